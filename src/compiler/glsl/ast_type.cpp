@@ -260,12 +260,15 @@ ast_type_qualifier::merge_qualifier(YYLTYPE *loc,
          unsigned buff_idx;
          if (process_qualifier_constant(state, loc, "xfb_buffer",
                                         this->xfb_buffer, &buff_idx)) {
+            ast_layout_expression *stride =
+               new(state->linalloc) ast_layout_expression(*loc,
+                                                          this->xfb_stride);
+
             if (state->out_qualifier->out_xfb_stride[buff_idx]) {
                state->out_qualifier->out_xfb_stride[buff_idx]->merge_qualifier(
-                  new(state) ast_layout_expression(*loc, this->xfb_stride));
+                  stride);
             } else {
-               state->out_qualifier->out_xfb_stride[buff_idx] =
-                  new(state) ast_layout_expression(*loc, this->xfb_stride);
+               state->out_qualifier->out_xfb_stride[buff_idx] = stride;
             }
          }
       }
@@ -365,7 +368,7 @@ ast_type_qualifier::merge_out_qualifier(YYLTYPE *loc,
                                         const ast_type_qualifier &q,
                                         ast_node* &node, bool create_node)
 {
-   void *mem_ctx = state;
+   void *lin_ctx = state->linalloc;
    const bool r = this->merge_qualifier(loc, state, q, false);
    ast_type_qualifier valid_out_mask;
    valid_out_mask.flags.i = 0;
@@ -398,7 +401,7 @@ ast_type_qualifier::merge_out_qualifier(YYLTYPE *loc,
       valid_out_mask.flags.q.prim_type = 1;
    } else if (state->stage == MESA_SHADER_TESS_CTRL) {
       if (create_node) {
-         node = new(mem_ctx) ast_tcs_output_layout(*loc);
+         node = new(lin_ctx) ast_tcs_output_layout(*loc);
       }
       valid_out_mask.flags.q.vertices = 1;
       valid_out_mask.flags.q.explicit_xfb_buffer = 1;
@@ -437,7 +440,7 @@ ast_type_qualifier::merge_in_qualifier(YYLTYPE *loc,
                                        const ast_type_qualifier &q,
                                        ast_node* &node, bool create_node)
 {
-   void *mem_ctx = state;
+   void *lin_ctx = state->linalloc;
    bool create_gs_ast = false;
    bool create_cs_ast = false;
    ast_type_qualifier valid_in_mask;
@@ -577,9 +580,9 @@ ast_type_qualifier::merge_in_qualifier(YYLTYPE *loc,
 
    if (create_node) {
       if (create_gs_ast) {
-         node = new(mem_ctx) ast_gs_input_layout(*loc, q.prim_type);
+         node = new(lin_ctx) ast_gs_input_layout(*loc, q.prim_type);
       } else if (create_cs_ast) {
-         node = new(mem_ctx) ast_cs_input_layout(*loc, q.local_size);
+         node = new(lin_ctx) ast_cs_input_layout(*loc, q.local_size);
       }
    }
 
@@ -39,7 +39,8 @@
  *
  *    The builtin_builder::create_builtins() function contains lists of all
  *    built-in function signatures, where they're available, what types they
- *    take, and so on.
+ *    take, and so on.  Functions are only generated the first time a shader
+ *    looks them up by name.
  *
  * 4. Implementations of built-in function signatures
  *
@@ -550,19 +551,32 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *find_function(const char *name);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * This includes signatures for every built-in looked up so far,
+    * regardless of version or enabled extensions.  The availability
+    * predicate associated with each signature allows matching_signature()
+    * to filter out the irrelevant ones.
     */
    gl_shader *shader;
 
 private:
    void *mem_ctx;
 
+   /**
+    * Name of the only function create_builtins() should generate, or NULL
+    * to generate all of them.
+    */
+   const char *wanted_function;
+
+   bool is_wanted(const char *name) const
+   {
+      return wanted_function == NULL || strcmp(wanted_function, name) == 0;
+   }
+
    /** Global variables used by built-in functions. */
    ir_variable *gl_ModelViewProjectionMatrix;
    ir_variable *gl_Vertex;
@@ -882,6 +896,7 @@ enum image_function_flags {
  */
 builtin_builder::builtin_builder()
    : shader(NULL),
+     wanted_function(NULL),
      gl_ModelViewProjectionMatrix(NULL),
      gl_Vertex(NULL)
 {
@@ -906,7 +921,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = find_function(name);
    if (f == NULL)
       return NULL;
 
@@ -918,6 +933,25 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    return sig;
 }
 
+/**
+ * Look up a built-in function by name, generating its signatures the first
+ * time it is asked for.  Most shaders only use a handful of built-ins, so
+ * this is much cheaper than generating IR for all of them up front.
+ */
+ir_function *
+builtin_builder::find_function(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL)
+      return f;
+
+   wanted_function = name;
+   create_builtins();
+   wanted_function = NULL;
+
+   return shader->symbols->get_function(name);
+}
+
 void
 builtin_builder::initialize()
 {
@@ -925,10 +959,13 @@ builtin_builder::initialize()
    if (mem_ctx != NULL)
       return;
 
+   /* The intrinsics are called by the built-ins, so they have to exist
+    * before any built-in is generated.  The built-ins themselves are
+    * generated on demand by find_function().
+    */
    mem_ctx = ralloc_context(NULL);
    create_shader();
    create_intrinsics();
-   create_builtins();
 }
 
 void
@@ -1071,13 +1108,21 @@ builtin_builder::create_intrinsics()
 /**
  * Create ir_function and ir_function_signature objects for each built-in.
  *
- * Contains a list of every available built-in.
+ * Contains a list of every available built-in.  Only the one named by
+ * wanted_function is created, unless that is NULL.  The signatures are
+ * arguments of ADD_FUNCTION, so they aren't even built for the others.
  */
 void
 builtin_builder::create_builtins()
 {
+#define ADD_FUNCTION(NAME, ...)                 \
+   do {                                         \
+      if (is_wanted(NAME))                      \
+         add_function(NAME, __VA_ARGS__);       \
+   } while (0)
+
 #define F(NAME)                                 \
-   add_function(#NAME,                          \
+   ADD_FUNCTION(#NAME,                          \
                 _##NAME(glsl_type::float_type), \
                 _##NAME(glsl_type::vec2_type),  \
                 _##NAME(glsl_type::vec3_type),  \
@@ -1085,7 +1130,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FD(NAME)                                 \
-   add_function(#NAME,                          \
+   ADD_FUNCTION(#NAME,                          \
                 _##NAME(always_available, glsl_type::float_type), \
                 _##NAME(always_available, glsl_type::vec2_type),  \
                 _##NAME(always_available, glsl_type::vec3_type),  \
@@ -1097,7 +1142,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FD130(NAME)                                 \
-   add_function(#NAME,                          \
+   ADD_FUNCTION(#NAME,                          \
                 _##NAME(v130, glsl_type::float_type), \
                 _##NAME(v130, glsl_type::vec2_type),  \
                 _##NAME(v130, glsl_type::vec3_type),                  \
@@ -1109,7 +1154,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FDGS5(NAME)                                 \
-   add_function(#NAME,                          \
+   ADD_FUNCTION(#NAME,                          \
                 _##NAME(gpu_shader5_es, glsl_type::float_type), \
                 _##NAME(gpu_shader5_es, glsl_type::vec2_type),  \
                 _##NAME(gpu_shader5_es, glsl_type::vec3_type),                  \
@@ -1121,7 +1166,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FI(NAME)                                \
-   add_function(#NAME,                          \
+   ADD_FUNCTION(#NAME,                          \
                 _##NAME(glsl_type::float_type), \
                 _##NAME(glsl_type::vec2_type),  \
                 _##NAME(glsl_type::vec3_type),  \
@@ -1133,7 +1178,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FID(NAME)                                \
-   add_function(#NAME,                          \
+   ADD_FUNCTION(#NAME,                          \
                 _##NAME(always_available, glsl_type::float_type), \
                 _##NAME(always_available, glsl_type::vec2_type),  \
                 _##NAME(always_available, glsl_type::vec3_type),  \
@@ -1149,7 +1194,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FIUD(NAME)                                                 \
-   add_function(#NAME,                                            \
+   ADD_FUNCTION(#NAME,                                            \
                 _##NAME(always_available, glsl_type::float_type), \
                 _##NAME(always_available, glsl_type::vec2_type),  \
                 _##NAME(always_available, glsl_type::vec3_type),  \
@@ -1171,7 +1216,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define IU(NAME)                                \
-   add_function(#NAME,                          \
+   ADD_FUNCTION(#NAME,                          \
                 _##NAME(glsl_type::int_type),   \
                 _##NAME(glsl_type::ivec2_type), \
                 _##NAME(glsl_type::ivec3_type), \
@@ -1184,7 +1229,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FIUBD(NAME)                                                \
-   add_function(#NAME,                                            \
+   ADD_FUNCTION(#NAME,                                            \
                 _##NAME(always_available, glsl_type::float_type), \
                 _##NAME(always_available, glsl_type::vec2_type),  \
                 _##NAME(always_available, glsl_type::vec3_type),  \
@@ -1212,7 +1257,7 @@ builtin_builder::create_builtins()
                 NULL);
 
 #define FIUD2_MIXED(NAME)                                                                 \
-   add_function(#NAME,                                                                   \
+   ADD_FUNCTION(#NAME,                                                                   \
                 _##NAME(always_available, glsl_type::float_type, glsl_type::float_type), \
                 _##NAME(always_available, glsl_type::vec2_type,  glsl_type::float_type), \
                 _##NAME(always_available, glsl_type::vec3_type,  glsl_type::float_type), \
@@ -1257,7 +1302,7 @@ builtin_builder::create_builtins()
    F(asin)
    F(acos)
 
-   add_function("atan",
+   ADD_FUNCTION("atan",
                 _atan(glsl_type::float_type),
                 _atan(glsl_type::vec2_type),
                 _atan(glsl_type::vec3_type),
@@ -1290,7 +1335,7 @@ builtin_builder::create_builtins()
    FD(ceil)
    FD(fract)
 
-   add_function("mod",
+   ADD_FUNCTION("mod",
                 _mod(always_available, glsl_type::float_type, glsl_type::float_type),
                 _mod(always_available, glsl_type::vec2_type,  glsl_type::float_type),
                 _mod(always_available, glsl_type::vec3_type,  glsl_type::float_type),
@@ -1316,7 +1361,7 @@ builtin_builder::create_builtins()
    FIUD2_MIXED(max)
    FIUD2_MIXED(clamp)
 
-   add_function("mix",
+   ADD_FUNCTION("mix",
                 _mix_lrp(always_available, glsl_type::float_type, glsl_type::float_type),
                 _mix_lrp(always_available, glsl_type::vec2_type,  glsl_type::float_type),
                 _mix_lrp(always_available, glsl_type::vec3_type,  glsl_type::float_type),
@@ -1361,7 +1406,7 @@ builtin_builder::create_builtins()
                 _mix_sel(shader_integer_mix, glsl_type::bvec4_type, glsl_type::bvec4_type),
                 NULL);
 
-   add_function("step",
+   ADD_FUNCTION("step",
                 _step(always_available, glsl_type::float_type, glsl_type::float_type),
                 _step(always_available, glsl_type::float_type, glsl_type::vec2_type),
                 _step(always_available, glsl_type::float_type, glsl_type::vec3_type),
@@ -1380,7 +1425,7 @@ builtin_builder::create_builtins()
                 _step(fp64, glsl_type::dvec4_type,  glsl_type::dvec4_type),
                 NULL);
 
-   add_function("smoothstep",
+   ADD_FUNCTION("smoothstep",
                 _smoothstep(always_available, glsl_type::float_type, glsl_type::float_type),
                 _smoothstep(always_available, glsl_type::float_type, glsl_type::vec2_type),
                 _smoothstep(always_available, glsl_type::float_type, glsl_type::vec3_type),
@@ -1404,47 +1449,47 @@ builtin_builder::create_builtins()
 
    F(floatBitsToInt)
    F(floatBitsToUint)
-   add_function("intBitsToFloat",
+   ADD_FUNCTION("intBitsToFloat",
                 _intBitsToFloat(glsl_type::int_type),
                 _intBitsToFloat(glsl_type::ivec2_type),
                 _intBitsToFloat(glsl_type::ivec3_type),
                 _intBitsToFloat(glsl_type::ivec4_type),
                 NULL);
-   add_function("uintBitsToFloat",
+   ADD_FUNCTION("uintBitsToFloat",
                 _uintBitsToFloat(glsl_type::uint_type),
                 _uintBitsToFloat(glsl_type::uvec2_type),
                 _uintBitsToFloat(glsl_type::uvec3_type),
                 _uintBitsToFloat(glsl_type::uvec4_type),
                 NULL);
 
-   add_function("packUnorm2x16",   _packUnorm2x16(shader_packing_or_es3_or_gpu_shader5),   NULL);
-   add_function("packSnorm2x16",   _packSnorm2x16(shader_packing_or_es3),                  NULL);
-   add_function("packUnorm4x8",    _packUnorm4x8(shader_packing_or_es31_or_gpu_shader5),   NULL);
-   add_function("packSnorm4x8",    _packSnorm4x8(shader_packing_or_es31_or_gpu_shader5),   NULL);
-   add_function("unpackUnorm2x16", _unpackUnorm2x16(shader_packing_or_es3_or_gpu_shader5), NULL);
-   add_function("unpackSnorm2x16", _unpackSnorm2x16(shader_packing_or_es3),                NULL);
-   add_function("unpackUnorm4x8",  _unpackUnorm4x8(shader_packing_or_es31_or_gpu_shader5), NULL);
-   add_function("unpackSnorm4x8",  _unpackSnorm4x8(shader_packing_or_es31_or_gpu_shader5), NULL);
-   add_function("packHalf2x16",    _packHalf2x16(shader_packing_or_es3),                   NULL);
-   add_function("unpackHalf2x16",  _unpackHalf2x16(shader_packing_or_es3),                 NULL);
-   add_function("packDouble2x32",    _packDouble2x32(fp64),                   NULL);
-   add_function("unpackDouble2x32",  _unpackDouble2x32(fp64),                 NULL);
+   ADD_FUNCTION("packUnorm2x16",   _packUnorm2x16(shader_packing_or_es3_or_gpu_shader5),   NULL);
+   ADD_FUNCTION("packSnorm2x16",   _packSnorm2x16(shader_packing_or_es3),                  NULL);
+   ADD_FUNCTION("packUnorm4x8",    _packUnorm4x8(shader_packing_or_es31_or_gpu_shader5),   NULL);
+   ADD_FUNCTION("packSnorm4x8",    _packSnorm4x8(shader_packing_or_es31_or_gpu_shader5),   NULL);
+   ADD_FUNCTION("unpackUnorm2x16", _unpackUnorm2x16(shader_packing_or_es3_or_gpu_shader5), NULL);
+   ADD_FUNCTION("unpackSnorm2x16", _unpackSnorm2x16(shader_packing_or_es3),                NULL);
+   ADD_FUNCTION("unpackUnorm4x8",  _unpackUnorm4x8(shader_packing_or_es31_or_gpu_shader5), NULL);
+   ADD_FUNCTION("unpackSnorm4x8",  _unpackSnorm4x8(shader_packing_or_es31_or_gpu_shader5), NULL);
+   ADD_FUNCTION("packHalf2x16",    _packHalf2x16(shader_packing_or_es3),                   NULL);
+   ADD_FUNCTION("unpackHalf2x16",  _unpackHalf2x16(shader_packing_or_es3),                 NULL);
+   ADD_FUNCTION("packDouble2x32",    _packDouble2x32(fp64),                   NULL);
+   ADD_FUNCTION("unpackDouble2x32",  _unpackDouble2x32(fp64),                 NULL);
 
 
    FD(length)
    FD(distance)
    FD(dot)
 
-   add_function("cross", _cross(always_available, glsl_type::vec3_type),
+   ADD_FUNCTION("cross", _cross(always_available, glsl_type::vec3_type),
                 _cross(fp64, glsl_type::dvec3_type), NULL);
 
    FD(normalize)
-   add_function("ftransform", _ftransform(), NULL);
+   ADD_FUNCTION("ftransform", _ftransform(), NULL);
    FD(faceforward)
    FD(reflect)
    FD(refract)
    // ...
-   add_function("matrixCompMult",
+   ADD_FUNCTION("matrixCompMult",
                 _matrixCompMult(always_available, glsl_type::mat2_type),
                 _matrixCompMult(always_available, glsl_type::mat3_type),
                 _matrixCompMult(always_available, glsl_type::mat4_type),
@@ -1464,7 +1509,7 @@ builtin_builder::create_builtins()
                 _matrixCompMult(fp64, glsl_type::dmat4x2_type),
                 _matrixCompMult(fp64, glsl_type::dmat4x3_type),
                 NULL);
-   add_function("outerProduct",
+   ADD_FUNCTION("outerProduct",
                 _outerProduct(v120, glsl_type::mat2_type),
                 _outerProduct(v120, glsl_type::mat3_type),
                 _outerProduct(v120, glsl_type::mat4_type),
@@ -1484,7 +1529,7 @@ builtin_builder::create_builtins()
                 _outerProduct(fp64, glsl_type::dmat4x2_type),
                 _outerProduct(fp64, glsl_type::dmat4x3_type),
                 NULL);
-   add_function("determinant",
+   ADD_FUNCTION("determinant",
                 _determinant_mat2(v120, glsl_type::mat2_type),
                 _determinant_mat3(v120, glsl_type::mat3_type),
                 _determinant_mat4(v120, glsl_type::mat4_type),
@@ -1493,7 +1538,7 @@ builtin_builder::create_builtins()
                 _determinant_mat4(fp64, glsl_type::dmat4_type),
 
                 NULL);
-   add_function("inverse",
+   ADD_FUNCTION("inverse",
                 _inverse_mat2(v140_or_es3, glsl_type::mat2_type),
                 _inverse_mat3(v140_or_es3, glsl_type::mat3_type),
                 _inverse_mat4(v140_or_es3, glsl_type::mat4_type),
@@ -1501,7 +1546,7 @@ builtin_builder::create_builtins()
                 _inverse_mat3(fp64, glsl_type::dmat3_type),
                 _inverse_mat4(fp64, glsl_type::dmat4_type),
                 NULL);
-   add_function("transpose",
+   ADD_FUNCTION("transpose",
                 _transpose(v120, glsl_type::mat2_type),
                 _transpose(v120, glsl_type::mat3_type),
                 _transpose(v120, glsl_type::mat4_type),
@@ -1528,25 +1573,25 @@ builtin_builder::create_builtins()
    FIUBD(notEqual)
    FIUBD(equal)
 
-   add_function("any",
+   ADD_FUNCTION("any",
                 _any(glsl_type::bvec2_type),
                 _any(glsl_type::bvec3_type),
                 _any(glsl_type::bvec4_type),
                 NULL);
 
-   add_function("all",
+   ADD_FUNCTION("all",
                 _all(glsl_type::bvec2_type),
                 _all(glsl_type::bvec3_type),
                 _all(glsl_type::bvec4_type),
                 NULL);
 
-   add_function("not",
+   ADD_FUNCTION("not",
                 _not(glsl_type::bvec2_type),
                 _not(glsl_type::bvec3_type),
                 _not(glsl_type::bvec4_type),
                 NULL);
 
-   add_function("textureSize",
+   ADD_FUNCTION("textureSize",
                 _textureSize(v130, glsl_type::int_type,   glsl_type::sampler1D_type),
                 _textureSize(v130, glsl_type::int_type,   glsl_type::isampler1D_type),
                 _textureSize(v130, glsl_type::int_type,   glsl_type::usampler1D_type),
@@ -1599,7 +1644,7 @@ builtin_builder::create_builtins()
                 _textureSize(texture_multisample_array, glsl_type::ivec3_type, glsl_type::usampler2DMSArray_type),
                 NULL);
 
-   add_function("textureSamples",
+   ADD_FUNCTION("textureSamples",
                 _textureSamples(glsl_type::sampler2DMS_type),
                 _textureSamples(glsl_type::isampler2DMS_type),
                 _textureSamples(glsl_type::usampler2DMS_type),
@@ -1609,7 +1654,7 @@ builtin_builder::create_builtins()
                 _textureSamples(glsl_type::usampler2DMSArray_type),
                 NULL);
 
-   add_function("texture",
+   ADD_FUNCTION("texture",
                 _texture(ir_tex, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::float_type),
                 _texture(ir_tex, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::float_type),
                 _texture(ir_tex, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::float_type),
@@ -1690,7 +1735,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txb, v130_fs_only, glsl_type::float_type, glsl_type::sampler1DArrayShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("textureLod",
+   ADD_FUNCTION("textureLod",
                 _texture(ir_txl, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::float_type),
                 _texture(ir_txl, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::float_type),
                 _texture(ir_txl, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::float_type),
@@ -1725,7 +1770,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txl, v130, glsl_type::float_type, glsl_type::sampler1DArrayShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("textureOffset",
+   ADD_FUNCTION("textureOffset",
                 _texture(ir_tex, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::float_type, TEX_OFFSET),
                 _texture(ir_tex, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::float_type, TEX_OFFSET),
                 _texture(ir_tex, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::float_type, TEX_OFFSET),
@@ -1790,7 +1835,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txb, v130_fs_only, glsl_type::float_type, glsl_type::sampler1DArrayShadow_type, glsl_type::vec3_type, TEX_OFFSET),
                 NULL);
 
-   add_function("textureProj",
+   ADD_FUNCTION("textureProj",
                 _texture(ir_tex, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_tex, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_tex, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
@@ -1843,7 +1888,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txb, v130, glsl_type::float_type, glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texelFetch",
+   ADD_FUNCTION("texelFetch",
                 _texelFetch(v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::int_type),
                 _texelFetch(v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::int_type),
                 _texelFetch(v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::int_type),
@@ -1881,7 +1926,7 @@ builtin_builder::create_builtins()
                 _texelFetch(texture_multisample_array, glsl_type::uvec4_type, glsl_type::usampler2DMSArray_type, glsl_type::ivec3_type),
                 NULL);
 
-   add_function("texelFetchOffset",
+   ADD_FUNCTION("texelFetchOffset",
                 _texelFetch(v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::int_type, glsl_type::int_type),
                 _texelFetch(v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::int_type, glsl_type::int_type),
                 _texelFetch(v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::int_type, glsl_type::int_type),
@@ -1908,7 +1953,7 @@ builtin_builder::create_builtins()
 
                 NULL);
 
-   add_function("textureProjOffset",
+   ADD_FUNCTION("textureProjOffset",
                 _texture(ir_tex, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
                 _texture(ir_tex, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
                 _texture(ir_tex, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
@@ -1961,7 +2006,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txb, v130, glsl_type::float_type, glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT | TEX_OFFSET),
                 NULL);
 
-   add_function("textureLodOffset",
+   ADD_FUNCTION("textureLodOffset",
                 _texture(ir_txl, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::float_type, TEX_OFFSET),
                 _texture(ir_txl, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::float_type, TEX_OFFSET),
                 _texture(ir_txl, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::float_type, TEX_OFFSET),
@@ -1988,7 +2033,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txl, v130, glsl_type::float_type, glsl_type::sampler1DArrayShadow_type, glsl_type::vec3_type, TEX_OFFSET),
                 NULL);
 
-   add_function("textureProjLod",
+   ADD_FUNCTION("textureProjLod",
                 _texture(ir_txl, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_txl, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_txl, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
@@ -2011,7 +2056,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txl, v130, glsl_type::float_type, glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("textureProjLodOffset",
+   ADD_FUNCTION("textureProjLodOffset",
                 _texture(ir_txl, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
                 _texture(ir_txl, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
                 _texture(ir_txl, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
@@ -2034,7 +2079,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txl, v130, glsl_type::float_type, glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT | TEX_OFFSET),
                 NULL);
 
-   add_function("textureGrad",
+   ADD_FUNCTION("textureGrad",
                 _texture(ir_txd, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::float_type),
                 _texture(ir_txd, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::float_type),
                 _texture(ir_txd, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::float_type),
@@ -2077,7 +2122,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txd, v130, glsl_type::float_type, glsl_type::sampler2DArrayShadow_type, glsl_type::vec4_type),
                 NULL);
 
-   add_function("textureGradOffset",
+   ADD_FUNCTION("textureGradOffset",
                 _texture(ir_txd, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::float_type, TEX_OFFSET),
                 _texture(ir_txd, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::float_type, TEX_OFFSET),
                 _texture(ir_txd, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::float_type, TEX_OFFSET),
@@ -2111,7 +2156,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txd, v130, glsl_type::float_type, glsl_type::sampler2DArrayShadow_type, glsl_type::vec4_type, TEX_OFFSET),
                 NULL);
 
-   add_function("textureProjGrad",
+   ADD_FUNCTION("textureProjGrad",
                 _texture(ir_txd, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_txd, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_txd, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
@@ -2143,7 +2188,7 @@ builtin_builder::create_builtins()
                 _texture(ir_txd, v130, glsl_type::float_type, glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("textureProjGradOffset",
+   ADD_FUNCTION("textureProjGradOffset",
                 _texture(ir_txd, v130, glsl_type::vec4_type,  glsl_type::sampler1D_type,  glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
                 _texture(ir_txd, v130, glsl_type::ivec4_type, glsl_type::isampler1D_type, glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
                 _texture(ir_txd, v130, glsl_type::uvec4_type, glsl_type::usampler1D_type, glsl_type::vec2_type, TEX_PROJECT | TEX_OFFSET),
@@ -2175,19 +2220,19 @@ builtin_builder::create_builtins()
                 _texture(ir_txd, v130, glsl_type::float_type, glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT | TEX_OFFSET),
                 NULL);
 
-   add_function("EmitVertex",   _EmitVertex(),   NULL);
-   add_function("EndPrimitive", _EndPrimitive(), NULL);
-   add_function("EmitStreamVertex",
+   ADD_FUNCTION("EmitVertex",   _EmitVertex(),   NULL);
+   ADD_FUNCTION("EndPrimitive", _EndPrimitive(), NULL);
+   ADD_FUNCTION("EmitStreamVertex",
                 _EmitStreamVertex(gs_streams, glsl_type::uint_type),
                 _EmitStreamVertex(gs_streams, glsl_type::int_type),
                 NULL);
-   add_function("EndStreamPrimitive",
+   ADD_FUNCTION("EndStreamPrimitive",
                 _EndStreamPrimitive(gs_streams, glsl_type::uint_type),
                 _EndStreamPrimitive(gs_streams, glsl_type::int_type),
                 NULL);
-   add_function("barrier", _barrier(), NULL);
+   ADD_FUNCTION("barrier", _barrier(), NULL);
 
-   add_function("textureQueryLOD",
+   ADD_FUNCTION("textureQueryLOD",
                 _textureQueryLod(texture_query_lod, glsl_type::sampler1D_type,  glsl_type::float_type),
                 _textureQueryLod(texture_query_lod, glsl_type::isampler1D_type, glsl_type::float_type),
                 _textureQueryLod(texture_query_lod, glsl_type::usampler1D_type, glsl_type::float_type),
@@ -2224,7 +2269,7 @@ builtin_builder::create_builtins()
                 _textureQueryLod(texture_query_lod, glsl_type::samplerCubeArrayShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("textureQueryLod",
+   ADD_FUNCTION("textureQueryLod",
                 _textureQueryLod(v400_fs_only, glsl_type::sampler1D_type,  glsl_type::float_type),
                 _textureQueryLod(v400_fs_only, glsl_type::isampler1D_type, glsl_type::float_type),
                 _textureQueryLod(v400_fs_only, glsl_type::usampler1D_type, glsl_type::float_type),
@@ -2261,7 +2306,7 @@ builtin_builder::create_builtins()
                 _textureQueryLod(v400_fs_only, glsl_type::samplerCubeArrayShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("textureQueryLevels",
+   ADD_FUNCTION("textureQueryLevels",
                 _textureQueryLevels(glsl_type::sampler1D_type),
                 _textureQueryLevels(glsl_type::sampler2D_type),
                 _textureQueryLevels(glsl_type::sampler3D_type),
@@ -2294,7 +2339,7 @@ builtin_builder::create_builtins()
 
                 NULL);
 
-   add_function("textureSamplesIdenticalEXT",
+   ADD_FUNCTION("textureSamplesIdenticalEXT",
                 _textureSamplesIdentical(texture_samples_identical, glsl_type::sampler2DMS_type,  glsl_type::ivec2_type),
                 _textureSamplesIdentical(texture_samples_identical, glsl_type::isampler2DMS_type, glsl_type::ivec2_type),
                 _textureSamplesIdentical(texture_samples_identical, glsl_type::usampler2DMS_type, glsl_type::ivec2_type),
@@ -2304,48 +2349,48 @@ builtin_builder::create_builtins()
                 _textureSamplesIdentical(texture_samples_identical_array, glsl_type::usampler2DMSArray_type, glsl_type::ivec3_type),
                 NULL);
 
-   add_function("texture1D",
+   ADD_FUNCTION("texture1D",
                 _texture(ir_tex, v110,         glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::float_type),
                 _texture(ir_txb, v110_fs_only, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::float_type),
                 NULL);
 
-   add_function("texture1DArray",
+   ADD_FUNCTION("texture1DArray",
                 _texture(ir_tex, texture_array,    glsl_type::vec4_type, glsl_type::sampler1DArray_type, glsl_type::vec2_type),
                 _texture(ir_txb, fs_texture_array, glsl_type::vec4_type, glsl_type::sampler1DArray_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("texture1DProj",
+   ADD_FUNCTION("texture1DProj",
                 _texture(ir_tex, v110,         glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_tex, v110,         glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec4_type, TEX_PROJECT),
                 _texture(ir_txb, v110_fs_only, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_txb, v110_fs_only, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture1DLod",
+   ADD_FUNCTION("texture1DLod",
                 _texture(ir_txl, tex1d_lod, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::float_type),
                 NULL);
 
-   add_function("texture1DArrayLod",
+   ADD_FUNCTION("texture1DArrayLod",
                 _texture(ir_txl, texture_array_lod, glsl_type::vec4_type, glsl_type::sampler1DArray_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("texture1DProjLod",
+   ADD_FUNCTION("texture1DProjLod",
                 _texture(ir_txl, tex1d_lod, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_txl, tex1d_lod, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture2D",
+   ADD_FUNCTION("texture2D",
                 _texture(ir_tex, always_available, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec2_type),
                 _texture(ir_txb, fs_only,          glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec2_type),
                 _texture(ir_tex, texture_external, glsl_type::vec4_type,  glsl_type::samplerExternalOES_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("texture2DArray",
+   ADD_FUNCTION("texture2DArray",
                 _texture(ir_tex, texture_array,    glsl_type::vec4_type, glsl_type::sampler2DArray_type, glsl_type::vec3_type),
                 _texture(ir_txb, fs_texture_array, glsl_type::vec4_type, glsl_type::sampler2DArray_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("texture2DProj",
+   ADD_FUNCTION("texture2DProj",
                 _texture(ir_tex, always_available, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec3_type, TEX_PROJECT),
                 _texture(ir_tex, always_available, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec4_type, TEX_PROJECT),
                 _texture(ir_txb, fs_only,          glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec3_type, TEX_PROJECT),
@@ -2354,177 +2399,177 @@ builtin_builder::create_builtins()
                 _texture(ir_tex, texture_external, glsl_type::vec4_type,  glsl_type::samplerExternalOES_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture2DLod",
+   ADD_FUNCTION("texture2DLod",
                 _texture(ir_txl, lod_exists_in_stage, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("texture2DArrayLod",
+   ADD_FUNCTION("texture2DArrayLod",
                 _texture(ir_txl, texture_array_lod, glsl_type::vec4_type, glsl_type::sampler2DArray_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("texture2DProjLod",
+   ADD_FUNCTION("texture2DProjLod",
                 _texture(ir_txl, lod_exists_in_stage, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec3_type, TEX_PROJECT),
                 _texture(ir_txl, lod_exists_in_stage, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture3D",
+   ADD_FUNCTION("texture3D",
                 _texture(ir_tex, tex3d,    glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec3_type),
                 _texture(ir_txb, fs_tex3d, glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("texture3DProj",
+   ADD_FUNCTION("texture3DProj",
                 _texture(ir_tex, tex3d,    glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec4_type, TEX_PROJECT),
                 _texture(ir_txb, fs_tex3d, glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture3DLod",
+   ADD_FUNCTION("texture3DLod",
                 _texture(ir_txl, tex3d_lod, glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("texture3DProjLod",
+   ADD_FUNCTION("texture3DProjLod",
                 _texture(ir_txl, tex3d_lod, glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("textureCube",
+   ADD_FUNCTION("textureCube",
                 _texture(ir_tex, always_available, glsl_type::vec4_type,  glsl_type::samplerCube_type, glsl_type::vec3_type),
                 _texture(ir_txb, fs_only,          glsl_type::vec4_type,  glsl_type::samplerCube_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("textureCubeLod",
+   ADD_FUNCTION("textureCubeLod",
                 _texture(ir_txl, lod_exists_in_stage, glsl_type::vec4_type,  glsl_type::samplerCube_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("texture2DRect",
+   ADD_FUNCTION("texture2DRect",
                 _texture(ir_tex, texture_rectangle, glsl_type::vec4_type,  glsl_type::sampler2DRect_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("texture2DRectProj",
+   ADD_FUNCTION("texture2DRectProj",
                 _texture(ir_tex, texture_rectangle, glsl_type::vec4_type,  glsl_type::sampler2DRect_type, glsl_type::vec3_type, TEX_PROJECT),
                 _texture(ir_tex, texture_rectangle, glsl_type::vec4_type,  glsl_type::sampler2DRect_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("shadow1D",
+   ADD_FUNCTION("shadow1D",
                 _texture(ir_tex, v110,         glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec3_type),
                 _texture(ir_txb, v110_fs_only, glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow1DArray",
+   ADD_FUNCTION("shadow1DArray",
                 _texture(ir_tex, texture_array,    glsl_type::vec4_type,  glsl_type::sampler1DArrayShadow_type, glsl_type::vec3_type),
                 _texture(ir_txb, fs_texture_array, glsl_type::vec4_type,  glsl_type::sampler1DArrayShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow2D",
+   ADD_FUNCTION("shadow2D",
                 _texture(ir_tex, v110,         glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec3_type),
                 _texture(ir_txb, v110_fs_only, glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow2DArray",
+   ADD_FUNCTION("shadow2DArray",
                 _texture(ir_tex, texture_array,    glsl_type::vec4_type,  glsl_type::sampler2DArrayShadow_type, glsl_type::vec4_type),
                 _texture(ir_txb, fs_texture_array, glsl_type::vec4_type,  glsl_type::sampler2DArrayShadow_type, glsl_type::vec4_type),
                 NULL);
 
-   add_function("shadow1DProj",
+   ADD_FUNCTION("shadow1DProj",
                 _texture(ir_tex, v110,         glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 _texture(ir_txb, v110_fs_only, glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("shadow2DProj",
+   ADD_FUNCTION("shadow2DProj",
                 _texture(ir_tex, v110,         glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 _texture(ir_txb, v110_fs_only, glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("shadow1DLod",
+   ADD_FUNCTION("shadow1DLod",
                 _texture(ir_txl, v110_lod, glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow2DLod",
+   ADD_FUNCTION("shadow2DLod",
                 _texture(ir_txl, v110_lod, glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow1DArrayLod",
+   ADD_FUNCTION("shadow1DArrayLod",
                 _texture(ir_txl, texture_array_lod, glsl_type::vec4_type, glsl_type::sampler1DArrayShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow1DProjLod",
+   ADD_FUNCTION("shadow1DProjLod",
                 _texture(ir_txl, v110_lod, glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("shadow2DProjLod",
+   ADD_FUNCTION("shadow2DProjLod",
                 _texture(ir_txl, v110_lod, glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("shadow2DRect",
+   ADD_FUNCTION("shadow2DRect",
                 _texture(ir_tex, texture_rectangle, glsl_type::vec4_type,  glsl_type::sampler2DRectShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow2DRectProj",
+   ADD_FUNCTION("shadow2DRectProj",
                 _texture(ir_tex, texture_rectangle, glsl_type::vec4_type,  glsl_type::sampler2DRectShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture1DGradARB",
+   ADD_FUNCTION("texture1DGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::float_type),
                 NULL);
 
-   add_function("texture1DProjGradARB",
+   ADD_FUNCTION("texture1DProjGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec2_type, TEX_PROJECT),
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler1D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture2DGradARB",
+   ADD_FUNCTION("texture2DGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("texture2DProjGradARB",
+   ADD_FUNCTION("texture2DProjGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec3_type, TEX_PROJECT),
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler2D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture3DGradARB",
+   ADD_FUNCTION("texture3DGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("texture3DProjGradARB",
+   ADD_FUNCTION("texture3DProjGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler3D_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("textureCubeGradARB",
+   ADD_FUNCTION("textureCubeGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::samplerCube_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow1DGradARB",
+   ADD_FUNCTION("shadow1DGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow1DProjGradARB",
+   ADD_FUNCTION("shadow1DProjGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler1DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("shadow2DGradARB",
+   ADD_FUNCTION("shadow2DGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow2DProjGradARB",
+   ADD_FUNCTION("shadow2DProjGradARB",
                 _texture(ir_txd, shader_texture_lod, glsl_type::vec4_type,  glsl_type::sampler2DShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("texture2DRectGradARB",
+   ADD_FUNCTION("texture2DRectGradARB",
                 _texture(ir_txd, shader_texture_lod_and_rect, glsl_type::vec4_type,  glsl_type::sampler2DRect_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("texture2DRectProjGradARB",
+   ADD_FUNCTION("texture2DRectProjGradARB",
                 _texture(ir_txd, shader_texture_lod_and_rect, glsl_type::vec4_type,  glsl_type::sampler2DRect_type, glsl_type::vec3_type, TEX_PROJECT),
                 _texture(ir_txd, shader_texture_lod_and_rect, glsl_type::vec4_type,  glsl_type::sampler2DRect_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("shadow2DRectGradARB",
+   ADD_FUNCTION("shadow2DRectGradARB",
                 _texture(ir_txd, shader_texture_lod_and_rect, glsl_type::vec4_type,  glsl_type::sampler2DRectShadow_type, glsl_type::vec3_type),
                 NULL);
 
-   add_function("shadow2DRectProjGradARB",
+   ADD_FUNCTION("shadow2DRectProjGradARB",
                 _texture(ir_txd, shader_texture_lod_and_rect, glsl_type::vec4_type,  glsl_type::sampler2DRectShadow_type, glsl_type::vec4_type, TEX_PROJECT),
                 NULL);
 
-   add_function("textureGather",
+   ADD_FUNCTION("textureGather",
                 _texture(ir_tg4, texture_gather_or_es31, glsl_type::vec4_type, glsl_type::sampler2D_type, glsl_type::vec2_type),
                 _texture(ir_tg4, texture_gather_or_es31, glsl_type::ivec4_type, glsl_type::isampler2D_type, glsl_type::vec2_type),
                 _texture(ir_tg4, texture_gather_or_es31, glsl_type::uvec4_type, glsl_type::usampler2D_type, glsl_type::vec2_type),
@@ -2572,7 +2617,7 @@ builtin_builder::create_builtins()
                 _texture(ir_tg4, gpu_shader5, glsl_type::vec4_type, glsl_type::sampler2DRectShadow_type, glsl_type::vec2_type),
                 NULL);
 
-   add_function("textureGatherOffset",
+   ADD_FUNCTION("textureGatherOffset",
                 _texture(ir_tg4, texture_gather_only_or_es31, glsl_type::vec4_type, glsl_type::sampler2D_type, glsl_type::vec2_type, TEX_OFFSET),
                 _texture(ir_tg4, texture_gather_only_or_es31, glsl_type::ivec4_type, glsl_type::isampler2D_type, glsl_type::vec2_type, TEX_OFFSET),
                 _texture(ir_tg4, texture_gather_only_or_es31, glsl_type::uvec4_type, glsl_type::usampler2D_type, glsl_type::vec2_type, TEX_OFFSET),
@@ -2621,7 +2666,7 @@ builtin_builder::create_builtins()
                 _texture(ir_tg4, es31_not_gs5, glsl_type::vec4_type, glsl_type::sampler2DArrayShadow_type, glsl_type::vec3_type, TEX_OFFSET),
                 NULL);
 
-   add_function("textureGatherOffsets",
+   ADD_FUNCTION("textureGatherOffsets",
                 _texture(ir_tg4, gpu_shader5_es, glsl_type::vec4_type, glsl_type::sampler2D_type, glsl_type::vec2_type, TEX_OFFSET_ARRAY),
                 _texture(ir_tg4, gpu_shader5_es, glsl_type::ivec4_type, glsl_type::isampler2D_type, glsl_type::vec2_type, TEX_OFFSET_ARRAY),
                 _texture(ir_tg4, gpu_shader5_es, glsl_type::uvec4_type, glsl_type::usampler2D_type, glsl_type::vec2_type, TEX_OFFSET_ARRAY),
@@ -2673,7 +2718,7 @@ builtin_builder::create_builtins()
    IU(findMSB)
    FDGS5(fma)
 
-   add_function("ldexp",
+   ADD_FUNCTION("ldexp",
                 _ldexp(glsl_type::float_type, glsl_type::int_type),
                 _ldexp(glsl_type::vec2_type,  glsl_type::ivec2_type),
                 _ldexp(glsl_type::vec3_type,  glsl_type::ivec3_type),
@@ -2684,7 +2729,7 @@ builtin_builder::create_builtins()
                 _ldexp(glsl_type::dvec4_type,  glsl_type::ivec4_type),
                 NULL);
 
-   add_function("frexp",
+   ADD_FUNCTION("frexp",
                 _frexp(glsl_type::float_type, glsl_type::int_type),
                 _frexp(glsl_type::vec2_type,  glsl_type::ivec2_type),
                 _frexp(glsl_type::vec3_type,  glsl_type::ivec3_type),
@@ -2694,100 +2739,100 @@ builtin_builder::create_builtins()
                 _dfrexp(glsl_type::dvec3_type,  glsl_type::ivec3_type),
                 _dfrexp(glsl_type::dvec4_type,  glsl_type::ivec4_type),
                 NULL);
-   add_function("uaddCarry",
+   ADD_FUNCTION("uaddCarry",
                 _uaddCarry(glsl_type::uint_type),
                 _uaddCarry(glsl_type::uvec2_type),
                 _uaddCarry(glsl_type::uvec3_type),
                 _uaddCarry(glsl_type::uvec4_type),
                 NULL);
-   add_function("usubBorrow",
+   ADD_FUNCTION("usubBorrow",
                 _usubBorrow(glsl_type::uint_type),
                 _usubBorrow(glsl_type::uvec2_type),
                 _usubBorrow(glsl_type::uvec3_type),
                 _usubBorrow(glsl_type::uvec4_type),
                 NULL);
-   add_function("imulExtended",
+   ADD_FUNCTION("imulExtended",
                 _mulExtended(glsl_type::int_type),
                 _mulExtended(glsl_type::ivec2_type),
                 _mulExtended(glsl_type::ivec3_type),
                 _mulExtended(glsl_type::ivec4_type),
                 NULL);
-   add_function("umulExtended",
+   ADD_FUNCTION("umulExtended",
                 _mulExtended(glsl_type::uint_type),
                 _mulExtended(glsl_type::uvec2_type),
                 _mulExtended(glsl_type::uvec3_type),
                 _mulExtended(glsl_type::uvec4_type),
                 NULL);
-   add_function("interpolateAtCentroid",
+   ADD_FUNCTION("interpolateAtCentroid",
                 _interpolateAtCentroid(glsl_type::float_type),
                 _interpolateAtCentroid(glsl_type::vec2_type),
                 _interpolateAtCentroid(glsl_type::vec3_type),
                 _interpolateAtCentroid(glsl_type::vec4_type),
                 NULL);
-   add_function("interpolateAtOffset",
+   ADD_FUNCTION("interpolateAtOffset",
                 _interpolateAtOffset(glsl_type::float_type),
                 _interpolateAtOffset(glsl_type::vec2_type),
                 _interpolateAtOffset(glsl_type::vec3_type),
                 _interpolateAtOffset(glsl_type::vec4_type),
                 NULL);
-   add_function("interpolateAtSample",
+   ADD_FUNCTION("interpolateAtSample",
                 _interpolateAtSample(glsl_type::float_type),
                 _interpolateAtSample(glsl_type::vec2_type),
                 _interpolateAtSample(glsl_type::vec3_type),
                 _interpolateAtSample(glsl_type::vec4_type),
                 NULL);
 
-   add_function("atomicCounter",
+   ADD_FUNCTION("atomicCounter",
                 _atomic_counter_op("__intrinsic_atomic_read",
                                    shader_atomic_counters),
                 NULL);
-   add_function("atomicCounterIncrement",
+   ADD_FUNCTION("atomicCounterIncrement",
                 _atomic_counter_op("__intrinsic_atomic_increment",
                                    shader_atomic_counters),
                 NULL);
-   add_function("atomicCounterDecrement",
+   ADD_FUNCTION("atomicCounterDecrement",
                 _atomic_counter_op("__intrinsic_atomic_predecrement",
                                    shader_atomic_counters),
                 NULL);
 
-   add_function("atomicCounterAddARB",
+   ADD_FUNCTION("atomicCounterAddARB",
                 _atomic_counter_op1("__intrinsic_atomic_add",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterSubtractARB",
+   ADD_FUNCTION("atomicCounterSubtractARB",
                 _atomic_counter_op1("__intrinsic_atomic_sub",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterMinARB",
+   ADD_FUNCTION("atomicCounterMinARB",
                 _atomic_counter_op1("__intrinsic_atomic_min",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterMaxARB",
+   ADD_FUNCTION("atomicCounterMaxARB",
                 _atomic_counter_op1("__intrinsic_atomic_max",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterAndARB",
+   ADD_FUNCTION("atomicCounterAndARB",
                 _atomic_counter_op1("__intrinsic_atomic_and",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterOrARB",
+   ADD_FUNCTION("atomicCounterOrARB",
                 _atomic_counter_op1("__intrinsic_atomic_or",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterXorARB",
+   ADD_FUNCTION("atomicCounterXorARB",
                 _atomic_counter_op1("__intrinsic_atomic_xor",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterExchangeARB",
+   ADD_FUNCTION("atomicCounterExchangeARB",
                 _atomic_counter_op1("__intrinsic_atomic_exchange",
                                     shader_atomic_counter_ops),
                 NULL);
-   add_function("atomicCounterCompSwapARB",
+   ADD_FUNCTION("atomicCounterCompSwapARB",
                 _atomic_counter_op2("__intrinsic_atomic_comp_swap",
                                     shader_atomic_counter_ops),
                 NULL);
 
-   add_function("atomicAdd",
+   ADD_FUNCTION("atomicAdd",
                 _atomic_op2("__intrinsic_atomic_add",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2795,7 +2840,7 @@ builtin_builder::create_builtins()
                             buffer_atomics_supported,
                             glsl_type::int_type),
                 NULL);
-   add_function("atomicMin",
+   ADD_FUNCTION("atomicMin",
                 _atomic_op2("__intrinsic_atomic_min",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2803,7 +2848,7 @@ builtin_builder::create_builtins()
                             buffer_atomics_supported,
                             glsl_type::int_type),
                 NULL);
-   add_function("atomicMax",
+   ADD_FUNCTION("atomicMax",
                 _atomic_op2("__intrinsic_atomic_max",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2811,7 +2856,7 @@ builtin_builder::create_builtins()
                             buffer_atomics_supported,
                             glsl_type::int_type),
                 NULL);
-   add_function("atomicAnd",
+   ADD_FUNCTION("atomicAnd",
                 _atomic_op2("__intrinsic_atomic_and",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2819,7 +2864,7 @@ builtin_builder::create_builtins()
                             buffer_atomics_supported,
                             glsl_type::int_type),
                 NULL);
-   add_function("atomicOr",
+   ADD_FUNCTION("atomicOr",
                 _atomic_op2("__intrinsic_atomic_or",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2827,7 +2872,7 @@ builtin_builder::create_builtins()
                             buffer_atomics_supported,
                             glsl_type::int_type),
                 NULL);
-   add_function("atomicXor",
+   ADD_FUNCTION("atomicXor",
                 _atomic_op2("__intrinsic_atomic_xor",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2835,7 +2880,7 @@ builtin_builder::create_builtins()
                             buffer_atomics_supported,
                             glsl_type::int_type),
                 NULL);
-   add_function("atomicExchange",
+   ADD_FUNCTION("atomicExchange",
                 _atomic_op2("__intrinsic_atomic_exchange",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2843,7 +2888,7 @@ builtin_builder::create_builtins()
                             buffer_atomics_supported,
                             glsl_type::int_type),
                 NULL);
-   add_function("atomicCompSwap",
+   ADD_FUNCTION("atomicCompSwap",
                 _atomic_op3("__intrinsic_atomic_comp_swap",
                             buffer_atomics_supported,
                             glsl_type::uint_type),
@@ -2852,7 +2897,7 @@ builtin_builder::create_builtins()
                             glsl_type::int_type),
                 NULL);
 
-   add_function("min3",
+   ADD_FUNCTION("min3",
                 _min3(glsl_type::float_type),
                 _min3(glsl_type::vec2_type),
                 _min3(glsl_type::vec3_type),
@@ -2869,7 +2914,7 @@ builtin_builder::create_builtins()
                 _min3(glsl_type::uvec4_type),
                 NULL);
 
-   add_function("max3",
+   ADD_FUNCTION("max3",
                 _max3(glsl_type::float_type),
                 _max3(glsl_type::vec2_type),
                 _max3(glsl_type::vec3_type),
@@ -2886,7 +2931,7 @@ builtin_builder::create_builtins()
                 _max3(glsl_type::uvec4_type),
                 NULL);
 
-   add_function("mid3",
+   ADD_FUNCTION("mid3",
                 _mid3(glsl_type::float_type),
                 _mid3(glsl_type::vec2_type),
                 _mid3(glsl_type::vec3_type),
@@ -2905,32 +2950,32 @@ builtin_builder::create_builtins()
 
    add_image_functions(true);
 
-   add_function("memoryBarrier",
+   ADD_FUNCTION("memoryBarrier",
                 _memory_barrier("__intrinsic_memory_barrier",
                                 shader_image_load_store),
                 NULL);
-   add_function("groupMemoryBarrier",
+   ADD_FUNCTION("groupMemoryBarrier",
                 _memory_barrier("__intrinsic_group_memory_barrier",
                                 compute_shader),
                 NULL);
-   add_function("memoryBarrierAtomicCounter",
+   ADD_FUNCTION("memoryBarrierAtomicCounter",
                 _memory_barrier("__intrinsic_memory_barrier_atomic_counter",
                                 compute_shader),
                 NULL);
-   add_function("memoryBarrierBuffer",
+   ADD_FUNCTION("memoryBarrierBuffer",
                 _memory_barrier("__intrinsic_memory_barrier_buffer",
                                 compute_shader),
                 NULL);
-   add_function("memoryBarrierImage",
+   ADD_FUNCTION("memoryBarrierImage",
                 _memory_barrier("__intrinsic_memory_barrier_image",
                                 compute_shader),
                 NULL);
-   add_function("memoryBarrierShared",
+   ADD_FUNCTION("memoryBarrierShared",
                 _memory_barrier("__intrinsic_memory_barrier_shared",
                                 compute_shader),
                 NULL);
 
-   add_function("clock2x32ARB",
+   ADD_FUNCTION("clock2x32ARB",
                 _shader_clock(shader_clock,
                               glsl_type::uvec2_type),
                 NULL);
@@ -2940,6 +2985,7 @@ builtin_builder::create_builtins()
 #undef FIUD
 #undef FIUBD
 #undef FIU2_MIXED
+#undef ADD_FUNCTION
 }
 
 void
@@ -3011,6 +3057,9 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMSArray_type
    };
 
+   if (!is_wanted(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -5620,7 +5669,7 @@ _mesa_glsl_find_builtin_function_by_name(const char *name)
 {
    ir_function *f;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.find_function(name);
    mtx_unlock(&builtins_lock);
    return f;
 }
@@ -5631,6 +5680,23 @@ _mesa_glsl_get_builtin_function_shader()
    return builtins.shader;
 }
 
+/**
+ * Built-ins are added to the built-in shader as they are looked up, so
+ * anything walking its symbol table from another thread, like the linker,
+ * has to hold this lock.
+ */
+void
+_mesa_glsl_lock_builtin_functions()
+{
+   mtx_lock(&builtins_lock);
+}
+
+void
+_mesa_glsl_unlock_builtin_functions()
+{
+   mtx_unlock(&builtins_lock);
+}
+
 
 /**
  * Get the function signature for main from a shader
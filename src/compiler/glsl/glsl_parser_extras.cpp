@@ -31,11 +31,13 @@
 #include "main/shaderobj.h"
 #include "util/u_atomic.h" /* for p_atomic_cmpxchg */
 #include "util/ralloc.h"
+#include "util/disk_cache.h"
 #include "ast.h"
 #include "glsl_parser_extras.h"
 #include "glsl_parser.h"
 #include "ir_optimization.h"
 #include "loop_analysis.h"
+#include "shader_cache.h"
 
 /**
  * Format a short human-readable description of the given GLSL version.
@@ -62,6 +64,7 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    this->stage = stage;
 
    this->scanner = NULL;
+   this->linalloc = linear_context(this);
    this->translation_unit.make_empty();
    this->symbols = new(mem_ctx) glsl_symbol_table;
 
@@ -1575,19 +1578,22 @@ ast_struct_specifier::print(void) const
 }
 
 
-ast_struct_specifier::ast_struct_specifier(const char *identifier,
+ast_struct_specifier::ast_struct_specifier(void *lin_ctx,
+                                           const char *identifier,
 					   ast_declarator_list *declarator_list)
 {
    if (identifier == NULL) {
       static mtx_t mutex = _MTX_INITIALIZER_NP;
       static unsigned anon_count = 1;
       unsigned count;
+      char buf[32];
 
       mtx_lock(&mutex);
       count = anon_count++;
       mtx_unlock(&mutex);
 
-      identifier = ralloc_asprintf(this, "#anon_struct_%04x", count);
+      snprintf(buf, sizeof(buf), "#anon_struct_%04x", count);
+      identifier = linear_strdup(lin_ctx, buf);
    }
    name = identifier;
    this->declarations.push_degenerate_list_at_head(&declarator_list->link);
@@ -1748,11 +1754,34 @@ extern "C" {
 
 void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
-                          bool dump_ast, bool dump_hir)
+                          bool dump_ast, bool dump_hir, bool force_recompile)
 {
+   const char *source = shader->Source;
+
+   shader->CompileSkipped = false;
+
+   if (ctx->Cache) {
+      shader_cache_compute_shader_sha1(ctx, shader);
+
+      /* A shader that compiled successfully before will do so again.  Defer
+       * the real compile until link time, where it is only needed if the
+       * linked program itself is not in the cache.
+       */
+      if (!force_recompile && !dump_ast && !dump_hir &&
+          !(ctx->Shader.Flags & (GLSL_DUMP | GLSL_LOG)) &&
+          disk_cache_has_key(ctx->Cache, shader->sha1)) {
+         ralloc_free(shader->ir);
+         shader->ir = NULL;
+         ralloc_free(shader->InfoLog);
+         shader->InfoLog = ralloc_strdup(shader, "");
+         shader->CompileStatus = true;
+         shader->CompileSkipped = true;
+         return;
+      }
+   }
+
    struct _mesa_glsl_parse_state *state =
       new(shader) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
-   const char *source = shader->Source;
 
    if (ctx->Const.GenerateTemporaryNames)
       (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
@@ -1869,6 +1898,9 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 
    _mesa_glsl_initialize_derived_variables(shader);
 
+   if (ctx->Cache && shader->CompileStatus)
+      disk_cache_put_key(ctx->Cache, shader->sha1);
+
    delete state->symbols;
    ralloc_free(state);
 }
@@ -1891,6 +1923,11 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
  *                                    unrolled.  Setting to 0 disables loop
  *                                    unrolling.
  * \param options                     The driver's preferred shader options.
+ *
+ * Drivers which translate the IR to NIR (\c options->NirOptions is set) get
+ * a reduced set of passes: the ones linking depends on, and the ones NIR has
+ * no equivalent for yet, like function inlining and loop unrolling.  The
+ * rest is left to the NIR optimization loop.
  */
 bool
 do_common_optimization(exec_list *ir, bool linked,
@@ -1899,6 +1936,7 @@ do_common_optimization(exec_list *ir, bool linked,
                        bool native_integers)
 {
    const bool debug = false;
+   const bool nir = options->NirOptions != NULL;
    GLboolean progress = GL_FALSE;
 
 #define OPT(PASS, ...) do {                                             \
@@ -1923,11 +1961,13 @@ do_common_optimization(exec_list *ir, bool linked,
       OPT(do_structure_splitting, ir);
    }
    propagate_invariance(ir);
-   OPT(do_if_simplification, ir);
-   OPT(opt_flatten_nested_if_blocks, ir);
-   OPT(opt_conditional_discard, ir);
-   OPT(do_copy_propagation, ir);
-   OPT(do_copy_propagation_elements, ir);
+   if (!nir) {
+      OPT(do_if_simplification, ir);
+      OPT(opt_flatten_nested_if_blocks, ir);
+      OPT(opt_conditional_discard, ir);
+      OPT(do_copy_propagation, ir);
+      OPT(do_copy_propagation_elements, ir);
+   }
 
    if (options->OptimizeForAOS && !linked)
       OPT(opt_flip_matrices, ir);
@@ -1940,25 +1980,32 @@ do_common_optimization(exec_list *ir, bool linked,
       OPT(do_dead_code, ir, uniform_locations_assigned);
    else
       OPT(do_dead_code_unlinked, ir);
-   OPT(do_dead_code_local, ir);
-   OPT(do_tree_grafting, ir);
+   if (!nir) {
+      OPT(do_dead_code_local, ir);
+      OPT(do_tree_grafting, ir);
+   }
+   /* Loop unrolling needs constant loop bounds. */
    OPT(do_constant_propagation, ir);
    if (linked)
       OPT(do_constant_variable, ir);
    else
       OPT(do_constant_variable_unlinked, ir);
    OPT(do_constant_folding, ir);
-   OPT(do_minmax_prune, ir);
-   OPT(do_rebalance_tree, ir);
-   OPT(do_algebraic, ir, native_integers, options);
+   if (!nir) {
+      OPT(do_minmax_prune, ir);
+      OPT(do_rebalance_tree, ir);
+      OPT(do_algebraic, ir, native_integers, options);
+   }
    OPT(do_lower_jumps, ir);
    OPT(do_vec_index_to_swizzle, ir);
    OPT(lower_vector_insert, ir, false);
-   OPT(do_swizzle_swizzle, ir);
-   OPT(do_noop_swizzle, ir);
+   if (!nir) {
+      OPT(do_swizzle_swizzle, ir);
+      OPT(do_noop_swizzle, ir);
 
-   OPT(optimize_split_arrays, ir, linked);
-   OPT(optimize_redundant_jumps, ir);
+      OPT(optimize_split_arrays, ir, linked);
+      OPT(optimize_redundant_jumps, ir);
+   }
 
    loop_state *ls = analyze_loop_variables(ir);
    if (ls->loop_found) {
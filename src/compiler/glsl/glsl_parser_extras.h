@@ -275,6 +275,13 @@ struct _mesa_glsl_parse_state {
 
    struct gl_context *const ctx;
    void *scanner;
+
+   /**
+    * Linear context the AST and the identifier strings are allocated out of.
+    * None of it is freed before the parse state itself.
+    */
+   void *linalloc;
+
    exec_list translation_unit;
    glsl_symbol_table *symbols;
 
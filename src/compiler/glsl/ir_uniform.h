@@ -107,6 +107,11 @@ struct gl_uniform_storage {
 
    struct gl_opaque_uniform_index opaque[MESA_SHADER_STAGES];
 
+   /**
+    * Mask of (1 << MESA_SHADER_x) bits of the stages which use this uniform.
+    */
+   unsigned active_shader_mask;
+
    /**
     * Storage used by the driver for the uniform
     */
@@ -78,6 +78,7 @@
 #include "ir_rvalue_visitor.h"
 #include "ir_uniform.h"
 
+#include "main/shaderapi.h"
 #include "main/shaderobj.h"
 #include "main/enums.h"
 
@@ -2269,7 +2270,10 @@ link_intrastage_shaders(void *mem_ctx,
          _mesa_glsl_initialize_builtin_functions();
          linking_shaders[num_shaders] = _mesa_glsl_get_builtin_function_shader();
 
+         /* Other threads may add built-ins to the built-in shader. */
+         _mesa_glsl_lock_builtin_functions();
          ok = link_function_calls(prog, linked, linking_shaders, num_shaders + 1);
+         _mesa_glsl_unlock_builtin_functions();
 
          free(linking_shaders);
       } else {
@@ -3404,15 +3408,15 @@ should_add_buffer_variable(struct gl_shader_program *shProg,
 }
 
 static bool
-add_program_resource(struct gl_shader_program *prog, GLenum type,
+add_program_resource(struct gl_shader_program *prog,
+                     hash_table *resource_set, GLenum type,
                      const void *data, uint8_t stages)
 {
    assert(data);
 
    /* If resource already exists, do not add it again. */
-   for (unsigned i = 0; i < prog->NumProgramResourceList; i++)
-      if (prog->ProgramResourceList[i].Data == data)
-         return true;
+   if (hash_table_find(resource_set, data))
+      return true;
 
    prog->ProgramResourceList =
       reralloc(prog,
@@ -3433,6 +3437,7 @@ add_program_resource(struct gl_shader_program *prog, GLenum type,
    res->StageReferences = stages;
 
    prog->NumProgramResourceList++;
+   hash_table_insert(resource_set, (void *) data, data);
 
    return true;
 }
@@ -3521,6 +3526,117 @@ build_stageref(struct gl_shader_program *shProg, const char *name,
    return stages;
 }
 
+/**
+ * Builds stage reference bitmasks like build_stageref(), for many names at
+ * once.  The variable names of each linked stage are put in hash tables up
+ * front, instead of walking the IR of every stage for each name.
+ */
+class stageref_table
+{
+public:
+   stageref_table(struct gl_shader_program *shProg, unsigned mode)
+   {
+      this->mem_ctx = ralloc_context(NULL);
+
+      for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+         struct gl_shader *sh = shProg->_LinkedShaders[i];
+
+         this->vars[i] = NULL;
+         this->packed[i] = NULL;
+         if (!sh)
+            continue;
+
+         this->vars[i] = hash_table_ctor(shProg->NumUniformStorage,
+                                         hash_table_string_hash,
+                                         hash_table_string_compare);
+         this->packed[i] = hash_table_ctor(0, hash_table_string_hash,
+                                           hash_table_string_compare);
+
+         foreach_in_list(ir_instruction, node, sh->ir) {
+            ir_variable *var = node->as_variable();
+            if (!var)
+               continue;
+
+            /* See included_in_packed_varying(). */
+            if (strncmp(var->name, "packed:", 7) == 0) {
+               char *list = ralloc_strdup(this->mem_ctx, var->name + 7);
+               char *saveptr;
+               char *token = strtok_r(list, ",", &saveptr);
+               while (token) {
+                  hash_table_insert(this->packed[i], token, token);
+                  token = strtok_r(NULL, ",", &saveptr);
+               }
+            }
+
+            if (var->data.mode == mode)
+               hash_table_insert(this->vars[i], var, var->name);
+         }
+      }
+   }
+
+   ~stageref_table()
+   {
+      for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+         if (this->vars[i]) {
+            hash_table_dtor(this->vars[i]);
+            hash_table_dtor(this->packed[i]);
+         }
+      }
+      ralloc_free(this->mem_ctx);
+   }
+
+   uint8_t get(const char *name)
+   {
+      uint8_t stages = 0;
+
+      /* The variable name may be followed by array subscripts and struct
+       * members, look up each of those prefixes.
+       */
+      char *prefix = strdup(name);
+      assert(prefix);
+
+      for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+         if (!this->vars[i])
+            continue;
+
+         if (hash_table_find(this->packed[i], name)) {
+            stages |= 1 << i;
+            continue;
+         }
+
+         for (char *c = prefix; ; c++) {
+            if (*c != '\0' && *c != '[' && *c != '.')
+               continue;
+
+            const char saved = *c;
+            *c = '\0';
+            const bool found = hash_table_find(this->vars[i], prefix) != NULL;
+            *c = saved;
+
+            if (found) {
+               stages |= 1 << i;
+               break;
+            }
+
+            if (saved == '\0')
+               break;
+         }
+      }
+
+      free(prefix);
+      return stages;
+   }
+
+private:
+   void *mem_ctx;
+
+   /** Names of the variables with the requested mode, per stage. */
+   hash_table *vars[MESA_SHADER_STAGES];
+
+   /** Names of the variables packed into 'packed:a,b,c' varyings. */
+   hash_table *packed[MESA_SHADER_STAGES];
+};
+
 /**
  * Create gl_shader_variable from ir_variable class.
  */
@@ -3579,7 +3695,8 @@ create_shader_variable(struct gl_shader_program *shProg,
 }
 
 static bool
-add_shader_variable(struct gl_shader_program *shProg, unsigned stage_mask,
+add_shader_variable(struct gl_shader_program *shProg,
+                    hash_table *resource_set, unsigned stage_mask,
                     GLenum programInterface, ir_variable *var,
                     const char *name, const glsl_type *type,
                     bool use_implicit_location, int location)
@@ -3603,7 +3720,8 @@ add_shader_variable(struct gl_shader_program *shProg, unsigned stage_mask,
       for (unsigned i = 0; i < type->length; i++) {
          const struct glsl_struct_field *field = &type->fields.structure[i];
          char *field_name = ralloc_asprintf(shProg, "%s.%s", name, field->name);
-         if (!add_shader_variable(shProg, stage_mask, programInterface,
+         if (!add_shader_variable(shProg, resource_set,
+                                  stage_mask, programInterface,
                                   var, field_name, field->type,
                                   use_implicit_location, field_location))
             return false;
@@ -3627,13 +3745,15 @@ add_shader_variable(struct gl_shader_program *shProg, unsigned stage_mask,
       if (!sha_v)
          return false;
 
-      return add_program_resource(shProg, programInterface, sha_v, stage_mask);
+      return add_program_resource(shProg, resource_set,
+                                  programInterface, sha_v, stage_mask);
    }
    }
 }
 
 static bool
 add_interface_variables(struct gl_shader_program *shProg,
+                        hash_table *resource_set,
                         unsigned stage, GLenum programInterface)
 {
    exec_list *ir = shProg->_LinkedShaders[stage]->ir;
@@ -3680,7 +3800,8 @@ add_interface_variables(struct gl_shader_program *shProg,
          (stage == MESA_SHADER_VERTEX && var->data.mode == ir_var_shader_in) ||
          (stage == MESA_SHADER_FRAGMENT && var->data.mode == ir_var_shader_out);
 
-      if (!add_shader_variable(shProg, 1 << stage, programInterface,
+      if (!add_shader_variable(shProg, resource_set,
+                               1 << stage, programInterface,
                                var, var->name, var->type, vs_input_or_fs_output,
                                var->data.location - loc_bias))
          return false;
@@ -3689,7 +3810,9 @@ add_interface_variables(struct gl_shader_program *shProg,
 }
 
 static bool
-add_packed_varyings(struct gl_shader_program *shProg, int stage, GLenum type)
+add_packed_varyings(struct gl_shader_program *shProg,
+                    hash_table *resource_set,
+                    int stage, GLenum type)
 {
    struct gl_shader *sh = shProg->_LinkedShaders[stage];
    GLenum iface;
@@ -3714,7 +3837,7 @@ add_packed_varyings(struct gl_shader_program *shProg, int stage, GLenum type)
          if (type == iface) {
             const int stage_mask =
                build_stageref(shProg, var->name, var->data.mode);
-            if (!add_shader_variable(shProg, stage_mask,
+            if (!add_shader_variable(shProg, resource_set, stage_mask,
                                      iface, var, var->name, var->type, false,
                                      var->data.location - VARYING_SLOT_VAR0))
                return false;
@@ -3725,7 +3848,8 @@ add_packed_varyings(struct gl_shader_program *shProg, int stage, GLenum type)
 }
 
 static bool
-add_fragdata_arrays(struct gl_shader_program *shProg)
+add_fragdata_arrays(struct gl_shader_program *shProg,
+                    hash_table *resource_set)
 {
    struct gl_shader *sh = shProg->_LinkedShaders[MESA_SHADER_FRAGMENT];
 
@@ -3737,7 +3861,7 @@ add_fragdata_arrays(struct gl_shader_program *shProg)
       if (var) {
          assert(var->data.mode == ir_var_shader_out);
 
-         if (!add_shader_variable(shProg,
+         if (!add_shader_variable(shProg, resource_set,
                                   1 << MESA_SHADER_FRAGMENT,
                                   GL_PROGRAM_OUTPUT, var, var->name, var->type,
                                   true, var->data.location - FRAG_RESULT_DATA0))
@@ -3957,20 +4081,13 @@ write_top_level_array_size_and_stride:
 }
 
 /**
- * Builds up a list of program resources that point to existing
- * resource data.
+ * Adds all active resources of the program to its resource list.
  */
-void
-build_program_resource_list(struct gl_context *ctx,
-                            struct gl_shader_program *shProg)
+static bool
+add_program_resources(struct gl_context *ctx,
+                      struct gl_shader_program *shProg,
+                      hash_table *resource_set)
 {
-   /* Rebuild resource list. */
-   if (shProg->ProgramResourceList) {
-      ralloc_free(shProg->ProgramResourceList);
-      shProg->ProgramResourceList = NULL;
-      shProg->NumProgramResourceList = 0;
-   }
-
    int input_stage = MESA_SHADER_STAGES, output_stage = 0;
 
    /* Determine first input and final output stage. These are used to
@@ -3987,34 +4104,35 @@ build_program_resource_list(struct gl_context *ctx,
 
    /* Empty shader, no resources. */
    if (input_stage == MESA_SHADER_STAGES && output_stage == 0)
-      return;
+      return true;
 
    /* Program interface needs to expose varyings in case of SSO. */
    if (shProg->SeparateShader) {
-      if (!add_packed_varyings(shProg, input_stage, GL_PROGRAM_INPUT))
-         return;
+      if (!add_packed_varyings(shProg, resource_set, input_stage, GL_PROGRAM_INPUT))
+         return false;
 
-      if (!add_packed_varyings(shProg, output_stage, GL_PROGRAM_OUTPUT))
-         return;
+      if (!add_packed_varyings(shProg, resource_set, output_stage, GL_PROGRAM_OUTPUT))
+         return false;
    }
 
-   if (!add_fragdata_arrays(shProg))
-      return;
+   if (!add_fragdata_arrays(shProg, resource_set))
+      return false;
 
    /* Add inputs and outputs to the resource list. */
-   if (!add_interface_variables(shProg, input_stage, GL_PROGRAM_INPUT))
-      return;
+   if (!add_interface_variables(shProg, resource_set, input_stage, GL_PROGRAM_INPUT))
+      return false;
 
-   if (!add_interface_variables(shProg, output_stage, GL_PROGRAM_OUTPUT))
-      return;
+   if (!add_interface_variables(shProg, resource_set, output_stage, GL_PROGRAM_OUTPUT))
+      return false;
 
    /* Add transform feedback varyings. */
    if (shProg->LinkedTransformFeedback.NumVarying > 0) {
       for (int i = 0; i < shProg->LinkedTransformFeedback.NumVarying; i++) {
-         if (!add_program_resource(shProg, GL_TRANSFORM_FEEDBACK_VARYING,
+         if (!add_program_resource(shProg, resource_set,
+                                   GL_TRANSFORM_FEEDBACK_VARYING,
                                    &shProg->LinkedTransformFeedback.Varyings[i],
                                    0))
-         return;
+         return false;
       }
    }
 
@@ -4022,22 +4140,23 @@ build_program_resource_list(struct gl_context *ctx,
    for (unsigned i = 0; i < ctx->Const.MaxTransformFeedbackBuffers; i++) {
       if ((shProg->LinkedTransformFeedback.ActiveBuffers >> i) & 1) {
          shProg->LinkedTransformFeedback.Buffers[i].Binding = i;
-         if (!add_program_resource(shProg, GL_TRANSFORM_FEEDBACK_BUFFER,
+         if (!add_program_resource(shProg, resource_set,
+                                   GL_TRANSFORM_FEEDBACK_BUFFER,
                                    &shProg->LinkedTransformFeedback.Buffers[i],
                                    0))
-         return;
+         return false;
       }
    }
 
    /* Add uniforms from uniform storage. */
+   stageref_table uniform_stagerefs(shProg, ir_var_uniform);
    for (unsigned i = 0; i < shProg->NumUniformStorage; i++) {
       /* Do not add uniforms internally used by Mesa. */
       if (shProg->UniformStorage[i].hidden)
          continue;
 
       uint8_t stageref =
-         build_stageref(shProg, shProg->UniformStorage[i].name,
-                        ir_var_uniform);
+         uniform_stagerefs.get(shProg->UniformStorage[i].name);
 
       /* Add stagereferences for uniforms in a uniform block. */
       bool is_shader_storage =  shProg->UniformStorage[i].is_shader_storage;
@@ -4057,30 +4176,31 @@ build_program_resource_list(struct gl_context *ctx,
          calculate_array_size_and_stride(shProg, &shProg->UniformStorage[i]);
       }
 
-      if (!add_program_resource(shProg, type,
+      if (!add_program_resource(shProg, resource_set, type,
                                 &shProg->UniformStorage[i], stageref))
-         return;
+         return false;
    }
 
    /* Add program uniform blocks. */
    for (unsigned i = 0; i < shProg->NumUniformBlocks; i++) {
-      if (!add_program_resource(shProg, GL_UNIFORM_BLOCK,
+      if (!add_program_resource(shProg, resource_set, GL_UNIFORM_BLOCK,
           &shProg->UniformBlocks[i], 0))
-         return;
+         return false;
    }
 
    /* Add program shader storage blocks. */
    for (unsigned i = 0; i < shProg->NumShaderStorageBlocks; i++) {
-      if (!add_program_resource(shProg, GL_SHADER_STORAGE_BLOCK,
+      if (!add_program_resource(shProg, resource_set, GL_SHADER_STORAGE_BLOCK,
           &shProg->ShaderStorageBlocks[i], 0))
-         return;
+         return false;
    }
 
    /* Add atomic counter buffers. */
    for (unsigned i = 0; i < shProg->NumAtomicBuffers; i++) {
-      if (!add_program_resource(shProg, GL_ATOMIC_COUNTER_BUFFER,
+      if (!add_program_resource(shProg, resource_set,
+                                GL_ATOMIC_COUNTER_BUFFER,
                                 &shProg->AtomicBuffers[i], 0))
-         return;
+         return false;
    }
 
    for (unsigned i = 0; i < shProg->NumUniformStorage; i++) {
@@ -4095,8 +4215,9 @@ build_program_resource_list(struct gl_context *ctx,
 
          type = _mesa_shader_stage_to_subroutine_uniform((gl_shader_stage)j);
          /* add shader subroutines */
-         if (!add_program_resource(shProg, type, &shProg->UniformStorage[i], 0))
-            return;
+         if (!add_program_resource(shProg, resource_set, type,
+                                   &shProg->UniformStorage[i], 0))
+            return false;
       }
    }
 
@@ -4109,10 +4230,43 @@ build_program_resource_list(struct gl_context *ctx,
 
       type = _mesa_shader_stage_to_subroutine((gl_shader_stage)i);
       for (unsigned j = 0; j < sh->NumSubroutineFunctions; j++) {
-         if (!add_program_resource(shProg, type, &sh->SubroutineFunctions[j], 0))
-            return;
+         if (!add_program_resource(shProg, resource_set, type,
+                                   &sh->SubroutineFunctions[j], 0))
+            return false;
       }
    }
+
+   return true;
+}
+
+/**
+ * Builds up a list of program resources that point to existing
+ * resource data.
+ */
+void
+build_program_resource_list(struct gl_context *ctx,
+                            struct gl_shader_program *shProg)
+{
+   /* Rebuild resource list. */
+   if (shProg->ProgramResourceList) {
+      ralloc_free(shProg->ProgramResourceList);
+      shProg->ProgramResourceList = NULL;
+      shProg->NumProgramResourceList = 0;
+   }
+   if (shProg->ProgramResourceHash) {
+      hash_table_dtor(shProg->ProgramResourceHash);
+      shProg->ProgramResourceHash = NULL;
+   }
+
+   /* Data pointers of the resources added so far. */
+   hash_table *resource_set =
+      hash_table_ctor(shProg->NumUniformStorage, hash_table_pointer_hash,
+                      hash_table_pointer_compare);
+
+   if (add_program_resources(ctx, shProg, resource_set))
+      _mesa_create_program_resource_hash(shProg);
+
+   hash_table_dtor(resource_set);
 }
 
 /**
@@ -693,6 +693,7 @@ public:
                                              const exec_list *instructions);
 
    virtual ir_visitor_status visit_leave(ir_emit_vertex *ev);
+   virtual ir_visitor_status visit_enter(ir_assignment *);
 
 private:
    /**
@@ -724,6 +725,17 @@ lower_packed_varyings_gs_splicer::visit_leave(ir_emit_vertex *ev)
    return visit_continue;
 }
 
+
+/**
+ * EmitVertex() can't appear inside an assignment, so don't walk the
+ * expression trees.
+ */
+ir_visitor_status
+lower_packed_varyings_gs_splicer::visit_enter(ir_assignment *)
+{
+   return visit_continue_with_parent;
+}
+
 /**
  * Visitor that splices varying packing code before every return.
  */
@@ -734,6 +746,7 @@ public:
                                                  const exec_list *instructions);
 
    virtual ir_visitor_status visit_leave(ir_return *ret);
+   virtual ir_visitor_status visit_enter(ir_assignment *);
 
 private:
    /**
@@ -764,6 +777,17 @@ lower_packed_varyings_return_splicer::visit_leave(ir_return *ret)
    return visit_continue;
 }
 
+
+/**
+ * A return can't appear inside an assignment, so don't walk the expression
+ * trees.
+ */
+ir_visitor_status
+lower_packed_varyings_return_splicer::visit_enter(ir_assignment *)
+{
+   return visit_continue_with_parent;
+}
+
 void
 lower_packed_varyings(void *mem_ctx, unsigned locations_used,
                       ir_variable_mode mode, unsigned gs_input_vertices,
@@ -783,6 +807,11 @@ lower_packed_varyings(void *mem_ctx, unsigned locations_used,
                                          disable_varying_packing,
                                          xfb_enabled);
    visitor.run(shader);
+
+   /* Nothing needed packing, so there is no code to splice in. */
+   if (new_instructions.is_empty() && new_variables.is_empty())
+      return;
+
    if (mode == ir_var_shader_out) {
       if (shader->Stage == MESA_SHADER_GEOMETRY) {
          /* For geometry shaders, outputs need to be lowered before each call
@@ -804,7 +833,10 @@ lower_packed_varyings(void *mem_ctx, unsigned locations_used,
 
          main_func_sig->body.head->insert_before(&new_variables);
 
-         splicer.run(instructions);
+         /* Outputs only have to be packed when main() returns, not when
+          * some other function does.
+          */
+         splicer.run(&main_func_sig->body);
 
          /* Lower outputs at the end of main() if the last instruction is not
           * a return statement
@@ -37,35 +37,198 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "compiler/glsl_types.h"
+#include "util/hash_table.h"
+#include "util/set.h"
 
 namespace {
 
-class acp_entry : public exec_node
+struct acp_ref
 {
-public:
-   acp_entry(ir_variable *lhs, ir_variable *rhs)
-   {
-      assert(lhs);
-      assert(rhs);
-      this->lhs = lhs;
-      this->rhs = rhs;
-   }
+   ir_variable *var;
+   acp_ref *next;
+};
 
-   ir_variable *lhs;
+/**
+ * What is known about the copies to and from a variable.
+ */
+struct acp_entry
+{
+   /** The variable can be read from rhs instead, if it is set. */
    ir_variable *rhs;
+
+   /**
+    * The variables which were copied from this one.  Some may have been
+    * written since, so they are only candidates.
+    */
+   acp_ref *copies;
+
+   /**
+    * The entry only counts if this matches the generation of the table,
+    * which lets make_empty() forget all entries at once.
+    */
+   unsigned generation;
 };
 
+struct acp_undo
+{
+   /** The entry to restore, or NULL to restore the table generation. */
+   acp_entry *entry;
+   acp_entry saved;
+   acp_undo *next;
+};
 
-class kill_entry : public exec_node
+/**
+ * The available copies, by variable.
+ *
+ * Instead of copying the copies of the parent into each nested block, a
+ * block opens a scope in the same table: the changes made to the entries
+ * until the scope is closed are logged, and closing the scope undoes them.
+ */
+class acp_table
 {
 public:
-   kill_entry(ir_variable *var)
+   DECLARE_RALLOC_CXX_OPERATORS(acp_table);
+
+   acp_table()
    {
-      assert(var);
-      this->var = var;
+      this->ht = _mesa_hash_table_create(this, _mesa_hash_pointer,
+                                         _mesa_key_pointer_equal);
+      this->lin_ctx = linear_context(this);
+      this->generation = 1;
+      this->next_generation = 2;
+      this->open_scopes = 0;
+      this->log = NULL;
+      this->free_undo = NULL;
    }
 
-   ir_variable *var;
+   ir_variable *find(ir_variable *lhs) const
+   {
+      const acp_entry *a = find_entry(lhs);
+      return a ? a->rhs : NULL;
+   }
+
+   void add(ir_variable *lhs, ir_variable *rhs)
+   {
+      get_entry_for_write(lhs)->rhs = rhs;
+
+      acp_entry *r = get_entry_for_write(rhs);
+      acp_ref *ref = linear_alloc(lin_ctx, acp_ref);
+      ref->var = lhs;
+      ref->next = r->copies;
+      r->copies = ref;
+   }
+
+   /** Removes the copies to or from \p var. */
+   void kill(ir_variable *var)
+   {
+      if (!find_entry(var))
+         return;
+
+      acp_entry *v = get_entry_for_write(var);
+      v->rhs = NULL;
+
+      for (acp_ref *ref = v->copies; ref != NULL; ref = ref->next) {
+         if (find(ref->var) == var)
+            get_entry_for_write(ref->var)->rhs = NULL;
+      }
+
+      v->copies = NULL;
+   }
+
+   void make_empty()
+   {
+      if (open_scopes > 0)
+         log_change(NULL);
+
+      generation = next_generation++;
+   }
+
+   acp_undo *open_scope()
+   {
+      open_scopes++;
+      return log;
+   }
+
+   /** Undoes the changes made since the matching open_scope(). */
+   void close_scope(acp_undo *mark)
+   {
+      while (log != mark) {
+         acp_undo *u = log;
+
+         if (u->entry)
+            *u->entry = u->saved;
+         else
+            generation = u->saved.generation;
+
+         log = u->next;
+         u->next = free_undo;
+         free_undo = u;
+      }
+
+      open_scopes--;
+   }
+
+private:
+   const acp_entry *find_entry(ir_variable *var) const
+   {
+      struct hash_entry *entry = _mesa_hash_table_search(ht, var);
+      if (!entry)
+         return NULL;
+
+      const acp_entry *a = (const acp_entry *) entry->data;
+      return a->generation == generation ? a : NULL;
+   }
+
+   void log_change(acp_entry *a)
+   {
+      acp_undo *u = free_undo;
+      if (u)
+         free_undo = u->next;
+      else
+         u = linear_alloc(lin_ctx, acp_undo);
+
+      u->entry = a;
+      if (a)
+         u->saved = *a;
+      else
+         u->saved.generation = generation;
+      u->next = log;
+      log = u;
+   }
+
+   acp_entry *get_entry_for_write(ir_variable *var)
+   {
+      struct hash_entry *entry = _mesa_hash_table_search(ht, var);
+      acp_entry *a;
+
+      if (entry) {
+         a = (acp_entry *) entry->data;
+      } else {
+         a = linear_zalloc(lin_ctx, acp_entry);
+         _mesa_hash_table_insert(ht, var, a);
+      }
+
+      if (open_scopes > 0)
+         log_change(a);
+
+      if (a->generation != generation) {
+         memset(a, 0, sizeof(*a));
+         a->generation = generation;
+      }
+
+      return a;
+   }
+
+   /** ir_variable * -> acp_entry */
+   struct hash_table *ht;
+   void *lin_ctx;
+
+   unsigned generation;
+   unsigned next_generation;
+
+   unsigned open_scopes;
+   acp_undo *log;
+   acp_undo *free_undo;
 };
 
 class ir_copy_propagation_visitor : public ir_hierarchical_visitor {
@@ -74,8 +237,8 @@ public:
    {
       progress = false;
       mem_ctx = ralloc_context(0);
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      this->acp = new(mem_ctx) acp_table;
+      this->kills = create_kills();
    }
    ~ir_copy_propagation_visitor()
    {
@@ -94,13 +257,19 @@ public:
    void kill(ir_variable *ir);
    void handle_if_block(exec_list *instructions);
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
+   struct set *create_kills()
+   {
+      return _mesa_set_create(mem_ctx, _mesa_hash_pointer,
+                              _mesa_key_pointer_equal);
+   }
+
+   /** The available copies to propagate */
+   acp_table *acp;
    /**
-    * List of kill_entry: The variables whose values were killed in this
+    * Set of ir_variable *: The variables whose values were killed in this
     * block.
     */
-   exec_list *kills;
+   struct set *kills;
 
    bool progress;
 
@@ -118,21 +287,20 @@ ir_copy_propagation_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   acp_undo *mark = this->acp->open_scope();
+   struct set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->acp->make_empty();
+   this->kills = create_kills();
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body);
 
-   ralloc_free(this->acp);
-   ralloc_free(this->kills);
+   this->acp->close_scope(mark);
+   _mesa_set_destroy(this->kills, NULL);
 
    this->kills = orig_kills;
-   this->acp = orig_acp;
    this->killed_all = orig_killed_all;
 
    return visit_continue_with_parent;
@@ -168,14 +336,10 @@ ir_copy_propagation_visitor::visit(ir_dereference_variable *ir)
    if (this->in_assignee)
       return visit_continue;
 
-   ir_variable *var = ir->var;
-
-   foreach_in_list(acp_entry, entry, this->acp) {
-      if (var == entry->lhs) {
-	 ir->var = entry->rhs;
-	 this->progress = true;
-	 break;
-      }
+   ir_variable *rhs = this->acp->find(ir->var);
+   if (rhs) {
+      ir->var = rhs;
+      this->progress = true;
    }
 
    return visit_continue;
@@ -208,36 +372,32 @@ ir_copy_propagation_visitor::visit_enter(ir_call *ir)
 void
 ir_copy_propagation_visitor::handle_if_block(exec_list *instructions)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   /* The initial acp is the one of the parent block */
+   acp_undo *mark = this->acp->open_scope();
+   struct set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->kills = create_kills();
    this->killed_all = false;
 
-   /* Populate the initial acp with a copy of the original */
-   foreach_in_list(acp_entry, a, orig_acp) {
-      this->acp->push_tail(new(this->acp) acp_entry(a->lhs, a->rhs));
-   }
-
    visit_list_elements(this, instructions);
 
+   this->acp->close_scope(mark);
+
    if (this->killed_all) {
-      orig_acp->make_empty();
+      this->acp->make_empty();
    }
 
-   exec_list *new_kills = this->kills;
+   struct set *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
-   this->acp = orig_acp;
    this->killed_all = this->killed_all || orig_killed_all;
 
-   foreach_in_list(kill_entry, k, new_kills) {
-      kill(k->var);
+   struct set_entry *k;
+   set_foreach(new_kills, k) {
+      kill((ir_variable *) k->key);
    }
 
-   ralloc_free(new_kills);
+   _mesa_set_destroy(new_kills, NULL);
 }
 
 ir_visitor_status
@@ -255,35 +415,36 @@ ir_copy_propagation_visitor::visit_enter(ir_if *ir)
 ir_visitor_status
 ir_copy_propagation_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   acp_undo *mark = this->acp->open_scope();
+   struct set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->acp->make_empty();
+   this->kills = create_kills();
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body_instructions);
 
+   this->acp->close_scope(mark);
+
    if (this->killed_all) {
-      orig_acp->make_empty();
+      this->acp->make_empty();
    }
 
-   exec_list *new_kills = this->kills;
+   struct set *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
-   this->acp = orig_acp;
    this->killed_all = this->killed_all || orig_killed_all;
 
-   foreach_in_list(kill_entry, k, new_kills) {
-      kill(k->var);
+   struct set_entry *k;
+   set_foreach(new_kills, k) {
+      kill((ir_variable *) k->key);
    }
 
-   ralloc_free(new_kills);
+   _mesa_set_destroy(new_kills, NULL);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
@@ -295,15 +456,11 @@ ir_copy_propagation_visitor::kill(ir_variable *var)
    assert(var != NULL);
 
    /* Remove any entries currently in the ACP for this kill. */
-   foreach_in_list_safe(acp_entry, entry, acp) {
-      if (entry->lhs == var || entry->rhs == var) {
-	 entry->remove();
-      }
-   }
+   this->acp->kill(var);
 
    /* Add the LHS variable to the list of killed variables in this block.
     */
-   this->kills->push_tail(new(this->kills) kill_entry(var));
+   _mesa_set_add(this->kills, var);
 }
 
 /**
@@ -313,8 +470,6 @@ ir_copy_propagation_visitor::kill(ir_variable *var)
 void
 ir_copy_propagation_visitor::add_copy(ir_assignment *ir)
 {
-   acp_entry *entry;
-
    if (ir->condition)
       return;
 
@@ -333,8 +488,7 @@ ir_copy_propagation_visitor::add_copy(ir_assignment *ir)
       } else if (lhs_var->data.mode != ir_var_shader_storage &&
                  lhs_var->data.mode != ir_var_shader_shared &&
                  lhs_var->data.precise == rhs_var->data.precise) {
-	 entry = new(this->acp) acp_entry(lhs_var, rhs_var);
-	 this->acp->push_tail(entry);
+	 this->acp->add(lhs_var, rhs_var);
       }
    }
 }
@@ -46,48 +46,228 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "compiler/glsl_types.h"
+#include "util/hash_table.h"
 
 static bool debug = false;
 
 namespace {
 
-class acp_entry : public exec_node
+struct acp_ref
+{
+   ir_variable *var;
+   acp_ref *next;
+};
+
+/**
+ * What is known about the copies to and from a variable.
+ */
+struct acp_entry
+{
+   /**
+    * Channel i of the variable can be read from channel swizzle[i] of rhs[i]
+    * instead, if rhs[i] is set.
+    */
+   ir_variable *rhs[4];
+   int swizzle[4];
+
+   /**
+    * The variables which were copied from this one.  Some may have been
+    * written since, so they are only candidates.
+    */
+   acp_ref *copies;
+
+   /**
+    * The entry only counts if this matches the generation of the table,
+    * which lets make_empty() forget all entries at once.
+    */
+   unsigned generation;
+};
+
+struct acp_undo
+{
+   /** The entry to restore, or NULL to restore the table generation. */
+   acp_entry *entry;
+   acp_entry saved;
+   acp_undo *next;
+};
+
+/**
+ * The available copies, by variable.
+ *
+ * Instead of copying the copies of the parent into each nested block, a
+ * block opens a scope in the same table: the changes made to the entries
+ * until the scope is closed are logged, and closing the scope undoes them.
+ */
+class acp_table
 {
 public:
-   acp_entry(ir_variable *lhs, ir_variable *rhs, int write_mask, int swizzle[4])
+   DECLARE_RALLOC_CXX_OPERATORS(acp_table);
+
+   acp_table()
+   {
+      this->ht = _mesa_hash_table_create(this, _mesa_hash_pointer,
+                                         _mesa_key_pointer_equal);
+      this->lin_ctx = linear_context(this);
+      this->generation = 1;
+      this->next_generation = 2;
+      this->open_scopes = 0;
+      this->log = NULL;
+      this->free_undo = NULL;
+   }
+
+   const acp_entry *find(ir_variable *var) const
    {
-      this->lhs = lhs;
-      this->rhs = rhs;
-      this->write_mask = write_mask;
-      memcpy(this->swizzle, swizzle, sizeof(this->swizzle));
+      struct hash_entry *entry = _mesa_hash_table_search(ht, var);
+      if (!entry)
+         return NULL;
+
+      const acp_entry *a = (const acp_entry *) entry->data;
+      return a->generation == generation ? a : NULL;
    }
 
-   acp_entry(acp_entry *a)
+   /**
+    * Records that the \p write_mask channels of \p lhs are copies of the
+    * \p swizzle channels of \p rhs.  \p swizzle is indexed by the \p lhs
+    * channel.
+    */
+   void add(ir_variable *lhs, ir_variable *rhs, unsigned write_mask,
+            const int *swizzle)
    {
-      this->lhs = a->lhs;
-      this->rhs = a->rhs;
-      this->write_mask = a->write_mask;
-      memcpy(this->swizzle, a->swizzle, sizeof(this->swizzle));
+      acp_entry *l = get_entry_for_write(lhs);
+
+      for (int c = 0; c < 4; c++) {
+         if (write_mask & (1 << c)) {
+            l->rhs[c] = rhs;
+            l->swizzle[c] = swizzle[c];
+         }
+      }
+
+      acp_entry *r = get_entry_for_write(rhs);
+      acp_ref *ref = linear_alloc(lin_ctx, acp_ref);
+      ref->var = lhs;
+      ref->next = r->copies;
+      r->copies = ref;
    }
 
-   ir_variable *lhs;
-   ir_variable *rhs;
-   unsigned int write_mask;
-   int swizzle[4];
-};
+   /**
+    * Removes the copies to the \p write_mask channels of \p var, and all
+    * the copies from \p var.
+    */
+   void kill(ir_variable *var, unsigned write_mask)
+   {
+      if (!find(var))
+         return;
 
+      acp_entry *v = get_entry_for_write(var);
 
-class kill_entry : public exec_node
-{
-public:
-   kill_entry(ir_variable *var, int write_mask)
+      for (int c = 0; c < 4; c++) {
+         if (write_mask & (1 << c))
+            v->rhs[c] = NULL;
+      }
+
+      for (acp_ref *ref = v->copies; ref != NULL; ref = ref->next) {
+         const acp_entry *l = find(ref->var);
+
+         for (int c = 0; l != NULL && c < 4; c++) {
+            if (l->rhs[c] == var) {
+               acp_entry *w = get_entry_for_write(ref->var);
+
+               for (int i = 0; i < 4; i++) {
+                  if (w->rhs[i] == var)
+                     w->rhs[i] = NULL;
+               }
+               break;
+            }
+         }
+      }
+
+      v->copies = NULL;
+   }
+
+   void make_empty()
    {
-      this->var = var;
-      this->write_mask = write_mask;
+      if (open_scopes > 0)
+         log_change(NULL);
+
+      generation = next_generation++;
    }
 
-   ir_variable *var;
-   unsigned int write_mask;
+   acp_undo *open_scope()
+   {
+      open_scopes++;
+      return log;
+   }
+
+   /** Undoes the changes made since the matching open_scope(). */
+   void close_scope(acp_undo *mark)
+   {
+      while (log != mark) {
+         acp_undo *u = log;
+
+         if (u->entry)
+            *u->entry = u->saved;
+         else
+            generation = u->saved.generation;
+
+         log = u->next;
+         u->next = free_undo;
+         free_undo = u;
+      }
+
+      open_scopes--;
+   }
+
+private:
+   void log_change(acp_entry *a)
+   {
+      acp_undo *u = free_undo;
+      if (u)
+         free_undo = u->next;
+      else
+         u = linear_alloc(lin_ctx, acp_undo);
+
+      u->entry = a;
+      if (a)
+         u->saved = *a;
+      else
+         u->saved.generation = generation;
+      u->next = log;
+      log = u;
+   }
+
+   acp_entry *get_entry_for_write(ir_variable *var)
+   {
+      struct hash_entry *entry = _mesa_hash_table_search(ht, var);
+      acp_entry *a;
+
+      if (entry) {
+         a = (acp_entry *) entry->data;
+      } else {
+         a = linear_zalloc(lin_ctx, acp_entry);
+         _mesa_hash_table_insert(ht, var, a);
+      }
+
+      if (open_scopes > 0)
+         log_change(a);
+
+      if (a->generation != generation) {
+         memset(a, 0, sizeof(*a));
+         a->generation = generation;
+      }
+
+      return a;
+   }
+
+   /** ir_variable * -> acp_entry */
+   struct hash_table *ht;
+   void *lin_ctx;
+
+   unsigned generation;
+   unsigned next_generation;
+
+   unsigned open_scopes;
+   acp_undo *log;
+   acp_undo *free_undo;
 };
 
 class ir_copy_propagation_elements_visitor : public ir_rvalue_visitor {
@@ -98,8 +278,8 @@ public:
       this->killed_all = false;
       this->mem_ctx = ralloc_context(NULL);
       this->shader_mem_ctx = NULL;
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      this->acp = new(mem_ctx) acp_table;
+      this->kills = create_kills();
    }
    ~ir_copy_propagation_elements_visitor()
    {
@@ -116,16 +296,23 @@ public:
    void handle_rvalue(ir_rvalue **rvalue);
 
    void add_copy(ir_assignment *ir);
-   void kill(kill_entry *k);
+   void kill(ir_variable *var, unsigned write_mask);
    void handle_if_block(exec_list *instructions);
+   void merge_kills(struct hash_table *new_kills);
+
+   struct hash_table *create_kills()
+   {
+      return _mesa_hash_table_create(mem_ctx, _mesa_hash_pointer,
+                                     _mesa_key_pointer_equal);
+   }
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
+   /** The available copies to propagate */
+   acp_table *acp;
    /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
+    * ir_variable * -> write mask: The channels of variables whose values
+    * were killed in this block.
     */
-   exec_list *kills;
+   struct hash_table *kills;
 
    bool progress;
 
@@ -146,21 +333,20 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   acp_undo *mark = this->acp->open_scope();
+   struct hash_table *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->acp->make_empty();
+   this->kills = create_kills();
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body);
 
-   ralloc_free(this->acp);
-   ralloc_free(this->kills);
+   this->acp->close_scope(mark);
+   _mesa_hash_table_destroy(this->kills, NULL);
 
    this->kills = orig_kills;
-   this->acp = orig_acp;
    this->killed_all = orig_killed_all;
 
    return visit_continue_with_parent;
@@ -173,14 +359,10 @@ ir_copy_propagation_elements_visitor::visit_leave(ir_assignment *ir)
    ir_variable *var = ir->lhs->variable_referenced();
 
    if (var->type->is_scalar() || var->type->is_vector()) {
-      kill_entry *k;
-
       if (lhs)
-	 k = new(this->kills) kill_entry(var, ir->write_mask);
+	 kill(var, ir->write_mask);
       else
-	 k = new(this->kills) kill_entry(var, ~0);
-
-      kill(k);
+	 kill(var, ~0);
    }
 
    add_copy(ir);
@@ -248,18 +430,16 @@ ir_copy_propagation_elements_visitor::handle_rvalue(ir_rvalue **ir)
    /* Try to find ACP entries covering swizzle_chan[], hoping they're
     * the same source variable.
     */
-   foreach_in_list(acp_entry, entry, this->acp) {
-      if (var == entry->lhs) {
-	 for (int c = 0; c < chans; c++) {
-	    if (entry->write_mask & (1 << swizzle_chan[c])) {
-	       source[c] = entry->rhs;
-	       source_chan[c] = entry->swizzle[swizzle_chan[c]];
-
-               if (source_chan[c] != swizzle_chan[c])
-                  noop_swizzle = false;
-	    }
-	 }
-      }
+   const acp_entry *entry = this->acp->find(var);
+   if (!entry)
+      return;
+
+   for (int c = 0; c < chans; c++) {
+      source[c] = entry->rhs[swizzle_chan[c]];
+      source_chan[c] = entry->swizzle[swizzle_chan[c]];
+
+      if (source_chan[c] != swizzle_chan[c])
+         noop_swizzle = false;
    }
 
    /* Make sure all channels are copying from the same source variable. */
@@ -327,39 +507,30 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_call *ir)
 void
 ir_copy_propagation_elements_visitor::handle_if_block(exec_list *instructions)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   /* The initial acp is the one of the parent block */
+   acp_undo *mark = this->acp->open_scope();
+   struct hash_table *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->kills = create_kills();
    this->killed_all = false;
 
-   /* Populate the initial acp with a copy of the original */
-   foreach_in_list(acp_entry, a, orig_acp) {
-      this->acp->push_tail(new(this->acp) acp_entry(a));
-   }
-
    visit_list_elements(this, instructions);
 
+   this->acp->close_scope(mark);
+
    if (this->killed_all) {
-      orig_acp->make_empty();
+      this->acp->make_empty();
    }
 
-   exec_list *new_kills = this->kills;
+   struct hash_table *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
-   this->acp = orig_acp;
    this->killed_all = this->killed_all || orig_killed_all;
 
    /* Move the new kills into the parent block's list, removing them
     * from the parent's ACP list in the process.
     */
-   foreach_in_list_safe(kill_entry, k, new_kills) {
-      kill(k);
-   }
-
-   ralloc_free(new_kills);
+   merge_kills(new_kills);
 }
 
 ir_visitor_status
@@ -377,35 +548,31 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_if *ir)
 ir_visitor_status
 ir_copy_propagation_elements_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   acp_undo *mark = this->acp->open_scope();
+   struct hash_table *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->acp->make_empty();
+   this->kills = create_kills();
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body_instructions);
 
+   this->acp->close_scope(mark);
+
    if (this->killed_all) {
-      orig_acp->make_empty();
+      this->acp->make_empty();
    }
 
-   exec_list *new_kills = this->kills;
+   struct hash_table *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
-   this->acp = orig_acp;
    this->killed_all = this->killed_all || orig_killed_all;
 
-   foreach_in_list_safe(kill_entry, k, new_kills) {
-      kill(k);
-   }
-
-   ralloc_free(new_kills);
+   merge_kills(new_kills);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
@@ -413,27 +580,33 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_loop *ir)
 
 /* Remove any entries currently in the ACP for this kill. */
 void
-ir_copy_propagation_elements_visitor::kill(kill_entry *k)
+ir_copy_propagation_elements_visitor::kill(ir_variable *var,
+                                           unsigned write_mask)
 {
-   foreach_in_list_safe(acp_entry, entry, acp) {
-      if (entry->lhs == k->var) {
-	 entry->write_mask = entry->write_mask & ~k->write_mask;
-	 if (entry->write_mask == 0) {
-	    entry->remove();
-	    continue;
-	 }
-      }
-      if (entry->rhs == k->var) {
-	 entry->remove();
-      }
+   this->acp->kill(var, write_mask);
+
+   struct hash_entry *entry = _mesa_hash_table_search(this->kills, var);
+   if (entry) {
+      entry->data = (void *) ((uintptr_t) entry->data | write_mask);
+   } else {
+      _mesa_hash_table_insert(this->kills, var,
+                              (void *) (uintptr_t) write_mask);
    }
+}
 
-   /* If we were on a list, remove ourselves before inserting */
-   if (k->next)
-      k->remove();
+/**
+ * Applies the kills of a child block to the current one, and frees them.
+ */
+void
+ir_copy_propagation_elements_visitor::merge_kills(struct hash_table *new_kills)
+{
+   struct hash_entry *entry;
 
-   ralloc_steal(this->kills, k);
-   this->kills->push_tail(k);
+   hash_table_foreach(new_kills, entry) {
+      kill((ir_variable *) entry->key, (uintptr_t) entry->data);
+   }
+
+   _mesa_hash_table_destroy(new_kills, NULL);
 }
 
 /**
@@ -443,7 +616,6 @@ ir_copy_propagation_elements_visitor::kill(kill_entry *k)
 void
 ir_copy_propagation_elements_visitor::add_copy(ir_assignment *ir)
 {
-   acp_entry *entry;
    int orig_swizzle[4] = {0, 1, 2, 3};
    int swizzle[4];
 
@@ -496,9 +668,8 @@ ir_copy_propagation_elements_visitor::add_copy(ir_assignment *ir)
    if (lhs->var->data.precise != rhs->var->data.precise)
       return;
 
-   entry = new(this->mem_ctx) acp_entry(lhs->var, rhs->var, write_mask,
-					swizzle);
-   this->acp->push_tail(entry);
+   if (write_mask)
+      this->acp->add(lhs->var, rhs->var, write_mask, swizzle);
 }
 
 bool
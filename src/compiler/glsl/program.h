@@ -33,7 +33,8 @@ struct gl_shader_program;
 
 extern void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
-			  bool dump_ast, bool dump_hir);
+			  bool dump_ast, bool dump_hir,
+			  bool force_recompile);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,794 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file shader_cache.cpp
+ *
+ * GLSL shader cache implementation
+ *
+ * This uses the generic cache in util/disk_cache.c.  Two kinds of entries
+ * are stored:
+ *
+ *   o For every successfully compiled shader, only its key is recorded
+ *     (see disk_cache_put_key()).  A later compile of a shader whose key is
+ *     known is skipped, on the assumption that the linked program will be
+ *     found in the cache as well.
+ *
+ *   o For every successfully linked program, all the state the GL API needs
+ *     after linking (uniforms, the uniform remap table, the program resource
+ *     list, ...) is serialized, followed by a driver-specific blob for each
+ *     linked stage produced by ctx->Driver.ShaderCacheSerializeDriverBlob.
+ *
+ * If a program is not found, or cannot be restored, any skipped shaders are
+ * compiled for real and the program is linked from source as usual.
+ *
+ * Only a subset of programs is supported: those using uniform blocks,
+ * shader storage blocks, atomic counters, images, subroutines or transform
+ * feedback are never stored and always linked from source.
+ */
+
+#include "main/core.h"
+#include "main/shaderapi.h"
+#include "main/shaderobj.h"
+#include "compiler/glsl_types.h"
+#include "blob.h"
+#include "ir_uniform.h"
+#include "program/hash_table.h"
+#include "program/program.h"
+#include "shader_cache.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+
+static bool
+encode_type_to_blob(struct blob *blob, const glsl_type *type)
+{
+   blob_write_uint32(blob, type->base_type);
+
+   switch (type->base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL:
+      blob_write_uint32(blob, type->vector_elements);
+      blob_write_uint32(blob, type->matrix_columns);
+      return true;
+   case GLSL_TYPE_SAMPLER:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_shadow);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampled_type);
+      return true;
+   case GLSL_TYPE_ARRAY:
+      blob_write_uint32(blob, type->length);
+      return encode_type_to_blob(blob, type->fields.array);
+   default:
+      /* Records, interfaces, images, atomic counters and subroutines are
+       * not supported by the cache.
+       */
+      return false;
+   }
+}
+
+static const glsl_type *
+decode_type_from_blob(struct blob_reader *blob)
+{
+   const glsl_type *type;
+   glsl_base_type base_type = (glsl_base_type) blob_read_uint32(blob);
+
+   switch (base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL: {
+      unsigned rows = blob_read_uint32(blob);
+      unsigned columns = blob_read_uint32(blob);
+      type = glsl_type::get_instance(base_type, rows, columns);
+      break;
+   }
+   case GLSL_TYPE_SAMPLER: {
+      glsl_sampler_dim dim = (glsl_sampler_dim) blob_read_uint32(blob);
+      bool shadow = blob_read_uint32(blob);
+      bool array = blob_read_uint32(blob);
+      glsl_base_type sampled_type = (glsl_base_type) blob_read_uint32(blob);
+      type = glsl_type::get_sampler_instance(dim, shadow, array, sampled_type);
+      break;
+   }
+   case GLSL_TYPE_ARRAY: {
+      unsigned length = blob_read_uint32(blob);
+      const glsl_type *element = decode_type_from_blob(blob);
+      if (element == NULL)
+         return NULL;
+      type = glsl_type::get_array_instance(element, length);
+      break;
+   }
+   default:
+      return NULL;
+   }
+
+   return (type == NULL || type->is_error()) ? NULL : type;
+}
+
+/**
+ * Number of gl_constant_value slots backing a uniform's storage.
+ */
+static unsigned
+uniform_data_slots(const struct gl_uniform_storage *uni)
+{
+   return uni->type->component_slots() * MAX2(1, uni->array_elements);
+}
+
+static bool
+write_uniforms(struct blob *metadata, struct gl_shader_program *prog)
+{
+   blob_write_uint32(metadata, prog->NumUniformStorage);
+   blob_write_uint32(metadata, prog->NumHiddenUniforms);
+
+   for (unsigned i = 0; i < prog->NumUniformStorage; i++) {
+      const struct gl_uniform_storage *uni = &prog->UniformStorage[i];
+
+      if (uni->block_index != -1 || uni->atomic_buffer_index != -1 ||
+          uni->is_shader_storage || uni->num_compatible_subroutines)
+         return false;
+
+      if (!encode_type_to_blob(metadata, uni->type))
+         return false;
+
+      blob_write_string(metadata, uni->name);
+      blob_write_uint32(metadata, uni->array_elements);
+      blob_write_bytes(metadata, uni->opaque, sizeof(uni->opaque));
+      blob_write_uint32(metadata, uni->remap_location);
+      blob_write_uint32(metadata, uni->hidden);
+      blob_write_uint32(metadata, uni->builtin);
+      blob_write_uint32(metadata, uni->top_level_array_size);
+      blob_write_uint32(metadata, uni->top_level_array_stride);
+
+      /* The current values are the initializers, since the program has only
+       * just been linked.
+       */
+      blob_write_uint32(metadata, uni->storage != NULL);
+      if (uni->storage) {
+         blob_write_bytes(metadata, uni->storage,
+                          sizeof(union gl_constant_value) *
+                          uniform_data_slots(uni));
+      }
+   }
+
+   return true;
+}
+
+static bool
+read_uniforms(struct blob_reader *metadata, struct gl_shader_program *prog)
+{
+   prog->NumUniformStorage = blob_read_uint32(metadata);
+   prog->NumHiddenUniforms = blob_read_uint32(metadata);
+   if (metadata->overrun)
+      return false;
+
+   if (prog->NumUniformStorage == 0)
+      return true;
+
+   prog->UniformStorage = rzalloc_array(prog, struct gl_uniform_storage,
+                                        prog->NumUniformStorage);
+   if (prog->UniformStorage == NULL) {
+      prog->NumUniformStorage = 0;
+      return false;
+   }
+
+   for (unsigned i = 0; i < prog->NumUniformStorage; i++) {
+      struct gl_uniform_storage *uni = &prog->UniformStorage[i];
+
+      uni->type = decode_type_from_blob(metadata);
+      if (uni->type == NULL)
+         return false;
+
+      const char *name = blob_read_string(metadata);
+      if (name == NULL)
+         return false;
+
+      uni->name = ralloc_strdup(prog->UniformStorage, name);
+      uni->array_elements = blob_read_uint32(metadata);
+      blob_copy_bytes(metadata, (uint8_t *) uni->opaque, sizeof(uni->opaque));
+      uni->remap_location = blob_read_uint32(metadata);
+      uni->hidden = blob_read_uint32(metadata);
+      uni->builtin = blob_read_uint32(metadata);
+      uni->top_level_array_size = blob_read_uint32(metadata);
+      uni->top_level_array_stride = blob_read_uint32(metadata);
+
+      uni->block_index = -1;
+      uni->offset = -1;
+      uni->array_stride = -1;
+      uni->matrix_stride = -1;
+      uni->atomic_buffer_index = -1;
+
+      if (blob_read_uint32(metadata)) {
+         const unsigned slots = uniform_data_slots(uni);
+
+         uni->storage = rzalloc_array(prog->UniformStorage,
+                                      union gl_constant_value, slots);
+         if (uni->storage == NULL)
+            return false;
+
+         blob_copy_bytes(metadata, (uint8_t *) uni->storage,
+                         sizeof(union gl_constant_value) * slots);
+      }
+
+      if (metadata->overrun)
+         return false;
+   }
+
+   return true;
+}
+
+enum uniform_remap_type
+{
+   remap_type_inactive_explicit_location,
+   remap_type_null_ptr,
+   remap_type_uniform_offset
+};
+
+static void
+write_uniform_remap_table(struct blob *metadata,
+                          struct gl_shader_program *prog)
+{
+   blob_write_uint32(metadata, prog->NumUniformRemapTable);
+
+   for (unsigned i = 0; i < prog->NumUniformRemapTable; i++) {
+      struct gl_uniform_storage *entry = prog->UniformRemapTable[i];
+
+      if (entry == INACTIVE_UNIFORM_EXPLICIT_LOCATION) {
+         blob_write_uint32(metadata, remap_type_inactive_explicit_location);
+      } else if (entry == NULL) {
+         blob_write_uint32(metadata, remap_type_null_ptr);
+      } else {
+         blob_write_uint32(metadata, remap_type_uniform_offset);
+         blob_write_uint32(metadata, entry - prog->UniformStorage);
+      }
+   }
+}
+
+static bool
+read_uniform_remap_table(struct blob_reader *metadata,
+                         struct gl_shader_program *prog)
+{
+   prog->NumUniformRemapTable = blob_read_uint32(metadata);
+   if (metadata->overrun)
+      return false;
+
+   if (prog->NumUniformRemapTable == 0)
+      return true;
+
+   prog->UniformRemapTable = rzalloc_array(prog, struct gl_uniform_storage *,
+                                           prog->NumUniformRemapTable);
+   if (prog->UniformRemapTable == NULL) {
+      prog->NumUniformRemapTable = 0;
+      return false;
+   }
+
+   for (unsigned i = 0; i < prog->NumUniformRemapTable; i++) {
+      switch (blob_read_uint32(metadata)) {
+      case remap_type_inactive_explicit_location:
+         prog->UniformRemapTable[i] = INACTIVE_UNIFORM_EXPLICIT_LOCATION;
+         break;
+      case remap_type_null_ptr:
+         prog->UniformRemapTable[i] = NULL;
+         break;
+      case remap_type_uniform_offset: {
+         unsigned index = blob_read_uint32(metadata);
+         if (index >= prog->NumUniformStorage)
+            return false;
+         prog->UniformRemapTable[i] = &prog->UniformStorage[index];
+         break;
+      }
+      default:
+         return false;
+      }
+   }
+
+   return !metadata->overrun;
+}
+
+struct hash_table_write_closure {
+   struct blob *blob;
+   unsigned count;
+};
+
+static void
+count_hash_table_entry(const char *key, unsigned value, void *closure)
+{
+   struct hash_table_write_closure *c =
+      (struct hash_table_write_closure *) closure;
+
+   c->count++;
+}
+
+static void
+write_hash_table_entry(const char *key, unsigned value, void *closure)
+{
+   struct hash_table_write_closure *c =
+      (struct hash_table_write_closure *) closure;
+
+   blob_write_string(c->blob, key);
+   blob_write_uint32(c->blob, value);
+}
+
+static void
+write_uniform_hash(struct blob *metadata, struct string_to_uint_map *hash)
+{
+   struct hash_table_write_closure c = { metadata, 0 };
+
+   if (hash == NULL) {
+      blob_write_uint32(metadata, 0);
+      return;
+   }
+
+   hash->iterate(count_hash_table_entry, &c);
+   blob_write_uint32(metadata, c.count);
+   hash->iterate(write_hash_table_entry, &c);
+}
+
+static bool
+read_uniform_hash(struct blob_reader *metadata,
+                  struct gl_shader_program *prog)
+{
+   const unsigned count = blob_read_uint32(metadata);
+
+   prog->UniformHash = new string_to_uint_map;
+
+   for (unsigned i = 0; i < count; i++) {
+      const char *key = blob_read_string(metadata);
+      unsigned value = blob_read_uint32(metadata);
+
+      if (key == NULL || metadata->overrun)
+         return false;
+
+      prog->UniformHash->put(value, key);
+   }
+
+   return !metadata->overrun;
+}
+
+static bool
+write_program_resource_list(struct blob *metadata,
+                            struct gl_shader_program *prog)
+{
+   blob_write_uint32(metadata, prog->NumProgramResourceList);
+
+   for (unsigned i = 0; i < prog->NumProgramResourceList; i++) {
+      const struct gl_program_resource *res = &prog->ProgramResourceList[i];
+
+      blob_write_uint32(metadata, res->Type);
+      blob_write_uint32(metadata, res->StageReferences);
+
+      switch (res->Type) {
+      case GL_UNIFORM: {
+         const struct gl_uniform_storage *uni =
+            (const struct gl_uniform_storage *) res->Data;
+         blob_write_uint32(metadata, uni - prog->UniformStorage);
+         break;
+      }
+      case GL_PROGRAM_INPUT:
+      case GL_PROGRAM_OUTPUT: {
+         const struct gl_shader_variable *var =
+            (const struct gl_shader_variable *) res->Data;
+
+         if (!encode_type_to_blob(metadata, var->type))
+            return false;
+
+         blob_write_string(metadata, var->name);
+         blob_write_uint32(metadata, var->location);
+         blob_write_uint32(metadata, var->component);
+         blob_write_uint32(metadata, var->index);
+         blob_write_uint32(metadata, var->patch);
+         blob_write_uint32(metadata, var->mode);
+         break;
+      }
+      default:
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static bool
+read_program_resource_list(struct blob_reader *metadata,
+                           struct gl_shader_program *prog)
+{
+   prog->NumProgramResourceList = blob_read_uint32(metadata);
+   if (metadata->overrun)
+      return false;
+
+   if (prog->NumProgramResourceList == 0)
+      return true;
+
+   prog->ProgramResourceList =
+      ralloc_array(prog, struct gl_program_resource,
+                   prog->NumProgramResourceList);
+   if (prog->ProgramResourceList == NULL) {
+      prog->NumProgramResourceList = 0;
+      return false;
+   }
+
+   for (unsigned i = 0; i < prog->NumProgramResourceList; i++) {
+      struct gl_program_resource *res = &prog->ProgramResourceList[i];
+
+      res->Type = blob_read_uint32(metadata);
+      res->StageReferences = blob_read_uint32(metadata);
+
+      switch (res->Type) {
+      case GL_UNIFORM: {
+         unsigned index = blob_read_uint32(metadata);
+         if (index >= prog->NumUniformStorage)
+            return false;
+         res->Data = &prog->UniformStorage[index];
+         break;
+      }
+      case GL_PROGRAM_INPUT:
+      case GL_PROGRAM_OUTPUT: {
+         struct gl_shader_variable *var =
+            rzalloc(prog, struct gl_shader_variable);
+         if (var == NULL)
+            return false;
+
+         var->type = decode_type_from_blob(metadata);
+         if (var->type == NULL)
+            return false;
+
+         const char *name = blob_read_string(metadata);
+         if (name == NULL)
+            return false;
+
+         var->name = ralloc_strdup(prog, name);
+         var->location = blob_read_uint32(metadata);
+         var->component = blob_read_uint32(metadata);
+         var->index = blob_read_uint32(metadata);
+         var->patch = blob_read_uint32(metadata);
+         var->mode = blob_read_uint32(metadata);
+         res->Data = var;
+         break;
+      }
+      default:
+         return false;
+      }
+   }
+
+   return !metadata->overrun;
+}
+
+static void
+write_linked_shader(struct blob *metadata, struct gl_shader *sh)
+{
+   blob_write_uint32(metadata, sh->Type);
+   blob_write_uint32(metadata, sh->Version);
+   blob_write_uint32(metadata, sh->IsES);
+   blob_write_uint32(metadata, sh->num_samplers);
+   blob_write_uint32(metadata, sh->active_samplers);
+   blob_write_uint32(metadata, sh->shadow_samplers);
+   blob_write_bytes(metadata, sh->SamplerUnits, sizeof(sh->SamplerUnits));
+   blob_write_bytes(metadata, sh->SamplerTargets, sizeof(sh->SamplerTargets));
+   blob_write_uint32(metadata, sh->num_uniform_components);
+   blob_write_uint32(metadata, sh->num_combined_uniform_components);
+   blob_write_uint32(metadata, sh->origin_upper_left);
+   blob_write_uint32(metadata, sh->pixel_center_integer);
+   blob_write_uint32(metadata, sh->EarlyFragmentTests);
+}
+
+static struct gl_shader *
+read_linked_shader(struct gl_context *ctx, struct blob_reader *metadata,
+                   gl_shader_stage stage)
+{
+   GLenum type = blob_read_uint32(metadata);
+   if (metadata->overrun || _mesa_shader_enum_to_shader_stage(type) != stage)
+      return NULL;
+
+   struct gl_shader *sh = ctx->Driver.NewShader(NULL, 0, type);
+   if (sh == NULL)
+      return NULL;
+
+   sh->Version = blob_read_uint32(metadata);
+   sh->IsES = blob_read_uint32(metadata);
+   sh->num_samplers = blob_read_uint32(metadata);
+   sh->active_samplers = blob_read_uint32(metadata);
+   sh->shadow_samplers = blob_read_uint32(metadata);
+   blob_copy_bytes(metadata, (uint8_t *) sh->SamplerUnits,
+                   sizeof(sh->SamplerUnits));
+   blob_copy_bytes(metadata, (uint8_t *) sh->SamplerTargets,
+                   sizeof(sh->SamplerTargets));
+   sh->num_uniform_components = blob_read_uint32(metadata);
+   sh->num_combined_uniform_components = blob_read_uint32(metadata);
+   sh->origin_upper_left = blob_read_uint32(metadata);
+   sh->pixel_center_integer = blob_read_uint32(metadata);
+   sh->EarlyFragmentTests = blob_read_uint32(metadata);
+
+   return sh;
+}
+
+/**
+ * Whether everything the GL API needs from a linked \p prog can be
+ * expressed by the cache format.
+ */
+static bool
+program_is_cacheable(struct gl_shader_program *prog)
+{
+   if (prog->NumUniformBlocks || prog->NumShaderStorageBlocks ||
+       prog->NumAtomicBuffers || prog->LinkedTransformFeedback.NumOutputs ||
+       prog->TransformFeedback.NumVarying)
+      return false;
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      struct gl_shader *sh = prog->_LinkedShaders[i];
+
+      if (sh == NULL)
+         continue;
+
+      if (sh->Program == NULL || sh->NumImages ||
+          sh->NumSubroutineUniformTypes || sh->NumSubroutineFunctions ||
+          sh->NumSubroutineUniformRemapTable)
+         return false;
+   }
+
+   return true;
+}
+
+static void
+discard_linked_program(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] != NULL)
+         _mesa_delete_shader(ctx, prog->_LinkedShaders[i]);
+
+      prog->_LinkedShaders[i] = NULL;
+   }
+
+   _mesa_clear_shader_program_data(prog);
+}
+
+extern "C" void
+shader_cache_compute_shader_sha1(struct gl_context *ctx,
+                                 struct gl_shader *shader)
+{
+   struct mesa_sha1 *sha1_ctx = _mesa_sha1_init();
+   const uint32_t state[] = {
+      shader->Stage,
+      ctx->API,
+      ctx->Version,
+      ctx->Const.GLSLVersion,
+      ctx->Const.ForceGLSLVersion,
+   };
+
+   if (sha1_ctx == NULL) {
+      memset(shader->sha1, 0, sizeof(shader->sha1));
+      return;
+   }
+
+   _mesa_sha1_update(sha1_ctx, state, sizeof(state));
+   _mesa_sha1_update(sha1_ctx, shader->Source, strlen(shader->Source));
+   _mesa_sha1_final(sha1_ctx, shader->sha1);
+}
+
+static void
+sha1_update_binding(const char *key, unsigned value, void *closure)
+{
+   struct mesa_sha1 *sha1_ctx = (struct mesa_sha1 *) closure;
+
+   _mesa_sha1_update(sha1_ctx, key, strlen(key) + 1);
+   _mesa_sha1_update(sha1_ctx, &value, sizeof(value));
+}
+
+static void
+sha1_update_bindings(struct mesa_sha1 *sha1_ctx,
+                     struct string_to_uint_map *bindings)
+{
+   const uint32_t marker = 0xffffffff;
+
+   if (bindings)
+      bindings->iterate(sha1_update_binding, sha1_ctx);
+
+   /* Separate consecutive maps so that entries can't move between them. */
+   _mesa_sha1_update(sha1_ctx, &marker, sizeof(marker));
+}
+
+extern "C" void
+shader_cache_compute_program_sha1(struct gl_context *ctx,
+                                  struct gl_shader_program *prog)
+{
+   struct mesa_sha1 *sha1_ctx = _mesa_sha1_init();
+   const uint32_t state[] = {
+      ctx->API,
+      prog->SeparateShader,
+      prog->TransformFeedback.BufferMode,
+      prog->TransformFeedback.NumVarying,
+   };
+
+   if (sha1_ctx == NULL) {
+      memset(prog->sha1, 0, sizeof(prog->sha1));
+      return;
+   }
+
+   _mesa_sha1_update(sha1_ctx, state, sizeof(state));
+
+   for (unsigned i = 0; i < prog->NumShaders; i++) {
+      _mesa_sha1_update(sha1_ctx, prog->Shaders[i]->sha1,
+                        sizeof(prog->Shaders[i]->sha1));
+   }
+
+   sha1_update_bindings(sha1_ctx, prog->AttributeBindings);
+   sha1_update_bindings(sha1_ctx, prog->FragDataBindings);
+   sha1_update_bindings(sha1_ctx, prog->FragDataIndexBindings);
+
+   for (unsigned i = 0; i < prog->TransformFeedback.NumVarying; i++) {
+      const char *name = prog->TransformFeedback.VaryingNames[i];
+      _mesa_sha1_update(sha1_ctx, name, strlen(name) + 1);
+   }
+
+   _mesa_sha1_final(sha1_ctx, prog->sha1);
+}
+
+extern "C" void
+shader_cache_write_program_metadata(struct gl_context *ctx,
+                                    struct gl_shader_program *prog)
+{
+   if (!ctx->Cache || !ctx->Driver.ShaderCacheSerializeDriverBlob)
+      return;
+
+   if (!program_is_cacheable(prog))
+      return;
+
+   struct blob *metadata = blob_create(NULL);
+   if (metadata == NULL)
+      return;
+
+   blob_write_uint32(metadata, prog->Version);
+   blob_write_uint32(metadata, prog->IsES);
+   blob_write_uint32(metadata, prog->ARB_fragment_coord_conventions_enable);
+   blob_write_uint32(metadata, prog->FragDepthLayout);
+   blob_write_uint32(metadata, prog->LastClipDistanceArraySize);
+   blob_write_uint32(metadata, prog->Vert.ClipDistanceArraySize);
+
+   if (!write_uniforms(metadata, prog))
+      goto fail;
+
+   write_uniform_remap_table(metadata, prog);
+   write_uniform_hash(metadata, prog->UniformHash);
+
+   if (!write_program_resource_list(metadata, prog))
+      goto fail;
+
+   uint32_t stages;
+   stages = 0;
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i])
+         stages |= 1 << i;
+   }
+   blob_write_uint32(metadata, stages);
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      struct gl_shader *sh = prog->_LinkedShaders[i];
+
+      if (sh == NULL)
+         continue;
+
+      write_linked_shader(metadata, sh);
+      if (!ctx->Driver.ShaderCacheSerializeDriverBlob(ctx, sh->Program,
+                                                      metadata))
+         goto fail;
+   }
+
+   disk_cache_put(ctx->Cache, prog->sha1, metadata->data, metadata->size);
+
+fail:
+   ralloc_free(metadata);
+}
+
+static bool
+read_program(struct gl_context *ctx, struct gl_shader_program *prog,
+             struct blob_reader *metadata)
+{
+   prog->Version = blob_read_uint32(metadata);
+   prog->IsES = blob_read_uint32(metadata);
+   prog->ARB_fragment_coord_conventions_enable = blob_read_uint32(metadata);
+   prog->FragDepthLayout = (gl_frag_depth_layout) blob_read_uint32(metadata);
+   prog->LastClipDistanceArraySize = blob_read_uint32(metadata);
+   prog->Vert.ClipDistanceArraySize = blob_read_uint32(metadata);
+
+   if (!read_uniforms(metadata, prog) ||
+       !read_uniform_remap_table(metadata, prog) ||
+       !read_uniform_hash(metadata, prog) ||
+       !read_program_resource_list(metadata, prog))
+      return false;
+
+   _mesa_create_program_resource_hash(prog);
+
+   const uint32_t stages = blob_read_uint32(metadata);
+   if (metadata->overrun || stages == 0 ||
+       (stages & ~((1u << MESA_SHADER_STAGES) - 1)))
+      return false;
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (!(stages & (1 << i)))
+         continue;
+
+      const gl_shader_stage stage = (gl_shader_stage) i;
+      struct gl_shader *sh = read_linked_shader(ctx, metadata, stage);
+      if (sh == NULL)
+         return false;
+
+      prog->_LinkedShaders[i] = sh;
+
+      /* The initial reference returned by NewProgram is owned by the linked
+       * shader, just like after a regular link.
+       */
+      sh->Program = ctx->Driver.NewProgram(ctx,
+                                           _mesa_shader_stage_to_program(stage),
+                                           prog->Name);
+      if (sh->Program == NULL)
+         return false;
+
+      if (!ctx->Driver.ShaderCacheDeserializeDriverBlob(ctx, prog,
+                                                        sh->Program,
+                                                        metadata))
+         return false;
+   }
+
+   return !metadata->overrun && metadata->current == metadata->end;
+}
+
+extern "C" bool
+shader_cache_read_program_metadata(struct gl_context *ctx,
+                                   struct gl_shader_program *prog)
+{
+   if (!ctx->Cache || !ctx->Driver.ShaderCacheDeserializeDriverBlob)
+      return false;
+
+   size_t size;
+   uint8_t *buffer = (uint8_t *) disk_cache_get(ctx->Cache, prog->sha1, &size);
+   if (buffer == NULL)
+      return false;
+
+   /* Start from the same state link_shaders() would. */
+   discard_linked_program(ctx, prog);
+
+   struct blob_reader metadata;
+   blob_reader_init(&metadata, buffer, size);
+
+   bool restored = read_program(ctx, prog, &metadata);
+   free(buffer);
+
+   if (!restored) {
+      /* A truncated or otherwise unusable entry.  Drop it so the program is
+       * stored again after the regular link.
+       */
+      disk_cache_remove(ctx->Cache, prog->sha1);
+      discard_linked_program(ctx, prog);
+      return false;
+   }
+
+   prog->LinkStatus = true;
+   prog->Validated = false;
+   prog->_Used = false;
+
+   return true;
+}
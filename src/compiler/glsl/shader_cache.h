@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct gl_context;
+struct gl_shader;
+struct gl_shader_program;
+
+/**
+ * Compute the cache key of a shader from its source and the context state
+ * that affects compilation, and store it in \c shader->sha1.
+ */
+void
+shader_cache_compute_shader_sha1(struct gl_context *ctx,
+                                 struct gl_shader *shader);
+
+/**
+ * Compute the cache key of a program from the keys of its attached shaders
+ * and the state that affects linking, and store it in \c prog->sha1.
+ */
+void
+shader_cache_compute_program_sha1(struct gl_context *ctx,
+                                  struct gl_shader_program *prog);
+
+/**
+ * Store the linked program \p prog, including the driver's compiled code,
+ * in \c ctx->Cache under \c prog->sha1.
+ *
+ * Programs using features the cache cannot represent are silently skipped.
+ */
+void
+shader_cache_write_program_metadata(struct gl_context *ctx,
+                                    struct gl_shader_program *prog);
+
+/**
+ * Try to restore the linked program \p prog from \c ctx->Cache.
+ *
+ * \return true if \p prog is fully linked on return.  On false, \p prog
+ * has been reset and must be linked from source.
+ */
+bool
+shader_cache_read_program_metadata(struct gl_context *ctx,
+                                   struct gl_shader_program *prog);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SHADER_CACHE_H */
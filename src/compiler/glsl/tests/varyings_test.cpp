@@ -26,7 +26,7 @@
 #include "main/macros.h"
 #include "util/ralloc.h"
 #include "ir.h"
-#include "program/hash_table.h"
+#include "util/hash_table.h"
 
 /**
  * \file varyings_test.cpp
@@ -92,11 +92,13 @@ link_varyings::SetUp()
    this->mem_ctx = ralloc_context(NULL);
    this->ir.make_empty();
 
-   this->consumer_inputs
-      = hash_table_ctor(0, hash_table_string_hash, hash_table_string_compare);
+   this->consumer_inputs =
+      _mesa_hash_table_create(NULL, _mesa_key_hash_string,
+                              _mesa_key_string_equal);
 
-   this->consumer_interface_inputs
-      = hash_table_ctor(0, hash_table_string_hash, hash_table_string_compare);
+   this->consumer_interface_inputs =
+      _mesa_hash_table_create(NULL, _mesa_key_hash_string,
+                              _mesa_key_string_equal);
 }
 
 void
@@ -105,23 +107,21 @@ link_varyings::TearDown()
    ralloc_free(this->mem_ctx);
    this->mem_ctx = NULL;
 
-   hash_table_dtor(this->consumer_inputs);
+   _mesa_hash_table_destroy(this->consumer_inputs, NULL);
    this->consumer_inputs = NULL;
-   hash_table_dtor(this->consumer_interface_inputs);
+   _mesa_hash_table_destroy(this->consumer_interface_inputs, NULL);
    this->consumer_interface_inputs = NULL;
 }
 
 /**
- * Hash table callback function that counts the elements in the table
- *
- * \sa num_elements
+ * Helper function to look up the data stored for a key in a hash table.
  */
-static void
-ht_count_callback(const void *, void *, void *closure)
+static void *
+find_data(hash_table *ht, const char *key)
 {
-   unsigned int *counter = (unsigned int *) closure;
+   hash_entry *entry = _mesa_hash_table_search(ht, key);
 
-   (*counter)++;
+   return entry ? entry->data : NULL;
 }
 
 /**
@@ -130,11 +130,7 @@ ht_count_callback(const void *, void *, void *closure)
 static unsigned
 num_elements(hash_table *ht)
 {
-   unsigned int counter = 0;
-
-   hash_table_call_foreach(ht, ht_count_callback, (void *) &counter);
-
-   return counter;
+   return ht->entries;
 }
 
 /**
@@ -162,7 +158,7 @@ TEST_F(link_varyings, single_simple_input)
                                         consumer_interface_inputs,
                                         junk);
 
-   EXPECT_EQ((void *) v, hash_table_find(consumer_inputs, "a"));
+   EXPECT_EQ((void *) v, find_data(consumer_inputs, "a"));
    EXPECT_EQ(1u, num_elements(consumer_inputs));
    EXPECT_TRUE(is_empty(consumer_interface_inputs));
 }
@@ -212,7 +208,7 @@ TEST_F(link_varyings, single_interface_input)
                                         junk);
    char *const full_name = interface_field_name(simple_interface);
 
-   EXPECT_EQ((void *) v, hash_table_find(consumer_interface_inputs, full_name));
+   EXPECT_EQ((void *) v, find_data(consumer_interface_inputs, full_name));
    EXPECT_EQ(1u, num_elements(consumer_interface_inputs));
    EXPECT_TRUE(is_empty(consumer_inputs));
 }
@@ -244,11 +240,11 @@ TEST_F(link_varyings, one_interface_and_one_simple_input)
 
    char *const iface_field_name = interface_field_name(simple_interface);
 
-   EXPECT_EQ((void *) iface, hash_table_find(consumer_interface_inputs,
-                                             iface_field_name));
+   EXPECT_EQ((void *) iface, find_data(consumer_interface_inputs,
+                                       iface_field_name));
    EXPECT_EQ(1u, num_elements(consumer_interface_inputs));
 
-   EXPECT_EQ((void *) v, hash_table_find(consumer_inputs, "a"));
+   EXPECT_EQ((void *) v, find_data(consumer_inputs, "a"));
    EXPECT_EQ(1u, num_elements(consumer_inputs));
 }
 
@@ -26,10 +26,10 @@
 #include "compiler/glsl/glsl_parser_extras.h"
 #include "glsl_types.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 
 mtx_t glsl_type::mutex = _MTX_INITIALIZER_NP;
-hash_table *glsl_type::array_types = NULL;
 hash_table *glsl_type::record_types = NULL;
 hash_table *glsl_type::interface_types = NULL;
 hash_table *glsl_type::function_types = NULL;
@@ -53,7 +53,7 @@ glsl_type::glsl_type(GLenum gl_type,
    sampler_dimensionality(0), sampler_shadow(0), sampler_array(0),
    sampled_type(0), interface_packing(0),
    vector_elements(vector_elements), matrix_columns(matrix_columns),
-   length(0)
+   length(0), array_instances(NULL), next_array_instance(NULL)
 {
    mtx_lock(&glsl_type::mutex);
 
@@ -76,7 +76,7 @@ glsl_type::glsl_type(GLenum gl_type, glsl_base_type base_type,
    base_type(base_type),
    sampler_dimensionality(dim), sampler_shadow(shadow),
    sampler_array(array), sampled_type(type), interface_packing(0),
-   length(0)
+   length(0), array_instances(NULL), next_array_instance(NULL)
 {
    mtx_lock(&glsl_type::mutex);
 
@@ -103,7 +103,7 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
    sampler_dimensionality(0), sampler_shadow(0), sampler_array(0),
    sampled_type(0), interface_packing(0),
    vector_elements(0), matrix_columns(0),
-   length(num_fields)
+   length(num_fields), array_instances(NULL), next_array_instance(NULL)
 {
    unsigned int i;
 
@@ -148,7 +148,7 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
    sampler_dimensionality(0), sampler_shadow(0), sampler_array(0),
    sampled_type(0), interface_packing((unsigned) packing),
    vector_elements(0), matrix_columns(0),
-   length(num_fields)
+   length(num_fields), array_instances(NULL), next_array_instance(NULL)
 {
    unsigned int i;
 
@@ -192,7 +192,7 @@ glsl_type::glsl_type(const glsl_type *return_type,
    sampler_dimensionality(0), sampler_shadow(0), sampler_array(0),
    sampled_type(0), interface_packing(0),
    vector_elements(0), matrix_columns(0),
-   length(num_params)
+   length(num_params), array_instances(NULL), next_array_instance(NULL)
 {
    unsigned int i;
 
@@ -224,7 +224,7 @@ glsl_type::glsl_type(const char *subroutine_name) :
    sampler_dimensionality(0), sampler_shadow(0), sampler_array(0),
    sampled_type(0), interface_packing(0),
    vector_elements(1), matrix_columns(1),
-   length(0)
+   length(0), array_instances(NULL), next_array_instance(NULL)
 {
    mtx_lock(&glsl_type::mutex);
 
@@ -418,11 +418,6 @@ _mesa_glsl_release_types(void)
     * object, or if process terminates), so no mutex-locking should be
     * necessary.
     */
-   if (glsl_type::array_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::array_types, NULL);
-      glsl_type::array_types = NULL;
-   }
-
    if (glsl_type::record_types != NULL) {
       _mesa_hash_table_destroy(glsl_type::record_types, NULL);
       glsl_type::record_types = NULL;
@@ -440,7 +435,8 @@ glsl_type::glsl_type(const glsl_type *array, unsigned length) :
    sampler_dimensionality(0), sampler_shadow(0), sampler_array(0),
    sampled_type(0), interface_packing(0),
    vector_elements(0), matrix_columns(0),
-   length(length), name(NULL)
+   length(length), name(NULL),
+   array_instances(NULL), next_array_instance(NULL)
 {
    this->fields.array = array;
    /* Inherit the gl type of the base. The GL type is used for
@@ -816,42 +812,58 @@ glsl_type::get_image_instance(enum glsl_sampler_dim dim,
    unreachable("switch statement above should be complete");
 }
 
+const glsl_type *
+glsl_type::find_array_instance(const glsl_type *base, unsigned array_size)
+{
+   for (const glsl_type *t = p_atomic_read(&base->array_instances);
+        t != NULL; t = t->next_array_instance) {
+      if (t->length == array_size)
+         return t;
+   }
+
+   return NULL;
+}
+
+
 const glsl_type *
 glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 {
-   /* Generate a name using the base type pointer in the key.  This is
-    * done because the name of the base type may not be unique across
-    * shaders.  For example, two shaders may have different record types
-    * named 'foo'.
+   /* Array types are kept in a list hanging off the element type rather
+    * than in a table keyed on the name, because the name of the base type
+    * may not be unique across shaders.  For example, two shaders may have
+    * different record types named 'foo'.
+    *
+    * This is by far the most common type lookup, so finding an existing
+    * type doesn't take the mutex.
     */
-   char key[128];
-   snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
-
-   mtx_lock(&glsl_type::mutex);
+   const glsl_type *t = find_array_instance(base, array_size);
+   if (t != NULL)
+      return t;
 
-   if (array_types == NULL) {
-      array_types = _mesa_hash_table_create(NULL, _mesa_key_hash_string,
-                                            _mesa_key_string_equal);
-   }
+   glsl_type *new_type = new glsl_type(base, array_size);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(array_types, key);
-   if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
-      const glsl_type *t = new glsl_type(base, array_size);
-      mtx_lock(&glsl_type::mutex);
+   mtx_lock(&glsl_type::mutex);
 
-      entry = _mesa_hash_table_insert(array_types,
-                                      ralloc_strdup(mem_ctx, key),
-                                      (void *) t);
+   /* Another thread may have added the type in the meantime, in which
+    * case new_type just stays unused in mem_ctx.
+    */
+   t = find_array_instance(base, array_size);
+   if (t == NULL) {
+      new_type->next_array_instance = base->array_instances;
+      /* Publish the type after it's fully initialized. */
+      (void) p_atomic_cmpxchg(&base->array_instances,
+                              new_type->next_array_instance,
+                              (const glsl_type *) new_type);
+      t = new_type;
    }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_ARRAY);
-   assert(((glsl_type *) entry->data)->length == array_size);
-   assert(((glsl_type *) entry->data)->fields.array == base);
-
    mtx_unlock(&glsl_type::mutex);
 
-   return (glsl_type *) entry->data;
+   assert(t->base_type == GLSL_TYPE_ARRAY);
+   assert(t->length == array_size);
+   assert(t->fields.array == base);
+
+   return t;
 }
 
 
@@ -993,7 +1005,10 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
       const glsl_type *t = new glsl_type(fields, num_fields, name);
       mtx_lock(&glsl_type::mutex);
 
-      entry = _mesa_hash_table_insert(record_types, t, (void *) t);
+      /* Another thread may have added the type in the meantime. */
+      entry = _mesa_hash_table_search(record_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(record_types, t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_STRUCT);
@@ -1029,7 +1044,10 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
                                          packing, block_name);
       mtx_lock(&glsl_type::mutex);
 
-      entry = _mesa_hash_table_insert(interface_types, t, (void *) t);
+      /* Another thread may have added the type in the meantime. */
+      entry = _mesa_hash_table_search(interface_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(interface_types, t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_INTERFACE);
@@ -1060,7 +1078,10 @@ glsl_type::get_subroutine_instance(const char *subroutine_name)
       const glsl_type *t = new glsl_type(subroutine_name);
       mtx_lock(&glsl_type::mutex);
 
-      entry = _mesa_hash_table_insert(subroutine_types, t, (void *) t);
+      /* Another thread may have added the type in the meantime. */
+      entry = _mesa_hash_table_search(subroutine_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(subroutine_types, t, (void *) t);
    }
 
    assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_SUBROUTINE);
@@ -1126,7 +1147,10 @@ glsl_type::get_function_instance(const glsl_type *return_type,
       const glsl_type *t = new glsl_type(return_type, params, num_params);
       mtx_lock(&glsl_type::mutex);
 
-      entry = _mesa_hash_table_insert(function_types, t, (void *) t);
+      /* Another thread may have added the type in the meantime. */
+      entry = _mesa_hash_table_search(function_types, &key);
+      if (entry == NULL)
+         entry = _mesa_hash_table_insert(function_types, t, (void *) t);
    }
 
    const glsl_type *t = (const glsl_type *)entry->data;
@@ -784,8 +784,17 @@ private:
    /** Constructor for subroutine types */
    glsl_type(const char *name);
 
-   /** Hash table containing the known array types. */
-   static struct hash_table *array_types;
+   /**
+    * Array types of this type, linked through \c next_array_instance.
+    *
+    * The list is only ever prepended to, with the mutex held, and types
+    * are never freed, so get_array_instance() walks it without locking.
+    */
+   mutable const glsl_type *array_instances;
+   const glsl_type *next_array_instance;
+
+   static const glsl_type *find_array_instance(const glsl_type *base,
+                                               unsigned array_size);
 
    /** Hash table containing the known record types. */
    static struct hash_table *record_types;
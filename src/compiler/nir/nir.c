@@ -1829,3 +1829,71 @@ nir_system_value_from_intrinsic(nir_intrinsic_op intrin)
       unreachable("intrinsic doesn't produce a system value");
    }
 }
+
+#ifdef DEBUG
+
+#include <time.h>
+#include "c11/threads.h"
+
+#define NIR_MAX_TIMED_PASSES 128
+
+static struct {
+   const char *name;
+   unsigned runs;
+   int64_t ns;
+} nir_pass_times[NIR_MAX_TIMED_PASSES];
+static unsigned nir_num_timed_passes;
+static mtx_t nir_pass_time_mutex = _MTX_INITIALIZER_NP;
+
+static void
+nir_pass_time_report(void)
+{
+   fprintf(stderr, "NIR pass times:\n");
+   for (unsigned i = 0; i < nir_num_timed_passes; i++) {
+      fprintf(stderr, "  %-40s %8u runs %12.3f ms\n",
+              nir_pass_times[i].name, nir_pass_times[i].runs,
+              nir_pass_times[i].ns / 1000000.0);
+   }
+}
+
+int64_t
+nir_pass_time_begin(void)
+{
+#ifdef _WIN32
+   return 0;
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void
+nir_pass_time_end(const char *pass, int64_t start)
+{
+   int64_t ns = nir_pass_time_begin() - start;
+   unsigned i;
+
+   mtx_lock(&nir_pass_time_mutex);
+
+   for (i = 0; i < nir_num_timed_passes; i++) {
+      if (strcmp(nir_pass_times[i].name, pass) == 0)
+         break;
+   }
+
+   if (i == nir_num_timed_passes && i < NIR_MAX_TIMED_PASSES) {
+      if (i == 0)
+         atexit(nir_pass_time_report);
+      nir_pass_times[i].name = pass;
+      nir_num_timed_passes++;
+   }
+
+   if (i < nir_num_timed_passes) {
+      nir_pass_times[i].runs++;
+      nir_pass_times[i].ns += ns;
+   }
+
+   mtx_unlock(&nir_pass_time_mutex);
+}
+
+#endif /* DEBUG */
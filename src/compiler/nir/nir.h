@@ -2254,15 +2254,37 @@ should_clone_nir(void)
 
    return should_clone;
 }
+
+/* NIR_PASS_TIME=1 accumulates the time spent in each pass and prints it to
+ * stderr when the process exits.
+ */
+static inline bool
+should_time_nir(void)
+{
+   static int should_time = -1;
+   if (should_time < 0)
+      should_time = env_var_as_boolean("NIR_PASS_TIME", false);
+
+   return should_time;
+}
+
+int64_t nir_pass_time_begin(void);
+void nir_pass_time_end(const char *pass, int64_t start);
 #else
 static inline void nir_validate_shader(nir_shader *shader) { (void) shader; }
 static inline void nir_metadata_set_validation_flag(nir_shader *shader) { (void) shader; }
 static inline void nir_metadata_check_validation_flag(nir_shader *shader) { (void) shader; }
 static inline bool should_clone_nir(void) { return false; }
+static inline bool should_time_nir(void) { return false; }
+static inline int64_t nir_pass_time_begin(void) { return 0; }
+static inline void nir_pass_time_end(const char *pass, int64_t start) { (void) pass; (void) start; }
 #endif /* DEBUG */
 
-#define _PASS(nir, do_pass) do {                                     \
+#define _PASS(nir, pass_name, do_pass) do {                          \
+   int64_t _pass_start = should_time_nir() ? nir_pass_time_begin() : 0; \
    do_pass                                                           \
+   if (should_time_nir())                                            \
+      nir_pass_time_end(pass_name, _pass_start);                     \
    nir_validate_shader(nir);                                         \
    if (should_clone_nir()) {                                         \
       nir_shader *clone = nir_shader_clone(ralloc_parent(nir), nir); \
@@ -2271,7 +2293,7 @@ static inline bool should_clone_nir(void) { return false; }
    }                                                                 \
 } while (0)
 
-#define NIR_PASS(progress, nir, pass, ...) _PASS(nir,                \
+#define NIR_PASS(progress, nir, pass, ...) _PASS(nir, #pass,         \
    nir_metadata_set_validation_flag(nir);                            \
    if (pass(nir, ##__VA_ARGS__)) {                                   \
       progress = true;                                               \
@@ -2279,10 +2301,87 @@ static inline bool should_clone_nir(void) { return false; }
    }                                                                 \
 )
 
-#define NIR_PASS_V(nir, pass, ...) _PASS(nir,                        \
+#define NIR_PASS_V(nir, pass, ...) _PASS(nir, #pass,                 \
    pass(nir, ##__VA_ARGS__);                                         \
 )
 
+#define NIR_MAX_LOOP_PASSES 32
+
+/**
+ * Remembers which passes of an optimization loop are known to make no
+ * progress, so that the loop doesn't have to rerun all of them whenever one
+ * of them did something.
+ *
+ * The shader gets a new generation each time a pass makes progress.  A pass
+ * which made no progress on some generation won't make any on it either the
+ * next time around, and NIR_LOOP_PASS() skips it until the shader changes.
+ * Passes are told apart by the line they are run from, so the same pass can
+ * be run several times in one loop.  Passes that don't report progress
+ * (NIR_PASS_V) are assumed not to touch the shader past the first iteration,
+ * as with plain do/while loops.
+ */
+typedef struct {
+   unsigned generation;
+   unsigned num_passes;
+   struct {
+      unsigned line;
+      unsigned clean_generation;
+   } passes[NIR_MAX_LOOP_PASSES];
+} nir_pass_tracker;
+
+static inline void
+nir_pass_tracker_init(nir_pass_tracker *tracker)
+{
+   tracker->generation = 1;
+   tracker->num_passes = 0;
+}
+
+/* Returns the slot of the pass run from line, or -1 if the tracker is full. */
+static inline int
+nir_pass_tracker_find(nir_pass_tracker *tracker, unsigned line)
+{
+   for (unsigned i = 0; i < tracker->num_passes; i++) {
+      if (tracker->passes[i].line == line)
+         return i;
+   }
+
+   if (tracker->num_passes == NIR_MAX_LOOP_PASSES)
+      return -1;
+
+   tracker->passes[tracker->num_passes].line = line;
+   tracker->passes[tracker->num_passes].clean_generation = 0;
+   return tracker->num_passes++;
+}
+
+static inline bool
+nir_pass_tracker_should_run(nir_pass_tracker *tracker, unsigned line)
+{
+   int i = nir_pass_tracker_find(tracker, line);
+   return i < 0 || tracker->passes[i].clean_generation != tracker->generation;
+}
+
+static inline void
+nir_pass_tracker_ran(nir_pass_tracker *tracker, unsigned line,
+                     bool progress)
+{
+   int i = nir_pass_tracker_find(tracker, line);
+
+   if (progress)
+      tracker->generation++;
+   else if (i >= 0)
+      tracker->passes[i].clean_generation = tracker->generation;
+}
+
+#define NIR_LOOP_PASS(progress, tracker, nir, pass, ...) do {        \
+   if (nir_pass_tracker_should_run(tracker, __LINE__)) {             \
+      bool _pass_progress = false;                                   \
+      NIR_PASS(_pass_progress, nir, pass, ##__VA_ARGS__);            \
+      nir_pass_tracker_ran(tracker, __LINE__, _pass_progress);       \
+      if (_pass_progress)                                            \
+         progress = true;                                            \
+   }                                                                 \
+} while (0)
+
 void nir_calc_dominance_impl(nir_function_impl *impl);
 void nir_calc_dominance(nir_shader *shader);
 
@@ -490,6 +490,131 @@ class SearchAndReplace(object):
 
       BitSizeValidator(varset).validate(self.search, self.replace)
 
+class Item(object):
+   """An item of the tree automaton.
+
+   An item is a subtree of a search expression, where constants and
+   variables which only match constants are replaced by "__const" and all
+   other variables by "__wildcard".  Identical subtrees share a single item.
+   """
+   def __init__(self, opcode, children, index):
+      self.opcode = opcode
+      self.children = children
+      self.index = index
+
+class TreeAutomaton(object):
+   """A bottom-up tree automaton for the search expressions of a pass.
+
+   Each SSA value is assigned a state, which is the set of items matching
+   the value if we only look at the opcodes of the expression tree.  The
+   state of an ALU instruction only depends on its opcode and the states of
+   its sources, so it is found with a single table lookup per instruction.
+   Only the transforms whose search expression is in the state of an
+   instruction then need to go through the full matching of nir_search.c,
+   however many transforms there are for the opcode.
+
+   State 0 is the state of values we know nothing about, and state 1 the
+   state of load_const instructions.
+
+   In order to keep the tables small, the states of the sources are first
+   mapped to the sets of items which are children of items for the opcode,
+   the "filtered" states of the opcode, and the table for the opcode is
+   indexed by those.
+   """
+   def __init__(self, transforms):
+      self._items = {}
+      self.opcodes = {}
+      self.wildcard = self._get_item("__wildcard", ())
+      self.const = self._get_item("__const", ())
+
+      self.roots = [self._build_item(xform.search) for xform in transforms]
+
+      self._compute_states()
+
+   def _get_item(self, opcode, children):
+      key = (opcode, children)
+      if key not in self._items:
+         self._items[key] = Item(opcode, children, len(self._items))
+         if opcode not in ("__wildcard", "__const"):
+            self.opcodes.setdefault(opcode, []).append(self._items[key])
+      return self._items[key]
+
+   def _build_item(self, val):
+      if isinstance(val, Constant):
+         return self.const
+      elif isinstance(val, Variable):
+         return self.const if val.is_constant else self.wildcard
+      else:
+         children = tuple(self._build_item(src) for src in val.sources)
+         return self._get_item(val.opcode, children)
+
+   @staticmethod
+   def _item_matches(item, src_states, commutative):
+      if all(child in src_states[i] for i, child in enumerate(item.children)):
+         return True
+
+      return (commutative and
+              item.children[0] in src_states[1] and
+              item.children[1] in src_states[0])
+
+   def _compute_states(self):
+      self.states = [frozenset([self.wildcard]),
+                     frozenset([self.wildcard, self.const])]
+      state_index = dict((s, i) for i, s in enumerate(self.states))
+
+      src_items = {}
+      self.filters = {}
+      self.state_filters = {}
+      tables = {}
+      for op, items in self.opcodes.iteritems():
+         src_items[op] = frozenset(child for item in items
+                                         for child in item.children)
+         self.filters[op] = []
+         self.state_filters[op] = []
+         tables[op] = {}
+
+      # Keep on applying the opcodes to the states we have until no new
+      # state shows up.
+      changed = True
+      while changed:
+         changed = False
+         for op in sorted(self.opcodes):
+            nir_op = opcodes[op]
+            commutative = "commutative" in nir_op.algebraic_properties
+            filters = self.filters[op]
+            state_filters = self.state_filters[op]
+
+            for state in self.states[len(state_filters):]:
+               filtered = state & src_items[op]
+               if filtered not in filters:
+                  filters.append(filtered)
+               state_filters.append(filters.index(filtered))
+
+            for srcs in itertools.product(range(len(filters)),
+                                          repeat=nir_op.num_inputs):
+               if srcs in tables[op]:
+                  continue
+
+               src_states = [filters[i] for i in srcs]
+               state = frozenset([self.wildcard] +
+                                 [item for item in self.opcodes[op]
+                                  if self._item_matches(item, src_states,
+                                                        commutative)])
+               if state not in state_index:
+                  state_index[state] = len(self.states)
+                  self.states.append(state)
+                  changed = True
+               tables[op][srcs] = state_index[state]
+
+      assert len(self.states) <= 65536
+
+      # Flatten the tables, the first source being the most significant.
+      self.tables = {}
+      for op in self.opcodes:
+         self.tables[op] = [tables[op][srcs] for srcs in
+                            itertools.product(range(len(self.filters[op])),
+                                              repeat=opcodes[op].num_inputs)]
+
 _algebraic_pass_template = mako.template.Template("""
 #include "nir.h"
 #include "nir_search.h"
@@ -503,24 +628,100 @@ struct transform {
    unsigned condition_offset;
 };
 
+/* The automaton transitions of an opcode, see TreeAutomaton in
+ * nir_algebraic.py.
+ */
+struct per_op_table {
+   const uint16_t *filter;
+   unsigned num_filtered_states;
+   const uint16_t *table;
+};
+
+static uint16_t
+automaton_src_state(const nir_src *src, const uint16_t *states)
+{
+   return src->is_ssa ? states[src->ssa->index] : 0;
+}
+
+/* Computes the automaton state of every SSA value of impl into states,
+ * which is indexed by SSA index and must be zero-filled.
+ */
+static void
+run_automaton(nir_function_impl *impl, const struct per_op_table *tables,
+              uint16_t *states)
+{
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block) {
+         switch (instr->type) {
+         case nir_instr_type_alu: {
+            nir_alu_instr *alu = nir_instr_as_alu(instr);
+            const struct per_op_table *tbl = &tables[alu->op];
+            unsigned index = 0;
+
+            if (!alu->dest.dest.is_ssa || !tbl->filter)
+               break;
+
+            for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+               uint16_t state = automaton_src_state(&alu->src[i].src, states);
+               index = index * tbl->num_filtered_states + tbl->filter[state];
+            }
+            states[alu->dest.dest.ssa.index] = tbl->table[index];
+            break;
+         }
+
+         case nir_instr_type_load_const:
+            states[nir_instr_as_load_const(instr)->def.index] = 1;
+            break;
+
+         default:
+            break;
+         }
+      }
+   }
+}
+
 #endif
 
-% for (opcode, xform_list) in xform_dict.iteritems():
-% for xform in xform_list:
+% for xform in xforms:
    ${xform.search.render()}
    ${xform.replace.render()}
 % endfor
 
-static const struct transform ${pass_name}_${opcode}_xforms[] = {
+% for i, xform_list in enumerate(state_xform_lists):
+static const struct transform ${pass_name}_state_xforms${i}[] = {
 % for xform in xform_list:
    { &${xform.search.name}, ${xform.replace.c_ptr}, ${xform.condition_index} },
 % endfor
 };
+
+% endfor
+% for op in sorted(automaton.opcodes):
+static const uint16_t ${pass_name}_${op}_filter[] = {
+% for i in range(0, len(automaton.state_filters[op]), 16):
+   ${', '.join(str(f) for f in automaton.state_filters[op][i:i + 16])},
+% endfor
+};
+
+static const uint16_t ${pass_name}_${op}_table[] = {
+% for i in range(0, len(automaton.tables[op]), 16):
+   ${', '.join(str(s) for s in automaton.tables[op][i:i + 16])},
+% endfor
+};
+
 % endfor
+static const struct per_op_table ${pass_name}_table[nir_num_opcodes] = {
+% for op in sorted(automaton.opcodes):
+   [nir_op_${op}] = {
+      ${pass_name}_${op}_filter,
+      ${len(automaton.filters[op])},
+      ${pass_name}_${op}_table,
+   },
+% endfor
+};
 
 static bool
 ${pass_name}_block(nir_block *block, const bool *condition_flags,
-                   void *mem_ctx)
+                   const uint16_t *states, void *mem_ctx)
 {
    bool progress = false;
 
@@ -532,11 +733,17 @@ ${pass_name}_block(nir_block *block, const bool *condition_flags,
       if (!alu->dest.dest.is_ssa)
          continue;
 
-      switch (alu->op) {
-      % for opcode in xform_dict.keys():
-      case nir_op_${opcode}:
-         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_${opcode}_xforms); i++) {
-            const struct transform *xform = &${pass_name}_${opcode}_xforms[i];
+      /* Replacements are inserted before the instruction, and only its
+       * uses, which we are done with, are rewritten.  The states of the
+       * instructions left to walk remain valid.
+       */
+      switch (states[alu->dest.dest.ssa.index]) {
+      % for i, state_list in enumerate(state_lists):
+      % for state in state_list:
+      case ${state}:
+      % endfor
+         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_state_xforms${i}); i++) {
+            const struct transform *xform = &${pass_name}_state_xforms${i}[i];
             if (condition_flags[xform->condition_offset] &&
                 nir_replace_instr(alu, xform->search, xform->replace,
                                   mem_ctx)) {
@@ -560,10 +767,18 @@ ${pass_name}_impl(nir_function_impl *impl, const bool *condition_flags)
    void *mem_ctx = ralloc_parent(impl);
    bool progress = false;
 
+   uint16_t *states = calloc(impl->ssa_alloc, sizeof(uint16_t));
+   if (!states)
+      return false;
+
+   run_automaton(impl, ${pass_name}_table, states);
+
    nir_foreach_block_reverse(block, impl) {
-      progress |= ${pass_name}_block(block, condition_flags, mem_ctx);
+      progress |= ${pass_name}_block(block, condition_flags, states, mem_ctx);
    }
 
+   free(states);
+
    if (progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
@@ -595,7 +810,7 @@ ${pass_name}(nir_shader *shader)
 
 class AlgebraicPass(object):
    def __init__(self, pass_name, transforms):
-      self.xform_dict = {}
+      self.xforms = []
       self.pass_name = pass_name
 
       error = False
@@ -612,15 +827,34 @@ class AlgebraicPass(object):
                error = True
                continue
 
-         if xform.search.opcode not in self.xform_dict:
-            self.xform_dict[xform.search.opcode] = []
-
-         self.xform_dict[xform.search.opcode].append(xform)
+         self.xforms.append(xform)
 
       if error:
          sys.exit(1)
 
+      self.automaton = TreeAutomaton(self.xforms)
+
+      # Group the states by the transforms they have to try, which keep the
+      # order they were given in.
+      self.state_xform_lists = []
+      self.state_lists = []
+      for i, state in enumerate(self.automaton.states):
+         xform_list = [xform for xform, root
+                       in zip(self.xforms, self.automaton.roots)
+                       if root in state]
+         if not xform_list:
+            continue
+
+         if xform_list in self.state_xform_lists:
+            self.state_lists[self.state_xform_lists.index(xform_list)].append(i)
+         else:
+            self.state_xform_lists.append(xform_list)
+            self.state_lists.append([i])
+
    def render(self):
       return _algebraic_pass_template.render(pass_name=self.pass_name,
-                                             xform_dict=self.xform_dict,
+                                             xforms=self.xforms,
+                                             automaton=self.automaton,
+                                             state_xform_lists=self.state_xform_lists,
+                                             state_lists=self.state_lists,
                                              condition_list=condition_list)
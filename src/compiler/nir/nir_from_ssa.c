@@ -37,6 +37,9 @@
 struct from_ssa_state {
    void *mem_ctx;
    void *dead_ctx;
+
+   /* Linear context for the merge sets and nodes, out of dead_ctx */
+   void *lin_ctx;
    bool phi_webs_only;
    struct hash_table *merge_node_table;
    nir_instr *instr;
@@ -124,12 +127,12 @@ get_merge_node(nir_ssa_def *def, struct from_ssa_state *state)
    if (entry)
       return entry->data;
 
-   merge_set *set = ralloc(state->dead_ctx, merge_set);
+   merge_set *set = linear_alloc(state->lin_ctx, merge_set);
    exec_list_make_empty(&set->nodes);
    set->size = 1;
    set->reg = NULL;
 
-   merge_node *node = ralloc(state->dead_ctx, merge_node);
+   merge_node *node = linear_alloc(state->lin_ctx, merge_node);
    node->set = set;
    node->def = def;
    exec_list_push_head(&set->nodes, &node->node);
@@ -758,6 +761,7 @@ nir_convert_from_ssa_impl(nir_function_impl *impl, bool phi_webs_only)
 
    state.mem_ctx = ralloc_parent(impl);
    state.dead_ctx = ralloc_context(NULL);
+   state.lin_ctx = linear_context(state.dead_ctx);
    state.impl = impl;
    state.phi_webs_only = phi_webs_only;
    state.merge_node_table = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
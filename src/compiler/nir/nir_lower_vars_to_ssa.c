@@ -58,6 +58,9 @@ struct deref_node {
 struct lower_variables_state {
    nir_shader *shader;
    void *dead_ctx;
+
+   /* Linear context for the deref nodes, out of dead_ctx */
+   void *lin_ctx;
    nir_function_impl *impl;
 
    /* A hash table mapping variables to deref_node data */
@@ -92,12 +95,12 @@ struct lower_variables_state {
 
 static struct deref_node *
 deref_node_create(struct deref_node *parent,
-                  const struct glsl_type *type, nir_shader *shader)
+                  const struct glsl_type *type, void *lin_ctx)
 {
    size_t size = sizeof(struct deref_node) +
                  glsl_get_length(type) * sizeof(struct deref_node *);
 
-   struct deref_node *node = rzalloc_size(shader, size);
+   struct deref_node *node = linear_zalloc_size(lin_ctx, size);
    node->type = type;
    node->parent = parent;
    node->deref = NULL;
@@ -120,7 +123,7 @@ get_deref_node_for_var(nir_variable *var, struct lower_variables_state *state)
    if (var_entry) {
       return var_entry->data;
    } else {
-      node = deref_node_create(NULL, var->type, state->dead_ctx);
+      node = deref_node_create(NULL, var->type, state->lin_ctx);
       _mesa_hash_table_insert(state->deref_var_nodes, var, node);
       return node;
    }
@@ -149,7 +152,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
 
          if (node->children[deref_struct->index] == NULL)
             node->children[deref_struct->index] =
-               deref_node_create(node, tail->type, state->dead_ctx);
+               deref_node_create(node, tail->type, state->lin_ctx);
 
          node = node->children[deref_struct->index];
          break;
@@ -169,7 +172,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
 
             if (node->children[arr->base_offset] == NULL)
                node->children[arr->base_offset] =
-                  deref_node_create(node, tail->type, state->dead_ctx);
+                  deref_node_create(node, tail->type, state->lin_ctx);
 
             node = node->children[arr->base_offset];
             break;
@@ -177,7 +180,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
          case nir_deref_array_type_indirect:
             if (node->indirect == NULL)
                node->indirect = deref_node_create(node, tail->type,
-                                                  state->dead_ctx);
+                                                  state->lin_ctx);
 
             node = node->indirect;
             is_direct = false;
@@ -186,7 +189,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
          case nir_deref_array_type_wildcard:
             if (node->wildcard == NULL)
                node->wildcard = deref_node_create(node, tail->type,
-                                                  state->dead_ctx);
+                                                  state->lin_ctx);
 
             node = node->wildcard;
             is_direct = false;
@@ -643,6 +646,7 @@ nir_lower_vars_to_ssa_impl(nir_function_impl *impl)
 
    state.shader = impl->function->shader;
    state.dead_ctx = ralloc_context(state.shader);
+   state.lin_ctx = linear_context(state.dead_ctx);
    state.impl = impl;
 
    state.deref_var_nodes = _mesa_hash_table_create(state.dead_ctx,
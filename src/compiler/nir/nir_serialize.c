@@ -0,0 +1,1169 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file nir_serialize.c
+ *
+ * Writes a nir_shader to a blob and reads it back, in this process or in
+ * another one, so that shader caches can store NIR after the optimization
+ * loop.
+ *
+ * The layout follows nir_clone.c.  Every object which can be pointed to
+ * (variables, registers, SSA defs, blocks and functions) gets an index in
+ * the order it is written, and pointers are written as these indices.  The
+ * index 0 stands for NULL.  The sources of phis can point forward, their
+ * indices are patched in once the function is written.
+ */
+
+#include "nir_serialize.h"
+#include "nir_control_flow.h"
+
+typedef struct {
+   const nir_phi_src *src;
+
+   /* Offset of the index of the predecessor, the SSA def follows it. */
+   size_t blob_offset;
+} write_phi_fixup;
+
+typedef struct {
+   struct blob *blob;
+
+   /* maps pointer -> index: */
+   struct hash_table *remap_table;
+
+   /* the index of the next object to be written */
+   uintptr_t next_idx;
+
+   /* phi sources of the current function */
+   write_phi_fixup *phi_fixups;
+   unsigned num_phi_fixups;
+   unsigned phi_fixups_size;
+} write_ctx;
+
+typedef struct {
+   nir_shader *nir;
+
+   struct blob_reader *blob;
+
+   /* the index of the next object to be read */
+   uintptr_t next_idx;
+
+   /* maps index -> pointer: */
+   void **idx_table;
+   uintptr_t idx_table_len;
+
+   /* phi sources of the current function, with indices for pointers */
+   struct list_head phi_srcs;
+} read_ctx;
+
+static void
+write_add_object(write_ctx *ctx, const void *obj)
+{
+   _mesa_hash_table_insert(ctx->remap_table, obj, (void *) ctx->next_idx++);
+}
+
+static uintptr_t
+write_lookup_object(write_ctx *ctx, const void *obj)
+{
+   struct hash_entry *entry;
+
+   if (!obj)
+      return 0;
+
+   entry = _mesa_hash_table_search(ctx->remap_table, obj);
+   assert(entry && "Failed to find pointer!");
+   return entry ? (uintptr_t) entry->data : 0;
+}
+
+static void
+write_object(write_ctx *ctx, const void *obj)
+{
+   blob_write_uint32(ctx->blob, write_lookup_object(ctx, obj));
+}
+
+static void
+read_add_object(read_ctx *ctx, void *obj)
+{
+   assert(ctx->next_idx < ctx->idx_table_len);
+   ctx->idx_table[ctx->next_idx++] = obj;
+}
+
+static void *
+read_lookup_object(read_ctx *ctx, uintptr_t idx)
+{
+   assert(idx < ctx->next_idx);
+   return idx < ctx->next_idx ? ctx->idx_table[idx] : NULL;
+}
+
+static void *
+read_object(read_ctx *ctx)
+{
+   return read_lookup_object(ctx, blob_read_uint32(ctx->blob));
+}
+
+static void
+write_string(write_ctx *ctx, const char *str)
+{
+   blob_write_uint32(ctx->blob, str != NULL);
+   if (str)
+      blob_write_string(ctx->blob, str);
+}
+
+/* Returns a copy of the string in mem_ctx. */
+static char *
+read_string(read_ctx *ctx, void *mem_ctx)
+{
+   if (!blob_read_uint32(ctx->blob))
+      return NULL;
+
+   return ralloc_strdup(mem_ctx, blob_read_string(ctx->blob));
+}
+
+static void
+write_constant(write_ctx *ctx, const nir_constant *c)
+{
+   blob_write_bytes(ctx->blob, &c->value, sizeof(c->value));
+   blob_write_uint32(ctx->blob, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++)
+      write_constant(ctx, c->elements[i]);
+}
+
+static nir_constant *
+read_constant(read_ctx *ctx, nir_variable *nvar)
+{
+   nir_constant *c = ralloc(nvar, nir_constant);
+
+   blob_copy_bytes(ctx->blob, (uint8_t *) &c->value, sizeof(c->value));
+   c->num_elements = blob_read_uint32(ctx->blob);
+   c->elements = ralloc_array(nvar, nir_constant *, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++)
+      c->elements[i] = read_constant(ctx, nvar);
+
+   return c;
+}
+
+static void
+write_variable(write_ctx *ctx, const nir_variable *var)
+{
+   write_add_object(ctx, var);
+   glsl_encode_type(ctx->blob, var->type);
+   write_string(ctx, var->name);
+   blob_write_bytes(ctx->blob, &var->data, sizeof(var->data));
+   blob_write_uint32(ctx->blob, var->num_state_slots);
+   blob_write_bytes(ctx->blob, var->state_slots,
+                    var->num_state_slots * sizeof(nir_state_slot));
+   blob_write_uint32(ctx->blob, var->constant_initializer != NULL);
+   if (var->constant_initializer)
+      write_constant(ctx, var->constant_initializer);
+   blob_write_uint32(ctx->blob, var->interface_type != NULL);
+   if (var->interface_type)
+      glsl_encode_type(ctx->blob, var->interface_type);
+}
+
+static nir_variable *
+read_variable(read_ctx *ctx)
+{
+   nir_variable *var = rzalloc(ctx->nir, nir_variable);
+   read_add_object(ctx, var);
+
+   var->type = glsl_decode_type(ctx->blob);
+   var->name = read_string(ctx, var);
+   blob_copy_bytes(ctx->blob, (uint8_t *) &var->data, sizeof(var->data));
+   var->num_state_slots = blob_read_uint32(ctx->blob);
+   var->state_slots = ralloc_array(var, nir_state_slot,
+                                   var->num_state_slots);
+   blob_copy_bytes(ctx->blob, (uint8_t *) var->state_slots,
+                   var->num_state_slots * sizeof(nir_state_slot));
+   if (blob_read_uint32(ctx->blob))
+      var->constant_initializer = read_constant(ctx, var);
+   if (blob_read_uint32(ctx->blob))
+      var->interface_type = glsl_decode_type(ctx->blob);
+
+   return var;
+}
+
+static void
+write_var_list(write_ctx *ctx, const struct exec_list *src)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(src));
+   foreach_list_typed(nir_variable, var, node, src)
+      write_variable(ctx, var);
+}
+
+static void
+read_var_list(read_ctx *ctx, struct exec_list *dst)
+{
+   unsigned num_vars = blob_read_uint32(ctx->blob);
+
+   exec_list_make_empty(dst);
+   for (unsigned i = 0; i < num_vars; i++) {
+      nir_variable *var = read_variable(ctx);
+      exec_list_push_tail(dst, &var->node);
+   }
+}
+
+static void
+write_register(write_ctx *ctx, const nir_register *reg)
+{
+   write_add_object(ctx, reg);
+   blob_write_uint32(ctx->blob, reg->num_components);
+   blob_write_uint32(ctx->blob, reg->bit_size);
+   blob_write_uint32(ctx->blob, reg->num_array_elems);
+   blob_write_uint32(ctx->blob, reg->index);
+   write_string(ctx, reg->name);
+   blob_write_uint32(ctx->blob, reg->is_global);
+   blob_write_uint32(ctx->blob, reg->is_packed);
+}
+
+static nir_register *
+read_register(read_ctx *ctx)
+{
+   nir_register *reg = rzalloc(ctx->nir, nir_register);
+   read_add_object(ctx, reg);
+
+   reg->num_components = blob_read_uint32(ctx->blob);
+   reg->bit_size = blob_read_uint32(ctx->blob);
+   reg->num_array_elems = blob_read_uint32(ctx->blob);
+   reg->index = blob_read_uint32(ctx->blob);
+   reg->name = read_string(ctx, reg);
+   reg->is_global = blob_read_uint32(ctx->blob);
+   reg->is_packed = blob_read_uint32(ctx->blob);
+
+   /* uses/defs/if_uses are set up by nir_instr_insert() */
+   list_inithead(&reg->uses);
+   list_inithead(&reg->defs);
+   list_inithead(&reg->if_uses);
+
+   return reg;
+}
+
+static void
+write_reg_list(write_ctx *ctx, const struct exec_list *src)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(src));
+   foreach_list_typed(nir_register, reg, node, src)
+      write_register(ctx, reg);
+}
+
+static void
+read_reg_list(read_ctx *ctx, struct exec_list *dst)
+{
+   unsigned num_regs = blob_read_uint32(ctx->blob);
+
+   exec_list_make_empty(dst);
+   for (unsigned i = 0; i < num_regs; i++) {
+      nir_register *reg = read_register(ctx);
+      exec_list_push_tail(dst, &reg->node);
+   }
+}
+
+static void
+write_src(write_ctx *ctx, const nir_src *src)
+{
+   blob_write_uint32(ctx->blob, src->is_ssa);
+   if (src->is_ssa) {
+      write_object(ctx, src->ssa);
+   } else {
+      write_object(ctx, src->reg.reg);
+      blob_write_uint32(ctx->blob, src->reg.base_offset);
+      blob_write_uint32(ctx->blob, src->reg.indirect != NULL);
+      if (src->reg.indirect)
+         write_src(ctx, src->reg.indirect);
+   }
+}
+
+static void
+read_src(read_ctx *ctx, nir_src *src, void *mem_ctx)
+{
+   src->is_ssa = blob_read_uint32(ctx->blob);
+   if (src->is_ssa) {
+      src->ssa = read_object(ctx);
+   } else {
+      src->reg.reg = read_object(ctx);
+      src->reg.base_offset = blob_read_uint32(ctx->blob);
+      src->reg.indirect = NULL;
+      if (blob_read_uint32(ctx->blob)) {
+         src->reg.indirect = ralloc(mem_ctx, nir_src);
+         read_src(ctx, src->reg.indirect, mem_ctx);
+      }
+   }
+}
+
+static void
+write_dest(write_ctx *ctx, const nir_dest *dst)
+{
+   blob_write_uint32(ctx->blob, dst->is_ssa);
+   if (dst->is_ssa) {
+      blob_write_uint32(ctx->blob, dst->ssa.num_components);
+      blob_write_uint32(ctx->blob, dst->ssa.bit_size);
+      write_string(ctx, dst->ssa.name);
+      write_add_object(ctx, &dst->ssa);
+   } else {
+      write_object(ctx, dst->reg.reg);
+      blob_write_uint32(ctx->blob, dst->reg.base_offset);
+      blob_write_uint32(ctx->blob, dst->reg.indirect != NULL);
+      if (dst->reg.indirect)
+         write_src(ctx, dst->reg.indirect);
+   }
+}
+
+static void
+read_dest(read_ctx *ctx, nir_dest *dst, nir_instr *instr)
+{
+   bool is_ssa = blob_read_uint32(ctx->blob);
+
+   if (is_ssa) {
+      unsigned num_components = blob_read_uint32(ctx->blob);
+      unsigned bit_size = blob_read_uint32(ctx->blob);
+      char *name = read_string(ctx, NULL);
+
+      nir_ssa_dest_init(instr, dst, num_components, bit_size, name);
+      read_add_object(ctx, &dst->ssa);
+      ralloc_free(name);
+   } else {
+      dst->is_ssa = false;
+      dst->reg.reg = read_object(ctx);
+      dst->reg.base_offset = blob_read_uint32(ctx->blob);
+      dst->reg.indirect = NULL;
+      if (blob_read_uint32(ctx->blob)) {
+         dst->reg.indirect = ralloc(instr, nir_src);
+         read_src(ctx, dst->reg.indirect, instr);
+      }
+   }
+}
+
+static void
+write_deref_chain(write_ctx *ctx, const nir_deref_var *dvar)
+{
+   write_object(ctx, dvar->var);
+
+   for (const nir_deref *deref = dvar->deref.child; deref;
+        deref = deref->child) {
+      blob_write_uint32(ctx->blob, deref->deref_type);
+
+      switch (deref->deref_type) {
+      case nir_deref_type_array: {
+         const nir_deref_array *darr = nir_deref_as_array(deref);
+
+         blob_write_uint32(ctx->blob, darr->deref_array_type);
+         blob_write_uint32(ctx->blob, darr->base_offset);
+         if (darr->deref_array_type == nir_deref_array_type_indirect)
+            write_src(ctx, &darr->indirect);
+         break;
+      }
+      case nir_deref_type_struct:
+         blob_write_uint32(ctx->blob, nir_deref_as_struct(deref)->index);
+         break;
+      default:
+         unreachable("bad deref type");
+      }
+
+      glsl_encode_type(ctx->blob, deref->type);
+   }
+
+   /* A variable deref never is the child of another deref. */
+   blob_write_uint32(ctx->blob, nir_deref_type_var);
+}
+
+static nir_deref_var *
+read_deref_chain(read_ctx *ctx, nir_instr *instr)
+{
+   nir_variable *var = read_object(ctx);
+   nir_deref_var *dvar = nir_deref_var_create(instr, var);
+   nir_deref *tail = &dvar->deref;
+   nir_deref_type deref_type;
+
+   while ((deref_type = blob_read_uint32(ctx->blob)) != nir_deref_type_var) {
+      nir_deref *deref;
+
+      switch (deref_type) {
+      case nir_deref_type_array: {
+         nir_deref_array *darr = nir_deref_array_create(instr);
+
+         darr->deref_array_type = blob_read_uint32(ctx->blob);
+         darr->base_offset = blob_read_uint32(ctx->blob);
+         if (darr->deref_array_type == nir_deref_array_type_indirect)
+            read_src(ctx, &darr->indirect, instr);
+         deref = &darr->deref;
+         break;
+      }
+      case nir_deref_type_struct: {
+         unsigned index = blob_read_uint32(ctx->blob);
+         deref = &nir_deref_struct_create(instr, index)->deref;
+         break;
+      }
+      default:
+         unreachable("bad deref type");
+      }
+
+      deref->type = glsl_decode_type(ctx->blob);
+      tail->child = deref;
+      tail = deref;
+   }
+
+   return dvar;
+}
+
+static void
+write_deref_var(write_ctx *ctx, const nir_deref_var *dvar)
+{
+   blob_write_uint32(ctx->blob, dvar != NULL);
+   if (dvar)
+      write_deref_chain(ctx, dvar);
+}
+
+static nir_deref_var *
+read_deref_var(read_ctx *ctx, nir_instr *instr)
+{
+   if (!blob_read_uint32(ctx->blob))
+      return NULL;
+
+   return read_deref_chain(ctx, instr);
+}
+
+static void
+write_alu(write_ctx *ctx, const nir_alu_instr *alu)
+{
+   blob_write_uint32(ctx->blob, alu->op);
+   blob_write_uint32(ctx->blob, alu->exact);
+
+   write_dest(ctx, &alu->dest.dest);
+   blob_write_uint32(ctx->blob, alu->dest.saturate);
+   blob_write_uint32(ctx->blob, alu->dest.write_mask);
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      write_src(ctx, &alu->src[i].src);
+      blob_write_uint32(ctx->blob, alu->src[i].negate);
+      blob_write_uint32(ctx->blob, alu->src[i].abs);
+      blob_write_bytes(ctx->blob, alu->src[i].swizzle,
+                       sizeof(alu->src[i].swizzle));
+   }
+}
+
+static nir_alu_instr *
+read_alu(read_ctx *ctx)
+{
+   nir_op op = blob_read_uint32(ctx->blob);
+   nir_alu_instr *alu = nir_alu_instr_create(ctx->nir, op);
+
+   alu->exact = blob_read_uint32(ctx->blob);
+
+   read_dest(ctx, &alu->dest.dest, &alu->instr);
+   alu->dest.saturate = blob_read_uint32(ctx->blob);
+   alu->dest.write_mask = blob_read_uint32(ctx->blob);
+
+   for (unsigned i = 0; i < nir_op_infos[op].num_inputs; i++) {
+      read_src(ctx, &alu->src[i].src, &alu->instr);
+      alu->src[i].negate = blob_read_uint32(ctx->blob);
+      alu->src[i].abs = blob_read_uint32(ctx->blob);
+      blob_copy_bytes(ctx->blob, alu->src[i].swizzle,
+                      sizeof(alu->src[i].swizzle));
+   }
+
+   return alu;
+}
+
+static void
+write_intrinsic(write_ctx *ctx, const nir_intrinsic_instr *intrin)
+{
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[intrin->intrinsic];
+
+   blob_write_uint32(ctx->blob, intrin->intrinsic);
+   blob_write_uint32(ctx->blob, intrin->num_components);
+   blob_write_bytes(ctx->blob, intrin->const_index,
+                    sizeof(intrin->const_index));
+
+   if (info->has_dest)
+      write_dest(ctx, &intrin->dest);
+
+   for (unsigned i = 0; i < info->num_variables; i++)
+      write_deref_chain(ctx, intrin->variables[i]);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      write_src(ctx, &intrin->src[i]);
+}
+
+static nir_intrinsic_instr *
+read_intrinsic(read_ctx *ctx)
+{
+   nir_intrinsic_op op = blob_read_uint32(ctx->blob);
+   nir_intrinsic_instr *intrin = nir_intrinsic_instr_create(ctx->nir, op);
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[op];
+
+   intrin->num_components = blob_read_uint32(ctx->blob);
+   blob_copy_bytes(ctx->blob, (uint8_t *) intrin->const_index,
+                   sizeof(intrin->const_index));
+
+   if (info->has_dest)
+      read_dest(ctx, &intrin->dest, &intrin->instr);
+
+   for (unsigned i = 0; i < info->num_variables; i++)
+      intrin->variables[i] = read_deref_chain(ctx, &intrin->instr);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      read_src(ctx, &intrin->src[i], &intrin->instr);
+
+   return intrin;
+}
+
+static void
+write_load_const(write_ctx *ctx, const nir_load_const_instr *lc)
+{
+   blob_write_uint32(ctx->blob, lc->def.num_components);
+   blob_write_uint32(ctx->blob, lc->def.bit_size);
+   blob_write_bytes(ctx->blob, &lc->value, sizeof(lc->value));
+   write_add_object(ctx, &lc->def);
+}
+
+static nir_load_const_instr *
+read_load_const(read_ctx *ctx)
+{
+   unsigned num_components = blob_read_uint32(ctx->blob);
+   unsigned bit_size = blob_read_uint32(ctx->blob);
+   nir_load_const_instr *lc =
+      nir_load_const_instr_create(ctx->nir, num_components, bit_size);
+
+   blob_copy_bytes(ctx->blob, (uint8_t *) &lc->value, sizeof(lc->value));
+   read_add_object(ctx, &lc->def);
+
+   return lc;
+}
+
+static void
+write_ssa_undef(write_ctx *ctx, const nir_ssa_undef_instr *undef)
+{
+   blob_write_uint32(ctx->blob, undef->def.num_components);
+   blob_write_uint32(ctx->blob, undef->def.bit_size);
+   write_add_object(ctx, &undef->def);
+}
+
+static nir_ssa_undef_instr *
+read_ssa_undef(read_ctx *ctx)
+{
+   unsigned num_components = blob_read_uint32(ctx->blob);
+   unsigned bit_size = blob_read_uint32(ctx->blob);
+   nir_ssa_undef_instr *undef =
+      nir_ssa_undef_instr_create(ctx->nir, num_components, bit_size);
+
+   read_add_object(ctx, &undef->def);
+
+   return undef;
+}
+
+static void
+write_tex(write_ctx *ctx, const nir_tex_instr *tex)
+{
+   blob_write_uint32(ctx->blob, tex->num_srcs);
+   blob_write_uint32(ctx->blob, tex->sampler_dim);
+   blob_write_uint32(ctx->blob, tex->dest_type);
+   blob_write_uint32(ctx->blob, tex->op);
+   write_dest(ctx, &tex->dest);
+   for (unsigned i = 0; i < tex->num_srcs; i++) {
+      blob_write_uint32(ctx->blob, tex->src[i].src_type);
+      write_src(ctx, &tex->src[i].src);
+   }
+   blob_write_uint32(ctx->blob, tex->coord_components);
+   blob_write_uint32(ctx->blob, tex->is_array);
+   blob_write_uint32(ctx->blob, tex->is_shadow);
+   blob_write_uint32(ctx->blob, tex->is_new_style_shadow);
+   blob_write_uint32(ctx->blob, tex->component);
+
+   blob_write_uint32(ctx->blob, tex->texture_index);
+   write_deref_var(ctx, tex->texture);
+   blob_write_uint32(ctx->blob, tex->texture_array_size);
+
+   blob_write_uint32(ctx->blob, tex->sampler_index);
+   write_deref_var(ctx, tex->sampler);
+}
+
+static nir_tex_instr *
+read_tex(read_ctx *ctx)
+{
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+   nir_tex_instr *tex = nir_tex_instr_create(ctx->nir, num_srcs);
+
+   tex->sampler_dim = blob_read_uint32(ctx->blob);
+   tex->dest_type = blob_read_uint32(ctx->blob);
+   tex->op = blob_read_uint32(ctx->blob);
+   read_dest(ctx, &tex->dest, &tex->instr);
+   for (unsigned i = 0; i < num_srcs; i++) {
+      tex->src[i].src_type = blob_read_uint32(ctx->blob);
+      read_src(ctx, &tex->src[i].src, &tex->instr);
+   }
+   tex->coord_components = blob_read_uint32(ctx->blob);
+   tex->is_array = blob_read_uint32(ctx->blob);
+   tex->is_shadow = blob_read_uint32(ctx->blob);
+   tex->is_new_style_shadow = blob_read_uint32(ctx->blob);
+   tex->component = blob_read_uint32(ctx->blob);
+
+   tex->texture_index = blob_read_uint32(ctx->blob);
+   tex->texture = read_deref_var(ctx, &tex->instr);
+   tex->texture_array_size = blob_read_uint32(ctx->blob);
+
+   tex->sampler_index = blob_read_uint32(ctx->blob);
+   tex->sampler = read_deref_var(ctx, &tex->instr);
+
+   return tex;
+}
+
+static void
+write_phi(write_ctx *ctx, const nir_phi_instr *phi)
+{
+   /* The predecessors and SSA defs of the sources may come further down,
+    * reserve room for their indices and fill it once the function is
+    * written.
+    */
+   write_dest(ctx, &phi->dest);
+
+   blob_write_uint32(ctx->blob, exec_list_length(&phi->srcs));
+
+   nir_foreach_phi_src(src, phi) {
+      assert(src->src.is_ssa);
+
+      if (ctx->num_phi_fixups == ctx->phi_fixups_size) {
+         ctx->phi_fixups_size = MAX2(16, ctx->phi_fixups_size * 2);
+         ctx->phi_fixups = reralloc(NULL, ctx->phi_fixups, write_phi_fixup,
+                                    ctx->phi_fixups_size);
+      }
+
+      blob_write_uint32(ctx->blob, 0);
+      ctx->phi_fixups[ctx->num_phi_fixups].src = src;
+      ctx->phi_fixups[ctx->num_phi_fixups].blob_offset =
+         ctx->blob->size - sizeof(uint32_t);
+      ctx->num_phi_fixups++;
+      blob_write_uint32(ctx->blob, 0);
+   }
+}
+
+static void
+write_fixup_phis(write_ctx *ctx)
+{
+   for (unsigned i = 0; i < ctx->num_phi_fixups; i++) {
+      const write_phi_fixup *fixup = &ctx->phi_fixups[i];
+
+      blob_overwrite_uint32(ctx->blob, fixup->blob_offset,
+                            write_lookup_object(ctx, fixup->src->pred));
+      blob_overwrite_uint32(ctx->blob,
+                            fixup->blob_offset + sizeof(uint32_t),
+                            write_lookup_object(ctx, fixup->src->src.ssa));
+   }
+
+   ctx->num_phi_fixups = 0;
+}
+
+static void
+read_phi(read_ctx *ctx, nir_block *blk)
+{
+   nir_phi_instr *phi = nir_phi_instr_create(ctx->nir);
+
+   read_dest(ctx, &phi->dest, &phi->instr);
+
+   /* As in nir_clone.c, insert the phi before setting up its sources so
+    * that they don't end up in any use list yet.
+    */
+   nir_instr_insert_after_block(blk, &phi->instr);
+
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_srcs; i++) {
+      nir_phi_src *src = ralloc(phi, nir_phi_src);
+
+      /* Stash the indices for now, read_fixup_phis() turns them into
+       * pointers.
+       */
+      src->pred = (nir_block *) (uintptr_t) blob_read_uint32(ctx->blob);
+      src->src = NIR_SRC_INIT;
+      src->src.is_ssa = true;
+      src->src.ssa = (nir_ssa_def *) (uintptr_t) blob_read_uint32(ctx->blob);
+      src->src.parent_instr = &phi->instr;
+
+      list_add(&src->src.use_link, &ctx->phi_srcs);
+      exec_list_push_tail(&phi->srcs, &src->node);
+   }
+}
+
+static void
+read_fixup_phis(read_ctx *ctx)
+{
+   list_for_each_entry_safe(nir_phi_src, src, &ctx->phi_srcs, src.use_link) {
+      src->pred = read_lookup_object(ctx, (uintptr_t) src->pred);
+      src->src.ssa = read_lookup_object(ctx, (uintptr_t) src->src.ssa);
+
+      /* Remove from this list and place in the uses of the SSA def */
+      list_del(&src->src.use_link);
+      list_addtail(&src->src.use_link, &src->src.ssa->uses);
+   }
+   assert(list_empty(&ctx->phi_srcs));
+}
+
+static void
+write_jump(write_ctx *ctx, const nir_jump_instr *jmp)
+{
+   blob_write_uint32(ctx->blob, jmp->type);
+}
+
+static nir_jump_instr *
+read_jump(read_ctx *ctx)
+{
+   nir_jump_type type = blob_read_uint32(ctx->blob);
+   return nir_jump_instr_create(ctx->nir, type);
+}
+
+static void
+write_call(write_ctx *ctx, const nir_call_instr *call)
+{
+   write_object(ctx, call->callee);
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      write_deref_chain(ctx, call->params[i]);
+
+   write_deref_var(ctx, call->return_deref);
+}
+
+static nir_call_instr *
+read_call(read_ctx *ctx)
+{
+   nir_function *callee = read_object(ctx);
+   nir_call_instr *call = nir_call_instr_create(ctx->nir, callee);
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      call->params[i] = read_deref_chain(ctx, &call->instr);
+
+   call->return_deref = read_deref_var(ctx, &call->instr);
+
+   return call;
+}
+
+static void
+write_instr(write_ctx *ctx, const nir_instr *instr)
+{
+   blob_write_uint32(ctx->blob, instr->type);
+
+   switch (instr->type) {
+   case nir_instr_type_alu:
+      write_alu(ctx, nir_instr_as_alu(instr));
+      break;
+   case nir_instr_type_intrinsic:
+      write_intrinsic(ctx, nir_instr_as_intrinsic(instr));
+      break;
+   case nir_instr_type_load_const:
+      write_load_const(ctx, nir_instr_as_load_const(instr));
+      break;
+   case nir_instr_type_ssa_undef:
+      write_ssa_undef(ctx, nir_instr_as_ssa_undef(instr));
+      break;
+   case nir_instr_type_tex:
+      write_tex(ctx, nir_instr_as_tex(instr));
+      break;
+   case nir_instr_type_phi:
+      write_phi(ctx, nir_instr_as_phi(instr));
+      break;
+   case nir_instr_type_jump:
+      write_jump(ctx, nir_instr_as_jump(instr));
+      break;
+   case nir_instr_type_call:
+      write_call(ctx, nir_instr_as_call(instr));
+      break;
+   case nir_instr_type_parallel_copy:
+      unreachable("Cannot write parallel copies");
+   default:
+      unreachable("bad instr type");
+   }
+}
+
+static void
+read_instr(read_ctx *ctx, nir_block *block)
+{
+   nir_instr_type type = blob_read_uint32(ctx->blob);
+   nir_instr *instr;
+
+   switch (type) {
+   case nir_instr_type_alu:
+      instr = &read_alu(ctx)->instr;
+      break;
+   case nir_instr_type_intrinsic:
+      instr = &read_intrinsic(ctx)->instr;
+      break;
+   case nir_instr_type_load_const:
+      instr = &read_load_const(ctx)->instr;
+      break;
+   case nir_instr_type_ssa_undef:
+      instr = &read_ssa_undef(ctx)->instr;
+      break;
+   case nir_instr_type_tex:
+      instr = &read_tex(ctx)->instr;
+      break;
+   case nir_instr_type_phi:
+      /* Phis insert themselves, see read_phi(). */
+      read_phi(ctx, block);
+      return;
+   case nir_instr_type_jump:
+      instr = &read_jump(ctx)->instr;
+      break;
+   case nir_instr_type_call:
+      instr = &read_call(ctx)->instr;
+      break;
+   case nir_instr_type_parallel_copy:
+      unreachable("Cannot read parallel copies");
+   default:
+      unreachable("bad instr type");
+   }
+
+   nir_instr_insert_after_block(block, instr);
+}
+
+static void
+write_block(write_ctx *ctx, const nir_block *block)
+{
+   write_add_object(ctx, block);
+   blob_write_uint32(ctx->blob, exec_list_length(&block->instr_list));
+   nir_foreach_instr(instr, block)
+      write_instr(ctx, instr);
+}
+
+static void
+read_block(read_ctx *ctx, struct exec_list *cf_list)
+{
+   /* Don't actually create a new block.  Just use the one from the tail of
+    * the list.  NIR guarantees that the tail of the list is a block and that
+    * no two blocks are side-by-side in the IR;  It should be empty.
+    */
+   nir_block *block =
+      exec_node_data(nir_block, exec_list_get_tail(cf_list), cf_node.node);
+   assert(block->cf_node.type == nir_cf_node_block);
+   assert(exec_list_is_empty(&block->instr_list));
+
+   read_add_object(ctx, block);
+
+   unsigned num_instrs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_instrs; i++)
+      read_instr(ctx, block);
+}
+
+static void
+write_cf_list(write_ctx *ctx, const struct exec_list *cf_list);
+
+static void
+read_cf_list(read_ctx *ctx, struct exec_list *cf_list);
+
+static void
+write_if(write_ctx *ctx, const nir_if *nif)
+{
+   write_src(ctx, &nif->condition);
+   write_cf_list(ctx, &nif->then_list);
+   write_cf_list(ctx, &nif->else_list);
+}
+
+static void
+read_if(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_if *nif = nir_if_create(ctx->nir);
+
+   read_src(ctx, &nif->condition, nif);
+
+   nir_cf_node_insert_end(cf_list, &nif->cf_node);
+
+   read_cf_list(ctx, &nif->then_list);
+   read_cf_list(ctx, &nif->else_list);
+}
+
+static void
+write_loop(write_ctx *ctx, const nir_loop *loop)
+{
+   write_cf_list(ctx, &loop->body);
+}
+
+static void
+read_loop(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_loop *loop = nir_loop_create(ctx->nir);
+
+   nir_cf_node_insert_end(cf_list, &loop->cf_node);
+
+   read_cf_list(ctx, &loop->body);
+}
+
+static void
+write_cf_node(write_ctx *ctx, const nir_cf_node *cf)
+{
+   blob_write_uint32(ctx->blob, cf->type);
+
+   switch (cf->type) {
+   case nir_cf_node_block:
+      write_block(ctx, nir_cf_node_as_block(cf));
+      break;
+   case nir_cf_node_if:
+      write_if(ctx, nir_cf_node_as_if(cf));
+      break;
+   case nir_cf_node_loop:
+      write_loop(ctx, nir_cf_node_as_loop(cf));
+      break;
+   default:
+      unreachable("bad cf type");
+   }
+}
+
+static void
+read_cf_node(read_ctx *ctx, struct exec_list *list)
+{
+   nir_cf_node_type type = blob_read_uint32(ctx->blob);
+
+   switch (type) {
+   case nir_cf_node_block:
+      read_block(ctx, list);
+      break;
+   case nir_cf_node_if:
+      read_if(ctx, list);
+      break;
+   case nir_cf_node_loop:
+      read_loop(ctx, list);
+      break;
+   default:
+      unreachable("bad cf type");
+   }
+}
+
+static void
+write_cf_list(write_ctx *ctx, const struct exec_list *cf_list)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(cf_list));
+   foreach_list_typed(nir_cf_node, cf, node, cf_list)
+      write_cf_node(ctx, cf);
+}
+
+static void
+read_cf_list(read_ctx *ctx, struct exec_list *cf_list)
+{
+   unsigned num_cf_nodes = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_cf_nodes; i++)
+      read_cf_node(ctx, cf_list);
+}
+
+static void
+write_function_impl(write_ctx *ctx, const nir_function_impl *fi)
+{
+   write_var_list(ctx, &fi->locals);
+   write_reg_list(ctx, &fi->registers);
+   blob_write_uint32(ctx->blob, fi->reg_alloc);
+
+   blob_write_uint32(ctx->blob, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params; i++)
+      write_variable(ctx, fi->params[i]);
+
+   blob_write_uint32(ctx->blob, fi->return_var != NULL);
+   if (fi->return_var)
+      write_variable(ctx, fi->return_var);
+
+   write_cf_list(ctx, &fi->body);
+   write_fixup_phis(ctx);
+}
+
+static nir_function_impl *
+read_function_impl(read_ctx *ctx, nir_function *fxn)
+{
+   nir_function_impl *fi = nir_function_impl_create_bare(ctx->nir);
+   fi->function = fxn;
+
+   read_var_list(ctx, &fi->locals);
+   read_reg_list(ctx, &fi->registers);
+   fi->reg_alloc = blob_read_uint32(ctx->blob);
+
+   fi->num_params = blob_read_uint32(ctx->blob);
+   fi->params = ralloc_array(ctx->nir, nir_variable *, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params; i++)
+      fi->params[i] = read_variable(ctx);
+
+   if (blob_read_uint32(ctx->blob))
+      fi->return_var = read_variable(ctx);
+
+   assert(list_empty(&ctx->phi_srcs));
+   read_cf_list(ctx, &fi->body);
+   read_fixup_phis(ctx);
+
+   fi->valid_metadata = 0;
+
+   return fi;
+}
+
+static void
+write_function(write_ctx *ctx, const nir_function *fxn)
+{
+   write_add_object(ctx, fxn);
+   write_string(ctx, fxn->name);
+
+   blob_write_uint32(ctx->blob, fxn->num_params);
+   for (unsigned i = 0; i < fxn->num_params; i++) {
+      blob_write_uint32(ctx->blob, fxn->params[i].param_type);
+      glsl_encode_type(ctx->blob, fxn->params[i].type);
+   }
+
+   glsl_encode_type(ctx->blob, fxn->return_type);
+
+   /* At first glance, it looks like we should write the function_impl
+    * here.  However, call instructions need to be able to reference at
+    * least the function and those will get processed as we write the
+    * function_impls.  We stop here and write function_impls as a second
+    * pass.
+    */
+}
+
+static void
+read_function(read_ctx *ctx)
+{
+   char *name = read_string(ctx, NULL);
+   nir_function *fxn = nir_function_create(ctx->nir, name);
+
+   ralloc_free(name);
+   read_add_object(ctx, fxn);
+
+   fxn->num_params = blob_read_uint32(ctx->blob);
+   fxn->params = ralloc_array(ctx->nir, nir_parameter, fxn->num_params);
+   for (unsigned i = 0; i < fxn->num_params; i++) {
+      fxn->params[i].param_type = blob_read_uint32(ctx->blob);
+      fxn->params[i].type = glsl_decode_type(ctx->blob);
+   }
+
+   fxn->return_type = glsl_decode_type(ctx->blob);
+}
+
+/**
+ * Write \p nir to \p blob.  The shader can be read back with
+ * nir_deserialize(), in this process or in another one running the same
+ * build of Mesa.
+ */
+void
+nir_serialize(struct blob *blob, const nir_shader *nir)
+{
+   write_ctx ctx;
+   ctx.blob = blob;
+   ctx.remap_table = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                             _mesa_key_pointer_equal);
+   ctx.next_idx = 1;   /* 0 is NULL */
+   ctx.phi_fixups = NULL;
+   ctx.num_phi_fixups = 0;
+   ctx.phi_fixups_size = 0;
+
+   /* The number of objects is only known at the end, it is written here. */
+   blob_write_uint32(blob, 0);
+   size_t idx_size_offset = blob->size - sizeof(uint32_t);
+
+   blob_write_uint32(blob, nir->stage);
+
+   struct nir_shader_info info = nir->info;
+   info.name = NULL;
+   info.label = NULL;
+   blob_write_bytes(blob, &info, sizeof(info));
+   write_string(&ctx, nir->info.name);
+   write_string(&ctx, nir->info.label);
+
+   write_var_list(&ctx, &nir->uniforms);
+   write_var_list(&ctx, &nir->inputs);
+   write_var_list(&ctx, &nir->outputs);
+   write_var_list(&ctx, &nir->shared);
+   write_var_list(&ctx, &nir->globals);
+   write_var_list(&ctx, &nir->system_values);
+
+   write_reg_list(&ctx, &nir->registers);
+   blob_write_uint32(blob, nir->reg_alloc);
+
+   blob_write_uint32(blob, exec_list_length(&nir->functions));
+   nir_foreach_function(fxn, nir)
+      write_function(&ctx, fxn);
+
+   nir_foreach_function(fxn, nir) {
+      blob_write_uint32(blob, fxn->impl != NULL);
+      if (fxn->impl)
+         write_function_impl(&ctx, fxn->impl);
+   }
+
+   blob_write_uint32(blob, nir->num_inputs);
+   blob_write_uint32(blob, nir->num_uniforms);
+   blob_write_uint32(blob, nir->num_outputs);
+   blob_write_uint32(blob, nir->num_shared);
+
+   blob_overwrite_uint32(blob, idx_size_offset, ctx.next_idx);
+
+   _mesa_hash_table_destroy(ctx.remap_table, NULL);
+   ralloc_free(ctx.phi_fixups);
+}
+
+/**
+ * Read a shader written by nir_serialize().  Returns NULL if the blob is
+ * too short.
+ */
+nir_shader *
+nir_deserialize(void *mem_ctx,
+                const struct nir_shader_compiler_options *options,
+                struct blob_reader *blob)
+{
+   read_ctx ctx;
+   ctx.blob = blob;
+   list_inithead(&ctx.phi_srcs);
+   ctx.idx_table_len = blob_read_uint32(blob);
+   ctx.idx_table = calloc(ctx.idx_table_len, sizeof(void *));
+   ctx.next_idx = 1;   /* 0 is NULL */
+
+   if (blob->overrun || !ctx.idx_table) {
+      free(ctx.idx_table);
+      return NULL;
+   }
+
+   gl_shader_stage stage = blob_read_uint32(blob);
+   ctx.nir = nir_shader_create(mem_ctx, stage, options);
+
+   blob_copy_bytes(blob, (uint8_t *) &ctx.nir->info, sizeof(ctx.nir->info));
+   ctx.nir->info.name = read_string(&ctx, ctx.nir);
+   ctx.nir->info.label = read_string(&ctx, ctx.nir);
+
+   read_var_list(&ctx, &ctx.nir->uniforms);
+   read_var_list(&ctx, &ctx.nir->inputs);
+   read_var_list(&ctx, &ctx.nir->outputs);
+   read_var_list(&ctx, &ctx.nir->shared);
+   read_var_list(&ctx, &ctx.nir->globals);
+   read_var_list(&ctx, &ctx.nir->system_values);
+
+   read_reg_list(&ctx, &ctx.nir->registers);
+   ctx.nir->reg_alloc = blob_read_uint32(blob);
+
+   unsigned num_functions = blob_read_uint32(blob);
+   for (unsigned i = 0; i < num_functions; i++)
+      read_function(&ctx);
+
+   nir_foreach_function(fxn, ctx.nir) {
+      if (blob_read_uint32(blob))
+         fxn->impl = read_function_impl(&ctx, fxn);
+   }
+
+   ctx.nir->num_inputs = blob_read_uint32(blob);
+   ctx.nir->num_uniforms = blob_read_uint32(blob);
+   ctx.nir->num_outputs = blob_read_uint32(blob);
+   ctx.nir->num_shared = blob_read_uint32(blob);
+
+   free(ctx.idx_table);
+
+   if (blob->overrun) {
+      ralloc_free(ctx.nir);
+      return NULL;
+   }
+
+   return ctx.nir;
+}
@@ -26,6 +26,7 @@
  */
 
 #include "nir_types.h"
+#include "compiler/glsl/blob.h"
 #include "compiler/glsl/ir.h"
 
 void
@@ -341,3 +342,201 @@ glsl_transposed_type(const struct glsl_type *type)
    return glsl_type::get_instance(type->base_type, type->matrix_columns,
                                   type->vector_elements);
 }
+
+static void
+encode_struct_fields(struct blob *blob, const glsl_type *type)
+{
+   for (unsigned i = 0; i < type->length; i++) {
+      const glsl_struct_field *field = &type->fields.structure[i];
+
+      glsl_encode_type(blob, field->type);
+      blob_write_string(blob, field->name);
+      blob_write_uint32(blob, field->location);
+      blob_write_uint32(blob, field->offset);
+      blob_write_uint32(blob, field->xfb_buffer);
+      blob_write_uint32(blob, field->xfb_stride);
+      blob_write_uint32(blob, field->interpolation);
+      blob_write_uint32(blob, field->centroid);
+      blob_write_uint32(blob, field->sample);
+      blob_write_uint32(blob, field->matrix_layout);
+      blob_write_uint32(blob, field->patch);
+      blob_write_uint32(blob, field->precision);
+      blob_write_uint32(blob, field->image_read_only);
+      blob_write_uint32(blob, field->image_write_only);
+      blob_write_uint32(blob, field->image_coherent);
+      blob_write_uint32(blob, field->image_volatile);
+      blob_write_uint32(blob, field->image_restrict);
+      blob_write_uint32(blob, field->explicit_xfb_buffer);
+   }
+}
+
+static glsl_struct_field *
+decode_struct_fields(struct blob_reader *blob, unsigned num_fields)
+{
+   glsl_struct_field *fields = new glsl_struct_field[num_fields];
+
+   for (unsigned i = 0; i < num_fields; i++) {
+      glsl_struct_field *field = &fields[i];
+
+      field->type = glsl_decode_type(blob);
+      field->name = blob_read_string(blob);
+      field->location = blob_read_uint32(blob);
+      field->offset = blob_read_uint32(blob);
+      field->xfb_buffer = blob_read_uint32(blob);
+      field->xfb_stride = blob_read_uint32(blob);
+      field->interpolation = blob_read_uint32(blob);
+      field->centroid = blob_read_uint32(blob);
+      field->sample = blob_read_uint32(blob);
+      field->matrix_layout = blob_read_uint32(blob);
+      field->patch = blob_read_uint32(blob);
+      field->precision = blob_read_uint32(blob);
+      field->image_read_only = blob_read_uint32(blob);
+      field->image_write_only = blob_read_uint32(blob);
+      field->image_coherent = blob_read_uint32(blob);
+      field->image_volatile = blob_read_uint32(blob);
+      field->image_restrict = blob_read_uint32(blob);
+      field->explicit_xfb_buffer = blob_read_uint32(blob);
+   }
+
+   return fields;
+}
+
+/**
+ * Write a description of \p type to \p blob, from which glsl_decode_type()
+ * gets the same type back in any process.
+ */
+void
+glsl_encode_type(struct blob *blob, const glsl_type *type)
+{
+   blob_write_uint32(blob, type->base_type);
+
+   switch (type->base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL:
+      blob_write_uint32(blob, type->vector_elements);
+      blob_write_uint32(blob, type->matrix_columns);
+      break;
+   case GLSL_TYPE_SAMPLER:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_shadow);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampled_type);
+      break;
+   case GLSL_TYPE_IMAGE:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampled_type);
+      break;
+   case GLSL_TYPE_ARRAY:
+      blob_write_uint32(blob, type->length);
+      glsl_encode_type(blob, type->fields.array);
+      break;
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE:
+      blob_write_string(blob, type->name);
+      blob_write_uint32(blob, type->length);
+      blob_write_uint32(blob, type->interface_packing);
+      encode_struct_fields(blob, type);
+      break;
+   case GLSL_TYPE_SUBROUTINE:
+      blob_write_string(blob, type->name);
+      break;
+   case GLSL_TYPE_FUNCTION:
+      blob_write_uint32(blob, type->length);
+      for (unsigned i = 0; i <= type->length; i++) {
+         glsl_encode_type(blob, type->fields.parameters[i].type);
+         blob_write_uint32(blob, type->fields.parameters[i].in);
+         blob_write_uint32(blob, type->fields.parameters[i].out);
+      }
+      break;
+   case GLSL_TYPE_ATOMIC_UINT:
+   case GLSL_TYPE_VOID:
+   case GLSL_TYPE_ERROR:
+      break;
+   }
+}
+
+const glsl_type *
+glsl_decode_type(struct blob_reader *blob)
+{
+   glsl_base_type base_type = (glsl_base_type) blob_read_uint32(blob);
+
+   switch (base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL: {
+      unsigned rows = blob_read_uint32(blob);
+      unsigned columns = blob_read_uint32(blob);
+      return glsl_type::get_instance(base_type, rows, columns);
+   }
+   case GLSL_TYPE_SAMPLER: {
+      glsl_sampler_dim dim = (glsl_sampler_dim) blob_read_uint32(blob);
+      bool shadow = blob_read_uint32(blob);
+      bool array = blob_read_uint32(blob);
+      glsl_base_type sampled_type = (glsl_base_type) blob_read_uint32(blob);
+
+      /* The bare sampler of SPIR-V has no sampled type. */
+      if (sampled_type == GLSL_TYPE_VOID)
+         return glsl_type::sampler_type;
+      return glsl_type::get_sampler_instance(dim, shadow, array,
+                                             sampled_type);
+   }
+   case GLSL_TYPE_IMAGE: {
+      glsl_sampler_dim dim = (glsl_sampler_dim) blob_read_uint32(blob);
+      bool array = blob_read_uint32(blob);
+      glsl_base_type sampled_type = (glsl_base_type) blob_read_uint32(blob);
+      return glsl_type::get_image_instance(dim, array, sampled_type);
+   }
+   case GLSL_TYPE_ARRAY: {
+      unsigned length = blob_read_uint32(blob);
+      return glsl_type::get_array_instance(glsl_decode_type(blob), length);
+   }
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE: {
+      const char *name = blob_read_string(blob);
+      unsigned num_fields = blob_read_uint32(blob);
+      glsl_interface_packing packing =
+         (glsl_interface_packing) blob_read_uint32(blob);
+      glsl_struct_field *fields = decode_struct_fields(blob, num_fields);
+      const glsl_type *type;
+
+      if (base_type == GLSL_TYPE_STRUCT)
+         type = glsl_type::get_record_instance(fields, num_fields, name);
+      else
+         type = glsl_type::get_interface_instance(fields, num_fields,
+                                                  packing, name);
+      delete [] fields;
+      return type;
+   }
+   case GLSL_TYPE_SUBROUTINE:
+      return glsl_type::get_subroutine_instance(blob_read_string(blob));
+   case GLSL_TYPE_FUNCTION: {
+      unsigned num_params = blob_read_uint32(blob);
+      glsl_function_param *params = new glsl_function_param[num_params + 1];
+
+      for (unsigned i = 0; i <= num_params; i++) {
+         params[i].type = glsl_decode_type(blob);
+         params[i].in = blob_read_uint32(blob);
+         params[i].out = blob_read_uint32(blob);
+      }
+
+      const glsl_type *type =
+         glsl_type::get_function_instance(params[0].type, &params[1],
+                                          num_params);
+      delete [] params;
+      return type;
+   }
+   case GLSL_TYPE_ATOMIC_UINT:
+      return glsl_type::atomic_uint_type;
+   case GLSL_TYPE_VOID:
+      return glsl_type::void_type;
+   case GLSL_TYPE_ERROR:
+   default:
+      return glsl_type::error_type;
+   }
+}
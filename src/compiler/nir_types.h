@@ -144,6 +144,12 @@ const struct glsl_type * glsl_function_type(const struct glsl_type *return_type,
 
 const struct glsl_type *glsl_transposed_type(const struct glsl_type *type);
 
+struct blob;
+struct blob_reader;
+
+void glsl_encode_type(struct blob *blob, const struct glsl_type *type);
+const struct glsl_type *glsl_decode_type(struct blob_reader *blob);
+
 #ifdef __cplusplus
 }
 #endif
@@ -163,6 +163,10 @@ struct vtn_function {
 
    const uint32_t *end;
 
+   /* Only functions reachable from the entry point are emitted. */
+   bool referenced;
+   bool emitted;
+
    SpvFunctionControlMask control;
 };
 
@@ -283,6 +283,10 @@ struct dri2_egl_surface
    } color_buffers[4], *back, *current;
 #endif
 
+#ifdef HAVE_SURFACELESS_PLATFORM
+   __DRIimage           *front;
+#endif
+
 #ifdef HAVE_ANDROID_PLATFORM
    struct ANativeWindow *window;
    struct ANativeWindowBuffer *buffer;
@@ -485,6 +485,9 @@ dri2_drm_create_image_khr_pixmap(_EGLDisplay *disp, _EGLContext *ctx,
       return NULL;
    }
 
+   /* The image shares the BO storage and may outlive the BO. */
+   dri_bo->cacheable = 0;
+
    return &dri2_img->base;
 }
 
@@ -37,10 +37,150 @@
 #include "egl_dri2_fallbacks.h"
 #include "loader.h"
 
+static __DRIimage *
+surfaceless_alloc_image(struct dri2_egl_display *dri2_dpy,
+                        struct dri2_egl_surface *dri2_surf,
+                        unsigned int format)
+{
+   return dri2_dpy->image->createImage(dri2_dpy->dri_screen,
+                                       dri2_surf->base.Width,
+                                       dri2_surf->base.Height,
+                                       format, 0, NULL);
+}
+
+static void
+surfaceless_free_images(struct dri2_egl_surface *dri2_surf)
+{
+   struct dri2_egl_display *dri2_dpy =
+      dri2_egl_display(dri2_surf->base.Resource.Display);
+
+   if (dri2_surf->front) {
+      dri2_dpy->image->destroyImage(dri2_surf->front);
+      dri2_surf->front = NULL;
+   }
+}
+
+static int
+surfaceless_image_get_buffers(__DRIdrawable *driDrawable,
+                              unsigned int format,
+                              uint32_t *stamp,
+                              void *loaderPrivate,
+                              uint32_t buffer_mask,
+                              struct __DRIimageList *buffers)
+{
+   struct dri2_egl_surface *dri2_surf = loaderPrivate;
+   struct dri2_egl_display *dri2_dpy =
+      dri2_egl_display(dri2_surf->base.Resource.Display);
+
+   buffers->image_mask = 0;
+   buffers->front = NULL;
+   buffers->back = NULL;
+
+   /* Pbuffers are the only surfaces on this platform, and they are created
+    * from single-buffered configs, so rendering goes to the front buffer.
+    * It is a plain image owned by the surface: there is no window system to
+    * share it with, so no copies, fences or round trips are involved.
+    */
+   if (buffer_mask & __DRI_IMAGE_BUFFER_FRONT) {
+      if (!dri2_surf->front)
+         dri2_surf->front =
+            surfaceless_alloc_image(dri2_dpy, dri2_surf, format);
+      if (!dri2_surf->front)
+         return 0;
+
+      buffers->image_mask |= __DRI_IMAGE_BUFFER_FRONT;
+      buffers->front = dri2_surf->front;
+   }
+
+   return 1;
+}
+
+static _EGLSurface *
+dri2_surfaceless_create_surface(_EGLDriver *drv, _EGLDisplay *disp,
+                                EGLint type, _EGLConfig *conf,
+                                const EGLint *attrib_list)
+{
+   struct dri2_egl_display *dri2_dpy = dri2_egl_display(disp);
+   struct dri2_egl_config *dri2_conf = dri2_egl_config(conf);
+   struct dri2_egl_surface *dri2_surf;
+   const __DRIconfig *config;
+
+   dri2_surf = calloc(1, sizeof *dri2_surf);
+   if (!dri2_surf) {
+      _eglError(EGL_BAD_ALLOC, "eglCreatePbufferSurface");
+      return NULL;
+   }
+
+   if (!_eglInitSurface(&dri2_surf->base, disp, type, conf, attrib_list))
+      goto cleanup_surface;
+
+   config = dri2_get_dri_config(dri2_conf, type,
+                                dri2_surf->base.GLColorspace);
+   if (!config) {
+      _eglError(EGL_BAD_MATCH,
+                "Unsupported surfacetype/colorspace configuration");
+      goto cleanup_surface;
+   }
+
+   dri2_surf->dri_drawable =
+      (*dri2_dpy->dri2->createNewDrawable)(dri2_dpy->dri_screen, config,
+                                           dri2_surf);
+   if (dri2_surf->dri_drawable == NULL) {
+      _eglError(EGL_BAD_ALLOC, "dri2->createNewDrawable");
+      goto cleanup_surface;
+   }
+
+   return &dri2_surf->base;
+
+cleanup_surface:
+   free(dri2_surf);
+
+   return NULL;
+}
+
+static _EGLSurface *
+dri2_surfaceless_create_pbuffer_surface(_EGLDriver *drv, _EGLDisplay *disp,
+                                        _EGLConfig *conf,
+                                        const EGLint *attrib_list)
+{
+   return dri2_surfaceless_create_surface(drv, disp, EGL_PBUFFER_BIT, conf,
+                                          attrib_list);
+}
+
+static EGLBoolean
+dri2_surfaceless_destroy_surface(_EGLDriver *drv, _EGLDisplay *disp,
+                                 _EGLSurface *surf)
+{
+   struct dri2_egl_display *dri2_dpy = dri2_egl_display(disp);
+   struct dri2_egl_surface *dri2_surf = dri2_egl_surface(surf);
+
+   if (!_eglPutSurface(surf))
+      return EGL_TRUE;
+
+   surfaceless_free_images(dri2_surf);
+
+   (*dri2_dpy->core->destroyDrawable)(dri2_surf->dri_drawable);
+
+   free(dri2_surf);
+
+   return EGL_TRUE;
+}
+
+static EGLBoolean
+dri2_surfaceless_swap_buffers(_EGLDriver *drv, _EGLDisplay *disp,
+                              _EGLSurface *draw)
+{
+   /* Swapping a pbuffer has no effect. */
+   return EGL_TRUE;
+}
+
 static struct dri2_egl_display_vtbl dri2_surfaceless_display_vtbl = {
    .create_pixmap_surface = dri2_fallback_create_pixmap_surface,
+   .create_pbuffer_surface = dri2_surfaceless_create_pbuffer_surface,
+   .destroy_surface = dri2_surfaceless_destroy_surface,
    .create_image = dri2_create_image_khr,
    .swap_interval = dri2_fallback_swap_interval,
+   .swap_buffers = dri2_surfaceless_swap_buffers,
    .swap_buffers_with_damage = dri2_fallback_swap_buffers_with_damage,
    .swap_buffers_region = dri2_fallback_swap_buffers_region,
    .post_sub_buffer = dri2_fallback_post_sub_buffer,
@@ -48,6 +188,7 @@ static struct dri2_egl_display_vtbl dri2_surfaceless_display_vtbl = {
    .query_buffer_age = dri2_fallback_query_buffer_age,
    .create_wayland_buffer_from_image = dri2_fallback_create_wayland_buffer_from_image,
    .get_sync_values = dri2_fallback_get_sync_values,
+   .get_dri_drawable = dri2_surface_get_dri_drawable,
 };
 
 static void
@@ -55,22 +196,12 @@ surfaceless_flush_front_buffer(__DRIdrawable *driDrawable, void *loaderPrivate)
 {
 }
 
-static __DRIbuffer *
-surfaceless_get_buffers_with_format(__DRIdrawable * driDrawable,
-                             int *width, int *height,
-                             unsigned int *attachments, int count,
-                             int *out_count, void *loaderPrivate)
-{
-   struct dri2_egl_surface *dri2_surf = loaderPrivate;
+static const __DRIimageLoaderExtension image_loader_extension = {
+   .base = { __DRI_IMAGE_LOADER, 1 },
 
-   dri2_surf->buffer_count = 1;
-   if (width)
-      *width = dri2_surf->base.Width;
-   if (height)
-      *height = dri2_surf->base.Height;
-   *out_count = dri2_surf->buffer_count;
-   return dri2_surf->buffers;
-}
+   .getBuffers          = surfaceless_image_get_buffers,
+   .flushFrontBuffer    = surfaceless_flush_front_buffer,
+};
 
 #define DRM_RENDER_DEV_NAME  "%s/renderD%d"
 
@@ -119,15 +250,7 @@ dri2_initialize_surfaceless(_EGLDriver *drv, _EGLDisplay *disp)
       goto cleanup_display;
    }
 
-   dri2_dpy->dri2_loader_extension.base.name = __DRI_DRI2_LOADER;
-   dri2_dpy->dri2_loader_extension.base.version = 3;
-   dri2_dpy->dri2_loader_extension.getBuffers = NULL;
-   dri2_dpy->dri2_loader_extension.flushFrontBuffer =
-      surfaceless_flush_front_buffer;
-   dri2_dpy->dri2_loader_extension.getBuffersWithFormat =
-      surfaceless_get_buffers_with_format;
-
-   dri2_dpy->extensions[0] = &dri2_dpy->dri2_loader_extension.base;
+   dri2_dpy->extensions[0] = &image_loader_extension.base;
    dri2_dpy->extensions[1] = &image_lookup_extension.base;
    dri2_dpy->extensions[2] = &use_invalidate.base;
    dri2_dpy->extensions[3] = NULL;
@@ -138,8 +261,18 @@ dri2_initialize_surfaceless(_EGLDriver *drv, _EGLDisplay *disp)
    }
 
    for (i = 0; dri2_dpy->driver_configs[i]; i++) {
-      dri2_add_config(disp, dri2_dpy->driver_configs[i],
-                      i + 1, EGL_WINDOW_BIT, NULL, NULL);
+      unsigned int double_buffer = 0;
+
+      /* Single-buffered configs back pbuffers.  The double-buffered ones
+       * keep EGL_WINDOW_BIT, which eglChooseConfig matches by default, for
+       * applications that only use surfaceless contexts.
+       */
+      dri2_dpy->core->getConfigAttrib(dri2_dpy->driver_configs[i],
+                                      __DRI_ATTRIB_DOUBLE_BUFFER,
+                                      &double_buffer);
+      dri2_add_config(disp, dri2_dpy->driver_configs[i], i + 1,
+                      double_buffer ? EGL_WINDOW_BIT : EGL_PBUFFER_BIT,
+                      NULL, NULL);
    }
 
    disp->Extensions.KHR_image_base = EGL_TRUE;
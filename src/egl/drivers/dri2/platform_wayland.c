@@ -327,16 +327,21 @@ get_back_bo(struct dri2_egl_surface *dri2_surf)
       return -1;
    }
 
-   /* We always want to throttle to some event (either a frame callback or
-    * a sync request) after the commit so that we can be sure the
-    * compositor has had a chance to handle it and send us a release event
-    * before we look for a free buffer */
+   /* Throttle to the frame callback of the last commit, if there is one. */
    while (dri2_surf->throttle_callback != NULL)
       if (wl_display_dispatch_queue(dri2_dpy->wl_dpy,
                                     dri2_dpy->wl_queue) == -1)
          return -1;
 
-   if (dri2_surf->back == NULL) {
+   /* Handle any release events which already arrived without blocking, so
+    * we see every buffer the compositor is done with.
+    */
+   if (dri2_surf->back == NULL &&
+       wl_display_dispatch_queue_pending(dri2_dpy->wl_dpy,
+                                         dri2_dpy->wl_queue) == -1)
+      return -1;
+
+   while (dri2_surf->back == NULL) {
       for (i = 0; i < ARRAY_SIZE(dri2_surf->color_buffers); i++) {
          /* Get an unlocked buffer, preferrably one with a dri_buffer
           * already allocated. */
@@ -347,10 +352,17 @@ get_back_bo(struct dri2_egl_surface *dri2_surf)
          else if (dri2_surf->back->dri_image == NULL)
             dri2_surf->back = &dri2_surf->color_buffers[i];
       }
-   }
 
-   if (dri2_surf->back == NULL)
-      return -1;
+      if (dri2_surf->back)
+         break;
+
+      /* All buffers are held by the compositor, wait for it to release
+       * one.  Our commits have been flushed, so a release will come.
+       */
+      if (wl_display_dispatch_queue(dri2_dpy->wl_dpy,
+                                    dri2_dpy->wl_queue) == -1)
+         return -1;
+   }
 
    use_flags = __DRI_IMAGE_USE_SHARE | __DRI_IMAGE_USE_BACKBUFFER;
 
@@ -760,18 +772,11 @@ dri2_wl_swap_buffers_with_damage(_EGLDriver *drv,
 
    wl_surface_commit(dri2_surf->wl_win->surface);
 
-   /* If we're not waiting for a frame callback then we'll at least throttle
-    * to a sync callback so that we always give a chance for the compositor to
-    * handle the commit and send a release event before checking for a free
-    * buffer */
-   if (dri2_surf->throttle_callback == NULL) {
-      dri2_surf->throttle_callback = wl_display_sync(dri2_dpy->wl_dpy);
-      wl_callback_add_listener(dri2_surf->throttle_callback,
-                               &throttle_listener, dri2_surf);
-      wl_proxy_set_queue((struct wl_proxy *) dri2_surf->throttle_callback,
-                         dri2_dpy->wl_queue);
-   }
-
+   /* With a swap interval of 0 there is no frame callback to throttle to.
+    * Rather than waiting for a sync request to complete on every frame, the
+    * next get_back_bo() picks up the release events that have arrived by
+    * then and only blocks if the compositor holds all of our buffers.
+    */
    wl_display_flush(dri2_dpy->wl_dpy);
 
    return EGL_TRUE;
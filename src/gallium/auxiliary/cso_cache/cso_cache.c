@@ -52,10 +52,13 @@ static unsigned hash_key(const void *key, unsigned key_size)
 
    assert(key_size % 4 == 0);
 
-   /* I'm sure this can be improved on:
+   /* FNV-1a over whole dwords.  Plain xor folding made states differing
+    * in a single field collide whenever two fields swapped values, which
+    * sent lookups down long collision lists.
     */
+   hash = 2166136261u;
    for (i = 0; i < key_size/4; i++)
-      hash ^= ikey[i];
+      hash = (hash ^ ikey[i]) * 16777619u;
 
    return hash;
 }
@@ -209,7 +212,8 @@ void *cso_hash_find_data_from_template( struct cso_hash *hash,
 				        int size )
 {
    struct cso_hash_iter iter = cso_hash_find(hash, hash_key);
-   while (!cso_hash_iter_is_null(iter)) {
+   while (!cso_hash_iter_is_null(iter) &&
+          cso_hash_iter_key(iter) == hash_key) {
       void *iter_data = cso_hash_iter_data(iter);
       if (!memcmp(iter_data, templ, size)) {
 	 /* We found a match
@@ -227,12 +231,17 @@ struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
                                              void *templ, unsigned size)
 {
    struct cso_hash_iter iter = cso_find_state(sc, hash_key, type);
-   while (!cso_hash_iter_is_null(iter)) {
+   /* Entries sharing a key are adjacent, stop at the first other key
+    * rather than walking the rest of the table on a miss.
+    */
+   while (!cso_hash_iter_is_null(iter) &&
+          cso_hash_iter_key(iter) == hash_key) {
       void *iter_data = cso_hash_iter_data(iter);
       if (!memcmp(iter_data, templ, size))
          return iter;
       iter = cso_hash_iter_next(iter);
    }
+   iter.node = NULL;
    return iter;
 }
 
@@ -111,6 +111,19 @@ struct cso_context {
    void *tesseval_shader, *tesseval_shader_saved;
    void *compute_shader;
    void *velements, *velements_saved;
+
+   /** The templates the current blend, depth/stencil/alpha and rasterizer
+    * states were set from, so that setting the same state again can skip
+    * hashing it and looking it up in the cache.
+    */
+   struct pipe_blend_state blend_templ;
+   struct pipe_depth_stencil_alpha_state depth_stencil_templ;
+   struct pipe_rasterizer_state rasterizer_templ;
+   unsigned blend_templ_size;
+   void *blend_templ_handle;
+   void *depth_stencil_templ_handle;
+   void *rasterizer_templ_handle;
+
    struct pipe_query *render_condition, *render_condition_saved;
    uint render_condition_mode, render_condition_mode_saved;
    boolean render_condition_cond, render_condition_cond_saved;
@@ -408,6 +421,12 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
+
+   if (ctx->blend && ctx->blend == ctx->blend_templ_handle &&
+       key_size == ctx->blend_templ_size &&
+       memcmp(templ, &ctx->blend_templ, key_size) == 0)
+      return PIPE_OK;
+
    hash_key = cso_construct_key((void*)templ, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
                                   (void*)templ, key_size);
@@ -439,6 +458,10 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
       ctx->blend = handle;
       ctx->pipe->bind_blend_state(ctx->pipe, handle);
    }
+
+   memcpy(&ctx->blend_templ, templ, key_size);
+   ctx->blend_templ_size = key_size;
+   ctx->blend_templ_handle = handle;
    return PIPE_OK;
 }
 
@@ -466,13 +489,20 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
                             const struct pipe_depth_stencil_alpha_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
+   unsigned hash_key;
+   struct cso_hash_iter iter;
    void *handle;
 
+   if (ctx->depth_stencil &&
+       ctx->depth_stencil == ctx->depth_stencil_templ_handle &&
+       memcmp(templ, &ctx->depth_stencil_templ, key_size) == 0)
+      return PIPE_OK;
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key,
+                                  CSO_DEPTH_STENCIL_ALPHA,
+                                  (void*)templ, key_size);
+
    if (cso_hash_iter_is_null(iter)) {
       struct cso_depth_stencil_alpha *cso =
          MALLOC(sizeof(struct cso_depth_stencil_alpha));
@@ -504,6 +534,9 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
       ctx->depth_stencil = handle;
       ctx->pipe->bind_depth_stencil_alpha_state(ctx->pipe, handle);
    }
+
+   memcpy(&ctx->depth_stencil_templ, templ, key_size);
+   ctx->depth_stencil_templ_handle = handle;
    return PIPE_OK;
 }
 
@@ -531,13 +564,18 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
                                    const struct pipe_rasterizer_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
+   unsigned hash_key;
+   struct cso_hash_iter iter;
    void *handle = NULL;
 
+   if (ctx->rasterizer && ctx->rasterizer == ctx->rasterizer_templ_handle &&
+       memcmp(templ, &ctx->rasterizer_templ, key_size) == 0)
+      return PIPE_OK;
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key, CSO_RASTERIZER,
+                                  (void*)templ, key_size);
+
    if (cso_hash_iter_is_null(iter)) {
       struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
@@ -565,6 +603,9 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
       ctx->rasterizer = handle;
       ctx->pipe->bind_rasterizer_state(ctx->pipe, handle);
    }
+
+   memcpy(&ctx->rasterizer_templ, templ, key_size);
+   ctx->rasterizer_templ_handle = handle;
    return PIPE_OK;
 }
 
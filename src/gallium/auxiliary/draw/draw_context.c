@@ -45,6 +45,8 @@
 #include "draw_vs.h"
 #include "draw_gs.h"
 
+#include <inttypes.h>
+
 #if HAVE_LLVM
 #include "gallivm/lp_bld_init.h"
 #include "gallivm/lp_bld_limits.h"
@@ -216,6 +218,16 @@ void draw_destroy( struct draw_context *draw )
       draw->render->destroy( draw->render );
    */
 
+   if (debug_get_bool_option("DRAW_DUMP_STATS", FALSE) &&
+       draw->debug_stats.vcache_lookups) {
+      debug_printf("draw: vertex cache: %"PRIu64" lookups, %"PRIu64" hits "
+                   "(%.1f%%)\n",
+                   draw->debug_stats.vcache_lookups,
+                   draw->debug_stats.vcache_hits,
+                   100.0 * draw->debug_stats.vcache_hits /
+                   draw->debug_stats.vcache_lookups);
+   }
+
    draw_prim_assembler_destroy(draw->ia);
    draw_pipeline_destroy( draw );
    draw_pt_destroy( draw );
@@ -339,6 +339,12 @@ struct draw_context
    struct pipe_query_data_pipeline_statistics statistics;
    boolean collect_statistics;
 
+   /** Debug counters, printed by draw_destroy() if DRAW_DUMP_STATS is set */
+   struct {
+      uint64_t vcache_lookups;  /**< indexed vertices of the segments */
+      uint64_t vcache_hits;     /**< ... which didn't need to be shaded */
+   } debug_stats;
+
    struct draw_assembler *ia;
 
    void *driver_private;
@@ -25,8 +25,10 @@
  *
  **************************************************************************/
 
+#include "util/u_cpu_detect.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/u_queue.h"
 #include "util/u_prim.h"
 #include "draw/draw_context.h"
 #include "draw/draw_gs.h"
@@ -39,6 +41,58 @@
 #include "gallivm/lp_bld_init.h"
 
 
+/** Max number of threads running the vertex shader besides the caller */
+#define LLVM_MAX_VS_THREADS 8
+
+/** Fewest vertices worth handing to another thread */
+#define LLVM_VS_JOB_MIN_VERTICES 256
+
+/** Default number of entries of the post-transform vertex cache */
+#define LLVM_VCACHE_DEFAULT_SIZE 2048
+
+
+struct llvm_middle_end;
+
+/**
+ * Post-transform vertex cache.
+ *
+ * vsplit only merges repeated indices within a small direct-mapped
+ * cache, so indexed meshes still fetch the same index several times per
+ * segment.  This maps each index of a segment to the first fetch of it,
+ * with an open-addressed hash table keyed on the index, so each unique
+ * vertex of the segment is shaded once.  Entries are tagged with the
+ * segment they belong to, which avoids clearing the table for each run.
+ */
+struct llvm_vcache {
+   unsigned size;          /**< power of two, 0 if disabled */
+   unsigned stamp;         /**< tag of the current segment */
+   unsigned *tags;
+   unsigned *keys;
+   ushort *slots;
+
+   /** Deduplicated elements handed to the pipeline */
+   unsigned *fetch_elts;
+   ushort *remap;
+   unsigned max_fetch_elts;
+   ushort *draw_elts;
+   unsigned max_draw_elts;
+};
+
+/**
+ * A range of the vertices of a fetch, shaded by one of the vertex shader
+ * threads.
+ */
+struct llvm_vs_job {
+   struct util_queue_fence fence;
+   struct llvm_middle_end *fpme;
+   const struct draw_fetch_info *fetch_info;
+   struct vertex_header *verts;
+   unsigned start;
+   unsigned count;
+   unsigned clipped;
+};
+
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -56,6 +110,15 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /* Threads splitting the vertex shader runs of large fetches with the
+    * calling thread.  Not initialized when DRAW_VS_THREADS is 0.
+    */
+   unsigned num_vs_threads;
+   struct util_queue vs_queue;
+   struct llvm_vs_job vs_jobs[LLVM_MAX_VS_THREADS + 1];
+
+   struct llvm_vcache vcache;
 };
 
 
@@ -336,6 +399,111 @@ emit(struct pt_emit *emit,
 }
 
 
+/**
+ * Run the fetch + vertex shader function over count vertices of the
+ * fetch, starting at vertex start, writing them to verts.
+ */
+static unsigned
+llvm_run_vs_range(struct llvm_middle_end *fpme,
+                  const struct draw_fetch_info *fetch_info,
+                  struct vertex_header *verts,
+                  unsigned start,
+                  unsigned count)
+{
+   struct draw_context *draw = fpme->draw;
+
+   if (fetch_info->linear)
+      return fpme->current_variant->jit_func( &fpme->llvm->jit_context,
+                                       verts,
+                                       draw->pt.user.vbuffer,
+                                       fetch_info->start + start,
+                                       count,
+                                       fpme->vertex_size,
+                                       draw->pt.vertex_buffer,
+                                       draw->instance_id,
+                                       draw->start_index,
+                                       draw->start_instance);
+   else
+      return fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
+                                            verts,
+                                            draw->pt.user.vbuffer,
+                                            fetch_info->elts + start,
+                                            draw->pt.user.eltMax,
+                                            count,
+                                            fpme->vertex_size,
+                                            draw->pt.vertex_buffer,
+                                            draw->instance_id,
+                                            draw->pt.user.eltBias,
+                                            draw->start_instance);
+}
+
+
+static void
+llvm_vs_job_execute(void *data, int thread_index)
+{
+   struct llvm_vs_job *job = (struct llvm_vs_job *)data;
+
+   job->clipped = llvm_run_vs_range(job->fpme, job->fetch_info, job->verts,
+                                    job->start, job->count);
+}
+
+
+/**
+ * Run the fetch + vertex shader over all vertices of the fetch.
+ *
+ * Large fetches are cut into ranges which are shaded concurrently by the
+ * vertex shader threads and the calling thread.  The ranges are written
+ * to their place in verts, so the vertices come out in the same order as
+ * with a single run and the rest of the pipeline is unaffected.  The
+ * shader variant only reads the jit context and the vertex buffers, so
+ * this is safe.
+ */
+static unsigned
+llvm_run_vs(struct llvm_middle_end *fpme,
+            const struct draw_fetch_info *fetch_info,
+            struct vertex_header *verts)
+{
+   const unsigned vector_length = lp_native_vector_width / 32;
+   unsigned num_jobs, job_size, clipped, i;
+
+   num_jobs = MIN2(fpme->num_vs_threads + 1,
+                   fetch_info->count / LLVM_VS_JOB_MIN_VERTICES);
+   if (num_jobs <= 1)
+      return llvm_run_vs_range(fpme, fetch_info, verts, 0, fetch_info->count);
+
+   /* Keep the ranges a multiple of the vector length, as the shader
+    * writes whole vectors of vertices.
+    */
+   job_size = align(DIV_ROUND_UP(fetch_info->count, num_jobs), vector_length);
+   num_jobs = DIV_ROUND_UP(fetch_info->count, job_size);
+
+   for (i = 0; i < num_jobs; i++) {
+      struct llvm_vs_job *job = &fpme->vs_jobs[i];
+
+      job->fpme = fpme;
+      job->fetch_info = fetch_info;
+      job->start = i * job_size;
+      job->count = MIN2(job_size, fetch_info->count - job->start);
+      job->verts = (struct vertex_header *)
+         ((char *)verts + job->start * fpme->vertex_size);
+
+      if (i > 0)
+         util_queue_add_job(&fpme->vs_queue, job, &job->fence,
+                            llvm_vs_job_execute);
+   }
+
+   clipped = llvm_run_vs_range(fpme, fetch_info, fpme->vs_jobs[0].verts,
+                               0, fpme->vs_jobs[0].count);
+
+   for (i = 1; i < num_jobs; i++) {
+      util_queue_job_wait(&fpme->vs_jobs[i].fence);
+      clipped |= fpme->vs_jobs[i].clipped;
+   }
+
+   return clipped;
+}
+
+
 static void
 llvm_pipeline_generic(struct draw_pt_middle_end *middle,
                       const struct draw_fetch_info *fetch_info,
@@ -373,29 +541,7 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       draw->statistics.vs_invocations += fetch_info->count;
    }
 
-   if (fetch_info->linear)
-      clipped = fpme->current_variant->jit_func( &fpme->llvm->jit_context,
-                                       llvm_vert_info.verts,
-                                       draw->pt.user.vbuffer,
-                                       fetch_info->start,
-                                       fetch_info->count,
-                                       fpme->vertex_size,
-                                       draw->pt.vertex_buffer,
-                                       draw->instance_id,
-                                       draw->start_index,
-                                       draw->start_instance);
-   else
-      clipped = fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
-                                            llvm_vert_info.verts,
-                                            draw->pt.user.vbuffer,
-                                            fetch_info->elts,
-                                            draw->pt.user.eltMax,
-                                            fetch_info->count,
-                                            fpme->vertex_size,
-                                            draw->pt.vertex_buffer,
-                                            draw->instance_id,
-                                            draw->pt.user.eltBias,
-                                            draw->start_instance);
+   clipped = llvm_run_vs(fpme, fetch_info, llvm_vert_info.verts);
 
    /* Finished with fetch and vs:
     */
@@ -484,6 +630,92 @@ prim_type(unsigned prim, unsigned flags)
 }
 
 
+static inline unsigned
+llvm_vcache_hash(unsigned key)
+{
+   key ^= key >> 16;
+   return key * 0x45d9f3b;
+}
+
+
+/**
+ * Remove repeated indices from fetch_elts, and remap draw_elts to the
+ * remaining ones.  Returns FALSE if there was nothing to remove.
+ */
+static boolean
+llvm_vcache_dedup(struct llvm_middle_end *fpme,
+                  const unsigned **fetch_elts,
+                  unsigned *fetch_count,
+                  const ushort **draw_elts,
+                  unsigned draw_count)
+{
+   struct llvm_vcache *cache = &fpme->vcache;
+   const unsigned mask = cache->size - 1;
+   unsigned num_unique = 0;
+   unsigned i;
+
+   if (cache->max_fetch_elts < *fetch_count) {
+      FREE(cache->fetch_elts);
+      FREE(cache->remap);
+      cache->fetch_elts = MALLOC(*fetch_count * sizeof(unsigned));
+      cache->remap = MALLOC(*fetch_count * sizeof(ushort));
+      cache->max_fetch_elts = *fetch_count;
+      if (!cache->fetch_elts || !cache->remap) {
+         cache->max_fetch_elts = 0;
+         return FALSE;
+      }
+   }
+
+   if (cache->max_draw_elts < draw_count) {
+      FREE(cache->draw_elts);
+      cache->draw_elts = MALLOC(draw_count * sizeof(ushort));
+      cache->max_draw_elts = cache->draw_elts ? draw_count : 0;
+      if (!cache->draw_elts)
+         return FALSE;
+   }
+
+   if (++cache->stamp == 0) {
+      memset(cache->tags, 0, cache->size * sizeof(unsigned));
+      cache->stamp = 1;
+   }
+
+   for (i = 0; i < *fetch_count; i++) {
+      const unsigned key = (*fetch_elts)[i];
+      unsigned h = llvm_vcache_hash(key) & mask;
+      unsigned probes = 0;
+
+      while (cache->tags[h] == cache->stamp && cache->keys[h] != key &&
+             ++probes < cache->size)
+         h = (h + 1) & mask;
+
+      if (cache->tags[h] == cache->stamp && cache->keys[h] == key) {
+         cache->remap[i] = cache->slots[h];
+         continue;
+      }
+
+      /* Miss.  If the table is full the vertex is just shaded again. */
+      if (cache->tags[h] != cache->stamp) {
+         cache->tags[h] = cache->stamp;
+         cache->keys[h] = key;
+         cache->slots[h] = num_unique;
+      }
+      cache->remap[i] = num_unique;
+      cache->fetch_elts[num_unique++] = key;
+   }
+
+   if (num_unique == *fetch_count)
+      return FALSE;
+
+   for (i = 0; i < draw_count; i++)
+      cache->draw_elts[i] = cache->remap[(*draw_elts)[i]];
+
+   *fetch_elts = cache->fetch_elts;
+   *fetch_count = num_unique;
+   *draw_elts = cache->draw_elts;
+   return TRUE;
+}
+
+
 static void
 llvm_middle_end_run(struct draw_pt_middle_end *middle,
                     const unsigned *fetch_elts,
@@ -493,9 +725,17 @@ llvm_middle_end_run(struct draw_pt_middle_end *middle,
                     unsigned prim_flags)
 {
    struct llvm_middle_end *fpme = llvm_middle_end(middle);
+   struct draw_context *draw = fpme->draw;
    struct draw_fetch_info fetch_info;
    struct draw_prim_info prim_info;
 
+   if (fpme->vcache.size)
+      llvm_vcache_dedup(fpme, &fetch_elts, &fetch_count,
+                        &draw_elts, draw_count);
+
+   draw->debug_stats.vcache_lookups += draw_count;
+   draw->debug_stats.vcache_hits += draw_count - MIN2(fetch_count, draw_count);
+
    fetch_info.linear = FALSE;
    fetch_info.start = 0;
    fetch_info.elts = fetch_elts;
@@ -585,6 +825,20 @@ static void
 llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
 {
    struct llvm_middle_end *fpme = llvm_middle_end(middle);
+   unsigned i;
+
+   if (util_queue_is_initialized(&fpme->vs_queue)) {
+      util_queue_destroy(&fpme->vs_queue);
+      for (i = 0; i < ARRAY_SIZE(fpme->vs_jobs); i++)
+         util_queue_fence_destroy(&fpme->vs_jobs[i].fence);
+   }
+
+   FREE(fpme->vcache.tags);
+   FREE(fpme->vcache.keys);
+   FREE(fpme->vcache.slots);
+   FREE(fpme->vcache.fetch_elts);
+   FREE(fpme->vcache.remap);
+   FREE(fpme->vcache.draw_elts);
 
    if (fpme->fetch)
       draw_pt_fetch_destroy( fpme->fetch );
@@ -646,6 +900,36 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 
    fpme->current_variant = NULL;
 
+   fpme->vcache.size = debug_get_num_option("DRAW_VERTEX_CACHE_SIZE",
+                                            LLVM_VCACHE_DEFAULT_SIZE);
+   if (fpme->vcache.size) {
+      fpme->vcache.size = util_next_power_of_two(fpme->vcache.size);
+      fpme->vcache.tags = CALLOC(fpme->vcache.size, sizeof(unsigned));
+      fpme->vcache.keys = MALLOC(fpme->vcache.size * sizeof(unsigned));
+      fpme->vcache.slots = MALLOC(fpme->vcache.size * sizeof(ushort));
+      if (!fpme->vcache.tags || !fpme->vcache.keys || !fpme->vcache.slots)
+         goto fail;
+   }
+
+   /* The calling thread shades vertices as well. */
+   fpme->num_vs_threads = util_cpu_caps.nr_cpus > 1 ?
+                          MIN2(util_cpu_caps.nr_cpus - 1, LLVM_MAX_VS_THREADS) : 0;
+   fpme->num_vs_threads = debug_get_num_option("DRAW_VS_THREADS",
+                                               fpme->num_vs_threads);
+   fpme->num_vs_threads = MIN2(fpme->num_vs_threads, LLVM_MAX_VS_THREADS);
+   if (fpme->num_vs_threads) {
+      unsigned i;
+
+      if (util_queue_init(&fpme->vs_queue, "draw_vs", LLVM_MAX_VS_THREADS,
+                          fpme->num_vs_threads)) {
+         for (i = 0; i < ARRAY_SIZE(fpme->vs_jobs); i++)
+            util_queue_fence_init(&fpme->vs_jobs[i].fence);
+      }
+      else {
+         fpme->num_vs_threads = 0;
+      }
+   }
+
    return &fpme->base;
 
  fail:
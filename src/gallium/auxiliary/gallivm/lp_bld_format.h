@@ -164,6 +164,9 @@ lp_build_fetch_subsampled_rgba_aos(struct gallivm_state *gallivm,
                                    LLVMValueRef j);
 
 
+boolean
+lp_build_format_is_cached(const struct util_format_description *format_desc);
+
 LLVMValueRef
 lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
                              const struct util_format_description *format_desc,
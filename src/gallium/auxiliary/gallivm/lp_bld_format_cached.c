@@ -32,6 +32,7 @@
 #include "lp_bld_flow.h"
 #include "lp_bld_swizzle.h"
 
+#include "util/u_format.h"
 #include "util/u_math.h"
 
 
@@ -235,6 +236,32 @@ update_cached_block(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Whether texels of the format should be fetched through the block cache.
+ *
+ * That's the case for the 4x4 block compressed formats which decode to
+ * 8 bit unorm texels, as decoding them block by block from C is much slower
+ * than looking up a decoded block.
+ */
+boolean
+lp_build_format_is_cached(const struct util_format_description *format_desc)
+{
+   switch (format_desc->layout) {
+   case UTIL_FORMAT_LAYOUT_S3TC:
+      return TRUE;
+   case UTIL_FORMAT_LAYOUT_RGTC:
+   case UTIL_FORMAT_LAYOUT_ETC:
+   case UTIL_FORMAT_LAYOUT_BPTC:
+      return format_desc->block.width == 4 &&
+             format_desc->block.height == 4 &&
+             format_desc->fetch_rgba_8unorm &&
+             util_format_fits_8unorm(format_desc);
+   default:
+      return FALSE;
+   }
+}
+
+
 /*
  * Do a cached lookup.
  *
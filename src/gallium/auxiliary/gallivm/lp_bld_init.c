@@ -75,6 +75,9 @@ DEBUG_GET_ONCE_FLAGS_OPTION(gallivm_debug, "GALLIVM_DEBUG", lp_bld_debug_flags,
 
 static boolean gallivm_initialized = FALSE;
 
+/* Target data for MCJIT, shared by all gallivm states. */
+static LLVMTargetDataRef gallivm_target;
+
 unsigned lp_native_vector_width;
 
 
@@ -144,7 +147,7 @@ create_pass_manager(struct gallivm_state *gallivm)
    LLVMSetDataLayout(gallivm->module, "");
 #endif
 
-   if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) == 0) {
+   if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) == 0 && !gallivm->fast_compile) {
       /* These are the passes currently listed in llvm-c/Transforms/Scalar.h,
        * but there are more on SVN.
        * TODO: Add more passes.
@@ -189,13 +192,9 @@ gallivm_free_ir(struct gallivm_state *gallivm)
 
    FREE(gallivm->module_name);
 
-   if (!USE_MCJIT) {
-      /* Don't free the TargetData, it's owned by the exec engine */
-   } else {
-      if (gallivm->target) {
-         LLVMDisposeTargetData(gallivm->target);
-      }
-   }
+   /* Don't free the TargetData, it's owned by the exec engine, or shared
+    * with the other states with MCJIT.
+    */
 
    if (gallivm->builder)
       LLVMDisposeBuilder(gallivm->builder);
@@ -235,7 +234,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       char *error = NULL;
       int ret;
 
-      if (gallivm_debug & GALLIVM_DEBUG_NO_OPT) {
+      if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) || gallivm->fast_compile) {
          optlevel = None;
       }
       else {
@@ -342,38 +341,9 @@ init_gallivm_state(struct gallivm_state *gallivm, const char *name,
    } else {
       /*
        * MC-JIT engine compiles the module immediately on creation, so we can't
-       * obtain the target data from it.  Instead we create a target data layout
-       * from a string.
-       *
-       * The produced layout strings are not precisely the same, but should make
-       * no difference for the kind of optimization passes we run.
-       *
-       * For reference this is the layout string on x64:
-       *
-       *   e-p:64:64:64-S128-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f16:16:16-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-f128:128:128-n8:16:32:64
-       *
-       * See also:
-       * - http://llvm.org/docs/LangRef.html#datalayout
+       * obtain the target data from it.  Use the one lp_build_init() created.
        */
-
-      {
-         const unsigned pointer_size = 8 * sizeof(void *);
-         char layout[512];
-         util_snprintf(layout, sizeof layout, "%c-p:%u:%u:%u-i64:64:64-a0:0:%u-s0:%u:%u",
-#ifdef PIPE_ARCH_LITTLE_ENDIAN
-                       'e', // little endian
-#else
-                       'E', // big endian
-#endif
-                       pointer_size, pointer_size, pointer_size, // pointer size, abi alignment, preferred alignment
-                       pointer_size, // aggregate preferred alignment
-                       pointer_size, pointer_size); // stack objects abi alignment, preferred alignment
-
-         gallivm->target = LLVMCreateTargetData(layout);
-         if (!gallivm->target) {
-            return FALSE;
-         }
-      }
+      gallivm->target = gallivm_target;
    }
 
    if (!create_pass_manager(gallivm))
@@ -406,6 +376,37 @@ lp_build_init(void)
 
    lp_set_target_options();
 
+   if (USE_MCJIT) {
+      /*
+       * Create a target data layout from a string, shared by all modules.
+       *
+       * The produced layout strings are not precisely the same, but should make
+       * no difference for the kind of optimization passes we run.
+       *
+       * For reference this is the layout string on x64:
+       *
+       *   e-p:64:64:64-S128-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f16:16:16-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-f128:128:128-n8:16:32:64
+       *
+       * See also:
+       * - http://llvm.org/docs/LangRef.html#datalayout
+       */
+      const unsigned pointer_size = 8 * sizeof(void *);
+      char layout[512];
+      util_snprintf(layout, sizeof layout, "%c-p:%u:%u:%u-i64:64:64-a0:0:%u-s0:%u:%u",
+#ifdef PIPE_ARCH_LITTLE_ENDIAN
+                    'e', // little endian
+#else
+                    'E', // big endian
+#endif
+                    pointer_size, pointer_size, pointer_size, // pointer size, abi alignment, preferred alignment
+                    pointer_size, // aggregate preferred alignment
+                    pointer_size, pointer_size); // stack objects abi alignment, preferred alignment
+
+      gallivm_target = LLVMCreateTargetData(layout);
+      if (!gallivm_target)
+         return FALSE;
+   }
+
    util_cpu_detect();
 
    /* For simulating less capable machines */
@@ -484,16 +485,14 @@ lp_build_init(void)
 
 
 
-/**
- * Create a new gallivm_state object.
- */
-struct gallivm_state *
-gallivm_create(const char *name, LLVMContextRef context)
+static struct gallivm_state *
+create_gallivm(const char *name, LLVMContextRef context, boolean fast_compile)
 {
    struct gallivm_state *gallivm;
 
    gallivm = CALLOC_STRUCT(gallivm_state);
    if (gallivm) {
+      gallivm->fast_compile = fast_compile;
       if (!init_gallivm_state(gallivm, name, context)) {
          FREE(gallivm);
          gallivm = NULL;
@@ -504,6 +503,29 @@ gallivm_create(const char *name, LLVMContextRef context)
 }
 
 
+/**
+ * Create a new gallivm_state object.
+ */
+struct gallivm_state *
+gallivm_create(const char *name, LLVMContextRef context)
+{
+   return create_gallivm(name, context, FALSE);
+}
+
+
+/**
+ * Create a gallivm_state object whose module is compiled as quickly as
+ * possible: only the passes the backends need are run, and code is
+ * generated at -O0.  Meant for code that is recompiled with
+ * gallivm_create() later if it turns out to matter.
+ */
+struct gallivm_state *
+gallivm_create_fast(const char *name, LLVMContextRef context)
+{
+   return create_gallivm(name, context, TRUE);
+}
+
+
 /**
  * Destroy a gallivm_state object.
  */
@@ -51,6 +51,8 @@ struct gallivm_state
    LLVMMCJITMemoryManagerRef memorymgr;
    struct lp_generated_code *code;
    unsigned compiled;
+   /* Trade code quality for compile time, see gallivm_create_fast() */
+   boolean fast_compile;
 };
 
 
@@ -61,6 +63,9 @@ lp_build_init(void);
 struct gallivm_state *
 gallivm_create(const char *name, LLVMContextRef context);
 
+struct gallivm_state *
+gallivm_create_fast(const char *name, LLVMContextRef context);
+
 void
 gallivm_destroy(struct gallivm_state *gallivm);
 
@@ -70,10 +70,12 @@
 #include <llvm/ExecutionEngine/JITMemoryManager.h>
 #else
 #include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 #endif
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Host.h>
 #include <llvm/Support/PrettyStackTrace.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <llvm/Support/TargetSelect.h>
 
@@ -91,6 +93,8 @@
 #include "pipe/p_config.h"
 #include "util/u_debug.h"
 #include "util/u_cpu_detect.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 
 #include "lp_bld_misc.h"
 
@@ -384,6 +388,10 @@ class ShaderMemoryManager : public DelegatingJITMemoryManager {
       typedef std::vector<void *> Vec;
       Vec FunctionBody, ExceptionTable;
       BaseMemoryManager *TheMM;
+#if HAVE_LLVM >= 0x0306
+      /* Must outlive the engine it was given to. */
+      std::unique_ptr<llvm::ObjectCache> Cache;
+#endif
 
       GeneratedCode(BaseMemoryManager *MM) {
          TheMM = MM;
@@ -436,6 +444,13 @@ class ShaderMemoryManager : public DelegatingJITMemoryManager {
          delete (GeneratedCode *) code;
       }
 
+#if HAVE_LLVM >= 0x0306
+      static void setObjectCache(struct lp_generated_code *code,
+                                 llvm::ObjectCache *Cache) {
+         ((GeneratedCode *) code)->Cache.reset(Cache);
+      }
+#endif
+
 #if HAVE_LLVM < 0x0304
       virtual void deallocateExceptionTable(void *ET) {
          // remember for later deallocation
@@ -450,6 +465,101 @@ class ShaderMemoryManager : public DelegatingJITMemoryManager {
 };
 
 
+#if HAVE_LLVM >= 0x0306
+
+static once_flag object_cache_once_flag;
+static struct disk_cache *object_disk_cache;
+
+static void init_object_cache()
+{
+   char timestamp[64];
+
+   if (disk_cache_get_function_timestamp((void *) init_object_cache,
+                                         timestamp, sizeof timestamp))
+      object_disk_cache = disk_cache_create("gallivm", timestamp);
+}
+
+/*
+ * Keep the object code MCJIT emits in the on-disk shader cache, so that
+ * modules compiled before, by another context or another process, skip
+ * code generation.
+ *
+ * The key is the SHA-1 of the optimized IR and of everything that affects
+ * code generation but isn't part of the module: LLVM version, CPU, target
+ * features and optimization level.  Host addresses baked into the IR are
+ * part of the key too, so objects never leak across address spaces.
+ */
+class ShaderObjectCache : public llvm::ObjectCache {
+
+   struct disk_cache *Cache;
+   std::string Target;
+
+   /* MCJIT asks for the object, then hands it over if there was none. */
+   const llvm::Module *LastModule;
+   cache_key LastKey;
+
+   bool getKey(const llvm::Module *M, cache_key key) {
+      if (M != LastModule) {
+         std::string IR;
+         llvm::raw_string_ostream OS(IR);
+         struct mesa_sha1 *ctx = _mesa_sha1_init();
+
+         if (!ctx)
+            return false;
+
+         M->print(OS, NULL);
+         OS.flush();
+
+         _mesa_sha1_update(ctx, Target.data(), Target.size());
+         _mesa_sha1_update(ctx, IR.data(), IR.size());
+         _mesa_sha1_final(ctx, LastKey);
+         LastModule = M;
+      }
+
+      memcpy(key, LastKey, sizeof(cache_key));
+      return true;
+   }
+
+   public:
+
+      ShaderObjectCache(struct disk_cache *cache, const std::string &target)
+         : Cache(cache), Target(target), LastModule(NULL) {
+      }
+
+      virtual void notifyObjectCompiled(const llvm::Module *M,
+                                        llvm::MemoryBufferRef Obj) {
+         cache_key key;
+
+         if (getKey(M, key))
+            disk_cache_put(Cache, key, Obj.getBufferStart(),
+                           Obj.getBufferSize());
+      }
+
+      virtual std::unique_ptr<llvm::MemoryBuffer>
+      getObject(const llvm::Module *M) {
+         std::unique_ptr<llvm::MemoryBuffer> Obj;
+         cache_key key;
+         size_t size;
+         void *data;
+
+         if (!getKey(M, key))
+            return NULL;
+
+         data = disk_cache_get(Cache, key, &size);
+         if (!data)
+            return NULL;
+
+         Obj = llvm::MemoryBuffer::getMemBufferCopy(
+                  llvm::StringRef((const char *) data, size),
+                  M->getModuleIdentifier());
+         free(data);
+         return Obj;
+      }
+};
+
+#endif /* HAVE_LLVM >= 0x0306 */
+
+
 /**
  * Same as LLVMCreateJITCompilerForModule, but:
  * - allows using MCJIT and enabling AVX feature where available.
@@ -600,6 +710,18 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    builder.setMCPU(MCPU);
 #endif
 
+#if HAVE_LLVM >= 0x0306
+   std::string CacheTarget;
+   if (useMCJIT) {
+      llvm::raw_string_ostream OS(CacheTarget);
+
+      OS << HAVE_LLVM << ' ' << MCPU << ' ' << OptLevel;
+      for (unsigned i = 0; i < MAttrs.size(); ++i)
+         OS << ' ' << MAttrs[i];
+      OS.flush();
+   }
+#endif
+
    ShaderMemoryManager *MM = NULL;
    if (useMCJIT) {
        BaseMemoryManager* JMM = reinterpret_cast<BaseMemoryManager*>(CMM);
@@ -630,6 +752,16 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 
    JIT = builder.create();
    if (JIT) {
+#if HAVE_LLVM >= 0x0306
+      call_once(&object_cache_once_flag, init_object_cache);
+      if (useMCJIT && object_disk_cache) {
+         ShaderObjectCache *Cache =
+            new ShaderObjectCache(object_disk_cache, CacheTarget);
+
+         ShaderMemoryManager::setObjectCache(*OutCode, Cache);
+         JIT->setObjectCache(Cache);
+      }
+#endif
       *OutJIT = wrap(JIT);
       return 0;
    }
@@ -33,6 +33,7 @@
  * Set GALLIUM_HUD=help for more info.
  */
 
+#include <inttypes.h>
 #include <signal.h>
 #include <stdio.h>
 
@@ -41,6 +42,7 @@
 #include "hud/font.h"
 
 #include "cso_cache/cso_context.h"
+#include "os/os_time.h"
 #include "util/u_draw_quad.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
@@ -63,6 +65,10 @@ struct hud_context {
    struct hud_batch_query_context *batch_query;
    struct list_head pane_list;
 
+   /* per-frame records of all graphs, see GALLIUM_HUD_DUMP_FILE */
+   FILE *dump_file;
+   unsigned frame;
+
    /* states */
    struct pipe_blend_state alpha_blend;
    struct pipe_depth_stencil_alpha_state dsa;
@@ -435,6 +441,60 @@ hud_alloc_vertices(struct hud_context *hud, struct vertex_queue *v,
                   (void**)&v->vertices);
 }
 
+/**
+ * Write the current values of all graphs as one CSV record.
+ */
+static void
+hud_dump_frame(struct hud_context *hud)
+{
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+
+   fprintf(hud->dump_file, "%u,%"PRId64, hud->frame, os_time_get());
+
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         fprintf(hud->dump_file, ",%"PRIu64, gr->current_value);
+      }
+   }
+   fputc('\n', hud->dump_file);
+}
+
+static void
+hud_dump_header(struct hud_context *hud)
+{
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+
+   fprintf(hud->dump_file, "frame,time_us");
+
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         fprintf(hud->dump_file, ",%s", gr->name);
+      }
+   }
+   fputc('\n', hud->dump_file);
+}
+
+/**
+ * Update the values of all graphs without drawing anything, for the frames
+ * where the HUD is hidden but its values are still dumped.
+ */
+static void
+hud_update_graphs(struct hud_context *hud)
+{
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+
+   hud_batch_query_update(hud->batch_query);
+
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         gr->query_new_value(gr);
+      }
+   }
+}
+
 /**
  * Draw the HUD to the texture \p tex.
  * The texture is usually the back buffer being displayed.
@@ -452,8 +512,15 @@ hud_draw(struct hud_context *hud, struct pipe_resource *tex)
    struct hud_pane *pane;
    struct hud_graph *gr;
 
-   if (!huds_visible)
+   hud->frame++;
+
+   if (!huds_visible) {
+      if (hud->dump_file) {
+         hud_update_graphs(hud);
+         hud_dump_frame(hud);
+      }
       return;
+   }
 
    hud->fb_width = tex->width0;
    hud->fb_height = tex->height0;
@@ -596,6 +663,9 @@ hud_draw(struct hud_context *hud, struct pipe_resource *tex)
    cso_restore_constant_buffer_slot0(cso, PIPE_SHADER_VERTEX);
 
    pipe_surface_reference(&surf, NULL);
+
+   if (hud->dump_file)
+      hud_dump_frame(hud);
 }
 
 /**
@@ -1083,6 +1153,11 @@ print_help(struct pipe_screen *screen)
    puts("");
    puts("  Example: GALLIUM_HUD=\".w256.h64.x1600.y520.d.c1000fps+cpu,.datom-count\"");
    puts("");
+   puts("  GALLIUM_HUD_DUMP_FILE=[file] writes the values of all graphs to the");
+   puts("  file every frame, as CSV records starting with the frame number and");
+   puts("  the time in microseconds.  With GALLIUM_HUD_VISIBLE=false nothing is");
+   puts("  drawn, but the values are still queried and written.");
+   puts("");
    puts("  Available names:");
    puts("    fps");
    puts("    cpu");
@@ -1139,6 +1214,7 @@ hud_create(struct pipe_context *pipe, struct cso_context *cso)
    unsigned i;
    const char *env = debug_get_option("GALLIUM_HUD", NULL);
    unsigned signo = debug_get_num_option("GALLIUM_HUD_TOGGLE_SIGNAL", 0);
+   const char *dump_filename = debug_get_option("GALLIUM_HUD_DUMP_FILE", NULL);
 #ifdef PIPE_OS_UNIX
    static boolean sig_handled = FALSE;
    struct sigaction action = {};
@@ -1304,6 +1380,14 @@ hud_create(struct pipe_context *pipe, struct cso_context *cso)
 #endif
 
    hud_parse_env_var(hud, env);
+
+   if (dump_filename) {
+      hud->dump_file = fopen(dump_filename, "w");
+      if (hud->dump_file)
+         hud_dump_header(hud);
+      else
+         fprintf(stderr, "gallium_hud: unable to open %s\n", dump_filename);
+   }
    return hud;
 }
 
@@ -1323,6 +1407,9 @@ hud_destroy(struct hud_context *hud)
       FREE(pane);
    }
 
+   if (hud->dump_file)
+      fclose(hud->dump_file);
+
    hud_batch_query_cleanup(&hud->batch_query);
    pipe->delete_fs_state(pipe, hud->fs_color);
    pipe->delete_fs_state(pipe, hud->fs_text);
@@ -30,6 +30,7 @@ FIRST, LAST = 'first', 'last'
 PRDISABLE, PRENABLE = 'prdisable', 'prenable'
 
 INTYPES = (GENERATE, UBYTE, USHORT, UINT)
+SIZES = dict(ubyte=1, ushort=2, uint=4)
 OUTTYPES = (USHORT, UINT)
 PVS=(FIRST, LAST)
 PRS=(PRDISABLE, PRENABLE)
@@ -78,6 +79,10 @@ def prolog():
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
 
+#if defined(PIPE_ARCH_SSE)
+#include <emmintrin.h>
+#endif
+
 
 static unsigned out_size_idx( unsigned index_size )
 {
@@ -103,6 +108,99 @@ static u_translate_func translate[IN_COUNT][OUT_COUNT][PV_COUNT][PV_COUNT][PR_CO
 static u_generate_func  generate[OUT_COUNT][PV_COUNT][PV_COUNT][PRIM_COUNT];
 
 
+#if defined(PIPE_ARCH_SSE)
+
+/*
+ * SSE2 helpers for the vectorized loops below.  They only ever widen
+ * indices (or keep their size), so no value is ever truncated.
+ */
+
+static inline void widen_ubyte2ushort_x8( const ubyte *in, ushort *out )
+{
+   __m128i v = _mm_loadl_epi64((const __m128i *)in);
+   _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+}
+
+static inline void widen_ubyte2uint_x8( const ubyte *in, uint *out )
+{
+   __m128i v = _mm_loadl_epi64((const __m128i *)in);
+   v = _mm_unpacklo_epi8(v, _mm_setzero_si128());
+   _mm_storeu_si128((__m128i *)out + 0, _mm_unpacklo_epi16(v, _mm_setzero_si128()));
+   _mm_storeu_si128((__m128i *)out + 1, _mm_unpackhi_epi16(v, _mm_setzero_si128()));
+}
+
+static inline void widen_ushort2uint_x8( const ushort *in, uint *out )
+{
+   __m128i v = _mm_loadu_si128((const __m128i *)in);
+   _mm_storeu_si128((__m128i *)out + 0, _mm_unpacklo_epi16(v, _mm_setzero_si128()));
+   _mm_storeu_si128((__m128i *)out + 1, _mm_unpackhi_epi16(v, _mm_setzero_si128()));
+}
+
+/* Load four consecutive quads, one quad per vector of 32-bit indices. */
+static inline void load_quads_ubyte( const ubyte *in, __m128i q[4] )
+{
+   __m128i v = _mm_loadu_si128((const __m128i *)in);
+   __m128i lo = _mm_unpacklo_epi8(v, _mm_setzero_si128());
+   __m128i hi = _mm_unpackhi_epi8(v, _mm_setzero_si128());
+   q[0] = _mm_unpacklo_epi16(lo, _mm_setzero_si128());
+   q[1] = _mm_unpackhi_epi16(lo, _mm_setzero_si128());
+   q[2] = _mm_unpacklo_epi16(hi, _mm_setzero_si128());
+   q[3] = _mm_unpackhi_epi16(hi, _mm_setzero_si128());
+}
+
+static inline void load_quads_ushort( const ushort *in, __m128i q[4] )
+{
+   __m128i lo = _mm_loadu_si128((const __m128i *)in + 0);
+   __m128i hi = _mm_loadu_si128((const __m128i *)in + 1);
+   q[0] = _mm_unpacklo_epi16(lo, _mm_setzero_si128());
+   q[1] = _mm_unpackhi_epi16(lo, _mm_setzero_si128());
+   q[2] = _mm_unpacklo_epi16(hi, _mm_setzero_si128());
+   q[3] = _mm_unpackhi_epi16(hi, _mm_setzero_si128());
+}
+
+static inline void load_quads_uint( const uint *in, __m128i q[4] )
+{
+   q[0] = _mm_loadu_si128((const __m128i *)in + 0);
+   q[1] = _mm_loadu_si128((const __m128i *)in + 1);
+   q[2] = _mm_loadu_si128((const __m128i *)in + 2);
+   q[3] = _mm_loadu_si128((const __m128i *)in + 3);
+}
+
+static inline boolean quads_have_restart( const __m128i q[4], unsigned restart_index )
+{
+   __m128i r = _mm_set1_epi32(restart_index);
+   __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(q[0], r),
+                                          _mm_cmpeq_epi32(q[1], r)),
+                             _mm_or_si128(_mm_cmpeq_epi32(q[2], r),
+                                          _mm_cmpeq_epi32(q[3], r)));
+   return _mm_movemask_epi8(eq) != 0;
+}
+
+static inline void store_tris_uint( uint *out, const __m128i t[6] )
+{
+   unsigned k;
+   for (k = 0; k < 6; k++)
+      _mm_storeu_si128((__m128i *)out + k, t[k]);
+}
+
+/* The indices are known to fit in 16 bits: bias them so that the signed
+ * saturating pack leaves them alone.
+ */
+static inline void store_tris_ushort( ushort *out, const __m128i t[6] )
+{
+   const __m128i bias32 = _mm_set1_epi32(0x8000);
+   const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+   unsigned k;
+   for (k = 0; k < 3; k++) {
+      __m128i v = _mm_packs_epi32(_mm_sub_epi32(t[2*k+0], bias32),
+                                  _mm_sub_epi32(t[2*k+1], bias32));
+      _mm_storeu_si128((__m128i *)out + k, _mm_xor_si128(v, bias16));
+   }
+}
+
+#endif
+
+
 '''
 
 def vert( intype, outtype, v0 ):
@@ -149,6 +247,69 @@ def do_quad( intype, outtype, ptr, v0, v1, v2, v3, inpv, outpv ):
         do_tri( intype, outtype, ptr+'+0',  v0, v1, v2, inpv, outpv );
         do_tri( intype, outtype, ptr+'+3',  v0, v2, v3, inpv, outpv );
 
+def tri_verts( v0, v1, v2, inpv, outpv ):
+    if inpv == outpv:
+        return [v0, v1, v2]
+    elif inpv == FIRST:
+        return [v1, v2, v0]
+    else:
+        return [v2, v0, v1]
+
+def quad_verts( inpv, outpv ):
+    '''The vertices of a quad, in the order do_quad() emits them.'''
+    if inpv == LAST:
+        return tri_verts(0, 1, 3, inpv, outpv) + tri_verts(1, 2, 3, inpv, outpv)
+    else:
+        return tri_verts(0, 1, 2, inpv, outpv) + tri_verts(0, 2, 3, inpv, outpv)
+
+def can_widen( intype, outtype ):
+    return intype != GENERATE and SIZES[intype] < SIZES[outtype]
+
+def widen_loop( intype, outtype, nr ):
+    '''Vectorized head of the plain copy loops, which only widen the
+    indices.  Each iteration handles 8*nr indices so that the scalar loop
+    resumes on a primitive boundary.'''
+    print '  i = start;'
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '  for (; i + %d <= out_nr + start; i += %d) {' % (8*nr, 8*nr)
+    for k in range(nr):
+        print '      widen_%s2%s_x8(in + i + %d, out + i + %d);' % (intype, outtype, 8*k, 8*k)
+    print '   }'
+    print '#endif'
+
+def shuffle( q, v0, v1, v2, v3 ):
+    return '_mm_shuffle_epi32(%s, _MM_SHUFFLE(%d, %d, %d, %d))' % (q, v3, v2, v1, v0)
+
+def quads_simd( intype, outtype, inpv, outpv, pr ):
+    '''Vectorized quad to triangle conversion, four quads at a time.
+    With primitive restart enabled, blocks containing the restart index
+    are left to the scalar code.'''
+    if intype == GENERATE or SIZES[intype] > SIZES[outtype]:
+        return
+    v = quad_verts(inpv, outpv)
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '      while (j + 24 <= out_nr && i + 16 <= in_nr) {'
+    print '         __m128i q[4], t[6];'
+    print '         load_quads_' + intype + '(in + i, q);'
+    if pr == PRENABLE:
+        print '         if (quads_have_restart(q, restart_index))'
+        print '            break;'
+    for k in (0, 2):
+        qa = 'q[%d]' % k
+        qb = 'q[%d]' % (k + 1)
+        t = k * 3 // 2
+        print '         t[%d] = %s;' % (t + 0, shuffle(qa, v[0], v[1], v[2], v[3]))
+        print '         t[%d] = _mm_unpacklo_epi64(%s,' % (t + 1, shuffle(qa, v[4], v[5], 0, 0))
+        print '                                   %s);' % shuffle(qb, v[0], v[1], 0, 0)
+        print '         t[%d] = %s;' % (t + 2, shuffle(qb, v[2], v[3], v[4], v[5]))
+    print '         store_tris_' + outtype + '(out + j, t);'
+    print '         i += 16;'
+    print '         j += 24;'
+    print '      }'
+    print '      if (j >= out_nr)'
+    print '         break;'
+    print '#endif'
+
 def name(intype, outtype, inpv, outpv, pr, prim):
     if intype == GENERATE:
         return 'generate_' + prim + '_' + outtype + '_' + inpv + '2' + outpv
@@ -179,14 +340,22 @@ def postamble():
 
 def points(intype, outtype, inpv, outpv, pr):
     preamble(intype, outtype, inpv, outpv, pr, prim='points')
-    print '  for (i = start; i < (out_nr+start); i++) { '
+    if can_widen(intype, outtype):
+        widen_loop(intype, outtype, 1)
+        print '  for (; i < (out_nr+start); i++) { '
+    else:
+        print '  for (i = start; i < (out_nr+start); i++) { '
     do_point( intype, outtype, 'out+i',  'i' );
     print '   }'
     postamble()
 
 def lines(intype, outtype, inpv, outpv, pr):
     preamble(intype, outtype, inpv, outpv, pr, prim='lines')
-    print '  for (i = start; i < (out_nr+start); i+=2) { '
+    if can_widen(intype, outtype) and inpv == outpv:
+        widen_loop(intype, outtype, 2)
+        print '  for (; i < (out_nr+start); i+=2) { '
+    else:
+        print '  for (i = start; i < (out_nr+start); i+=2) { '
     do_line( intype, outtype, 'out+i',  'i', 'i+1', inpv, outpv );
     print '   }'
     postamble()
@@ -208,7 +377,11 @@ def lineloop(intype, outtype, inpv, outpv, pr):
 
 def tris(intype, outtype, inpv, outpv, pr):
     preamble(intype, outtype, inpv, outpv, pr, prim='tris')
-    print '  for (i = start; i < (out_nr+start); i+=3) { '
+    if can_widen(intype, outtype) and inpv == outpv:
+        widen_loop(intype, outtype, 3)
+        print '  for (; i < (out_nr+start); i+=3) { '
+    else:
+        print '  for (i = start; i < (out_nr+start); i+=3) { '
     do_tri( intype, outtype, 'out+i',  'i', 'i+1', 'i+2', inpv, outpv );
     print '   }'
     postamble()
@@ -272,6 +445,7 @@ def polygon(intype, outtype, inpv, outpv, pr):
 def quads(intype, outtype, inpv, outpv, pr):
     preamble(intype, outtype, inpv, outpv, pr, prim='quads')
     print '  for (i = start, j = 0; j < out_nr; j+=6, i+=4) { '
+    quads_simd(intype, outtype, inpv, outpv, pr)
     if pr == PRENABLE:
         print 'restart:'
         print '      if (i + 4 > in_nr) {'
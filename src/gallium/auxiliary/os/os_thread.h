@@ -96,6 +96,25 @@ static inline void pipe_thread_setname( const char *name )
    (void)name;
 }
 
+/**
+ * Pin the calling thread to a single CPU.  Only implemented with glibc,
+ * a no-op elsewhere.
+ */
+static inline void pipe_thread_set_cpu( unsigned cpu )
+{
+#if defined(HAVE_PTHREAD)
+#  if defined(__GNU_LIBRARY__) && defined(__GLIBC__) && defined(__GLIBC_MINOR__) && \
+      defined(CPU_SET)
+   cpu_set_t cpuset;
+
+   CPU_ZERO(&cpuset);
+   CPU_SET(cpu, &cpuset);
+   pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+#  endif
+#endif
+   (void)cpu;
+}
+
 
 /* pipe_mutex
  */
@@ -201,29 +201,45 @@ pipe_loader_drm_probe_fd(struct pipe_loader_device **dev, int fd)
    }
    if (!ddev->dd)
       goto fail;
-#else
-   ddev->lib = pipe_loader_find_module(&ddev->base, PIPE_SEARCH_DIR);
-   if (!ddev->lib)
-      goto fail;
-
-   ddev->dd = (const struct drm_driver_descriptor *)
-      util_dl_get_proc_address(ddev->lib, "driver_descriptor");
-
-   /* sanity check on the name */
-   if (!ddev->dd || strcmp(ddev->dd->name, ddev->base.driver_name) != 0)
-      goto fail;
 #endif
 
+   /* With dynamic targets the driver module is only loaded when the device
+    * is actually used, see pipe_loader_drm_load_driver.
+    */
    *dev = &ddev->base;
    return true;
 
   fail:
+   FREE(ddev->base.driver_name);
+   FREE(ddev);
+   return false;
+}
+
+/**
+ * Load the driver module of the device, if it hasn't been loaded yet.
+ */
+static bool
+pipe_loader_drm_load_driver(struct pipe_loader_drm_device *ddev)
+{
 #ifndef GALLIUM_STATIC_TARGETS
+   if (ddev->dd)
+      return true;
    if (ddev->lib)
-      util_dl_close(ddev->lib);
+      return false; /* loading failed before */
+
+   ddev->lib = pipe_loader_find_module(&ddev->base, PIPE_SEARCH_DIR);
+   if (!ddev->lib)
+      return false;
+
+   ddev->dd = (const struct drm_driver_descriptor *)
+      util_dl_get_proc_address(ddev->lib, "driver_descriptor");
+
+   /* sanity check on the name */
+   if (ddev->dd && strcmp(ddev->dd->name, ddev->base.driver_name) != 0)
+      ddev->dd = NULL;
 #endif
-   FREE(ddev);
-   return false;
+
+   return ddev->dd != NULL;
 }
 
 static int
@@ -287,7 +303,7 @@ pipe_loader_drm_configuration(struct pipe_loader_device *dev,
 {
    struct pipe_loader_drm_device *ddev = pipe_loader_drm_device(dev);
 
-   if (!ddev->dd->configuration)
+   if (!pipe_loader_drm_load_driver(ddev) || !ddev->dd->configuration)
       return NULL;
 
    return ddev->dd->configuration(conf);
@@ -298,6 +314,9 @@ pipe_loader_drm_create_screen(struct pipe_loader_device *dev)
 {
    struct pipe_loader_drm_device *ddev = pipe_loader_drm_device(dev);
 
+   if (!pipe_loader_drm_load_driver(ddev))
+      return NULL;
+
    return ddev->dd->create_screen(ddev->fd);
 }
 
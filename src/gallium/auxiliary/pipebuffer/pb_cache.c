@@ -27,6 +27,7 @@
  **************************************************************************/
 
 #include "pb_cache.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_time.h"
 
@@ -49,21 +50,24 @@ destroy_buffer_locked(struct pb_cache_entry *entry)
    entry->mgr->destroy_buffer(entry->buffer);
 }
 
+static unsigned
+pb_cache_get_bucket_index(pb_size size)
+{
+   return MIN2(util_last_bit64(size), PB_CACHE_NUM_BUCKETS - 1);
+}
+
 /**
- * Free as many cache buffers from the list head as possible.
+ * Free as many cache buffers from the head of a bucket as possible.
  */
 static void
-release_expired_buffers_locked(struct pb_cache *mgr)
+release_expired_bucket_locked(struct list_head *bucket, int64_t now)
 {
    struct list_head *curr, *next;
    struct pb_cache_entry *entry;
-   int64_t now;
-
-   now = os_time_get();
 
-   curr = mgr->cache.next;
+   curr = bucket->next;
    next = curr->next;
-   while (curr != &mgr->cache) {
+   while (curr != bucket) {
       entry = LIST_ENTRY(struct pb_cache_entry, curr, head);
 
       if (!os_time_timeout(entry->start, entry->end, now))
@@ -76,6 +80,16 @@ release_expired_buffers_locked(struct pb_cache *mgr)
    }
 }
 
+static void
+release_expired_buffers_locked(struct pb_cache *mgr)
+{
+   int64_t now = os_time_get();
+   unsigned i;
+
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++)
+      release_expired_bucket_locked(&mgr->buckets[i], now);
+}
+
 /**
  * Add a buffer to the cache. This is typically done when the buffer is
  * being released.
@@ -99,7 +113,8 @@ pb_cache_add_buffer(struct pb_cache_entry *entry)
 
    entry->start = os_time_get();
    entry->end = entry->start + mgr->usecs;
-   LIST_ADDTAIL(&entry->head, &mgr->cache);
+   LIST_ADDTAIL(&entry->head,
+                &mgr->buckets[pb_cache_get_bucket_index(entry->buffer->size)]);
    ++mgr->num_buffers;
    mgr->cache_size += entry->buffer->size;
    pipe_mutex_unlock(mgr->mutex);
@@ -116,9 +131,6 @@ pb_cache_is_buffer_compat(struct pb_cache_entry *entry,
 {
    struct pb_buffer *buf = entry->buffer;
 
-   if (usage & entry->mgr->bypass_usage)
-      return 0;
-
    if (buf->size < size)
       return 0;
 
@@ -136,63 +148,72 @@ pb_cache_is_buffer_compat(struct pb_cache_entry *entry,
 }
 
 /**
- * Find a compatible buffer in the cache, return it, and remove it
- * from the cache.
+ * Look for a compatible buffer in one bucket, freeing the expired buffers
+ * in the process.
  */
-struct pb_buffer *
-pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
-                        unsigned alignment, unsigned usage)
+static struct pb_cache_entry *
+pb_cache_reclaim_from_bucket(struct list_head *bucket, pb_size size,
+                             unsigned alignment, unsigned usage, int64_t now)
 {
-   struct pb_cache_entry *entry;
    struct pb_cache_entry *cur_entry;
    struct list_head *cur, *next;
-   int64_t now;
-   int ret = 0;
-
-   pipe_mutex_lock(mgr->mutex);
+   bool expired = true;
+   int ret;
 
-   entry = NULL;
-   cur = mgr->cache.next;
+   cur = bucket->next;
    next = cur->next;
-
-   /* search in the expired buffers, freeing them in the process */
-   now = os_time_get();
-   while (cur != &mgr->cache) {
+   while (cur != bucket) {
       cur_entry = LIST_ENTRY(struct pb_cache_entry, cur, head);
+      ret = pb_cache_is_buffer_compat(cur_entry, size, alignment, usage);
 
-      if (!entry && (ret = pb_cache_is_buffer_compat(cur_entry, size,
-                                                     alignment, usage) > 0))
-         entry = cur_entry;
-      else if (os_time_timeout(cur_entry->start, cur_entry->end, now))
-         destroy_buffer_locked(cur_entry);
-      else
-         /* This buffer (and all hereafter) are still hot in cache */
-         break;
+      if (ret > 0)
+         return cur_entry;
 
       /* the buffer is busy (and probably all remaining ones too) */
       if (ret == -1)
-         break;
+         return NULL;
+
+      /* Buffers after the first hot one are hot too. */
+      if (expired) {
+         expired = os_time_timeout(cur_entry->start, cur_entry->end, now);
+         if (expired)
+            destroy_buffer_locked(cur_entry);
+      }
 
       cur = next;
       next = cur->next;
    }
 
-   /* keep searching in the hot buffers */
-   if (!entry && ret != -1) {
-      while (cur != &mgr->cache) {
-         cur_entry = LIST_ENTRY(struct pb_cache_entry, cur, head);
-         ret = pb_cache_is_buffer_compat(cur_entry, size, alignment, usage);
-
-         if (ret > 0) {
-            entry = cur_entry;
-            break;
-         }
-         if (ret == -1)
-            break;
-         /* no need to check the timeout here */
-         cur = next;
-         next = cur->next;
-      }
+   return NULL;
+}
+
+/**
+ * Find a compatible buffer in the cache, return it, and remove it
+ * from the cache.
+ *
+ * Only the buckets of the size classes allowed by size_factor are searched,
+ * starting with the smallest one.
+ */
+struct pb_buffer *
+pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
+                        unsigned alignment, unsigned usage)
+{
+   struct pb_cache_entry *entry = NULL;
+   unsigned first, last, i;
+   int64_t now;
+
+   if (usage & mgr->bypass_usage)
+      return NULL;
+
+   first = pb_cache_get_bucket_index(size);
+   last = pb_cache_get_bucket_index((pb_size)(mgr->size_factor * size));
+
+   pipe_mutex_lock(mgr->mutex);
+
+   now = os_time_get();
+   for (i = first; i <= last && !entry; i++) {
+      entry = pb_cache_reclaim_from_bucket(&mgr->buckets[i], size,
+                                           alignment, usage, now);
    }
 
    /* found a compatible buffer, return it */
@@ -220,15 +241,20 @@ pb_cache_release_all_buffers(struct pb_cache *mgr)
 {
    struct list_head *curr, *next;
    struct pb_cache_entry *buf;
+   unsigned i;
 
    pipe_mutex_lock(mgr->mutex);
-   curr = mgr->cache.next;
-   next = curr->next;
-   while (curr != &mgr->cache) {
-      buf = LIST_ENTRY(struct pb_cache_entry, curr, head);
-      destroy_buffer_locked(buf);
-      curr = next;
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++) {
+      struct list_head *bucket = &mgr->buckets[i];
+
+      curr = bucket->next;
       next = curr->next;
+      while (curr != bucket) {
+         buf = LIST_ENTRY(struct pb_cache_entry, curr, head);
+         destroy_buffer_locked(buf);
+         curr = next;
+         next = curr->next;
+      }
    }
    pipe_mutex_unlock(mgr->mutex);
 }
@@ -263,7 +289,11 @@ pb_cache_init(struct pb_cache *mgr, uint usecs, float size_factor,
               void (*destroy_buffer)(struct pb_buffer *buf),
               bool (*can_reclaim)(struct pb_buffer *buf))
 {
-   LIST_INITHEAD(&mgr->cache);
+   unsigned i;
+
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++)
+      LIST_INITHEAD(&mgr->buckets[i]);
+
    pipe_mutex_init(mgr->mutex);
    mgr->cache_size = 0;
    mgr->max_cache_size = maximum_cache_size;
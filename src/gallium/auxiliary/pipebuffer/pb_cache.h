@@ -44,9 +44,16 @@ struct pb_cache_entry
    int64_t start, end; /**< Caching time interval */
 };
 
+/**
+ * Cached buffers are sorted into buckets by size class, bucket i holding
+ * buffers whose size is in [2^(i-1), 2^i). Each bucket is ordered from the
+ * least recently added buffer.
+ */
+#define PB_CACHE_NUM_BUCKETS 64
+
 struct pb_cache
 {
-   struct list_head cache;
+   struct list_head buckets[PB_CACHE_NUM_BUCKETS];
    pipe_mutex mutex;
    uint64_t cache_size;
    uint64_t max_cache_size;
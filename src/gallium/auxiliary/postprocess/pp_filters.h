@@ -45,6 +45,8 @@
 
 void pp_filter_setup_in(struct pp_program *, struct pipe_resource *);
 void pp_filter_setup_out(struct pp_program *, struct pipe_resource *);
+void pp_filter_setup_in_view(struct pp_program *, struct pipe_sampler_view *);
+void pp_filter_setup_out_surface(struct pp_program *, struct pipe_surface *);
 void pp_filter_end_pass(struct pp_program *);
 void *pp_tgsi_to_state(struct pipe_context *, const char *, bool,
                        const char *);
@@ -91,8 +91,8 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    assert(p);
    assert(ppq);
    assert(ppq->constbuf);
-   assert(ppq->areamaptex);
-   assert(ppq->inner_tmp);
+   assert(ppq->areamap_view);
+   assert(ppq->inner_tmp_views[0] && ppq->inner_tmp_views[1]);
    assert(ppq->shaders[n]);
 
    w = p->framebuffer.width;
@@ -133,7 +133,7 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    else
       pp_filter_setup_in(p, ppq->depth);
 
-   pp_filter_setup_out(p, ppq->inner_tmp[0]);
+   pp_filter_setup_out_surface(p, ppq->inner_tmps[0]);
 
    pp_filter_set_fb(p);
    pp_filter_misc_state(p);
@@ -160,13 +160,10 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    mstencil.stencil[0].zpass_op = PIPE_STENCIL_OP_KEEP;
    cso_set_depth_stencil_alpha(p->cso, &mstencil);
 
-   pp_filter_setup_in(p, ppq->areamaptex);
-   pp_filter_setup_out(p, ppq->inner_tmp[1]);
+   pp_filter_setup_in_view(p, ppq->areamap_view);
+   pp_filter_setup_out_surface(p, ppq->inner_tmps[1]);
 
-   u_sampler_view_default_template(&v_tmp, ppq->inner_tmp[0],
-                                   ppq->inner_tmp[0]->format);
-   arr[1] = arr[2] = p->pipe->create_sampler_view(p->pipe,
-                                                  ppq->inner_tmp[0], &v_tmp);
+   arr[1] = arr[2] = ppq->inner_tmp_views[0];
 
    pp_filter_set_clear_fb(p);
 
@@ -184,12 +181,11 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
 
    pp_filter_draw(p);
    pp_filter_end_pass(p);
-   pipe_sampler_view_reference(&arr[1], NULL);
 
 
    /* Third pass: smoothed edges */
    /* Sampler order: colormap, blendmap (wtf compiler) */
-   pp_filter_setup_in(p, ppq->inner_tmp[1]);
+   pp_filter_setup_in_view(p, ppq->inner_tmp_views[1]);
    pp_filter_setup_out(p, out);
 
    pp_filter_set_fb(p);
@@ -233,6 +229,7 @@ pp_jimenezmlaa_init_run(struct pp_queue_t *ppq, unsigned int n,
 
    struct pipe_box box;
    struct pipe_resource res;
+   struct pipe_sampler_view v_tmp;
    char *tmp_text = NULL;
 
    tmp_text = CALLOC(sizeof(blend2fs_1) + sizeof(blend2fs_2) +
@@ -284,6 +281,16 @@ pp_jimenezmlaa_init_run(struct pp_queue_t *ppq, unsigned int n,
                                        PIPE_TRANSFER_WRITE, &box,
                                        areamap, 165 * 2, sizeof(areamap));
 
+   u_sampler_view_default_template(&v_tmp, ppq->areamaptex,
+                                   ppq->areamaptex->format);
+   ppq->areamap_view = ppq->p->pipe->create_sampler_view(ppq->p->pipe,
+                                                         ppq->areamaptex,
+                                                         &v_tmp);
+   if (ppq->areamap_view == NULL) {
+      pp_debug("Failed to create the area map sampler view\n");
+      goto fail;
+   }
+
    ppq->shaders[n][1] = pp_tgsi_to_state(ppq->p->pipe, offsetvs, true,
                                          "offsetvs");
    if (iscolor)
@@ -356,6 +363,8 @@ pp_jimenezmlaa_color(struct pp_queue_t *ppq, struct pipe_resource *in,
 void
 pp_jimenezmlaa_free(struct pp_queue_t *ppq, unsigned int n)
 {
+   pipe_sampler_view_reference(&ppq->areamap_view, NULL);
+
    if (ppq->areamaptex) {
       ppq->p->screen->resource_destroy(ppq->p->screen, ppq->areamaptex);
       ppq->areamaptex = NULL;
@@ -80,6 +80,8 @@ struct pp_queue_t
    struct pipe_resource *areamaptex;    /* MLAA area map texture */
 
    struct pipe_surface *tmps[2], *inner_tmps[3], *stencils;
+   struct pipe_sampler_view *inner_tmp_views[3];
+   struct pipe_sampler_view *areamap_view;
 
    void ***shaders;             /* Shaders in TGSI form */
    unsigned int *filters;       /* Active filter to filters.h mapping. */
@@ -218,6 +218,20 @@ pp_filter_setup_out(struct pp_program *p, struct pipe_resource *out)
    p->framebuffer.cbufs[0] = p->pipe->create_surface(p->pipe, out, &p->surf);
 }
 
+/** Setup an existing sampler view as the filter input. */
+void
+pp_filter_setup_in_view(struct pp_program *p, struct pipe_sampler_view *view)
+{
+   pipe_sampler_view_reference(&p->view, view);
+}
+
+/** Setup an existing surface as the filter output. */
+void
+pp_filter_setup_out_surface(struct pp_program *p, struct pipe_surface *surf)
+{
+   pipe_surface_reference(&p->framebuffer.cbufs[0], surf);
+}
+
 /** Clean up the input and output set with the above. */
 void
 pp_filter_end_pass(struct pp_program *p)
@@ -15,6 +15,10 @@
 #include "ddebug/dd_public.h"
 #endif
 
+#ifdef GALLIUM_THREADED
+#include "threaded/tc_public.h"
+#endif
+
 #ifdef GALLIUM_TRACE
 #include "trace/tr_public.h"
 #endif
@@ -38,6 +42,10 @@ debug_screen_wrap(struct pipe_screen *screen)
    screen = ddebug_screen_create(screen);
 #endif
 
+#if defined(GALLIUM_THREADED)
+   screen = threaded_screen_create(screen);
+#endif
+
 #if defined(GALLIUM_RBUG)
    screen = rbug_screen_create(screen);
 #endif
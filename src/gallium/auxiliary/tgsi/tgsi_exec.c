@@ -63,6 +63,21 @@
 #include "util/u_math.h"
 
 
+#if defined(PIPE_ARCH_SSE)
+#include <emmintrin.h>
+
+/*
+ * The micro ops of the common ALU opcodes have SSE2 versions working on a
+ * whole channel at once.  They give the same results as the C versions,
+ * NaNs included.  The channels aren't necessarily 16 byte aligned.
+ */
+#define CHAN_LOAD(c)       _mm_loadu_ps((c)->f)
+#define CHAN_STORE(c, v)   _mm_storeu_ps((c)->f, (v))
+#define CHAN_LOADI(c)      _mm_loadu_si128((const __m128i *)(c)->i)
+#define CHAN_STOREI(c, v)  _mm_storeu_si128((__m128i *)(c)->i, (v))
+#endif
+
+
 #define DEBUG_EXECUTION 0
 
 
@@ -87,10 +102,14 @@ static void
 micro_abs(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, _mm_and_si128(CHAN_LOADI(src), _mm_set1_epi32(0x7fffffff)));
+#else
    dst->f[0] = fabsf(src->f[0]);
    dst->f[1] = fabsf(src->f[1]);
    dst->f[2] = fabsf(src->f[2]);
    dst->f[3] = fabsf(src->f[3]);
+#endif
 }
 
 static void
@@ -129,10 +148,18 @@ micro_clamp(union tgsi_exec_channel *dst,
             const union tgsi_exec_channel *src1,
             const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 a = CHAN_LOAD(src0);
+   const __m128 lo = CHAN_LOAD(src1);
+   const __m128 r = _mm_min_ps(CHAN_LOAD(src2), a);
+   const __m128 m = _mm_cmplt_ps(a, lo);
+   CHAN_STORE(dst, _mm_or_ps(_mm_and_ps(m, lo), _mm_andnot_ps(m, r)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? src1->f[0] : src0->f[0] > src2->f[0] ? src2->f[0] : src0->f[0];
    dst->f[1] = src0->f[1] < src1->f[1] ? src1->f[1] : src0->f[1] > src2->f[1] ? src2->f[1] : src0->f[1];
    dst->f[2] = src0->f[2] < src1->f[2] ? src1->f[2] : src0->f[2] > src2->f[2] ? src2->f[2] : src0->f[2];
    dst->f[3] = src0->f[3] < src1->f[3] ? src1->f[3] : src0->f[3] > src2->f[3] ? src2->f[3] : src0->f[3];
+#endif
 }
 
 static void
@@ -141,10 +168,16 @@ micro_cmp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 m = _mm_cmplt_ps(CHAN_LOAD(src0), _mm_setzero_ps());
+   CHAN_STORE(dst, _mm_or_ps(_mm_and_ps(m, CHAN_LOAD(src1)),
+                             _mm_andnot_ps(m, CHAN_LOAD(src2))));
+#else
    dst->f[0] = src0->f[0] < 0.0f ? src1->f[0] : src2->f[0];
    dst->f[1] = src0->f[1] < 0.0f ? src1->f[1] : src2->f[1];
    dst->f[2] = src0->f[2] < 0.0f ? src1->f[2] : src2->f[2];
    dst->f[3] = src0->f[3] < 0.0f ? src1->f[3] : src2->f[3];
+#endif
 }
 
 static void
@@ -495,10 +528,17 @@ micro_lrp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 c = CHAN_LOAD(src2);
+   CHAN_STORE(dst, _mm_add_ps(_mm_mul_ps(CHAN_LOAD(src0),
+                                         _mm_sub_ps(CHAN_LOAD(src1), c)),
+                              c));
+#else
    dst->f[0] = src0->f[0] * (src1->f[0] - src2->f[0]) + src2->f[0];
    dst->f[1] = src0->f[1] * (src1->f[1] - src2->f[1]) + src2->f[1];
    dst->f[2] = src0->f[2] * (src1->f[2] - src2->f[2]) + src2->f[2];
    dst->f[3] = src0->f[3] * (src1->f[3] - src2->f[3]) + src2->f[3];
+#endif
 }
 
 static void
@@ -507,26 +547,38 @@ micro_mad(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_add_ps(_mm_mul_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)),
+                              CHAN_LOAD(src2)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0] + src2->f[0];
    dst->f[1] = src0->f[1] * src1->f[1] + src2->f[1];
    dst->f[2] = src0->f[2] * src1->f[2] + src2->f[2];
    dst->f[3] = src0->f[3] * src1->f[3] + src2->f[3];
+#endif
 }
 
 static void
 micro_mov(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, CHAN_LOADI(src));
+#else
    dst->u[0] = src->u[0];
    dst->u[1] = src->u[1];
    dst->u[2] = src->u[2];
    dst->u[3] = src->u[3];
+#endif
 }
 
 static void
 micro_rcp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_div_ps(_mm_set1_ps(1.0f), CHAN_LOAD(src)));
+#else
 #if 0 /* for debugging */
    assert(src->f[0] != 0.0f);
    assert(src->f[1] != 0.0f);
@@ -537,6 +589,7 @@ micro_rcp(union tgsi_exec_channel *dst,
    dst->f[1] = 1.0f / src->f[1];
    dst->f[2] = 1.0f / src->f[2];
    dst->f[3] = 1.0f / src->f[3];
+#endif
 }
 
 static void
@@ -553,6 +606,9 @@ static void
 micro_rsq(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(CHAN_LOAD(src))));
+#else
 #if 0 /* for debugging */
    assert(src->f[0] != 0.0f);
    assert(src->f[1] != 0.0f);
@@ -563,16 +619,21 @@ micro_rsq(union tgsi_exec_channel *dst,
    dst->f[1] = 1.0f / sqrtf(src->f[1]);
    dst->f[2] = 1.0f / sqrtf(src->f[2]);
    dst->f[3] = 1.0f / sqrtf(src->f[3]);
+#endif
 }
 
 static void
 micro_sqrt(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_sqrt_ps(CHAN_LOAD(src)));
+#else
    dst->f[0] = sqrtf(src->f[0]);
    dst->f[1] = sqrtf(src->f[1]);
    dst->f[2] = sqrtf(src->f[2]);
    dst->f[3] = sqrtf(src->f[3]);
+#endif
 }
 
 static void
@@ -580,10 +641,15 @@ micro_seq(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_and_ps(_mm_cmpeq_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)),
+                              _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] == src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] == src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] == src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] == src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -591,10 +657,15 @@ micro_sge(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_and_ps(_mm_cmpge_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)),
+                              _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] >= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] >= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] >= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] >= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -622,10 +693,15 @@ micro_sgt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_and_ps(_mm_cmpgt_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)),
+                              _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] > src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] > src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] > src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -643,10 +719,15 @@ micro_sle(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_and_ps(_mm_cmple_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)),
+                              _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] <= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] <= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] <= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] <= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -654,10 +735,15 @@ micro_slt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_and_ps(_mm_cmplt_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)),
+                              _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] < src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] < src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] < src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -665,10 +751,15 @@ micro_sne(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_and_ps(_mm_cmpneq_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)),
+                              _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] != src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] != src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] != src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] != src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -1035,6 +1126,65 @@ tgsi_exec_machine_bind_shader(
 }
 
 
+/**
+ * Bind the shader that is bound to another machine, without parsing
+ * the tokens again.  The decoded declarations and instructions are
+ * duplicated, so both machines stay independent.
+ */
+void
+tgsi_exec_machine_copy_shader(
+   struct tgsi_exec_machine *mach,
+   const struct tgsi_exec_machine *src)
+{
+   struct tgsi_full_instruction *instructions;
+   struct tgsi_full_declaration *declarations;
+
+   assert(mach->ShaderType == src->ShaderType);
+
+   /* Geometry shaders also allocate their inputs at bind time. */
+   if (mach->ShaderType == PIPE_SHADER_GEOMETRY || !src->Tokens) {
+      tgsi_exec_machine_bind_shader(mach, src->Tokens, src->Sampler,
+                                    src->Image, src->Buffer);
+      return;
+   }
+
+   declarations = (struct tgsi_full_declaration *)
+      MALLOC(MAX2(src->NumDeclarations, 1) * sizeof(*declarations));
+   instructions = (struct tgsi_full_instruction *)
+      MALLOC(MAX2(src->NumInstructions, 1) * sizeof(*instructions));
+
+   if (!declarations || !instructions) {
+      FREE(declarations);
+      FREE(instructions);
+      return;
+   }
+
+   memcpy(declarations, src->Declarations,
+          src->NumDeclarations * sizeof(*declarations));
+   memcpy(instructions, src->Instructions,
+          src->NumInstructions * sizeof(*instructions));
+
+   mach->Tokens = src->Tokens;
+   mach->Sampler = src->Sampler;
+   mach->Image = src->Image;
+   mach->Buffer = src->Buffer;
+
+   mach->ImmLimit = src->ImmLimit;
+   memcpy(mach->Imms, src->Imms, src->ImmLimit * sizeof(mach->Imms[0]));
+   mach->NumOutputs = src->NumOutputs;
+   memcpy(mach->SysSemanticToIndex, src->SysSemanticToIndex,
+          sizeof(mach->SysSemanticToIndex));
+
+   FREE(mach->Declarations);
+   mach->Declarations = declarations;
+   mach->NumDeclarations = src->NumDeclarations;
+
+   FREE(mach->Instructions);
+   mach->Instructions = instructions;
+   mach->NumInstructions = src->NumInstructions;
+}
+
+
 struct tgsi_exec_machine *
 tgsi_exec_machine_create(enum pipe_shader_type shader_type)
 {
@@ -1110,10 +1260,14 @@ micro_add(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_add_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->f[0] = src0->f[0] + src1->f[0];
    dst->f[1] = src0->f[1] + src1->f[1];
    dst->f[2] = src0->f[2] + src1->f[2];
    dst->f[3] = src0->f[3] + src1->f[3];
+#endif
 }
 
 static void
@@ -1155,10 +1309,14 @@ micro_max(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_max_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] > src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] > src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] > src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1166,10 +1324,14 @@ micro_min(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_min_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] < src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] < src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] < src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1177,10 +1339,14 @@ micro_mul(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_mul_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0];
    dst->f[1] = src0->f[1] * src1->f[1];
    dst->f[2] = src0->f[2] * src1->f[2];
    dst->f[3] = src0->f[3] * src1->f[3];
+#endif
 }
 
 static void
@@ -1188,10 +1354,14 @@ micro_neg(
    union tgsi_exec_channel *dst,
    const union tgsi_exec_channel *src )
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, _mm_xor_si128(CHAN_LOADI(src), _mm_set1_epi32(0x80000000)));
+#else
    dst->f[0] = -src->f[0];
    dst->f[1] = -src->f[1];
    dst->f[2] = -src->f[2];
    dst->f[3] = -src->f[3];
+#endif
 }
 
 static void
@@ -1218,10 +1388,27 @@ micro_sub(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_sub_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->f[0] = src0->f[0] - src1->f[0];
    dst->f[1] = src0->f[1] - src1->f[1];
    dst->f[2] = src0->f[2] - src1->f[2];
    dst->f[3] = src0->f[3] - src1->f[3];
+#endif
+}
+
+/**
+ * Whether all four lanes use the same register index, which is the case
+ * unless the register is indirectly addressed.  Such fetches copy whole
+ * channels.
+ */
+static inline boolean
+index_is_uniform(const union tgsi_exec_channel *index)
+{
+   return index->i[0] == index->i[1] &&
+          index->i[0] == index->i[2] &&
+          index->i[0] == index->i[3];
 }
 
 static void
@@ -1268,6 +1455,13 @@ fetch_src_file_channel(const struct tgsi_exec_machine *mach,
       break;
 
    case TGSI_FILE_INPUT:
+      if (index_is_uniform(index) && index_is_uniform(index2D)) {
+         const int pos = index2D->i[0] * TGSI_EXEC_MAX_INPUT_ATTRIBS + index->i[0];
+         assert(pos >= 0);
+         assert(pos < TGSI_MAX_PRIM_VERTICES * PIPE_MAX_ATTRIBS);
+         *chan = mach->Inputs[pos].xyzw[swizzle];
+         break;
+      }
       for (i = 0; i < TGSI_QUAD_SIZE; i++) {
          /*
          if (PIPE_SHADER_GEOMETRY == mach->ShaderType) {
@@ -1292,6 +1486,13 @@ fetch_src_file_channel(const struct tgsi_exec_machine *mach,
       break;
 
    case TGSI_FILE_TEMPORARY:
+      if (index_is_uniform(index)) {
+         assert(index->i[0] < TGSI_EXEC_NUM_TEMPS);
+         assert(index2D->i[0] == 0);
+
+         *chan = mach->Temps[index->i[0]].xyzw[swizzle];
+         break;
+      }
       for (i = 0; i < TGSI_QUAD_SIZE; i++) {
          assert(index->i[i] < TGSI_EXEC_NUM_TEMPS);
          assert(index2D->i[i] == 0);
@@ -1301,6 +1502,20 @@ fetch_src_file_channel(const struct tgsi_exec_machine *mach,
       break;
 
    case TGSI_FILE_IMMEDIATE:
+      if (index_is_uniform(index)) {
+         assert(index->i[0] >= 0 && index->i[0] < (int)mach->ImmLimit);
+         assert(index2D->i[0] == 0);
+
+#if defined(PIPE_ARCH_SSE)
+         CHAN_STORE(chan, _mm_set1_ps(mach->Imms[index->i[0]][swizzle]));
+#else
+         chan->f[0] =
+         chan->f[1] =
+         chan->f[2] =
+         chan->f[3] = mach->Imms[index->i[0]][swizzle];
+#endif
+         break;
+      }
       for (i = 0; i < TGSI_QUAD_SIZE; i++) {
          assert(index->i[i] >= 0 && index->i[i] < (int)mach->ImmLimit);
          assert(index2D->i[i] == 0);
@@ -4304,20 +4519,28 @@ static void
 micro_i2f(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_cvtepi32_ps(CHAN_LOADI(src)));
+#else
    dst->f[0] = (float)src->i[0];
    dst->f[1] = (float)src->i[1];
    dst->f[2] = (float)src->i[2];
    dst->f[3] = (float)src->i[3];
+#endif
 }
 
 static void
 micro_not(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, _mm_xor_si128(CHAN_LOADI(src), _mm_set1_epi32(~0)));
+#else
    dst->u[0] = ~src->u[0];
    dst->u[1] = ~src->u[1];
    dst->u[2] = ~src->u[2];
    dst->u[3] = ~src->u[3];
+#endif
 }
 
 static void
@@ -4341,10 +4564,14 @@ micro_and(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, _mm_and_si128(CHAN_LOADI(src0), CHAN_LOADI(src1)));
+#else
    dst->u[0] = src0->u[0] & src1->u[0];
    dst->u[1] = src0->u[1] & src1->u[1];
    dst->u[2] = src0->u[2] & src1->u[2];
    dst->u[3] = src0->u[3] & src1->u[3];
+#endif
 }
 
 static void
@@ -4352,10 +4579,14 @@ micro_or(union tgsi_exec_channel *dst,
          const union tgsi_exec_channel *src0,
          const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, _mm_or_si128(CHAN_LOADI(src0), CHAN_LOADI(src1)));
+#else
    dst->u[0] = src0->u[0] | src1->u[0];
    dst->u[1] = src0->u[1] | src1->u[1];
    dst->u[2] = src0->u[2] | src1->u[2];
    dst->u[3] = src0->u[3] | src1->u[3];
+#endif
 }
 
 static void
@@ -4363,10 +4594,14 @@ micro_xor(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, _mm_xor_si128(CHAN_LOADI(src0), CHAN_LOADI(src1)));
+#else
    dst->u[0] = src0->u[0] ^ src1->u[0];
    dst->u[1] = src0->u[1] ^ src1->u[1];
    dst->u[2] = src0->u[2] ^ src1->u[2];
    dst->u[3] = src0->u[3] ^ src1->u[3];
+#endif
 }
 
 static void
@@ -4384,10 +4619,14 @@ static void
 micro_f2i(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STOREI(dst, _mm_cvttps_epi32(CHAN_LOAD(src)));
+#else
    dst->i[0] = (int)src->f[0];
    dst->i[1] = (int)src->f[1];
    dst->i[2] = (int)src->f[2];
    dst->i[3] = (int)src->f[3];
+#endif
 }
 
 static void
@@ -4395,10 +4634,14 @@ micro_fseq(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_cmpeq_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->u[0] = src0->f[0] == src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] == src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] == src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] == src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4406,10 +4649,14 @@ micro_fsge(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_cmpge_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->u[0] = src0->f[0] >= src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] >= src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] >= src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] >= src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4417,10 +4664,14 @@ micro_fslt(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_cmplt_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->u[0] = src0->f[0] < src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] < src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] < src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] < src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -4428,10 +4679,14 @@ micro_fsne(union tgsi_exec_channel *dst,
            const union tgsi_exec_channel *src0,
            const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   CHAN_STORE(dst, _mm_cmpneq_ps(CHAN_LOAD(src0), CHAN_LOAD(src1)));
+#else
    dst->u[0] = src0->f[0] != src1->f[0] ? ~0 : 0;
    dst->u[1] = src0->f[1] != src1->f[1] ? ~0 : 0;
    dst->u[2] = src0->f[2] != src1->f[2] ? ~0 : 0;
    dst->u[3] = src0->f[3] != src1->f[3] ? ~0 : 0;
+#endif
 }
 
 static void
@@ -464,6 +464,11 @@ tgsi_exec_machine_bind_shader(
    struct tgsi_image *image,
    struct tgsi_buffer *buffer);
 
+void
+tgsi_exec_machine_copy_shader(
+   struct tgsi_exec_machine *mach,
+   const struct tgsi_exec_machine *src);
+
 uint
 tgsi_exec_machine_run(
    struct tgsi_exec_machine *mach, int start_pc );
@@ -46,6 +46,12 @@ struct translate *translate_create( const struct translate_key *key )
    (void)translate;
 #endif
 
+#if HAVE_LLVM
+   translate = translate_llvm_create( key );
+   if (translate)
+      return translate;
+#endif
+
    return translate_generic_create( key );
 }
 
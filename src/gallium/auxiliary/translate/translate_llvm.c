@@ -0,0 +1,669 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Translate backend which JIT compiles the whole fetch/convert/emit loop
+ * for a given translate_key with gallivm.
+ *
+ * Unlike translate_sse this works on any architecture LLVM supports, and
+ * it handles any input format lp_build_fetch_rgba_aos can fetch.  Keys
+ * which can't be expressed here (pure integer formats, output formats
+ * without a plain layout) make translate_llvm_create() return NULL, so
+ * that translate_create() falls back to translate_generic.
+ */
+
+#include "util/u_debug.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_format.h"
+#include "util/u_string.h"
+#include "pipe/p_state.h"
+
+#include "gallivm/lp_bld.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_conv.h"
+#include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_flow.h"
+#include "gallivm/lp_bld_format.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_struct.h"
+#include "gallivm/lp_bld_type.h"
+
+#include "translate.h"
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(translate_llvm, "TRANSLATE_USE_LLVM", TRUE)
+
+
+/**
+ * Per vertex buffer state, as seen by the generated code.
+ */
+struct translate_llvm_buffer {
+   const uint8_t *ptr;
+   unsigned stride;
+   unsigned max_index;
+};
+
+enum {
+   TRANSLATE_LLVM_BUFFER_PTR,
+   TRANSLATE_LLVM_BUFFER_STRIDE,
+   TRANSLATE_LLVM_BUFFER_MAX_INDEX,
+   TRANSLATE_LLVM_BUFFER_NUM_FIELDS
+};
+
+typedef void
+(*translate_llvm_run_func)(const struct translate_llvm_buffer *buffers,
+                           const void *elts,
+                           unsigned start,
+                           unsigned count,
+                           unsigned start_instance,
+                           unsigned instance_id,
+                           void *output_buffer);
+
+/** The index sizes a function is generated for, 0 meaning linear. */
+static const unsigned translate_llvm_index_sizes[] = { 0, 1, 2, 4 };
+
+#define TRANSLATE_LLVM_NUM_FUNCS ARRAY_SIZE(translate_llvm_index_sizes)
+
+
+struct translate_llvm {
+   struct translate translate;
+
+   LLVMContextRef context;
+   struct gallivm_state *gallivm;
+
+   translate_llvm_run_func func[TRANSLATE_LLVM_NUM_FUNCS];
+
+   unsigned nr_buffers;
+   struct translate_llvm_buffer buffer[PIPE_MAX_ATTRIBS];
+};
+
+
+static struct translate_llvm *
+translate_llvm(struct translate *translate)
+{
+   return (struct translate_llvm *)translate;
+}
+
+
+static boolean
+is_supported_input_format(const struct util_format_description *desc)
+{
+   if (desc->block.width != 1 || desc->block.height != 1)
+      return FALSE;
+
+   /* lp_build_fetch_rgba_aos only produces floats. */
+   if (util_format_is_pure_integer(desc->format))
+      return FALSE;
+
+   return desc->fetch_rgba_float != NULL;
+}
+
+
+static boolean
+is_supported_output_format(const struct util_format_description *desc)
+{
+   unsigned chan;
+
+   if (desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       desc->block.width != 1 || desc->block.height != 1)
+      return FALSE;
+
+   if (util_format_is_pure_integer(desc->format))
+      return FALSE;
+
+   /* Non-array formats are emitted as a single packed integer. */
+   if (!desc->is_array && desc->block.bits > 32)
+      return FALSE;
+
+   for (chan = 0; chan < desc->nr_channels; chan++) {
+      const struct util_format_channel_description *channel =
+         &desc->channel[chan];
+
+      switch (channel->type) {
+      case UTIL_FORMAT_TYPE_VOID:
+         break;
+      case UTIL_FORMAT_TYPE_FLOAT:
+         if (channel->size != 16 && channel->size != 32 && channel->size != 64)
+            return FALSE;
+         break;
+      case UTIL_FORMAT_TYPE_UNSIGNED:
+      case UTIL_FORMAT_TYPE_SIGNED:
+         if (channel->size > 32)
+            return FALSE;
+         break;
+      case UTIL_FORMAT_TYPE_FIXED:
+         if (channel->size != 32)
+            return FALSE;
+         break;
+      default:
+         return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Convert one float component into the integer bit pattern of a channel,
+ * following the same rules as translate_generic's emit functions.
+ */
+static LLVMValueRef
+emit_channel(struct gallivm_state *gallivm,
+             const struct util_format_channel_description *channel,
+             LLVMValueRef value)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef int_type = LLVMIntTypeInContext(gallivm->context,
+                                               channel->size);
+
+   switch (channel->type) {
+   case UTIL_FORMAT_TYPE_FLOAT:
+      if (channel->size == 16)
+         return lp_build_float_to_half(gallivm, value);
+      if (channel->size == 64)
+         value = LLVMBuildFPExt(builder, value,
+                                LLVMDoubleTypeInContext(gallivm->context), "");
+      return LLVMBuildBitCast(builder, value, int_type, "");
+
+   case UTIL_FORMAT_TYPE_UNSIGNED:
+      if (channel->normalized) {
+         double scale = (double)((1ULL << channel->size) - 1);
+         value = LLVMBuildFMul(builder, value,
+                               lp_build_const_float(gallivm, scale), "");
+      }
+      return LLVMBuildFPToUI(builder, value, int_type, "");
+
+   case UTIL_FORMAT_TYPE_SIGNED:
+      if (channel->normalized) {
+         double scale = (double)((1ULL << (channel->size - 1)) - 1);
+         value = LLVMBuildFMul(builder, value,
+                               lp_build_const_float(gallivm, scale), "");
+      }
+      return LLVMBuildFPToSI(builder, value, int_type, "");
+
+   case UTIL_FORMAT_TYPE_FIXED:
+      value = LLVMBuildFMul(builder, value,
+                            lp_build_const_float(gallivm, 65536.0), "");
+      return LLVMBuildFPToSI(builder, value, int_type, "");
+
+   default:
+      assert(0);
+      return LLVMGetUndef(int_type);
+   }
+}
+
+
+/**
+ * Store a float4 AoS value to dst in the given (plain) format.
+ */
+static void
+emit_rgba(struct gallivm_state *gallivm,
+          const struct util_format_description *desc,
+          LLVMValueRef rgba,
+          LLVMValueRef dst)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef block_type = LLVMIntTypeInContext(gallivm->context,
+                                                 desc->block.bits);
+   LLVMValueRef packed = NULL;
+   unsigned byte_offset = 0;
+   unsigned chan, comp;
+
+   for (chan = 0; chan < desc->nr_channels; chan++) {
+      const struct util_format_channel_description *channel =
+         &desc->channel[chan];
+      LLVMValueRef value;
+
+      if (channel->type == UTIL_FORMAT_TYPE_VOID) {
+         byte_offset += channel->size / 8;
+         continue;
+      }
+
+      for (comp = 0; comp < 4; comp++) {
+         if (desc->swizzle[comp] == chan)
+            break;
+      }
+
+      if (comp < 4)
+         value = LLVMBuildExtractElement(builder, rgba,
+                                         lp_build_const_int32(gallivm, comp),
+                                         "");
+      else
+         value = lp_build_const_float(gallivm, 0.0);
+
+      value = emit_channel(gallivm, channel, value);
+
+      if (desc->is_array) {
+         LLVMValueRef offset = lp_build_const_int32(gallivm, byte_offset);
+         LLVMValueRef ptr = LLVMBuildGEP(builder, dst, &offset, 1, "");
+         LLVMValueRef store;
+
+         ptr = LLVMBuildBitCast(builder, ptr,
+                                LLVMPointerType(LLVMTypeOf(value), 0), "");
+         store = LLVMBuildStore(builder, value, ptr);
+         LLVMSetAlignment(store, 1);
+         byte_offset += channel->size / 8;
+      }
+      else {
+         value = LLVMBuildZExtOrBitCast(builder, value, block_type, "");
+         value = LLVMBuildShl(builder, value,
+                              LLVMConstInt(block_type, channel->shift, 0), "");
+         packed = packed ? LLVMBuildOr(builder, packed, value, "") : value;
+      }
+   }
+
+   if (packed) {
+      LLVMValueRef ptr = LLVMBuildBitCast(builder, dst,
+                                          LLVMPointerType(block_type, 0), "");
+      LLVMValueRef store = LLVMBuildStore(builder, packed, ptr);
+      LLVMSetAlignment(store, 1);
+   }
+}
+
+
+/**
+ * Generate the code translating all elements of a single vertex.
+ */
+static void
+generate_vertex(struct gallivm_state *gallivm,
+                const struct translate_key *key,
+                LLVMValueRef buffers,
+                LLVMValueRef elt,
+                LLVMValueRef start_instance,
+                LLVMValueRef instance_id,
+                LLVMValueRef vert)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i32_type = LLVMInt32TypeInContext(gallivm->context);
+   LLVMTypeRef i64_type = LLVMInt64TypeInContext(gallivm->context);
+   LLVMValueRef zero = lp_build_const_int32(gallivm, 0);
+   unsigned i;
+
+   for (i = 0; i < key->nr_elements; i++) {
+      const struct translate_element *element = &key->element[i];
+      const struct util_format_description *out_desc =
+         util_format_description(element->output_format);
+      LLVMValueRef offset = lp_build_const_int32(gallivm,
+                                                 element->output_offset);
+      LLVMValueRef dst = LLVMBuildGEP(builder, vert, &offset, 1, "");
+      LLVMValueRef rgba;
+
+      if (element->type == TRANSLATE_ELEMENT_INSTANCE_ID) {
+         if (element->output_format == PIPE_FORMAT_R32_USCALED ||
+             element->output_format == PIPE_FORMAT_R32_SSCALED) {
+            LLVMValueRef ptr =
+               LLVMBuildBitCast(builder, dst,
+                                LLVMPointerType(i32_type, 0), "");
+            LLVMValueRef store = LLVMBuildStore(builder, instance_id, ptr);
+            LLVMSetAlignment(store, 1);
+            continue;
+         }
+
+         rgba = lp_build_const_vec(gallivm, lp_float32_vec4_type(), 0);
+         rgba = LLVMBuildInsertElement(builder, rgba,
+                                       LLVMBuildUIToFP(builder, instance_id,
+                                          LLVMFloatTypeInContext(gallivm->context),
+                                          ""),
+                                       zero, "");
+      }
+      else {
+         const struct util_format_description *in_desc =
+            util_format_description(element->input_format);
+         LLVMValueRef buf_index = lp_build_const_int32(gallivm,
+                                                       element->input_buffer);
+         LLVMValueRef buffer = LLVMBuildGEP(builder, buffers,
+                                            &buf_index, 1, "");
+         LLVMValueRef ptr, stride, index, src;
+
+         ptr = lp_build_struct_get(gallivm, buffer,
+                                   TRANSLATE_LLVM_BUFFER_PTR, "ptr");
+         stride = lp_build_struct_get(gallivm, buffer,
+                                      TRANSLATE_LLVM_BUFFER_STRIDE, "stride");
+
+         if (element->instance_divisor) {
+            index = LLVMBuildUDiv(builder, instance_id,
+                                  lp_build_const_int32(gallivm,
+                                     element->instance_divisor), "");
+            index = LLVMBuildAdd(builder, start_instance, index, "");
+         }
+         else {
+            LLVMValueRef max_index =
+               lp_build_struct_get(gallivm, buffer,
+                                   TRANSLATE_LLVM_BUFFER_MAX_INDEX,
+                                   "max_index");
+            /* clamp to avoid going out of bounds */
+            index = LLVMBuildSelect(builder,
+                                    LLVMBuildICmp(builder, LLVMIntULT,
+                                                  elt, max_index, ""),
+                                    elt, max_index, "");
+         }
+
+         /* Do the offset arithmetic in 64 bits, like translate_generic. */
+         offset = LLVMBuildMul(builder,
+                               LLVMBuildZExt(builder, stride, i64_type, ""),
+                               LLVMBuildZExt(builder, index, i64_type, ""),
+                               "");
+         offset = LLVMBuildAdd(builder, offset,
+                               LLVMConstInt(i64_type,
+                                            element->input_offset, 0), "");
+         src = LLVMBuildGEP(builder, ptr, &offset, 1, "");
+
+         if (element->input_format == element->output_format &&
+             !(in_desc->block.bits & 7)) {
+            LLVMTypeRef copy_type =
+               LLVMVectorType(LLVMInt8TypeInContext(gallivm->context),
+                              in_desc->block.bits / 8);
+            LLVMValueRef value, store;
+
+            src = LLVMBuildBitCast(builder, src,
+                                   LLVMPointerType(copy_type, 0), "");
+            dst = LLVMBuildBitCast(builder, dst,
+                                   LLVMPointerType(copy_type, 0), "");
+            value = LLVMBuildLoad(builder, src, "");
+            LLVMSetAlignment(value, 1);
+            store = LLVMBuildStore(builder, value, dst);
+            LLVMSetAlignment(store, 1);
+            continue;
+         }
+
+         rgba = lp_build_fetch_rgba_aos(gallivm, in_desc,
+                                        lp_float32_vec4_type(), FALSE,
+                                        src, zero, zero, zero, NULL);
+      }
+
+      emit_rgba(gallivm, out_desc, rgba, dst);
+   }
+}
+
+
+/**
+ * Generate a function translating count vertices, either linearly starting
+ * at start, or through an index buffer of index_size bytes per index.
+ */
+static LLVMValueRef
+generate_run(struct gallivm_state *gallivm,
+             const struct translate_key *key,
+             unsigned index_size)
+{
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i8_ptr_type = LLVMPointerType(LLVMInt8TypeInContext(context), 0);
+   LLVMTypeRef i32_type = LLVMInt32TypeInContext(context);
+   LLVMTypeRef buffer_elem_types[TRANSLATE_LLVM_BUFFER_NUM_FIELDS];
+   LLVMTypeRef buffer_type;
+   LLVMTypeRef arg_types[7];
+   LLVMValueRef func, buffers, elts, start, count;
+   LLVMValueRef start_instance, instance_id, output;
+   LLVMBasicBlockRef block;
+   struct lp_build_for_loop_state loop;
+   char func_name[32];
+
+   buffer_elem_types[TRANSLATE_LLVM_BUFFER_PTR] = i8_ptr_type;
+   buffer_elem_types[TRANSLATE_LLVM_BUFFER_STRIDE] = i32_type;
+   buffer_elem_types[TRANSLATE_LLVM_BUFFER_MAX_INDEX] = i32_type;
+   buffer_type = LLVMStructTypeInContext(context, buffer_elem_types,
+                                         ARRAY_SIZE(buffer_elem_types), 0);
+
+   arg_types[0] = LLVMPointerType(buffer_type, 0);  /* buffers */
+   arg_types[1] = i8_ptr_type;                      /* elts */
+   arg_types[2] = i32_type;                         /* start */
+   arg_types[3] = i32_type;                         /* count */
+   arg_types[4] = i32_type;                         /* start_instance */
+   arg_types[5] = i32_type;                         /* instance_id */
+   arg_types[6] = i8_ptr_type;                      /* output_buffer */
+
+   util_snprintf(func_name, sizeof func_name, "translate_run_elts%u",
+                 index_size * 8);
+
+   func = LLVMAddFunction(gallivm->module, func_name,
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           arg_types, ARRAY_SIZE(arg_types),
+                                           0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+
+   buffers = LLVMGetParam(func, 0);
+   elts = LLVMGetParam(func, 1);
+   start = LLVMGetParam(func, 2);
+   count = LLVMGetParam(func, 3);
+   start_instance = LLVMGetParam(func, 4);
+   instance_id = LLVMGetParam(func, 5);
+   output = LLVMGetParam(func, 6);
+
+   lp_build_name(buffers, "buffers");
+   lp_build_name(elts, "elts");
+   lp_build_name(start, "start");
+   lp_build_name(count, "count");
+   lp_build_name(start_instance, "start_instance");
+   lp_build_name(instance_id, "instance_id");
+   lp_build_name(output, "output_buffer");
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   lp_build_for_loop_begin(&loop, gallivm, lp_build_const_int32(gallivm, 0),
+                           LLVMIntULT, count,
+                           lp_build_const_int32(gallivm, 1));
+   {
+      LLVMValueRef elt, vert, offset;
+
+      if (index_size) {
+         LLVMTypeRef index_type = LLVMIntTypeInContext(context,
+                                                       index_size * 8);
+         LLVMValueRef elt_ptr =
+            LLVMBuildBitCast(builder, elts,
+                             LLVMPointerType(index_type, 0), "");
+
+         elt = lp_build_pointer_get(builder, elt_ptr, loop.counter);
+         elt = LLVMBuildZExtOrBitCast(builder, elt, i32_type, "");
+      }
+      else {
+         elt = LLVMBuildAdd(builder, start, loop.counter, "");
+      }
+
+      offset = LLVMBuildMul(builder,
+                            LLVMBuildZExt(builder, loop.counter,
+                                          LLVMInt64TypeInContext(context), ""),
+                            LLVMConstInt(LLVMInt64TypeInContext(context),
+                                         key->output_stride, 0), "");
+      vert = LLVMBuildGEP(builder, output, &offset, 1, "");
+
+      generate_vertex(gallivm, key, buffers, elt, start_instance,
+                      instance_id, vert);
+   }
+   lp_build_for_loop_end(&loop);
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+static void PIPE_CDECL
+llvm_run_elts(struct translate *translate,
+              const unsigned *elts,
+              unsigned count,
+              unsigned start_instance,
+              unsigned instance_id,
+              void *output_buffer)
+{
+   struct translate_llvm *tl = translate_llvm(translate);
+
+   tl->func[3](tl->buffer, elts, 0, count,
+               start_instance, instance_id, output_buffer);
+}
+
+
+static void PIPE_CDECL
+llvm_run_elts16(struct translate *translate,
+                const uint16_t *elts,
+                unsigned count,
+                unsigned start_instance,
+                unsigned instance_id,
+                void *output_buffer)
+{
+   struct translate_llvm *tl = translate_llvm(translate);
+
+   tl->func[2](tl->buffer, elts, 0, count,
+               start_instance, instance_id, output_buffer);
+}
+
+
+static void PIPE_CDECL
+llvm_run_elts8(struct translate *translate,
+               const uint8_t *elts,
+               unsigned count,
+               unsigned start_instance,
+               unsigned instance_id,
+               void *output_buffer)
+{
+   struct translate_llvm *tl = translate_llvm(translate);
+
+   tl->func[1](tl->buffer, elts, 0, count,
+               start_instance, instance_id, output_buffer);
+}
+
+
+static void PIPE_CDECL
+llvm_run(struct translate *translate,
+         unsigned start,
+         unsigned count,
+         unsigned start_instance,
+         unsigned instance_id,
+         void *output_buffer)
+{
+   struct translate_llvm *tl = translate_llvm(translate);
+
+   tl->func[0](tl->buffer, NULL, start, count,
+               start_instance, instance_id, output_buffer);
+}
+
+
+static void
+llvm_set_buffer(struct translate *translate,
+                unsigned buf,
+                const void *ptr,
+                unsigned stride,
+                unsigned max_index)
+{
+   struct translate_llvm *tl = translate_llvm(translate);
+
+   if (buf < tl->nr_buffers) {
+      tl->buffer[buf].ptr = ptr;
+      tl->buffer[buf].stride = stride;
+      tl->buffer[buf].max_index = max_index;
+   }
+}
+
+
+static void
+llvm_release(struct translate *translate)
+{
+   struct translate_llvm *tl = translate_llvm(translate);
+
+   gallivm_destroy(tl->gallivm);
+   LLVMContextDispose(tl->context);
+   FREE(tl);
+}
+
+
+struct translate *
+translate_llvm_create(const struct translate_key *key)
+{
+   struct translate_llvm *tl;
+   LLVMValueRef funcs[TRANSLATE_LLVM_NUM_FUNCS];
+   unsigned i;
+
+   if (!debug_get_option_translate_llvm())
+      return NULL;
+
+   for (i = 0; i < key->nr_elements; i++) {
+      const struct translate_element *element = &key->element[i];
+
+      if (!is_supported_output_format(
+             util_format_description(element->output_format)))
+         return NULL;
+
+      if (element->type == TRANSLATE_ELEMENT_NORMAL &&
+          (element->input_buffer >= PIPE_MAX_ATTRIBS ||
+           !is_supported_input_format(
+              util_format_description(element->input_format))))
+         return NULL;
+   }
+
+   if (!lp_build_init())
+      return NULL;
+
+   tl = CALLOC_STRUCT(translate_llvm);
+   if (!tl)
+      return NULL;
+
+   tl->translate.key = *key;
+   tl->translate.release = llvm_release;
+   tl->translate.set_buffer = llvm_set_buffer;
+   tl->translate.run_elts = llvm_run_elts;
+   tl->translate.run_elts16 = llvm_run_elts16;
+   tl->translate.run_elts8 = llvm_run_elts8;
+   tl->translate.run = llvm_run;
+
+   for (i = 0; i < key->nr_elements; i++) {
+      if (key->element[i].type == TRANSLATE_ELEMENT_NORMAL)
+         tl->nr_buffers = MAX2(tl->nr_buffers,
+                               key->element[i].input_buffer + 1);
+   }
+
+   tl->context = LLVMContextCreate();
+   if (!tl->context)
+      goto fail;
+
+   tl->gallivm = gallivm_create("translate", tl->context);
+   if (!tl->gallivm)
+      goto fail;
+
+   for (i = 0; i < TRANSLATE_LLVM_NUM_FUNCS; i++)
+      funcs[i] = generate_run(tl->gallivm, key, translate_llvm_index_sizes[i]);
+
+   gallivm_compile_module(tl->gallivm);
+
+   for (i = 0; i < TRANSLATE_LLVM_NUM_FUNCS; i++)
+      tl->func[i] = (translate_llvm_run_func)
+         gallivm_jit_function(tl->gallivm, funcs[i]);
+
+   gallivm_free_ir(tl->gallivm);
+
+   return &tl->translate;
+
+fail:
+   if (tl->context)
+      LLVMContextDispose(tl->context);
+   FREE(tl);
+   return NULL;
+}
@@ -611,6 +611,185 @@ def generate_pack_kernel(format, src_channel, src_native_type):
         print_channels(format, pack_into_union)
 
 
+def is_format_sse2_unorm8(format):
+    '''Whether the format is four 8-bit unorm channels, which have SSE2 row
+    kernels processing four pixels at a time.'''
+
+    if format.layout != PLAIN or format.colorspace != RGB:
+        return False
+    if format.block_width != 1 or format.block_height != 1:
+        return False
+    if format.block_size() != 32:
+        return False
+
+    for channel in format.le_channels:
+        if channel.size != 8:
+            return False
+        if channel.type != VOID and (channel.type != UNSIGNED or not channel.norm):
+            return False
+
+    return True
+
+
+def unorm8_sources(format):
+    '''Return, for each rgba component, the byte of the pixel it is read from,
+    or SWIZZLE_0/SWIZZLE_1.'''
+
+    sources = []
+    for swizzle in format.le_swizzles:
+        if swizzle < 4:
+            sources.append(format.le_channels[swizzle].shift / 8)
+        elif swizzle == SWIZZLE_1:
+            sources.append(SWIZZLE_1)
+        else:
+            sources.append(SWIZZLE_0)
+    return sources
+
+
+def unorm8_destinations(format):
+    '''Return, for each byte of the pixel, the rgba component written to it,
+    or SWIZZLE_0 for padding.'''
+
+    inv_swizzle = inv_swizzles(format.le_swizzles)
+    destinations = [SWIZZLE_0]*4
+    for i in range(4):
+        channel = format.le_channels[i]
+        if channel.type != VOID and inv_swizzle[i] is not None:
+            destinations[channel.shift / 8] = inv_swizzle[i]
+    return destinations
+
+
+def sse2_shuffle_bytes(dst, src, mapping):
+    '''Emit code moving bytes within each 32-bit pixel of the src vector,
+    where mapping[i] is the byte dst byte i comes from, or SWIZZLE_0/1.'''
+
+    ones = 0
+    shifts = {}
+    for i in range(4):
+        if mapping[i] == SWIZZLE_1:
+            ones |= 0xff << (8*i)
+        elif mapping[i] != SWIZZLE_0:
+            shift = 8*(i - mapping[i])
+            shifts[shift] = shifts.get(shift, 0) | (0xff << (8*i))
+
+    terms = []
+    for shift in sorted(shifts.keys()):
+        mask = shifts[shift]
+        if shift > 0:
+            value = '_mm_slli_epi32(%s, %u)' % (src, shift)
+        elif shift < 0:
+            value = '_mm_srli_epi32(%s, %u)' % (src, -shift)
+        else:
+            value = src
+        if mask != 0xffffffff:
+            value = '_mm_and_si128(%s, _mm_set1_epi32((int)0x%08x))' % (value, mask)
+        terms.append(value)
+    if ones:
+        terms.append('_mm_set1_epi32((int)0x%08x)' % ones)
+    if not terms:
+        terms.append('_mm_setzero_si128()')
+
+    print '         %s = %s;' % (dst, terms[0])
+    for term in terms[1:]:
+        print '         %s = _mm_or_si128(%s, %s);' % (dst, dst, term)
+
+
+def sse2_shuffle_mask(mapping):
+    '''_MM_SHUFFLE() argument for a mapping of lanes, with SWIZZLE_0/1 lanes
+    reading lane 0.'''
+
+    lanes = [m if m < 4 else 0 for m in mapping]
+    return '_MM_SHUFFLE(%u, %u, %u, %u)' % (lanes[3], lanes[2], lanes[1], lanes[0])
+
+
+def generate_sse2_unpack_kernel(format, dst_suffix):
+    '''Emit the body of a loop unpacking four pixels with SSE2.'''
+
+    sources = unorm8_sources(format)
+
+    print '         __m128i texels = _mm_loadu_si128((const __m128i *)src);'
+    if dst_suffix == 'rgba_8unorm':
+        print '         __m128i rgba;'
+        sse2_shuffle_bytes('rgba', 'texels', sources)
+        print '         _mm_storeu_si128((__m128i *)dst, rgba);'
+        return
+
+    print '         const __m128i zero = _mm_setzero_si128();'
+    print '         __m128i lo = _mm_unpacklo_epi8(texels, zero);'
+    print '         __m128i hi = _mm_unpackhi_epi8(texels, zero);'
+    print '         __m128i pixels[4];'
+    print '         unsigned i;'
+    print '         pixels[0] = _mm_unpacklo_epi16(lo, zero);'
+    print '         pixels[1] = _mm_unpackhi_epi16(lo, zero);'
+    print '         pixels[2] = _mm_unpacklo_epi16(hi, zero);'
+    print '         pixels[3] = _mm_unpackhi_epi16(hi, zero);'
+    print '         for (i = 0; i < 4; i++) {'
+    print '            __m128 rgba = _mm_mul_ps(_mm_cvtepi32_ps(pixels[i]), _mm_set1_ps(1.0f/255.0f));'
+    if sources != [0, 1, 2, 3]:
+        print '            rgba = _mm_shuffle_ps(rgba, rgba, %s);' % sse2_shuffle_mask(sources)
+    if SWIZZLE_0 in sources or SWIZZLE_1 in sources:
+        keep = ['-1' if m < 4 else '0' for m in sources]
+        print '            rgba = _mm_and_ps(rgba, _mm_castsi128_ps(_mm_setr_epi32(%s)));' % ', '.join(keep)
+    if SWIZZLE_1 in sources:
+        ones = ['1.0f' if m == SWIZZLE_1 else '0.0f' for m in sources]
+        print '            rgba = _mm_or_ps(rgba, _mm_setr_ps(%s));' % ', '.join(ones)
+    print '            _mm_storeu_ps(dst + 4*i, rgba);'
+    print '         }'
+
+
+def generate_sse2_pack_kernel(format, src_suffix):
+    '''Emit the body of a loop packing four pixels with SSE2.'''
+
+    destinations = unorm8_destinations(format)
+
+    if src_suffix == 'rgba_8unorm':
+        print '         __m128i rgba = _mm_loadu_si128((const __m128i *)src);'
+        print '         __m128i texels;'
+        sse2_shuffle_bytes('texels', 'rgba', destinations)
+        print '         _mm_storeu_si128((__m128i *)dst, texels);'
+        return
+
+    # Same result as float_to_ubyte(), bit for bit.
+    print '         __m128i bytes[4];'
+    print '         unsigned i;'
+    print '         for (i = 0; i < 4; i++) {'
+    print '            __m128 rgba = _mm_loadu_ps(src + 4*i);'
+    print '            __m128i bits, value;'
+    if destinations != [0, 1, 2, 3]:
+        print '            rgba = _mm_shuffle_ps(rgba, rgba, %s);' % sse2_shuffle_mask(destinations)
+    print '            bits = _mm_castps_si128(rgba);'
+    print '            value = _mm_castps_si128(_mm_add_ps(_mm_mul_ps(rgba, _mm_set1_ps(255.0f/256.0f)), _mm_set1_ps(32768.0f)));'
+    print '            value = _mm_and_si128(value, _mm_set1_epi32(0xff));'
+    print '            value = _mm_andnot_si128(_mm_cmplt_epi32(bits, _mm_setzero_si128()), value);'
+    print '            value = _mm_or_si128(value, _mm_and_si128(_mm_cmpgt_epi32(bits, _mm_set1_epi32(0x3f7fffff)), _mm_set1_epi32(0xff)));'
+    if SWIZZLE_0 in destinations:
+        keep = ['-1' if m < 4 else '0' for m in destinations]
+        print '            value = _mm_and_si128(value, _mm_setr_epi32(%s));' % ', '.join(keep)
+    print '            bytes[i] = value;'
+    print '         }'
+    print '         _mm_storeu_si128((__m128i *)dst,'
+    print '                          _mm_packus_epi16(_mm_packs_epi32(bytes[0], bytes[1]),'
+    print '                                           _mm_packs_epi32(bytes[2], bytes[3])));'
+
+
+def generate_sse2_loop(format, suffix, kernel):
+    '''Emit an SSE2 loop over the pixels of the row in groups of four, and
+    start the scalar loop that follows at the first remaining one.'''
+
+    print '      x = 0;'
+
+    if suffix not in ('rgba_float', 'rgba_8unorm') or not is_format_sse2_unorm8(format):
+        return
+
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '      for(; x + 4 <= width; x += 4) {'
+    kernel(format, suffix)
+    print '         src += 16;'
+    print '         dst += 16;'
+    print '      }'
+    print '#endif'
+
+
 def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
     '''Generate the function to unpack pixels from a particular format'''
 
@@ -625,7 +804,8 @@ def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      %s *dst = dst_row;' % (dst_native_type)
         print '      const uint8_t *src = src_row;'
-        print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
+        generate_sse2_loop(format, dst_suffix, generate_sse2_unpack_kernel)
+        print '      for(; x < width; x += %u) {' % (format.block_width,)
         
         generate_unpack_kernel(format, dst_channel, dst_native_type)
     
@@ -654,7 +834,8 @@ def generate_format_pack(format, src_channel, src_native_type, src_suffix):
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      const %s *src = src_row;' % (src_native_type)
         print '      uint8_t *dst = dst_row;'
-        print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
+        generate_sse2_loop(format, src_suffix, generate_sse2_pack_kernel)
+        print '      for(; x < width; x += %u) {' % (format.block_width,)
     
         generate_pack_kernel(format, src_channel, src_native_type)
             
@@ -700,6 +881,10 @@ def generate(formats):
     print '#include "u_format_yuv.h"'
     print '#include "u_format_zs.h"'
     print
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '#include <emmintrin.h>'
+    print '#endif'
+    print
 
     for format in formats:
         if not is_format_hand_written(format):
@@ -32,12 +32,24 @@
 #include "pipe/p_defines.h"
 #include "util/u_inlines.h"
 #include "pipe/p_context.h"
+#include "pipe/p_screen.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
 
 #include "u_upload_mgr.h"
 
 
+/* Number of full upload buffers kept around for reuse. */
+#define U_UPLOAD_MAX_RETIRED 4
+
+/* An upload buffer that is full, waiting for the GPU to be done with it. */
+struct u_upload_retired {
+   struct pipe_resource *buffer;
+   struct pipe_transfer *transfer; /* Persistent mapping, if any. */
+   uint8_t *map;
+   struct pipe_fence_handle *fence; /* NULL until u_upload_fence(). */
+};
+
 struct u_upload_mgr {
    struct pipe_context *pipe;
 
@@ -52,6 +64,13 @@ struct u_upload_mgr {
    uint8_t *map;    /* Pointer to the mapped upload buffer. */
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
+
+   /* Full buffers, oldest first.  Only kept once the user has started
+    * passing fences with u_upload_fence().
+    */
+   boolean recycle;
+   struct u_upload_retired retired[U_UPLOAD_MAX_RETIRED];
+   unsigned num_retired;
 };
 
 
@@ -121,13 +140,114 @@ static void u_upload_release_buffer(struct u_upload_mgr *upload)
 }
 
 
+static void
+u_upload_release_retired(struct u_upload_mgr *upload,
+                         struct u_upload_retired *retired)
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+
+   if (retired->transfer)
+      pipe_transfer_unmap(upload->pipe, retired->transfer);
+   pipe_resource_reference(&retired->buffer, NULL);
+   if (retired->fence)
+      screen->fence_reference(screen, &retired->fence, NULL);
+}
+
+
 void u_upload_destroy( struct u_upload_mgr *upload )
 {
+   unsigned i;
+
    u_upload_release_buffer( upload );
+
+   for (i = 0; i < upload->num_retired; i++)
+      u_upload_release_retired(upload, &upload->retired[i]);
+
    FREE( upload );
 }
 
 
+void u_upload_fence(struct u_upload_mgr *upload,
+                    struct pipe_fence_handle *fence)
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   unsigned i;
+
+   upload->recycle = TRUE;
+
+   for (i = 0; i < upload->num_retired; i++) {
+      if (!upload->retired[i].fence)
+         screen->fence_reference(screen, &upload->retired[i].fence, fence);
+   }
+}
+
+
+/**
+ * Stop allocating from the current buffer.  It is kept for reuse if it has
+ * the default size and there is room, and released otherwise.
+ */
+static void
+u_upload_retire_buffer(struct u_upload_mgr *upload)
+{
+   struct u_upload_retired *retired;
+
+   if (!upload->buffer)
+      return;
+
+   if (!upload->recycle ||
+       upload->num_retired == U_UPLOAD_MAX_RETIRED ||
+       upload->buffer->width0 != align(upload->default_size, 4096)) {
+      u_upload_release_buffer(upload);
+      return;
+   }
+
+   /* Keep persistent mappings, they stay valid while the GPU reads. */
+   if (!upload->map_persistent)
+      upload_unmap_internal(upload, TRUE);
+
+   retired = &upload->retired[upload->num_retired++];
+   retired->buffer = upload->buffer;
+   retired->transfer = upload->transfer;
+   retired->map = upload->map;
+   retired->fence = NULL;
+
+   upload->buffer = NULL;
+   upload->transfer = NULL;
+   upload->map = NULL;
+}
+
+
+/**
+ * Make the oldest retired buffer current again if the GPU is done with it.
+ */
+static boolean
+u_upload_reuse_buffer(struct u_upload_mgr *upload, unsigned min_size)
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   struct u_upload_retired *oldest = &upload->retired[0];
+
+   /* Fences signal in order, so if the oldest one isn't done yet none of
+    * the other buffers are either.
+    */
+   if (!upload->num_retired ||
+       !oldest->fence ||
+       oldest->buffer->width0 < min_size ||
+       !screen->fence_finish(screen, oldest->fence, 0))
+      return FALSE;
+
+   upload->buffer = oldest->buffer;
+   upload->transfer = oldest->transfer;
+   upload->map = oldest->map;
+   upload->offset = 0;
+   screen->fence_reference(screen, &oldest->fence, NULL);
+
+   upload->num_retired--;
+   memmove(&upload->retired[0], &upload->retired[1],
+           upload->num_retired * sizeof(upload->retired[0]));
+   return TRUE;
+}
+
+
 static void
 u_upload_alloc_buffer(struct u_upload_mgr *upload,
                       unsigned min_size)
@@ -136,12 +256,15 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload,
    struct pipe_resource buffer;
    unsigned size;
 
-   /* Release the old buffer, if present:
+   /* Retire the old buffer, if present:
     */
-   u_upload_release_buffer( upload );
+   u_upload_retire_buffer( upload );
 
-   /* Allocate a new one: 
+   /* Reuse an idle one, or allocate a new one:
     */
+   if (u_upload_reuse_buffer(upload, min_size))
+      return;
+
    size = align(MAX2(upload->default_size, min_size), 4096);
 
    memset(&buffer, 0, sizeof buffer);
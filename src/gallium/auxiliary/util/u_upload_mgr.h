@@ -36,6 +36,7 @@
 
 struct pipe_context;
 struct pipe_resource;
+struct pipe_fence_handle;
 
 
 /**
@@ -55,6 +56,20 @@ u_upload_create(struct pipe_context *pipe, unsigned default_size,
  */
 void u_upload_destroy( struct u_upload_mgr *upload );
 
+/**
+ * Tell the upload manager that the commands submitted so far complete with
+ * \p fence.
+ *
+ * Upload buffers that were filled up before this call are recycled once the
+ * fence has signalled, instead of being released and allocating new ones.
+ * Buffers are only kept for reuse after the first call to this function.
+ *
+ * \param upload           Upload manager
+ * \param fence            Fence returned by the last pipe_context::flush()
+ */
+void u_upload_fence(struct u_upload_mgr *upload,
+                    struct pipe_fence_handle *fence);
+
 /**
  * Unmap upload buffer
  *
@@ -30,8 +30,11 @@
 #include "pipe/p_compiler.h"
 #include "pipe/p_context.h"
 
+#include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
 #include "util/u_surface.h"
 #include "util/u_upload_mgr.h"
 
@@ -44,6 +47,19 @@
 #define MIN_DIRTY (0)
 #define MAX_DIRTY (1 << 15)
 
+/* block size of the compute path */
+#define CS_BLOCK_SIZE 8
+
+DEBUG_GET_ONCE_BOOL_OPTION(vl_compute, "VL_COMPOSITOR_COMPUTE", TRUE)
+
+/* second constant buffer of the compute shader, see draw_layer_compute */
+struct cs_params
+{
+   int32_t x0, y0, x1, y1;
+   float scale_x, scale_y, offset_x, offset_y;
+   float layer, pad[3];
+};
+
 enum VS_OUTPUT
 {
    VS_O_VPOS = 0,
@@ -338,6 +354,131 @@ create_frag_shader_rgba(struct vl_compositor *c)
    return ureg_create_shader_and_destroy(shader, c->pipe);
 }
 
+/*
+ * Color conversion, scaling and bob deinterlacing of a video buffer in a
+ * single compute dispatch, writing the destination through an image
+ * instead of going through the rasterizer.
+ */
+static void *
+create_compute_shader_video_buffer(struct vl_compositor *c,
+                                   enum pipe_format format)
+{
+   struct ureg_program *shader;
+   struct ureg_src block, thread;
+   struct ureg_src csc[3], params[3];
+   struct ureg_src sampler[3];
+   struct ureg_src image;
+   struct ureg_dst pos, tc, texel, color;
+   struct pipe_compute_state state;
+   const struct tgsi_token *tokens;
+   unsigned label, i;
+   void *cs;
+
+   shader = ureg_create(PIPE_SHADER_COMPUTE);
+   if (!shader)
+      return NULL;
+
+   ureg_property(shader, TGSI_PROPERTY_CS_FIXED_BLOCK_WIDTH, CS_BLOCK_SIZE);
+   ureg_property(shader, TGSI_PROPERTY_CS_FIXED_BLOCK_HEIGHT, CS_BLOCK_SIZE);
+   ureg_property(shader, TGSI_PROPERTY_CS_FIXED_BLOCK_DEPTH, 1);
+
+   block = ureg_DECL_system_value(shader, TGSI_SEMANTIC_BLOCK_ID, 0);
+   thread = ureg_DECL_system_value(shader, TGSI_SEMANTIC_THREAD_ID, 0);
+   ureg_DECL_constant2D(shader, 0, 2, 0);
+   ureg_DECL_constant2D(shader, 0, 2, 1);
+   for (i = 0; i < 3; ++i) {
+      csc[i] = ureg_src_dimension(ureg_src_register(TGSI_FILE_CONSTANT, i), 0);
+      params[i] = ureg_src_dimension(ureg_src_register(TGSI_FILE_CONSTANT, i), 1);
+      sampler[i] = ureg_DECL_sampler(shader, i);
+   }
+   image = ureg_DECL_image(shader, 0, TGSI_TEXTURE_2D, format, true, false);
+
+   pos = ureg_DECL_temporary(shader);
+   tc = ureg_DECL_temporary(shader);
+   texel = ureg_DECL_temporary(shader);
+   color = ureg_DECL_temporary(shader);
+
+   /*
+    * pos.xy = block.xy * CS_BLOCK_SIZE + thread.xy + params[0].xy
+    * if (pos.x < params[0].z && pos.y < params[0].w) {
+    */
+   ureg_UMAD(shader, ureg_writemask(pos, TGSI_WRITEMASK_XY), block,
+             ureg_imm1u(shader, CS_BLOCK_SIZE), thread);
+   ureg_UADD(shader, ureg_writemask(pos, TGSI_WRITEMASK_XY),
+             ureg_src(pos), params[0]);
+   ureg_ISLT(shader, ureg_writemask(tc, TGSI_WRITEMASK_XY), ureg_src(pos),
+             ureg_swizzle(params[0], TGSI_SWIZZLE_Z, TGSI_SWIZZLE_W,
+                          TGSI_SWIZZLE_W, TGSI_SWIZZLE_W));
+   ureg_AND(shader, ureg_writemask(tc, TGSI_WRITEMASK_X),
+            ureg_scalar(ureg_src(tc), TGSI_SWIZZLE_X),
+            ureg_scalar(ureg_src(tc), TGSI_SWIZZLE_Y));
+   ureg_UIF(shader, ureg_scalar(ureg_src(tc), TGSI_SWIZZLE_X), &label);
+
+      /*
+       * tc.xy = (pos.xy + 0.5) * params[1].xy + params[1].zw
+       * tc.z = params[2].x
+       * tc.w = 0
+       */
+      ureg_I2F(shader, ureg_writemask(tc, TGSI_WRITEMASK_XY), ureg_src(pos));
+      ureg_ADD(shader, ureg_writemask(tc, TGSI_WRITEMASK_XY), ureg_src(tc),
+               ureg_imm1f(shader, 0.5f));
+      ureg_MAD(shader, ureg_writemask(tc, TGSI_WRITEMASK_XY), ureg_src(tc),
+               params[1], ureg_swizzle(params[1], TGSI_SWIZZLE_Z, TGSI_SWIZZLE_W,
+                                       TGSI_SWIZZLE_W, TGSI_SWIZZLE_W));
+      ureg_MOV(shader, ureg_writemask(tc, TGSI_WRITEMASK_Z),
+               ureg_scalar(params[2], TGSI_SWIZZLE_X));
+      ureg_MOV(shader, ureg_writemask(tc, TGSI_WRITEMASK_W),
+               ureg_imm1f(shader, 0.0f));
+
+      /*
+       * texel.xyz = txl(tc, sampler[i])
+       * color = csc * texel
+       */
+      for (i = 0; i < 3; ++i)
+         ureg_TXL(shader, ureg_writemask(texel, TGSI_WRITEMASK_X << i),
+                  TGSI_TEXTURE_2D_ARRAY, ureg_src(tc), sampler[i]);
+
+      ureg_MOV(shader, ureg_writemask(texel, TGSI_WRITEMASK_W), ureg_imm1f(shader, 1.0f));
+
+      for (i = 0; i < 3; ++i)
+         ureg_DP4(shader, ureg_writemask(color, TGSI_WRITEMASK_X << i), csc[i], ureg_src(texel));
+
+      ureg_MOV(shader, ureg_writemask(color, TGSI_WRITEMASK_W), ureg_imm1f(shader, 1.0f));
+
+      /* image[pos.xy] = color */
+      {
+         struct ureg_dst dst = ureg_dst(image);
+         struct ureg_src src[2] = { ureg_src(pos), ureg_src(color) };
+
+         ureg_memory_insn(shader, TGSI_OPCODE_STORE, &dst, 1, src, 2, 0,
+                          TGSI_TEXTURE_2D, format);
+      }
+
+   ureg_fixup_label(shader, label, ureg_get_instruction_number(shader));
+   ureg_ENDIF(shader);
+
+   ureg_release_temporary(shader, pos);
+   ureg_release_temporary(shader, tc);
+   ureg_release_temporary(shader, texel);
+   ureg_release_temporary(shader, color);
+   ureg_END(shader);
+
+   tokens = ureg_get_tokens(shader, NULL);
+   if (!tokens) {
+      ureg_destroy(shader);
+      return NULL;
+   }
+
+   memset(&state, 0, sizeof(state));
+   state.ir_type = PIPE_SHADER_IR_TGSI;
+   state.prog = tokens;
+   cs = c->pipe->create_compute_state(c->pipe, &state);
+
+   ureg_free_tokens(tokens);
+   ureg_destroy(shader);
+   return cs;
+}
+
 static bool
 init_shaders(struct vl_compositor *c)
 {
@@ -392,6 +533,31 @@ static void cleanup_shaders(struct vl_compositor *c)
    c->pipe->delete_fs_state(c->pipe, c->fs_palette.yuv);
    c->pipe->delete_fs_state(c->pipe, c->fs_palette.rgb);
    c->pipe->delete_fs_state(c->pipe, c->fs_rgba);
+   if (c->cs.video_buffer)
+      c->pipe->delete_compute_state(c->pipe, c->cs.video_buffer);
+}
+
+static void
+init_compute(struct vl_compositor *c)
+{
+   struct pipe_screen *screen = c->pipe->screen;
+
+   if (!debug_get_option_vl_compute() ||
+       !screen->get_param(screen, PIPE_CAP_COMPUTE) ||
+       !c->pipe->launch_grid || !c->pipe->set_shader_images ||
+       !(screen->get_shader_param(screen, PIPE_SHADER_COMPUTE,
+                                  PIPE_SHADER_CAP_SUPPORTED_IRS) &
+         (1 << PIPE_SHADER_IR_TGSI)) ||
+       screen->get_shader_param(screen, PIPE_SHADER_COMPUTE,
+                                PIPE_SHADER_CAP_MAX_SHADER_IMAGES) < 1 ||
+       screen->get_shader_param(screen, PIPE_SHADER_COMPUTE,
+                                PIPE_SHADER_CAP_MAX_TEXTURE_SAMPLERS) < 3)
+      return;
+
+   c->cs.params = pipe_buffer_create(screen, PIPE_BIND_CONSTANT_BUFFER,
+                                     PIPE_USAGE_STREAM,
+                                     sizeof(struct cs_params));
+   c->cs.supported = c->cs.params != NULL;
 }
 
 static bool
@@ -789,6 +955,119 @@ draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rec
    }
 }
 
+/*
+ * Render a single opaque, unrotated video buffer layer with one compute
+ * dispatch.  Returns false if the layers need the graphics path.
+ */
+static bool
+draw_layer_compute(struct vl_compositor *c, struct vl_compositor_state *s,
+                   struct pipe_surface *dst_surface, struct u_rect *dirty)
+{
+   struct vl_compositor_layer *layer = &s->layers[0];
+   struct pipe_screen *screen = c->pipe->screen;
+   struct pipe_resource *dst = dst_surface->texture;
+   struct pipe_image_view image;
+   struct pipe_grid_info info;
+   struct cs_params params;
+   struct u_rect drawn;
+   float dst_x0, dst_y0, dst_w, dst_h;
+
+   if (!c->cs.supported || s->used_layers != 1 ||
+       layer->fs != c->fs_video_buffer ||
+       layer->rotate != VL_COMPOSITOR_ROTATE_0 ||
+       (layer->blend && layer->blend != c->blend_clear))
+      return false;
+
+   if ((dst->target != PIPE_TEXTURE_2D && dst->target != PIPE_TEXTURE_RECT) ||
+       dst->nr_samples > 1 ||
+       !screen->is_format_supported(screen, dst_surface->format, dst->target,
+                                    0, PIPE_BIND_SHADER_IMAGE))
+      return false;
+
+   dst_x0 = layer->dst.tl.x * layer->viewport.scale[0] + layer->viewport.translate[0];
+   dst_y0 = layer->dst.tl.y * layer->viewport.scale[1] + layer->viewport.translate[1];
+   dst_w = (layer->dst.br.x - layer->dst.tl.x) * layer->viewport.scale[0];
+   dst_h = (layer->dst.br.y - layer->dst.tl.y) * layer->viewport.scale[1];
+   if (dst_w <= 0.0f || dst_h <= 0.0f)
+      return false;
+
+   if (!c->cs.video_buffer || c->cs.format != dst_surface->format) {
+      if (c->cs.video_buffer)
+         c->pipe->delete_compute_state(c->pipe, c->cs.video_buffer);
+      c->cs.video_buffer =
+         create_compute_shader_video_buffer(c, dst_surface->format);
+      c->cs.format = dst_surface->format;
+      if (!c->cs.video_buffer) {
+         c->cs.supported = false;
+         return false;
+      }
+   }
+
+   drawn = calc_drawn_area(s, layer);
+
+   if (dirty) {
+      dirty->x0 = MIN2(drawn.x0, dirty->x0);
+      dirty->y0 = MIN2(drawn.y0, dirty->y0);
+      dirty->x1 = MAX2(drawn.x1, dirty->x1);
+      dirty->y1 = MAX2(drawn.y1, dirty->y1);
+   }
+
+   drawn.x0 = MAX2(drawn.x0, 0);
+   drawn.y0 = MAX2(drawn.y0, 0);
+   drawn.x1 = MIN2(drawn.x1, (int)dst_surface->width);
+   drawn.y1 = MIN2(drawn.y1, (int)dst_surface->height);
+   if (drawn.x0 >= drawn.x1 || drawn.y0 >= drawn.y1)
+      return true;
+
+   /* Map destination pixel centers straight to source coordinates. */
+   memset(&params, 0, sizeof(params));
+   params.x0 = drawn.x0;
+   params.y0 = drawn.y0;
+   params.x1 = drawn.x1;
+   params.y1 = drawn.y1;
+   params.scale_x = (layer->src.br.x - layer->src.tl.x) / dst_w;
+   params.scale_y = (layer->src.br.y - layer->src.tl.y) / dst_h;
+   params.offset_x = layer->src.tl.x - dst_x0 * params.scale_x;
+   params.offset_y = layer->src.tl.y - dst_y0 * params.scale_y;
+   params.layer = layer->zw.x;
+   pipe_buffer_write(c->pipe, c->cs.params, 0, sizeof(params), &params);
+
+   memset(&image, 0, sizeof(image));
+   image.resource = dst;
+   image.format = dst_surface->format;
+   image.access = PIPE_IMAGE_ACCESS_WRITE;
+   image.u.tex.level = dst_surface->u.tex.level;
+   image.u.tex.first_layer = dst_surface->u.tex.first_layer;
+   image.u.tex.last_layer = dst_surface->u.tex.last_layer;
+
+   pipe_set_constant_buffer(c->pipe, PIPE_SHADER_COMPUTE, 0, s->csc_matrix);
+   pipe_set_constant_buffer(c->pipe, PIPE_SHADER_COMPUTE, 1, c->cs.params);
+   c->pipe->bind_sampler_states(c->pipe, PIPE_SHADER_COMPUTE, 0, 3,
+                                layer->samplers);
+   c->pipe->set_sampler_views(c->pipe, PIPE_SHADER_COMPUTE, 0, 3,
+                              layer->sampler_views);
+   c->pipe->set_shader_images(c->pipe, PIPE_SHADER_COMPUTE, 0, 1, &image);
+   c->pipe->bind_compute_state(c->pipe, c->cs.video_buffer);
+
+   memset(&info, 0, sizeof(info));
+   info.block[0] = CS_BLOCK_SIZE;
+   info.block[1] = CS_BLOCK_SIZE;
+   info.block[2] = 1;
+   info.grid[0] = DIV_ROUND_UP(drawn.x1 - drawn.x0, CS_BLOCK_SIZE);
+   info.grid[1] = DIV_ROUND_UP(drawn.y1 - drawn.y0, CS_BLOCK_SIZE);
+   info.grid[2] = 1;
+   c->pipe->launch_grid(c->pipe, &info);
+
+   /* Don't keep the destination and the video buffer bound. */
+   c->pipe->set_shader_images(c->pipe, PIPE_SHADER_COMPUTE, 0, 1, NULL);
+   c->pipe->set_sampler_views(c->pipe, PIPE_SHADER_COMPUTE, 0, 3, NULL);
+
+   if (c->pipe->memory_barrier)
+      c->pipe->memory_barrier(c->pipe, PIPE_BARRIER_TEXTURE |
+                                       PIPE_BARRIER_FRAMEBUFFER);
+   return true;
+}
+
 void
 vl_compositor_reset_dirty_area(struct u_rect *dirty)
 {
@@ -849,6 +1128,7 @@ vl_compositor_cleanup(struct vl_compositor *c)
    cleanup_buffers(c);
    cleanup_shaders(c);
    cleanup_pipe_state(c);
+   pipe_resource_reference(&c->cs.params, NULL);
 }
 
 void
@@ -1072,6 +1352,9 @@ vl_compositor_render(struct vl_compositor_state *s,
       dirty_area->x1 = dirty_area->y1 = MIN_DIRTY;
    }
 
+   if (draw_layer_compute(c, s, dst_surface, dirty_area))
+      return;
+
    c->pipe->set_framebuffer_state(c->pipe, &c->fb_state);
    c->pipe->bind_vs_state(c->pipe, c->vs);
    c->pipe->set_vertex_buffers(c->pipe, 0, 1, &c->vertex_buf);
@@ -1115,6 +1398,8 @@ vl_compositor_init(struct vl_compositor *c, struct pipe_context *pipe)
       return false;
    }
 
+   init_compute(c);
+
    return true;
 }
 
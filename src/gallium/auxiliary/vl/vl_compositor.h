@@ -120,6 +120,14 @@ struct vl_compositor
       void *rgb;
       void *yuv;
    } fs_palette;
+
+   /* compute path for a single video buffer layer */
+   struct {
+      bool supported;
+      void *video_buffer;
+      enum pipe_format format;
+      struct pipe_resource *params;
+   } cs;
 };
 
 /**
@@ -316,9 +316,22 @@ DD_IMM_STATE(stencil_ref, const struct pipe_stencil_ref, *state, state)
 DD_IMM_STATE(clip_state, const struct pipe_clip_state, *state, state)
 DD_IMM_STATE(sample_mask, unsigned, sample_mask, sample_mask)
 DD_IMM_STATE(min_samples, unsigned, min_samples, min_samples)
-DD_IMM_STATE(framebuffer_state, const struct pipe_framebuffer_state, *state, state)
 DD_IMM_STATE(polygon_stipple, const struct pipe_poly_stipple, *state, state)
 
+static void
+dd_context_set_framebuffer_state(struct pipe_context *_pipe,
+                                 const struct pipe_framebuffer_state *state)
+{
+   struct dd_context *dctx = dd_context(_pipe);
+   struct pipe_context *pipe = dctx->pipe;
+
+   dctx->framebuffer_state = *state;
+   pipe->set_framebuffer_state(pipe, state);
+
+   /* Each framebuffer starts a new segment of the timeline. */
+   dd_profile_begin_segment(dctx, DD_SEGMENT_DRAW);
+}
+
 static void
 dd_context_set_constant_buffer(struct pipe_context *_pipe,
                                uint shader, uint index,
@@ -538,6 +551,8 @@ dd_context_destroy(struct pipe_context *_pipe)
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
+   dd_profile_destroy(dctx);
+   dd_ring_destroy(dctx);
    pipe->destroy(pipe);
    FREE(dctx);
 }
@@ -635,8 +650,11 @@ dd_context_invalidate_resource(struct pipe_context *_pipe,
 static enum pipe_reset_status
 dd_context_get_device_reset_status(struct pipe_context *_pipe)
 {
-   struct pipe_context *pipe = dd_context(_pipe)->pipe;
+   struct dd_context *dctx = dd_context(_pipe);
+   struct pipe_context *pipe = dctx->pipe;
 
+   if (dctx->ring)
+      return dd_ring_get_device_reset_status(dctx);
    return pipe->get_device_reset_status(pipe);
 }
 
@@ -750,5 +768,10 @@ dd_context_create(struct dd_screen *dscreen, struct pipe_context *pipe)
    dd_init_draw_functions(dctx);
 
    dctx->sample_mask = ~0;
+
+   if (dscreen->mode == DD_PROFILE_TIMESTAMPS)
+      dd_profile_init(dctx);
+   else if (dscreen->mode == DD_DETECT_HANGS_RING)
+      dd_ring_init(dctx);
    return &dctx->base;
 }
@@ -511,16 +511,6 @@ dd_dump_call(struct dd_context *dctx, struct dd_call *call, unsigned flags)
    dd_close_file_stream(f);
 }
 
-static void
-dd_kill_process(void)
-{
-   sync();
-   fprintf(stderr, "dd: Aborting the process...\n");
-   fflush(stdout);
-   fflush(stderr);
-   abort();
-}
-
 static bool
 dd_flush_and_check_hang(struct dd_context *dctx,
                         struct pipe_fence_handle **flush_fence,
@@ -581,16 +571,104 @@ dd_context_flush(struct pipe_context *_pipe,
    case DD_DUMP_ALL_CALLS:
       pipe->flush(pipe, fence, flags);
       break;
+   case DD_PROFILE_TIMESTAMPS:
+      dd_profile_flush(dctx, flags);
+      pipe->flush(pipe, fence, flags);
+      break;
+   case DD_DETECT_HANGS_RING:
+      dd_ring_flush(dctx, fence, flags);
+      break;
    default:
       assert(0);
    }
 }
 
+static enum dd_segment_kind
+dd_call_segment_kind(const struct dd_call *call)
+{
+   switch (call->type) {
+   case CALL_RESOURCE_COPY_REGION:
+   case CALL_FLUSH_RESOURCE:
+      return DD_SEGMENT_COPY;
+   case CALL_BLIT:
+      return DD_SEGMENT_BLIT;
+   case CALL_CLEAR:
+   case CALL_CLEAR_BUFFER:
+   case CALL_CLEAR_RENDER_TARGET:
+   case CALL_CLEAR_DEPTH_STENCIL:
+      return DD_SEGMENT_CLEAR;
+   default:
+      return DD_SEGMENT_DRAW;
+   }
+}
+
+static const char *
+dd_call_name(const struct dd_call *call)
+{
+   switch (call->type) {
+   case CALL_DRAW_VBO:
+      return "draw_vbo";
+   case CALL_RESOURCE_COPY_REGION:
+      return "resource_copy_region";
+   case CALL_BLIT:
+      return "blit";
+   case CALL_FLUSH_RESOURCE:
+      return "flush_resource";
+   case CALL_CLEAR:
+      return "clear";
+   case CALL_CLEAR_BUFFER:
+      return "clear_buffer";
+   case CALL_CLEAR_RENDER_TARGET:
+      return "clear_render_target";
+   case CALL_CLEAR_DEPTH_STENCIL:
+      return "clear_depth_stencil";
+   default:
+      return "unknown";
+   }
+}
+
 static void
-dd_before_draw(struct dd_context *dctx)
+dd_ring_record_call(struct dd_context *dctx, const struct dd_call *call)
+{
+   const struct pipe_framebuffer_state *fb = &dctx->framebuffer_state;
+   struct dd_ring_record *rec = dd_ring_add_record(dctx);
+
+   if (!rec)
+      return;
+
+   rec->name = dd_call_name(call);
+   rec->cbuf_format = fb->nr_cbufs && fb->cbufs[0] ? fb->cbufs[0]->format :
+                                                     PIPE_FORMAT_NONE;
+
+   if (call->type == CALL_DRAW_VBO) {
+      const struct pipe_draw_info *info = &call->info.draw_vbo;
+
+      rec->is_draw = true;
+      rec->indexed = info->indexed;
+      rec->mode = info->mode;
+      rec->start = info->start;
+      rec->count = info->count;
+      rec->instance_count = info->instance_count;
+      rec->vs = dctx->shaders[PIPE_SHADER_VERTEX] ?
+                   dctx->shaders[PIPE_SHADER_VERTEX]->cso : NULL;
+      rec->fs = dctx->shaders[PIPE_SHADER_FRAGMENT] ?
+                   dctx->shaders[PIPE_SHADER_FRAGMENT]->cso : NULL;
+   }
+}
+
+static void
+dd_before_draw(struct dd_context *dctx, struct dd_call *call)
 {
    struct dd_screen *dscreen = dd_screen(dctx->base.screen);
 
+   if (dscreen->mode == DD_DETECT_HANGS_RING)
+      dd_ring_record_call(dctx, call);
+
+   /* Blits, copies and clears get their own segment of the timeline. */
+   if (dscreen->mode == DD_PROFILE_TIMESTAMPS &&
+       call->type != CALL_DRAW_VBO)
+      dd_profile_begin_segment(dctx, dd_call_segment_kind(call));
+
    if (dscreen->mode == DD_DETECT_HANGS &&
        !dscreen->no_flush &&
        dctx->num_draw_calls >= dscreen->skip_count)
@@ -605,6 +683,13 @@ dd_after_draw(struct dd_context *dctx, struct dd_call *call)
    struct dd_screen *dscreen = dd_screen(dctx->base.screen);
    struct pipe_context *pipe = dctx->pipe;
 
+   if (dscreen->mode == DD_PROFILE_TIMESTAMPS) {
+      if (call->type == CALL_DRAW_VBO)
+         dd_profile_add_draw(dctx);
+      else
+         dd_profile_begin_segment(dctx, DD_SEGMENT_DRAW);
+   }
+
    if (dctx->num_draw_calls >= dscreen->skip_count) {
       switch (dscreen->mode) {
       case DD_DETECT_HANGS:
@@ -621,6 +706,9 @@ dd_after_draw(struct dd_context *dctx, struct dd_call *call)
             pipe->flush(pipe, NULL, 0);
          dd_dump_call(dctx, call, 0);
          break;
+      case DD_PROFILE_TIMESTAMPS:
+      case DD_DETECT_HANGS_RING:
+         break;
       default:
          assert(0);
       }
@@ -643,7 +731,7 @@ dd_context_draw_vbo(struct pipe_context *_pipe,
    call.type = CALL_DRAW_VBO;
    call.info.draw_vbo = *info;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->draw_vbo(pipe, info);
    dd_after_draw(dctx, &call);
 }
@@ -669,7 +757,7 @@ dd_context_resource_copy_region(struct pipe_context *_pipe,
    call.info.resource_copy_region.src_level = src_level;
    call.info.resource_copy_region.src_box = src_box;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->resource_copy_region(pipe,
                               dst, dst_level, dstx, dsty, dstz,
                               src, src_level, src_box);
@@ -686,7 +774,7 @@ dd_context_blit(struct pipe_context *_pipe, const struct pipe_blit_info *info)
    call.type = CALL_BLIT;
    call.info.blit = *info;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->blit(pipe, info);
    dd_after_draw(dctx, &call);
 }
@@ -702,7 +790,7 @@ dd_context_flush_resource(struct pipe_context *_pipe,
    call.type = CALL_FLUSH_RESOURCE;
    call.info.flush_resource = resource;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->flush_resource(pipe, resource);
    dd_after_draw(dctx, &call);
 }
@@ -722,7 +810,7 @@ dd_context_clear(struct pipe_context *_pipe, unsigned buffers,
    call.info.clear.depth = depth;
    call.info.clear.stencil = stencil;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->clear(pipe, buffers, color, depth, stencil);
    dd_after_draw(dctx, &call);
 }
@@ -740,7 +828,7 @@ dd_context_clear_render_target(struct pipe_context *_pipe,
 
    call.type = CALL_CLEAR_RENDER_TARGET;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->clear_render_target(pipe, dst, color, dstx, dsty, width, height);
    dd_after_draw(dctx, &call);
 }
@@ -757,7 +845,7 @@ dd_context_clear_depth_stencil(struct pipe_context *_pipe,
 
    call.type = CALL_CLEAR_DEPTH_STENCIL;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->clear_depth_stencil(pipe, dst, clear_flags, depth, stencil,
                              dstx, dsty, width, height);
    dd_after_draw(dctx, &call);
@@ -779,7 +867,7 @@ dd_context_clear_buffer(struct pipe_context *_pipe, struct pipe_resource *res,
    call.info.clear_buffer.clear_value = clear_value;
    call.info.clear_buffer.clear_value_size = clear_value_size;
 
-   dd_before_draw(dctx);
+   dd_before_draw(dctx, &call);
    pipe->clear_buffer(pipe, res, offset, size, clear_value, clear_value_size);
    dd_after_draw(dctx, &call);
 }
@@ -35,7 +35,35 @@
 
 enum dd_mode {
    DD_DETECT_HANGS,
-   DD_DUMP_ALL_CALLS
+   DD_DUMP_ALL_CALLS,
+   DD_PROFILE_TIMESTAMPS,
+   DD_DETECT_HANGS_RING
+};
+
+/* What the GPU is doing between two timestamps, see dd_profile.c. */
+enum dd_segment_kind {
+   DD_SEGMENT_DRAW,
+   DD_SEGMENT_BLIT,
+   DD_SEGMENT_COPY,
+   DD_SEGMENT_CLEAR,
+   DD_SEGMENT_FLUSH
+};
+
+/* A call recorded in the hang detection ring, see dd_ring.c. */
+struct dd_ring_record
+{
+   unsigned index;
+   unsigned frame;
+   const char *name;
+
+   bool is_draw;
+   bool indexed;
+   unsigned mode;
+   unsigned start, count, instance_count;
+   void *vs, *fs;
+
+   unsigned width, height;
+   enum pipe_format cbuf_format;
 };
 
 struct dd_screen
@@ -114,6 +142,9 @@ struct dd_context
    float tess_default_levels[6];
 
    unsigned num_draw_calls;
+
+   struct dd_profile *profile;
+   struct dd_ring *ring;
 };
 
 
@@ -123,6 +154,37 @@ dd_context_create(struct dd_screen *dscreen, struct pipe_context *pipe);
 void
 dd_init_draw_functions(struct dd_context *dctx);
 
+void
+dd_profile_init(struct dd_context *dctx);
+
+void
+dd_profile_destroy(struct dd_context *dctx);
+
+void
+dd_profile_begin_segment(struct dd_context *dctx, enum dd_segment_kind kind);
+
+void
+dd_profile_add_draw(struct dd_context *dctx);
+
+void
+dd_profile_flush(struct dd_context *dctx, unsigned flags);
+
+void
+dd_ring_init(struct dd_context *dctx);
+
+void
+dd_ring_destroy(struct dd_context *dctx);
+
+struct dd_ring_record *
+dd_ring_add_record(struct dd_context *dctx);
+
+void
+dd_ring_flush(struct dd_context *dctx, struct pipe_fence_handle **fence,
+              unsigned flags);
+
+enum pipe_reset_status
+dd_ring_get_device_reset_status(struct dd_context *dctx);
+
 
 static inline struct dd_context *
 dd_context(struct pipe_context *pipe)
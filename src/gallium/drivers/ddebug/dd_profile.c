@@ -0,0 +1,266 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* GPU timeline of a context, measured with timestamp queries.
+ *
+ * A timestamp is written at every boundary between segments of GPU work:
+ * framebuffer changes, blits, copies, clears and the end of each frame.
+ * A segment lasts from its timestamp to the next one.  The results are
+ * read back without stalling whenever the context is flushed, and written
+ * as CSV records, one per segment.
+ */
+
+#include "dd_pipe.h"
+
+#include <inttypes.h>
+
+#include "util/u_format.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+
+struct dd_profile_segment
+{
+   enum dd_segment_kind kind;
+   unsigned frame;
+   unsigned num_draws;
+   unsigned width, height;
+   enum pipe_format cbuf_format;
+
+   struct pipe_query *query;
+   bool ready;
+   uint64_t timestamp;
+};
+
+struct dd_profile
+{
+   FILE *f;
+   unsigned frame;
+
+   /* Segments whose duration hasn't been written yet.  The last one is the
+    * segment being recorded.
+    */
+   struct dd_profile_segment *segments;
+   unsigned first, count, max;
+};
+
+static const char *dd_segment_names[] = {
+   "draw",
+   "blit",
+   "copy",
+   "clear",
+   "flush",
+};
+
+
+static bool
+dd_profile_read_timestamp(struct pipe_context *pipe,
+                          struct dd_profile_segment *seg, bool wait)
+{
+   union pipe_query_result result;
+
+   if (seg->ready)
+      return true;
+
+   if (!pipe->get_query_result(pipe, seg->query, wait, &result))
+      return false;
+
+   seg->timestamp = result.u64;
+   seg->ready = true;
+   pipe->destroy_query(pipe, seg->query);
+   seg->query = NULL;
+   return true;
+}
+
+/**
+ * Write every finished segment whose timestamps are available.
+ */
+static void
+dd_profile_write_segments(struct dd_context *dctx, bool wait)
+{
+   struct dd_profile *prof = dctx->profile;
+
+   while (prof->count - prof->first >= 2) {
+      struct dd_profile_segment *seg = &prof->segments[prof->first];
+      struct dd_profile_segment *next = seg + 1;
+
+      if (!dd_profile_read_timestamp(dctx->pipe, seg, wait) ||
+          !dd_profile_read_timestamp(dctx->pipe, next, wait))
+         break;
+
+      fprintf(prof->f, "%u,%s,%u,%"PRIu64",%"PRIu64",%u,%u,%s\n",
+              seg->frame, dd_segment_names[seg->kind], seg->num_draws,
+              seg->timestamp, next->timestamp - seg->timestamp,
+              seg->width, seg->height,
+              util_format_short_name(seg->cbuf_format));
+      prof->first++;
+   }
+
+   /* Move the pending segments to the front of the array. */
+   if (prof->first) {
+      memmove(prof->segments, &prof->segments[prof->first],
+              (prof->count - prof->first) * sizeof(prof->segments[0]));
+      prof->count -= prof->first;
+      prof->first = 0;
+   }
+}
+
+/**
+ * End the current segment and start a new one of the given kind.
+ */
+void
+dd_profile_begin_segment(struct dd_context *dctx, enum dd_segment_kind kind)
+{
+   struct dd_profile *prof = dctx->profile;
+   struct pipe_context *pipe = dctx->pipe;
+   const struct pipe_framebuffer_state *fb = &dctx->framebuffer_state;
+   struct dd_profile_segment *seg;
+
+   if (!prof)
+      return;
+
+   /* Nothing happened since the last timestamp, reuse it. */
+   if (prof->count > prof->first) {
+      seg = &prof->segments[prof->count - 1];
+
+      if (seg->kind == DD_SEGMENT_DRAW && !seg->num_draws &&
+          seg->frame == prof->frame)
+         goto fill;
+   }
+
+   if (prof->count == prof->max) {
+      unsigned max = MAX2(prof->max * 2, 64);
+      struct dd_profile_segment *segments =
+         REALLOC(prof->segments, prof->max * sizeof(*segments),
+                 max * sizeof(*segments));
+
+      if (!segments)
+         return;
+      prof->segments = segments;
+      prof->max = max;
+   }
+
+   seg = &prof->segments[prof->count];
+   seg->query = pipe->create_query(pipe, PIPE_QUERY_TIMESTAMP, 0);
+   if (!seg->query)
+      return;
+
+   seg->ready = false;
+   pipe->end_query(pipe, seg->query);
+   prof->count++;
+
+fill:
+   seg->kind = kind;
+   seg->frame = prof->frame;
+   seg->num_draws = 0;
+   seg->width = fb->width;
+   seg->height = fb->height;
+   seg->cbuf_format = fb->nr_cbufs && fb->cbufs[0] ? fb->cbufs[0]->format :
+                                                      PIPE_FORMAT_NONE;
+}
+
+void
+dd_profile_add_draw(struct dd_context *dctx)
+{
+   struct dd_profile *prof = dctx->profile;
+
+   if (prof && prof->count > prof->first)
+      prof->segments[prof->count - 1].num_draws++;
+}
+
+/**
+ * Called before pipe->flush.  The end of a frame ends its last segment,
+ * and results that are already available are written.
+ */
+void
+dd_profile_flush(struct dd_context *dctx, unsigned flags)
+{
+   struct dd_profile *prof = dctx->profile;
+
+   if (!prof)
+      return;
+
+   if (flags & PIPE_FLUSH_END_OF_FRAME) {
+      dd_profile_begin_segment(dctx, DD_SEGMENT_FLUSH);
+      prof->frame++;
+   }
+
+   dd_profile_write_segments(dctx, false);
+}
+
+void
+dd_profile_init(struct dd_context *dctx)
+{
+   struct dd_screen *dscreen = dd_screen(dctx->base.screen);
+   struct pipe_screen *screen = dscreen->screen;
+   struct dd_profile *prof;
+
+   if (!screen->get_param(screen, PIPE_CAP_QUERY_TIMESTAMP)) {
+      fprintf(stderr, "dd: the driver doesn't support timestamp queries, "
+              "profiling disabled\n");
+      return;
+   }
+
+   prof = CALLOC_STRUCT(dd_profile);
+   if (!prof)
+      return;
+
+   prof->f = dd_get_debug_file(dscreen->verbose);
+   if (!prof->f) {
+      FREE(prof);
+      return;
+   }
+
+   fprintf(prof->f, "frame,kind,draws,start_ns,duration_ns,"
+           "width,height,cbuf0_format\n");
+   dctx->profile = prof;
+
+   dd_profile_begin_segment(dctx, DD_SEGMENT_DRAW);
+}
+
+void
+dd_profile_destroy(struct dd_context *dctx)
+{
+   struct dd_profile *prof = dctx->profile;
+   unsigned i;
+
+   if (!prof)
+      return;
+
+   dd_profile_begin_segment(dctx, DD_SEGMENT_FLUSH);
+   dctx->pipe->flush(dctx->pipe, NULL, 0);
+   dd_profile_write_segments(dctx, true);
+
+   for (i = prof->first; i < prof->count; i++) {
+      if (prof->segments[i].query)
+         dctx->pipe->destroy_query(dctx->pipe, prof->segments[i].query);
+   }
+
+   fclose(prof->f);
+   FREE(prof->segments);
+   FREE(prof);
+   dctx->profile = NULL;
+}
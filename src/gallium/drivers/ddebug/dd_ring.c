@@ -0,0 +1,217 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* Hang detection that is cheap enough to leave enabled.
+ *
+ * Every call that submits GPU work writes a small record into a fixed-size
+ * ring; nothing is flushed, waited for or written to disk per call.  At
+ * each pipe->flush, the fence of the previous flush is checked with the
+ * configured timeout, which lets the GPU run one flush behind the CPU.
+ * Only when that fence times out or the driver reports a device reset
+ * are the records written out, together with the driver state.
+ */
+
+#include "dd_pipe.h"
+
+#include "util/u_format.h"
+#include "util/u_memory.h"
+#include "util/u_prim.h"
+
+
+/* Must be a power of two. */
+#define DD_RING_SIZE 4096
+
+struct dd_ring
+{
+   struct dd_ring_record records[DD_RING_SIZE];
+
+   /* Total number of records ever written. */
+   unsigned num_records;
+   unsigned frame;
+
+   /* Fence of the last flush and the number of records submitted by it. */
+   struct pipe_fence_handle *fence;
+   unsigned fence_records;
+
+   /* All records before this one are known to have completed. */
+   unsigned idle_records;
+
+   /* A reset seen by dd_ring_flush, kept for the application. */
+   enum pipe_reset_status reset_status;
+};
+
+
+struct dd_ring_record *
+dd_ring_add_record(struct dd_context *dctx)
+{
+   struct dd_ring *ring = dctx->ring;
+   struct dd_ring_record *rec;
+
+   if (!ring)
+      return NULL;
+
+   rec = &ring->records[ring->num_records % DD_RING_SIZE];
+   memset(rec, 0, sizeof(*rec));
+   rec->index = ring->num_records++;
+   rec->frame = ring->frame;
+   rec->width = dctx->framebuffer_state.width;
+   rec->height = dctx->framebuffer_state.height;
+   return rec;
+}
+
+static void
+dd_ring_dump(struct dd_context *dctx, const char *cause, unsigned flags)
+{
+   struct dd_screen *dscreen = dd_screen(dctx->base.screen);
+   struct dd_ring *ring = dctx->ring;
+   struct pipe_screen *screen = dctx->pipe->screen;
+   unsigned first = ring->num_records > DD_RING_SIZE ?
+                    ring->num_records - DD_RING_SIZE : 0;
+   unsigned i;
+   FILE *f = dd_get_debug_file(dscreen->verbose);
+
+   if (!f)
+      return;
+
+   fprintf(f, "Driver vendor: %s\n", screen->get_vendor(screen));
+   fprintf(f, "Device vendor: %s\n", screen->get_device_vendor(screen));
+   fprintf(f, "Device name: %s\n\n", screen->get_name(screen));
+   fprintf(f, "dd: %s.\n", cause);
+   fprintf(f, "Calls before #%u completed, calls up to #%u were flushed.\n\n",
+           ring->idle_records, ring->fence_records);
+
+   fprintf(f, "call,frame,name,mode,start,count,instances,indexed,"
+           "vs,fs,width,height,cbuf0_format\n");
+
+   for (i = first; i < ring->num_records; i++) {
+      struct dd_ring_record *rec = &ring->records[i % DD_RING_SIZE];
+
+      fprintf(f, "%u,%u,%s,%s,%u,%u,%u,%u,%p,%p,%u,%u,%s%s\n",
+              rec->index, rec->frame, rec->name,
+              rec->is_draw ? u_prim_name(rec->mode) : "",
+              rec->start, rec->count, rec->instance_count, rec->indexed,
+              rec->vs, rec->fs, rec->width, rec->height,
+              util_format_short_name(rec->cbuf_format),
+              i < ring->idle_records ? "" : " <-- pending");
+   }
+   fprintf(f, "\n");
+
+   if (dctx->pipe->dump_debug_state) {
+      fprintf(f, "\nDriver-specific state:\n\n");
+      dctx->pipe->dump_debug_state(dctx->pipe, f, flags);
+   }
+   fclose(f);
+}
+
+/**
+ * pipe->flush replacement.  Check that the previous flush has completed
+ * and that the device hasn't been reset.
+ */
+void
+dd_ring_flush(struct dd_context *dctx, struct pipe_fence_handle **fence,
+              unsigned flags)
+{
+   struct dd_ring *ring = dctx->ring;
+   struct pipe_context *pipe = dctx->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   uint64_t timeout_ms = dd_screen(dctx->base.screen)->timeout_ms;
+   struct pipe_fence_handle *new_fence = NULL;
+
+   pipe->flush(pipe, &new_fence, flags);
+   if (fence)
+      screen->fence_reference(screen, fence, new_fence);
+
+   if (flags & PIPE_FLUSH_END_OF_FRAME)
+      ring->frame++;
+
+   if (ring->fence) {
+      if (!screen->fence_finish(screen, ring->fence, timeout_ms * 1000000)) {
+         fprintf(stderr, "dd: GPU hang detected!\n");
+         dd_ring_dump(dctx, "GPU hang detected in pipe->flush()",
+                      PIPE_DEBUG_DEVICE_IS_HUNG);
+
+         /* Terminate the process to prevent future hangs. */
+         dd_kill_process();
+      }
+      ring->idle_records = ring->fence_records;
+   }
+
+   screen->fence_reference(screen, &ring->fence, NULL);
+   ring->fence = new_fence;
+   ring->fence_records = ring->num_records;
+
+   /* The application may recover from a reset, so don't abort. */
+   if (pipe->get_device_reset_status &&
+       ring->reset_status == PIPE_NO_RESET) {
+      ring->reset_status = pipe->get_device_reset_status(pipe);
+
+      if (ring->reset_status != PIPE_NO_RESET) {
+         fprintf(stderr, "dd: GPU reset detected!\n");
+         dd_ring_dump(dctx, "GPU reset detected in pipe->flush()",
+                      PIPE_DEBUG_DEVICE_IS_HUNG);
+      }
+   }
+}
+
+/**
+ * Return the reset status to the application.  A reset that was already
+ * seen by dd_ring_flush is reported once.
+ */
+enum pipe_reset_status
+dd_ring_get_device_reset_status(struct dd_context *dctx)
+{
+   struct dd_ring *ring = dctx->ring;
+   struct pipe_context *pipe = dctx->pipe;
+   enum pipe_reset_status status = ring->reset_status;
+
+   ring->reset_status = PIPE_NO_RESET;
+   if (status != PIPE_NO_RESET)
+      return status;
+   return pipe->get_device_reset_status(pipe);
+}
+
+void
+dd_ring_init(struct dd_context *dctx)
+{
+   dctx->ring = CALLOC_STRUCT(dd_ring);
+}
+
+void
+dd_ring_destroy(struct dd_context *dctx)
+{
+   struct dd_ring *ring = dctx->ring;
+
+   if (!ring)
+      return;
+
+   if (ring->fence) {
+      struct pipe_screen *screen = dctx->pipe->screen;
+
+      screen->fence_reference(screen, &ring->fence, NULL);
+   }
+   FREE(ring);
+   dctx->ring = NULL;
+}
@@ -273,6 +273,8 @@ ddebug_screen_create(struct pipe_screen *screen)
    struct dd_screen *dscreen;
    const char *option = debug_get_option("GALLIUM_DDEBUG", NULL);
    bool dump_always = option && !strncmp(option, "always", 6);
+   bool profile = option && !strncmp(option, "profile", 7);
+   bool ring = option && !strncmp(option, "ring", 4);
    bool no_flush = option && strstr(option, "noflush");
    bool help = option && !strcmp(option, "help");
    unsigned timeout = 0;
@@ -291,6 +293,19 @@ ddebug_screen_create(struct pipe_screen *screen)
       puts("    fence timeout and dump context and driver information into");
       puts("    $HOME/"DD_DIR"/ when a hang is detected.");
       puts("");
+      puts("  GALLIUM_DDEBUG=\"profile [verbose]\"");
+      puts("    Write a GPU timeline of every context into $HOME/"DD_DIR"/,");
+      puts("    measured with timestamp queries. Each CSV record is a segment of");
+      puts("    work between framebuffer changes, blits, copies, clears and");
+      puts("    the ends of frames.");
+      puts("");
+      puts("  GALLIUM_DDEBUG=\"ring [timeout in ms] [verbose]\"");
+      puts("    Record every draw call into an in-memory ring without flushing, and");
+      puts("    dump the recent calls and driver information into $HOME/"DD_DIR"/");
+      puts("    only when a fence of the previous flush exceeds the timeout (1000 ms");
+      puts("    by default) or the driver reports a device reset. The overhead is low");
+      puts("    enough to leave it enabled.");
+      puts("");
       puts("  If 'noflush' is specified, do not flush on every draw call. In hang");
       puts("  detection mode, this only detect hangs in pipe->flush.");
       puts("  If 'verbose' is specified, additional information is written to stderr.");
@@ -303,8 +318,13 @@ ddebug_screen_create(struct pipe_screen *screen)
 
    if (!option)
       return screen;
-   if (!dump_always && sscanf(option, "%u", &timeout) != 1)
+   if (ring) {
+      if (sscanf(option + 4, "%u", &timeout) != 1)
+         timeout = 1000;
+   } else if (!dump_always && !profile &&
+              sscanf(option, "%u", &timeout) != 1) {
       return screen;
+   }
 
    dscreen = CALLOC_STRUCT(dd_screen);
    if (!dscreen)
@@ -342,7 +362,14 @@ ddebug_screen_create(struct pipe_screen *screen)
 
    dscreen->screen = screen;
    dscreen->timeout_ms = timeout;
-   dscreen->mode = dump_always ? DD_DUMP_ALL_CALLS : DD_DETECT_HANGS;
+   if (profile)
+      dscreen->mode = DD_PROFILE_TIMESTAMPS;
+   else if (ring)
+      dscreen->mode = DD_DETECT_HANGS_RING;
+   else if (dump_always)
+      dscreen->mode = DD_DUMP_ALL_CALLS;
+   else
+      dscreen->mode = DD_DETECT_HANGS;
    dscreen->no_flush = no_flush;
    dscreen->verbose = strstr(option, "verbose") != NULL;
 
@@ -354,6 +381,13 @@ ddebug_screen_create(struct pipe_screen *screen)
       fprintf(stderr, "Gallium debugger active. "
               "The hang detection timout is %i ms.\n", timeout);
       break;
+   case DD_PROFILE_TIMESTAMPS:
+      fprintf(stderr, "Gallium debugger active. Profiling with timestamps.\n");
+      break;
+   case DD_DETECT_HANGS_RING:
+      fprintf(stderr, "Gallium debugger active. Recording calls, "
+              "the hang detection timeout is %i ms.\n", timeout);
+      break;
    default:
       assert(0);
    }
@@ -29,6 +29,7 @@
 #define DD_UTIL_H
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -71,4 +72,14 @@ dd_get_debug_file(bool verbose)
    return f;
 }
 
+static inline void
+dd_kill_process(void)
+{
+   sync();
+   fprintf(stderr, "dd: Aborting the process...\n");
+   fflush(stdout);
+   fflush(stderr);
+   abort();
+}
+
 #endif /* DD_UTIL_H */
@@ -170,17 +170,49 @@ calculate_tiles(struct fd_context *ctx)
 				zsbuf_cpp[0], width, height);
 	}
 
-	/* then find a bin width/height that satisfies the memory
-	 * constraints:
+	/* then find the bin layout satisfying the memory constraints with
+	 * the fewest bins, since every bin replays the whole draw IB.  For
+	 * the same number of bins, prefer the squarest bins:
 	 */
-	while (total_size(cbuf_cpp, zsbuf_cpp, bin_w, bin_h, gmem) > gmem_size) {
-		if (bin_w > bin_h) {
-			nbins_x++;
-			bin_w = align(width / nbins_x, 32);
-		} else {
-			nbins_y++;
-			bin_h = align(height / nbins_y, 32);
+	if (total_size(cbuf_cpp, zsbuf_cpp, bin_w, bin_h, gmem) > gmem_size) {
+		uint32_t best_nbins = ~0, best_w = 0, best_h = 0;
+		uint32_t best_nx = 0, best_ny = 0;
+		uint32_t nx;
+
+		for (nx = nbins_x; nx < best_nbins; nx++) {
+			uint32_t w = align((width + nx - 1) / nx, 32);
+			uint32_t ny = 1, h = align(height, 32);
+			uint32_t n;
+
+			while (total_size(cbuf_cpp, zsbuf_cpp, w, h, gmem) > gmem_size &&
+					h > 32) {
+				ny++;
+				h = align((height + ny - 1) / ny, 32);
+			}
+
+			n = nx * ny;
+			if (total_size(cbuf_cpp, zsbuf_cpp, w, h, gmem) <= gmem_size &&
+					(n < best_nbins || (n == best_nbins &&
+					abs((int)w - (int)h) < abs((int)best_w - (int)best_h)))) {
+				best_nbins = n;
+				best_nx = nx;
+				best_ny = ny;
+				best_w = w;
+				best_h = h;
+			}
+
+			if (w <= 32)
+				break;
 		}
+
+		assert(best_nx);
+		nbins_x = best_nx;
+		nbins_y = best_ny;
+		bin_w = best_w;
+		bin_h = best_h;
+
+		/* total_size() also lays out the buffers in gmem: */
+		total_size(cbuf_cpp, zsbuf_cpp, bin_w, bin_h, gmem);
 	}
 
 	DBG("using %d bins of size %dx%d", nbins_x*nbins_y, bin_w, bin_h);
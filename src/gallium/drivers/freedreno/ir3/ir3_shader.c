@@ -225,6 +225,7 @@ ir3_shader_variant(struct ir3_shader *shader, struct ir3_shader_key key,
 	case SHADER_FRAGMENT:
 	case SHADER_COMPUTE:
 		key.binning_pass = false;
+		key.vclamp_color = false;
 		if (key.has_per_samp) {
 			key.vsaturate_s = 0;
 			key.vsaturate_t = 0;
@@ -236,6 +237,7 @@ ir3_shader_variant(struct ir3_shader *shader, struct ir3_shader_key key,
 		key.color_two_side = false;
 		key.half_precision = false;
 		key.rasterflat = false;
+		key.fclamp_color = false;
 		if (key.has_per_samp) {
 			key.fsaturate_s = 0;
 			key.fsaturate_t = 0;
@@ -49,6 +49,15 @@ enum ilo_builder_writer_flags {
    WRITER_FLAG_MAP       = 1 << 2,
 };
 
+/*
+ * The batch writer starts small and grows when batches fill up.  Surface and
+ * dynamic states are stolen from the end of the batch buffer, which is also
+ * Surface State Base Address, and binding table pointers are 16-bit offsets
+ * from it.  The batch buffer must not grow beyond 64KB.
+ */
+#define BATCH_INITIAL_SIZE (sizeof(uint32_t) * 8192)
+#define BATCH_MAX_SIZE     (sizeof(uint32_t) * 16384)
+
 /**
  * Set the initial size and flags of a writer.
  */
@@ -60,7 +69,7 @@ ilo_builder_writer_init(struct ilo_builder *builder,
 
    switch (which) {
    case ILO_BUILDER_WRITER_BATCH:
-      writer->size = sizeof(uint32_t) * 8192;
+      writer->size = BATCH_INITIAL_SIZE;
       break;
    case ILO_BUILDER_WRITER_INSTRUCTION:
       /*
@@ -164,12 +173,33 @@ ilo_builder_writer_alloc_and_map(struct ilo_builder *builder,
 
    /* allocate a new bo when not appending */
    if (!(writer->flags & WRITER_FLAG_APPEND) || !writer->bo) {
+      unsigned size = writer->size;
       struct intel_bo *bo;
 
-      bo = alloc_writer_bo(builder->winsys, which, writer->size);
+      /*
+       * A batch that was more than 3/4 full was likely submitted for running
+       * out of space.  Every submission makes the next batch re-emit all
+       * states, so use a larger batch for draw-heavy workloads.
+       */
+      if (which == ILO_BUILDER_WRITER_BATCH && size < BATCH_MAX_SIZE &&
+          (writer->used + writer->stolen) * 4 > size * 3)
+         size <<= 1;
+
+      bo = alloc_writer_bo(builder->winsys, which, size);
+      if (!bo && size != writer->size) {
+         size = writer->size;
+         bo = alloc_writer_bo(builder->winsys, which, size);
+      }
+
       if (bo) {
          intel_bo_unref(writer->bo);
          writer->bo = bo;
+
+         if (size != writer->size && !(writer->flags & WRITER_FLAG_MAP)) {
+            FREE(writer->ptr);
+            writer->ptr = NULL;
+         }
+         writer->size = size;
       } else if (writer->bo) {
          /* reuse the old bo */
          ilo_builder_writer_discard(builder, which);
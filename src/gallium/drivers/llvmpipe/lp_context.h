@@ -139,6 +139,9 @@ struct llvmpipe_context {
    unsigned tex_timestamp;
    boolean no_rast;
 
+   /** The bound fragment shader variant */
+   struct lp_fragment_shader_variant *fs_variant;
+
    /** List of all fragment shader variants */
    struct lp_fs_variant_list_item fs_variants_list;
    unsigned nr_fs_variants;
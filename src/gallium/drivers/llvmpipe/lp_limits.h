@@ -61,7 +61,28 @@
 #define LP_MAX_WIDTH  (1 << (LP_MAX_TEXTURE_LEVELS - 1))
 
 
-#define LP_MAX_THREADS 16
+/**
+ * Max number of rasterizer threads.  Bins are handed out to the threads
+ * with a lock-free counter, so this is mostly bounded by the per-thread
+ * query counters and task state.
+ */
+#define LP_MAX_THREADS 64
+
+
+/**
+ * Max number of triangle setup threads.  Setup of a triangle is cheap
+ * compared to binning it, which happens on the draw thread, so more
+ * threads than this don't pay off.
+ */
+#define LP_MAX_SETUP_THREADS 8
+
+
+/**
+ * Scenes with at most this many non-empty bins are rasterized on the
+ * calling thread, waking up the rasterizer threads and waiting for them
+ * costs more than the rasterization itself then.
+ */
+#define LP_MAX_DIRECT_RAST_BINS 16
 
 
 /**
@@ -56,9 +56,14 @@ struct lp_counters
    unsigned nr_fully_covered_4;
    unsigned nr_partially_covered_4;
    unsigned nr_non_empty_4;
+   unsigned nr_hiz_rejected;
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
 
+   unsigned nr_scenes;
+   unsigned nr_scene_flush_full;       /**< scene ran out of storage */
+   unsigned nr_scene_flush_resources;  /**< scene referenced too much texture data */
+
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
    unsigned nr_color_tile_store;
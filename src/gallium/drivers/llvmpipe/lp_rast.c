@@ -32,6 +32,7 @@
 #include "util/u_surface.h"
 #include "util/u_pack_color.h"
 #include "util/u_string.h"
+#include "util/u_cpu_detect.h"
 
 #include "os/os_time.h"
 
@@ -82,6 +83,33 @@ lp_rast_end( struct lp_rasterizer *rast )
 }
 
 
+/**
+ * Depth precision of a zsbuf format, or -1 if hierarchical Z isn't
+ * supported for it.  Unorm depth is rounded when converted, so fragments
+ * within one unit of the stored value may still pass.
+ */
+static float
+hiz_format_epsilon(enum pipe_format format)
+{
+   switch (format) {
+   case PIPE_FORMAT_Z16_UNORM:
+      return 1.0f / 0xffff;
+   case PIPE_FORMAT_Z24_UNORM_S8_UINT:
+   case PIPE_FORMAT_Z24X8_UNORM:
+   case PIPE_FORMAT_S8_UINT_Z24_UNORM:
+   case PIPE_FORMAT_X8Z24_UNORM:
+      return 1.0f / 0xffffff;
+   case PIPE_FORMAT_Z32_UNORM:
+      return 1.0f / 0xffffffffu;
+   case PIPE_FORMAT_Z32_FLOAT:
+   case PIPE_FORMAT_Z32_FLOAT_S8X24_UINT:
+      return 0.0f;
+   default:
+      return -1.0f;
+   }
+}
+
+
 /**
  * Beginning rasterization of a tile.
  * \param x  window X position of the tile, in pixels
@@ -111,14 +139,19 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
    for (i = 0; i < task->scene->fb.nr_cbufs; i++) {
       if (task->scene->fb.cbufs[i]) {
          task->color_tiles[i] = scene->cbufs[i].map +
-                                scene->cbufs[i].stride * task->y +
-                                scene->cbufs[i].format_bytes * task->x;
+                                scene->cbufs[i].tile_y_stride * y +
+                                scene->cbufs[i].tile_x_stride * x;
       }
    }
+   task->hiz_enabled = FALSE;
+   task->hiz_valid = 0;
+   task->hiz_exact = 0;
    if (task->scene->fb.zsbuf) {
       task->depth_tile = scene->zsbuf.map +
-                         scene->zsbuf.stride * task->y +
-                         scene->zsbuf.format_bytes * task->x;
+                         scene->zsbuf.tile_y_stride * y +
+                         scene->zsbuf.tile_x_stride * x;
+      task->hiz_epsilon = hiz_format_epsilon(scene->fb.zsbuf->format);
+      task->hiz_enabled = task->hiz_epsilon >= 0.0f;
    }
 }
 
@@ -152,12 +185,12 @@ lp_rast_clear_color(struct lp_rasterizer_task *task,
           __FUNCTION__, format, uc.ui[0], uc.ui[1], uc.ui[2], uc.ui[3]);
 
 
-   util_fill_box(scene->cbufs[cbuf].map,
+   util_fill_box(task->color_tiles[cbuf],
                  format,
                  scene->cbufs[cbuf].stride,
                  scene->cbufs[cbuf].layer_stride,
-                 task->x,
-                 task->y,
+                 0,
+                 0,
                  0,
                  task->width,
                  task->height,
@@ -202,6 +235,9 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
       uint8_t *dst_layer = task->depth_tile;
       block_size = util_format_get_blocksize(scene->fb.zsbuf->format);
 
+      task->hiz_valid = 0;
+      task->hiz_exact = 0;
+
       clear_value &= clear_mask;
 
       for (layer = 0; layer <= scene->fb_max_layer; layer++) {
@@ -299,7 +335,7 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    const struct lp_rast_state *state;
    struct lp_fragment_shader_variant *variant;
    const unsigned tile_x = task->x, tile_y = task->y;
-   unsigned x, y;
+   unsigned bx, by, x, y;
 
    if (inputs->disable) {
       /* This command was partially binned and has been disabled */
@@ -315,53 +351,68 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    }
    variant = state->variant;
 
-   /* render the whole 64x64 tile in 4x4 chunks */
-   for (y = 0; y < task->height; y += 4){
-      for (x = 0; x < task->width; x += 4) {
-         uint8_t *color[PIPE_MAX_COLOR_BUFS];
-         unsigned stride[PIPE_MAX_COLOR_BUFS];
-         uint8_t *depth = NULL;
-         unsigned depth_stride = 0;
-         unsigned i;
+   /* render the whole 64x64 tile in 4x4 chunks, skipping the 16x16 blocks
+    * known to fail the depth test
+    */
+   for (by = 0; by < task->height; by += LP_HIZ_BLOCK_SIZE) {
+      for (bx = 0; bx < task->width; bx += LP_HIZ_BLOCK_SIZE) {
+         const unsigned y_end = MIN2(by + LP_HIZ_BLOCK_SIZE, task->height);
+         const unsigned x_end = MIN2(bx + LP_HIZ_BLOCK_SIZE, task->width);
+
+         if (lp_rast_hiz_occluded(task, inputs, tile_x + bx, tile_y + by,
+                                  LP_HIZ_BLOCK_SIZE))
+            continue;
+
+         lp_rast_hiz_write(task, variant, inputs, tile_x + bx, tile_y + by);
+
+         for (y = by; y < y_end; y += 4) {
+            for (x = bx; x < x_end; x += 4) {
+               uint8_t *color[PIPE_MAX_COLOR_BUFS];
+               unsigned stride[PIPE_MAX_COLOR_BUFS];
+               uint8_t *depth = NULL;
+               unsigned depth_stride = 0;
+               unsigned i;
+
+               /* color buffer */
+               for (i = 0; i < scene->fb.nr_cbufs; i++){
+                  if (scene->fb.cbufs[i]) {
+                     stride[i] = scene->cbufs[i].stride;
+                     color[i] = lp_rast_get_color_block_pointer(task, i, tile_x + x,
+                                                                tile_y + y, inputs->layer);
+                  }
+                  else {
+                     stride[i] = 0;
+                     color[i] = NULL;
+                  }
+               }
 
-         /* color buffer */
-         for (i = 0; i < scene->fb.nr_cbufs; i++){
-            if (scene->fb.cbufs[i]) {
-               stride[i] = scene->cbufs[i].stride;
-               color[i] = lp_rast_get_color_block_pointer(task, i, tile_x + x,
+               /* depth buffer */
+               if (scene->zsbuf.map) {
+                  depth = lp_rast_get_depth_block_pointer(task, tile_x + x,
                                                           tile_y + y, inputs->layer);
-            }
-            else {
-               stride[i] = 0;
-               color[i] = NULL;
-            }
-         }
+                  depth_stride = scene->zsbuf.stride;
+               }
 
-         /* depth buffer */
-         if (scene->zsbuf.map) {
-            depth = lp_rast_get_depth_block_pointer(task, tile_x + x,
-                                                    tile_y + y, inputs->layer);
-            depth_stride = scene->zsbuf.stride;
+               /* Propagate non-interpolated raster state. */
+               task->thread_data.raster_state.viewport_index = inputs->viewport_index;
+
+               /* run shader on 4x4 block */
+               BEGIN_JIT_CALL(state, task);
+               variant->jit_function[RAST_WHOLE]( &state->jit_context,
+                                                  tile_x + x, tile_y + y,
+                                                  inputs->frontfacing,
+                                                  GET_A0(inputs),
+                                                  GET_DADX(inputs),
+                                                  GET_DADY(inputs),
+                                                  color,
+                                                  depth,
+                                                  0xffff,
+                                                  &task->thread_data,
+                                                  stride,
+                                                  depth_stride);
+               END_JIT_CALL();
+            }
          }
-
-         /* Propagate non-interpolated raster state. */
-         task->thread_data.raster_state.viewport_index = inputs->viewport_index;
-
-         /* run shader on 4x4 block */
-         BEGIN_JIT_CALL(state, task);
-         variant->jit_function[RAST_WHOLE]( &state->jit_context,
-                                            tile_x + x, tile_y + y,
-                                            inputs->frontfacing,
-                                            GET_A0(inputs),
-                                            GET_DADX(inputs),
-                                            GET_DADY(inputs),
-                                            color,
-                                            depth,
-                                            0xffff,
-                                            &task->thread_data,
-                                            stride,
-                                            depth_stride);
-         END_JIT_CALL();
       }
    }
 }
@@ -449,6 +500,8 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
       /* always count this not worth bothering? */
       task->ps_invocations += 1 * variant->ps_inv_multiplier;
 
+      lp_rast_hiz_write(task, variant, inputs, x, y);
+
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
 
@@ -472,6 +525,150 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
 
 
 
+/**
+ * Compute the maximum depth of a hierarchical Z block of the current tile
+ * (layer 0) from the depth buffer contents.
+ */
+static void
+hiz_update_block(struct lp_rasterizer_task *task, unsigned bx, unsigned by)
+{
+   const struct lp_scene *scene = task->scene;
+   const unsigned x0 = bx * LP_HIZ_BLOCK_SIZE;
+   const unsigned y0 = by * LP_HIZ_BLOCK_SIZE;
+   const unsigned stride = scene->zsbuf.stride;
+   const unsigned index = by * LP_HIZ_BLOCKS_X + bx;
+   unsigned width, height, i, j;
+   const uint8_t *depth;
+   uint32_t umax = 0;
+   float zmax = 0.0f;
+
+   /* Blocks outside the framebuffer never get any fragments. */
+   width = x0 < task->width ? MIN2(LP_HIZ_BLOCK_SIZE, task->width - x0) : 0;
+   height = y0 < task->height ? MIN2(LP_HIZ_BLOCK_SIZE, task->height - y0) : 0;
+
+   depth = task->depth_tile + y0 * stride + x0 * scene->zsbuf.format_bytes;
+
+   switch (scene->fb.zsbuf->format) {
+   case PIPE_FORMAT_Z16_UNORM:
+      for (i = 0; i < height; i++, depth += stride) {
+         const uint16_t *row = (const uint16_t *)depth;
+         for (j = 0; j < width; j++)
+            umax = MAX2(umax, row[j]);
+      }
+      zmax = umax / (float)0xffff;
+      break;
+   case PIPE_FORMAT_Z24_UNORM_S8_UINT:
+   case PIPE_FORMAT_Z24X8_UNORM:
+      for (i = 0; i < height; i++, depth += stride) {
+         const uint32_t *row = (const uint32_t *)depth;
+         for (j = 0; j < width; j++)
+            umax = MAX2(umax, row[j] & 0xffffff);
+      }
+      zmax = umax / (float)0xffffff;
+      break;
+   case PIPE_FORMAT_S8_UINT_Z24_UNORM:
+   case PIPE_FORMAT_X8Z24_UNORM:
+      for (i = 0; i < height; i++, depth += stride) {
+         const uint32_t *row = (const uint32_t *)depth;
+         for (j = 0; j < width; j++)
+            umax = MAX2(umax, row[j] >> 8);
+      }
+      zmax = umax / (float)0xffffff;
+      break;
+   case PIPE_FORMAT_Z32_UNORM:
+      for (i = 0; i < height; i++, depth += stride) {
+         const uint32_t *row = (const uint32_t *)depth;
+         for (j = 0; j < width; j++)
+            umax = MAX2(umax, row[j]);
+      }
+      zmax = (float)(umax / (double)0xffffffffu);
+      break;
+   case PIPE_FORMAT_Z32_FLOAT:
+   case PIPE_FORMAT_Z32_FLOAT_S8X24_UINT:
+      {
+         const unsigned step = scene->zsbuf.format_bytes / 4;
+         for (i = 0; i < height; i++, depth += stride) {
+            const float *row = (const float *)depth;
+            for (j = 0; j < width; j++) {
+               /* NaNs in the depth buffer fail any test, skip them */
+               if (row[j * step] > zmax)
+                  zmax = row[j * step];
+            }
+         }
+      }
+      break;
+   default:
+      assert(0);
+      return;
+   }
+
+   task->hiz_zmax[index] = zmax;
+   task->hiz_valid |= 1 << index;
+   task->hiz_exact |= 1 << index;
+}
+
+
+/**
+ * Check whether a primitive is behind the depth bounds of all hierarchical
+ * Z blocks overlapping a size x size region.  The primitive's nearest depth
+ * over the region is taken from the depth plane, which is exact for
+ * interpolated depth.
+ * \param x, y location of the region in window coords
+ * \param refresh  recompute inexact bounds from the depth buffer
+ */
+boolean
+lp_rast_hiz_test(struct lp_rasterizer_task *task,
+                 const struct lp_rast_shader_inputs *inputs,
+                 int x, int y, unsigned size,
+                 boolean refresh)
+{
+   const float (*a0)[4] = GET_A0(inputs);
+   const float (*dadx)[4] = GET_DADX(inputs);
+   const float (*dady)[4] = GET_DADY(inputs);
+   const float dzdx = dadx[0][2];
+   const float dzdy = dady[0][2];
+   const int tx = x - task->x, ty = y - task->y;
+   const unsigned bx0 = tx >> LP_HIZ_BLOCK_ORDER;
+   const unsigned by0 = ty >> LP_HIZ_BLOCK_ORDER;
+   const unsigned bx1 = MIN2((tx + size - 1) >> LP_HIZ_BLOCK_ORDER, LP_HIZ_BLOCKS_X - 1);
+   const unsigned by1 = MIN2((ty + size - 1) >> LP_HIZ_BLOCK_ORDER, LP_HIZ_BLOCKS_X - 1);
+   float zmax = 0.0f, zmin, zx, zy, slack;
+   unsigned bx, by;
+
+   assert(tx >= 0 && ty >= 0 && tx < TILE_SIZE && ty < TILE_SIZE);
+
+   for (by = by0; by <= by1; by++) {
+      for (bx = bx0; bx <= bx1; bx++) {
+         const unsigned index = by * LP_HIZ_BLOCKS_X + bx;
+
+         if (!(task->hiz_valid & (1 << index)) ||
+             (refresh && !(task->hiz_exact & (1 << index))))
+            hiz_update_block(task, bx, by);
+
+         zmax = MAX2(zmax, task->hiz_zmax[index]);
+      }
+   }
+
+   /* The plane is linear, so its minimum over the region is at a corner. */
+   zx = dzdx * (dzdx < 0.0f ? x + size : x);
+   zy = dzdy * (dzdy < 0.0f ? y + size : y);
+   zmin = a0[0][2] + zx + zy;
+
+   /* Unorm conversion clamps to 1.0.  Allow for the rounding of the jit
+    * code's evaluation of the plane, which doesn't happen in this order.
+    */
+   zmin = MIN2(zmin, 1.0f);
+   slack = 8.0f * FLT_EPSILON * (fabsf(a0[0][2]) + fabsf(zx) + fabsf(zy));
+
+   if (zmin > zmax + task->hiz_epsilon + slack) {
+      LP_COUNT(nr_hiz_rejected);
+      return TRUE;
+   }
+
+   return FALSE;
+}
+
+
 /**
  * Begin a new occlusion query.
  * This is a bin command put in all bins.
@@ -713,6 +910,28 @@ rasterize_scene(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Whether a scene is small enough to rasterize without the threads, like
+ * renders to thumbnail sized framebuffers or a few small draws.
+ */
+static boolean
+rasterize_directly(const struct lp_scene *scene)
+{
+   unsigned num_bins = 0;
+   unsigned i, j;
+
+   for (j = 0; j < scene->tiles_y; j++) {
+      for (i = 0; i < scene->tiles_x; i++) {
+         if (!is_empty_bin(&scene->tile[i][j]) &&
+             ++num_bins > LP_MAX_DIRECT_RAST_BINS)
+            return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+
 /**
  * Called by setup module when it has something for us to render.
  */
@@ -722,7 +941,13 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 {
    LP_DBG(DEBUG_SETUP, "%s\n", __FUNCTION__);
 
-   if (rast->num_threads == 0) {
+   /* The threads are idle until the scene is queued, and the caller waits
+    * for it to finish anyway, so small scenes can use the first thread's
+    * task on the calling thread.
+    */
+   rast->direct = rast->num_threads == 0 || rasterize_directly(scene);
+
+   if (rast->direct) {
       /* no threading */
       unsigned fpstate = util_fpstate_get();
 
@@ -735,6 +960,13 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 
       rasterize_scene( &rast->tasks[0], scene );
 
+      /* The fence expects to be signalled by every thread. */
+      if (scene->fence) {
+         unsigned i;
+         for (i = 1; i < rast->num_threads; i++)
+            lp_fence_signal(scene->fence);
+      }
+
       lp_rast_end( rast );
 
       util_fpstate_set(fpstate);
@@ -760,7 +992,7 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 void
 lp_rast_finish( struct lp_rasterizer *rast )
 {
-   if (rast->num_threads == 0) {
+   if (rast->direct) {
       /* nothing to do */
    }
    else {
@@ -792,6 +1024,13 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
    util_snprintf(thread_name, sizeof thread_name, "llvmpipe-%u", task->thread_index);
    pipe_thread_setname(thread_name);
 
+   /* Keep the thread on one CPU, and thus on one NUMA node.  The
+    * per-thread format cache is first touched here, so it ends up being
+    * local memory too.
+    */
+   if (rast->pin_threads)
+      pipe_thread_set_cpu(task->thread_index % util_cpu_caps.nr_cpus);
+
    /* Make sure that denorms are treated like zeros. This is 
     * the behavior required by D3D10. OpenGL doesn't care.
     */
@@ -906,6 +1145,7 @@ lp_rast_create( unsigned num_threads )
    rast->num_threads = num_threads;
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
+   rast->pin_threads = debug_get_bool_option("LP_PIN_THREADS", FALSE);
 
    create_rast_threads(rast);
 
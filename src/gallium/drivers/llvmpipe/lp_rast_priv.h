@@ -76,6 +76,14 @@ extern const struct lp_rasterizer_task *jit_task;
 struct lp_rasterizer;
 struct cmd_bin;
 
+/**
+ * Hierarchical Z block size.  A depth bound is kept for each block of
+ * LP_HIZ_BLOCK_SIZE x LP_HIZ_BLOCK_SIZE pixels of the current tile.
+ */
+#define LP_HIZ_BLOCK_ORDER 4
+#define LP_HIZ_BLOCK_SIZE (1 << LP_HIZ_BLOCK_ORDER)
+#define LP_HIZ_BLOCKS_X (TILE_SIZE / LP_HIZ_BLOCK_SIZE)
+
 /**
  * Per-thread rasterization state
  */
@@ -102,6 +110,17 @@ struct lp_rasterizer_task
    uint64_t ps_invocations;
    uint8_t ps_inv_multiplier;
 
+   /**
+    * Hierarchical Z state of the current tile (layer 0 only), one bit or
+    * value per block.  Writes which can only lower depth values keep
+    * hiz_zmax an upper bound, but make it inexact.
+    */
+   boolean hiz_enabled;     /**< zsbuf format supported */
+   float hiz_epsilon;       /**< depth precision of the zsbuf format */
+   unsigned hiz_valid;      /**< hiz_zmax is an upper bound of the depth */
+   unsigned hiz_exact;      /**< hiz_zmax is the maximum depth */
+   float hiz_zmax[LP_HIZ_BLOCKS_X * LP_HIZ_BLOCKS_X];
+
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
 };
@@ -129,8 +148,14 @@ struct lp_rasterizer
    unsigned num_threads;
    pipe_thread threads[LP_MAX_THREADS];
 
+   /** The last scene was rasterized on the calling thread */
+   boolean direct;
+
    /** For synchronizing the rasterization threads */
    pipe_barrier barrier;
+
+   /** Pin each thread to its own CPU (LP_PIN_THREADS) */
+   boolean pin_threads;
 };
 
 
@@ -217,6 +242,59 @@ lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
 
 
 
+boolean
+lp_rast_hiz_test(struct lp_rasterizer_task *task,
+                 const struct lp_rast_shader_inputs *inputs,
+                 int x, int y, unsigned size,
+                 boolean refresh);
+
+
+/**
+ * Check whether the depth test fails for all fragments of a primitive in
+ * a size x size region, using the hierarchical Z bounds of the tile.
+ * \param x, y location of the region in window coords
+ */
+static inline boolean
+lp_rast_hiz_occluded(struct lp_rasterizer_task *task,
+                     const struct lp_rast_shader_inputs *inputs,
+                     int x, int y, unsigned size)
+{
+   const struct lp_fragment_shader_variant *variant = task->state->variant;
+
+   if (!variant->hiz_test || !task->hiz_enabled || inputs->layer != 0)
+      return FALSE;
+
+   /* Primitives which don't write depth (e.g. after a depth prepass) are
+    * worth an exact bound, those which do would invalidate it right away.
+    */
+   return lp_rast_hiz_test(task, inputs, x, y, size,
+                           variant->hiz_write == LP_HIZ_WRITE_NONE);
+}
+
+
+/**
+ * Update the hierarchical Z state of the block containing a 4x4 block
+ * the shader is about to be run on.
+ * \param x, y location of 4x4 block in window coords
+ */
+static inline void
+lp_rast_hiz_write(struct lp_rasterizer_task *task,
+                  const struct lp_fragment_shader_variant *variant,
+                  const struct lp_rast_shader_inputs *inputs,
+                  unsigned x, unsigned y)
+{
+   if (variant->hiz_write != LP_HIZ_WRITE_NONE && inputs->layer == 0) {
+      unsigned bx = (x % TILE_SIZE) >> LP_HIZ_BLOCK_ORDER;
+      unsigned by = (y % TILE_SIZE) >> LP_HIZ_BLOCK_ORDER;
+      unsigned bit = 1 << (by * LP_HIZ_BLOCKS_X + bx);
+
+      task->hiz_exact &= ~bit;
+      if (variant->hiz_write == LP_HIZ_WRITE_ANY)
+         task->hiz_valid &= ~bit;
+   }
+}
+
+
 /**
  * Shade all pixels in a 4x4 block.  The fragment code omits the
  * triangle in/out tests.
@@ -263,6 +341,8 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
       /* always count this not worth bothering? */
       task->ps_invocations += 1 * variant->ps_inv_multiplier;
 
+      lp_rast_hiz_write(task, variant, inputs, x, y);
+
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
 
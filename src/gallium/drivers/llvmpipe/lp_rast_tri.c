@@ -265,6 +265,9 @@ lp_rast_triangle_32_3_16(struct lp_rasterizer_task *task,
    __m128i span_2;                /* 0,dcdx,2dcdx,3dcdx for plane 2 */
    __m128i unused;
 
+   if (lp_rast_hiz_occluded(task, &tri->inputs, x, y, 16))
+      return;
+
    transpose4_epi32(&p0, &p1, &p2, &zero,
                     &c, &unused, &dcdx, &dcdy);
 
@@ -373,6 +376,9 @@ lp_rast_triangle_32_3_4(struct lp_rasterizer_task *task,
    __m128i span_2;                /* 0,dcdx,2dcdx,3dcdx for plane 2 */
    __m128i unused;
 
+   if (lp_rast_hiz_occluded(task, &tri->inputs, x, y, 4))
+      return;
+
    transpose4_epi32(&p0, &p1, &p2, &zero,
                     &c, &unused, &dcdx, &dcdy);
 
@@ -556,6 +562,9 @@ lp_rast_triangle_32_3_16(struct lp_rasterizer_task *task,
    __m128i vshuf_mask1;
    __m128i vshuf_mask2;
 
+   if (lp_rast_hiz_occluded(task, &tri->inputs, x, y, 16))
+      return;
+
 #ifdef PIPE_ARCH_LITTLE_ENDIAN
    vshuf_mask0 = (__m128i) vec_splats((unsigned int) 0x03020100);
    vshuf_mask1 = (__m128i) vec_splats((unsigned int) 0x07060504);
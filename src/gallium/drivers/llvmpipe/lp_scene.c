@@ -31,6 +31,7 @@
 #include "util/u_inlines.h"
 #include "util/simple_list.h"
 #include "util/u_format.h"
+#include "util/u_atomic.h"
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
@@ -51,19 +52,19 @@ struct resource_ref {
  * \param queue  the queue to put newly rendered/emptied scenes into
  */
 struct lp_scene *
-lp_scene_create( struct pipe_context *pipe )
+lp_scene_create( struct pipe_context *pipe, unsigned num_threads )
 {
    struct lp_scene *scene = CALLOC_STRUCT(lp_scene);
    if (!scene)
       return NULL;
 
    scene->pipe = pipe;
+   scene->num_threads = num_threads;
+   scene->max_size = LP_SCENE_MIN_SIZE;
 
    scene->data.head =
       CALLOC_STRUCT(data_block);
 
-   pipe_mutex_init(scene->mutex);
-
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
    {
@@ -73,9 +74,9 @@ lp_scene_create( struct pipe_context *pipe )
       /* We'll need at least one command block per bin.  Make sure that's
        * less than the max allowed scene size.
        */
-      assert(maxCommandBytes < LP_SCENE_MAX_SIZE);
+      assert(maxCommandBytes < LP_SCENE_MIN_SIZE);
       /* We'll also need space for at least one other data block */
-      assert(maxCommandPlusData <= LP_SCENE_MAX_SIZE);
+      assert(maxCommandPlusData <= LP_SCENE_MIN_SIZE);
    }
 #endif
 
@@ -89,10 +90,17 @@ lp_scene_create( struct pipe_context *pipe )
 void
 lp_scene_destroy(struct lp_scene *scene)
 {
+   struct data_block *block, *tmp;
+
    lp_fence_reference(&scene->fence, NULL);
-   pipe_mutex_destroy(scene->mutex);
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
+
+   for (block = scene->data.free; block; block = tmp) {
+      tmp = block->next;
+      FREE(block);
+   }
+
    FREE(scene);
 }
 
@@ -175,6 +183,9 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
                                                      cbuf->u.tex.first_layer,
                                                      LP_TEX_USAGE_READ_WRITE);
          scene->cbufs[i].format_bytes = util_format_get_blocksize(cbuf->format);
+         llvmpipe_resource_tile_strides(cbuf->texture, cbuf->u.tex.level,
+                                        &scene->cbufs[i].tile_x_stride,
+                                        &scene->cbufs[i].tile_y_stride);
       }
       else {
          struct llvmpipe_resource *lpr = llvmpipe_resource(cbuf->texture);
@@ -184,6 +195,8 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
          scene->cbufs[i].map = lpr->data;
          scene->cbufs[i].map += cbuf->u.buf.first_element * pixstride;
          scene->cbufs[i].format_bytes = util_format_get_blocksize(cbuf->format);
+         scene->cbufs[i].tile_x_stride = TILE_SIZE * pixstride;
+         scene->cbufs[i].tile_y_stride = TILE_SIZE * scene->cbufs[i].stride;
       }
    }
 
@@ -197,6 +210,9 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
                                                zsbuf->u.tex.first_layer,
                                                LP_TEX_USAGE_READ_WRITE);
       scene->zsbuf.format_bytes = util_format_get_blocksize(zsbuf->format);
+      llvmpipe_resource_tile_strides(zsbuf->texture, zsbuf->u.tex.level,
+                                     &scene->zsbuf.tile_x_stride,
+                                     &scene->zsbuf.tile_y_stride);
    }
 }
 
@@ -274,19 +290,34 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                       j, scene->resource_reference_size);
    }
 
-   /* Free all scene data blocks:
+   /* Return all scene data blocks to the free list, then trim it.  The
+    * pool follows the size of recent scenes, but only shrinks slowly so
+    * alternating big and small scenes don't keep reallocating.
     */
    {
       struct data_block_list *list = &scene->data;
       struct data_block *block, *tmp;
+      unsigned num_blocks = 0;
 
       for (block = list->head->next; block; block = tmp) {
          tmp = block->next;
-	 FREE(block);
+         block->next = list->free;
+         list->free = block;
+         list->num_free++;
+         num_blocks++;
       }
 
       list->head->next = NULL;
       list->head->used = 0;
+
+      list->pool_size = MAX2(num_blocks, list->pool_size - list->pool_size / 4);
+
+      while (list->num_free > list->pool_size) {
+         block = list->free;
+         list->free = block->next;
+         list->num_free--;
+         FREE(block);
+      }
    }
 
    lp_fence_reference(&scene->fence, NULL);
@@ -330,16 +361,24 @@ lp_scene_new_cmd_block( struct lp_scene *scene,
 struct data_block *
 lp_scene_new_data_block( struct lp_scene *scene )
 {
-   if (scene->scene_size + DATA_BLOCK_SIZE > LP_SCENE_MAX_SIZE) {
+   if (scene->scene_size + DATA_BLOCK_SIZE > scene->max_size) {
       if (0) debug_printf("%s: failed\n", __FUNCTION__);
       scene->alloc_failed = TRUE;
       return NULL;
    }
    else {
-      struct data_block *block = MALLOC_STRUCT(data_block);
-      if (!block)
-         return NULL;
-      
+      struct data_block *block = scene->data.free;
+
+      if (block) {
+         scene->data.free = block->next;
+         scene->data.num_free--;
+      }
+      else {
+         block = MALLOC_STRUCT(data_block);
+         if (!block)
+            return NULL;
+      }
+
       scene->scene_size += sizeof *block;
 
       block->used = 0;
@@ -449,61 +488,33 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
-{
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
-   }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
-   }
-   return TRUE;
-}
-
-
 void
 lp_scene_bin_iter_begin( struct lp_scene *scene )
 {
-   scene->curr_x = scene->curr_y = -1;
+   scene->curr_bin = 0;
 }
 
 
 /**
  * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
  * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * of work (a bin) to work on.  The bins are handed out in row-major order
+ * through an atomic counter, so the threads never wait on each other here.
  */
 struct cmd_bin *
 lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
 {
-   struct cmd_bin *bin = NULL;
-
-   pipe_mutex_lock(scene->mutex);
+   int bin = p_atomic_inc_return(&scene->curr_bin) - 1;
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
+   if (bin >= (int)(scene->tiles_x * scene->tiles_y)) {
       /* no more bins left */
-      goto end;
+      return NULL;
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+   *x = bin % scene->tiles_x;
+   *y = bin / scene->tiles_x;
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   pipe_mutex_unlock(scene->mutex);
-   return bin;
+   return lp_scene_get_bin(scene, *x, *y);
 }
 
 
@@ -523,6 +534,12 @@ void lp_scene_begin_binning( struct lp_scene *scene,
    assert(scene->tiles_x <= TILES_X);
    assert(scene->tiles_y <= TILES_Y);
 
+   scene->max_size = (unsigned)
+      MIN2(LP_SCENE_MIN_SIZE +
+           (uint64_t)scene->tiles_x * scene->tiles_y *
+           LP_SCENE_SIZE_PER_TILE * MAX2(1, scene->num_threads),
+           LP_SCENE_MAX_SIZE);
+
    /*
     * Determine how many layers the fb has (used for clamping layer value).
     * OpenGL (but not d3d10) permits different amount of layers per rt, however
@@ -553,8 +570,8 @@ void lp_scene_end_binning( struct lp_scene *scene )
 {
    if (LP_DEBUG & DEBUG_SCENE) {
       debug_printf("rasterize scene:\n");
-      debug_printf("  scene_size: %u\n",
-                   scene->scene_size);
+      debug_printf("  scene_size: %u (max %u)\n",
+                   scene->scene_size, scene->max_size);
       debug_printf("  data size: %u\n",
                    lp_scene_data_size(scene));
 
@@ -58,9 +58,14 @@ struct lp_rast_state;
  */
 #define DATA_BLOCK_SIZE (64 * 1024)
 
-/* Scene temporary storage is clamped to this size:
+/* Scene temporary storage is clamped to a size between these, growing
+ * with the number of tiles and the number of rasterizer threads.  Bigger
+ * framebuffers need more command storage, and more threads can chew
+ * through bigger scenes without the setup thread waiting on them.
  */
-#define LP_SCENE_MAX_SIZE (9*1024*1024)
+#define LP_SCENE_MIN_SIZE (9*1024*1024)
+#define LP_SCENE_MAX_SIZE (128*1024*1024)
+#define LP_SCENE_SIZE_PER_TILE (8*1024)
 
 /* The maximum amount of texture storage referenced by a scene is
  * clamped to this size:
@@ -113,6 +118,13 @@ struct cmd_bin {
 struct data_block_list {
    struct data_block first;
    struct data_block *head;
+
+   /** Blocks of previous scenes kept for reuse */
+   struct data_block *free;
+   unsigned num_free;
+
+   /** Number of blocks the free list is trimmed to after each scene */
+   unsigned pool_size;
 };
 
 struct resource_ref;
@@ -143,6 +155,8 @@ struct lp_scene {
       unsigned stride;
       unsigned layer_stride;
       unsigned format_bytes;
+      /* Offsets between horizontally and vertically adjacent tiles */
+      unsigned tile_x_stride, tile_y_stride;
    } zsbuf, cbufs[PIPE_MAX_COLOR_BUFS];
 
    /* The amount of layers in the fb (minimum of all attachments) */
@@ -160,6 +174,12 @@ struct lp_scene {
     */
    unsigned scene_size;
 
+   /** Limit of scene_size, see LP_SCENE_MIN_SIZE */
+   unsigned max_size;
+
+   /** Number of rasterizer threads */
+   unsigned num_threads;
+
    /** Sum of sizes of all resources referenced by the scene.  Sums
     * all the textures read by the scene:
     */
@@ -173,8 +193,7 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   pipe_mutex mutex;
+   int curr_bin;  /**< for iterating over bins, atomically incremented */
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -182,7 +201,8 @@ struct lp_scene {
 
 
 
-struct lp_scene *lp_scene_create(struct pipe_context *pipe);
+struct lp_scene *lp_scene_create(struct pipe_context *pipe,
+                                 unsigned num_threads);
 
 void lp_scene_destroy(struct lp_scene *scene);
 
@@ -219,7 +239,7 @@ lp_scene_alloc( struct lp_scene *scene, unsigned size)
    if (LP_DEBUG & DEBUG_MEM)
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
 		   size, block->used, DATA_BLOCK_SIZE,
-		   scene->scene_size, LP_SCENE_MAX_SIZE);
+		   scene->scene_size, scene->max_size);
 
    if (block->used + size > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block( scene );
@@ -253,7 +273,7 @@ lp_scene_alloc_aligned( struct lp_scene *scene, unsigned size,
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
 		   size + alignment - 1,
 		   block->used, DATA_BLOCK_SIZE,
-		   scene->scene_size, LP_SCENE_MAX_SIZE);
+		   scene->scene_size, scene->max_size);
        
    if (block->used + size + alignment - 1 > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block( scene );
@@ -213,6 +213,7 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
       return 0;
    case PIPE_CAP_USER_VERTEX_BUFFERS:
    case PIPE_CAP_USER_INDEX_BUFFERS:
+   case PIPE_CAP_INDEX_BOUNDS_NOT_NEEDED:
       return 1;
    case PIPE_CAP_USER_CONSTANT_BUFFERS:
       return 0;
@@ -527,6 +528,11 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
    struct sw_winsys *winsys = screen->winsys;
 
+   if (util_queue_is_initialized(&screen->compile_queue))
+      util_queue_destroy(&screen->compile_queue);
+   if (util_queue_is_initialized(&screen->setup_queue))
+      util_queue_destroy(&screen->setup_queue);
+
    if (screen->rast)
       lp_rast_destroy(screen->rast);
 
@@ -643,6 +649,42 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    }
    pipe_mutex_init(screen->rast_mutex);
 
+   /* Variants are compiled in their own LLVM context on the compile
+    * threads, which needs MCJIT.
+    */
+#if HAVE_LLVM >= 0x0306
+   screen->num_compile_threads = util_cpu_caps.nr_cpus > 1 ?
+                                 MIN2(util_cpu_caps.nr_cpus / 2, 4) : 0;
+#ifdef PIPE_SUBSYSTEM_EMBEDDED
+   screen->num_compile_threads = 0;
+#endif
+   screen->num_compile_threads = debug_get_num_option("LP_NUM_COMPILE_THREADS",
+                                                      screen->num_compile_threads);
+#endif
+   if (screen->num_compile_threads &&
+       !util_queue_init(&screen->compile_queue, "llvmpipe_cc", 32,
+                        screen->num_compile_threads))
+      screen->num_compile_threads = 0;
+
+   screen->fast_compile = screen->num_compile_threads &&
+                          debug_get_bool_option("LP_FAST_COMPILE", FALSE);
+
+   screen->tiled_render_targets = debug_get_bool_option("LP_TILED", FALSE);
+
+   /* The rasterizer threads are idle while a scene is binned, so use as
+    * many setup threads, the draw thread sets up triangles as well.
+    */
+   screen->num_setup_threads = screen->num_threads > 1 ?
+                               MIN2(screen->num_threads - 1, LP_MAX_SETUP_THREADS) : 0;
+   screen->num_setup_threads = debug_get_num_option("LP_NUM_SETUP_THREADS",
+                                                    screen->num_setup_threads);
+   screen->num_setup_threads = MIN2(screen->num_setup_threads,
+                                    LP_MAX_SETUP_THREADS);
+   if (screen->num_setup_threads &&
+       !util_queue_init(&screen->setup_queue, "llvmpipe_setup",
+                        LP_MAX_SETUP_THREADS, screen->num_setup_threads))
+      screen->num_setup_threads = 0;
+
    util_format_s3tc_init();
 
    return &screen->base;
@@ -38,6 +38,7 @@
 #include "pipe/p_defines.h"
 #include "os/os_thread.h"
 #include "gallivm/lp_bld.h"
+#include "util/u_queue.h"
 
 
 struct sw_winsys;
@@ -57,6 +58,27 @@ struct llvmpipe_screen
 
    struct lp_rasterizer *rast;
    pipe_mutex rast_mutex;
+
+   /* Compiles fragment shader variants off the draw thread, see
+    * lp_state_fs.c.  Not initialized when LP_NUM_COMPILE_THREADS is 0.
+    */
+   unsigned num_compile_threads;
+   struct util_queue compile_queue;
+
+   /* Compile new variants at -O0 first and optimize the ones which get
+    * used on the compile queue, see LP_FAST_COMPILE.
+    */
+   boolean fast_compile;
+
+   /* Store render targets as contiguous tiles, see LP_TILED. */
+   boolean tiled_render_targets;
+
+   /* Sets up the triangles of large triangle lists together with the
+    * draw thread, see lp_setup_tri_list().  Not initialized when
+    * LP_NUM_SETUP_THREADS is 0.
+    */
+   unsigned num_setup_threads;
+   struct util_queue setup_queue;
 };
 
 
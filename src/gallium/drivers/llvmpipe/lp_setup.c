@@ -47,6 +47,7 @@
 #include "lp_texture.h"
 #include "lp_debug.h"
 #include "lp_fence.h"
+#include "lp_perf.h"
 #include "lp_query.h"
 #include "lp_rast.h"
 #include "lp_setup_context.h"
@@ -63,6 +64,22 @@ static boolean set_scene_state( struct lp_setup_context *, enum setup_state,
 static boolean try_update_scene_state( struct lp_setup_context *setup );
 
 
+/**
+ * Count why the current scene has to be flushed before its commands are
+ * all binned, see lp_print_counters().
+ */
+static void
+count_scene_restart(struct lp_setup_context *setup)
+{
+#ifdef DEBUG
+   if (setup->scene && lp_scene_is_oom(setup->scene))
+      LP_COUNT(nr_scene_flush_full);
+   else
+      LP_COUNT(nr_scene_flush_resources);
+#endif
+}
+
+
 static void
 lp_setup_get_empty_scene(struct lp_setup_context *setup)
 {
@@ -159,6 +176,8 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 
    lp_scene_end_binning(scene);
 
+   LP_COUNT(nr_scenes);
+
    lp_fence_reference(&setup->last_fence, scene->fence);
 
    if (setup->last_fence)
@@ -1255,6 +1274,8 @@ lp_setup_update_state( struct lp_setup_context *setup,
        * Cannot call lp_setup_flush_and_restart() directly here
        * because of potential recursion.
        */
+      count_scene_restart(setup);
+
       if (!set_scene_state(setup, SETUP_FLUSHED, __FUNCTION__))
          return FALSE;
 
@@ -1281,6 +1302,8 @@ lp_setup_destroy( struct lp_setup_context *setup )
 
    lp_setup_reset( setup );
 
+   lp_setup_free_tri_jobs( setup );
+
    util_unreference_framebuffer_state(&setup->fb);
 
    for (i = 0; i < ARRAY_SIZE(setup->fs.current_tex); i++) {
@@ -1343,7 +1366,7 @@ lp_setup_create( struct pipe_context *pipe,
 
    /* create some empty scenes */
    for (i = 0; i < MAX_SCENES; i++) {
-      setup->scenes[i] = lp_scene_create( pipe );
+      setup->scenes[i] = lp_scene_create( pipe, setup->num_threads );
       if (!setup->scenes[i]) {
          goto no_scenes;
       }
@@ -1495,9 +1518,11 @@ lp_setup_flush_and_restart(struct lp_setup_context *setup)
 
    assert(setup->state == SETUP_ACTIVE);
 
+   count_scene_restart(setup);
+
    if (!set_scene_state(setup, SETUP_FLUSHED, __FUNCTION__))
       return FALSE;
-   
+
    if (!lp_setup_update_state(setup, TRUE))
       return FALSE;
 
@@ -58,6 +58,14 @@ struct lp_setup_variant;
 /* XXX: make multiple scenes per context work, see lp_setup_rasterize_scene */
 #define MAX_SCENES 1
 
+/** Number of triangles set up by one job of lp_setup_tri_list() */
+#define LP_SETUP_TRI_JOB_SIZE 256
+
+/** Smallest triangle list set up on the setup threads */
+#define LP_SETUP_TRI_LIST_MIN (2 * LP_SETUP_TRI_JOB_SIZE)
+
+struct lp_setup_tri_job;
+
 
 
 /**
@@ -91,6 +99,10 @@ struct lp_setup_context
    struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
 
+   /** Triangle setup jobs, see lp_setup_tri_list() */
+   struct lp_setup_tri_job *tri_jobs;
+   unsigned num_tri_jobs;
+
    struct lp_fence *last_fence;
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned active_binned_queries;
@@ -221,4 +233,14 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
                        int nr_planes,
                        unsigned scissor_index );
 
+boolean
+lp_setup_tri_list(struct lp_setup_context *setup,
+                  const void *vertex_buffer,
+                  unsigned stride,
+                  const ushort *indices,
+                  unsigned nr);
+
+void
+lp_setup_free_tri_jobs(struct lp_setup_context *setup);
+
 #endif
@@ -39,6 +39,7 @@
 #include "lp_state_fs.h"
 #include "lp_state_setup.h"
 #include "lp_context.h"
+#include "lp_screen.h"
 
 #include <inttypes.h>
 
@@ -260,48 +261,45 @@ lp_setup_whole_tile(struct lp_setup_context *setup,
 
 
 /**
- * Do basic setup for triangle rasterization and determine which
- * framebuffer tiles are touched.  Put the triangle in the scene's
- * bins for the tiles which we overlap.
+ * Compute the bounding box, viewport, layer and number of planes of a
+ * ccw triangle.  Returns FALSE if the triangle can be discarded.
+ *
+ * This only reads setup state and doesn't touch the scene, so it may be
+ * called from the setup threads as well, see lp_setup_tri_list().
  */
 static boolean
-do_triangle_ccw(struct lp_setup_context *setup,
-                struct fixed_position* position,
-                const float (*v0)[4],
-                const float (*v1)[4],
-                const float (*v2)[4],
-                boolean frontfacing )
+triangle_bbox_ccw(const struct lp_setup_context *setup,
+                  const struct fixed_position *position,
+                  const float (*v0)[4],
+                  const float (*v2)[4],
+                  unsigned max_layer,
+                  struct u_rect *bbox,
+                  int *nr_planes,
+                  unsigned *viewport_index,
+                  unsigned *layer)
 {
-   struct lp_scene *scene = setup->scene;
-   const struct lp_setup_variant_key *key = &setup->setup.variant->key;
-   struct lp_rast_triangle *tri;
-   struct lp_rast_plane *plane;
-   struct u_rect bbox;
-   unsigned tri_bytes;
-   int nr_planes = 3;
-   unsigned viewport_index = 0;
-   unsigned layer = 0;
    const float (*pv)[4];
 
    /* Area should always be positive here */
    assert(position->area > 0);
 
-   if (0)
-      lp_setup_print_triangle(setup, v0, v1, v2);
-
    if (setup->flatshade_first) {
       pv = v0;
    }
    else {
       pv = v2;
    }
+
+   *viewport_index = 0;
    if (setup->viewport_index_slot > 0) {
       unsigned *udata = (unsigned*)pv[setup->viewport_index_slot];
-      viewport_index = lp_clamp_viewport_idx(*udata);
+      *viewport_index = lp_clamp_viewport_idx(*udata);
    }
+
+   *layer = 0;
    if (setup->layer_slot > 0) {
-      layer = *(unsigned*)pv[setup->layer_slot];
-      layer = MIN2(layer, scene->fb_max_layer);
+      *layer = *(unsigned*)pv[setup->layer_slot];
+      *layer = MIN2(*layer, max_layer);
    }
 
    /* Bounding rectangle (in pixels) */
@@ -314,35 +312,33 @@ do_triangle_ccw(struct lp_setup_context *setup,
       int adj = (setup->bottom_edge_rule != 0) ? 1 : 0;
 
       /* Inclusive x0, exclusive x1 */
-      bbox.x0 =  MIN3(position->x[0], position->x[1], position->x[2]) >> FIXED_ORDER;
-      bbox.x1 = (MAX3(position->x[0], position->x[1], position->x[2]) - 1) >> FIXED_ORDER;
+      bbox->x0 =  MIN3(position->x[0], position->x[1], position->x[2]) >> FIXED_ORDER;
+      bbox->x1 = (MAX3(position->x[0], position->x[1], position->x[2]) - 1) >> FIXED_ORDER;
 
       /* Inclusive / exclusive depending upon adj (bottom-left or top-right) */
-      bbox.y0 = (MIN3(position->y[0], position->y[1], position->y[2]) + adj) >> FIXED_ORDER;
-      bbox.y1 = (MAX3(position->y[0], position->y[1], position->y[2]) - 1 + adj) >> FIXED_ORDER;
+      bbox->y0 = (MIN3(position->y[0], position->y[1], position->y[2]) + adj) >> FIXED_ORDER;
+      bbox->y1 = (MAX3(position->y[0], position->y[1], position->y[2]) - 1 + adj) >> FIXED_ORDER;
    }
 
-   if (bbox.x1 < bbox.x0 ||
-       bbox.y1 < bbox.y0) {
+   if (bbox->x1 < bbox->x0 ||
+       bbox->y1 < bbox->y0) {
       if (0) debug_printf("empty bounding box\n");
-      LP_COUNT(nr_culled_tris);
-      return TRUE;
+      return FALSE;
    }
 
-   if (!u_rect_test_intersection(&setup->draw_regions[viewport_index], &bbox)) {
+   if (!u_rect_test_intersection(&setup->draw_regions[*viewport_index], bbox)) {
       if (0) debug_printf("offscreen\n");
-      LP_COUNT(nr_culled_tris);
-      return TRUE;
+      return FALSE;
    }
 
    /* Can safely discard negative regions, but need to keep hold of
     * information about when the triangle extends past screen
     * boundaries.  See trimmed_box in lp_setup_bin_triangle().
     */
-   bbox.x0 = MAX2(bbox.x0, 0);
-   bbox.y0 = MAX2(bbox.y0, 0);
+   bbox->x0 = MAX2(bbox->x0, 0);
+   bbox->y0 = MAX2(bbox->y0, 0);
 
-   nr_planes = 3;
+   *nr_planes = 3;
    /*
     * Determine how many scissor planes we need, that is drop scissor
     * edges if the bounding box of the tri is fully inside that edge.
@@ -350,27 +346,34 @@ do_triangle_ccw(struct lp_setup_context *setup,
    if (setup->scissor_test) {
       /* why not just use draw_regions */
       boolean s_planes[4];
-      scissor_planes_needed(s_planes, &bbox, &setup->scissors[viewport_index]);
-      nr_planes += s_planes[0] + s_planes[1] + s_planes[2] + s_planes[3];
+      scissor_planes_needed(s_planes, bbox, &setup->scissors[*viewport_index]);
+      *nr_planes += s_planes[0] + s_planes[1] + s_planes[2] + s_planes[3];
    }
 
-   tri = lp_setup_alloc_triangle(scene,
-                                 key->num_inputs,
-                                 nr_planes,
-                                 &tri_bytes);
-   if (!tri)
-      return FALSE;
+   return TRUE;
+}
 
-#if 0
-   tri->v[0][0] = v0[0][0];
-   tri->v[1][0] = v1[0][0];
-   tri->v[2][0] = v2[0][0];
-   tri->v[0][1] = v0[0][1];
-   tri->v[1][1] = v1[0][1];
-   tri->v[2][1] = v2[0][1];
-#endif
 
-   LP_COUNT(nr_tris);
+/**
+ * Compute the interpolation coefficients and the edge and scissor planes
+ * of a ccw triangle into tri, which has room for nr_planes planes.
+ *
+ * Like triangle_bbox_ccw() this is safe to call from the setup threads.
+ */
+static void
+triangle_setup_ccw(const struct lp_setup_context *setup,
+                   const struct fixed_position *position,
+                   const float (*v0)[4],
+                   const float (*v1)[4],
+                   const float (*v2)[4],
+                   boolean frontfacing,
+                   struct lp_rast_triangle *tri,
+                   const struct u_rect *bbox,
+                   int nr_planes,
+                   unsigned viewport_index,
+                   unsigned layer)
+{
+   struct lp_rast_plane *plane;
 
    /* Setup parameter interpolants:
     */
@@ -495,8 +498,8 @@ do_triangle_ccw(struct lp_setup_context *setup,
     */
    if (setup->fb.width <= MAX_FIXED_LENGTH32 &&
        setup->fb.height <= MAX_FIXED_LENGTH32 &&
-       (bbox.x1 - bbox.x0) <= MAX_FIXED_LENGTH32 &&
-       (bbox.y1 - bbox.y0) <= MAX_FIXED_LENGTH32) {
+       (bbox->x1 - bbox->x0) <= MAX_FIXED_LENGTH32 &&
+       (bbox->y1 - bbox->y0) <= MAX_FIXED_LENGTH32) {
       unsigned int bottom_edge;
       __m128i vertx, verty;
       __m128i shufx, shufy;
@@ -686,7 +689,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
       const struct u_rect *scissor = &setup->scissors[viewport_index];
       struct lp_rast_plane *plane_s = &plane[3];
       boolean s_planes[4];
-      scissor_planes_needed(s_planes, &bbox, scissor);
+      scissor_planes_needed(s_planes, bbox, scissor);
 
       if (s_planes[0]) {
          plane_s->dcdx = -1 << 8;
@@ -719,6 +722,61 @@ do_triangle_ccw(struct lp_setup_context *setup,
       assert(plane_s == &plane[nr_planes]);
    }
 
+}
+
+
+/**
+ * Do basic setup for triangle rasterization and determine which
+ * framebuffer tiles are touched.  Put the triangle in the scene's
+ * bins for the tiles which we overlap.
+ */
+static boolean
+do_triangle_ccw(struct lp_setup_context *setup,
+                struct fixed_position* position,
+                const float (*v0)[4],
+                const float (*v1)[4],
+                const float (*v2)[4],
+                boolean frontfacing )
+{
+   struct lp_scene *scene = setup->scene;
+   const struct lp_setup_variant_key *key = &setup->setup.variant->key;
+   struct lp_rast_triangle *tri;
+   struct u_rect bbox;
+   unsigned tri_bytes;
+   int nr_planes;
+   unsigned viewport_index;
+   unsigned layer;
+
+   if (0)
+      lp_setup_print_triangle(setup, v0, v1, v2);
+
+   if (!triangle_bbox_ccw(setup, position, v0, v2, scene->fb_max_layer,
+                          &bbox, &nr_planes, &viewport_index, &layer)) {
+      LP_COUNT(nr_culled_tris);
+      return TRUE;
+   }
+
+   tri = lp_setup_alloc_triangle(scene,
+                                 key->num_inputs,
+                                 nr_planes,
+                                 &tri_bytes);
+   if (!tri)
+      return FALSE;
+
+#if 0
+   tri->v[0][0] = v0[0][0];
+   tri->v[1][0] = v1[0][0];
+   tri->v[2][0] = v2[0][0];
+   tri->v[0][1] = v0[0][1];
+   tri->v[1][1] = v1[0][1];
+   tri->v[2][1] = v2[0][1];
+#endif
+
+   LP_COUNT(nr_tris);
+
+   triangle_setup_ccw(setup, position, v0, v1, v2, frontfacing, tri,
+                      &bbox, nr_planes, viewport_index, layer);
+
    return lp_setup_bin_triangle(setup, tri, &bbox, nr_planes, viewport_index);
 }
 
@@ -1214,3 +1272,331 @@ lp_setup_choose_triangle( struct lp_setup_context *setup )
       break;
    }
 }
+
+
+/**
+ * A batch of triangles of a triangle list set up by one setup thread.
+ *
+ * The triangles are set up into the job's own memory, as the scene
+ * can't be allocated from concurrently, and copied into the scene and
+ * binned in primitive order by the draw thread afterwards.
+ */
+struct lp_setup_tri_job
+{
+   struct util_queue_fence fence;
+   struct lp_setup_context *setup;
+
+   const void *vertex_buffer;
+   const ushort *indices;   /**< NULL for non-indexed draws */
+   unsigned stride;
+   unsigned first;          /**< first vertex of the batch */
+   unsigned nr;             /**< number of triangles in the batch */
+   unsigned max_layer;
+
+   struct {
+      struct u_rect bbox;
+      unsigned bytes;       /**< 0 if the triangle is discarded */
+      int nr_planes;
+      unsigned viewport_index;
+      boolean culled;       /**< discarded by the bounding box test */
+   } tris[LP_SETUP_TRI_JOB_SIZE];
+
+   /** LP_SETUP_TRI_JOB_SIZE triangles of slot_size bytes each */
+   char *data;
+   unsigned slot_size;
+   unsigned data_size;
+};
+
+
+static inline const float (*
+tri_job_vert(const struct lp_setup_tri_job *job, unsigned i))[4]
+{
+   unsigned index = job->indices ? job->indices[i] : i;
+   return (const float (*)[4])((const char *)job->vertex_buffer +
+                               index * job->stride);
+}
+
+
+/**
+ * Setup thread entrypoint.  Does what triangle_cw/ccw/both do for each
+ * triangle of the batch, except for the binning.
+ */
+static void
+setup_tri_job(void *data, int thread_index)
+{
+   struct lp_setup_tri_job *job = (struct lp_setup_tri_job *)data;
+   struct lp_setup_context *setup = job->setup;
+   const unsigned input_array_sz =
+      NUM_CHANNELS * (setup->setup.variant->key.num_inputs + 1) * sizeof(float);
+   unsigned i;
+
+   for (i = 0; i < job->nr; i++) {
+      PIPE_ALIGN_VAR(16) struct fixed_position position;
+      const unsigned v = job->first + 3 * i;
+      const float (*v0)[4] = tri_job_vert(job, v + 0);
+      const float (*v1)[4] = tri_job_vert(job, v + 1);
+      const float (*v2)[4] = tri_job_vert(job, v + 2);
+      struct lp_rast_triangle *tri;
+      unsigned layer;
+      boolean front;
+
+      job->tris[i].bytes = 0;
+      job->tris[i].culled = FALSE;
+
+      calc_fixed_position(setup, &position, v0, v1, v2);
+
+      if (position.area > 0) {
+         front = setup->ccw_is_frontface;
+      }
+      else if (position.area < 0) {
+         const float (*tmp)[4];
+         if (setup->flatshade_first) {
+            rotate_fixed_position_12(&position);
+            tmp = v1; v1 = v2; v2 = tmp;
+         } else {
+            rotate_fixed_position_01(&position);
+            tmp = v0; v0 = v1; v1 = tmp;
+         }
+         front = !setup->ccw_is_frontface;
+      }
+      else {
+         continue;
+      }
+
+      if (setup->cullmode & (front ? PIPE_FACE_FRONT : PIPE_FACE_BACK))
+         continue;
+
+      if (!triangle_bbox_ccw(setup, &position, v0, v2, job->max_layer,
+                             &job->tris[i].bbox,
+                             &job->tris[i].nr_planes,
+                             &job->tris[i].viewport_index,
+                             &layer)) {
+         job->tris[i].culled = TRUE;
+         continue;
+      }
+
+      tri = (struct lp_rast_triangle *)(job->data + i * job->slot_size);
+      tri->inputs.stride = input_array_sz;
+
+      triangle_setup_ccw(setup, &position, v0, v1, v2, front, tri,
+                         &job->tris[i].bbox,
+                         job->tris[i].nr_planes,
+                         job->tris[i].viewport_index,
+                         layer);
+
+      job->tris[i].bytes = (char *)&GET_PLANES(tri)[job->tris[i].nr_planes] -
+                           (char *)tri;
+   }
+}
+
+
+static boolean
+bin_prepared_triangle(struct lp_setup_context *setup,
+                      const struct lp_setup_tri_job *job,
+                      unsigned i)
+{
+   struct lp_rast_triangle *tri;
+
+   tri = lp_scene_alloc_aligned(setup->scene, job->tris[i].bytes, 16);
+   if (!tri)
+      return FALSE;
+
+   memcpy(tri, job->data + i * job->slot_size, job->tris[i].bytes);
+
+   return lp_setup_bin_triangle(setup, tri,
+                                &job->tris[i].bbox,
+                                job->tris[i].nr_planes,
+                                job->tris[i].viewport_index);
+}
+
+
+static void
+wait_tri_jobs(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   for (i = 0; i < setup->num_tri_jobs; i++)
+      util_queue_job_wait(&setup->tri_jobs[i].fence);
+}
+
+
+/**
+ * Bin the triangles of a finished job, restarting the scene on
+ * failure like retry_triangle_ccw() does.  Returns FALSE if the scene
+ * couldn't be restarted.
+ */
+static boolean
+bin_tri_job(struct lp_setup_context *setup,
+            const struct lp_setup_tri_job *job)
+{
+   unsigned i;
+
+   for (i = 0; i < job->nr; i++) {
+      if (!job->tris[i].bytes) {
+         if (job->tris[i].culled)
+            LP_COUNT(nr_culled_tris);
+         continue;
+      }
+
+      LP_COUNT(nr_tris);
+
+      if (!bin_prepared_triangle(setup, job, i)) {
+         /* Restarting the scene updates setup state the other jobs may
+          * still be reading.
+          */
+         wait_tri_jobs(setup);
+
+         if (!lp_setup_flush_and_restart(setup))
+            return FALSE;
+
+         bin_prepared_triangle(setup, job, i);
+      }
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Make sure there are num_jobs jobs with room for triangles with the
+ * current number of fragment shader inputs.
+ */
+static boolean
+alloc_tri_jobs(struct lp_setup_context *setup, unsigned num_jobs)
+{
+   const unsigned input_array_sz =
+      NUM_CHANNELS * (setup->setup.variant->key.num_inputs + 1) * sizeof(float);
+   const unsigned slot_size = align(sizeof(struct lp_rast_triangle) +
+                                    3 * input_array_sz +
+                                    (3 + 4) * sizeof(struct lp_rast_plane), 16);
+   unsigned i;
+
+   if (!setup->tri_jobs) {
+      setup->tri_jobs = CALLOC(num_jobs, sizeof *setup->tri_jobs);
+      if (!setup->tri_jobs)
+         return FALSE;
+
+      for (i = 0; i < num_jobs; i++) {
+         util_queue_fence_init(&setup->tri_jobs[i].fence);
+         setup->tri_jobs[i].setup = setup;
+      }
+      setup->num_tri_jobs = num_jobs;
+   }
+
+   assert(setup->num_tri_jobs == num_jobs);
+
+   for (i = 0; i < num_jobs; i++) {
+      struct lp_setup_tri_job *job = &setup->tri_jobs[i];
+      unsigned size = slot_size * LP_SETUP_TRI_JOB_SIZE;
+
+      if (job->data_size < size) {
+         align_free(job->data);
+         job->data = align_malloc(size, 16);
+         job->data_size = job->data ? size : 0;
+         if (!job->data)
+            return FALSE;
+      }
+      job->slot_size = slot_size;
+   }
+
+   return TRUE;
+}
+
+
+void
+lp_setup_free_tri_jobs(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   if (!setup->tri_jobs)
+      return;
+
+   wait_tri_jobs(setup);
+
+   for (i = 0; i < setup->num_tri_jobs; i++) {
+      util_queue_fence_destroy(&setup->tri_jobs[i].fence);
+      align_free(setup->tri_jobs[i].data);
+   }
+
+   FREE(setup->tri_jobs);
+   setup->tri_jobs = NULL;
+   setup->num_tri_jobs = 0;
+}
+
+
+/**
+ * Draw a triangle list, doing the triangle setup on the setup threads.
+ *
+ * The list is cut into batches of LP_SETUP_TRI_JOB_SIZE triangles which
+ * are set up concurrently, one of them on the calling thread.  Binning
+ * can't be done concurrently, so the batches are binned in order on the
+ * calling thread as they complete, which keeps the rasterization order
+ * of the triangles.
+ *
+ * Returns FALSE if the list should be drawn with setup->triangle instead,
+ * e.g. because it is too small to be worth it.
+ */
+boolean
+lp_setup_tri_list(struct lp_setup_context *setup,
+                  const void *vertex_buffer,
+                  unsigned stride,
+                  const ushort *indices,
+                  unsigned nr)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(setup->pipe->screen);
+   struct llvmpipe_context *lp_context = (struct llvmpipe_context *)setup->pipe;
+   const unsigned nr_tris = nr / 3;
+   const unsigned num_jobs = screen->num_setup_threads + 1;
+   boolean ok = TRUE;
+   unsigned done = 0;
+
+   if (!screen->num_setup_threads ||
+       nr_tris < LP_SETUP_TRI_LIST_MIN ||
+       setup->cullmode == PIPE_FACE_FRONT_AND_BACK ||
+       !setup->scene)
+      return FALSE;
+
+   if (!alloc_tri_jobs(setup, num_jobs))
+      return FALSE;
+
+   /* Same as triangle_both */
+   if (setup->cullmode == PIPE_FACE_NONE &&
+       lp_context->active_statistics_queries &&
+       !llvmpipe_rasterization_disabled(lp_context)) {
+      lp_context->pipeline_statistics.c_primitives += nr_tris;
+   }
+
+   while (ok && done < nr_tris) {
+      unsigned n, i;
+
+      for (n = 0; n < num_jobs && done < nr_tris; n++) {
+         struct lp_setup_tri_job *job = &setup->tri_jobs[n];
+
+         job->vertex_buffer = vertex_buffer;
+         job->indices = indices;
+         job->stride = stride;
+         job->first = done * 3;
+         job->nr = MIN2(nr_tris - done, LP_SETUP_TRI_JOB_SIZE);
+         job->max_layer = setup->scene->fb_max_layer;
+         done += job->nr;
+
+         if (n > 0)
+            util_queue_add_job(&screen->setup_queue, job, &job->fence,
+                               setup_tri_job);
+      }
+
+      setup_tri_job(&setup->tri_jobs[0], 0);
+
+      /* On a failed scene restart the rest of the list is dropped, but
+       * the jobs still need to be waited for.
+       */
+      for (i = 0; i < n; i++) {
+         if (i > 0)
+            util_queue_job_wait(&setup->tri_jobs[i].fence);
+         if (ok)
+            ok = bin_tri_job(setup, &setup->tri_jobs[i]);
+      }
+   }
+
+   return TRUE;
+}
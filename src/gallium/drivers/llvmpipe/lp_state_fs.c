@@ -95,6 +95,7 @@
 #include "lp_context.h"
 #include "lp_debug.h"
 #include "lp_perf.h"
+#include "lp_screen.h"
 #include "lp_setup.h"
 #include "lp_state.h"
 #include "lp_tex_sample.h"
@@ -2160,8 +2161,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
  * 2x2 pixels.
  */
 static void
-generate_fragment(struct llvmpipe_context *lp,
-                  struct lp_fragment_shader *shader,
+generate_fragment(struct lp_fragment_shader *shader,
                   struct lp_fragment_shader_variant *variant,
                   unsigned partial_mask)
 {
@@ -2544,18 +2544,21 @@ lp_debug_fs_variant(const struct lp_fragment_shader_variant *variant)
    tgsi_dump(variant->shader->base.tokens, 0);
    dump_fs_variant_key(&variant->key);
    debug_printf("variant->opaque = %u\n", variant->opaque);
+   debug_printf("variant->hiz_test = %u\n", variant->hiz_test);
+   debug_printf("variant->hiz_write = %u\n", variant->hiz_write);
    debug_printf("\n");
 }
 
 
 /**
- * Generate a new fragment shader variant from the shader code and
- * other state indicated by the key.
+ * Create a new fragment shader variant for the state indicated by the key,
+ * without generating any code yet.  The variant's module is created in the
+ * given LLVM context.
  */
 static struct lp_fragment_shader_variant *
-generate_variant(struct llvmpipe_context *lp,
-                 struct lp_fragment_shader *shader,
-                 const struct lp_fragment_shader_variant_key *key)
+create_variant(struct lp_fragment_shader *shader,
+               const struct lp_fragment_shader_variant_key *key,
+               LLVMContextRef context, boolean fast)
 {
    struct lp_fragment_shader_variant *variant;
    const struct util_format_description *cbuf0_format_desc;
@@ -2569,16 +2572,22 @@ generate_variant(struct llvmpipe_context *lp,
    util_snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
                  shader->no, shader->variants_created);
 
-   variant->gallivm = gallivm_create(module_name, lp->context);
+   if (fast)
+      variant->gallivm = gallivm_create_fast(module_name, context);
+   else
+      variant->gallivm = gallivm_create(module_name, context);
    if (!variant->gallivm) {
       FREE(variant);
       return NULL;
    }
 
+   util_queue_fence_init(&variant->fence);
+
    variant->shader = shader;
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
    variant->no = shader->variants_created++;
+   variant->fast = fast;
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
@@ -2602,6 +2611,32 @@ generate_variant(struct llvmpipe_context *lp,
          !shader->info.base.uses_kill
       ? TRUE : FALSE;
 
+   /*
+    * Fragments with interpolated depth which fail a LESS, LEQUAL or EQUAL
+    * test against the farthest depth of a block can be rejected for the
+    * whole block, unless stencil ops have to run for them.
+    */
+   variant->hiz_test =
+         key->depth.enabled &&
+         (key->depth.func == PIPE_FUNC_LESS ||
+          key->depth.func == PIPE_FUNC_LEQUAL ||
+          key->depth.func == PIPE_FUNC_EQUAL) &&
+         !key->stencil[0].enabled &&
+         !shader->info.base.writes_z;
+
+   if (!key->depth.enabled || !key->depth.writemask) {
+      variant->hiz_write = LP_HIZ_WRITE_NONE;
+   }
+   else if (key->depth.func == PIPE_FUNC_LESS ||
+            key->depth.func == PIPE_FUNC_LEQUAL ||
+            key->depth.func == PIPE_FUNC_EQUAL ||
+            key->depth.func == PIPE_FUNC_NEVER) {
+      variant->hiz_write = LP_HIZ_WRITE_LOWER;
+   }
+   else {
+      variant->hiz_write = LP_HIZ_WRITE_ANY;
+   }
+
    if ((shader->info.base.num_tokens <= 1) &&
        !key->depth.enabled && !key->stencil[0].enabled) {
       variant->ps_inv_multiplier = 0;
@@ -2613,15 +2648,30 @@ generate_variant(struct llvmpipe_context *lp,
       lp_debug_fs_variant(variant);
    }
 
+   return variant;
+}
+
+
+/**
+ * Generate and compile the code of a variant.  Only touches the variant
+ * and the immutable parts of its shader, so that it can run on the
+ * screen's compile queue when the variant has its own LLVM context.
+ */
+static void
+compile_variant(void *job, int thread_index)
+{
+   struct lp_fragment_shader_variant *variant = job;
+   struct lp_fragment_shader *shader = variant->shader;
+
    lp_jit_init_types(variant);
    
    if (variant->jit_function[RAST_EDGE_TEST] == NULL)
-      generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
+      generate_fragment(shader, variant, RAST_EDGE_TEST);
 
    if (variant->jit_function[RAST_WHOLE] == NULL) {
       if (variant->opaque) {
          /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
+         generate_fragment(shader, variant, RAST_WHOLE);
       }
    }
 
@@ -2648,11 +2698,156 @@ generate_variant(struct llvmpipe_context *lp,
    }
 
    gallivm_free_ir(variant->gallivm);
+}
+
+
+/**
+ * Generate a new fragment shader variant from the shader code and
+ * other state indicated by the key.
+ */
+static struct lp_fragment_shader_variant *
+generate_variant(struct llvmpipe_context *lp,
+                 struct lp_fragment_shader *shader,
+                 const struct lp_fragment_shader_variant_key *key)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct lp_fragment_shader_variant *variant;
+
+   variant = create_variant(shader, key, lp->context, screen->fast_compile);
+   if (!variant)
+      return NULL;
+
+   compile_variant(variant, 0);
 
    return variant;
 }
 
 
+/**
+ * Free a variant which is not on the variant lists (anymore).
+ */
+static void
+free_variant(struct lp_fragment_shader_variant *variant)
+{
+   if (variant->optimized) {
+      util_queue_job_wait(&variant->optimized->fence);
+      free_variant(variant->optimized);
+   }
+   gallivm_destroy(variant->gallivm);
+   if (variant->context)
+      LLVMContextDispose(variant->context);
+   util_queue_fence_destroy(&variant->fence);
+   FREE(variant);
+}
+
+
+static void
+make_variant_key(struct llvmpipe_context *lp,
+                 struct lp_fragment_shader *shader,
+                 struct lp_fragment_shader_variant_key *key);
+
+
+/**
+ * Start compiling the variant for the currently bound state on the
+ * screen's compile queue.  Shaders are usually created right before being
+ * used with the state that is current already, so this hides most of the
+ * compile time of the first draw with a new shader.
+ */
+static void
+precompile_variant(struct llvmpipe_context *lp,
+                   struct lp_fragment_shader *shader)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct lp_fragment_shader_variant_key key;
+   struct lp_fragment_shader_variant *variant;
+   LLVMContextRef context;
+
+   if (!screen->num_compile_threads)
+      return;
+
+   /* The key can't be built before the first state atoms are bound. */
+   if (!lp->rasterizer || !lp->depth_stencil || !lp->blend)
+      return;
+
+   context = LLVMContextCreate();
+   if (!context)
+      return;
+
+   make_variant_key(lp, shader, &key);
+
+   variant = create_variant(shader, &key, context, FALSE);
+   if (!variant) {
+      LLVMContextDispose(context);
+      return;
+   }
+   variant->context = context;
+
+   shader->precompiled = variant;
+   util_queue_add_job(&screen->compile_queue, variant, &variant->fence,
+                      compile_variant);
+}
+
+
+/* Draws after which a variant compiled without optimizations is worth
+ * optimizing.
+ */
+#define LP_HOT_VARIANT_DRAWS 32
+
+/**
+ * Called for each draw.  Once the bound variant has been used often enough,
+ * start compiling it again with full optimization on the compile queue, and
+ * switch to the optimized functions when they are ready.
+ *
+ * The functions are swapped in place, so scenes binned before keep working:
+ * they just run either version.  The unoptimized code is kept alive until
+ * the variant is freed.
+ */
+void
+llvmpipe_fs_variant_used(struct llvmpipe_context *lp)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct lp_fragment_shader_variant *variant = lp->fs_variant;
+   struct lp_fragment_shader_variant *optimized;
+   LLVMContextRef context;
+
+   if (!variant || !variant->fast)
+      return;
+
+   optimized = variant->optimized;
+   if (optimized) {
+      if (util_queue_fence_is_signalled(&optimized->fence)) {
+         variant->jit_function[RAST_EDGE_TEST] =
+            optimized->jit_function[RAST_EDGE_TEST];
+         variant->jit_function[RAST_WHOLE] =
+            optimized->jit_function[RAST_WHOLE];
+         variant->fast = FALSE;
+      }
+      return;
+   }
+
+   if (++variant->nr_draws < LP_HOT_VARIANT_DRAWS)
+      return;
+
+   context = LLVMContextCreate();
+   if (!context) {
+      variant->fast = FALSE;
+      return;
+   }
+
+   optimized = create_variant(variant->shader, &variant->key, context, FALSE);
+   if (!optimized) {
+      LLVMContextDispose(context);
+      variant->fast = FALSE;
+      return;
+   }
+   optimized->context = context;
+
+   variant->optimized = optimized;
+   util_queue_add_job(&screen->compile_queue, optimized, &optimized->fence,
+                      compile_variant);
+}
+
+
 static void *
 llvmpipe_create_fs_state(struct pipe_context *pipe,
                          const struct pipe_shader_state *templ)
@@ -2745,6 +2940,8 @@ llvmpipe_create_fs_state(struct pipe_context *pipe,
       debug_printf("\n");
    }
 
+   precompile_variant(llvmpipe, shader);
+
    return shader;
 }
 
@@ -2784,8 +2981,6 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants);
    }
 
-   gallivm_destroy(variant->gallivm);
-
    /* remove from shader's list */
    remove_from_list(&variant->list_item_local);
    variant->shader->variants_cached--;
@@ -2795,7 +2990,10 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
    lp->nr_fs_variants--;
    lp->nr_fs_instrs -= variant->nr_instrs;
 
-   FREE(variant);
+   if (lp->fs_variant == variant)
+      lp->fs_variant = NULL;
+
+   free_variant(variant);
 }
 
 
@@ -2823,6 +3021,11 @@ llvmpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
       li = next;
    }
 
+   if (shader->precompiled) {
+      util_queue_job_wait(&shader->precompiled->fence);
+      free_variant(shader->precompiled);
+   }
+
    /* Delete draw module's data */
    draw_delete_fragment_shader(llvmpipe->draw, shader->draw_data);
 
@@ -3165,10 +3368,19 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       }
 
       /*
-       * Generate the new variant.
+       * Generate the new variant, unless it has been precompiled.
        */
       t0 = os_time_get();
-      variant = generate_variant(lp, shader, &key);
+      if (shader->precompiled &&
+          memcmp(&shader->precompiled->key, &key,
+                 shader->variant_key_size) == 0) {
+         variant = shader->precompiled;
+         shader->precompiled = NULL;
+         util_queue_job_wait(&variant->fence);
+      }
+      else {
+         variant = generate_variant(lp, shader, &key);
+      }
       t1 = os_time_get();
       dt = t1 - t0;
       LP_COUNT_ADD(llvm_compile_time, dt);
@@ -3186,6 +3398,7 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
 
    /* Bind this variant */
    lp_setup_set_fs_variant(lp->setup, variant);
+   lp->fs_variant = variant;
 }
 
 
@@ -36,6 +36,7 @@
 #include "gallivm/lp_bld_sample.h" /* for struct lp_sampler_static_state */
 #include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
 #include "lp_bld_interp.h" /* for struct lp_shader_input */
+#include "util/u_queue.h"
 
 
 struct tgsi_token;
@@ -47,6 +48,18 @@ struct lp_fragment_shader;
 #define RAST_EDGE_TEST 1
 
 
+/**
+ * How a fragment shader variant may change the depth buffer, as far as the
+ * rasterizer's hierarchical Z bounds are concerned.
+ */
+enum lp_hiz_write
+{
+   LP_HIZ_WRITE_NONE,   /**< depth buffer is never written */
+   LP_HIZ_WRITE_LOWER,  /**< written values are never greater than the old ones */
+   LP_HIZ_WRITE_ANY
+};
+
+
 struct lp_sampler_static_state
 {
    /*
@@ -100,8 +113,20 @@ struct lp_fragment_shader_variant
    boolean opaque;
    uint8_t ps_inv_multiplier;
 
+   /** Whole blocks may be rejected against the hierarchical Z bounds */
+   boolean hiz_test;
+   enum lp_hiz_write hiz_write;
+
    struct gallivm_state *gallivm;
 
+   /* LLVM context owned by the variant when it is compiled on the screen's
+    * compile queue, NULL when it uses the llvmpipe context's one.
+    */
+   LLVMContextRef context;
+
+   /* Signalled once the variant's functions have been compiled. */
+   struct util_queue_fence fence;
+
    LLVMTypeRef jit_context_ptr_type;
    LLVMTypeRef jit_thread_data_ptr_type;
    LLVMTypeRef jit_linear_context_ptr_type;
@@ -113,6 +138,11 @@ struct lp_fragment_shader_variant
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
+   /* Compiled without optimizations, until the optimized copy is ready. */
+   boolean fast;
+   unsigned nr_draws;
+   struct lp_fragment_shader_variant *optimized;
+
    struct lp_fs_variant_list_item list_item_global, list_item_local;
    struct lp_fragment_shader *shader;
 
@@ -130,6 +160,11 @@ struct lp_fragment_shader
 
    struct lp_fs_variant_list_item variants;
 
+   /* Variant compiled ahead of time for the state current at creation,
+    * not on the variant lists until a draw needs it.
+    */
+   struct lp_fragment_shader_variant *precompiled;
+
    struct draw_fragment_shader *draw_data;
 
    /* For debugging/profiling purposes */
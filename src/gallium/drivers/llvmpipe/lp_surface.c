@@ -25,6 +25,7 @@
  * 
  **************************************************************************/
 
+#include "util/u_box.h"
 #include "util/u_rect.h"
 #include "util/u_surface.h"
 #include "lp_context.h"
@@ -61,11 +62,36 @@ lp_resource_copy(struct pipe_context *pipe,
 }
 
 
+/**
+ * Tiled resources can't be sampled from, so copy the source of a blit
+ * into a linear texture first.
+ */
+static struct pipe_resource *
+lp_blit_linear_source(struct pipe_context *pipe,
+                      struct pipe_resource *src)
+{
+   struct pipe_resource templ = *src;
+   struct pipe_resource *linear;
+   struct pipe_box box;
+
+   templ.bind = PIPE_BIND_SAMPLER_VIEW;
+   templ.usage = PIPE_USAGE_STAGING;
+   linear = pipe->screen->resource_create(pipe->screen, &templ);
+   if (!linear)
+      return NULL;
+
+   u_box_2d(0, 0, src->width0, src->height0, &box);
+   lp_resource_copy(pipe, linear, 0, 0, 0, 0, src, 0, &box);
+   return linear;
+}
+
+
 static void lp_blit(struct pipe_context *pipe,
                     const struct pipe_blit_info *blit_info)
 {
    struct llvmpipe_context *lp = llvmpipe_context(pipe);
    struct pipe_blit_info info = *blit_info;
+   struct pipe_resource *linear_src = NULL;
 
    if (blit_info->render_condition_enable && !llvmpipe_check_render_cond(lp))
       return;
@@ -89,6 +115,13 @@ static void lp_blit(struct pipe_context *pipe,
       return;
    }
 
+   if (llvmpipe_resource(info.src.resource)->tiled) {
+      linear_src = lp_blit_linear_source(pipe, info.src.resource);
+      if (!linear_src)
+         return;
+      info.src.resource = linear_src;
+   }
+
    /* XXX turn off occlusion and streamout queries */
 
    util_blitter_save_vertex_buffer_slot(lp->blitter, lp->vertex_buffer);
@@ -115,6 +148,8 @@ static void lp_blit(struct pipe_context *pipe,
    util_blitter_save_render_condition(lp->blitter, lp->render_cond_query,
                                       lp->render_cond_cond, lp->render_cond_mode);
    util_blitter_blit(lp->blitter, &info);
+
+   pipe_resource_reference(&linear_src, NULL);
 }
 
 
@@ -0,0 +1,315 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Unit tests and benchmark for the gallivm translate backend.
+ *
+ * The output of translate_llvm is checked against translate_generic, and
+ * the cycles per vertex of both are reported.
+ */
+
+
+#include "util/u_memory.h"
+#include "util/u_format.h"
+#include "translate/translate.h"
+
+#include "lp_test.h"
+
+
+#define NUM_VERTS 256
+#define NUM_RUNS 8
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "cycles_per_vertex_generic\t"
+           "cycles_per_vertex_llvm\t"
+           "input_format\t"
+           "output_format\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              enum pipe_format input_format,
+              enum pipe_format output_format,
+              double generic_cycles,
+              double llvm_cycles,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%.1f\t", generic_cycles / NUM_VERTS);
+   fprintf(fp, "%.1f\t", llvm_cycles / NUM_VERTS);
+
+   fprintf(fp, "%s\t", util_format_name(input_format));
+   fprintf(fp, "%s\n", util_format_name(output_format));
+
+   fflush(fp);
+}
+
+
+/**
+ * Largest difference expected between the generic and the JIT'ed paths,
+ * which may round differently when converting through floats.
+ */
+static double
+format_eps(const struct util_format_description *desc)
+{
+   double eps = 1e-6;
+   unsigned chan;
+
+   for (chan = 0; chan < desc->nr_channels; chan++) {
+      const struct util_format_channel_description *channel =
+         &desc->channel[chan];
+
+      if (channel->type == UTIL_FORMAT_TYPE_FLOAT) {
+         if (channel->size == 16)
+            eps = MAX2(eps, 1e-3);
+      }
+      else if (channel->normalized) {
+         unsigned bits = channel->size -
+                         (channel->type == UTIL_FORMAT_TYPE_SIGNED ? 1 : 0);
+         eps = MAX2(eps, 1.01 / (double)((1ULL << bits) - 1));
+      }
+      else if (channel->type != UTIL_FORMAT_TYPE_VOID) {
+         eps = MAX2(eps, 1.0);
+      }
+   }
+
+   return eps;
+}
+
+
+static uint64_t
+time_run(struct translate *translate, const unsigned *elts, void *output)
+{
+   uint64_t best = ~(uint64_t)0;
+   unsigned i;
+
+   for (i = 0; i < NUM_RUNS; i++) {
+      int64_t start_counter = rdtsc();
+      translate->run_elts(translate, elts, NUM_VERTS, 0, 0, output);
+      best = MIN2(best, (uint64_t)(rdtsc() - start_counter));
+   }
+
+   return best;
+}
+
+
+PIPE_ALIGN_STACK
+static boolean
+test_one(unsigned verbose,
+         FILE *fp,
+         enum pipe_format input_format,
+         enum pipe_format output_format)
+{
+   const struct util_format_description *in_desc =
+      util_format_description(input_format);
+   const struct util_format_description *out_desc =
+      util_format_description(output_format);
+   unsigned in_size = util_format_get_blocksize(input_format);
+   unsigned out_size = util_format_get_blocksize(output_format);
+   struct translate_key key;
+   struct translate *generic, *llvm;
+   float src_rgba[NUM_VERTS][4];
+   unsigned elts[NUM_VERTS];
+   uint8_t *src, *generic_dst, *llvm_dst;
+   double generic_cycles, llvm_cycles;
+   double eps = format_eps(out_desc);
+   boolean success = TRUE;
+   unsigned i, k;
+
+   memset(&key, 0, sizeof key);
+   key.output_stride = out_size;
+   key.nr_elements = 1;
+   key.element[0].type = TRANSLATE_ELEMENT_NORMAL;
+   key.element[0].input_format = input_format;
+   key.element[0].output_format = output_format;
+
+   llvm = translate_llvm_create(&key);
+   if (!llvm) {
+      /* Not handled by the JIT, translate_create() uses generic instead. */
+      return TRUE;
+   }
+
+   generic = translate_generic_create(&key);
+   if (!generic) {
+      llvm->release(llvm);
+      return TRUE;
+   }
+
+   if (verbose >= 1)
+      fprintf(stderr, "%s -> %s\n", util_format_name(input_format),
+              util_format_name(output_format));
+
+   src = MALLOC(NUM_VERTS * in_size);
+   generic_dst = CALLOC(NUM_VERTS, out_size);
+   llvm_dst = CALLOC(NUM_VERTS, out_size);
+
+   for (i = 0; i < NUM_VERTS; i++) {
+      for (k = 0; k < 4; k++)
+         src_rgba[i][k] = random_float();
+      elts[i] = rand() % NUM_VERTS;
+   }
+
+   in_desc->pack_rgba_float(src, NUM_VERTS * in_size, &src_rgba[0][0],
+                            sizeof src_rgba, NUM_VERTS, 1);
+
+   generic->set_buffer(generic, 0, src, in_size, NUM_VERTS - 1);
+   llvm->set_buffer(llvm, 0, src, in_size, NUM_VERTS - 1);
+
+   generic_cycles = (double)time_run(generic, elts, generic_dst);
+   llvm_cycles = (double)time_run(llvm, elts, llvm_dst);
+
+   for (i = 0; i < NUM_VERTS && success; i++) {
+      float expected[4], obtained[4];
+
+      out_desc->fetch_rgba_float(expected, generic_dst + i * out_size, 0, 0);
+      out_desc->fetch_rgba_float(obtained, llvm_dst + i * out_size, 0, 0);
+
+      for (k = 0; k < 4; k++) {
+         if (fabs(expected[k] - obtained[k]) > eps)
+            success = FALSE;
+      }
+
+      if (!success) {
+         fprintf(stderr, "MISMATCH: %s -> %s, vertex %u\n",
+                 util_format_name(input_format),
+                 util_format_name(output_format), i);
+         fprintf(stderr, "  Obtained: %f %f %f %f\n",
+                 obtained[0], obtained[1], obtained[2], obtained[3]);
+         fprintf(stderr, "  Expected: %f %f %f %f\n",
+                 expected[0], expected[1], expected[2], expected[3]);
+      }
+   }
+
+   if (fp)
+      write_tsv_row(fp, input_format, output_format,
+                    generic_cycles, llvm_cycles, success);
+
+   FREE(src);
+   FREE(generic_dst);
+   FREE(llvm_dst);
+
+   generic->release(generic);
+   llvm->release(llvm);
+
+   return success;
+}
+
+
+/**
+ * Vertex formats drivers commonly lack, and the formats u_vbuf translates
+ * them to.
+ */
+static const enum pipe_format input_formats[] = {
+   PIPE_FORMAT_R64G64B64A64_FLOAT,
+   PIPE_FORMAT_R64G64B64_FLOAT,
+   PIPE_FORMAT_R64_FLOAT,
+   PIPE_FORMAT_R32G32B32A32_FIXED,
+   PIPE_FORMAT_R32G32B32_UNORM,
+   PIPE_FORMAT_R32G32_SNORM,
+   PIPE_FORMAT_R32G32B32A32_USCALED,
+   PIPE_FORMAT_R16G16B16_FLOAT,
+   PIPE_FORMAT_R16G16B16_SNORM,
+   PIPE_FORMAT_R16G16B16_USCALED,
+   PIPE_FORMAT_R16G16_SSCALED,
+   PIPE_FORMAT_R8G8B8_UNORM,
+   PIPE_FORMAT_R8G8B8_SNORM,
+   PIPE_FORMAT_R8G8B8A8_USCALED,
+   PIPE_FORMAT_R10G10B10A2_SNORM,
+   PIPE_FORMAT_B10G10R10A2_UNORM,
+};
+
+static const enum pipe_format output_formats[] = {
+   PIPE_FORMAT_R32G32B32A32_FLOAT,
+   PIPE_FORMAT_R32G32B32_FLOAT,
+   PIPE_FORMAT_R32G32_FLOAT,
+   PIPE_FORMAT_R16G16B16A16_FLOAT,
+   PIPE_FORMAT_R16G16B16A16_SNORM,
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_R10G10B10A2_UNORM,
+};
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   boolean success = TRUE;
+   int error_count = 0;
+   unsigned i, j;
+
+   for (i = 0; i < ARRAY_SIZE(input_formats); i++) {
+      for (j = 0; j < ARRAY_SIZE(output_formats); j++) {
+         if (!test_one(verbose, fp, input_formats[i], output_formats[j])) {
+            success = FALSE;
+            ++error_count;
+         }
+      }
+   }
+
+   fprintf(stderr, "%d failures\n", error_count);
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   boolean success = TRUE;
+   unsigned long i;
+
+   for (i = 0; i < n; ++i) {
+      enum pipe_format input_format =
+         input_formats[rand() % ARRAY_SIZE(input_formats)];
+      enum pipe_format output_format =
+         output_formats[rand() % ARRAY_SIZE(output_formats)];
+
+      if (!test_one(verbose, fp, input_format, output_format))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_one(verbose, fp, PIPE_FORMAT_R64G64B64A64_FLOAT,
+                   PIPE_FORMAT_R32G32B32A32_FLOAT);
+}
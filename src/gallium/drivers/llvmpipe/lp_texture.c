@@ -183,6 +183,105 @@ fail:
 }
 
 
+/**
+ * Whether to store a resource as contiguous tiles.  Tiles are only laid
+ * out for the rasterizer, so the resource must never be sampled from,
+ * and must have a single 2D image.
+ */
+static boolean
+llvmpipe_can_tile(const struct llvmpipe_screen *screen,
+                  const struct pipe_resource *pt)
+{
+   return screen->tiled_render_targets &&
+          (pt->target == PIPE_TEXTURE_2D ||
+           pt->target == PIPE_TEXTURE_RECT) &&
+          pt->last_level == 0 &&
+          pt->array_size == 1 &&
+          pt->nr_samples <= 1 &&
+          pt->usage != PIPE_USAGE_STAGING &&
+          (pt->bind & (PIPE_BIND_RENDER_TARGET |
+                       PIPE_BIND_DEPTH_STENCIL)) &&
+          !(pt->bind & (PIPE_BIND_SAMPLER_VIEW |
+                        PIPE_BIND_SHADER_IMAGE |
+                        PIPE_BIND_LINEAR)) &&
+          !util_format_is_compressed(pt->format);
+}
+
+
+/**
+ * Allocation path for tiled render targets: the image is stored as
+ * TILE_SIZE x TILE_SIZE tiles, row of tiles after row of tiles, so that
+ * the tile a rasterizer thread works on is one contiguous block of memory.
+ */
+static boolean
+llvmpipe_tiled_layout(struct llvmpipe_screen *screen,
+                      struct llvmpipe_resource *lpr)
+{
+   struct pipe_resource *pt = &lpr->base;
+   const unsigned block_size = util_format_get_blocksize(pt->format);
+   const unsigned tiles_x = align(pt->width0, TILE_SIZE) / TILE_SIZE;
+   const unsigned tiles_y = align(pt->height0, TILE_SIZE) / TILE_SIZE;
+   uint64_t total_size;
+
+   total_size = (uint64_t)tiles_x * tiles_y * TILE_SIZE * TILE_SIZE * block_size;
+   if (total_size > LP_MAX_TEXTURE_SIZE)
+      return FALSE;
+
+   lpr->tiled = TRUE;
+   lpr->row_stride[0] = TILE_SIZE * block_size;
+   lpr->img_stride[0] = (unsigned)total_size;
+   lpr->mip_offsets[0] = 0;
+
+   lpr->tex_data = align_malloc(total_size, 64);
+   if (!lpr->tex_data)
+      return FALSE;
+
+   memset(lpr->tex_data, 0, total_size);
+   return TRUE;
+}
+
+
+/**
+ * Copy the box of a tiled resource to or from a linear image.
+ */
+static void
+llvmpipe_tiled_copy(struct llvmpipe_resource *lpr,
+                    uint8_t *linear, unsigned linear_stride,
+                    const struct pipe_box *box,
+                    boolean to_tiled)
+{
+   const unsigned block_size = util_format_get_blocksize(lpr->base.format);
+   const unsigned row_stride = lpr->row_stride[0];
+   const unsigned tile_stride = TILE_SIZE * row_stride;
+   const unsigned tiles_x = align(lpr->base.width0, TILE_SIZE) / TILE_SIZE;
+   int x, y;
+
+   assert(lpr->tiled);
+
+   for (y = 0; y < box->height; y++) {
+      const unsigned ty = box->y + y;
+      uint8_t *row = linear + y * linear_stride;
+
+      for (x = 0; x < box->width; ) {
+         const unsigned tx = box->x + x;
+         const unsigned span = MIN2(TILE_SIZE - tx % TILE_SIZE,
+                                    box->width - x);
+         uint8_t *tiled = (uint8_t *)lpr->tex_data +
+                          (ty / TILE_SIZE * tiles_x + tx / TILE_SIZE) * tile_stride +
+                          (ty % TILE_SIZE) * row_stride +
+                          (tx % TILE_SIZE) * block_size;
+
+         if (to_tiled)
+            memcpy(tiled, row + x * block_size, span * block_size);
+         else
+            memcpy(row + x * block_size, tiled, span * block_size);
+
+         x += span;
+      }
+   }
+}
+
+
 /**
  * Check the size of the texture specified by 'res'.
  * \return TRUE if OK, FALSE if too large.
@@ -260,6 +359,11 @@ llvmpipe_resource_create_front(struct pipe_screen *_screen,
          if (!llvmpipe_displaytarget_layout(screen, lpr, map_front_private))
             goto fail;
       }
+      else if (llvmpipe_can_tile(screen, &lpr->base)) {
+         /* tiled render target */
+         if (!llvmpipe_tiled_layout(screen, lpr))
+            goto fail;
+      }
       else {
          /* texture map */
          if (!llvmpipe_texture_layout(screen, lpr, true))
@@ -324,7 +428,7 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
    }
    else if (llvmpipe_resource_is_texture(pt)) {
       /* free linear image data */
-      if (lpr->tex_data) {
+      if (lpr->tex_data && !lpr->userBuffer) {
          align_free(lpr->tex_data);
          lpr->tex_data = NULL;
       }
@@ -431,6 +535,30 @@ llvmpipe_resource_data(struct pipe_resource *resource)
 }
 
 
+/**
+ * Get the offsets in bytes between horizontally and vertically adjacent
+ * TILE_SIZE x TILE_SIZE tiles of a texture level.
+ */
+void
+llvmpipe_resource_tile_strides(struct pipe_resource *resource,
+                               unsigned level,
+                               unsigned *x_stride,
+                               unsigned *y_stride)
+{
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+
+   if (lpr->tiled) {
+      assert(level == 0);
+      *x_stride = TILE_SIZE * lpr->row_stride[0];
+      *y_stride = *x_stride * (align(resource->width0, TILE_SIZE) / TILE_SIZE);
+   }
+   else {
+      *x_stride = TILE_SIZE * util_format_get_blocksize(resource->format);
+      *y_stride = TILE_SIZE * lpr->row_stride[level];
+   }
+}
+
+
 static struct pipe_resource *
 llvmpipe_resource_from_handle(struct pipe_screen *screen,
                               const struct pipe_resource *template,
@@ -483,6 +611,60 @@ no_lpr:
 }
 
 
+/**
+ * Wrap user memory in a linear render target.  Only single level 2D images
+ * whose size is a multiple of the tile size are accepted, stored with the
+ * natural row stride of width * blocksize, so that rendering never touches
+ * memory outside of the image.
+ */
+static struct pipe_resource *
+llvmpipe_resource_from_user_memory(struct pipe_screen *screen,
+                                   const struct pipe_resource *templat,
+                                   void *user_memory)
+{
+   struct llvmpipe_resource *lpr;
+   unsigned row_stride;
+
+   if ((templat->target != PIPE_TEXTURE_2D &&
+        templat->target != PIPE_TEXTURE_RECT) ||
+       templat->last_level != 0 ||
+       templat->depth0 != 1 ||
+       templat->array_size != 1 ||
+       templat->nr_samples > 1 ||
+       util_format_is_compressed(templat->format) ||
+       templat->width0 % TILE_SIZE != 0 ||
+       templat->height0 % TILE_SIZE != 0 ||
+       (uintptr_t) user_memory % 16 != 0)
+      return NULL;
+
+   row_stride = templat->width0 * util_format_get_blocksize(templat->format);
+   if ((uint64_t) row_stride * templat->height0 > LP_MAX_TEXTURE_SIZE)
+      return NULL;
+
+   lpr = CALLOC_STRUCT(llvmpipe_resource);
+   if (!lpr)
+      return NULL;
+
+   lpr->base = *templat;
+   pipe_reference_init(&lpr->base.reference, 1);
+   lpr->base.screen = screen;
+
+   lpr->row_stride[0] = row_stride;
+   lpr->img_stride[0] = row_stride * templat->height0;
+   lpr->mip_offsets[0] = 0;
+   lpr->tex_data = user_memory;
+   lpr->userBuffer = TRUE;
+
+   lpr->id = id_counter++;
+
+#ifdef DEBUG
+   insert_at_tail(&resource_list, lpr);
+#endif
+
+   return &lpr->base;
+}
+
+
 static boolean
 llvmpipe_resource_get_handle(struct pipe_screen *screen,
                             struct pipe_resource *pt,
@@ -592,6 +774,29 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
 
    format = lpr->base.format;
 
+   if (lpr->tiled) {
+      /* Map a linear copy of the box, which is written back on unmap. */
+      assert(box->z == 0 && box->depth == 1);
+
+      pt->stride = box->width * util_format_get_blocksize(format);
+      pt->layer_stride = pt->stride * box->height;
+
+      lpt->staging = MALLOC(pt->layer_stride);
+      if (!lpt->staging) {
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(lpt);
+         return NULL;
+      }
+
+      if (usage & PIPE_TRANSFER_READ)
+         llvmpipe_tiled_copy(lpr, lpt->staging, pt->stride, box, FALSE);
+
+      if (usage & PIPE_TRANSFER_WRITE)
+         screen->timestamp++;
+
+      return lpt->staging;
+   }
+
    map = llvmpipe_resource_map(resource,
                                level,
                                box->z,
@@ -619,6 +824,8 @@ static void
 llvmpipe_transfer_unmap(struct pipe_context *pipe,
                         struct pipe_transfer *transfer)
 {
+   struct llvmpipe_transfer *lpt = llvmpipe_transfer(transfer);
+
    assert(transfer->resource);
 
    llvmpipe_resource_unmap(transfer->resource,
@@ -627,8 +834,16 @@ llvmpipe_transfer_unmap(struct pipe_context *pipe,
 
    /* Effectively do the texture_update work here - if texture images
     * needed post-processing to put them into hardware layout, this is
-    * where it would happen.  For llvmpipe, nothing to do.
+    * where it would happen.  For llvmpipe, only tiled render targets.
     */
+   if (lpt->staging) {
+      if (transfer->usage & PIPE_TRANSFER_WRITE)
+         llvmpipe_tiled_copy(llvmpipe_resource(transfer->resource),
+                             lpt->staging, transfer->stride,
+                             &transfer->box, TRUE);
+      FREE(lpt->staging);
+   }
+
    assert (transfer->resource);
    pipe_resource_reference(&transfer->resource, NULL);
    FREE(transfer);
@@ -811,6 +1026,7 @@ llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen)
    screen->resource_destroy = llvmpipe_resource_destroy;
    screen->resource_from_handle = llvmpipe_resource_from_handle;
    screen->resource_get_handle = llvmpipe_resource_get_handle;
+   screen->resource_from_user_memory = llvmpipe_resource_from_user_memory;
    screen->can_create_resource = llvmpipe_can_create_resource;
 }
 
@@ -69,6 +69,14 @@ struct llvmpipe_resource
    /** allocated total size (for non-display target texture resources only) */
    unsigned total_alloc_size;
 
+   /**
+    * Render target stored as TILE_SIZE x TILE_SIZE tiles which are each
+    * contiguous in memory, row by row.  row_stride is the stride of a row
+    * within a tile then.  Only single level, single layer 2D resources which
+    * are never sampled from are tiled, see llvmpipe_tiled_layout().
+    */
+   boolean tiled;
+
    /**
     * Display target, for textures with the PIPE_BIND_DISPLAY_TARGET
     * usage.
@@ -102,6 +110,9 @@ struct llvmpipe_transfer
    struct pipe_transfer base;
 
    unsigned long offset;
+
+   /** Linear copy of the mapped box of tiled resources */
+   uint8_t *staging;
 };
 
 
@@ -211,6 +222,13 @@ void *
 llvmpipe_resource_data(struct pipe_resource *resource);
 
 
+void
+llvmpipe_resource_tile_strides(struct pipe_resource *resource,
+                               unsigned level,
+                               unsigned *x_stride,
+                               unsigned *y_stride);
+
+
 unsigned
 llvmpipe_resource_size(const struct pipe_resource *resource);
 
@@ -24,6 +24,8 @@
 #include "codegen/nv50_ir_target.h"
 #include "codegen/nv50_ir_driver.h"
 
+#include "os/os_time.h"
+
 extern "C" {
 #include "nouveau_debug.h"
 #include "nv50/nv50_program.h"
@@ -1190,19 +1192,13 @@ nv50_ir_init_prog_info(struct nv50_ir_prog_info *info)
    info->io.backFaceColor[0] = info->io.backFaceColor[1] = 0xff;
 }
 
-int
-nv50_ir_generate_code(struct nv50_ir_prog_info *info)
+static nv50_ir::Program::Type
+nv50_ir_prog_type(uint8_t type)
 {
-   int ret = 0;
-
-   nv50_ir::Program::Type type;
-
-   nv50_ir_init_prog_info(info);
-
 #define PROG_TYPE_CASE(a, b)                                      \
-   case PIPE_SHADER_##a: type = nv50_ir::Program::TYPE_##b; break
+   case PIPE_SHADER_##a: return nv50_ir::Program::TYPE_##b
 
-   switch (info->type) {
+   switch (type) {
    PROG_TYPE_CASE(VERTEX, VERTEX);
    PROG_TYPE_CASE(TESS_CTRL, TESSELLATION_CONTROL);
    PROG_TYPE_CASE(TESS_EVAL, TESSELLATION_EVAL);
@@ -1210,9 +1206,34 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
    PROG_TYPE_CASE(FRAGMENT, FRAGMENT);
    PROG_TYPE_CASE(COMPUTE, COMPUTE);
    default:
-      type = nv50_ir::Program::TYPE_COMPUTE;
-      break;
+      return nv50_ir::Program::TYPE_COMPUTE;
    }
+#undef PROG_TYPE_CASE
+}
+
+// Print the time spent since *start, and restart the measurement.
+static void
+nv50_ir_report_time(const nv50_ir::Program *prog, const char *stage,
+                    int64_t *start)
+{
+   const int64_t now = os_time_get_nano();
+
+   INFO_DBG(prog->dbgFlags, TIMING, "TIMING: %s: %.3f ms\n", stage,
+            (now - *start) / 1000000.0);
+   *start = now;
+}
+
+int
+nv50_ir_generate_code(struct nv50_ir_prog_info *info)
+{
+   int ret = 0;
+   int64_t time = os_time_get_nano();
+
+   nv50_ir::Program::Type type;
+
+   nv50_ir_init_prog_info(info);
+
+   type = nv50_ir_prog_type(info->type);
    INFO_DBG(info->dbgFlags, VERBOSE, "translating program of type %u\n", type);
 
    nv50_ir::Target *targ = nv50_ir::Target::create(info->target);
@@ -1244,6 +1265,7 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
       goto out;
    if (prog->dbgFlags & NV50_IR_DEBUG_VERBOSE)
       prog->print();
+   nv50_ir_report_time(prog, "translation", &time);
 
    targ->parseDriverInfo(info);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_PRE_SSA);
@@ -1252,18 +1274,21 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
 
    if (prog->dbgFlags & NV50_IR_DEBUG_VERBOSE)
       prog->print();
+   nv50_ir_report_time(prog, "SSA construction", &time);
 
    prog->optimizeSSA(info->optLevel);
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_SSA);
 
    if (prog->dbgFlags & NV50_IR_DEBUG_BASIC)
       prog->print();
+   nv50_ir_report_time(prog, "SSA optimization", &time);
 
    if (!prog->registerAllocation()) {
       ret = -4;
       goto out;
    }
    prog->getTarget()->runLegalizePass(prog, nv50_ir::CG_STAGE_POST_RA);
+   nv50_ir_report_time(prog, "register allocation", &time);
 
    prog->optimizePostRA(info->optLevel);
 
@@ -1271,6 +1296,7 @@ nv50_ir_generate_code(struct nv50_ir_prog_info *info)
       ret = -5;
       goto out;
    }
+   nv50_ir_report_time(prog, "emission", &time);
 
 out:
    INFO_DBG(prog->dbgFlags, VERBOSE, "nv50_ir_generate_code: ret = %i\n", ret);
@@ -1286,4 +1312,155 @@ out:
    return ret;
 }
 
+/* The serialized binary starts with a header of 3 dwords: the total size in
+ * bytes, the size of the relocation info in bytes and the number of interp
+ * entries. It's followed by the info struct with its pointers cleared, and
+ * by the data these pointers refer to, each part padded to a dword.
+ */
+
+static uint8_t *
+nv50_ir_write(uint8_t *ptr, const void *data, uint32_t size)
+{
+   if (size)
+      memcpy(ptr, data, size);
+   return ptr + align(size, 4);
+}
+
+static const uint8_t *
+nv50_ir_read(const uint8_t *ptr, void **data, uint32_t size)
+{
+   *data = NULL;
+   if (size) {
+      *data = MALLOC(size);
+      if (*data)
+         memcpy(*data, ptr, size);
+   }
+   return ptr + align(size, 4);
+}
+
+void *
+nv50_ir_serialize_bin(const struct nv50_ir_prog_info *info, uint32_t *size)
+{
+   const nv50_ir::RelocInfo *reloc =
+      reinterpret_cast<const nv50_ir::RelocInfo *>(info->bin.relocData);
+   const nv50_ir::InterpInfo *interp =
+      reinterpret_cast<const nv50_ir::InterpInfo *>(info->bin.interpData);
+   const uint32_t relocSize =
+      reloc ? sizeof(*reloc) + reloc->count * sizeof(reloc->entry[0]) : 0;
+   const uint32_t interpCount = interp ? interp->count : 0;
+   const uint32_t symsSize =
+      info->bin.syms ? info->bin.numSyms * sizeof(info->bin.syms[0]) : 0;
+   struct nv50_ir_prog_info bin = *info;
+   uint32_t header[3];
+   uint8_t *data, *ptr;
+
+   bin.bin.code = NULL;
+   bin.bin.source = NULL;
+   bin.bin.relocData = NULL;
+   bin.bin.interpData = NULL;
+   bin.bin.syms = NULL;
+   bin.bin.numSyms = info->bin.syms ? info->bin.numSyms : 0;
+   bin.immd.buf = NULL;
+   bin.immd.data = NULL;
+   bin.immd.type = NULL;
+   bin.assignSlots = NULL;
+   bin.driverPriv = NULL;
+
+   header[0] = sizeof(header) + align(sizeof(bin), 4) +
+      align(info->bin.codeSize, 4) + align(info->immd.bufSize, 4) +
+      align(relocSize, 4) + interpCount * sizeof(interp->entry[0]) +
+      align(symsSize, 4);
+   header[1] = relocSize;
+   header[2] = interpCount;
+
+   data = (uint8_t *)CALLOC(1, header[0]);
+   if (!data)
+      return NULL;
+
+   ptr = nv50_ir_write(data, header, sizeof(header));
+   ptr = nv50_ir_write(ptr, &bin, sizeof(bin));
+   ptr = nv50_ir_write(ptr, info->bin.code, info->bin.codeSize);
+   ptr = nv50_ir_write(ptr, info->immd.buf, info->immd.bufSize);
+   ptr = nv50_ir_write(ptr, reloc, relocSize);
+   if (interp)
+      ptr = nv50_ir_write(ptr, interp->entry,
+                          interpCount * sizeof(interp->entry[0]));
+   ptr = nv50_ir_write(ptr, info->bin.syms, symsSize);
+   assert(ptr == data + header[0]);
+
+   *size = header[0];
+   return data;
+}
+
+bool
+nv50_ir_deserialize_bin(struct nv50_ir_prog_info *info,
+                        const void *data, uint32_t size)
+{
+   const uint8_t *ptr = (const uint8_t *)data;
+   uint32_t header[3];
+   const void *source = info->bin.source;
+   int (*assignSlots)(struct nv50_ir_prog_info *) = info->assignSlots;
+   void *driverPriv = info->driverPriv;
+   nv50_ir::InterpInfo *interp = NULL;
+   void *tmp;
+
+   if (size < sizeof(header) + align(sizeof(*info), 4))
+      return false;
+   memcpy(header, ptr, sizeof(header));
+   if (header[0] != size)
+      return false;
+   ptr += sizeof(header);
+
+   memcpy(info, ptr, sizeof(*info));
+   ptr += align(sizeof(*info), 4);
+   info->bin.source = source;
+   info->assignSlots = assignSlots;
+   info->driverPriv = driverPriv;
+
+   ptr = nv50_ir_read(ptr, &tmp, info->bin.codeSize);
+   info->bin.code = (uint32_t *)tmp;
+   ptr = nv50_ir_read(ptr, &tmp, info->immd.bufSize);
+   info->immd.buf = (uint32_t *)tmp;
+   ptr = nv50_ir_read(ptr, &info->bin.relocData, header[1]);
+
+   if (header[2]) {
+      nv50_ir::Target *targ = nv50_ir::Target::create(info->target);
+      nv50_ir::CodeEmitter *emit =
+         targ ? targ->getCodeEmitter(nv50_ir_prog_type(info->type)) : NULL;
+
+      interp = (nv50_ir::InterpInfo *)
+         MALLOC(sizeof(*interp) + header[2] * sizeof(interp->entry[0]));
+      if (interp) {
+         interp->count = header[2];
+         interp->apply = emit ? emit->getInterpApply() : NULL;
+         memcpy(interp->entry, ptr, header[2] * sizeof(interp->entry[0]));
+      }
+      ptr += header[2] * sizeof(interp->entry[0]);
+
+      delete emit;
+      if (targ)
+         nv50_ir::Target::destroy(targ);
+   }
+   info->bin.interpData = interp;
+
+   ptr = nv50_ir_read(ptr, &tmp,
+                      info->bin.numSyms * sizeof(info->bin.syms[0]));
+   info->bin.syms = (struct nv50_ir_prog_symbol *)tmp;
+
+   if (ptr != (const uint8_t *)data + size ||
+       (info->bin.codeSize && !info->bin.code) ||
+       (info->immd.bufSize && !info->immd.buf) ||
+       (header[1] && !info->bin.relocData) ||
+       (header[2] && (!interp || !interp->apply)) ||
+       (info->bin.numSyms && !info->bin.syms)) {
+      FREE(info->bin.code);
+      FREE(info->immd.buf);
+      FREE(info->bin.relocData);
+      FREE(interp);
+      FREE(info->bin.syms);
+      return false;
+   }
+   return true;
+}
+
 } // extern "C"
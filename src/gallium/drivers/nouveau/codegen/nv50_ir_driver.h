@@ -63,10 +63,12 @@ struct nv50_ir_varying
 # define NV50_IR_DEBUG_BASIC     (1 << 0)
 # define NV50_IR_DEBUG_VERBOSE   (2 << 0)
 # define NV50_IR_DEBUG_REG_ALLOC (1 << 2)
+# define NV50_IR_DEBUG_TIMING    (1 << 3)
 #else
 # define NV50_IR_DEBUG_BASIC     0
 # define NV50_IR_DEBUG_VERBOSE   0
 # define NV50_IR_DEBUG_REG_ALLOC 0
+# define NV50_IR_DEBUG_TIMING    0
 #endif
 
 struct nv50_ir_prog_symbol
@@ -196,6 +198,13 @@ extern "C" {
 
 extern int nv50_ir_generate_code(struct nv50_ir_prog_info *);
 
+/* Store the output of nv50_ir_generate_code in a single allocation, and
+ * restore it into an info struct set up like for nv50_ir_generate_code. */
+extern void *nv50_ir_serialize_bin(const struct nv50_ir_prog_info *,
+                                   uint32_t *size);
+extern bool nv50_ir_deserialize_bin(struct nv50_ir_prog_info *,
+                                    const void *data, uint32_t size);
+
 extern void nv50_ir_relocate_code(void *relocData, uint32_t *code,
                                   uint32_t codePos,
                                   uint32_t libPos,
@@ -33,6 +33,7 @@ public:
 
    virtual bool emitInstruction(Instruction *);
    virtual uint32_t getMinEncodingSize(const Instruction *) const;
+   virtual InterpApply getInterpApply() const;
 
    virtual void prepareEmission(Program *);
    virtual void prepareEmission(Function *);
@@ -2311,6 +2312,12 @@ interpApply(const InterpEntry *entry, uint32_t *code,
    code[loc + 0] |= reg << 0x14;
 }
 
+InterpApply
+CodeEmitterGM107::getInterpApply() const
+{
+   return interpApply;
+}
+
 void
 CodeEmitterGM107::emitIPA()
 {
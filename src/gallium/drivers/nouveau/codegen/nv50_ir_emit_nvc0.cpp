@@ -33,6 +33,7 @@ public:
 
    virtual bool emitInstruction(Instruction *);
    virtual uint32_t getMinEncodingSize(const Instruction *) const;
+   virtual InterpApply getInterpApply() const;
    virtual void prepareEmission(Function *);
 
    inline void setProgramType(Program::Type pType) { progType = pType; }
@@ -1660,6 +1661,12 @@ interpApply(const InterpEntry *entry, uint32_t *code,
    code[loc + 0] |= reg << 26;
 }
 
+InterpApply
+CodeEmitterNVC0::getInterpApply() const
+{
+   return interpApply;
+}
+
 void
 CodeEmitterNVC0::emitINTERP(const Instruction *i)
 {
@@ -24,6 +24,8 @@
 #include "codegen/nv50_ir_target.h"
 #include "codegen/nv50_ir_build_util.h"
 
+#include "os/os_time.h"
+
 extern "C" {
 #include "util/u_math.h"
 }
@@ -3370,13 +3372,16 @@ DeadCodeElim::checkSplitLoad(Instruction *ld1)
 
 // =============================================================================
 
-#define RUN_PASS(l, n, f)                       \
-   if (level >= (l)) {                          \
-      if (dbgFlags & NV50_IR_DEBUG_VERBOSE)     \
-         INFO("PEEPHOLE: %s\n", #n);            \
-      n pass;                                   \
-      if (!pass.f(this))                        \
-         return false;                          \
+#define RUN_PASS(l, n, f)                                     \
+   if (level >= (l)) {                                        \
+      if (dbgFlags & NV50_IR_DEBUG_VERBOSE)                   \
+         INFO("PEEPHOLE: %s\n", #n);                          \
+      int64_t start = os_time_get_nano();                     \
+      n pass;                                                 \
+      if (!pass.f(this))                                      \
+         return false;                                        \
+      INFO_DBG(dbgFlags, TIMING, "TIMING: %s: %.3f ms\n",     \
+               #n, (os_time_get_nano() - start) / 1000000.0); \
    }
 
 bool
@@ -23,6 +23,8 @@
 #include "codegen/nv50_ir.h"
 #include "codegen/nv50_ir_target.h"
 
+#include "os/os_time.h"
+
 #include <algorithm>
 #include <stack>
 #include <limits>
@@ -228,7 +230,8 @@ RegisterSet::release(DataFile f, int32_t reg, unsigned int size)
 class RegAlloc
 {
 public:
-   RegAlloc(Program *program) : prog(program), sequence(0) { }
+   RegAlloc(Program *program) : prog(program), sequence(0),
+                                liveSetsChanged(false) { }
 
    bool exec();
    bool execFunc();
@@ -290,6 +293,7 @@ private:
    ArrayList insns;
 
    int sequence; // for manual passes through CFG
+   bool liveSetsChanged; // during the current buildLiveSets pass
 };
 
 typedef std::pair<Value *, Value *> ValuePair;
@@ -558,10 +562,14 @@ RegAlloc::buildLiveSets(BasicBlock *bb)
    BasicBlock *bn;
    Instruction *i;
    unsigned int s, d;
+   unsigned int liveCount = ~0;
 
    INFO_DBG(prog->dbgFlags, REG_ALLOC, "buildLiveSets(BB:%i)\n", bb->getId());
 
    bb->liveSet.allocate(func->allLValues.getSize(), false);
+   // live sets only grow from one pass to the next
+   if (bb->liveSet.marker)
+      liveCount = bb->liveSet.popCount();
 
    int n = 0;
    for (Graph::EdgeIterator ei = bb->cfg.outgoing(); !ei.end(); ei.next()) {
@@ -606,6 +614,9 @@ RegAlloc::buildLiveSets(BasicBlock *bb)
    for (i = bb->getPhi(); i && i->op == OP_PHI; i = i->next)
       bb->liveSet.clr(i->getDef(0)->id);
 
+   if (bb->liveSet.popCount() != liveCount)
+      liveSetsChanged = true;
+
    if (prog->dbgFlags & NV50_IR_DEBUG_REG_ALLOC) {
       INFO("BB:%i live set after propagation:\n", bb->getId());
       bb->liveSet.print();
@@ -784,7 +795,7 @@ private:
 
    inline void checkInterference(const RIG_Node *, Graph::EdgeIterator&);
 
-   inline void insertOrderedTail(std::list<RIG_Node *>&, RIG_Node *);
+   static inline bool liveBeginsBefore(const RIG_Node *, const RIG_Node *);
    void checkList(std::list<RIG_Node *>&);
 
 private:
@@ -1176,20 +1187,10 @@ GCRA::checkList(std::list<RIG_Node *>& lst)
    }
 }
 
-void
-GCRA::insertOrderedTail(std::list<RIG_Node *>& list, RIG_Node *node)
+bool
+GCRA::liveBeginsBefore(const RIG_Node *a, const RIG_Node *b)
 {
-   if (node->livei.isEmpty())
-      return;
-   // only the intervals of joined values don't necessarily arrive in order
-   std::list<RIG_Node *>::iterator prev, it;
-   for (it = list.end(); it != list.begin(); it = prev) {
-      prev = it;
-      --prev;
-      if ((*prev)->livei.begin() <= node->livei.begin())
-         break;
-   }
-   list.insert(it, node);
+   return a->livei.begin() < b->livei.begin();
 }
 
 void
@@ -1198,15 +1199,26 @@ GCRA::buildRIG(ArrayList& insns)
    std::list<RIG_Node *> values, active;
 
    for (std::deque<ValueDef>::iterator it = func->ins.begin();
-        it != func->ins.end(); ++it)
-      insertOrderedTail(values, getNode(it->get()->asLValue()));
+        it != func->ins.end(); ++it) {
+      RIG_Node *node = getNode(it->get()->asLValue());
+      if (!node->livei.isEmpty())
+         values.push_back(node);
+   }
 
    for (int i = 0; i < insns.getSize(); ++i) {
       Instruction *insn = reinterpret_cast<Instruction *>(insns.get(i));
-      for (int d = 0; insn->defExists(d); ++d)
-         if (insn->getDef(d)->rep() == insn->getDef(d))
-            insertOrderedTail(values, getNode(insn->getDef(d)->asLValue()));
+      for (int d = 0; insn->defExists(d); ++d) {
+         if (insn->getDef(d)->rep() != insn->getDef(d))
+            continue;
+         RIG_Node *node = getNode(insn->getDef(d)->asLValue());
+         if (!node->livei.isEmpty())
+            values.push_back(node);
+      }
    }
+   // Only the intervals of joined values don't necessarily arrive in order.
+   // Sorting them all at once is stable, and avoids walking the list back
+   // for each of them in large programs.
+   values.sort(liveBeginsBefore);
    checkList(values);
 
    while (!values.empty()) {
@@ -1814,6 +1826,7 @@ RegAlloc::execFunc()
    GCRA gcra(func, insertSpills);
 
    unsigned int i, retries;
+   int64_t time;
    bool ret;
 
    if (!func->ins.empty()) {
@@ -1843,23 +1856,38 @@ RegAlloc::execFunc()
          func->print();
 
       // spilling to registers may add live ranges, need to rebuild everything
+      time = os_time_get_nano();
       ret = true;
       for (sequence = func->cfg.nextSequence(), i = 0;
            ret && i <= func->loopNestingBound;
-           sequence = func->cfg.nextSequence(), ++i)
+           sequence = func->cfg.nextSequence(), ++i) {
+         liveSetsChanged = false;
          ret = buildLiveSets(BasicBlock::get(func->cfg.getRoot()));
+         // the next passes wouldn't change anything either
+         if (!liveSetsChanged)
+            break;
+      }
       // reset marker
       for (ArrayList::Iterator bi = func->allBBlocks.iterator();
            !bi.end(); bi.next())
          BasicBlock::get(bi)->liveSet.marker = false;
       if (!ret)
          break;
+      INFO_DBG(prog->dbgFlags, TIMING, "TIMING: RA live sets: %.3f ms\n",
+               (os_time_get_nano() - time) / 1000000.0);
       func->orderInstructions(this->insns);
 
+      time = os_time_get_nano();
       ret = buildIntervals.run(func);
       if (!ret)
          break;
+      INFO_DBG(prog->dbgFlags, TIMING, "TIMING: RA intervals: %.3f ms\n",
+               (os_time_get_nano() - time) / 1000000.0);
+
+      time = os_time_get_nano();
       ret = gcra.allocateRegisters(insns);
+      INFO_DBG(prog->dbgFlags, TIMING, "TIMING: RA coloring: %.3f ms\n",
+               (os_time_get_nano() - time) / 1000000.0);
       if (ret)
          break; // success
    }
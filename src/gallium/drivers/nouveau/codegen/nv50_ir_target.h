@@ -97,6 +97,8 @@ public:
 
    bool addInterp(int ipa, int reg, InterpApply apply);
    inline void *getInterpInfo() const { return interpInfo; }
+   // function passed to addInterp, for rebuilding InterpInfo
+   virtual InterpApply getInterpApply() const { return NULL; }
 
    virtual void prepareEmission(Program *);
    virtual void prepareEmission(Function *);
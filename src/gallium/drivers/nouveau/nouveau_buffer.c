@@ -12,6 +12,9 @@
 #include "nouveau_mm.h"
 
 #define NOUVEAU_TRANSFER_PUSHBUF_THRESHOLD 192
+/* Writes to bound constant buffers go inline through push_cb, which doesn't
+ * need the copy engine and keeps the update ordered with the draws. */
+#define NOUVEAU_TRANSFER_PUSHBUF_CB_THRESHOLD 1024
 
 struct nouveau_transfer {
    struct pipe_transfer base;
@@ -133,6 +136,17 @@ nouveau_buffer_destroy(struct pipe_screen *pscreen,
    NOUVEAU_DRV_STAT(nouveau_screen(pscreen), buf_obj_current_count, -1);
 }
 
+static inline bool
+nouveau_buffer_cb_bound(const struct nv04_resource *buf)
+{
+   unsigned s;
+
+   for (s = 0; s < ARRAY_SIZE(buf->cb_bindings); ++s)
+      if (buf->cb_bindings[s])
+         return true;
+   return false;
+}
+
 /* Set up a staging area for the transfer. This is either done in "regular"
  * system memory if the driver supports push_data (nv50+) and the data is
  * small enough (and permit_pb == true), or in GART memory.
@@ -143,11 +157,16 @@ nouveau_transfer_staging(struct nouveau_context *nv,
 {
    const unsigned adj = tx->base.box.x & NOUVEAU_MIN_BUFFER_MAP_ALIGN_MASK;
    const unsigned size = align(tx->base.box.width, 4) + adj;
+   const struct nv04_resource *buf = nv04_resource(tx->base.resource);
+   unsigned threshold = NOUVEAU_TRANSFER_PUSHBUF_THRESHOLD;
 
    if (!nv->push_data)
       permit_pb = false;
 
-   if ((size <= NOUVEAU_TRANSFER_PUSHBUF_THRESHOLD) && permit_pb) {
+   if (nv->push_cb && nouveau_buffer_cb_bound(buf))
+      threshold = NOUVEAU_TRANSFER_PUSHBUF_CB_THRESHOLD;
+
+   if ((size <= threshold) && permit_pb) {
       tx->map = align_malloc(size, NOUVEAU_MIN_BUFFER_MAP_ALIGN);
       if (tx->map)
          tx->map += adj;
@@ -452,6 +471,17 @@ nouveau_buffer_transfer_map(struct pipe_context *pipe,
          nv->invalidate_resource_storage(nv, &buf->base, ref);
    }
 
+   /* A bo of its own would be waited for by nouveau_bo_map below. When the
+    * range is discarded, write it through a staging area instead of stalling
+    * on the GPU, like for suballocated buffers.
+    */
+   if (!buf->mm && (usage & PIPE_TRANSFER_DISCARD_RANGE) &&
+       !(usage & (PIPE_TRANSFER_UNSYNCHRONIZED | PIPE_TRANSFER_MAP_DIRECTLY)) &&
+       nouveau_buffer_busy(buf, PIPE_TRANSFER_WRITE)) {
+      if (nouveau_transfer_staging(nv, tx, true))
+         return tx->map;
+   }
+
    /* Note that nouveau_bo_map ends up doing a nouveau_bo_wait with the
     * relevant flags. If buf->mm is set, that means this resource is part of a
     * larger slab bo that holds multiple resources. So in that case, don't
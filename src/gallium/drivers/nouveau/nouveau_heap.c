@@ -54,38 +54,42 @@ int
 nouveau_heap_alloc(struct nouveau_heap *heap, unsigned size, void *priv,
                    struct nouveau_heap **res)
 {
-   struct nouveau_heap *r;
+   struct nouveau_heap *r, *best = NULL;
 
    if (!heap || !size || !res || *res)
       return 1;
 
-   while (heap) {
-      if (!heap->in_use && heap->size >= size) {
-         r = calloc(1, sizeof(struct nouveau_heap));
-         if (!r)
-            return 1;
-
-         r->start  = (heap->start + heap->size) - size;
-         r->size   = size;
-         r->in_use = 1;
-         r->priv   = priv;
+   for (; heap; heap = heap->next) {
+      if (heap->in_use || heap->size < size)
+         continue;
+      if (!best || heap->size < best->size) {
+         best = heap;
+         if (best->size == size)
+            break;
+      }
+   }
+   if (!best)
+      return 1;
 
-         heap->size -= size;
+   r = calloc(1, sizeof(struct nouveau_heap));
+   if (!r)
+      return 1;
 
-         r->next = heap->next;
-         if (heap->next)
-            heap->next->prev = r;
-         r->prev = heap;
-         heap->next = r;
+   r->start  = (best->start + best->size) - size;
+   r->size   = size;
+   r->in_use = 1;
+   r->priv   = priv;
 
-         *res = r;
-         return 0;
-      }
+   best->size -= size;
 
-      heap = heap->next;
-   }
+   r->next = best->next;
+   if (best->next)
+      best->next->prev = r;
+   r->prev = best;
+   best->next = r;
 
-   return 1;
+   *res = r;
+   return 0;
 }
 
 void
@@ -28,9 +28,9 @@
  *
  * On initial allocation, there is a single node with the full size that's
  * marked as not in-use. As allocations are made, blocks are taken off the end
- * of that first node, and inserted right after it. If the first node doesn't
- * have enough free space, we look for free space down in the rest of the
- * list. This can happen if an allocation is made and then freed.
+ * of the smallest free node that is large enough (which is the first node
+ * until something gets freed), and inserted right after it. Picking the best
+ * fit keeps the large holes available for large allocations.
  *
  * The first node will remain with in_use == 0 even if the whole heap is
  * exhausted. Another invariant is that there will never be two sequential
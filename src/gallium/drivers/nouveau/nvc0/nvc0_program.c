@@ -22,7 +22,11 @@
 
 #include "pipe/p_defines.h"
 
+#include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_ureg.h"
+#include "util/disk_cache.h"
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
 
 #include "nvc0/nvc0_context.h"
 
@@ -524,12 +528,178 @@ nvc0_program_dump(struct nvc0_program *prog)
 }
 #endif
 
+/* Shader cache
+ *
+ * The output of nv50_ir_generate_code only depends on the TGSI and on the
+ * info struct it's given, so it's cached under a hash of both. An entry is
+ * the blob returned by nv50_ir_serialize_bin, which starts with its size.
+ */
+
+static bool
+nvc0_program_cache_key(const struct nvc0_program *prog,
+                       const struct nv50_ir_prog_info *info, cache_key key)
+{
+   struct nv50_ir_prog_info params = *info;
+   struct mesa_sha1 *ctx = _mesa_sha1_init();
+
+   if (!ctx)
+      return false;
+
+   params.bin.source = NULL;
+   params.assignSlots = NULL;
+   params.driverPriv = NULL;
+
+   _mesa_sha1_update(ctx, &params, sizeof(params));
+   _mesa_sha1_update(ctx, prog->pipe.tokens,
+                     tgsi_num_tokens(prog->pipe.tokens) *
+                     sizeof(struct tgsi_token));
+   _mesa_sha1_final(ctx, key);
+   return true;
+}
+
+/* Add a blob to the in-memory cache, which takes ownership of it. */
+static void
+nvc0_program_cache_add(struct nvc0_screen *screen, const cache_key key,
+                       void *blob)
+{
+   void *key_copy;
+
+   pipe_mutex_lock(screen->shader_cache_mutex);
+   if (_mesa_hash_table_search(screen->shader_cache, key)) {
+      /* Another context compiled the same shader meanwhile. */
+      pipe_mutex_unlock(screen->shader_cache_mutex);
+      free(blob);
+      return;
+   }
+
+   key_copy = malloc(CACHE_KEY_SIZE);
+   if (!key_copy ||
+       !_mesa_hash_table_insert(screen->shader_cache, key_copy, blob)) {
+      free(key_copy);
+      free(blob);
+   } else {
+      memcpy(key_copy, key, CACHE_KEY_SIZE);
+   }
+   pipe_mutex_unlock(screen->shader_cache_mutex);
+}
+
+/**
+ * Look up the codegen output in the in-memory cache, and then in the on-disk
+ * cache. On success, \p info is filled like by nv50_ir_generate_code.
+ */
+static bool
+nvc0_program_cache_load(struct nvc0_screen *screen, const cache_key key,
+                        struct nv50_ir_prog_info *info)
+{
+   struct hash_entry *entry;
+   uint32_t *blob;
+   size_t size;
+   bool ok = false;
+
+   pipe_mutex_lock(screen->shader_cache_mutex);
+   entry = _mesa_hash_table_search(screen->shader_cache, key);
+   if (entry) {
+      blob = entry->data;
+      ok = nv50_ir_deserialize_bin(info, blob, blob[0]);
+   }
+   pipe_mutex_unlock(screen->shader_cache_mutex);
+
+   if (entry || !screen->disk_shader_cache)
+      return ok;
+
+   blob = disk_cache_get(screen->disk_shader_cache, key, &size);
+   if (!blob)
+      return false;
+
+   if (size < 4 || blob[0] != size ||
+       !nv50_ir_deserialize_bin(info, blob, size)) {
+      /* Truncated or corrupted entry, don't try it again. */
+      disk_cache_remove(screen->disk_shader_cache, key);
+      free(blob);
+      return false;
+   }
+
+   nvc0_program_cache_add(screen, key, blob);
+   return true;
+}
+
+static void
+nvc0_program_cache_store(struct nvc0_screen *screen, const cache_key key,
+                         const struct nv50_ir_prog_info *info)
+{
+   uint32_t size;
+   void *blob = nv50_ir_serialize_bin(info, &size);
+
+   if (!blob)
+      return;
+
+   if (screen->disk_shader_cache)
+      disk_cache_put(screen->disk_shader_cache, key, blob, size);
+   nvc0_program_cache_add(screen, key, blob);
+}
+
+static uint32_t
+nvc0_program_cache_key_hash(const void *key)
+{
+   uint32_t hash;
+
+   /* The key is a SHA-1 already. */
+   memcpy(&hash, key, sizeof(hash));
+   return hash;
+}
+
+static bool
+nvc0_program_cache_key_equals(const void *a, const void *b)
+{
+   return memcmp(a, b, CACHE_KEY_SIZE) == 0;
+}
+
+static void
+nvc0_program_destroy_cache_entry(struct hash_entry *entry)
+{
+   free((void *)entry->key);
+   free(entry->data);
+}
+
+void
+nvc0_program_init_cache(struct nvc0_screen *screen)
+{
+   struct pipe_screen *pscreen = &screen->base.base;
+   char timestamp[32];
+
+   pipe_mutex_init(screen->shader_cache_mutex);
+   screen->shader_cache =
+      _mesa_hash_table_create(NULL, nvc0_program_cache_key_hash,
+                              nvc0_program_cache_key_equals);
+   if (!screen->shader_cache)
+      return;
+
+   /* The name contains the chipset, which the code is compiled for. */
+   if (disk_cache_get_function_timestamp((void *)nvc0_program_init_cache,
+                                         timestamp, sizeof(timestamp)))
+      screen->disk_shader_cache =
+         disk_cache_create(pscreen->get_name(pscreen), timestamp);
+}
+
+void
+nvc0_program_destroy_cache(struct nvc0_screen *screen)
+{
+   if (screen->shader_cache)
+      _mesa_hash_table_destroy(screen->shader_cache,
+                               nvc0_program_destroy_cache_entry);
+   disk_cache_destroy(screen->disk_shader_cache);
+   pipe_mutex_destroy(screen->shader_cache_mutex);
+}
+
 bool
-nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset,
+nvc0_program_translate(struct nvc0_program *prog, struct nvc0_screen *screen,
                        struct pipe_debug_callback *debug)
 {
+   const uint16_t chipset = screen->base.device->chipset;
    struct nv50_ir_prog_info *info;
-   int ret;
+   cache_key key;
+   bool use_cache;
+   int ret = 0;
 
    info = CALLOC_STRUCT(nv50_ir_prog_info);
    if (!info)
@@ -580,10 +750,19 @@ nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset,
    info->optLevel = 3;
 #endif
 
-   ret = nv50_ir_generate_code(info);
-   if (ret) {
-      NOUVEAU_ERR("shader translation failed: %i\n", ret);
-      goto out;
+   /* Debug output is only printed when the code is generated. */
+   use_cache = screen->shader_cache && prog->pipe.tokens && !info->dbgFlags &&
+               nvc0_program_cache_key(prog, info, key);
+
+   if (!use_cache || !nvc0_program_cache_load(screen, key, info)) {
+      ret = nv50_ir_generate_code(info);
+      if (ret) {
+         NOUVEAU_ERR("shader translation failed: %i\n", ret);
+         goto out;
+      }
+      /* before syms and the edge flag output are dropped below */
+      if (use_cache)
+         nvc0_program_cache_store(screen, key, info);
    }
    if (prog->type != PIPE_SHADER_COMPUTE)
       FREE(info->bin.syms);
@@ -668,6 +847,55 @@ out:
    return !ret;
 }
 
+static inline void
+nvc0_program_lru_remove(struct nvc0_program *prog)
+{
+   if (prog->lru.next) {
+      list_del(&prog->lru);
+      prog->lru.next = prog->lru.prev = NULL;
+   }
+}
+
+/* Mark the program as the most recently used one in the code segment. */
+void
+nvc0_program_touch(struct nvc0_screen *screen, struct nvc0_program *prog)
+{
+   nvc0_program_lru_remove(prog);
+   list_addtail(&prog->lru, &screen->code_lru);
+}
+
+static bool
+nvc0_program_is_bound(const struct nvc0_context *nvc0,
+                      const struct nvc0_program *prog)
+{
+   return prog == nvc0->vertprog || prog == nvc0->tctlprog ||
+          prog == nvc0->tevlprog || prog == nvc0->gmtyprog ||
+          prog == nvc0->fragprog || prog == nvc0->compprog ||
+          prog == nvc0->tcp_empty;
+}
+
+/* Free the code of the least recently used program that isn't bound. */
+static bool
+nvc0_program_evict_lru(struct nvc0_context *nvc0)
+{
+   struct nvc0_screen *screen = nvc0->screen;
+
+   list_for_each_entry_safe(struct nvc0_program, evict, &screen->code_lru,
+                            lru) {
+      if (!evict->mem) {
+         /* the code was freed for a re-upload */
+         nvc0_program_lru_remove(evict);
+         continue;
+      }
+      if (nvc0_program_is_bound(nvc0, evict))
+         continue;
+      nouveau_heap_free(&evict->mem);
+      nvc0_program_lru_remove(evict);
+      return true;
+   }
+   return false;
+}
+
 bool
 nvc0_program_upload_code(struct nvc0_context *nvc0, struct nvc0_program *prog)
 {
@@ -695,22 +923,19 @@ nvc0_program_upload_code(struct nvc0_context *nvc0, struct nvc0_program *prog)
 
    ret = nouveau_heap_alloc(screen->text_heap, size, prog, &prog->mem);
    if (ret) {
-      struct nouveau_heap *heap = screen->text_heap;
-      /* Note that the code library, which is allocated before anything else,
-       * does not have a priv pointer. We can stop once we hit it.
+      /* Out of space: evict the least recently used programs, one at a time,
+       * until there is a hole large enough. The bound ones are kept, their
+       * code may be in use by the current draw.
        */
-      while (heap->next && heap->next->priv) {
-         struct nvc0_program *evict = heap->next->priv;
-         nouveau_heap_free(&evict->mem);
-      }
-      debug_printf("WARNING: out of code space, evicting all shaders.\n");
-      ret = nouveau_heap_alloc(heap, size, prog, &prog->mem);
+      while (ret && nvc0_program_evict_lru(nvc0))
+         ret = nouveau_heap_alloc(screen->text_heap, size, prog, &prog->mem);
       if (ret) {
          NOUVEAU_ERR("shader too large (0x%x) to fit in code space ?\n", size);
          return false;
       }
       IMMED_NVC0(nvc0->base.pushbuf, NVC0_3D(SERIALIZE), 0);
    }
+   nvc0_program_touch(screen, prog);
    prog->code_base = prog->mem->start;
    prog->immd_base = align(prog->mem->start + prog->immd_base, 0x100);
    assert((prog->immd_size == 0) || (prog->immd_base + prog->immd_size <=
@@ -812,6 +1037,7 @@ nvc0_program_destroy(struct nvc0_context *nvc0, struct nvc0_program *prog)
    const struct pipe_shader_state pipe = prog->pipe;
    const ubyte type = prog->type;
 
+   nvc0_program_lru_remove(prog);
    if (prog->mem)
       nouveau_heap_free(&prog->mem);
    FREE(prog->code); /* may be 0 for hardcoded shaders */
@@ -3,6 +3,7 @@
 #define __NVC0_PROGRAM_H__
 
 #include "pipe/p_state.h"
+#include "util/list.h"
 
 #define NVC0_CAP_MAX_PROGRAM_TEMPS 128
 
@@ -69,6 +70,7 @@ struct nvc0_program {
    struct nvc0_transform_feedback_state *tfb;
 
    struct nouveau_heap *mem;
+   struct list_head lru; /* in screen->code_lru while linked (next != NULL) */
 };
 
 #endif
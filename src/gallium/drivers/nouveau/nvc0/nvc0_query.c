@@ -222,7 +222,8 @@ nvc0_screen_get_driver_query_group_info(struct pipe_screen *pscreen,
           * each different query, we don't want to allow more than one active
           * query simultaneously to avoid failure when the maximum number of
           * counters is reached. Note that these groups of GPU counters are
-          * currently only used by AMD_performance_monitor.
+          * only used by AMD_performance_monitor, the HUD looks up queries by
+          * name and can sample up to the number of free counter slots.
           */
          info->max_active_queries = 1;
          info->num_queries = nvc0_hw_sm_get_num_queries(screen);
@@ -261,6 +261,7 @@ nvc0_screen_get_param(struct pipe_screen *pscreen, enum pipe_cap param)
    case PIPE_CAP_PCI_DEVICE:
    case PIPE_CAP_PCI_FUNCTION:
    case PIPE_CAP_ROBUST_BUFFER_ACCESS_BEHAVIOR:
+   case PIPE_CAP_INDEX_BOUNDS_NOT_NEEDED:
       return 0;
 
    case PIPE_CAP_VENDOR_ID:
@@ -520,6 +521,8 @@ nvc0_screen_destroy(struct pipe_screen *pscreen)
    nouveau_heap_destroy(&screen->lib_code);
    nouveau_heap_destroy(&screen->text_heap);
 
+   nvc0_program_destroy_cache(screen);
+
    FREE(screen->tic.entries);
 
    nouveau_object_del(&screen->eng3d);
@@ -952,6 +955,7 @@ nvc0_screen_create(struct nouveau_device *dev)
     *  launches, don't use the last 256 bytes to work around them - prefetch ?
     */
    nouveau_heap_init(&screen->text_heap, 0, (1 << 20) - 0x100);
+   list_inithead(&screen->code_lru);
 
    ret = nouveau_bo_new(dev, NV_VRAM_DOMAIN(&screen->base), 1 << 12, 7 << 16, NULL,
                         &screen->uniform_bo);
@@ -1160,6 +1164,8 @@ nvc0_screen_create(struct nouveau_device *dev)
    screen->tic.entries = CALLOC(4096, sizeof(void *));
    screen->tsc.entries = screen->tic.entries + 2048;
 
+   nvc0_program_init_cache(screen);
+
    if (!nvc0_blitter_create(screen))
       goto fail;
 
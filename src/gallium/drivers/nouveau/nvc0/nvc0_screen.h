@@ -1,6 +1,8 @@
 #ifndef __NVC0_SCREEN_H__
 #define __NVC0_SCREEN_H__
 
+#include "os/os_thread.h"
+
 #include "nouveau_screen.h"
 #include "nouveau_mm.h"
 #include "nouveau_fence.h"
@@ -76,6 +78,13 @@ struct nvc0_screen {
 
    struct nouveau_heap *text_heap;
    struct nouveau_heap *lib_code; /* allocated from text_heap */
+   struct list_head code_lru; /* programs in text_heap, least recent first */
+
+   /* codegen output, keyed on the SHA-1 of the TGSI and the translation
+    * parameters */
+   pipe_mutex shader_cache_mutex;
+   struct hash_table *shader_cache;
+   struct disk_cache *disk_shader_cache;
 
    struct nvc0_blitter *blitter;
 
@@ -69,12 +69,14 @@ nvc0_program_update_context_state(struct nvc0_context *nvc0,
 static inline bool
 nvc0_program_validate(struct nvc0_context *nvc0, struct nvc0_program *prog)
 {
-   if (prog->mem)
+   if (prog->mem) {
+      nvc0_program_touch(nvc0->screen, prog);
       return true;
+   }
 
    if (!prog->translated) {
       prog->translated = nvc0_program_translate(
-         prog, nvc0->screen->base.device->chipset, &nvc0->base.debug);
+         prog, nvc0->screen, &nvc0->base.debug);
       if (!prog->translated)
          return false;
    }
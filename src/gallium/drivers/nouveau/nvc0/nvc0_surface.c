@@ -1660,6 +1660,8 @@ nvc0_blitter_destroy(struct nvc0_screen *screen)
          }
       }
    }
+   blitter->vp.code = NULL; /* hardcoded, don't FREE */
+   nvc0_program_destroy(NULL, &blitter->vp);
 
    pipe_mutex_destroy(blitter->mutex);
    FREE(blitter);
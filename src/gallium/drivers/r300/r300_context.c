@@ -33,6 +33,7 @@
 #include "r300_cb.h"
 #include "r300_context.h"
 #include "r300_emit.h"
+#include "r300_fs.h"
 #include "r300_screen.h"
 #include "r300_screen_buffer.h"
 #include "compiler/radeon_regalloc.h"
@@ -98,6 +99,7 @@ static void r300_destroy_context(struct pipe_context* context)
         r300->rws->ctx_destroy(r300->ctx);
 
     rc_destroy_regalloc_state(&r300->fs_regalloc_state);
+    r300_fs_cache_destroy(r300);
 
     /* XXX: No way to tell if this was initialized or not? */
     util_slab_destroy(&r300->pool_transfers);
@@ -478,6 +480,7 @@ struct pipe_context* r300_create_context(struct pipe_screen* screen,
 
     /* Register allocator state */
     rc_init_regalloc_state(&r300->fs_regalloc_state);
+    r300_fs_cache_init(r300);
 
     /* Print driver info. */
 #ifdef DEBUG
@@ -399,6 +399,12 @@ struct r300_resource
      * memory. */
     uint8_t *malloced_buffer;
 
+    /* Index buffers drawn with ubyte indices: the buffer converted to
+     * ushort indices, and how many draws translated it since the last
+     * write. The copy is dropped when the buffer is mapped for writing. */
+    struct pipe_resource *ushort_copy;
+    unsigned ubyte_translations;
+
     /* Texture description (addressing, layout, special features). */
     struct r300_texture_desc tex;
 
@@ -440,6 +446,8 @@ enum r300_fs_validity_status {
     FRAGMENT_SHADER_DIRTY       /* Always validate the FS (if the FS was changed) */
 };
 
+struct hash_table;
+
 struct r300_context {
     /* Parent class */
     struct pipe_context context;
@@ -636,6 +644,8 @@ struct r300_context {
     /* Compiler state. */
     struct rc_regalloc_state fs_regalloc_state; /* Register allocator info for
                                                  * fragment shaders. */
+    struct hash_table *fs_cache; /* Compiled fragment shaders, keyed by
+                                  * tokens and external state. */
 };
 
 #define foreach_atom(r300, atom) \
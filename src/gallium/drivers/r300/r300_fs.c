@@ -22,11 +22,13 @@
  * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
  * USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
+#include "util/hash_table.h"
 #include "util/u_format.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_ureg.h"
 
 #include "r300_cb.h"
@@ -561,6 +563,135 @@ static void r300_translate_fragment_shader(
     r300_emit_fs_code_to_buffer(r300, shader);
 }
 
+/* The cache of compiled fragment shaders.
+ *
+ * Applications and state trackers often create shaders with identical
+ * tokens, or delete and recreate the same shader. The compiler is slow
+ * enough that this causes visible stalls, so every compiled variant is
+ * kept per context and copied into new shader objects on a match. */
+
+#define R300_FS_CACHE_MAX_ENTRIES 64
+
+struct r300_fs_cache_key {
+    struct r300_fragment_program_external_state state;
+    unsigned num_tokens;
+    const struct tgsi_token *tokens;
+};
+
+struct r300_fs_cache_entry {
+    struct r300_fs_cache_key key; /* must be first */
+    struct r300_fragment_shader_code code;
+};
+
+static uint32_t r300_fs_cache_hash(const void *key)
+{
+    const struct r300_fs_cache_key *k = key;
+    uint32_t hash;
+
+    hash = _mesa_hash_data(&k->state, sizeof(k->state));
+    return _mesa_fnv32_1a_accumulate_block(hash, k->tokens,
+                                           k->num_tokens *
+                                           sizeof(struct tgsi_token));
+}
+
+static bool r300_fs_cache_equal(const void *a, const void *b)
+{
+    const struct r300_fs_cache_key *ka = a;
+    const struct r300_fs_cache_key *kb = b;
+
+    return ka->num_tokens == kb->num_tokens &&
+           memcmp(&ka->state, &kb->state, sizeof(ka->state)) == 0 &&
+           memcmp(ka->tokens, kb->tokens,
+                  ka->num_tokens * sizeof(struct tgsi_token)) == 0;
+}
+
+/* Copy everything except the list pointer, giving dst its own copies of
+ * the constants and the command buffer. */
+static void r300_fs_code_copy(struct r300_fragment_shader_code* dst,
+                              struct r300_fragment_shader_code* src)
+{
+    struct r300_fragment_shader_code* next = dst->next;
+
+    *dst = *src;
+    dst->next = next;
+
+    rc_constants_copy(&dst->code.constants, &src->code.constants);
+
+    dst->cb_code = MALLOC(src->cb_code_size * 4);
+    memcpy(dst->cb_code, src->cb_code, src->cb_code_size * 4);
+}
+
+static void r300_fs_cache_delete_entry(struct hash_entry *entry)
+{
+    struct r300_fs_cache_entry *e = entry->data;
+
+    rc_constants_destroy(&e->code.code.constants);
+    FREE(e->code.cb_code);
+    FREE((void*)e->key.tokens);
+    FREE(e);
+}
+
+void r300_fs_cache_init(struct r300_context* r300)
+{
+    r300->fs_cache = _mesa_hash_table_create(NULL, r300_fs_cache_hash,
+                                             r300_fs_cache_equal);
+}
+
+void r300_fs_cache_destroy(struct r300_context* r300)
+{
+    if (r300->fs_cache)
+        _mesa_hash_table_destroy(r300->fs_cache, r300_fs_cache_delete_entry);
+}
+
+/* Compile shader->compare_state variant of the tokens, or copy it
+ * from the cache if it was compiled before. */
+static void r300_compile_fragment_shader(struct r300_context* r300,
+                                         struct r300_fragment_shader_code* shader,
+                                         const struct tgsi_token *tokens)
+{
+    struct r300_fs_cache_key key;
+    struct r300_fs_cache_entry *e;
+    struct hash_entry *entry;
+
+    /* Compiler logs are only printed when a shader is really compiled. */
+    if (!r300->fs_cache || DBG_ON(r300, DBG_FP | DBG_P_STAT)) {
+        r300_translate_fragment_shader(r300, shader, tokens);
+        return;
+    }
+
+    key.state = shader->compare_state;
+    key.num_tokens = tgsi_num_tokens(tokens);
+    key.tokens = tokens;
+
+    entry = _mesa_hash_table_search(r300->fs_cache, &key);
+    if (entry) {
+        e = entry->data;
+        r300_fs_code_copy(shader, &e->code);
+        return;
+    }
+
+    r300_translate_fragment_shader(r300, shader, tokens);
+
+    e = CALLOC_STRUCT(r300_fs_cache_entry);
+    if (!e)
+        return;
+
+    key.tokens = tgsi_dup_tokens(tokens);
+    if (!key.tokens) {
+        FREE(e);
+        return;
+    }
+    e->key = key;
+    r300_fs_code_copy(&e->code, shader);
+    e->code.next = NULL;
+
+    if (_mesa_hash_table_num_entries(r300->fs_cache) >=
+        R300_FS_CACHE_MAX_ENTRIES)
+        _mesa_hash_table_clear(r300->fs_cache, r300_fs_cache_delete_entry);
+
+    _mesa_hash_table_insert(r300->fs_cache, &e->key, e);
+}
+
 boolean r300_pick_fragment_shader(struct r300_context* r300)
 {
     struct r300_fragment_shader* fs = r300_fs(r300);
@@ -576,7 +707,7 @@ boolean r300_pick_fragment_shader(struct r300_context* r300)
 
         memcpy(&fs->shader->compare_state, &state,
             sizeof(struct r300_fragment_program_external_state));
-        r300_translate_fragment_shader(r300, fs->shader, fs->state.tokens);
+        r300_compile_fragment_shader(r300, fs->shader, fs->state.tokens);
         return TRUE;
 
     } else {
@@ -603,7 +734,7 @@ boolean r300_pick_fragment_shader(struct r300_context* r300)
             fs->first = fs->shader = ptr;
 
             ptr->compare_state = state;
-            r300_translate_fragment_shader(r300, ptr, fs->state.tokens);
+            r300_compile_fragment_shader(r300, ptr, fs->state.tokens);
             return TRUE;
         }
     }
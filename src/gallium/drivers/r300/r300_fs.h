@@ -77,6 +77,9 @@ void r300_shader_read_fs_inputs(struct tgsi_shader_info* info,
 /* Return TRUE if the shader was switched and should be re-emitted. */
 boolean r300_pick_fragment_shader(struct r300_context* r300);
 
+void r300_fs_cache_init(struct r300_context* r300);
+void r300_fs_cache_destroy(struct r300_context* r300);
+
 static inline boolean r300_fragment_shader_writes_depth(struct r300_fragment_shader *fs)
 {
     if (!fs)
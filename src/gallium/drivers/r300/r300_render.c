@@ -605,8 +605,9 @@ static void r300_draw_elements(struct r300_context *r300,
 
     /* Fallback for misaligned ushort indices. */
     if (indexSize == 2 && (start & 1) && indexBuffer) {
-        /* If we got here, then orgIndexBuffer == indexBuffer. */
-        uint16_t *ptr = r300->rws->buffer_map(r300_resource(orgIndexBuffer)->buf,
+        /* This is either the original buffer or its cached ushort copy. */
+        struct pipe_resource *srcBuffer = indexBuffer;
+        uint16_t *ptr = r300->rws->buffer_map(r300_resource(srcBuffer)->buf,
                                               r300->cs,
                                               PIPE_TRANSFER_READ |
                                               PIPE_TRANSFER_UNSYNCHRONIZED);
@@ -619,6 +620,9 @@ static void r300_draw_elements(struct r300_context *r300,
              * every sub-buffer in the upload buffer is aligned. */
             r300_upload_index_buffer(r300, &indexBuffer, indexSize, &start,
                                      count, (uint8_t*)ptr);
+
+            if (srcBuffer != orgIndexBuffer)
+                pipe_resource_reference(&srcBuffer, NULL);
         }
     } else {
         if (r300->index_buffer.user_buffer)
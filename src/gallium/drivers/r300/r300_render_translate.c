@@ -22,8 +22,65 @@
 
 #include "r300_context.h"
 #include "util/u_index_modify.h"
+#include "util/u_inlines.h"
 #include "util/u_upload_mgr.h"
 
+/* Return the whole index buffer converted to ushort indices, or NULL.
+ *
+ * Converting only the drawn range has to be redone at every draw, so
+ * once a buffer has been translated again without being written to,
+ * keep a converted copy of the whole buffer until the next write. */
+static struct pipe_resource *
+r300_get_ushort_copy(struct r300_context *r300, struct pipe_index_buffer *ib)
+{
+    struct r300_resource *rbuf;
+    struct pipe_resource *copy;
+    struct pipe_transfer *src_transfer, *dst_transfer;
+    const uint8_t *in_map;
+    uint16_t *out_map;
+    unsigned i, size;
+
+    if (ib->user_buffer || !ib->buffer)
+        return NULL;
+
+    rbuf = r300_resource(ib->buffer);
+
+    if (rbuf->ushort_copy)
+        return rbuf->ushort_copy;
+
+    if (++rbuf->ubyte_translations < 2)
+        return NULL;
+
+    size = ib->buffer->width0;
+    copy = pipe_buffer_create(r300->context.screen, PIPE_BIND_INDEX_BUFFER,
+                              PIPE_USAGE_IMMUTABLE, size * 2);
+    if (!copy)
+        return NULL;
+
+    in_map = pipe_buffer_map(&r300->context, ib->buffer,
+                             PIPE_TRANSFER_READ, &src_transfer);
+    out_map = pipe_buffer_map(&r300->context, copy,
+                              PIPE_TRANSFER_WRITE |
+                              PIPE_TRANSFER_UNSYNCHRONIZED, &dst_transfer);
+    if (!in_map || !out_map) {
+        if (in_map)
+            pipe_buffer_unmap(&r300->context, src_transfer);
+        if (out_map)
+            pipe_buffer_unmap(&r300->context, dst_transfer);
+        pipe_resource_reference(&copy, NULL);
+        return NULL;
+    }
+
+    for (i = 0; i < size; i++)
+        out_map[i] = in_map[i];
+
+    pipe_buffer_unmap(&r300->context, src_transfer);
+    pipe_buffer_unmap(&r300->context, dst_transfer);
+
+    rbuf->ushort_copy = copy;
+    return copy;
+}
+
 
 void r300_translate_index_buffer(struct r300_context *r300,
                                  struct pipe_index_buffer *ib,
@@ -37,6 +94,17 @@ void r300_translate_index_buffer(struct r300_context *r300,
     switch (*index_size) {
     case 1:
         *out_buffer = NULL;
+
+        if (!index_offset) {
+            struct pipe_resource *copy = r300_get_ushort_copy(r300, ib);
+
+            if (copy) {
+                pipe_resource_reference(out_buffer, copy);
+                *index_size = 2;
+                break;
+            }
+        }
+
         u_upload_alloc(r300->uploader, 0, count * 2, 4,
                        &out_offset, out_buffer, &ptr);
 
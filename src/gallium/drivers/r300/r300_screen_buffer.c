@@ -56,6 +56,7 @@ static void r300_buffer_destroy(struct pipe_screen *screen,
     struct r300_resource *rbuf = r300_resource(buf);
 
     align_free(rbuf->malloced_buffer);
+    pipe_resource_reference(&rbuf->ushort_copy, NULL);
 
     if (rbuf->buf)
         pb_reference(&rbuf->buf, NULL);
@@ -85,6 +86,11 @@ r300_buffer_transfer_map( struct pipe_context *context,
     transfer->stride = 0;
     transfer->layer_stride = 0;
 
+    if (usage & PIPE_TRANSFER_WRITE) {
+        pipe_resource_reference(&rbuf->ushort_copy, NULL);
+        rbuf->ubyte_translations = 0;
+    }
+
     if (rbuf->malloced_buffer) {
         *ptransfer = transfer;
         return rbuf->malloced_buffer + box->x;
@@ -170,6 +176,8 @@ struct pipe_resource *r300_buffer_create(struct pipe_screen *screen,
     rbuf->domain = RADEON_DOMAIN_GTT;
     rbuf->buf = NULL;
     rbuf->malloced_buffer = NULL;
+    rbuf->ushort_copy = NULL;
+    rbuf->ubyte_translations = 0;
 
     /* Allocate constant buffers and SWTCL vertex and index buffers in RAM.
      * Note that uploaded index buffers use the flag PIPE_BIND_CUSTOM, so that
@@ -307,6 +307,32 @@ int compute_memory_finalize_pending(struct compute_memory_pool* pool,
 		return 0;
 	}
 
+	/* Place what fits into the free space between the items first, the
+	 * pool only needs to be compacted or grown for the rest. */
+	if (pool->bo) {
+		LIST_FOR_EACH_ENTRY_SAFE(item, next, pool->unallocated_list, link) {
+			if (!(item->status & ITEM_FOR_PROMOTING) ||
+			    item->size_in_dw > pool->size_in_dw)
+				continue;
+
+			last_pos = compute_memory_prealloc_chunk(pool, item->size_in_dw);
+			if (last_pos == -1)
+				continue;
+
+			err = compute_memory_promote_item(pool, item, pipe, last_pos);
+			item->status &= ~ITEM_FOR_PROMOTING;
+
+			allocated += align(item->size_in_dw, ITEM_ALIGNMENT);
+			unallocated -= align(item->size_in_dw, ITEM_ALIGNMENT);
+
+			if (err == -1)
+				return -1;
+		}
+
+		if (unallocated == 0)
+			return 0;
+	}
+
 	if (pool->size_in_dw < allocated + unallocated) {
 		err = compute_memory_grow_defrag_pool(pool, pipe, allocated + unallocated);
 		if (err == -1)
@@ -395,8 +421,8 @@ int compute_memory_promote_item(struct compute_memory_pool *pool,
 	/* Remove the item from the unallocated list */
 	list_del(&item->link);
 
-	/* Add it back to the item_list */
-	list_addtail(&item->link, pool->item_list);
+	/* Add it back to the item_list, which is sorted by start_in_dw */
+	list_add(&item->link, compute_memory_postalloc_chunk(pool, start_in_dw));
 	item->start_in_dw = start_in_dw;
 
 	if (src) {
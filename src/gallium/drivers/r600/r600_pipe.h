@@ -239,11 +239,18 @@ struct r600_gs_rings_state {
 #define DBG_SB_DISASM	(1 << 27)
 #define DBG_SB_SAFEMATH	(1 << 28)
 
+struct disk_cache;
+
 struct r600_screen {
 	struct r600_common_screen	b;
 	bool				has_msaa;
 	bool				has_compressed_msaa_texturing;
 
+	/* Bytecode optimized by sb, keyed on the unoptimized bytecode. */
+	pipe_mutex			sb_cache_mutex;
+	struct hash_table		*sb_cache;
+	struct disk_cache		*disk_sb_cache;
+
 	/*for compute global memory binding, we allocate stuff here, instead of
 	 * buffers.
 	 * XXX: Not sure if this is the best place for global_pool.  Also,
@@ -632,6 +639,8 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 			    union r600_shader_key key);
 
 void r600_pipe_shader_destroy(struct pipe_context *ctx, struct r600_pipe_shader *shader);
+void r600_init_sb_cache(struct r600_screen *rscreen);
+void r600_destroy_sb_cache(struct r600_screen *rscreen);
 
 /* r600_state.c */
 struct pipe_sampler_view *
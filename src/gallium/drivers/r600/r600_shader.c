@@ -33,8 +33,13 @@
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_scan.h"
 #include "tgsi/tgsi_dump.h"
+#include "util/disk_cache.h"
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "os/os_time.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <errno.h>
 
@@ -154,6 +159,191 @@ static int store_shader(struct pipe_context *ctx,
 	return 0;
 }
 
+/* SB CACHE
+ *
+ * sb only looks at the bytecode and at a few fields of r600_shader, so its
+ * output is cached under a hash of those. An entry is a blob of dwords:
+ * its size in bytes, ngpr, nstack and the optimized bytecode.
+ */
+
+static bool r600_sb_cache_key(struct r600_screen *rscreen,
+			      struct r600_shader *shader, cache_key key)
+{
+	struct r600_bytecode *bc = &shader->bc;
+	struct mesa_sha1 *ctx = _mesa_sha1_init();
+	uint32_t header[] = {
+		rscreen->b.family,
+		rscreen->b.debug_flags,
+		rscreen->b.debug_flags >> 32,
+		shader->processor_type,
+		shader->vs_as_es,
+		shader->vs_as_ls,
+		shader->tes_as_es,
+		shader->indirect_files,
+		shader->num_arrays,
+		shader->ninput,
+		bc->type,
+		bc->ngpr,
+		bc->nstack,
+		bc->ndw,
+	};
+
+	if (!ctx)
+		return false;
+
+	_mesa_sha1_update(ctx, header, sizeof(header));
+	_mesa_sha1_update(ctx, shader->arrays,
+			  shader->num_arrays * sizeof(shader->arrays[0]));
+	_mesa_sha1_update(ctx, shader->input,
+			  shader->ninput * sizeof(shader->input[0]));
+	_mesa_sha1_update(ctx, bc->bytecode, bc->ndw * 4);
+	_mesa_sha1_final(ctx, key);
+	return true;
+}
+
+static void r600_sb_cache_read_blob(struct r600_bytecode *bc,
+				    const uint32_t *blob)
+{
+	free(bc->bytecode);
+	bc->ndw = (blob[0] - 12) / 4;
+	bc->bytecode = malloc(bc->ndw * 4);
+	memcpy(bc->bytecode, blob + 3, bc->ndw * 4);
+	bc->ngpr = blob[1];
+	bc->nstack = blob[2];
+}
+
+/* Add a blob to the in-memory cache, which takes ownership of it. */
+static void r600_sb_cache_add(struct r600_screen *rscreen,
+			      const cache_key key, uint32_t *blob)
+{
+	void *key_copy;
+
+	pipe_mutex_lock(rscreen->sb_cache_mutex);
+	if (_mesa_hash_table_search(rscreen->sb_cache, key)) {
+		/* Another context compiled the same shader meanwhile. */
+		pipe_mutex_unlock(rscreen->sb_cache_mutex);
+		free(blob);
+		return;
+	}
+
+	key_copy = malloc(CACHE_KEY_SIZE);
+	if (!key_copy ||
+	    !_mesa_hash_table_insert(rscreen->sb_cache, key_copy, blob)) {
+		free(key_copy);
+		free(blob);
+	} else {
+		memcpy(key_copy, key, CACHE_KEY_SIZE);
+	}
+	pipe_mutex_unlock(rscreen->sb_cache_mutex);
+}
+
+/**
+ * Look up the optimized bytecode in the in-memory cache, and then in the
+ * on-disk cache. On success, the bytecode of \p bc is replaced.
+ */
+static bool r600_sb_cache_load(struct r600_screen *rscreen,
+			       const cache_key key, struct r600_bytecode *bc)
+{
+	struct hash_entry *entry;
+	uint32_t *blob;
+	size_t size;
+
+	pipe_mutex_lock(rscreen->sb_cache_mutex);
+	entry = _mesa_hash_table_search(rscreen->sb_cache, key);
+	if (entry)
+		r600_sb_cache_read_blob(bc, entry->data);
+	pipe_mutex_unlock(rscreen->sb_cache_mutex);
+
+	if (entry)
+		return true;
+	if (!rscreen->disk_sb_cache)
+		return false;
+
+	blob = disk_cache_get(rscreen->disk_sb_cache, key, &size);
+	if (!blob)
+		return false;
+
+	if (size < 12 || size % 4 || blob[0] != size) {
+		/* Truncated or corrupted entry, don't try it again. */
+		disk_cache_remove(rscreen->disk_sb_cache, key);
+		free(blob);
+		return false;
+	}
+
+	r600_sb_cache_read_blob(bc, blob);
+	r600_sb_cache_add(rscreen, key, blob);
+	return true;
+}
+
+static void r600_sb_cache_store(struct r600_screen *rscreen,
+				const cache_key key, struct r600_bytecode *bc)
+{
+	unsigned size = 12 + bc->ndw * 4;
+	uint32_t *blob = malloc(size);
+
+	if (!blob)
+		return;
+
+	blob[0] = size;
+	blob[1] = bc->ngpr;
+	blob[2] = bc->nstack;
+	memcpy(blob + 3, bc->bytecode, bc->ndw * 4);
+
+	if (rscreen->disk_sb_cache)
+		disk_cache_put(rscreen->disk_sb_cache, key, blob, size);
+	r600_sb_cache_add(rscreen, key, blob);
+}
+
+static uint32_t r600_sb_cache_key_hash(const void *key)
+{
+	uint32_t hash;
+
+	/* The key is a SHA-1 already. */
+	memcpy(&hash, key, sizeof(hash));
+	return hash;
+}
+
+static bool r600_sb_cache_key_equals(const void *a, const void *b)
+{
+	return memcmp(a, b, CACHE_KEY_SIZE) == 0;
+}
+
+static void r600_destroy_sb_cache_entry(struct hash_entry *entry)
+{
+	free((void*)entry->key);
+	free(entry->data);
+}
+
+void r600_init_sb_cache(struct r600_screen *rscreen)
+{
+	char timestamp[32];
+
+	pipe_mutex_init(rscreen->sb_cache_mutex);
+	rscreen->sb_cache =
+		_mesa_hash_table_create(NULL,
+					r600_sb_cache_key_hash,
+					r600_sb_cache_key_equals);
+
+	if (!rscreen->sb_cache)
+		return;
+
+	/* The renderer string contains the chip and the DRM version. */
+	if (disk_cache_get_function_timestamp((void *)r600_init_sb_cache,
+					      timestamp, sizeof(timestamp)))
+		rscreen->disk_sb_cache =
+			disk_cache_create(rscreen->b.b.get_name(&rscreen->b.b),
+					  timestamp);
+}
+
+void r600_destroy_sb_cache(struct r600_screen *rscreen)
+{
+	if (rscreen->sb_cache)
+		_mesa_hash_table_destroy(rscreen->sb_cache,
+					 r600_destroy_sb_cache_entry);
+	disk_cache_destroy(rscreen->disk_sb_cache);
+	pipe_mutex_destroy(rscreen->sb_cache_mutex);
+}
+
 int r600_pipe_shader_create(struct pipe_context *ctx,
 			    struct r600_pipe_shader *shader,
 			    union r600_shader_key key)
@@ -166,6 +356,8 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 	unsigned use_sb = !(rctx->screen->b.debug_flags & DBG_NO_SB);
 	unsigned sb_disasm = use_sb || (rctx->screen->b.debug_flags & DBG_SB_DISASM);
 	unsigned export_shader;
+	cache_key sb_key;
+	int64_t start_time = os_time_get_nano();
 
 	shader->shader.bc.isa = rctx->isa;
 
@@ -207,11 +399,23 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 		r600_bytecode_disasm(&shader->shader.bc);
 		fprintf(stderr, "______________________________________________________________\n");
 	} else if ((dump && sb_disasm) || use_sb) {
-		r = r600_sb_bytecode_process(rctx, &shader->shader.bc, &shader->shader,
-		                             dump, use_sb);
-		if (r) {
-			R600_ERR("r600_sb_bytecode_process failed !\n");
-			goto error;
+		/* Dumping always goes through sb to print the disassembly. */
+		bool cacheable = use_sb && !dump && rctx->screen->sb_cache &&
+				 r600_sb_cache_key(rctx->screen, &shader->shader,
+						   sb_key);
+
+		if (!cacheable ||
+		    !r600_sb_cache_load(rctx->screen, sb_key, &shader->shader.bc)) {
+			r = r600_sb_bytecode_process(rctx, &shader->shader.bc,
+						     &shader->shader, dump, use_sb);
+			if (r) {
+				R600_ERR("r600_sb_bytecode_process failed !\n");
+				goto error;
+			}
+
+			if (cacheable)
+				r600_sb_cache_store(rctx->screen, sb_key,
+						    &shader->shader.bc);
 		}
 	}
 
@@ -232,6 +436,13 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 	if ((r = store_shader(ctx, shader)))
 		goto error;
 
+	pipe_debug_message(&rctx->b.debug, SHADER_INFO,
+			   "Shader Stats: type: %d GPRS: %d Stack: %d "
+			   "Code Size: %d bytes SB: %d Compile Time: %"PRId64" us",
+			   shader->shader.processor_type, shader->shader.bc.ngpr,
+			   shader->shader.bc.nstack, shader->shader.bc.ndw * 4,
+			   use_sb, (os_time_get_nano() - start_time) / 1000);
+
 	/* Build state. */
 	switch (shader->shader.processor_type) {
 	case PIPE_SHADER_TESS_CTRL:
@@ -159,7 +159,11 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 #define SB_RUN_PASS(n, dump) \
 	do { \
+		int64_t pass_start = sb_context::dump_stat ? os_time_get_nano() : 0; \
 		r = n(*sh).run(); \
+		SB_DUMP_STAT( sblog << "sb: " << #n << " pass: " \
+				<< ((double)(os_time_get_nano() - pass_start))/1000000.0 \
+				<< " ms\n"; ); \
 		if (r) { \
 			sblog << "sb: error (" << r << ") in the " << #n << " pass.\n"; \
 			if (sb_context::no_fallback) \
@@ -317,15 +317,13 @@ void gcm::bu_sched_bb(bb_node* bb) {
 		pending_defs.clear();
 	}
 
-	for (sched_queue::iterator N, I = ready_above.begin(), E = ready_above.end();
-			I != E;	I = N) {
-		N = I;
-		++N;
-		node *n = *I;
-		if (op_map[n].bottom_bb == bb) {
+	bb_queue_map::iterator A = ready_above.find(bb);
+	if (A != ready_above.end()) {
+		for (sq_iterator I = A->second.begin(), E = A->second.end(); I != E;
+				++I) {
 			add_ready(*I);
-			ready_above.erase(I);
 		}
+		ready_above.erase(A);
 	}
 
 	unsigned cnt_ready[SQ_NUM];
@@ -644,7 +642,7 @@ void gcm::bu_release_op(node * n) {
 		add_ready(n);
 	} else {
 		GCM_DUMP( sblog << "   ready_above\n";);
-		ready_above.push_back(n);
+		ready_above[oi.bottom_bb].push_back(n);
 	}
 }
 
@@ -29,7 +29,9 @@
 
 namespace r600_sb {
 
-typedef sb_map<node*, unsigned> uc_map;
+// sb_map inserts into a sorted vector, which is quadratic when filling the
+// map for large ALU blocks
+typedef std::map<node*, unsigned> uc_map;
 
 // resource trackers for scheduler
 // rp = read port
@@ -174,6 +174,13 @@ bool r600_init_resource(struct r600_common_screen *rscreen,
 	if (rscreen->debug_flags & DBG_NO_WC)
 		flags &= ~RADEON_FLAG_GTT_WC;
 
+	/* Textures and shareable buffers are not suballocated, because
+	 * their metadata and handles are per kernel buffer object.
+	 */
+	if (res->b.b.target != PIPE_BUFFER ||
+	    res->b.b.bind & (PIPE_BIND_SHARED | PIPE_BIND_SCANOUT))
+		flags |= RADEON_FLAG_HANDLE;
+
 	/* Allocate a new resource. */
 	new_buf = rscreen->ws->buffer_create(rscreen->ws, size, alignment,
 					     res->domains, flags);
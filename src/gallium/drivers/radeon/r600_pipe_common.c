@@ -401,6 +401,7 @@ static const struct debug_named_value common_debug_options[] = {
 	{ "sisched", DBG_SI_SCHED, "Enable LLVM SI Machine Instruction Scheduler." },
 	{ "mono", DBG_MONOLITHIC_SHADERS, "Use old-style monolithic shaders compiled on demand" },
 	{ "noce", DBG_NO_CE, "Disable the constant engine"},
+	{ "asyncmono", DBG_ASYNC_MONOLITHIC, "Compile monolithic shader variants in the background and use separate shader parts until they are ready" },
 
 	DEBUG_NAMED_VALUE_END /* must be last */
 };
@@ -230,12 +230,50 @@ void rvce_frame_offset(struct rvce_encoder *enc, struct rvce_cpb_slot *slot,
 	*chroma_offset = *luma_offset + pitch * vpitch;
 }
 
+/**
+ * get a feedback buffer, reusing one of the already returned ones if possible
+ */
+static struct rvid_buffer *get_feedback_buffer(struct rvce_encoder *enc)
+{
+	struct rvid_buffer *fb;
+
+	if (enc->num_free_fb)
+		return enc->free_fb[--enc->num_free_fb];
+
+	fb = CALLOC_STRUCT(rvid_buffer);
+	if (!fb)
+		return NULL;
+
+	if (!rvid_create_buffer(enc->screen, fb, 512, PIPE_USAGE_STAGING)) {
+		FREE(fb);
+		return NULL;
+	}
+	return fb;
+}
+
+/**
+ * keep a feedback buffer around for the next frames, the hardware
+ * overwrites it in submission order so it can be reused right away
+ */
+static void put_feedback_buffer(struct rvce_encoder *enc,
+				struct rvid_buffer *fb)
+{
+	if (enc->num_free_fb < RVCE_MAX_FREE_FEEDBACK_NUM) {
+		enc->free_fb[enc->num_free_fb++] = fb;
+		return;
+	}
+
+	rvid_destroy_buffer(fb);
+	FREE(fb);
+}
+
 /**
  * destroy this video encoder
  */
 static void rvce_destroy(struct pipe_video_codec *encoder)
 {
 	struct rvce_encoder *enc = (struct rvce_encoder*)encoder;
+	unsigned i;
 	if (enc->stream_handle) {
 		struct rvid_buffer fb;
 		rvid_create_buffer(enc->screen, &fb, 512, PIPE_USAGE_STAGING);
@@ -246,6 +284,10 @@ static void rvce_destroy(struct pipe_video_codec *encoder)
 		flush(enc);
 		rvid_destroy_buffer(&fb);
 	}
+	for (i = 0; i < enc->num_free_fb; ++i) {
+		rvid_destroy_buffer(enc->free_fb[i]);
+		FREE(enc->free_fb[i]);
+	}
 	rvid_destroy_buffer(&enc->cpb);
 	enc->ws->cs_destroy(enc->cs);
 	FREE(enc->cpb_array);
@@ -308,8 +350,8 @@ static void rvce_encode_bitstream(struct pipe_video_codec *encoder,
 	enc->get_buffer(destination, &enc->bs_handle, NULL);
 	enc->bs_size = destination->width0;
 
-	*fb = enc->fb = CALLOC_STRUCT(rvid_buffer);
-	if (!rvid_create_buffer(enc->screen, enc->fb, 512, PIPE_USAGE_STAGING)) {
+	*fb = enc->fb = get_feedback_buffer(enc);
+	if (!enc->fb) {
 		RVID_ERR("Can't create feedback buffer.\n");
 		return;
 	}
@@ -358,8 +400,7 @@ static void rvce_get_feedback(struct pipe_video_codec *encoder,
 		enc->ws->buffer_unmap(fb->res->buf);
 	}
 	//dump_feedback(enc, fb);
-	rvid_destroy_buffer(fb);
-	FREE(fb);
+	put_feedback_buffer(enc, fb);
 }
 
 /**
@@ -45,6 +45,7 @@
 
 #define RVCE_MAX_BITSTREAM_OUTPUT_ROW_SIZE (4096 * 16 * 2.5)
 #define RVCE_MAX_AUX_BUFFER_NUM 4
+#define RVCE_MAX_FREE_FEEDBACK_NUM 8
 
 struct r600_common_screen;
 
@@ -105,6 +106,11 @@ struct rvce_encoder {
 
 	struct rvid_buffer		*fb;
 	struct rvid_buffer		cpb;
+
+	/* feedback buffers returned by get_feedback, ready for reuse */
+	struct rvid_buffer		*free_fb[RVCE_MAX_FREE_FEEDBACK_NUM];
+	unsigned			num_free_fb;
+
 	struct pipe_h264_enc_picture_desc pic;
 
 	unsigned			task_info_idx;
@@ -129,6 +129,14 @@ static void si_init_descriptors(struct si_descriptors *desc,
 	}
 }
 
+static void si_mark_descriptors_dirty(struct si_context *sctx,
+				      struct si_descriptors *desc,
+				      unsigned mask)
+{
+	desc->dirty_mask |= mask;
+	sctx->descriptors_dirty |= desc->dirty_bit;
+}
+
 static void si_release_descriptors(struct si_descriptors *desc)
 {
 	pipe_resource_reference((struct pipe_resource**)&desc->buffer, NULL);
@@ -162,7 +170,11 @@ static bool si_ce_upload(struct si_context *sctx, unsigned ce_offset, unsigned s
 static void si_reinitialize_ce_ram(struct si_context *sctx,
                             struct si_descriptors *desc)
 {
-	if (desc->buffer) {
+	if (sctx->screen->b.info.drm_major == 2) {
+		/* CE RAM loads aren't enabled with the radeon kernel driver,
+		 * rewrite the whole list instead. */
+		desc->dirty_mask = u_bit_consecutive(0, desc->num_elements);
+	} else if (desc->buffer) {
 		struct r600_resource *buffer = (struct r600_resource*)desc->buffer;
 		unsigned list_size = desc->num_elements * desc->element_dw_size * 4;
 		uint64_t va = buffer->gpu_address + desc->buffer_offset;
@@ -340,7 +352,7 @@ static void si_set_sampler_view(struct si_context *sctx,
 		views->desc.enabled_mask &= ~(1u << slot);
 	}
 
-	views->desc.dirty_mask |= 1u << slot;
+	si_mark_descriptors_dirty(sctx, &views->desc, 1u << slot);
 }
 
 static bool is_compressed_colortex(struct r600_texture *rtex)
@@ -458,7 +470,8 @@ si_image_views_begin_new_cs(struct si_context *sctx, struct si_images_info *imag
 }
 
 static void
-si_disable_shader_image(struct si_images_info *images, unsigned slot)
+si_disable_shader_image(struct si_context *sctx, struct si_images_info *images,
+			unsigned slot)
 {
 	if (images->desc.enabled_mask & (1u << slot)) {
 		pipe_resource_reference(&images->views[slot].resource, NULL);
@@ -466,7 +479,7 @@ si_disable_shader_image(struct si_images_info *images, unsigned slot)
 
 		memcpy(images->desc.list + slot*8, null_image_descriptor, 8*4);
 		images->desc.enabled_mask &= ~(1u << slot);
-		images->desc.dirty_mask |= 1u << slot;
+		si_mark_descriptors_dirty(sctx, &images->desc, 1u << slot);
 	}
 }
 
@@ -491,7 +504,7 @@ si_set_shader_images(struct pipe_context *pipe, unsigned shader,
 		struct r600_resource *res;
 
 		if (!views || !views[i].resource) {
-			si_disable_shader_image(images, slot);
+			si_disable_shader_image(ctx, images, slot);
 			continue;
 		}
 
@@ -548,7 +561,7 @@ si_set_shader_images(struct pipe_context *pipe, unsigned shader,
 		}
 
 		images->desc.enabled_mask |= 1u << slot;
-		images->desc.dirty_mask |= 1u << slot;
+		si_mark_descriptors_dirty(ctx, &images->desc, 1u << slot);
 	}
 }
 
@@ -606,7 +619,7 @@ static void si_bind_sampler_states(struct pipe_context *ctx, unsigned shader,
 			continue;
 
 		memcpy(desc->list + slot * 16 + 12, sstates[i]->val, 4*4);
-		desc->dirty_mask |= 1u << slot;
+		si_mark_descriptors_dirty(sctx, desc, 1u << slot);
 	}
 }
 
@@ -846,7 +859,7 @@ void si_set_constant_buffer(struct si_context *sctx,
 		buffers->desc.enabled_mask &= ~(1u << slot);
 	}
 
-	buffers->desc.dirty_mask |= 1u << slot;
+	si_mark_descriptors_dirty(sctx, &buffers->desc, 1u << slot);
 }
 
 static void si_pipe_set_constant_buffer(struct pipe_context *ctx,
@@ -905,7 +918,7 @@ static void si_set_shader_buffers(struct pipe_context *ctx, unsigned shader,
 		radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx, buf,
 				      buffers->shader_usage, buffers->priority);
 		buffers->desc.enabled_mask |= 1u << slot;
-		buffers->desc.dirty_mask |= 1u << slot;
+		si_mark_descriptors_dirty(sctx, &buffers->desc, 1u << slot);
 	}
 }
 
@@ -998,7 +1011,7 @@ void si_set_ring_buffer(struct pipe_context *ctx, uint slot,
 		buffers->desc.enabled_mask &= ~(1u << slot);
 	}
 
-	buffers->desc.dirty_mask |= 1u << slot;
+	si_mark_descriptors_dirty(sctx, &buffers->desc, 1u << slot);
 }
 
 /* STREAMOUT BUFFERS */
@@ -1097,7 +1110,7 @@ static void si_set_streamout_targets(struct pipe_context *ctx,
 						NULL);
 			buffers->desc.enabled_mask &= ~(1u << bufidx);
 		}
-		buffers->desc.dirty_mask |= 1u << bufidx;
+		si_mark_descriptors_dirty(sctx, &buffers->desc, 1u << bufidx);
 	}
 	for (; i < old_num_targets; i++) {
 		bufidx = SI_VS_STREAMOUT_BUF0 + i;
@@ -1105,7 +1118,7 @@ static void si_set_streamout_targets(struct pipe_context *ctx,
 		memset(buffers->desc.list + bufidx*4, 0, sizeof(uint32_t) * 4);
 		pipe_resource_reference(&buffers->buffers[bufidx], NULL);
 		buffers->desc.enabled_mask &= ~(1u << bufidx);
-		buffers->desc.dirty_mask |= 1u << bufidx;
+		si_mark_descriptors_dirty(sctx, &buffers->desc, 1u << bufidx);
 	}
 }
 
@@ -1178,7 +1191,7 @@ static void si_reset_buffer_resources(struct si_context *sctx,
 			si_desc_reset_buffer_offset(&sctx->b.b,
 						    buffers->desc.list + i*4,
 						    old_va, buf);
-			buffers->desc.dirty_mask |= 1u << i;
+			si_mark_descriptors_dirty(sctx, &buffers->desc, 1u << i);
 
 			radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
 						(struct r600_resource *)buf,
@@ -1239,7 +1252,7 @@ static void si_invalidate_buffer(struct pipe_context *ctx, struct pipe_resource
 
 		si_desc_reset_buffer_offset(ctx, buffers->desc.list + i*4,
 					    old_va, buf);
-		buffers->desc.dirty_mask |= 1u << i;
+		si_mark_descriptors_dirty(sctx, &buffers->desc, 1u << i);
 
 		radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
 					  rbuffer, buffers->shader_usage,
@@ -1279,7 +1292,8 @@ static void si_invalidate_buffer(struct pipe_context *ctx, struct pipe_resource
 							    views->desc.list +
 							    i * 16 + 4,
 							    old_va, buf);
-				views->desc.dirty_mask |= 1u << i;
+				si_mark_descriptors_dirty(sctx, &views->desc,
+							  1u << i);
 
 				radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
 						      rbuffer, RADEON_USAGE_READ,
@@ -1300,7 +1314,8 @@ static void si_invalidate_buffer(struct pipe_context *ctx, struct pipe_resource
 				si_desc_reset_buffer_offset(
 					ctx, images->desc.list + i * 8 + 4,
 					old_va, buf);
-				images->desc.dirty_mask |= 1u << i;
+				si_mark_descriptors_dirty(sctx, &images->desc,
+							  1u << i);
 
 				radeon_add_to_buffer_list(
 					&sctx->b, &sctx->b.gfx, rbuffer,
@@ -1489,6 +1504,23 @@ void si_init_all_descriptors(struct si_context *sctx)
 
 	assert(ce_offset <= 32768);
 
+	for (i = 0; i < SI_NUM_SHADERS; i++) {
+		sctx->descriptors[si_shader_descs_index(i, SI_SHADER_DESCS_CONST_BUFFERS)] =
+			&sctx->const_buffers[i].desc;
+		sctx->descriptors[si_shader_descs_index(i, SI_SHADER_DESCS_SHADER_BUFFERS)] =
+			&sctx->shader_buffers[i].desc;
+		sctx->descriptors[si_shader_descs_index(i, SI_SHADER_DESCS_SAMPLERS)] =
+			&sctx->samplers[i].views.desc;
+		sctx->descriptors[si_shader_descs_index(i, SI_SHADER_DESCS_IMAGES)] =
+			&sctx->images[i].desc;
+	}
+	sctx->descriptors[SI_DESCS_RW_BUFFERS] = &sctx->rw_buffers.desc;
+
+	/* All lists start out with all elements dirty. */
+	for (i = 0; i < SI_NUM_DESCS; i++)
+		sctx->descriptors[i]->dirty_bit = 1u << i;
+	sctx->descriptors_dirty = u_bit_consecutive(0, SI_NUM_DESCS);
+
 	/* Set pipe_context functions. */
 	sctx->b.b.bind_sampler_states = si_bind_sampler_states;
 	sctx->b.b.set_shader_images = si_set_shader_images;
@@ -1510,23 +1542,32 @@ void si_init_all_descriptors(struct si_context *sctx)
 	si_set_user_data_base(sctx, PIPE_SHADER_FRAGMENT, R_00B030_SPI_SHADER_USER_DATA_PS_0);
 }
 
-bool si_upload_graphics_shader_descriptors(struct si_context *sctx)
+/* Upload the dirty descriptor lists among the ones in the mask. */
+static bool si_upload_dirty_descriptors(struct si_context *sctx,
+					unsigned mask,
+					struct r600_atom *atom)
 {
-	int i;
+	unsigned dirty = sctx->descriptors_dirty & mask;
 
-	for (i = 0; i < SI_NUM_SHADERS; i++) {
-		if (!si_upload_descriptors(sctx, &sctx->const_buffers[i].desc,
-		                           &sctx->shader_userdata.atom) ||
-		    !si_upload_descriptors(sctx, &sctx->shader_buffers[i].desc,
-		                           &sctx->shader_userdata.atom) ||
-		    !si_upload_descriptors(sctx, &sctx->samplers[i].views.desc,
-		                           &sctx->shader_userdata.atom) ||
-		    !si_upload_descriptors(sctx, &sctx->images[i].desc,
-		                           &sctx->shader_userdata.atom))
+	while (dirty) {
+		unsigned i = u_bit_scan(&dirty);
+
+		if (!si_upload_descriptors(sctx, sctx->descriptors[i], atom))
 			return false;
+
+		sctx->descriptors_dirty &= ~(1u << i);
 	}
-	return si_upload_descriptors(sctx, &sctx->rw_buffers.desc,
-				     &sctx->shader_userdata.atom) &&
+	return true;
+}
+
+bool si_upload_graphics_shader_descriptors(struct si_context *sctx)
+{
+	const unsigned mask =
+		u_bit_consecutive(0, SI_NUM_GRAPHICS_SHADERS * SI_NUM_SHADER_DESCS) |
+		(1u << SI_DESCS_RW_BUFFERS);
+
+	return si_upload_dirty_descriptors(sctx, mask,
+					   &sctx->shader_userdata.atom) &&
 	       si_upload_vertex_buffer_descriptors(sctx);
 }
 
@@ -1535,14 +1576,11 @@ bool si_upload_compute_shader_descriptors(struct si_context *sctx)
 	/* Does not update rw_buffers as that is not needed for compute shaders
 	 * and the input buffer is using the same SGPR's anyway.
 	 */
-	return si_upload_descriptors(sctx,
-	                &sctx->const_buffers[PIPE_SHADER_COMPUTE].desc, NULL) &&
-	       si_upload_descriptors(sctx,
-	               &sctx->shader_buffers[PIPE_SHADER_COMPUTE].desc, NULL) &&
-	       si_upload_descriptors(sctx,
-	               &sctx->samplers[PIPE_SHADER_COMPUTE].views.desc, NULL) &&
-	       si_upload_descriptors(sctx,
-	               &sctx->images[PIPE_SHADER_COMPUTE].desc,  NULL);
+	const unsigned mask =
+		u_bit_consecutive(si_shader_descs_index(PIPE_SHADER_COMPUTE, 0),
+				  SI_NUM_SHADER_DESCS);
+
+	return si_upload_dirty_descriptors(sctx, mask, NULL);
 }
 
 void si_release_all_descriptors(struct si_context *sctx)
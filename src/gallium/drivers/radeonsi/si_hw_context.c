@@ -202,9 +202,11 @@ void si_begin_new_cs(struct si_context *ctx)
 	if (ctx->init_config_gs_rings)
 		si_pm4_emit(ctx, ctx->init_config_gs_rings);
 
+	/* The radeon kernel driver doesn't allow CONTEXT_CONTROL in the CE IB,
+	 * see si_reinitialize_ce_ram. */
 	if (ctx->ce_preamble_ib)
 		si_ce_enable_loads(ctx->ce_preamble_ib);
-	else if (ctx->ce_ib)
+	else if (ctx->ce_ib && ctx->screen->b.info.drm_major == 3)
 		si_ce_enable_loads(ctx->ce_ib);
 
 	ctx->framebuffer.dirty_cbufs = (1 << 8) - 1;
@@ -27,6 +27,7 @@
 #define SI_PIPE_H
 
 #include "si_state.h"
+#include "util/u_queue.h"
 
 #include <llvm-c/TargetMachine.h>
 
@@ -76,6 +77,7 @@
 #define SI_MAX_BORDER_COLORS	4096
 
 struct si_compute;
+struct disk_cache;
 struct hash_table;
 struct u_suballocator;
 
@@ -86,6 +88,15 @@ struct si_screen {
 	/* Whether shaders are monolithic (1-part) or separate (3-part). */
 	bool				use_monolithic_shaders;
 
+	/* Whether variants are drawn with prologs/epilogs until the
+	 * monolithic variant has been compiled in the background.
+	 */
+	bool				async_monolithic_variants;
+
+	/* Shader compiler queue for multithreaded compilation. */
+	struct util_queue		shader_compiler_queue;
+	LLVMTargetMachineRef		tm[4]; /* used by the queue only */
+
 	pipe_mutex			shader_parts_mutex;
 	struct si_shader_part		*vs_prologs;
 	struct si_shader_part		*vs_epilogs;
@@ -93,11 +104,13 @@ struct si_screen {
 	struct si_shader_part		*ps_prologs;
 	struct si_shader_part		*ps_epilogs;
 
-	/* Shader cache in memory.
+	/* Shader cache in memory, backed by the on-disk cache.
 	 *
 	 * Design & limitations:
-	 * - The shader cache is per screen (= per process), never saved to
-	 *   disk, and skips redundant shader compilations from TGSI to bytecode.
+	 * - The in-memory shader cache is per screen (= per process) and skips
+	 *   redundant shader compilations from TGSI to bytecode. Binaries are
+	 *   also stored in the on-disk cache (if enabled), which is looked up
+	 *   on an in-memory miss before compiling.
 	 * - It can only be used with one-variant-per-shader support, in which
 	 *   case only the main (typically middle) part of shaders is cached.
 	 * - Only VS, TCS, TES, PS are cached, out of which only the hw VS
@@ -107,6 +120,7 @@ struct si_screen {
 	 */
 	pipe_mutex			shader_cache_mutex;
 	struct hash_table		*shader_cache;
+	struct disk_cache		*disk_shader_cache;
 };
 
 struct si_blend_color {
@@ -208,6 +222,7 @@ struct si_context {
 	/* PM4 states (precomputed immutable states) */
 	union si_state			queued;
 	union si_state			emitted;
+	unsigned			dirty_states; /* mask of queued states */
 
 	/* Atom declarations. */
 	struct r600_atom		cache_flush;
@@ -250,6 +265,10 @@ struct si_context {
 	struct si_buffer_resources	shader_buffers[SI_NUM_SHADERS];
 	struct si_textures_info		samplers[SI_NUM_SHADERS];
 	struct si_images_info		images[SI_NUM_SHADERS];
+	/* All lists above but vertex_buffers, and the ones with dirty
+	 * elements, so that draws only look at the lists which changed. */
+	struct si_descriptors		*descriptors[SI_NUM_DESCS];
+	unsigned			descriptors_dirty;
 
 	/* other shader resources */
 	struct pipe_constant_buffer	null_const_buf; /* used for set_constant_buffer(NULL) on CIK */
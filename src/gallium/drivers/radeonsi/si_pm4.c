@@ -152,7 +152,10 @@ void si_pm4_emit(struct si_context *sctx, struct si_pm4_state *state)
 
 void si_pm4_emit_dirty(struct si_context *sctx)
 {
-	for (int i = 0; i < NUMBER_OF_STATES; ++i) {
+	unsigned mask = sctx->dirty_states;
+
+	while (mask) {
+		unsigned i = u_bit_scan(&mask);
 		struct si_pm4_state *state = sctx->queued.array[i];
 
 		if (!state || sctx->emitted.array[i] == state)
@@ -161,11 +164,13 @@ void si_pm4_emit_dirty(struct si_context *sctx)
 		si_pm4_emit(sctx, state);
 		sctx->emitted.array[i] = state;
 	}
+	sctx->dirty_states = 0;
 }
 
 void si_pm4_reset_emitted(struct si_context *sctx)
 {
 	memset(&sctx->emitted, 0, sizeof(sctx->emitted));
+	sctx->dirty_states = u_bit_consecutive(0, NUMBER_OF_STATES);
 }
 
 void si_pm4_upload_indirect_buffer(struct si_context *sctx,
@@ -70,6 +70,7 @@
 
 #include <llvm-c/Core.h> /* LLVMModuleRef */
 #include "tgsi/tgsi_scan.h"
+#include "util/u_queue.h"
 #include "si_state.h"
 
 struct radeon_shader_binary;
@@ -222,6 +223,13 @@ struct si_shader;
  * binaries for one TGSI program. This can be shared by multiple contexts.
  */
 struct si_shader_selector {
+	struct si_screen	*screen;
+	struct util_queue_fence ready;
+
+	/* Used by the synchronous path of si_init_shader_selector_async. */
+	LLVMTargetMachineRef	tm;
+	struct pipe_debug_callback debug;
+
 	pipe_mutex		mutex;
 	struct si_shader	*first_variant; /* immutable after the first variant */
 	struct si_shader	*last_variant; /* mutable */
@@ -411,8 +419,16 @@ struct si_shader {
 	struct r600_resource		*scratch_bo;
 	union si_shader_key		key;
 	bool				is_binary_shared;
+	bool				is_monolithic;
 	unsigned			z_order;
 
+	/* A monolithic variant with the same key, compiled in the background
+	 * and used instead of this one once "ready" is signalled.
+	 */
+	struct si_shader		*optimized;
+	struct util_queue_fence		ready;
+	bool				compilation_failed;
+
 	/* The following data is all that's needed for binary shaders. */
 	struct radeon_shader_binary	binary;
 	struct si_shader_config		config;
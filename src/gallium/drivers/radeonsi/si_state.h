@@ -40,6 +40,23 @@
 #define SI_NUM_IMAGES			16
 #define SI_NUM_SHADER_BUFFERS		16
 
+/* The descriptor lists of each shader stage, followed by the RW buffers.
+ * This is the bit order of si_context::descriptors_dirty.
+ */
+enum {
+	SI_SHADER_DESCS_CONST_BUFFERS,
+	SI_SHADER_DESCS_SHADER_BUFFERS,
+	SI_SHADER_DESCS_SAMPLERS,
+	SI_SHADER_DESCS_IMAGES,
+	SI_NUM_SHADER_DESCS,
+};
+
+#define SI_DESCS_RW_BUFFERS		(SI_NUM_SHADERS * SI_NUM_SHADER_DESCS)
+#define SI_NUM_DESCS			(SI_DESCS_RW_BUFFERS + 1)
+
+#define si_shader_descs_index(shader, type) \
+	((shader) * SI_NUM_SHADER_DESCS + (type))
+
 struct si_screen;
 struct si_shader;
 
@@ -201,6 +218,8 @@ struct si_descriptors {
 
 	/* elements of the list that are changed and need to be uploaded */
 	unsigned dirty_mask;
+	/* The bit of this list in si_context::descriptors_dirty. */
+	unsigned dirty_bit;
 
 	/* Whether the CE ram is dirty and needs to be reinitialized entirely
 	 * before we can do partial updates. */
@@ -235,6 +254,7 @@ struct si_buffer_resources {
 #define si_pm4_bind_state(sctx, member, value) \
 	do { \
 		(sctx)->queued.named.member = (value); \
+		(sctx)->dirty_states |= 1u << si_pm4_block_idx(member); \
 	} while(0)
 
 #define si_pm4_delete_state(sctx, member, value) \
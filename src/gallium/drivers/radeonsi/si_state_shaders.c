@@ -32,7 +32,9 @@
 
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_ureg.h"
+#include "util/disk_cache.h"
 #include "util/hash_table.h"
+#include "util/mesa-sha1.h"
 #include "util/u_hash.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
@@ -168,17 +170,48 @@ static bool si_load_shader_binary(struct si_shader *shader, void *binary)
 }
 
 /**
- * Insert a shader into the cache. It's assumed the shader is not in the cache.
- * Use si_shader_cache_load_shader before calling this.
+ * Return the key of a TGSI binary in the on-disk shader cache.
+ *
+ * Debug flags that change the generated code are part of the key; the GPU,
+ * LLVM version and driver build are covered by the cache directory.
+ */
+static void si_shader_cache_disk_key(struct si_screen *sscreen,
+				     void *tgsi_binary, cache_key key)
+{
+	struct mesa_sha1 *ctx = _mesa_sha1_init();
+	uint64_t flags = sscreen->b.debug_flags & DBG_SI_SCHED;
+
+	if (!ctx) {
+		memset(key, 0, CACHE_KEY_SIZE);
+		return;
+	}
+
+	_mesa_sha1_update(ctx, &flags, sizeof(flags));
+	_mesa_sha1_update(ctx, tgsi_binary, *(uint32_t*)tgsi_binary);
+	_mesa_sha1_final(ctx, key);
+}
+
+/**
+ * Insert a shader into the cache. Use si_shader_cache_load_shader before
+ * calling this. Since shaders are compiled without holding the cache lock,
+ * another thread may have inserted the same shader in the meantime.
+ *
+ * If insert_into_disk_cache is true, the binary is also written to the
+ * on-disk cache, so that later processes can skip the compilation too.
  *
  * Returns false on failure, in which case the tgsi_binary should be freed.
  */
 static bool si_shader_cache_insert_shader(struct si_screen *sscreen,
 					  void *tgsi_binary,
-					  struct si_shader *shader)
+					  struct si_shader *shader,
+					  bool insert_into_disk_cache)
 {
-	void *hw_binary = si_get_shader_binary(shader);
+	void *hw_binary;
+
+	if (_mesa_hash_table_search(sscreen->shader_cache, tgsi_binary))
+		return false;
 
+	hw_binary = si_get_shader_binary(shader);
 	if (!hw_binary)
 		return false;
 
@@ -188,19 +221,60 @@ static bool si_shader_cache_insert_shader(struct si_screen *sscreen,
 		return false;
 	}
 
+	if (sscreen->disk_shader_cache && insert_into_disk_cache) {
+		cache_key key;
+
+		si_shader_cache_disk_key(sscreen, tgsi_binary, key);
+		disk_cache_put(sscreen->disk_shader_cache, key, hw_binary,
+			       *((uint32_t *)hw_binary));
+	}
+
 	return true;
 }
 
+/**
+ * Look up a shader in the in-memory cache, and then in the on-disk cache.
+ *
+ * On success, this takes ownership of tgsi_binary.
+ */
 static bool si_shader_cache_load_shader(struct si_screen *sscreen,
 					void *tgsi_binary,
 				        struct si_shader *shader)
 {
 	struct hash_entry *entry =
 		_mesa_hash_table_search(sscreen->shader_cache, tgsi_binary);
-	if (!entry)
+	cache_key key;
+	void *buffer;
+	size_t size;
+
+	if (entry) {
+		if (!si_load_shader_binary(shader, entry->data))
+			return false;
+		FREE(tgsi_binary);
+		return true;
+	}
+
+	if (!sscreen->disk_shader_cache)
 		return false;
 
-	return si_load_shader_binary(shader, entry->data);
+	si_shader_cache_disk_key(sscreen, tgsi_binary, key);
+	buffer = disk_cache_get(sscreen->disk_shader_cache, key, &size);
+	if (!buffer)
+		return false;
+
+	if (size < 8 || *((uint32_t *)buffer) != size ||
+	    !si_load_shader_binary(shader, buffer)) {
+		/* Truncated or corrupted entry, don't try it again. */
+		disk_cache_remove(sscreen->disk_shader_cache, key);
+		free(buffer);
+		return false;
+	}
+	free(buffer);
+
+	/* Keep it in memory for later lookups. */
+	if (!si_shader_cache_insert_shader(sscreen, tgsi_binary, shader, false))
+		FREE(tgsi_binary);
+	return true;
 }
 
 static uint32_t si_shader_cache_key_hash(const void *key)
@@ -229,11 +303,21 @@ static void si_destroy_shader_cache_entry(struct hash_entry *entry)
 
 bool si_init_shader_cache(struct si_screen *sscreen)
 {
+	char timestamp[32];
+
 	pipe_mutex_init(sscreen->shader_cache_mutex);
 	sscreen->shader_cache =
 		_mesa_hash_table_create(NULL,
 					si_shader_cache_key_hash,
 					si_shader_cache_key_equals);
+
+	/* The renderer string contains the chip and the LLVM version. */
+	if (disk_cache_get_function_timestamp((void *)si_init_shader_cache,
+					      timestamp, sizeof(timestamp)))
+		sscreen->disk_shader_cache =
+			disk_cache_create(sscreen->b.b.get_name(&sscreen->b.b),
+					  timestamp);
+
 	return sscreen->shader_cache != NULL;
 }
 
@@ -242,6 +326,7 @@ void si_destroy_shader_cache(struct si_screen *sscreen)
 	if (sscreen->shader_cache)
 		_mesa_hash_table_destroy(sscreen->shader_cache,
 					 si_destroy_shader_cache_entry);
+	disk_cache_destroy(sscreen->disk_shader_cache);
 	pipe_mutex_destroy(sscreen->shader_cache_mutex);
 }
 
@@ -822,9 +907,8 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 			key->vs.as_ls = 1;
 		else if (sctx->gs_shader.cso)
 			key->vs.as_es = 1;
-
-		if (!sctx->gs_shader.cso && sctx->ps_shader.cso &&
-		    sctx->ps_shader.cso->info.uses_primid)
+		else if (sctx->ps_shader.cso &&
+			 sctx->ps_shader.cso->info.uses_primid)
 			key->vs.epilog.export_prim_id = 1;
 		break;
 	case PIPE_SHADER_TESS_CTRL:
@@ -915,6 +999,18 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 		}
 
 		key->ps.epilog.alpha_func = si_get_alpha_test_func(sctx);
+
+		/* The rest of the color state only affects the color outputs,
+		 * don't create variants for it if they aren't written.
+		 */
+		if (!(sel->info.colors_written & 0x1))
+			key->ps.epilog.alpha_func = PIPE_FUNC_ALWAYS;
+
+		if (!sel->info.colors_written) {
+			key->ps.epilog.alpha_to_one = 0;
+			key->ps.epilog.poly_line_smoothing = 0;
+			key->ps.epilog.clamp_color = 0;
+		}
 		break;
 	}
 	default:
@@ -922,12 +1018,45 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 	}
 }
 
+/* Compile a monolithic variant on a compiler thread. */
+static void si_build_monolithic_variant(void *job, int thread_index)
+{
+	struct si_shader *shader = (struct si_shader *)job;
+	struct si_screen *sscreen = shader->selector->screen;
+
+	assert(thread_index >= 0 && thread_index < ARRAY_SIZE(sscreen->tm));
+
+	if (si_shader_create(sscreen, sscreen->tm[thread_index], shader, NULL)) {
+		R600_ERR("Failed to build a monolithic shader variant (type=%u)\n",
+			 shader->selector->type);
+		shader->compilation_failed = true;
+		return;
+	}
+	si_shader_init_pm4_state(shader);
+}
+
+/* Return the monolithic replacement of a variant if it has been compiled,
+ * or the variant itself otherwise.
+ */
+static inline struct si_shader *si_get_ready_variant(struct si_shader *shader)
+{
+	struct si_shader *optimized = shader->optimized;
+
+	if (unlikely(optimized &&
+		     util_queue_fence_is_signalled(&optimized->ready) &&
+		     !optimized->compilation_failed))
+		return optimized;
+
+	return shader;
+}
+
 /* Select the hw shader variant depending on the current state. */
 static int si_shader_select_with_key(struct pipe_context *ctx,
 				     struct si_shader_ctx_state *state,
 				     union si_shader_key *key)
 {
 	struct si_context *sctx = (struct si_context *)ctx;
+	struct si_screen *sscreen = sctx->screen;
 	struct si_shader_selector *sel = state->cso;
 	struct si_shader *current = state->current;
 	struct si_shader *iter, *shader = NULL;
@@ -937,8 +1066,15 @@ static int si_shader_select_with_key(struct pipe_context *ctx,
 	 * This path is also used for most shaders that don't need multiple
 	 * variants, it will cost just a computation of the key and this
 	 * test. */
-	if (likely(current && memcmp(&current->key, key, sizeof(*key)) == 0))
+	if (likely(current && memcmp(&current->key, key, sizeof(*key)) == 0)) {
+		state->current = si_get_ready_variant(current);
 		return 0;
+	}
+
+	/* Wait for the main part and pre-compiled variants, which may still
+	 * be compiled by si_init_shader_selector_async.
+	 */
+	util_queue_job_wait(&sel->ready);
 
 	pipe_mutex_lock(sel->mutex);
 
@@ -947,7 +1083,7 @@ static int si_shader_select_with_key(struct pipe_context *ctx,
 		/* Don't check the "current" shader. We checked it above. */
 		if (current != iter &&
 		    memcmp(&iter->key, key, sizeof(*key)) == 0) {
-			state->current = iter;
+			state->current = si_get_ready_variant(iter);
 			pipe_mutex_unlock(sel->mutex);
 			return 0;
 		}
@@ -972,6 +1108,26 @@ static int si_shader_select_with_key(struct pipe_context *ctx,
 	}
 	si_shader_init_pm4_state(shader);
 
+	/* Use the variant built from prologs and epilogs right away and
+	 * compile the monolithic variant in the background.
+	 */
+	if (sscreen->async_monolithic_variants && shader->is_binary_shared &&
+	    util_queue_is_initialized(&sscreen->shader_compiler_queue)) {
+		struct si_shader *optimized = CALLOC_STRUCT(si_shader);
+
+		if (optimized) {
+			optimized->selector = sel;
+			optimized->key = *key;
+			optimized->is_monolithic = true;
+			util_queue_fence_init(&optimized->ready);
+			shader->optimized = optimized;
+
+			util_queue_add_job(&sscreen->shader_compiler_queue,
+					   optimized, &optimized->ready,
+					   si_build_monolithic_variant);
+		}
+	}
+
 	if (!sel->last_variant) {
 		sel->first_variant = shader;
 		sel->last_variant = shader;
@@ -1018,6 +1174,125 @@ static void si_parse_next_shader_property(const struct tgsi_shader_info *info,
 	}
 }
 
+/**
+ * Compile the main shader part and the pre-compiled variants as part of
+ * si_shader_selector initialization. Since it can be done asynchronously,
+ * there is no way to report compile failures to applications. If the main
+ * part fails to compile, variants are compiled as monolithic shaders.
+ *
+ * \param thread_index	index of the compiler thread, or -1 when called
+ *			from the application's thread
+ */
+static void si_init_shader_selector_async(void *job, int thread_index)
+{
+	struct si_shader_selector *sel = (struct si_shader_selector *)job;
+	struct si_screen *sscreen = sel->screen;
+	LLVMTargetMachineRef tm;
+	struct pipe_debug_callback *debug;
+	int i;
+
+	if (thread_index >= 0) {
+		assert(thread_index < ARRAY_SIZE(sscreen->tm));
+		tm = sscreen->tm[thread_index];
+		debug = NULL;
+	} else {
+		tm = sel->tm;
+		debug = &sel->debug;
+	}
+
+	/* Compile the main shader part for use with a prolog and/or epilog. */
+	if (sel->type != PIPE_SHADER_GEOMETRY &&
+	    !sscreen->use_monolithic_shaders) {
+		struct si_shader *shader = CALLOC_STRUCT(si_shader);
+		void *tgsi_binary;
+
+		if (!shader) {
+			fprintf(stderr, "radeonsi: can't allocate a main shader part\n");
+			return;
+		}
+
+		shader->selector = sel;
+		si_parse_next_shader_property(&sel->info, &shader->key);
+
+		tgsi_binary = si_get_tgsi_binary(sel);
+
+		/* Try to load the shader from the shader cache. On success,
+		 * the cache takes ownership of tgsi_binary. The lock isn't
+		 * held during compilation, so that other threads can use
+		 * the cache in the meantime.
+		 */
+		pipe_mutex_lock(sscreen->shader_cache_mutex);
+		if (tgsi_binary &&
+		    si_shader_cache_load_shader(sscreen, tgsi_binary, shader)) {
+			pipe_mutex_unlock(sscreen->shader_cache_mutex);
+		} else {
+			pipe_mutex_unlock(sscreen->shader_cache_mutex);
+
+			/* Compile the shader if it hasn't been loaded from the cache. */
+			if (si_compile_tgsi_shader(sscreen, tm, shader, false,
+						   debug) != 0) {
+				FREE(shader);
+				FREE(tgsi_binary);
+				fprintf(stderr, "radeonsi: can't compile a main shader part\n");
+				return;
+			}
+
+			if (tgsi_binary) {
+				pipe_mutex_lock(sscreen->shader_cache_mutex);
+				if (!si_shader_cache_insert_shader(sscreen, tgsi_binary,
+								   shader, true))
+					FREE(tgsi_binary);
+				pipe_mutex_unlock(sscreen->shader_cache_mutex);
+			}
+		}
+
+		sel->main_shader_part = shader;
+	}
+
+	/* Pre-compilation. */
+	if (sel->type == PIPE_SHADER_GEOMETRY ||
+	    sscreen->b.debug_flags & DBG_PRECOMPILE) {
+		struct si_shader *shader = CALLOC_STRUCT(si_shader);
+
+		if (!shader) {
+			fprintf(stderr, "radeonsi: can't allocate a shader\n");
+			return;
+		}
+
+		shader->selector = sel;
+		si_parse_next_shader_property(&sel->info, &shader->key);
+
+		/* Set reasonable defaults, so that the shader key doesn't
+		 * cause any code to be eliminated.
+		 */
+		switch (sel->type) {
+		case PIPE_SHADER_TESS_CTRL:
+			shader->key.tcs.epilog.prim_mode = PIPE_PRIM_TRIANGLES;
+			break;
+		case PIPE_SHADER_FRAGMENT:
+			shader->key.ps.epilog.alpha_func = PIPE_FUNC_ALWAYS;
+			for (i = 0; i < 8; i++)
+				if (sel->info.colors_written & (1 << i))
+					shader->key.ps.epilog.spi_shader_col_format |=
+						V_028710_SPI_SHADER_FP16_ABGR << (i * 4);
+			break;
+		}
+
+		if (si_shader_create(sscreen, tm, shader, debug)) {
+			fprintf(stderr, "radeonsi: can't create a shader\n");
+			FREE(shader);
+			return;
+		}
+		si_shader_init_pm4_state(shader);
+
+		/* Nothing else can access the selector before "ready" is
+		 * signalled, so the mutex isn't needed.
+		 */
+		sel->first_variant = shader;
+		sel->last_variant = shader;
+	}
+}
+
 static void *si_create_shader_selector(struct pipe_context *ctx,
 				       const struct pipe_shader_state *state)
 {
@@ -1029,6 +1304,7 @@ static void *si_create_shader_selector(struct pipe_context *ctx,
 	if (!sel)
 		return NULL;
 
+	sel->screen = sscreen;
 	sel->tokens = tgsi_dup_tokens(state->tokens);
 	if (!sel->tokens) {
 		FREE(sel);
@@ -1137,82 +1413,24 @@ static void *si_create_shader_selector(struct pipe_context *ctx,
 		sel->db_shader_control |= S_02880C_EXEC_ON_HIER_FAIL(1) |
 					  S_02880C_EXEC_ON_NOOP(1);
 
-	/* Compile the main shader part for use with a prolog and/or epilog. */
-	if (sel->type != PIPE_SHADER_GEOMETRY &&
-	    !sscreen->use_monolithic_shaders) {
-		struct si_shader *shader = CALLOC_STRUCT(si_shader);
-		void *tgsi_binary;
-
-		if (!shader)
-			goto error;
-
-		shader->selector = sel;
-		si_parse_next_shader_property(&sel->info, &shader->key);
-
-		tgsi_binary = si_get_tgsi_binary(sel);
-
-		/* Try to load the shader from the shader cache. */
-		pipe_mutex_lock(sscreen->shader_cache_mutex);
-
-		if (tgsi_binary &&
-		    si_shader_cache_load_shader(sscreen, tgsi_binary, shader)) {
-			FREE(tgsi_binary);
-		} else {
-			/* Compile the shader if it hasn't been loaded from the cache. */
-			if (si_compile_tgsi_shader(sscreen, sctx->tm, shader, false,
-						   &sctx->b.debug) != 0) {
-				FREE(shader);
-				FREE(tgsi_binary);
-				pipe_mutex_unlock(sscreen->shader_cache_mutex);
-				goto error;
-			}
-
-			if (tgsi_binary &&
-			    !si_shader_cache_insert_shader(sscreen, tgsi_binary, shader))
-				FREE(tgsi_binary);
-		}
-		pipe_mutex_unlock(sscreen->shader_cache_mutex);
-
-		sel->main_shader_part = shader;
-	}
-
-	/* Pre-compilation. */
-	if (sel->type == PIPE_SHADER_GEOMETRY ||
-	    sscreen->b.debug_flags & DBG_PRECOMPILE) {
-		struct si_shader_ctx_state state = {sel};
-		union si_shader_key key;
-
-		memset(&key, 0, sizeof(key));
-		si_parse_next_shader_property(&sel->info, &key);
-
-		/* Set reasonable defaults, so that the shader key doesn't
-		 * cause any code to be eliminated.
-		 */
-		switch (sel->type) {
-		case PIPE_SHADER_TESS_CTRL:
-			key.tcs.epilog.prim_mode = PIPE_PRIM_TRIANGLES;
-			break;
-		case PIPE_SHADER_FRAGMENT:
-			key.ps.epilog.alpha_func = PIPE_FUNC_ALWAYS;
-			for (i = 0; i < 8; i++)
-				if (sel->info.colors_written & (1 << i))
-					key.ps.epilog.spi_shader_col_format |=
-						V_028710_SPI_SHADER_FP16_ABGR << (i * 4);
-			break;
-		}
+	/* Compile the main part and pre-compiled variants in the compiler
+	 * queue if possible. Debug callbacks can only be invoked from the
+	 * application's thread, so compile synchronously when one is set.
+	 */
+	pipe_mutex_init(sel->mutex);
+	util_queue_fence_init(&sel->ready);
 
-		if (si_shader_select_with_key(ctx, &state, &key))
-			goto error;
+	if (sctx->b.debug.debug_message ||
+	    !util_queue_is_initialized(&sscreen->shader_compiler_queue)) {
+		sel->tm = sctx->tm;
+		sel->debug = sctx->b.debug;
+		si_init_shader_selector_async(sel, -1);
+	} else {
+		util_queue_add_job(&sscreen->shader_compiler_queue, sel,
+				   &sel->ready, si_init_shader_selector_async);
 	}
 
-	pipe_mutex_init(sel->mutex);
 	return sel;
-
-error:
-	fprintf(stderr, "radeonsi: can't create a shader\n");
-	tgsi_free_tokens(sel->tokens);
-	FREE(sel);
-	return NULL;
 }
 
 static void si_bind_vs_shader(struct pipe_context *ctx, void *state)
@@ -1301,6 +1519,12 @@ static void si_bind_ps_shader(struct pipe_context *ctx, void *state)
 
 static void si_delete_shader(struct si_context *sctx, struct si_shader *shader)
 {
+	if (shader->optimized) {
+		util_queue_job_wait(&shader->optimized->ready);
+		util_queue_fence_destroy(&shader->optimized->ready);
+		si_delete_shader(sctx, shader->optimized);
+	}
+
 	if (shader->pm4) {
 		switch (shader->selector->type) {
 		case PIPE_SHADER_VERTEX:
@@ -1347,6 +1571,8 @@ static void si_delete_shader_selector(struct pipe_context *ctx, void *state)
 		[PIPE_SHADER_FRAGMENT] = &sctx->ps_shader,
 	};
 
+	util_queue_job_wait(&sel->ready);
+
 	if (current_shader[sel->type]->cso == sel) {
 		current_shader[sel->type]->cso = NULL;
 		current_shader[sel->type]->current = NULL;
@@ -1361,6 +1587,7 @@ static void si_delete_shader_selector(struct pipe_context *ctx, void *state)
 	if (sel->main_shader_part)
 		si_delete_shader(sctx, sel->main_shader_part);
 
+	util_queue_fence_destroy(&sel->ready);
 	pipe_mutex_destroy(sel->mutex);
 	free(sel->tokens);
 	free(sel);
@@ -38,6 +38,7 @@
 static void
 cs_prepare(const struct sp_compute_shader *cs,
            struct tgsi_exec_machine *machine,
+           const struct tgsi_exec_machine *bound,
            int w, int h, int d,
            int g_w, int g_h, int g_d,
            int b_w, int b_h, int b_d,
@@ -48,10 +49,14 @@ cs_prepare(const struct sp_compute_shader *cs,
    int j;
    /*
     * Bind tokens/shader to the interpreter's machine state.
+    * All threads run the same shader, so only parse it once.
     */
-   tgsi_exec_machine_bind_shader(machine,
-                                 cs->tokens,
-                                 sampler, image, buffer);
+   if (bound)
+      tgsi_exec_machine_copy_shader(machine, bound);
+   else
+      tgsi_exec_machine_bind_shader(machine,
+                                    cs->tokens,
+                                    sampler, image, buffer);
 
    if (machine->SysSemanticToIndex[TGSI_SEMANTIC_THREAD_ID] != -1) {
       unsigned i = machine->SysSemanticToIndex[TGSI_SEMANTIC_THREAD_ID];
@@ -203,7 +208,7 @@ softpipe_launch_grid(struct pipe_context *context,
 
             machines[idx]->LocalMem = local_mem;
             machines[idx]->LocalMemSize = cs->shader.req_local_mem;
-            cs_prepare(cs, machines[idx],
+            cs_prepare(cs, machines[idx], idx ? machines[0] : NULL,
                        w, h, d,
                        grid_size[0], grid_size[1], grid_size[2],
                        bwidth, bheight, bdepth,
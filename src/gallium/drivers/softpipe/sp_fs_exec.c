@@ -68,7 +68,16 @@ exec_prepare( const struct sp_fragment_shader_variant *var,
 {
    /*
     * Bind tokens/shader to the interpreter's machine state.
+    * Avoid parsing the tokens again when the variant is still bound;
+    * exec_delete() unbinds it before the tokens are freed.
     */
+   if (machine->Tokens == var->tokens) {
+      machine->Sampler = sampler;
+      machine->Image = image;
+      machine->Buffer = buffer;
+      return;
+   }
+
    tgsi_exec_machine_bind_shader(machine,
                                  var->tokens,
                                  sampler, image, buffer);
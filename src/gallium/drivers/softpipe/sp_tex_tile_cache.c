@@ -55,10 +55,15 @@ sp_create_tex_tile_cache( struct pipe_context *pipe )
    tc = CALLOC_STRUCT( softpipe_tex_tile_cache );
    if (tc) {
       tc->pipe = pipe;
-      for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
-         tc->entries[pos].addr.bits.invalid = 1;
+      for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos += NUM_TEX_TILE_WAYS) {
+         tc->entries[pos] = MALLOC_STRUCT(softpipe_tex_cached_tile);
+         if (!tc->entries[pos]) {
+            sp_destroy_tex_tile_cache(tc);
+            return NULL;
+         }
+         tc->entries[pos]->addr.bits.invalid = 1;
       }
-      tc->last_tile = &tc->entries[0]; /* any tile */
+      tc->last_tile = tc->entries[0]; /* any tile */
    }
    return tc;
 }
@@ -71,7 +76,7 @@ sp_destroy_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
       uint pos;
 
       for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
-         /*assert(tc->entries[pos].x < 0);*/
+         FREE(tc->entries[pos]);
       }
       if (tc->transfer) {
          tc->pipe->transfer_unmap(tc->pipe, tc->transfer);
@@ -98,7 +103,8 @@ sp_tex_tile_cache_validate_texture(struct softpipe_tex_tile_cache *tc)
    assert(tc->texture);
 
    for (i = 0; i < ARRAY_SIZE(tc->entries); i++) {
-      tc->entries[i].addr.bits.invalid = 1;
+      if (tc->entries[i])
+         tc->entries[i]->addr.bits.invalid = 1;
    }
 }
 
@@ -148,7 +154,8 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
       /* mark as entries as invalid/empty */
       /* XXX we should try to avoid this when the teximage hasn't changed */
       for (i = 0; i < ARRAY_SIZE(tc->entries); i++) {
-         tc->entries[i].addr.bits.invalid = 1;
+         if (tc->entries[i])
+            tc->entries[i]->addr.bits.invalid = 1;
       }
 
       tc->tex_z = -1; /* any invalid value here */
@@ -170,7 +177,8 @@ sp_flush_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
    if (tc->texture) {
       /* caching a texture, mark all entries as empty */
       for (pos = 0; pos < ARRAY_SIZE(tc->entries); pos++) {
-         tc->entries[pos].addr.bits.invalid = 1;
+         if (tc->entries[pos])
+            tc->entries[pos]->addr.bits.invalid = 1;
       }
       tc->tex_z = -1;
    }
@@ -180,10 +188,7 @@ sp_flush_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
 
 /**
  * Given the texture face, level, zslice, x and y values, compute
- * the cache entry position/index where we'd hope to find the
- * cached texture tile.
- * This is basically a direct-map cache.
- * XXX There's probably lots of ways in which we can improve this.
+ * the cache set where we'd hope to find the cached texture tile.
  */
 static inline uint
 tex_cache_pos( union tex_tile_address addr )
@@ -193,7 +198,7 @@ tex_cache_pos( union tex_tile_address addr )
                  addr.bits.z +
                  addr.bits.level * 7);
 
-   return entry % NUM_TEX_TILE_ENTRIES;
+   return entry % NUM_TEX_TILE_SETS;
 }
 
 /**
@@ -204,12 +209,32 @@ const struct softpipe_tex_cached_tile *
 sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc, 
                         union tex_tile_address addr )
 {
-   struct softpipe_tex_cached_tile *tile;
+   struct softpipe_tex_cached_tile **set =
+      &tc->entries[tex_cache_pos( addr ) * NUM_TEX_TILE_WAYS];
+   struct softpipe_tex_cached_tile *tile = NULL;
    boolean zs = util_format_is_depth_or_stencil(tc->format);
+   unsigned way;
 
-   tile = tc->entries + tex_cache_pos( addr );
+   for (way = 0; way < NUM_TEX_TILE_WAYS && set[way]; way++) {
+      if (set[way]->addr.value == addr.value) {
+         tile = set[way];
+         break;
+      }
+   }
 
-   if (addr.value != tile->addr.value) {
+   if (!tile) {
+      /* Take an unallocated way if there's one left, the least recently
+       * used one otherwise.  The first way is always allocated.
+       */
+      if (way < NUM_TEX_TILE_WAYS) {
+         set[way] = MALLOC_STRUCT(softpipe_tex_cached_tile);
+         if (!set[way])
+            way--;
+      }
+      else {
+         way = NUM_TEX_TILE_WAYS - 1;
+      }
+      tile = set[way];
 
       /* cache miss.  Most misses are because we've invalidated the
        * texture cache previously -- most commonly on binding a new
@@ -288,6 +313,11 @@ sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc,
       tile->addr = addr;
    }
 
+   /* keep the ways in most recently used order */
+   for (; way > 0; way--)
+      set[way] = set[way - 1];
+   set[0] = tile;
+
    tc->last_tile = tile;
    return tile;
 }
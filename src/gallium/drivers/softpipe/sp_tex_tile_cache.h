@@ -73,12 +73,16 @@ struct softpipe_tex_cached_tile
 };
 
 /*
- * The number of cache entries.
- * Should not be decreased to lower than 16, and even that
- * seems too low to avoid cache thrashing in some cases (because
- * the cache is direct mapped, see tex_cache_pos() function).
+ * The cache is set associative: a tile can be in any of the ways of the
+ * set selected by tex_cache_pos(), and the least recently used way is
+ * replaced on a miss.
+ * The number of sets should not be decreased to lower than 16, so that
+ * the neighbouring tiles read by a filter land in different sets.
+ * Only the first way of each set is allocated up front.
  */
-#define NUM_TEX_TILE_ENTRIES 16
+#define NUM_TEX_TILE_SETS 16
+#define NUM_TEX_TILE_WAYS 4
+#define NUM_TEX_TILE_ENTRIES (NUM_TEX_TILE_SETS * NUM_TEX_TILE_WAYS)
 
 struct softpipe_tex_tile_cache
 {
@@ -89,7 +93,8 @@ struct softpipe_tex_tile_cache
    struct pipe_resource *texture;  /**< if caching a texture */
    unsigned timestamp;
 
-   struct softpipe_tex_cached_tile entries[NUM_TEX_TILE_ENTRIES];
+   /** Ways of each set, in most recently used order, NULL if unallocated */
+   struct softpipe_tex_cached_tile *entries[NUM_TEX_TILE_ENTRIES];
 
    struct pipe_transfer *tex_trans;
    void *tex_trans_map;
@@ -343,8 +343,11 @@ static void
 sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc, int layer)
 {
    struct pipe_transfer *pt = tc->transfer[layer];
+   const enum pipe_format format = pt->resource->format;
    const uint w = tc->transfer[layer]->box.width;
    const uint h = tc->transfer[layer]->box.height;
+   const int stride = util_format_get_stride(format, TILE_SIZE);
+   void *packed;
    uint x, y;
    uint numCleared = 0;
 
@@ -352,9 +355,34 @@ sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc, int layer)
 
    /* clear the scratch tile to the clear value */
    if (tc->depth_stencil) {
-      clear_tile(tc->tile, pt->resource->format, tc->clear_val);
+      clear_tile(tc->tile, format, tc->clear_val);
+      packed = tc->tile->data.any;
    } else {
-      clear_tile_rgba(tc->tile, pt->resource->format, &tc->clear_color);
+      clear_tile_rgba(tc->tile, format, &tc->clear_color);
+
+      /* Convert the scratch tile to the surface format once, every cleared
+       * position is then a plain copy.
+       */
+      packed = MALLOC(stride * TILE_SIZE);
+      if (!packed)
+         return;
+
+      if (util_format_is_pure_uint(tc->surface->format)) {
+         util_format_write_4ui(format,
+                               (unsigned *) tc->tile->data.colorui128,
+                               TILE_SIZE * 4 * sizeof(unsigned),
+                               packed, stride, 0, 0, TILE_SIZE, TILE_SIZE);
+      } else if (util_format_is_pure_sint(tc->surface->format)) {
+         util_format_write_4i(format,
+                              (int *) tc->tile->data.colori128,
+                              TILE_SIZE * 4 * sizeof(int),
+                              packed, stride, 0, 0, TILE_SIZE, TILE_SIZE);
+      } else {
+         util_format_write_4f(format,
+                              (float *) tc->tile->data.color,
+                              TILE_SIZE * 4 * sizeof(float),
+                              packed, stride, 0, 0, TILE_SIZE, TILE_SIZE);
+      }
    }
 
    /* push the tile to all positions marked as clear */
@@ -364,33 +392,16 @@ sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc, int layer)
 
          if (is_clear_flag_set(tc->clear_flags, addr, tc->clear_flags_size)) {
             /* write the scratch tile to the surface */
-            if (tc->depth_stencil) {
-               pipe_put_tile_raw(pt, tc->transfer_map[layer],
-                                 x, y, TILE_SIZE, TILE_SIZE,
-                                 tc->tile->data.any, 0/*STRIDE*/);
-            }
-            else {
-               if (util_format_is_pure_uint(tc->surface->format)) {
-                  pipe_put_tile_ui_format(pt, tc->transfer_map[layer],
-                                          x, y, TILE_SIZE, TILE_SIZE,
-                                          pt->resource->format,
-                                          (unsigned *) tc->tile->data.colorui128);
-               } else if (util_format_is_pure_sint(tc->surface->format)) {
-                  pipe_put_tile_i_format(pt, tc->transfer_map[layer],
-                                         x, y, TILE_SIZE, TILE_SIZE,
-                                         pt->resource->format,
-                                         (int *) tc->tile->data.colori128);
-               } else {
-                  pipe_put_tile_rgba(pt, tc->transfer_map[layer],
-                                     x, y, TILE_SIZE, TILE_SIZE,
-                                     (float *) tc->tile->data.color);
-               }
-            }
+            pipe_put_tile_raw(pt, tc->transfer_map[layer],
+                              x, y, TILE_SIZE, TILE_SIZE,
+                              packed, stride);
             numCleared++;
          }
       }
    }
 
+   if (!tc->depth_stencil)
+      FREE(packed);
 
 #if 0
    debug_printf("num cleared: %u\n", numCleared);
@@ -54,6 +54,25 @@ svga_buffer_needs_hw_storage(unsigned usage)
 }
 
 
+/**
+ * Whether [start, end) intersects one of the ranges of the pending DMA.
+ */
+static boolean
+svga_buffer_range_is_pending(const struct svga_buffer *sbuf,
+                             unsigned start, unsigned end)
+{
+   unsigned i;
+
+   for (i = 0; i < sbuf->map.num_ranges; ++i) {
+      if (start < sbuf->map.ranges[i].end &&
+          sbuf->map.ranges[i].start < end)
+         return TRUE;
+   }
+
+   return FALSE;
+}
+
+
 /**
  * Create a buffer transfer.
  *
@@ -164,9 +183,17 @@ svga_buffer_transfer_map(struct pipe_context *pipe,
          svga_hwtnl_flush_buffer(svga, resource);
 
          if (sbuf->dma.pending) {
+            boolean overlaps =
+               svga_buffer_range_is_pending(sbuf, box->x, box->x + box->width);
+
             svga_buffer_upload_flush(svga, sbuf);
 
-            if (svga_buffer_has_hw_storage(sbuf)) {
+            /*
+             * The pending DMA only reads the ranges that were mapped so far,
+             * so writes elsewhere in the buffer can't disturb it.  The next
+             * DMA is queued after it anyway.
+             */
+            if (overlaps && svga_buffer_has_hw_storage(sbuf)) {
                /*
                 * We have a pending DMA upload from a hardware buffer, therefore
                 * we need to ensure that the host finishes processing that DMA
@@ -23,6 +23,7 @@
  *
  **********************************************************/
 
+#include "util/u_debug.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_hash.h"
@@ -228,19 +229,19 @@ svga_screen_cache_add(struct svga_screen *svgascreen,
    *p_handle = NULL;
    pipe_mutex_lock(cache->mutex);
 
-   if (surf_size >= SVGA_HOST_SURFACE_CACHE_BYTES) {
+   if (surf_size >= cache->max_size) {
       /* this surface is too large to cache, just free it */
       sws->surface_reference(sws, &handle, NULL);
       pipe_mutex_unlock(cache->mutex);
       return;
    }
 
-   if (cache->total_size + surf_size > SVGA_HOST_SURFACE_CACHE_BYTES) {
+   if (cache->total_size + surf_size > cache->max_size) {
       /* Adding this surface would exceed the cache size.
        * Try to discard least recently used entries until we hit the
        * new target cache size.
        */
-      unsigned target_size = SVGA_HOST_SURFACE_CACHE_BYTES - surf_size;
+      unsigned target_size = cache->max_size - surf_size;
 
       svga_screen_cache_shrink(svgascreen, target_size);
 
@@ -389,6 +390,10 @@ svga_screen_cache_init(struct svga_screen *svgascreen)
 
    pipe_mutex_init(cache->mutex);
 
+   cache->max_size = debug_get_num_option("SVGA_SURFACE_CACHE_MB",
+                                          SVGA_HOST_SURFACE_CACHE_BYTES /
+                                          (1024 * 1024)) * 1024 * 1024;
+
    for (i = 0; i < SVGA_HOST_SURFACE_CACHE_BUCKETS; ++i)
       LIST_INITHEAD(&cache->bucket[i]);
 
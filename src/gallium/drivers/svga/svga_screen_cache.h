@@ -38,7 +38,7 @@
 
 
 /* Guess the storage size of cached surfaces and try and keep it under
- * this amount:
+ * this amount, unless overridden with SVGA_SURFACE_CACHE_MB:
  */ 
 #define SVGA_HOST_SURFACE_CACHE_BYTES (16 * 1024 * 1024)
 
@@ -124,6 +124,9 @@ struct svga_host_surface_cache
 
    /** Sum of sizes of all surfaces (in bytes) */
    unsigned total_size;
+
+   /** Limit for total_size (in bytes) */
+   unsigned max_size;
 };
 
 
@@ -216,7 +216,7 @@ void QueueWork(SWR_CONTEXT *pContext)
             static TileSet lockedTiles;
             uint64_t curDraw[2] = { pContext->pCurDrawContext->drawId, pContext->pCurDrawContext->drawId };
             WorkOnFifoFE(pContext, 0, curDraw[0]);
-            WorkOnFifoBE(pContext, 0, curDraw[1], lockedTiles, 0, 0);
+            WorkOnFifoBE(pContext, 0, curDraw[1], lockedTiles, 0, 1);
         }
         else
         {
@@ -258,10 +258,21 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
     // If current draw context is null then need to obtain a new draw context to use from ring.
     if (pContext->pCurDrawContext == nullptr)
     {
-        // Need to wait for a free entry.
+        // Need to wait for a free entry. Spin for a while, then yield, so that
+        // the API thread doesn't keep a core away from the workers which have
+        // to retire a draw before it can go on.
+        uint32_t spinCount = 0;
         while (pContext->dcRing.IsFull())
         {
-            _mm_pause();
+            if (spinCount < KNOB_WORKER_SPIN_LOOP_COUNT)
+            {
+                _mm_pause();
+                spinCount++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
         }
 
         uint64_t curDraw = pContext->dcRing.GetHead();
@@ -1486,6 +1497,57 @@ void SwrGetStats(
     QueueDraw(pContext);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the current arena memory counters.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - SWR will fill this out for caller.
+void SwrGetArenaStats(
+    HANDLE hContext,
+    SWR_ARENA_STATS* pStats)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    size_t inUse, cached, highWater;
+    uint64_t numSystemAllocs;
+
+    pContext->cachingArenaAllocator.GetStats(inUse, cached, highWater, numSystemAllocs);
+
+    pStats->BytesInUse = inUse;
+    pStats->BytesCached = cached;
+    pStats->BytesHighWater = highWater;
+    pStats->NumSystemAllocs = numSystemAllocs;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Starts recording the per-worker trace.
+/// @param hContext - Handle passed back from SwrCreateContext
+void SwrEnableTrace(
+    HANDLE hContext)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    SwrWaitForIdle(hContext);
+    pContext->trace.Enable(pContext->NumWorkerThreads);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Stops recording the per-worker trace and writes it out.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pFilename - File to write the trace to.
+bool SwrDisableTrace(
+    HANDLE hContext,
+    const char* pFilename)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    if (!pContext->trace.IsEnabled())
+    {
+        return false;
+    }
+
+    SwrWaitForIdle(hContext);
+    return pContext->trace.Write(pFilename);
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Enables stats counting
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -1509,4 +1571,16 @@ void SWR_API SwrEndFrame(
     RDTSC_ENDFRAME();
     SWR_CONTEXT *pContext = GetContext(hContext);
     pContext->frameCount++;
+
+    if (KNOB_TRACE_END_FRAME > KNOB_TRACE_START_FRAME)
+    {
+        if (pContext->frameCount == KNOB_TRACE_START_FRAME)
+        {
+            SwrEnableTrace(hContext);
+        }
+        else if (pContext->frameCount == KNOB_TRACE_END_FRAME)
+        {
+            SwrDisableTrace(hContext, KNOB_TRACE_FILE.c_str());
+        }
+    }
 }
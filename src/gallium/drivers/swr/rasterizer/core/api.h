@@ -514,6 +514,43 @@ void SWR_API SwrGetStats(
     HANDLE hContext,
     SWR_STATS* pStats);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Memory used by the draw and state arenas of a context.
+struct SWR_ARENA_STATS
+{
+    uint64_t BytesInUse;        // Bytes held by draw/state arenas
+    uint64_t BytesCached;       // Bytes cached for reuse by the arenas
+    uint64_t BytesHighWater;    // Peak of BytesInUse in the current trim period
+    uint64_t NumSystemAllocs;   // Blocks allocated from the system so far
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the current arena memory counters. Unlike SwrGetStats
+///        this is not queued, the values are read immediately.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - SWR will fill this out for caller.
+void SWR_API SwrGetArenaStats(
+    HANDLE hContext,
+    SWR_ARENA_STATS* pStats);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Starts recording a trace of the frontend, backend and compute
+///        work done by each worker thread, one span per draw, macrotile or
+///        thread group. Waits for all queued work to complete first.
+/// @param hContext - Handle passed back from SwrCreateContext
+void SWR_API SwrEnableTrace(
+    HANDLE hContext);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Waits for all queued work to complete, stops recording and writes
+///        the trace in the Chrome trace event format (chrome://tracing).
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pFilename - File to write the trace to.
+/// @return false if tracing wasn't enabled or the file couldn't be written.
+bool SWR_API SwrDisableTrace(
+    HANDLE hContext,
+    const char* pFilename);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Enables stats counting
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -115,10 +115,24 @@ struct CachingAllocatorT : DefaultAllocator
                 pPrevBlock->pNext = pBlock->pNext;
                 pBlock->pNext = nullptr;
 
+                UpdateHighWater();
                 return pBlock;
             }
+        }
+
+        if (bucket && bucket < (CACHE_NUM_BUCKETS - 1))
+        {
+            // Make all blocks in this bucket the same size
+            size = size_t(1) << (bucket + 1 + CACHE_START_BUCKET_BIT);
+        }
+
+        ArenaBlock* pBlock = this->DefaultAllocator::AllocateAligned(size, align);
 
+        {
+            std::lock_guard<std::mutex> l(m_mutex);
             m_totalAllocated += size;
+            m_numSystemAllocs++;
+            UpdateHighWater();
 
 #if 0
             {
@@ -130,13 +144,7 @@ struct CachingAllocatorT : DefaultAllocator
 #endif
         }
 
-        if (bucket && bucket < (CACHE_NUM_BUCKETS - 1))
-        {
-            // Make all blocks in this bucket the same size
-            size = size_t(1) << (bucket + 1 + CACHE_START_BUCKET_BIT);
-        }
-
-        return this->DefaultAllocator::AllocateAligned(size, align);
+        return pBlock;
     }
 
     void Free(ArenaBlock* pMem)
@@ -150,30 +158,43 @@ struct CachingAllocatorT : DefaultAllocator
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Called periodically to age the cached blocks. Blocks that stayed
+    ///        unused for a whole period are only released down to what the
+    ///        peak usage of that period needs, so periodic spikes (e.g. a
+    ///        heavy pass every frame) keep being served from the cache.
     void FreeOldBlocks()
     {
-        if (!m_cachedSize) { return; }
+        if (!m_cachedSize && !m_oldCachedSize) { return; }
         std::lock_guard<std::mutex> l(m_mutex);
 
-        bool doFree = (m_oldCachedSize > MAX_UNUSED_SIZE);
+        size_t inUse = m_totalAllocated - m_cachedSize - m_oldCachedSize;
+        size_t maxCachedSize = (m_highWater - inUse) + MAX_UNUSED_SIZE;
 
-        for (uint32_t i = 0; i < CACHE_NUM_BUCKETS; ++i)
+        // Release old blocks, biggest buckets first, until under the target
+        for (uint32_t i = CACHE_NUM_BUCKETS; i-- > 0 && (m_cachedSize + m_oldCachedSize) > maxCachedSize; )
         {
-            if (doFree)
+            ArenaBlock* pBlock = m_oldCachedBlocks[i].pNext;
+            while (pBlock && (m_cachedSize + m_oldCachedSize) > maxCachedSize)
+            {
+                ArenaBlock* pNext = pBlock->pNext;
+                m_oldCachedSize -= pBlock->blockSize;
+                m_totalAllocated -= pBlock->blockSize;
+                this->DefaultAllocator::Free(pBlock);
+                pBlock = pNext;
+            }
+            m_oldCachedBlocks[i].pNext = pBlock;
+            if (!pBlock)
             {
-                ArenaBlock* pBlock = m_oldCachedBlocks[i].pNext;
-                while (pBlock)
-                {
-                    ArenaBlock* pNext = pBlock->pNext;
-                    m_oldCachedSize -= pBlock->blockSize;
-                    m_totalAllocated -= pBlock->blockSize;
-                    this->DefaultAllocator::Free(pBlock);
-                    pBlock = pNext;
-                }
-                m_oldCachedBlocks[i].pNext = nullptr;
                 m_pOldLastCachedBlocks[i] = &m_oldCachedBlocks[i];
             }
+        }
 
+        // Start a new period
+        m_highWater = inUse;
+
+        for (uint32_t i = 0; i < CACHE_NUM_BUCKETS; ++i)
+        {
             if (m_pLastCachedBlocks[i] != &m_cachedBlocks[i])
             {
                 if (i && i < (CACHE_NUM_BUCKETS - 1))
@@ -213,6 +234,17 @@ struct CachingAllocatorT : DefaultAllocator
         m_cachedSize = 0;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the allocator counters, in bytes.
+    void GetStats(size_t& out_inUse, size_t& out_cached, size_t& out_highWater, uint64_t& out_numSystemAllocs)
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        out_cached = m_cachedSize + m_oldCachedSize;
+        out_inUse = m_totalAllocated - out_cached;
+        out_highWater = m_highWater;
+        out_numSystemAllocs = m_numSystemAllocs;
+    }
+
     CachingAllocatorT()
     {
         for (uint32_t i = 0; i < CACHE_NUM_BUCKETS; ++i)
@@ -245,6 +277,13 @@ struct CachingAllocatorT : DefaultAllocator
     }
 
 private:
+    // m_mutex must be held
+    void UpdateHighWater()
+    {
+        size_t inUse = m_totalAllocated - m_cachedSize - m_oldCachedSize;
+        m_highWater = std::max(m_highWater, inUse);
+    }
+
     static uint32_t GetBucketId(size_t blockSize)
     {
         uint32_t bucketId = 0;
@@ -363,6 +402,10 @@ private:
 
     size_t                  m_cachedSize = 0;
     size_t                  m_oldCachedSize = 0;
+
+    // Peak of bytes handed out to arenas since the last FreeOldBlocks
+    size_t                  m_highWater = 0;
+    uint64_t                m_numSystemAllocs = 0;
 };
 typedef CachingAllocatorT<> CachingAllocator;
 
@@ -41,6 +41,7 @@
 #include "core/knobs.h"
 #include "common/simdintrin.h"
 #include "core/threads.h"
+#include "core/trace.h"
 #include "ringbuffer.h"
 
 // x.8 fixed point precision values
@@ -482,6 +483,9 @@ struct SWR_CONTEXT
 
     CachingAllocator cachingArenaAllocator;
     uint32_t frameCount;
+
+    // Per-worker trace of FE/BE/compute work, see SwrEnableTrace.
+    TraceRecorder trace;
 };
 
 void WaitForDependencies(SWR_CONTEXT *pContext, uint64_t drawId);
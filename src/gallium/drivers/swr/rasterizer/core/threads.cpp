@@ -368,7 +368,7 @@ void WorkOnFifoBE(
     uint64_t &curDrawBE,
     TileSet& lockedTiles,
     uint32_t numaNode,
-    uint32_t numaMask)
+    uint32_t numNumaNodes)
 {
     // Find the first incomplete draw that has pending work. If no such draw is found then
     // return. FindFirstIncompleteDraw is responsible for incrementing the curDrawBE.
@@ -413,7 +413,7 @@ void WorkOnFifoBE(
             // Only work on tiles for for this numa node
             uint32_t x, y;
             pDC->pTileMgr->getTileIndices(tileID, x, y);
-            if (((x ^ y) & numaMask) != numaNode)
+            if (GetMacroTileNumaNode(x, y, numNumaNodes) != numaNode)
             {
                 continue;
             }
@@ -436,6 +436,7 @@ void WorkOnFifoBE(
                 BE_WORK *pWork;
 
                 RDTSC_START(WorkerFoundWork);
+                uint64_t traceStart = pContext->trace.Start();
 
                 uint32_t numWorkItems = tile.getNumQueued();
                 SWR_ASSERT(numWorkItems);
@@ -453,6 +454,7 @@ void WorkOnFifoBE(
                     tile.dequeue();
                 }
                 RDTSC_STOP(WorkerFoundWork, numWorkItems, pDC->drawId);
+                pContext->trace.AddSpan(workerId, traceStart, TRACE_SPAN_BE, pDC->drawId, tileID);
 
                 _ReadWriteBarrier();
 
@@ -512,7 +514,9 @@ void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawFE)
             if (initial == 0)
             {
                 // successfully grabbed the DC, now run the FE
+                uint64_t traceStart = pContext->trace.Start();
                 pDC->FeWork.pfnWork(pContext, pDC, workerId, &pDC->FeWork.desc);
+                pContext->trace.AddSpan(workerId, traceStart, TRACE_SPAN_FE, pDC->drawId, 0);
 
                 _ReadWriteBarrier();
                 pDC->doneFE = true;
@@ -563,7 +567,9 @@ void WorkOnCompute(
             uint32_t threadGroupId = 0;
             while (queue.getWork(threadGroupId))
             {
+                uint64_t traceStart = pContext->trace.Start();
                 ProcessComputeBE(pDC, workerId, threadGroupId, pSpillFillBuffer);
+                pContext->trace.AddSpan(workerId, traceStart, TRACE_SPAN_COMPUTE, pDC->drawId, threadGroupId);
 
                 queue.finishedWork();
             }
@@ -584,7 +590,7 @@ DWORD workerThreadMain(LPVOID pData)
     RDTSC_INIT(threadId);
 
     uint32_t numaNode = pThreadData->numaId;
-    uint32_t numaMask = pContext->threadPool.numaMask;
+    uint32_t numNumaNodes = pContext->threadPool.numNumaNodes;
 
     // flush denormals to 0
     _mm_setcsr(_mm_getcsr() | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
@@ -658,7 +664,7 @@ DWORD workerThreadMain(LPVOID pData)
         if (IsBEThread)
         {
             RDTSC_START(WorkerWorkOnFifoBE);
-            WorkOnFifoBE(pContext, workerId, curDrawBE, lockedTiles, numaNode, numaMask);
+            WorkOnFifoBE(pContext, workerId, curDrawBE, lockedTiles, numaNode, numNumaNodes);
             RDTSC_STOP(WorkerWorkOnFifoBE, 0, 0);
 
             WorkOnCompute(pContext, workerId, curDrawBE);
@@ -817,7 +823,7 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
 
     pPool->inThreadShutdown = false;
     pPool->pThreadData = (THREAD_DATA *)malloc(pPool->numThreads * sizeof(THREAD_DATA));
-    pPool->numaMask = 0;
+    pPool->numNumaNodes = 1;
 
     if (KNOB_MAX_WORKER_THREADS)
     {
@@ -843,7 +849,7 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     }
     else
     {
-        pPool->numaMask = numNodes - 1; // Only works for 2**n numa nodes (1, 2, 4, etc.)
+        pPool->numNumaNodes = numNodes;
 
         uint32_t workerId = 0;
         for (uint32_t n = 0; n < numNodes; ++n)
@@ -53,18 +53,26 @@ struct THREAD_POOL
 {
     THREAD_PTR threads[KNOB_MAX_NUM_THREADS];
     uint32_t numThreads;
-    uint32_t numaMask;
+    uint32_t numNumaNodes;
     volatile bool inThreadShutdown;
     THREAD_DATA *pThreadData;
 };
 
 typedef std::unordered_set<uint32_t> TileSet;
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the NUMA node whose workers own a macrotile. Its hot
+///        tiles are allocated on that node.
+INLINE uint32_t GetMacroTileNumaNode(uint32_t x, uint32_t y, uint32_t numNumaNodes)
+{
+    return (x ^ y) % numNumaNodes;
+}
+
 void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
 void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
 
 // Expose FE and BE worker functions to the API thread if single threaded
 void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawFE);
-void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawBE, TileSet &usedTiles, uint32_t numaNode, uint32_t numaMask);
+void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawBE, TileSet &usedTiles, uint32_t numaNode, uint32_t numNumaNodes);
 void WorkOnCompute(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawBE);
 int64_t CompleteDrawContext(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC);
\ No newline at end of file
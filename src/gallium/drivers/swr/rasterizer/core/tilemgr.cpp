@@ -98,7 +98,7 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32
         if (create)
         {
             uint32_t size = numSamples * mHotTileSize[attachment];
-            uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
+            uint32_t numaNode = GetMacroTileNumaNode(x, y, pContext->threadPool.numNumaNodes);
             hotTile.pBuffer = (uint8_t*)AllocHotTileMem(size, KNOB_SIMD_WIDTH * 4, numaNode);
             hotTile.state = HOTTILE_INVALID;
             hotTile.numSamples = numSamples;
@@ -119,10 +119,10 @@ HOTTILE* HotTileMgr::GetHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32
             SWR_ASSERT((hotTile.state == HOTTILE_INVALID) ||
                 (hotTile.state == HOTTILE_RESOLVED) ||
                 (hotTile.state == HOTTILE_CLEAR));
-            FreeHotTileMem(hotTile.pBuffer);
+            FreeHotTileMem(hotTile.pBuffer, hotTile.numSamples * mHotTileSize[attachment]);
 
             uint32_t size = numSamples * mHotTileSize[attachment];
-            uint32_t numaNode = ((x ^ y) & pContext->threadPool.numaMask);
+            uint32_t numaNode = GetMacroTileNumaNode(x, y, pContext->threadPool.numNumaNodes);
             hotTile.pBuffer = (uint8_t*)AllocHotTileMem(size, KNOB_SIMD_WIDTH * 4, numaNode);
             hotTile.state = HOTTILE_INVALID;
             hotTile.numSamples = numSamples;
@@ -181,7 +181,8 @@ HOTTILE* HotTileMgr::GetHotTileNoLoad(
         if (create)
         {
             uint32_t size = numSamples * mHotTileSize[attachment];
-            hotTile.pBuffer = (uint8_t*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
+            uint32_t numaNode = GetMacroTileNumaNode(x, y, pContext->threadPool.numNumaNodes);
+            hotTile.pBuffer = (uint8_t*)AllocHotTileMem(size, KNOB_SIMD_WIDTH * 4, numaNode);
             hotTile.state = HOTTILE_INVALID;
             hotTile.numSamples = numSamples;
             hotTile.renderTargetArrayIndex = 0;
@@ -30,6 +30,9 @@
 
 #include <set>
 #include <unordered_map>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 #include "common/formats.h"
 #include "fifo.hpp"
 #include "context.h"
@@ -285,7 +288,8 @@ public:
             {
                 for (int a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
                 {
-                    FreeHotTileMem(mHotTiles[x][y].Attachment[a].pBuffer);
+                    HOTTILE& hotTile = mHotTiles[x][y].Attachment[a];
+                    FreeHotTileMem(hotTile.pBuffer, hotTile.numSamples * mHotTileSize[a]);
                 }
             }
         }
@@ -306,6 +310,11 @@ private:
     HotTileSet mHotTiles[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];
     uint32_t mHotTileSize[SWR_NUM_ATTACHMENTS];
 
+    // Hot tiles are only touched by the workers of the NUMA node owning
+    // their macrotile (see GetMacroTileNumaNode). On Windows the memory is
+    // allocated on that node explicitly, elsewhere fresh pages are mapped so
+    // the first-touch policy places them there when the owning worker
+    // loads or clears the tile.
     void* AllocHotTileMem(size_t size, uint32_t align, uint32_t numaNode)
     {
         void* p = nullptr;
@@ -313,20 +322,25 @@ private:
         HANDLE hProcess = GetCurrentProcess();
         p = VirtualAllocExNuma(hProcess, nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE, numaNode);
 #else
-        p = _aligned_malloc(size, align);
+        SWR_ASSERT(align <= 4096);
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            p = nullptr;
+        }
 #endif
 
         return p;
     }
 
-    void FreeHotTileMem(void* pBuffer)
+    void FreeHotTileMem(void* pBuffer, size_t size)
     {
         if (pBuffer)
         {
 #if defined(_WIN32)
             VirtualFree(pBuffer, 0, MEM_RELEASE);
 #else
-            _aligned_free(pBuffer);
+            munmap(pBuffer, size);
 #endif
         }
     }
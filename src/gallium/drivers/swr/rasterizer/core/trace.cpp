@@ -0,0 +1,89 @@
+/****************************************************************************
+* Copyright (C) 2016 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file trace.cpp
+*
+* @brief Chrome trace event output for TraceRecorder.
+*
+******************************************************************************/
+#include "core/trace.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+
+static const char* TraceSpanName(uint32_t type)
+{
+    switch (type)
+    {
+    case TRACE_SPAN_FE: return "FE";
+    case TRACE_SPAN_BE: return "BE";
+    case TRACE_SPAN_COMPUTE: return "CS";
+    default: return "unknown";
+    }
+}
+
+bool TraceRecorder::Write(const char* pFilename)
+{
+    mEnabled = false;
+
+    // Calibrate rdtsc against the wall clock over the traced interval.
+    uint64_t endTsc = __rdtsc();
+    double elapsedUs = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - mStartTime).count();
+    double usPerTick = (endTsc > mStartTsc) ? elapsedUs / (double)(endTsc - mStartTsc) : 0.0;
+
+    FILE* f = fopen(pFilename, "w");
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    bool first = true;
+    for (uint32_t workerId = 0; workerId < mSpans.size(); ++workerId)
+    {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+                "\"args\":{\"name\":\"worker %u\"}}",
+                first ? "" : ",\n", workerId, workerId);
+        first = false;
+
+        for (const TRACE_SPAN& span : mSpans[workerId])
+        {
+            double ts = (double)(span.start - mStartTsc) * usPerTick;
+            double dur = (double)(span.end - span.start) * usPerTick;
+
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,"
+                    "\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"draw\":%" PRIu64 ",\"%s\":%u}}",
+                    TraceSpanName(span.type), workerId, ts, dur, span.drawId,
+                    span.type == TRACE_SPAN_COMPUTE ? "group" : "tile", span.id);
+        }
+
+        mSpans[workerId].clear();
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    return true;
+}
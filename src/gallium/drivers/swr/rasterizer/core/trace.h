@@ -0,0 +1,111 @@
+/****************************************************************************
+* Copyright (C) 2016 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file trace.h
+*
+* @brief Per-draw, per-worker trace of the work done by the thread pool.
+*        Unlike the rdtsc buckets this is always compiled in and is enabled
+*        at runtime. Each worker records a span for every frontend draw
+*        (vertex processing and binning), backend macrotile and compute
+*        thread group it executes. The spans are written out in the Chrome
+*        trace event format, which can be loaded in chrome://tracing.
+*
+******************************************************************************/
+#pragma once
+
+#include "common/os.h"
+#include "core/knobs.h"
+
+#include <vector>
+#include <chrono>
+
+enum TRACE_SPAN_TYPE
+{
+    TRACE_SPAN_FE,          // frontend: vertex processing and binning of a draw
+    TRACE_SPAN_BE,          // backend: all queued work for one macrotile of a draw
+    TRACE_SPAN_COMPUTE,     // one compute thread group
+};
+
+struct TRACE_SPAN
+{
+    uint64_t start;         // rdtsc
+    uint64_t end;           // rdtsc
+    uint64_t drawId;
+    uint32_t type;          // TRACE_SPAN_TYPE
+    uint32_t id;            // macrotile or thread group id
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Records trace spans for each worker thread. Spans are appended
+///        to per-worker lists so recording doesn't need any locking.
+///        Enable() and Write() must only be called while the workers are
+///        idle.
+class TraceRecorder
+{
+public:
+    void Enable(uint32_t numWorkers)
+    {
+        mSpans.resize(numWorkers);
+        for (auto& spans : mSpans)
+        {
+            spans.clear();
+        }
+        mStartTime = std::chrono::steady_clock::now();
+        mStartTsc = __rdtsc();
+        mEnabled = true;
+    }
+
+    INLINE bool IsEnabled() const
+    {
+        return mEnabled;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns a start timestamp to pass to AddSpan, or 0 when
+    ///        tracing is disabled.
+    INLINE uint64_t Start() const
+    {
+        return mEnabled ? __rdtsc() : 0;
+    }
+
+    INLINE void AddSpan(uint32_t workerId, uint64_t start, TRACE_SPAN_TYPE type, uint64_t drawId, uint32_t id)
+    {
+        if (start == 0 || !mEnabled)
+        {
+            return;
+        }
+
+        TRACE_SPAN span = { start, __rdtsc(), drawId, (uint32_t)type, id };
+        mSpans[workerId].push_back(span);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Stops recording and writes the recorded spans to pFilename.
+    /// @return false if the file could not be written.
+    bool Write(const char* pFilename);
+
+private:
+    volatile bool mEnabled{ false };
+    std::vector<std::vector<TRACE_SPAN>> mSpans;
+    std::chrono::steady_clock::time_point mStartTime;
+    uint64_t mStartTsc{ 0 };
+};
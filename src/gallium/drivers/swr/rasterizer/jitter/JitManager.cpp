@@ -107,11 +107,10 @@ JitManager::JitManager(uint32_t simdWidth, const char *arch)
     // force JIT to use the same CPU arch as the rest of swr
     if(mArch.AVX512F())
     {
-        assert(0 && "Implement AVX512 jitter");
         hostCPUName = sys::getHostCPUName();
         if (mVWidth == 0)
         {
-            mVWidth = 16;
+            mVWidth = 8;
         }
     }
     else if(mArch.AVX2())
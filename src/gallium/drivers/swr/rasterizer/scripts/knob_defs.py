@@ -123,6 +123,32 @@ KNOBS = [
         'category'  : 'perf',
     }],
 
+    ['TRACE_START_FRAME', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Frame from when to record the per-worker FE/BE/compute trace.',
+                       '',
+                       'NOTE: Tracing is only enabled if TRACE_END_FRAME is greater',
+                       'than TRACE_START_FRAME.'],
+        'category'  : 'perf',
+    }],
+
+    ['TRACE_END_FRAME', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Frame at which to stop recording the trace and write it',
+                       'to TRACE_FILE.'],
+        'category'  : 'perf',
+    }],
+
+    ['TRACE_FILE', {
+        'type'      : 'std::string',
+        'default'   : 'swr_trace.json',
+        'desc'      : ['File the per-worker trace is written to, in the Chrome',
+                       'trace event format (load it in chrome://tracing).'],
+        'category'  : 'perf',
+    }],
+
     ['WORKER_SPIN_LOOP_COUNT', {
         'type'      : 'uint32_t',
         'default'   : '5000',
@@ -342,6 +342,39 @@ swr_render_condition(struct pipe_context *pipe,
    ctx->render_cond_cond = condition;
 }
 
+static void
+swr_invalidate_resource(struct pipe_context *pipe,
+                        struct pipe_resource *resource)
+{
+   struct swr_context *ctx = swr_context(pipe);
+   struct pipe_framebuffer_state *fb = &ctx->framebuffer;
+   uint32_t attachment_mask = 0;
+   SWR_RECT rect;
+
+   /* The hot tiles belong to the framebuffer the core last saw. */
+   if (ctx->dirty & SWR_NEW_FRAMEBUFFER)
+      return;
+
+   for (unsigned i = 0; i < fb->nr_cbufs; i++) {
+      if (fb->cbufs[i] && fb->cbufs[i]->texture == resource)
+         attachment_mask |= SWR_ATTACHMENT_COLOR0_BIT << i;
+   }
+   if (fb->zsbuf && fb->zsbuf->texture == resource)
+      attachment_mask |= SWR_ATTACHMENT_DEPTH_BIT | SWR_ATTACHMENT_STENCIL_BIT;
+
+   if (!attachment_mask)
+      return;
+
+   /* Mark the tiles covering the surface as resolved, so that they are
+    * neither stored at the next flush nor loaded back before the next draw.
+    */
+   rect.left = 0;
+   rect.top = 0;
+   rect.right = fb->width;
+   rect.bottom = fb->height;
+   SwrDiscardRect(ctx->swrContext, attachment_mask, rect);
+}
+
 struct pipe_context *
 swr_create_context(struct pipe_screen *p_screen, void *priv, unsigned flags)
 {
@@ -380,6 +413,7 @@ swr_create_context(struct pipe_screen *p_screen, void *priv, unsigned flags)
 
    ctx->pipe.resource_copy_region = swr_resource_copy;
    ctx->pipe.render_condition = swr_render_condition;
+   ctx->pipe.invalidate_resource = swr_invalidate_resource;
 
    swr_state_init(&ctx->pipe);
    swr_clear_init(&ctx->pipe);
@@ -31,6 +31,30 @@
 #include "util/u_draw.h"
 #include "util/u_prim.h"
 
+/*
+ * Look up the fetch shader for a vertex layout, compiling it on first use.
+ * Contexts and vertex element states with the same layout share it.
+ */
+static PFN_FETCH_FUNC
+swr_get_fetch_func(struct swr_screen *screen, const FETCH_COMPILE_STATE &state)
+{
+   PFN_FETCH_FUNC func;
+
+   pipe_mutex_lock(screen->fetch_cache_mutex);
+   auto search = screen->fetch_cache->find(state);
+   if (search != screen->fetch_cache->end()) {
+      func = search->second;
+   } else {
+      func = JitCompileFetch(screen->hJitMgr, state);
+      debug_printf("fetch shader %p\n", func);
+      if (func)
+         (*screen->fetch_cache)[state] = func;
+   }
+   pipe_mutex_unlock(screen->fetch_cache_mutex);
+
+   return func;
+}
+
 /*
  * Convert mesa PIPE_PRIM_X to SWR enum PRIMITIVE_TOPOLOGY
  */
@@ -149,11 +173,8 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
       velems->fsState.cutIndex = info->restart_index;
       velems->fsState.bEnableCutIndex = info->primitive_restart;
 
-      /* Create Fetch Shader */
-      HANDLE hJitMgr = swr_screen(ctx->pipe.screen)->hJitMgr;
-      velems->fsFunc = JitCompileFetch(hJitMgr, velems->fsState);
-
-      debug_printf("fetch shader %p\n", velems->fsFunc);
+      velems->fsFunc = swr_get_fetch_func(swr_screen(ctx->pipe.screen),
+                                          velems->fsState);
       assert(velems->fsFunc && "Error: FetchShader = NULL");
    }
 
@@ -38,7 +38,13 @@ swr_create_screen(struct sw_winsys *winsys)
    util_dl_library *pLibrary = nullptr;
 
    util_cpu_detect();
-   if (util_cpu_caps.has_avx2) {
+   if (util_cpu_caps.has_avx512f) {
+      fprintf(stderr, "AVX512\n");
+      pLibrary = util_dl_open("libswrAVX512.so");
+      /* The AVX512 build is optional, fall back to AVX2. */
+      if (!pLibrary)
+         pLibrary = util_dl_open("libswrAVX2.so");
+   } else if (util_cpu_caps.has_avx2) {
       fprintf(stderr, "AVX2\n");
       pLibrary = util_dl_open("libswrAVX2.so");
    } else if (util_cpu_caps.has_avx) {
@@ -338,6 +338,7 @@ swr_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_QUERY_BUFFER_OBJECT:
    case PIPE_CAP_QUERY_MEMORY_INFO:
    case PIPE_CAP_ROBUST_BUFFER_ACCESS_BEHAVIOR:
+   case PIPE_CAP_INDEX_BOUNDS_NOT_NEEDED:
    case PIPE_CAP_PCI_GROUP:
    case PIPE_CAP_PCI_BUS:
    case PIPE_CAP_PCI_DEVICE:
@@ -693,6 +694,9 @@ swr_destroy_screen(struct pipe_screen *p_screen)
    swr_fence_finish(p_screen, screen->flush_fence, 0);
    swr_fence_reference(p_screen, &screen->flush_fence, NULL);
 
+   delete screen->fetch_cache;
+   pipe_mutex_destroy(screen->fetch_cache_mutex);
+
    JitDestroyContext(screen->hJitMgr);
 
    if (winsys->destroy)
@@ -733,6 +737,10 @@ swr_create_screen(struct sw_winsys *winsys)
 
    screen->hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, KNOB_ARCH_STR);
 
+   pipe_mutex_init(screen->fetch_cache_mutex);
+   screen->fetch_cache =
+      new std::unordered_map<FETCH_COMPILE_STATE, PFN_FETCH_FUNC>;
+
    swr_fence_init(&screen->base);
 
    return &screen->base;
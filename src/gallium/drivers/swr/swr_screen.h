@@ -26,7 +26,29 @@
 
 #include "pipe/p_screen.h"
 #include "pipe/p_defines.h"
+#include "os/os_thread.h"
 #include "api.h"
+#include "jit_api.h"
+#include <unordered_map>
+
+namespace std
+{
+/* Only hashes what FETCH_COMPILE_STATE::operator== compares */
+template <> struct hash<FETCH_COMPILE_STATE> {
+   std::size_t operator()(const FETCH_COMPILE_STATE &k) const
+   {
+      std::size_t h = k.numAttribs ^ (k.indexType << 8) ^
+                      (k.bDisableVGATHER << 16) ^
+                      (k.bDisableIndexOOBCheck << 17) ^
+                      (k.bEnableCutIndex << 18) ^ k.cutIndex;
+
+      for (uint32_t i = 0; i < k.numAttribs; i++)
+         h = h * 31 + std::hash<uint64_t>()(k.layout[i].bits);
+
+      return h;
+   }
+};
+};
 
 struct sw_winsys;
 
@@ -39,6 +61,10 @@ struct swr_screen {
    struct sw_winsys *winsys;
 
    HANDLE hJitMgr;
+
+   /* Fetch shaders live in hJitMgr, so every context can share them. */
+   pipe_mutex fetch_cache_mutex;
+   std::unordered_map<FETCH_COMPILE_STATE, PFN_FETCH_FUNC> *fetch_cache;
 };
 
 static INLINE struct swr_screen *
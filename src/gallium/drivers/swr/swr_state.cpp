@@ -432,6 +432,41 @@ swr_set_constant_buffer(struct pipe_context *pipe,
 }
 
 
+/*
+ * Whether an attribute can be fetched with the load/shuffle path instead of
+ * gathers, which are slow on many CPUs.  That path only handles
+ * non-instanced attributes of four components of the same size and type,
+ * in memory order.
+ */
+static bool
+swr_can_fetch_without_gather(const INPUT_ELEMENT_DESC &ied)
+{
+   const SWR_FORMAT_INFO &info = GetFormatInfo((SWR_FORMAT)ied.Format);
+   unsigned bpc;
+
+   if (ied.InstanceEnable || info.numComps != 4)
+      return false;
+
+   bpc = info.bpp / info.numComps;
+   for (unsigned c = 0; c < 4; c++) {
+      if (info.bpc[c] != bpc || info.swizzle[c] != c ||
+          info.type[c] != info.type[0])
+         return false;
+   }
+
+   switch (info.type[0]) {
+   case SWR_TYPE_FLOAT:
+      return bpc == 32;
+   case SWR_TYPE_UNORM:
+      return bpc == 8 || bpc == 16;
+   case SWR_TYPE_UINT:
+   case SWR_TYPE_SINT:
+      return bpc == 8 || bpc == 16 || bpc == 32;
+   default:
+      return false;
+   }
+}
+
 static void *
 swr_create_vertex_elements_state(struct pipe_context *pipe,
                                  unsigned num_elements,
@@ -480,6 +515,12 @@ swr_create_vertex_elements_state(struct pipe_context *pipe,
             mesa_to_swr_format(attribs[i].src_format));
          velems->stream_pitch[attribs[i].vertex_buffer_index] += swr_desc.Bpp;
       }
+
+      velems->fsState.bDisableVGATHER = num_elements > 0;
+      for (unsigned i = 0; i < num_elements; i++) {
+         if (!swr_can_fetch_without_gather(velems->fsState.layout[i]))
+            velems->fsState.bDisableVGATHER = false;
+      }
    }
 
    return velems;
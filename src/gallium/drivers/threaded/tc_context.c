@@ -0,0 +1,1720 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#include "tc_pipe.h"
+#include "util/u_format.h"
+#include "util/u_framebuffer.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+
+
+/********************************************************************
+ * batches
+ */
+
+static void
+tc_batch_execute(void *job, int thread_index)
+{
+   struct tc_batch *batch = job;
+   struct pipe_context *pipe = batch->pipe;
+   uint64_t *iter = batch->slots;
+   uint64_t *end = batch->slots + batch->num_total_call_slots;
+
+   while (iter < end) {
+      struct tc_call *call = (struct tc_call *)iter;
+
+      call->execute(pipe, call + 1);
+      iter += call->num_call_slots;
+   }
+
+   batch->num_total_call_slots = 0;
+}
+
+static void
+tc_batch_flush(struct threaded_context *tc)
+{
+   struct tc_batch *next = &tc->batch_slots[tc->next];
+
+   if (!next->num_total_call_slots)
+      return;
+
+   util_queue_add_job(&tc->queue, next, &next->fence, tc_batch_execute);
+   tc->next = (tc->next + 1) % TC_MAX_BATCHES;
+
+   /* The next batch may still be being executed. */
+   util_queue_job_wait(&tc->batch_slots[tc->next].fence);
+}
+
+/**
+ * Return true if a call with a payload of the given size can be recorded.
+ * Larger calls must be executed synchronously.
+ */
+static inline bool
+tc_fits(unsigned payload_size)
+{
+   return TC_CALL_SLOTS(payload_size) <= TC_SLOTS_PER_BATCH;
+}
+
+/**
+ * Record a call and return a pointer to its payload, which the caller
+ * must fill in.
+ */
+static void *
+tc_add_call(struct threaded_context *tc, tc_execute execute,
+            unsigned payload_size)
+{
+   struct tc_batch *next = &tc->batch_slots[tc->next];
+   unsigned num_call_slots = TC_CALL_SLOTS(payload_size);
+   struct tc_call *call;
+
+   assert(tc_fits(payload_size));
+
+   if (next->num_total_call_slots + num_call_slots > TC_SLOTS_PER_BATCH) {
+      tc_batch_flush(tc);
+      next = &tc->batch_slots[tc->next];
+   }
+
+   call = (struct tc_call *)&next->slots[next->num_total_call_slots];
+   call->execute = execute;
+   call->num_call_slots = num_call_slots;
+   next->num_total_call_slots += num_call_slots;
+   return call + 1;
+}
+
+/**
+ * Wait until the driver thread has executed all recorded calls, so that
+ * the driver can be called directly.
+ */
+static void
+tc_sync(struct threaded_context *tc)
+{
+   unsigned i;
+
+   tc_batch_flush(tc);
+
+   for (i = 0; i < TC_MAX_BATCHES; i++)
+      util_queue_job_wait(&tc->batch_slots[i].fence);
+}
+
+
+/********************************************************************
+ * simple functions
+ */
+
+/* Functions taking one CSO or another opaque pointer. */
+#define TC_FUNC_PTR(func) \
+   static void \
+   tc_call_##func(struct pipe_context *pipe, void *payload) \
+   { \
+      pipe->func(pipe, *(void **)payload); \
+   } \
+   \
+   static void \
+   tc_##func(struct pipe_context *_pipe, void *state) \
+   { \
+      struct threaded_context *tc = threaded_context(_pipe); \
+      *(void **)tc_add_call(tc, tc_call_##func, sizeof(void *)) = state; \
+   }
+
+/* Functions taking a pointer to a small self-contained structure. */
+#define TC_FUNC_STRUCT(func, type) \
+   static void \
+   tc_call_##func(struct pipe_context *pipe, void *payload) \
+   { \
+      pipe->func(pipe, (type *)payload); \
+   } \
+   \
+   static void \
+   tc_##func(struct pipe_context *_pipe, const type *state) \
+   { \
+      struct threaded_context *tc = threaded_context(_pipe); \
+      *(type *)tc_add_call(tc, tc_call_##func, sizeof(type)) = *state; \
+   }
+
+/* Functions taking one unsigned integer. */
+#define TC_FUNC_UINT(func) \
+   static void \
+   tc_call_##func(struct pipe_context *pipe, void *payload) \
+   { \
+      pipe->func(pipe, *(unsigned *)payload); \
+   } \
+   \
+   static void \
+   tc_##func(struct pipe_context *_pipe, unsigned value) \
+   { \
+      struct threaded_context *tc = threaded_context(_pipe); \
+      *(unsigned *)tc_add_call(tc, tc_call_##func, sizeof(unsigned)) = value; \
+   }
+
+TC_FUNC_PTR(bind_blend_state)
+TC_FUNC_PTR(delete_blend_state)
+TC_FUNC_PTR(delete_sampler_state)
+TC_FUNC_PTR(bind_rasterizer_state)
+TC_FUNC_PTR(delete_rasterizer_state)
+TC_FUNC_PTR(bind_depth_stencil_alpha_state)
+TC_FUNC_PTR(delete_depth_stencil_alpha_state)
+TC_FUNC_PTR(bind_fs_state)
+TC_FUNC_PTR(delete_fs_state)
+TC_FUNC_PTR(bind_vs_state)
+TC_FUNC_PTR(delete_vs_state)
+TC_FUNC_PTR(bind_gs_state)
+TC_FUNC_PTR(delete_gs_state)
+TC_FUNC_PTR(bind_tcs_state)
+TC_FUNC_PTR(delete_tcs_state)
+TC_FUNC_PTR(bind_tes_state)
+TC_FUNC_PTR(delete_tes_state)
+TC_FUNC_PTR(bind_vertex_elements_state)
+TC_FUNC_PTR(delete_vertex_elements_state)
+TC_FUNC_PTR(bind_compute_state)
+TC_FUNC_PTR(delete_compute_state)
+
+TC_FUNC_STRUCT(set_blend_color, struct pipe_blend_color)
+TC_FUNC_STRUCT(set_stencil_ref, struct pipe_stencil_ref)
+TC_FUNC_STRUCT(set_clip_state, struct pipe_clip_state)
+TC_FUNC_STRUCT(set_polygon_stipple, struct pipe_poly_stipple)
+
+TC_FUNC_UINT(set_sample_mask)
+TC_FUNC_UINT(set_min_samples)
+TC_FUNC_UINT(memory_barrier)
+
+#undef TC_FUNC_PTR
+#undef TC_FUNC_STRUCT
+#undef TC_FUNC_UINT
+
+static void
+tc_call_texture_barrier(struct pipe_context *pipe, void *payload)
+{
+   pipe->texture_barrier(pipe);
+}
+
+static void
+tc_texture_barrier(struct pipe_context *_pipe)
+{
+   tc_add_call(threaded_context(_pipe), tc_call_texture_barrier, 0);
+}
+
+
+/********************************************************************
+ * object creation
+ *
+ * Creating objects is synchronous, because drivers are free to use
+ * the context in their create functions.
+ */
+
+#define TC_CREATE_CSO(func, type) \
+   static void * \
+   tc_##func(struct pipe_context *_pipe, const type *state) \
+   { \
+      struct threaded_context *tc = threaded_context(_pipe); \
+      \
+      tc_sync(tc); \
+      return tc->pipe->func(tc->pipe, state); \
+   }
+
+TC_CREATE_CSO(create_blend_state, struct pipe_blend_state)
+TC_CREATE_CSO(create_sampler_state, struct pipe_sampler_state)
+TC_CREATE_CSO(create_rasterizer_state, struct pipe_rasterizer_state)
+TC_CREATE_CSO(create_depth_stencil_alpha_state,
+              struct pipe_depth_stencil_alpha_state)
+TC_CREATE_CSO(create_fs_state, struct pipe_shader_state)
+TC_CREATE_CSO(create_vs_state, struct pipe_shader_state)
+TC_CREATE_CSO(create_gs_state, struct pipe_shader_state)
+TC_CREATE_CSO(create_tcs_state, struct pipe_shader_state)
+TC_CREATE_CSO(create_tes_state, struct pipe_shader_state)
+TC_CREATE_CSO(create_compute_state, struct pipe_compute_state)
+
+#undef TC_CREATE_CSO
+
+static void *
+tc_create_vertex_elements_state(struct pipe_context *_pipe,
+                                unsigned num_elements,
+                                const struct pipe_vertex_element *elems)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->create_vertex_elements_state(tc->pipe, num_elements,
+                                                 elems);
+}
+
+/* Sampler views, surfaces and stream output targets point to the wrapper,
+ * so that pipe_*_reference ends up here. Such objects are only destroyed
+ * when nothing references them anymore, including recorded calls, so the
+ * driver can free them directly from any thread.
+ */
+static struct pipe_sampler_view *
+tc_create_sampler_view(struct pipe_context *_pipe,
+                       struct pipe_resource *resource,
+                       const struct pipe_sampler_view *templ)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_sampler_view *view;
+
+   tc_sync(tc);
+   view = tc->pipe->create_sampler_view(tc->pipe, resource, templ);
+   if (view)
+      view->context = _pipe;
+   return view;
+}
+
+static void
+tc_sampler_view_destroy(struct pipe_context *_pipe,
+                        struct pipe_sampler_view *view)
+{
+   struct pipe_context *pipe = threaded_context(_pipe)->pipe;
+
+   pipe->sampler_view_destroy(pipe, view);
+}
+
+static struct pipe_surface *
+tc_create_surface(struct pipe_context *_pipe,
+                  struct pipe_resource *resource,
+                  const struct pipe_surface *surf_tmpl)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_surface *surf;
+
+   tc_sync(tc);
+   surf = tc->pipe->create_surface(tc->pipe, resource, surf_tmpl);
+   if (surf)
+      surf->context = _pipe;
+   return surf;
+}
+
+static void
+tc_surface_destroy(struct pipe_context *_pipe, struct pipe_surface *surf)
+{
+   struct pipe_context *pipe = threaded_context(_pipe)->pipe;
+
+   pipe->surface_destroy(pipe, surf);
+}
+
+static struct pipe_stream_output_target *
+tc_create_stream_output_target(struct pipe_context *_pipe,
+                               struct pipe_resource *res,
+                               unsigned buffer_offset,
+                               unsigned buffer_size)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_stream_output_target *target;
+
+   tc_sync(tc);
+   target = tc->pipe->create_stream_output_target(tc->pipe, res,
+                                                  buffer_offset, buffer_size);
+   if (target)
+      target->context = _pipe;
+   return target;
+}
+
+static void
+tc_stream_output_target_destroy(struct pipe_context *_pipe,
+                                struct pipe_stream_output_target *target)
+{
+   struct pipe_context *pipe = threaded_context(_pipe)->pipe;
+
+   pipe->stream_output_target_destroy(pipe, target);
+}
+
+static struct pipe_video_codec *
+tc_create_video_codec(struct pipe_context *_pipe,
+                      const struct pipe_video_codec *templ)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->create_video_codec(tc->pipe, templ);
+}
+
+static struct pipe_video_buffer *
+tc_create_video_buffer(struct pipe_context *_pipe,
+                       const struct pipe_video_buffer *templ)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->create_video_buffer(tc->pipe, templ);
+}
+
+
+/********************************************************************
+ * queries
+ */
+
+static struct pipe_query *
+tc_create_query(struct pipe_context *_pipe, unsigned query_type,
+                unsigned index)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->create_query(tc->pipe, query_type, index);
+}
+
+static struct pipe_query *
+tc_create_batch_query(struct pipe_context *_pipe, unsigned num_queries,
+                      unsigned *query_types)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->create_batch_query(tc->pipe, num_queries, query_types);
+}
+
+static void
+tc_call_destroy_query(struct pipe_context *pipe, void *payload)
+{
+   pipe->destroy_query(pipe, *(struct pipe_query **)payload);
+}
+
+static void
+tc_destroy_query(struct pipe_context *_pipe, struct pipe_query *query)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   *(struct pipe_query **)
+      tc_add_call(tc, tc_call_destroy_query, sizeof(query)) = query;
+}
+
+static void
+tc_call_begin_query(struct pipe_context *pipe, void *payload)
+{
+   pipe->begin_query(pipe, *(struct pipe_query **)payload);
+}
+
+static boolean
+tc_begin_query(struct pipe_context *_pipe, struct pipe_query *query)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   *(struct pipe_query **)
+      tc_add_call(tc, tc_call_begin_query, sizeof(query)) = query;
+   return true; /* we don't care about the return value */
+}
+
+static void
+tc_call_end_query(struct pipe_context *pipe, void *payload)
+{
+   pipe->end_query(pipe, *(struct pipe_query **)payload);
+}
+
+static bool
+tc_end_query(struct pipe_context *_pipe, struct pipe_query *query)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   *(struct pipe_query **)
+      tc_add_call(tc, tc_call_end_query, sizeof(query)) = query;
+   return true; /* we don't care about the return value */
+}
+
+static boolean
+tc_get_query_result(struct pipe_context *_pipe, struct pipe_query *query,
+                    boolean wait, union pipe_query_result *result)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->get_query_result(tc->pipe, query, wait, result);
+}
+
+struct tc_query_result_resource {
+   struct pipe_query *query;
+   boolean wait;
+   enum pipe_query_value_type result_type;
+   int index;
+   struct pipe_resource *resource;
+   unsigned offset;
+};
+
+static void
+tc_call_get_query_result_resource(struct pipe_context *pipe, void *payload)
+{
+   struct tc_query_result_resource *p = payload;
+
+   pipe->get_query_result_resource(pipe, p->query, p->wait, p->result_type,
+                                   p->index, p->resource, p->offset);
+   pipe_resource_reference(&p->resource, NULL);
+}
+
+static void
+tc_get_query_result_resource(struct pipe_context *_pipe,
+                             struct pipe_query *query, boolean wait,
+                             enum pipe_query_value_type result_type,
+                             int index, struct pipe_resource *resource,
+                             unsigned offset)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_query_result_resource *p =
+      tc_add_call(tc, tc_call_get_query_result_resource, sizeof(*p));
+
+   p->query = query;
+   p->wait = wait;
+   p->result_type = result_type;
+   p->index = index;
+   p->resource = NULL;
+   pipe_resource_reference(&p->resource, resource);
+   p->offset = offset;
+}
+
+static void
+tc_call_set_active_query_state(struct pipe_context *pipe, void *payload)
+{
+   pipe->set_active_query_state(pipe, *(boolean *)payload);
+}
+
+static void
+tc_set_active_query_state(struct pipe_context *_pipe, boolean enable)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   *(boolean *)
+      tc_add_call(tc, tc_call_set_active_query_state, sizeof(enable)) = enable;
+}
+
+struct tc_render_condition {
+   struct pipe_query *query;
+   boolean condition;
+   uint mode;
+};
+
+static void
+tc_call_render_condition(struct pipe_context *pipe, void *payload)
+{
+   struct tc_render_condition *p = payload;
+
+   pipe->render_condition(pipe, p->query, p->condition, p->mode);
+}
+
+static void
+tc_render_condition(struct pipe_context *_pipe, struct pipe_query *query,
+                    boolean condition, uint mode)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_render_condition *p =
+      tc_add_call(tc, tc_call_render_condition, sizeof(*p));
+
+   p->query = query;
+   p->condition = condition;
+   p->mode = mode;
+}
+
+
+/********************************************************************
+ * state
+ */
+
+struct tc_sampler_states {
+   unsigned shader, start, count;
+   void *slot[PIPE_MAX_SAMPLERS]; /* only "count" elements are recorded */
+};
+
+static void
+tc_call_bind_sampler_states(struct pipe_context *pipe, void *payload)
+{
+   struct tc_sampler_states *p = payload;
+
+   pipe->bind_sampler_states(pipe, p->shader, p->start, p->count, p->slot);
+}
+
+static void
+tc_bind_sampler_states(struct pipe_context *_pipe, unsigned shader,
+                       unsigned start, unsigned count, void **states)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_sampler_states *p;
+
+   assert(count <= PIPE_MAX_SAMPLERS);
+   p = tc_add_call(tc, tc_call_bind_sampler_states,
+                   offsetof(struct tc_sampler_states, slot) +
+                   count * sizeof(void *));
+   p->shader = shader;
+   p->start = start;
+   p->count = count;
+   if (states)
+      memcpy(p->slot, states, count * sizeof(void *));
+   else
+      memset(p->slot, 0, count * sizeof(void *));
+}
+
+static void
+tc_call_set_framebuffer_state(struct pipe_context *pipe, void *payload)
+{
+   struct pipe_framebuffer_state *p = payload;
+
+   pipe->set_framebuffer_state(pipe, p);
+   util_unreference_framebuffer_state(p);
+}
+
+static void
+tc_set_framebuffer_state(struct pipe_context *_pipe,
+                         const struct pipe_framebuffer_state *fb)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_framebuffer_state *p =
+      tc_add_call(tc, tc_call_set_framebuffer_state, sizeof(*p));
+
+   memset(p, 0, sizeof(*p));
+   util_copy_framebuffer_state(p, fb);
+}
+
+struct tc_constant_buffer {
+   uint shader, index;
+   bool is_null;
+   struct pipe_constant_buffer cb;
+   /* user_buffer contents follow */
+};
+
+static void
+tc_call_set_constant_buffer(struct pipe_context *pipe, void *payload)
+{
+   struct tc_constant_buffer *p = payload;
+
+   if (p->is_null) {
+      pipe->set_constant_buffer(pipe, p->shader, p->index, NULL);
+      return;
+   }
+
+   if (p->cb.user_buffer)
+      p->cb.user_buffer = p + 1;
+
+   pipe->set_constant_buffer(pipe, p->shader, p->index, &p->cb);
+   pipe_resource_reference(&p->cb.buffer, NULL);
+}
+
+static void
+tc_set_constant_buffer(struct pipe_context *_pipe, uint shader, uint index,
+                       struct pipe_constant_buffer *cb)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   unsigned user_size = cb && cb->user_buffer ? cb->buffer_size : 0;
+   struct tc_constant_buffer *p;
+
+   /* User constant buffers are copied, because they may be changed as soon
+    * as this returns.
+    */
+   if (!tc_fits(sizeof(*p) + user_size)) {
+      tc_sync(tc);
+      tc->pipe->set_constant_buffer(tc->pipe, shader, index, cb);
+      return;
+   }
+
+   p = tc_add_call(tc, tc_call_set_constant_buffer, sizeof(*p) + user_size);
+   p->shader = shader;
+   p->index = index;
+   p->is_null = cb == NULL;
+
+   if (cb) {
+      p->cb = *cb;
+      p->cb.buffer = NULL;
+      pipe_resource_reference(&p->cb.buffer, cb->buffer);
+
+      if (cb->user_buffer)
+         memcpy(p + 1, cb->user_buffer, user_size);
+   }
+}
+
+struct tc_scissors {
+   unsigned start, count;
+   struct pipe_scissor_state slot[PIPE_MAX_VIEWPORTS];
+};
+
+static void
+tc_call_set_scissor_states(struct pipe_context *pipe, void *payload)
+{
+   struct tc_scissors *p = payload;
+
+   pipe->set_scissor_states(pipe, p->start, p->count, p->slot);
+}
+
+static void
+tc_set_scissor_states(struct pipe_context *_pipe, unsigned start,
+                      unsigned count, const struct pipe_scissor_state *states)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_scissors *p;
+
+   assert(count <= PIPE_MAX_VIEWPORTS);
+   p = tc_add_call(tc, tc_call_set_scissor_states,
+                   offsetof(struct tc_scissors, slot) +
+                   count * sizeof(states[0]));
+   p->start = start;
+   p->count = count;
+   memcpy(p->slot, states, count * sizeof(states[0]));
+}
+
+struct tc_viewports {
+   unsigned start, count;
+   struct pipe_viewport_state slot[PIPE_MAX_VIEWPORTS];
+};
+
+static void
+tc_call_set_viewport_states(struct pipe_context *pipe, void *payload)
+{
+   struct tc_viewports *p = payload;
+
+   pipe->set_viewport_states(pipe, p->start, p->count, p->slot);
+}
+
+static void
+tc_set_viewport_states(struct pipe_context *_pipe, unsigned start,
+                       unsigned count, const struct pipe_viewport_state *states)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_viewports *p;
+
+   assert(count <= PIPE_MAX_VIEWPORTS);
+   p = tc_add_call(tc, tc_call_set_viewport_states,
+                   offsetof(struct tc_viewports, slot) +
+                   count * sizeof(states[0]));
+   p->start = start;
+   p->count = count;
+   memcpy(p->slot, states, count * sizeof(states[0]));
+}
+
+struct tc_tess_state {
+   float default_outer_level[4];
+   float default_inner_level[2];
+};
+
+static void
+tc_call_set_tess_state(struct pipe_context *pipe, void *payload)
+{
+   struct tc_tess_state *p = payload;
+
+   pipe->set_tess_state(pipe, p->default_outer_level, p->default_inner_level);
+}
+
+static void
+tc_set_tess_state(struct pipe_context *_pipe,
+                  const float default_outer_level[4],
+                  const float default_inner_level[2])
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_tess_state *p =
+      tc_add_call(tc, tc_call_set_tess_state, sizeof(*p));
+
+   memcpy(p->default_outer_level, default_outer_level,
+          sizeof(p->default_outer_level));
+   memcpy(p->default_inner_level, default_inner_level,
+          sizeof(p->default_inner_level));
+}
+
+struct tc_sampler_views {
+   unsigned shader, start, count;
+   struct pipe_sampler_view *slot[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+};
+
+static void
+tc_call_set_sampler_views(struct pipe_context *pipe, void *payload)
+{
+   struct tc_sampler_views *p = payload;
+   unsigned i;
+
+   pipe->set_sampler_views(pipe, p->shader, p->start, p->count, p->slot);
+   for (i = 0; i < p->count; i++)
+      pipe_sampler_view_reference(&p->slot[i], NULL);
+}
+
+static void
+tc_set_sampler_views(struct pipe_context *_pipe, unsigned shader,
+                     unsigned start, unsigned count,
+                     struct pipe_sampler_view **views)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_sampler_views *p;
+   unsigned i;
+
+   assert(count <= PIPE_MAX_SHADER_SAMPLER_VIEWS);
+   p = tc_add_call(tc, tc_call_set_sampler_views,
+                   offsetof(struct tc_sampler_views, slot) +
+                   count * sizeof(views[0]));
+   p->shader = shader;
+   p->start = start;
+   p->count = count;
+
+   for (i = 0; i < count; i++) {
+      p->slot[i] = NULL;
+      pipe_sampler_view_reference(&p->slot[i], views ? views[i] : NULL);
+   }
+}
+
+struct tc_shader_buffers {
+   unsigned shader, start, count;
+   bool unbind;
+   struct pipe_shader_buffer slot[PIPE_MAX_SHADER_BUFFERS];
+};
+
+static void
+tc_call_set_shader_buffers(struct pipe_context *pipe, void *payload)
+{
+   struct tc_shader_buffers *p = payload;
+   unsigned i;
+
+   if (p->unbind) {
+      pipe->set_shader_buffers(pipe, p->shader, p->start, p->count, NULL);
+      return;
+   }
+
+   pipe->set_shader_buffers(pipe, p->shader, p->start, p->count, p->slot);
+   for (i = 0; i < p->count; i++)
+      pipe_resource_reference(&p->slot[i].buffer, NULL);
+}
+
+static void
+tc_set_shader_buffers(struct pipe_context *_pipe, unsigned shader,
+                      unsigned start, unsigned count,
+                      struct pipe_shader_buffer *buffers)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_shader_buffers *p;
+   unsigned i;
+
+   assert(count <= PIPE_MAX_SHADER_BUFFERS);
+   p = tc_add_call(tc, tc_call_set_shader_buffers,
+                   offsetof(struct tc_shader_buffers, slot) +
+                   (buffers ? count * sizeof(buffers[0]) : 0));
+   p->shader = shader;
+   p->start = start;
+   p->count = count;
+   p->unbind = buffers == NULL;
+
+   if (buffers) {
+      for (i = 0; i < count; i++) {
+         p->slot[i] = buffers[i];
+         p->slot[i].buffer = NULL;
+         pipe_resource_reference(&p->slot[i].buffer, buffers[i].buffer);
+      }
+   }
+}
+
+struct tc_shader_images {
+   unsigned shader, start, count;
+   bool unbind;
+   struct pipe_image_view slot[PIPE_MAX_SHADER_IMAGES];
+};
+
+static void
+tc_call_set_shader_images(struct pipe_context *pipe, void *payload)
+{
+   struct tc_shader_images *p = payload;
+   unsigned i;
+
+   if (p->unbind) {
+      pipe->set_shader_images(pipe, p->shader, p->start, p->count, NULL);
+      return;
+   }
+
+   pipe->set_shader_images(pipe, p->shader, p->start, p->count, p->slot);
+   for (i = 0; i < p->count; i++)
+      pipe_resource_reference(&p->slot[i].resource, NULL);
+}
+
+static void
+tc_set_shader_images(struct pipe_context *_pipe, unsigned shader,
+                     unsigned start, unsigned count,
+                     struct pipe_image_view *images)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_shader_images *p;
+   unsigned i;
+
+   assert(count <= PIPE_MAX_SHADER_IMAGES);
+   p = tc_add_call(tc, tc_call_set_shader_images,
+                   offsetof(struct tc_shader_images, slot) +
+                   (images ? count * sizeof(images[0]) : 0));
+   p->shader = shader;
+   p->start = start;
+   p->count = count;
+   p->unbind = images == NULL;
+
+   if (images) {
+      for (i = 0; i < count; i++) {
+         p->slot[i] = images[i];
+         p->slot[i].resource = NULL;
+         pipe_resource_reference(&p->slot[i].resource, images[i].resource);
+      }
+   }
+}
+
+struct tc_vertex_buffers {
+   unsigned start, count;
+   bool unbind;
+   struct pipe_vertex_buffer slot[PIPE_MAX_ATTRIBS];
+};
+
+static void
+tc_call_set_vertex_buffers(struct pipe_context *pipe, void *payload)
+{
+   struct tc_vertex_buffers *p = payload;
+   unsigned i;
+
+   if (p->unbind) {
+      pipe->set_vertex_buffers(pipe, p->start, p->count, NULL);
+      return;
+   }
+
+   pipe->set_vertex_buffers(pipe, p->start, p->count, p->slot);
+   for (i = 0; i < p->count; i++)
+      pipe_resource_reference(&p->slot[i].buffer, NULL);
+}
+
+static void
+tc_set_vertex_buffers(struct pipe_context *_pipe, unsigned start,
+                      unsigned count, const struct pipe_vertex_buffer *buffers)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_vertex_buffers *p;
+   uint32_t user_mask = 0;
+   uint32_t slot_mask;
+   unsigned i;
+
+   assert(start + count <= PIPE_MAX_ATTRIBS);
+   slot_mask = u_bit_consecutive(start, count);
+
+   if (buffers) {
+      for (i = 0; i < count; i++)
+         if (buffers[i].user_buffer)
+            user_mask |= 1u << (start + i);
+   }
+
+   tc->user_vertex_buffer_mask =
+      (tc->user_vertex_buffer_mask & ~slot_mask) | user_mask;
+
+   /* User buffers are only referenced by pointer, so binding them doesn't
+    * need to be synchronous. Draws with them bound are.
+    */
+   p = tc_add_call(tc, tc_call_set_vertex_buffers,
+                   offsetof(struct tc_vertex_buffers, slot) +
+                   (buffers ? count * sizeof(buffers[0]) : 0));
+   p->start = start;
+   p->count = count;
+   p->unbind = buffers == NULL;
+
+   if (buffers) {
+      for (i = 0; i < count; i++) {
+         p->slot[i] = buffers[i];
+         p->slot[i].buffer = NULL;
+         pipe_resource_reference(&p->slot[i].buffer, buffers[i].buffer);
+      }
+   }
+}
+
+struct tc_index_buffer {
+   bool unbind;
+   struct pipe_index_buffer ib;
+};
+
+static void
+tc_call_set_index_buffer(struct pipe_context *pipe, void *payload)
+{
+   struct tc_index_buffer *p = payload;
+
+   if (p->unbind) {
+      pipe->set_index_buffer(pipe, NULL);
+      return;
+   }
+
+   pipe->set_index_buffer(pipe, &p->ib);
+   pipe_resource_reference(&p->ib.buffer, NULL);
+}
+
+static void
+tc_set_index_buffer(struct pipe_context *_pipe,
+                    const struct pipe_index_buffer *ib)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_index_buffer *p =
+      tc_add_call(tc, tc_call_set_index_buffer, sizeof(*p));
+
+   tc->user_index_buffer = ib && ib->user_buffer;
+   p->unbind = ib == NULL;
+
+   if (ib) {
+      p->ib = *ib;
+      p->ib.buffer = NULL;
+      pipe_resource_reference(&p->ib.buffer, ib->buffer);
+   }
+}
+
+struct tc_so_targets {
+   unsigned count;
+   struct pipe_stream_output_target *targets[PIPE_MAX_SO_BUFFERS];
+   unsigned offsets[PIPE_MAX_SO_BUFFERS];
+};
+
+static void
+tc_call_set_stream_output_targets(struct pipe_context *pipe, void *payload)
+{
+   struct tc_so_targets *p = payload;
+   unsigned i;
+
+   pipe->set_stream_output_targets(pipe, p->count, p->targets, p->offsets);
+   for (i = 0; i < p->count; i++)
+      pipe_so_target_reference(&p->targets[i], NULL);
+}
+
+static void
+tc_set_stream_output_targets(struct pipe_context *_pipe, unsigned count,
+                             struct pipe_stream_output_target **targets,
+                             const unsigned *offsets)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_so_targets *p =
+      tc_add_call(tc, tc_call_set_stream_output_targets, sizeof(*p));
+   unsigned i;
+
+   assert(count <= PIPE_MAX_SO_BUFFERS);
+   p->count = count;
+
+   for (i = 0; i < count; i++) {
+      p->targets[i] = NULL;
+      pipe_so_target_reference(&p->targets[i], targets[i]);
+      p->offsets[i] = offsets ? offsets[i] : 0;
+   }
+}
+
+static void
+tc_set_debug_callback(struct pipe_context *_pipe,
+                      const struct pipe_debug_callback *cb)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   tc->pipe->set_debug_callback(tc->pipe, cb);
+}
+
+static void
+tc_set_compute_resources(struct pipe_context *_pipe, unsigned start,
+                         unsigned count, struct pipe_surface **resources)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   tc->pipe->set_compute_resources(tc->pipe, start, count, resources);
+}
+
+static void
+tc_set_global_binding(struct pipe_context *_pipe, unsigned first,
+                      unsigned count, struct pipe_resource **resources,
+                      uint32_t **handles)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   /* The driver writes the handles. */
+   tc_sync(tc);
+   tc->pipe->set_global_binding(tc->pipe, first, count, resources, handles);
+}
+
+
+/********************************************************************
+ * transfers
+ *
+ * Mapping is synchronous, because the driver must see all prior
+ * rendering to decide whether to stall or to reallocate the storage.
+ * Unmapping can be recorded, because the caller doesn't access the
+ * mapping afterwards.
+ */
+
+static void *
+tc_transfer_map(struct pipe_context *_pipe, struct pipe_resource *resource,
+                unsigned level, unsigned usage, const struct pipe_box *box,
+                struct pipe_transfer **transfer)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->transfer_map(tc->pipe, resource, level, usage, box,
+                                 transfer);
+}
+
+struct tc_transfer_flush_region {
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+};
+
+static void
+tc_call_transfer_flush_region(struct pipe_context *pipe, void *payload)
+{
+   struct tc_transfer_flush_region *p = payload;
+
+   pipe->transfer_flush_region(pipe, p->transfer, &p->box);
+}
+
+static void
+tc_transfer_flush_region(struct pipe_context *_pipe,
+                         struct pipe_transfer *transfer,
+                         const struct pipe_box *box)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_transfer_flush_region *p =
+      tc_add_call(tc, tc_call_transfer_flush_region, sizeof(*p));
+
+   p->transfer = transfer;
+   p->box = *box;
+}
+
+static void
+tc_call_transfer_unmap(struct pipe_context *pipe, void *payload)
+{
+   pipe->transfer_unmap(pipe, *(struct pipe_transfer **)payload);
+}
+
+static void
+tc_transfer_unmap(struct pipe_context *_pipe, struct pipe_transfer *transfer)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   *(struct pipe_transfer **)
+      tc_add_call(tc, tc_call_transfer_unmap, sizeof(transfer)) = transfer;
+}
+
+struct tc_buffer_write {
+   struct pipe_resource *resource;
+   unsigned usage;
+   struct pipe_box box;
+   /* data follows */
+};
+
+static void
+tc_call_buffer_write(struct pipe_context *pipe, void *payload)
+{
+   struct tc_buffer_write *p = payload;
+
+   pipe->transfer_inline_write(pipe, p->resource, 0, p->usage, &p->box,
+                               p + 1, 0, 0);
+   pipe_resource_reference(&p->resource, NULL);
+}
+
+static void
+tc_transfer_inline_write(struct pipe_context *_pipe,
+                         struct pipe_resource *resource,
+                         unsigned level, unsigned usage,
+                         const struct pipe_box *box,
+                         const void *data, unsigned stride,
+                         unsigned layer_stride)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_buffer_write *p;
+
+   /* Small buffer uploads are copied and recorded. */
+   if (resource->target != PIPE_BUFFER ||
+       !tc_fits(sizeof(*p) + box->width)) {
+      tc_sync(tc);
+      tc->pipe->transfer_inline_write(tc->pipe, resource, level, usage, box,
+                                      data, stride, layer_stride);
+      return;
+   }
+
+   p = tc_add_call(tc, tc_call_buffer_write, sizeof(*p) + box->width);
+   p->resource = NULL;
+   pipe_resource_reference(&p->resource, resource);
+   p->usage = usage;
+   p->box = *box;
+   memcpy(p + 1, data, box->width);
+}
+
+
+/********************************************************************
+ * draw, launch, clear, blit, copy, flush
+ */
+
+static void
+tc_call_draw_vbo(struct pipe_context *pipe, void *payload)
+{
+   struct pipe_draw_info *info = payload;
+
+   pipe->draw_vbo(pipe, info);
+   pipe_so_target_reference(&info->count_from_stream_output, NULL);
+   pipe_resource_reference(&info->indirect, NULL);
+   pipe_resource_reference(&info->indirect_params, NULL);
+}
+
+static void
+tc_draw_vbo(struct pipe_context *_pipe, const struct pipe_draw_info *info)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_draw_info *p;
+
+   /* User buffers may be changed by the caller as soon as this returns. */
+   if (unlikely(tc->user_vertex_buffer_mask ||
+                (info->indexed && tc->user_index_buffer))) {
+      tc_sync(tc);
+      tc->pipe->draw_vbo(tc->pipe, info);
+      return;
+   }
+
+   p = tc_add_call(tc, tc_call_draw_vbo, sizeof(*p));
+   *p = *info;
+   p->count_from_stream_output = NULL;
+   p->indirect = NULL;
+   p->indirect_params = NULL;
+   pipe_so_target_reference(&p->count_from_stream_output,
+                            info->count_from_stream_output);
+   pipe_resource_reference(&p->indirect, info->indirect);
+   pipe_resource_reference(&p->indirect_params, info->indirect_params);
+}
+
+static void
+tc_call_launch_grid(struct pipe_context *pipe, void *payload)
+{
+   struct pipe_grid_info *info = payload;
+
+   pipe->launch_grid(pipe, info);
+   pipe_resource_reference(&info->indirect, NULL);
+}
+
+static void
+tc_launch_grid(struct pipe_context *_pipe, const struct pipe_grid_info *info)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_grid_info *p;
+
+   /* The size of the kernel input isn't known here. */
+   if (info->input) {
+      tc_sync(tc);
+      tc->pipe->launch_grid(tc->pipe, info);
+      return;
+   }
+
+   p = tc_add_call(tc, tc_call_launch_grid, sizeof(*p));
+   *p = *info;
+   p->indirect = NULL;
+   pipe_resource_reference(&p->indirect, info->indirect);
+}
+
+struct tc_clear {
+   unsigned buffers;
+   union pipe_color_union color;
+   double depth;
+   unsigned stencil;
+};
+
+static void
+tc_call_clear(struct pipe_context *pipe, void *payload)
+{
+   struct tc_clear *p = payload;
+
+   pipe->clear(pipe, p->buffers, &p->color, p->depth, p->stencil);
+}
+
+static void
+tc_clear(struct pipe_context *_pipe, unsigned buffers,
+         const union pipe_color_union *color, double depth, unsigned stencil)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_clear *p = tc_add_call(tc, tc_call_clear, sizeof(*p));
+
+   p->buffers = buffers;
+   if (color)
+      p->color = *color;
+   p->depth = depth;
+   p->stencil = stencil;
+}
+
+struct tc_clear_surface {
+   struct pipe_surface *dst;
+   union pipe_color_union color;
+   unsigned clear_flags;
+   double depth;
+   unsigned stencil;
+   unsigned dstx, dsty, width, height;
+};
+
+static void
+tc_call_clear_render_target(struct pipe_context *pipe, void *payload)
+{
+   struct tc_clear_surface *p = payload;
+
+   pipe->clear_render_target(pipe, p->dst, &p->color, p->dstx, p->dsty,
+                             p->width, p->height);
+   pipe_surface_reference(&p->dst, NULL);
+}
+
+static void
+tc_clear_render_target(struct pipe_context *_pipe, struct pipe_surface *dst,
+                       const union pipe_color_union *color,
+                       unsigned dstx, unsigned dsty,
+                       unsigned width, unsigned height)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_clear_surface *p =
+      tc_add_call(tc, tc_call_clear_render_target, sizeof(*p));
+
+   p->dst = NULL;
+   pipe_surface_reference(&p->dst, dst);
+   p->color = *color;
+   p->dstx = dstx;
+   p->dsty = dsty;
+   p->width = width;
+   p->height = height;
+}
+
+static void
+tc_call_clear_depth_stencil(struct pipe_context *pipe, void *payload)
+{
+   struct tc_clear_surface *p = payload;
+
+   pipe->clear_depth_stencil(pipe, p->dst, p->clear_flags, p->depth,
+                             p->stencil, p->dstx, p->dsty,
+                             p->width, p->height);
+   pipe_surface_reference(&p->dst, NULL);
+}
+
+static void
+tc_clear_depth_stencil(struct pipe_context *_pipe, struct pipe_surface *dst,
+                       unsigned clear_flags, double depth, unsigned stencil,
+                       unsigned dstx, unsigned dsty,
+                       unsigned width, unsigned height)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_clear_surface *p =
+      tc_add_call(tc, tc_call_clear_depth_stencil, sizeof(*p));
+
+   p->dst = NULL;
+   pipe_surface_reference(&p->dst, dst);
+   p->clear_flags = clear_flags;
+   p->depth = depth;
+   p->stencil = stencil;
+   p->dstx = dstx;
+   p->dsty = dsty;
+   p->width = width;
+   p->height = height;
+}
+
+struct tc_clear_texture {
+   struct pipe_resource *res;
+   unsigned level;
+   struct pipe_box box;
+   uint64_t data[2]; /* one texel, at most 16 bytes */
+};
+
+static void
+tc_call_clear_texture(struct pipe_context *pipe, void *payload)
+{
+   struct tc_clear_texture *p = payload;
+
+   pipe->clear_texture(pipe, p->res, p->level, &p->box, p->data);
+   pipe_resource_reference(&p->res, NULL);
+}
+
+static void
+tc_clear_texture(struct pipe_context *_pipe, struct pipe_resource *res,
+                 unsigned level, const struct pipe_box *box, const void *data)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_clear_texture *p =
+      tc_add_call(tc, tc_call_clear_texture, sizeof(*p));
+   unsigned size = util_format_get_blocksize(res->format);
+
+   assert(size <= sizeof(p->data));
+   p->res = NULL;
+   pipe_resource_reference(&p->res, res);
+   p->level = level;
+   p->box = *box;
+   memcpy(p->data, data, MIN2(size, sizeof(p->data)));
+}
+
+struct tc_clear_buffer {
+   struct pipe_resource *res;
+   unsigned offset;
+   unsigned size;
+   uint64_t clear_value[2]; /* at most 16 bytes */
+   int clear_value_size;
+};
+
+static void
+tc_call_clear_buffer(struct pipe_context *pipe, void *payload)
+{
+   struct tc_clear_buffer *p = payload;
+
+   pipe->clear_buffer(pipe, p->res, p->offset, p->size, p->clear_value,
+                      p->clear_value_size);
+   pipe_resource_reference(&p->res, NULL);
+}
+
+static void
+tc_clear_buffer(struct pipe_context *_pipe, struct pipe_resource *res,
+                unsigned offset, unsigned size,
+                const void *clear_value, int clear_value_size)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_clear_buffer *p =
+      tc_add_call(tc, tc_call_clear_buffer, sizeof(*p));
+
+   assert(clear_value_size <= sizeof(p->clear_value));
+   p->res = NULL;
+   pipe_resource_reference(&p->res, res);
+   p->offset = offset;
+   p->size = size;
+   memcpy(p->clear_value, clear_value, clear_value_size);
+   p->clear_value_size = clear_value_size;
+}
+
+struct tc_resource_copy_region {
+   struct pipe_resource *dst;
+   unsigned dst_level;
+   unsigned dstx, dsty, dstz;
+   struct pipe_resource *src;
+   unsigned src_level;
+   struct pipe_box src_box;
+};
+
+static void
+tc_call_resource_copy_region(struct pipe_context *pipe, void *payload)
+{
+   struct tc_resource_copy_region *p = payload;
+
+   pipe->resource_copy_region(pipe, p->dst, p->dst_level, p->dstx, p->dsty,
+                              p->dstz, p->src, p->src_level, &p->src_box);
+   pipe_resource_reference(&p->dst, NULL);
+   pipe_resource_reference(&p->src, NULL);
+}
+
+static void
+tc_resource_copy_region(struct pipe_context *_pipe,
+                        struct pipe_resource *dst, unsigned dst_level,
+                        unsigned dstx, unsigned dsty, unsigned dstz,
+                        struct pipe_resource *src, unsigned src_level,
+                        const struct pipe_box *src_box)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct tc_resource_copy_region *p =
+      tc_add_call(tc, tc_call_resource_copy_region, sizeof(*p));
+
+   p->dst = NULL;
+   pipe_resource_reference(&p->dst, dst);
+   p->dst_level = dst_level;
+   p->dstx = dstx;
+   p->dsty = dsty;
+   p->dstz = dstz;
+   p->src = NULL;
+   pipe_resource_reference(&p->src, src);
+   p->src_level = src_level;
+   p->src_box = *src_box;
+}
+
+static void
+tc_call_blit(struct pipe_context *pipe, void *payload)
+{
+   struct pipe_blit_info *info = payload;
+
+   pipe->blit(pipe, info);
+   pipe_resource_reference(&info->dst.resource, NULL);
+   pipe_resource_reference(&info->src.resource, NULL);
+}
+
+static void
+tc_blit(struct pipe_context *_pipe, const struct pipe_blit_info *info)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   struct pipe_blit_info *p = tc_add_call(tc, tc_call_blit, sizeof(*p));
+
+   *p = *info;
+   p->dst.resource = NULL;
+   p->src.resource = NULL;
+   pipe_resource_reference(&p->dst.resource, info->dst.resource);
+   pipe_resource_reference(&p->src.resource, info->src.resource);
+}
+
+/* Functions taking one resource. */
+#define TC_FUNC_RESOURCE(func) \
+   static void \
+   tc_call_##func(struct pipe_context *pipe, void *payload) \
+   { \
+      struct pipe_resource **p = payload; \
+      \
+      pipe->func(pipe, *p); \
+      pipe_resource_reference(p, NULL); \
+   } \
+   \
+   static void \
+   tc_##func(struct pipe_context *_pipe, struct pipe_resource *resource) \
+   { \
+      struct threaded_context *tc = threaded_context(_pipe); \
+      struct pipe_resource **p = \
+         tc_add_call(tc, tc_call_##func, sizeof(*p)); \
+      \
+      *p = NULL; \
+      pipe_resource_reference(p, resource); \
+   }
+
+TC_FUNC_RESOURCE(flush_resource)
+TC_FUNC_RESOURCE(invalidate_resource)
+
+#undef TC_FUNC_RESOURCE
+
+static boolean
+tc_generate_mipmap(struct pipe_context *_pipe, struct pipe_resource *res,
+                   enum pipe_format format, unsigned base_level,
+                   unsigned last_level, unsigned first_layer,
+                   unsigned last_layer)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->generate_mipmap(tc->pipe, res, format, base_level,
+                                    last_level, first_layer, last_layer);
+}
+
+static void
+tc_call_emit_string_marker(struct pipe_context *pipe, void *payload)
+{
+   int *len = payload;
+
+   pipe->emit_string_marker(pipe, (const char *)(len + 1), *len);
+}
+
+static void
+tc_emit_string_marker(struct pipe_context *_pipe, const char *string, int len)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   int *p;
+
+   if (!tc_fits(sizeof(int) + len)) {
+      tc_sync(tc);
+      tc->pipe->emit_string_marker(tc->pipe, string, len);
+      return;
+   }
+
+   p = tc_add_call(tc, tc_call_emit_string_marker, sizeof(int) + len);
+   *p = len;
+   memcpy(p + 1, string, len);
+}
+
+static void
+tc_call_flush(struct pipe_context *pipe, void *payload)
+{
+   pipe->flush(pipe, NULL, *(unsigned *)payload);
+}
+
+static void
+tc_flush(struct pipe_context *_pipe, struct pipe_fence_handle **fence,
+         unsigned flags)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   /* The fence must be returned immediately. */
+   if (fence) {
+      tc_sync(tc);
+      tc->pipe->flush(tc->pipe, fence, flags);
+      return;
+   }
+
+   *(unsigned *)tc_add_call(tc, tc_call_flush, sizeof(flags)) = flags;
+   tc_batch_flush(tc);
+}
+
+
+/********************************************************************
+ * miscellaneous
+ */
+
+static void
+tc_get_sample_position(struct pipe_context *_pipe, unsigned sample_count,
+                       unsigned sample_index, float *out_value)
+{
+   struct pipe_context *pipe = threaded_context(_pipe)->pipe;
+
+   /* This only returns constants. */
+   pipe->get_sample_position(pipe, sample_count, sample_index, out_value);
+}
+
+static uint64_t
+tc_get_timestamp(struct pipe_context *_pipe)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->get_timestamp(tc->pipe);
+}
+
+static enum pipe_reset_status
+tc_get_device_reset_status(struct pipe_context *_pipe)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   return tc->pipe->get_device_reset_status(tc->pipe);
+}
+
+static void
+tc_dump_debug_state(struct pipe_context *_pipe, FILE *stream, unsigned flags)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+
+   tc_sync(tc);
+   tc->pipe->dump_debug_state(tc->pipe, stream, flags);
+}
+
+static void
+tc_destroy(struct pipe_context *_pipe)
+{
+   struct threaded_context *tc = threaded_context(_pipe);
+   unsigned i;
+
+   tc_sync(tc);
+   util_queue_destroy(&tc->queue);
+
+   for (i = 0; i < TC_MAX_BATCHES; i++)
+      util_queue_fence_destroy(&tc->batch_slots[i].fence);
+
+   tc->pipe->destroy(tc->pipe);
+   FREE(tc);
+}
+
+struct pipe_context *
+tc_context_create(struct tc_screen *tscreen, struct pipe_context *pipe)
+{
+   struct threaded_context *tc;
+   unsigned i;
+
+   if (!pipe)
+      return NULL;
+
+   tc = CALLOC_STRUCT(threaded_context);
+   if (!tc) {
+      pipe->destroy(pipe);
+      return NULL;
+   }
+
+   /* Contexts that can't get a thread stay synchronous. */
+   if (!util_queue_init(&tc->queue, "gallium_drv", TC_MAX_BATCHES, 1)) {
+      FREE(tc);
+      return pipe;
+   }
+
+   for (i = 0; i < TC_MAX_BATCHES; i++) {
+      tc->batch_slots[i].pipe = pipe;
+      util_queue_fence_init(&tc->batch_slots[i].fence);
+   }
+
+   tc->pipe = pipe;
+   tc->base.priv = pipe->priv; /* expose wrapped priv data */
+   tc->base.screen = &tscreen->base;
+
+#define CTX_INIT(_member) \
+   tc->base._member = pipe->_member ? tc_##_member : NULL
+
+   tc->base.destroy = tc_destroy;
+   CTX_INIT(draw_vbo);
+   CTX_INIT(render_condition);
+   CTX_INIT(create_query);
+   CTX_INIT(create_batch_query);
+   CTX_INIT(destroy_query);
+   CTX_INIT(begin_query);
+   CTX_INIT(end_query);
+   CTX_INIT(get_query_result);
+   CTX_INIT(get_query_result_resource);
+   CTX_INIT(set_active_query_state);
+   CTX_INIT(create_blend_state);
+   CTX_INIT(bind_blend_state);
+   CTX_INIT(delete_blend_state);
+   CTX_INIT(create_sampler_state);
+   CTX_INIT(bind_sampler_states);
+   CTX_INIT(delete_sampler_state);
+   CTX_INIT(create_rasterizer_state);
+   CTX_INIT(bind_rasterizer_state);
+   CTX_INIT(delete_rasterizer_state);
+   CTX_INIT(create_depth_stencil_alpha_state);
+   CTX_INIT(bind_depth_stencil_alpha_state);
+   CTX_INIT(delete_depth_stencil_alpha_state);
+   CTX_INIT(create_fs_state);
+   CTX_INIT(bind_fs_state);
+   CTX_INIT(delete_fs_state);
+   CTX_INIT(create_vs_state);
+   CTX_INIT(bind_vs_state);
+   CTX_INIT(delete_vs_state);
+   CTX_INIT(create_gs_state);
+   CTX_INIT(bind_gs_state);
+   CTX_INIT(delete_gs_state);
+   CTX_INIT(create_tcs_state);
+   CTX_INIT(bind_tcs_state);
+   CTX_INIT(delete_tcs_state);
+   CTX_INIT(create_tes_state);
+   CTX_INIT(bind_tes_state);
+   CTX_INIT(delete_tes_state);
+   CTX_INIT(create_vertex_elements_state);
+   CTX_INIT(bind_vertex_elements_state);
+   CTX_INIT(delete_vertex_elements_state);
+   CTX_INIT(set_blend_color);
+   CTX_INIT(set_stencil_ref);
+   CTX_INIT(set_sample_mask);
+   CTX_INIT(set_min_samples);
+   CTX_INIT(set_clip_state);
+   CTX_INIT(set_constant_buffer);
+   CTX_INIT(set_framebuffer_state);
+   CTX_INIT(set_polygon_stipple);
+   CTX_INIT(set_scissor_states);
+   CTX_INIT(set_viewport_states);
+   CTX_INIT(set_sampler_views);
+   CTX_INIT(set_tess_state);
+   CTX_INIT(set_debug_callback);
+   CTX_INIT(set_shader_buffers);
+   CTX_INIT(set_shader_images);
+   CTX_INIT(set_vertex_buffers);
+   CTX_INIT(set_index_buffer);
+   CTX_INIT(create_stream_output_target);
+   CTX_INIT(stream_output_target_destroy);
+   CTX_INIT(set_stream_output_targets);
+   CTX_INIT(resource_copy_region);
+   CTX_INIT(blit);
+   CTX_INIT(clear);
+   CTX_INIT(clear_render_target);
+   CTX_INIT(clear_depth_stencil);
+   CTX_INIT(clear_texture);
+   CTX_INIT(clear_buffer);
+   CTX_INIT(flush);
+   CTX_INIT(create_sampler_view);
+   CTX_INIT(sampler_view_destroy);
+   CTX_INIT(create_surface);
+   CTX_INIT(surface_destroy);
+   CTX_INIT(transfer_map);
+   CTX_INIT(transfer_flush_region);
+   CTX_INIT(transfer_unmap);
+   CTX_INIT(transfer_inline_write);
+   CTX_INIT(texture_barrier);
+   CTX_INIT(memory_barrier);
+   CTX_INIT(create_video_codec);
+   CTX_INIT(create_video_buffer);
+   CTX_INIT(create_compute_state);
+   CTX_INIT(bind_compute_state);
+   CTX_INIT(delete_compute_state);
+   CTX_INIT(set_compute_resources);
+   CTX_INIT(set_global_binding);
+   CTX_INIT(launch_grid);
+   CTX_INIT(get_sample_position);
+   CTX_INIT(get_timestamp);
+   CTX_INIT(flush_resource);
+   CTX_INIT(invalidate_resource);
+   CTX_INIT(get_device_reset_status);
+   CTX_INIT(dump_debug_state);
+   CTX_INIT(emit_string_marker);
+   CTX_INIT(generate_mipmap);
+
+#undef CTX_INIT
+
+   return &tc->base;
+}
@@ -0,0 +1,111 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* A pipe_context wrapper that records pipe calls into batches and executes
+ * them on a driver thread.
+ *
+ * Calls that only change state or queue GPU work are recorded. Resources,
+ * surfaces, sampler views and stream output targets referenced by recorded
+ * calls are kept alive by taking references, which are released after the
+ * call has been executed. Everything else (object creation, transfers,
+ * queries returning data, flushes returning fences, ...) synchronizes with
+ * the driver thread first and then calls the driver directly, so the driver
+ * is never entered from two threads at the same time.
+ */
+
+#ifndef TC_PIPE_H_
+#define TC_PIPE_H_
+
+#include "pipe/p_context.h"
+#include "pipe/p_state.h"
+#include "pipe/p_screen.h"
+#include "util/u_queue.h"
+
+/* 8-byte slots; a batch is 16 KB. */
+#define TC_SLOTS_PER_BATCH	2048
+#define TC_MAX_BATCHES		4
+
+typedef void (*tc_execute)(struct pipe_context *pipe, void *payload);
+
+struct tc_call
+{
+   tc_execute execute;
+   unsigned num_call_slots;
+   /* The payload follows, aligned to 8 bytes. */
+};
+
+/* The number of slots needed by a call with a payload of the given size. */
+#define TC_CALL_SLOTS(payload_size) \
+   DIV_ROUND_UP(sizeof(struct tc_call) + (payload_size), sizeof(uint64_t))
+
+struct tc_batch
+{
+   struct util_queue_fence fence;
+   struct pipe_context *pipe;
+   unsigned num_total_call_slots;
+   uint64_t slots[TC_SLOTS_PER_BATCH];
+};
+
+struct tc_screen
+{
+   struct pipe_screen base;
+   struct pipe_screen *screen;
+};
+
+struct threaded_context
+{
+   struct pipe_context base;
+   struct pipe_context *pipe;
+
+   /* One thread executing batches in order. */
+   struct util_queue queue;
+
+   struct tc_batch batch_slots[TC_MAX_BATCHES];
+   unsigned next; /* the batch being recorded */
+
+   /* User vertex and index buffers are read by the driver at draw time,
+    * so draws must be synchronous while any of them is bound.
+    */
+   uint32_t user_vertex_buffer_mask;
+   bool user_index_buffer;
+};
+
+struct pipe_context *
+tc_context_create(struct tc_screen *tscreen, struct pipe_context *pipe);
+
+static inline struct tc_screen *
+tc_screen(struct pipe_screen *screen)
+{
+   return (struct tc_screen *)screen;
+}
+
+static inline struct threaded_context *
+threaded_context(struct pipe_context *pipe)
+{
+   return (struct threaded_context *)pipe;
+}
+
+#endif /* TC_PIPE_H_ */
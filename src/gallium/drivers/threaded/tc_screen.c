@@ -0,0 +1,350 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#include "tc_pipe.h"
+#include "tc_public.h"
+#include "util/u_memory.h"
+#include "util/u_debug.h"
+
+
+static const char *
+tc_screen_get_name(struct pipe_screen *_screen)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_name(screen);
+}
+
+static const char *
+tc_screen_get_vendor(struct pipe_screen *_screen)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_vendor(screen);
+}
+
+static const char *
+tc_screen_get_device_vendor(struct pipe_screen *_screen)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_device_vendor(screen);
+}
+
+static int
+tc_screen_get_param(struct pipe_screen *_screen,
+                    enum pipe_cap param)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_param(screen, param);
+}
+
+static float
+tc_screen_get_paramf(struct pipe_screen *_screen,
+                     enum pipe_capf param)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_paramf(screen, param);
+}
+
+static int
+tc_screen_get_shader_param(struct pipe_screen *_screen, unsigned shader,
+                           enum pipe_shader_cap param)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_shader_param(screen, shader, param);
+}
+
+static int
+tc_screen_get_video_param(struct pipe_screen *_screen,
+                          enum pipe_video_profile profile,
+                          enum pipe_video_entrypoint entrypoint,
+                          enum pipe_video_cap param)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_video_param(screen, profile, entrypoint, param);
+}
+
+static int
+tc_screen_get_compute_param(struct pipe_screen *_screen,
+                            enum pipe_shader_ir ir_type,
+                            enum pipe_compute_cap param,
+                            void *ret)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_compute_param(screen, ir_type, param, ret);
+}
+
+static uint64_t
+tc_screen_get_timestamp(struct pipe_screen *_screen)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_timestamp(screen);
+}
+
+static struct pipe_context *
+tc_screen_context_create(struct pipe_screen *_screen, void *priv,
+                         unsigned flags)
+{
+   struct tc_screen *tscreen = tc_screen(_screen);
+   struct pipe_screen *screen = tscreen->screen;
+
+   return tc_context_create(tscreen,
+                            screen->context_create(screen, priv, flags));
+}
+
+static boolean
+tc_screen_is_format_supported(struct pipe_screen *_screen,
+                              enum pipe_format format,
+                              enum pipe_texture_target target,
+                              unsigned sample_count,
+                              unsigned tex_usage)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->is_format_supported(screen, format, target, sample_count,
+                                      tex_usage);
+}
+
+static boolean
+tc_screen_is_video_format_supported(struct pipe_screen *_screen,
+                                    enum pipe_format format,
+                                    enum pipe_video_profile profile,
+                                    enum pipe_video_entrypoint entrypoint)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->is_video_format_supported(screen, format, profile,
+                                            entrypoint);
+}
+
+static boolean
+tc_screen_can_create_resource(struct pipe_screen *_screen,
+                              const struct pipe_resource *templat)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->can_create_resource(screen, templat);
+}
+
+static void
+tc_screen_flush_frontbuffer(struct pipe_screen *_screen,
+                            struct pipe_resource *resource,
+                            unsigned level, unsigned layer,
+                            void *context_private,
+                            struct pipe_box *sub_box)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   screen->flush_frontbuffer(screen, resource, level, layer, context_private,
+                             sub_box);
+}
+
+static int
+tc_screen_get_driver_query_info(struct pipe_screen *_screen,
+                                unsigned index,
+                                struct pipe_driver_query_info *info)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_driver_query_info(screen, index, info);
+}
+
+static int
+tc_screen_get_driver_query_group_info(struct pipe_screen *_screen,
+                                      unsigned index,
+                                      struct pipe_driver_query_group_info *info)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->get_driver_query_group_info(screen, index, info);
+}
+
+
+/********************************************************************
+ * resource
+ */
+
+static struct pipe_resource *
+tc_screen_resource_create(struct pipe_screen *_screen,
+                          const struct pipe_resource *templat)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+   struct pipe_resource *res = screen->resource_create(screen, templat);
+
+   if (!res)
+      return NULL;
+   res->screen = _screen;
+   return res;
+}
+
+static struct pipe_resource *
+tc_screen_resource_from_handle(struct pipe_screen *_screen,
+                               const struct pipe_resource *templ,
+                               struct winsys_handle *handle,
+                               unsigned usage)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+   struct pipe_resource *res =
+      screen->resource_from_handle(screen, templ, handle, usage);
+
+   if (!res)
+      return NULL;
+   res->screen = _screen;
+   return res;
+}
+
+static struct pipe_resource *
+tc_screen_resource_from_user_memory(struct pipe_screen *_screen,
+                                    const struct pipe_resource *templ,
+                                    void *user_memory)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+   struct pipe_resource *res =
+      screen->resource_from_user_memory(screen, templ, user_memory);
+
+   if (!res)
+      return NULL;
+   res->screen = _screen;
+   return res;
+}
+
+static void
+tc_screen_resource_destroy(struct pipe_screen *_screen,
+                           struct pipe_resource *res)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   screen->resource_destroy(screen, res);
+}
+
+static boolean
+tc_screen_resource_get_handle(struct pipe_screen *_screen,
+                              struct pipe_resource *resource,
+                              struct winsys_handle *handle,
+                              unsigned usage)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->resource_get_handle(screen, resource, handle, usage);
+}
+
+
+/********************************************************************
+ * fence
+ */
+
+static void
+tc_screen_fence_reference(struct pipe_screen *_screen,
+                          struct pipe_fence_handle **pdst,
+                          struct pipe_fence_handle *src)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   screen->fence_reference(screen, pdst, src);
+}
+
+static boolean
+tc_screen_fence_finish(struct pipe_screen *_screen,
+                       struct pipe_fence_handle *fence,
+                       uint64_t timeout)
+{
+   struct pipe_screen *screen = tc_screen(_screen)->screen;
+
+   return screen->fence_finish(screen, fence, timeout);
+}
+
+
+/********************************************************************
+ * screen
+ */
+
+
+/********************************************************************
+ * screen
+ */
+
+static void
+tc_screen_destroy(struct pipe_screen *_screen)
+{
+   struct tc_screen *tscreen = tc_screen(_screen);
+   struct pipe_screen *screen = tscreen->screen;
+
+   screen->destroy(screen);
+   FREE(tscreen);
+}
+
+struct pipe_screen *
+threaded_screen_create(struct pipe_screen *screen)
+{
+   struct tc_screen *tscreen;
+
+   if (!debug_get_bool_option("GALLIUM_THREAD", FALSE))
+      return screen;
+
+   tscreen = CALLOC_STRUCT(tc_screen);
+   if (!tscreen)
+      return screen;
+
+#define SCR_INIT(_member) \
+   tscreen->base._member = screen->_member ? tc_screen_##_member : NULL
+
+   tscreen->base.destroy = tc_screen_destroy;
+   tscreen->base.get_name = tc_screen_get_name;
+   tscreen->base.get_vendor = tc_screen_get_vendor;
+   tscreen->base.get_device_vendor = tc_screen_get_device_vendor;
+   tscreen->base.get_param = tc_screen_get_param;
+   tscreen->base.get_paramf = tc_screen_get_paramf;
+   tscreen->base.get_shader_param = tc_screen_get_shader_param;
+   SCR_INIT(get_video_param);
+   SCR_INIT(get_compute_param);
+   SCR_INIT(get_timestamp);
+   tscreen->base.context_create = tc_screen_context_create;
+   tscreen->base.is_format_supported = tc_screen_is_format_supported;
+   SCR_INIT(is_video_format_supported);
+   SCR_INIT(can_create_resource);
+   tscreen->base.resource_create = tc_screen_resource_create;
+   tscreen->base.resource_from_handle = tc_screen_resource_from_handle;
+   SCR_INIT(resource_from_user_memory);
+   tscreen->base.resource_get_handle = tc_screen_resource_get_handle;
+   tscreen->base.resource_destroy = tc_screen_resource_destroy;
+   SCR_INIT(flush_frontbuffer);
+   SCR_INIT(fence_reference);
+   SCR_INIT(fence_finish);
+   SCR_INIT(get_driver_query_info);
+   SCR_INIT(get_driver_query_group_info);
+
+#undef SCR_INIT
+
+   tscreen->screen = screen;
+   return &tscreen->base;
+}
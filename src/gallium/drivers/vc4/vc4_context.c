@@ -176,14 +176,26 @@ vc4_cl_references_bo(struct pipe_context *pctx, struct vc4_bo *bo,
         return false;
 }
 
+/**
+ * Drops the stores of an invalidated render target, and its load at the
+ * start of the job, the same way as for buffers that were never written.
+ */
 static void
 vc4_invalidate_resource(struct pipe_context *pctx, struct pipe_resource *prsc)
 {
         struct vc4_context *vc4 = vc4_context(pctx);
+        struct pipe_surface *cbuf = vc4->framebuffer.cbufs[0];
         struct pipe_surface *zsurf = vc4->framebuffer.zsbuf;
 
-        if (zsurf && zsurf->texture == prsc)
+        if (cbuf && cbuf->texture == prsc) {
+                vc4->resolve &= ~PIPE_CLEAR_COLOR0;
+                vc4->cleared |= PIPE_CLEAR_COLOR0;
+        }
+
+        if (zsurf && zsurf->texture == prsc) {
                 vc4->resolve &= ~(PIPE_CLEAR_DEPTH | PIPE_CLEAR_STENCIL);
+                vc4->cleared |= PIPE_CLEAR_DEPTH | PIPE_CLEAR_STENCIL;
+        }
 }
 
 static void
@@ -103,6 +103,11 @@ struct vc4_uncompiled_shader {
         /** How many variants of this program were compiled, for shader-db. */
         uint32_t compiled_variant_count;
         struct pipe_shader_state base;
+        /**
+         * NIR translated from base.tokens at create time, cloned for each
+         * variant.
+         */
+        nir_shader *base_nir;
 };
 
 struct vc4_ubo_range {
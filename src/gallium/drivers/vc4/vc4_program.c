@@ -1838,9 +1838,7 @@ vc4_shader_ntq(struct vc4_context *vc4, enum qstage stage,
                 tgsi_dump(tokens, 0);
         }
 
-        c->s = tgsi_to_nir(tokens, &nir_options);
-        NIR_PASS_V(c->s, nir_opt_global_to_local);
-        NIR_PASS_V(c->s, nir_convert_to_ssa);
+        c->s = nir_shader_clone(c, key->shader_state->base_nir);
 
         if (stage == QSTAGE_FRAG)
                 NIR_PASS_V(c->s, vc4_nir_lower_blend, c);
@@ -1993,6 +1991,12 @@ vc4_shader_state_create(struct pipe_context *pctx,
         so->base.tokens = tgsi_dup_tokens(cso->tokens);
         so->program_id = vc4->next_uncompiled_program_id++;
 
+        /* Translate to NIR once, instead of for every variant. */
+        nir_shader *s = tgsi_to_nir(so->base.tokens, &nir_options);
+        NIR_PASS_V(s, nir_opt_global_to_local);
+        NIR_PASS_V(s, nir_convert_to_ssa);
+        so->base_nir = s;
+
         return so;
 }
 
@@ -2340,6 +2344,7 @@ vc4_shader_state_delete(struct pipe_context *pctx, void *hwcso)
         hash_table_foreach(vc4->vs_cache, entry)
                 delete_from_cache_if_matches(vc4->vs_cache, entry, so);
 
+        ralloc_free(so->base_nir);
         free((void *)so->base.tokens);
         free(so);
 }
@@ -204,6 +204,12 @@ process_raddr_deps(struct schedule_state *state, struct schedule_node *n,
         }
 }
 
+static bool
+is_sfu_write(uint32_t waddr)
+{
+        return waddr >= QPU_W_SFU_RECIP && waddr <= QPU_W_SFU_LOG;
+}
+
 static bool
 is_tmu_write(uint32_t waddr)
 {
@@ -506,6 +512,13 @@ get_instruction_priority(uint64_t inst)
         baseline_score = next_score;
         next_score++;
 
+        /* Schedule SFU operations early as well, since their result takes
+         * a couple of instructions to show up in r4.
+         */
+        if (is_sfu_write(waddr_add) || is_sfu_write(waddr_mul))
+                return next_score;
+        next_score++;
+
         /* Schedule texture read setup early to hide their latency better. */
         if (is_tmu_write(waddr_add) || is_tmu_write(waddr_mul))
                 return next_score;
@@ -596,8 +609,7 @@ update_scoreboard_for_chosen(struct choose_scoreboard *scoreboard,
                 scoreboard->last_waddr_a = waddr_mul;
         }
 
-        if ((waddr_add >= QPU_W_SFU_RECIP && waddr_add <= QPU_W_SFU_LOG) ||
-            (waddr_mul >= QPU_W_SFU_RECIP && waddr_mul <= QPU_W_SFU_LOG)) {
+        if (is_sfu_write(waddr_add) || is_sfu_write(waddr_mul)) {
                 scoreboard->last_sfu_write_tick = scoreboard->tick;
         }
 }
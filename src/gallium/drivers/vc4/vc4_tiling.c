@@ -104,11 +104,49 @@ vc4_load_utile(void *dst, void *src, uint32_t dst_stride, uint32_t cpp)
         uint32_t utile_h = vc4_utile_height(cpp);
         uint32_t row_size = 64 / utile_h;
 
-        for (int y = 0; y < utile_h; y++) {
-                memcpy(dst, src, row_size);
-                dst += dst_stride;
-                src += row_size;
+#if defined(__ARM_NEON__)
+        /* Load the whole utile into q0-q3, then store its rows. */
+        if (row_size == 8) {
+                __asm__ volatile (
+                        "vldm %[src], {q0, q1, q2, q3}\n"
+                        "vst1.8 d0, [%[dst]], %[stride]\n"
+                        "vst1.8 d1, [%[dst]], %[stride]\n"
+                        "vst1.8 d2, [%[dst]], %[stride]\n"
+                        "vst1.8 d3, [%[dst]], %[stride]\n"
+                        "vst1.8 d4, [%[dst]], %[stride]\n"
+                        "vst1.8 d5, [%[dst]], %[stride]\n"
+                        "vst1.8 d6, [%[dst]], %[stride]\n"
+                        "vst1.8 d7, [%[dst]]\n"
+                        : [dst] "+r"(dst)
+                        : [src] "r"(src), [stride] "r"(dst_stride)
+                        : "q0", "q1", "q2", "q3", "memory");
+        } else {
+                __asm__ volatile (
+                        "vldm %[src], {q0, q1, q2, q3}\n"
+                        "vst1.8 {d0, d1}, [%[dst]], %[stride]\n"
+                        "vst1.8 {d2, d3}, [%[dst]], %[stride]\n"
+                        "vst1.8 {d4, d5}, [%[dst]], %[stride]\n"
+                        "vst1.8 {d6, d7}, [%[dst]]\n"
+                        : [dst] "+r"(dst)
+                        : [src] "r"(src), [stride] "r"(dst_stride)
+                        : "q0", "q1", "q2", "q3", "memory");
+        }
+#else
+        /* Constant-size copies, so that they get inlined. */
+        if (row_size == 8) {
+                for (int y = 0; y < 8; y++) {
+                        memcpy(dst, src, 8);
+                        dst += dst_stride;
+                        src += 8;
+                }
+        } else {
+                for (int y = 0; y < 4; y++) {
+                        memcpy(dst, src, 16);
+                        dst += dst_stride;
+                        src += 16;
+                }
         }
+#endif
 }
 
 void
@@ -117,11 +155,49 @@ vc4_store_utile(void *dst, void *src, uint32_t src_stride, uint32_t cpp)
         uint32_t utile_h = vc4_utile_height(cpp);
         uint32_t row_size = 64 / utile_h;
 
-        for (int y = 0; y < utile_h; y++) {
-                memcpy(dst, src, row_size);
-                dst += row_size;
-                src += src_stride;
+#if defined(__ARM_NEON__)
+        /* Gather the rows into q0-q3, then store the whole utile. */
+        if (row_size == 8) {
+                __asm__ volatile (
+                        "vld1.8 d0, [%[src]], %[stride]\n"
+                        "vld1.8 d1, [%[src]], %[stride]\n"
+                        "vld1.8 d2, [%[src]], %[stride]\n"
+                        "vld1.8 d3, [%[src]], %[stride]\n"
+                        "vld1.8 d4, [%[src]], %[stride]\n"
+                        "vld1.8 d5, [%[src]], %[stride]\n"
+                        "vld1.8 d6, [%[src]], %[stride]\n"
+                        "vld1.8 d7, [%[src]]\n"
+                        "vstm %[dst], {q0, q1, q2, q3}\n"
+                        : [src] "+r"(src)
+                        : [dst] "r"(dst), [stride] "r"(src_stride)
+                        : "q0", "q1", "q2", "q3", "memory");
+        } else {
+                __asm__ volatile (
+                        "vld1.8 {d0, d1}, [%[src]], %[stride]\n"
+                        "vld1.8 {d2, d3}, [%[src]], %[stride]\n"
+                        "vld1.8 {d4, d5}, [%[src]], %[stride]\n"
+                        "vld1.8 {d6, d7}, [%[src]]\n"
+                        "vstm %[dst], {q0, q1, q2, q3}\n"
+                        : [src] "+r"(src)
+                        : [dst] "r"(dst), [stride] "r"(src_stride)
+                        : "q0", "q1", "q2", "q3", "memory");
+        }
+#else
+        /* Constant-size copies, so that they get inlined. */
+        if (row_size == 8) {
+                for (int y = 0; y < 8; y++) {
+                        memcpy(dst, src, 8);
+                        dst += 8;
+                        src += src_stride;
+                }
+        } else {
+                for (int y = 0; y < 4; y++) {
+                        memcpy(dst, src, 16);
+                        dst += 16;
+                        src += src_stride;
+                }
         }
+#endif
 }
 
 static void
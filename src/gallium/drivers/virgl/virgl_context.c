@@ -35,6 +35,8 @@
 #include "util/u_slab.h"
 #include "util/u_upload_mgr.h"
 #include "util/u_blitter.h"
+#include "util/hash_table.h"
+#include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_text.h"
 #include "indices/u_primconvert.h"
 
@@ -457,48 +459,116 @@ void virgl_transfer_inline_write(struct pipe_context *ctx,
                                 unsigned layer_stride)
 {
    struct virgl_context *vctx = virgl_context(ctx);
-   struct virgl_screen *vs = virgl_screen(ctx->screen);
    struct virgl_resource *grres = virgl_resource(res);
-   struct virgl_buffer *vbuf = virgl_buffer(res);
 
    grres->clean = FALSE;
 
-   if (virgl_res_needs_flush_wait(vctx, &vbuf->base, usage)) {
-      ctx->flush(ctx, NULL, 0);
+   /* The data travels in the command stream, so the host applies it after
+    * the commands already queued that use the resource. There is no need
+    * to submit them and wait for the host first.
+    */
+   virgl_encoder_inline_write(vctx, grres, level, usage,
+                              box, data, stride, layer_stride);
+}
+
+static uint32_t virgl_shader_hash(const void *key)
+{
+   const struct virgl_shader *shader = key;
+
+   return _mesa_hash_data(shader->tokens,
+                          shader->num_tokens * sizeof(struct tgsi_token)) ^
+          shader->type;
+}
 
-      vs->vws->resource_wait(vs->vws, vbuf->base.hw_res);
+static bool virgl_shader_equal(const void *a, const void *b)
+{
+   const struct virgl_shader *sa = a, *sb = b;
+   const struct pipe_stream_output_info *soa = &sa->stream_output;
+   const struct pipe_stream_output_info *sob = &sb->stream_output;
+   unsigned i;
+
+   if (sa->type != sb->type || sa->num_tokens != sb->num_tokens ||
+       soa->num_outputs != sob->num_outputs ||
+       memcmp(soa->stride, sob->stride, sizeof(soa->stride)))
+      return false;
+
+   /* The outputs are bitfields, don't compare their padding. */
+   for (i = 0; i < soa->num_outputs; i++) {
+      if (soa->output[i].register_index != sob->output[i].register_index ||
+          soa->output[i].start_component != sob->output[i].start_component ||
+          soa->output[i].num_components != sob->output[i].num_components ||
+          soa->output[i].output_buffer != sob->output[i].output_buffer ||
+          soa->output[i].dst_offset != sob->output[i].dst_offset ||
+          soa->output[i].stream != sob->output[i].stream)
+         return false;
    }
 
-   virgl_encoder_inline_write(vctx, grres, level, usage,
-                              box, data, stride, layer_stride);
+   return !memcmp(sa->tokens, sb->tokens,
+                  sa->num_tokens * sizeof(struct tgsi_token));
 }
 
+/*
+ * Shaders are often created several times from the same tokens, e.g. by
+ * programs sharing their vertex shader. Reuse the host object in that
+ * case, so that the host doesn't translate and compile it again.
+ */
 static void *virgl_shader_encoder(struct pipe_context *ctx,
                                   const struct pipe_shader_state *shader,
                                   unsigned type)
 {
    struct virgl_context *vctx = virgl_context(ctx);
-   uint32_t handle;
+   struct virgl_shader key, *vs;
+   struct hash_entry *entry;
    struct tgsi_token *new_tokens;
    int ret;
 
+   memset(&key, 0, sizeof(key));
+   key.type = type;
+   key.stream_output = shader->stream_output;
+   key.num_tokens = tgsi_num_tokens(shader->tokens);
+   key.tokens = (struct tgsi_token *)shader->tokens;
+
+   entry = _mesa_hash_table_search(vctx->shaders, &key);
+   if (entry) {
+      vs = entry->data;
+      vs->refcount++;
+      return vs;
+   }
+
+   vs = CALLOC_STRUCT(virgl_shader);
+   if (!vs)
+      return NULL;
+
+   *vs = key;
+   vs->refcount = 1;
+   vs->tokens = tgsi_dup_tokens(shader->tokens);
+   if (!vs->tokens) {
+      FREE(vs);
+      return NULL;
+   }
+
    new_tokens = virgl_tgsi_transform(shader->tokens);
    if (!new_tokens)
-      return NULL;
+      goto fail;
 
-   handle = virgl_object_assign_handle();
+   vs->handle = virgl_object_assign_handle();
    /* encode VS state */
-   ret = virgl_encode_shader_state(vctx, handle, type,
+   ret = virgl_encode_shader_state(vctx, vs->handle, type,
                                    &shader->stream_output,
                                    new_tokens);
-   if (ret) {
-      return NULL;
-   }
-
    FREE(new_tokens);
-   return (void *)(unsigned long)handle;
+   if (ret)
+      goto fail;
 
+   _mesa_hash_table_insert(vctx->shaders, vs, vs);
+   return vs;
+
+fail:
+   FREE(vs->tokens);
+   FREE(vs);
+   return NULL;
 }
+
 static void *virgl_create_vs_state(struct pipe_context *ctx,
                                    const struct pipe_shader_state *shader)
 {
@@ -518,39 +588,51 @@ static void *virgl_create_fs_state(struct pipe_context *ctx,
 }
 
 static void
-virgl_delete_fs_state(struct pipe_context *ctx,
-                     void *fs)
+virgl_delete_shader(struct pipe_context *ctx, void *shader)
 {
-   uint32_t handle = (unsigned long)fs;
    struct virgl_context *vctx = virgl_context(ctx);
+   struct virgl_shader *vs = shader;
+
+   if (--vs->refcount)
+      return;
 
-   virgl_encode_delete_object(vctx, handle, VIRGL_OBJECT_SHADER);
+   _mesa_hash_table_remove(vctx->shaders,
+                           _mesa_hash_table_search(vctx->shaders, vs));
+   virgl_encode_delete_object(vctx, vs->handle, VIRGL_OBJECT_SHADER);
+   FREE(vs->tokens);
+   FREE(vs);
+}
+
+static void
+virgl_delete_fs_state(struct pipe_context *ctx,
+                     void *fs)
+{
+   virgl_delete_shader(ctx, fs);
 }
 
 static void
 virgl_delete_gs_state(struct pipe_context *ctx,
                      void *gs)
 {
-   uint32_t handle = (unsigned long)gs;
-   struct virgl_context *vctx = virgl_context(ctx);
-
-   virgl_encode_delete_object(vctx, handle, VIRGL_OBJECT_SHADER);
+   virgl_delete_shader(ctx, gs);
 }
 
 static void
 virgl_delete_vs_state(struct pipe_context *ctx,
                      void *vs)
 {
-   uint32_t handle = (unsigned long)vs;
-   struct virgl_context *vctx = virgl_context(ctx);
+   virgl_delete_shader(ctx, vs);
+}
 
-   virgl_encode_delete_object(vctx, handle, VIRGL_OBJECT_SHADER);
+static inline uint32_t virgl_shader_handle(void *shader)
+{
+   return shader ? ((struct virgl_shader *)shader)->handle : 0;
 }
 
 static void virgl_bind_vs_state(struct pipe_context *ctx,
                                         void *vss)
 {
-   uint32_t handle = (unsigned long)vss;
+   uint32_t handle = virgl_shader_handle(vss);
    struct virgl_context *vctx = virgl_context(ctx);
 
    virgl_encode_bind_shader(vctx, handle, PIPE_SHADER_VERTEX);
@@ -559,7 +641,7 @@ static void virgl_bind_vs_state(struct pipe_context *ctx,
 static void virgl_bind_gs_state(struct pipe_context *ctx,
                                void *vss)
 {
-   uint32_t handle = (unsigned long)vss;
+   uint32_t handle = virgl_shader_handle(vss);
    struct virgl_context *vctx = virgl_context(ctx);
 
    virgl_encode_bind_shader(vctx, handle, PIPE_SHADER_GEOMETRY);
@@ -569,7 +651,7 @@ static void virgl_bind_gs_state(struct pipe_context *ctx,
 static void virgl_bind_fs_state(struct pipe_context *ctx,
                                         void *vss)
 {
-   uint32_t handle = (unsigned long)vss;
+   uint32_t handle = virgl_shader_handle(vss);
    struct virgl_context *vctx = virgl_context(ctx);
 
    virgl_encode_bind_shader(vctx, handle, PIPE_SHADER_FRAGMENT);
@@ -863,6 +945,18 @@ virgl_context_destroy( struct pipe_context *ctx )
    util_primconvert_destroy(vctx->primconvert);
 
    util_slab_destroy(&vctx->texture_transfer_pool);
+
+   /* The host objects went away with the sub context. */
+   if (vctx->shaders) {
+      struct hash_entry *entry;
+
+      hash_table_foreach(vctx->shaders, entry) {
+         struct virgl_shader *vs = entry->data;
+         FREE(vs->tokens);
+         FREE(vs);
+      }
+      _mesa_hash_table_destroy(vctx->shaders, NULL);
+   }
    FREE(vctx);
 }
 
@@ -944,6 +1038,11 @@ struct pipe_context *virgl_context_create(struct pipe_screen *pscreen,
    virgl_init_so_functions(vctx);
 
    list_inithead(&vctx->to_flush_bufs);
+   vctx->shaders = _mesa_hash_table_create(NULL, virgl_shader_hash,
+                                           virgl_shader_equal);
+   if (!vctx->shaders)
+      goto fail;
+
    util_slab_create(&vctx->texture_transfer_pool, sizeof(struct virgl_transfer),
                     16, UTIL_SLAB_SINGLETHREADED);
 
@@ -28,6 +28,7 @@
 #include "util/u_slab.h"
 #include "util/list.h"
 
+struct hash_table;
 struct pipe_screen;
 struct tgsi_token;
 struct u_upload_mgr;
@@ -43,6 +44,17 @@ struct virgl_so_target {
    uint32_t handle;
 };
 
+/* Host shader objects are shared by all shader CSOs created from the same
+ * tokens, see virgl_shader_encoder(). */
+struct virgl_shader {
+   uint32_t handle;
+   unsigned refcount;
+   unsigned type;
+   struct pipe_stream_output_info stream_output;
+   unsigned num_tokens;
+   struct tgsi_token *tokens;
+};
+
 struct virgl_textures_info {
    struct virgl_sampler_view *views[16];
    uint32_t enabled_mask;
@@ -75,6 +87,8 @@ struct virgl_context {
 
    struct primconvert_context *primconvert;
    uint32_t hw_sub_ctx_id;
+
+   struct hash_table *shaders;
 };
 
 static inline struct virgl_sampler_view *
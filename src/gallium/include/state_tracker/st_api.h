@@ -415,6 +415,23 @@ struct st_context_iface
     */
    boolean (*get_resource_for_egl_image)(struct st_context_iface *stctxi,
                                          struct st_context_resource *stres);
+
+   /**
+    * Start the thread that executes the marshalled GL API calls of the
+    * context (glthread).
+    *
+    * This function is optional.
+    */
+   void (*start_thread)(struct st_context_iface *stctxi);
+
+   /**
+    * Wait for the GL API calls marshalled by the thread started by
+    * start_thread to execute.  Called before the window system accesses
+    * the context outside the GL API.
+    *
+    * This function is optional.
+    */
+   void (*thread_finish)(struct st_context_iface *stctxi);
 };
 
 
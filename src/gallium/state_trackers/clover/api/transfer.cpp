@@ -238,8 +238,16 @@ namespace {
                 T dst_obj, const vector_t &dst_orig, const vector_t &dst_pitch,
                 S src_obj, const vector_t &src_orig, const vector_t &src_pitch,
                 const vector_t &region) {
+      // The previous contents of a destination buffer don't need to be
+      // read back if every byte of the mapped range is overwritten.
+      const bool dense = (std::is_convertible<T, buffer *>::value &&
+                          dst_pitch[1] == dst_pitch[0] * region[0] &&
+                          dst_pitch[2] == dst_pitch[1] * region[1]);
+      const cl_map_flags dst_flags = (dense ? CL_MAP_WRITE_INVALIDATE_REGION :
+                                      CL_MAP_WRITE);
+
       return [=, &q](event &) {
-         auto dst = _map<T>::get(q, dst_obj, CL_MAP_WRITE,
+         auto dst = _map<T>::get(q, dst_obj, dst_flags,
                                  dot(dst_pitch, dst_orig),
                                  size(dst_pitch, region));
          auto src = _map<S>::get(q, src_obj, CL_MAP_READ,
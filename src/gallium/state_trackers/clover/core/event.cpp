@@ -106,9 +106,48 @@ event::chain(event &ev) {
    ev.deps.push_back(*this);
 }
 
+void
+event::release_deps(const std::function<bool (event &)> &done) {
+   std::vector<intrusive_ref<event>> evs;
+   std::vector<event *> released;
+
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      evs = deps;
+   }
+
+   for (event &ev : evs) {
+      if (done(ev))
+         released.push_back(&ev);
+   }
+
+   if (!released.empty()) {
+      std::lock_guard<std::mutex> lock(mutex);
+      deps.erase(std::remove_if(deps.begin(), deps.end(),
+                                [&](const intrusive_ref<event> &ev) {
+                                   return std::count(released.begin(),
+                                                     released.end(),
+                                                     &ev());
+                                }), deps.end());
+   }
+}
+
+bool
+event::has_deps() const {
+   std::lock_guard<std::mutex> lock(mutex);
+   return !deps.empty();
+}
+
 void
 event::wait() const {
-   for (event &ev : deps)
+   std::vector<intrusive_ref<event>> evs;
+
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      evs = deps;
+   }
+
+   for (event &ev : evs)
       ev.wait();
 
    std::unique_lock<std::mutex> lock(mutex);
@@ -196,6 +235,24 @@ void
 hard_event::fence(pipe_fence_handle *fence) {
    pipe_screen *screen = queue()->device().pipe;
    screen->fence_reference(screen, &_fence, fence);
+   release_complete_deps();
+}
+
+///
+/// Called once the event has been flushed.  Every hard event holds a
+/// reference to the one queued before it, so without this the whole
+/// history of the queue would be kept alive and walked by wait().
+///
+void
+hard_event::release_complete_deps() {
+   release_deps([&](event &ev) {
+         // Commands of the same queue complete in order, so waiting for
+         // this event's fence covers an already flushed predecessor, as
+         // long as it doesn't depend on anything else.
+         return (ev.queue() == queue() && ev.fence() &&
+                 !static_cast<hard_event &>(ev).has_deps()) ||
+            ev.status() == CL_COMPLETE;
+      });
 }
 
 event::action
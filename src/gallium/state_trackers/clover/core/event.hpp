@@ -80,6 +80,10 @@ namespace clover {
    protected:
       void chain(event &ev);
 
+      /// Forget about the dependencies \a done returns true for.
+      void release_deps(const std::function<bool (event &)> &done);
+      bool has_deps() const;
+
       std::vector<intrusive_ref<event>> deps;
 
    private:
@@ -133,6 +137,7 @@ namespace clover {
    private:
       virtual void fence(pipe_fence_handle *fence);
       action profile(command_queue &q, const action &action) const;
+      void release_complete_deps();
 
       const intrusive_ref<command_queue> _queue;
       cl_command_type _command;
@@ -51,7 +51,7 @@ kernel::launch(command_queue &q,
                const std::vector<size_t> &grid_offset,
                const std::vector<size_t> &grid_size,
                const std::vector<size_t> &block_size) {
-   const auto m = program().binary(q.device());
+   const auto &m = program().binary(q.device());
    const auto reduced_grid_size =
       map(divides(), grid_size, block_size);
    void *st = exec.bind(&q, grid_offset);
@@ -160,8 +160,8 @@ kernel::exec_context::bind(intrusive_ptr<command_queue> _q,
 
    // Bind kernel arguments.
    auto &m = kern.program().binary(q->device());
-   auto margs = find(name_equals(kern.name()), m.syms).args;
-   auto msec = find(type_equals(module::section::text), m.secs);
+   auto &margs = find(name_equals(kern.name()), m.syms).args;
+   auto &msec = find(type_equals(module::section::text), m.secs);
    auto explicit_arg = kern._args.begin();
 
    for (auto &marg : margs) {
@@ -29,6 +29,13 @@
 using namespace clover;
 
 namespace {
+   bool
+   is_barrier(const hard_event &ev) {
+      // clFinish() uses a temporary event with no command type.
+      return !ev.command() || ev.command() == CL_COMMAND_MARKER ||
+         ev.command() == CL_COMMAND_BARRIER;
+   }
+
    void
    debug_notify_callback(void *data,
                          unsigned *id,
@@ -69,10 +76,18 @@ command_queue::flush() {
    if (!queued_events.empty()) {
       pipe->flush(pipe, &fence, 0);
 
-      while (!queued_events.empty() &&
-             queued_events.front()().signalled()) {
-         queued_events.front()().fence(fence);
-         queued_events.pop_front();
+      // Everything that has been submitted so far is covered by the fence,
+      // on out-of-order queues that may include events queued after one
+      // that is still waiting for its dependencies.
+      for (auto it = queued_events.begin(); it != queued_events.end();) {
+         if ((*it)().signalled()) {
+            (*it)().fence(fence);
+            it = queued_events.erase(it);
+         } else if (out_of_order()) {
+            ++it;
+         } else {
+            break;
+         }
       }
 
       screen->fence_reference(screen, &fence, NULL);
@@ -89,11 +104,34 @@ command_queue::profiling_enabled() const {
    return props & CL_QUEUE_PROFILING_ENABLE;
 }
 
+bool
+command_queue::out_of_order() const {
+   return props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+}
+
 void
 command_queue::sequence(hard_event &ev) {
    std::lock_guard<std::mutex> lock(queued_events_mutex);
-   if (!queued_events.empty())
-      queued_events.back()().chain(ev);
+
+   if (!out_of_order()) {
+      if (!queued_events.empty())
+         queued_events.back()().chain(ev);
+
+   } else if (is_barrier(ev)) {
+      // Commands that have already been flushed were submitted to the
+      // pipe before this one, only the pending ones need to be waited for.
+      for (hard_event &qev : queued_events)
+         qev.chain(ev);
+
+   } else {
+      // Other commands are only ordered with respect to the last barrier.
+      for (auto it = queued_events.rbegin(); it != queued_events.rend(); ++it) {
+         if ((*it)().command() == CL_COMMAND_BARRIER) {
+            (*it)().chain(ev);
+            break;
+         }
+      }
+   }
 
    queued_events.push_back(ev);
 }
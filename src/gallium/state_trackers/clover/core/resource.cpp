@@ -26,6 +26,8 @@
 #include "util/u_sampler.h"
 #include "util/u_format.h"
 
+#include <unistd.h>
+
 using namespace clover;
 
 namespace {
@@ -141,8 +143,26 @@ root_resource::root_resource(clover::device &dev, memory_obj &obj,
                 PIPE_BIND_TRANSFER_WRITE);
 
    if (obj.flags() & CL_MEM_USE_HOST_PTR && user_ptr_support) {
-      // Page alignment is normally required for this, just try, hope for the
-      // best and fall back if it fails.
+      if (!dynamic_cast<image *>(&obj)) {
+         // Page alignment is normally required for this, so wrap the whole
+         // pages the buffer lies in and point at the buffer within them.
+         const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+         const uintptr_t ptr = (uintptr_t)obj.host_ptr();
+         const uintptr_t start = ptr & ~(page_size - 1);
+         const uintptr_t end = (ptr + obj.size() + page_size - 1) &
+                               ~(page_size - 1);
+         pipe_resource pages_info = info;
+
+         pages_info.width0 = end - start;
+         pipe = dev.pipe->resource_from_user_memory(dev.pipe, &pages_info,
+                                                    (void *)start);
+         if (pipe) {
+            offset[0] = ptr - start;
+            return;
+         }
+      }
+
+      // Just try, hope for the best and fall back if it fails.
       pipe = dev.pipe->resource_from_user_memory(dev.pipe, &info, obj.host_ptr());
       if (pipe)
          return;
@@ -191,7 +211,7 @@ mapping::mapping(command_queue &q, resource &r,
    unsigned usage = ((flags & CL_MAP_WRITE ? PIPE_TRANSFER_WRITE : 0 ) |
                      (flags & CL_MAP_READ ? PIPE_TRANSFER_READ : 0 ) |
                      (flags & CL_MAP_WRITE_INVALIDATE_REGION ?
-                      PIPE_TRANSFER_DISCARD_RANGE : 0) |
+                      PIPE_TRANSFER_WRITE | PIPE_TRANSFER_DISCARD_RANGE : 0) |
                      (!blocking ? PIPE_TRANSFER_UNSYNCHRONIZED : 0));
 
    p = pctx->transfer_map(pctx, r.pipe, 0, usage,
@@ -66,6 +66,8 @@
 #include <llvm-c/Core.h>
 
 #include "pipe/p_state.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
 
@@ -76,6 +78,7 @@
 #include <sstream>
 #include <libelf.h>
 #include <gelf.h>
+#include <sys/stat.h>
 
 using namespace clover;
 
@@ -849,6 +852,115 @@ namespace {
       return debug_flags;
    }
 
+#ifdef ENABLE_SHADER_CACHE
+   ///
+   /// Cache of the modules built by compile_program_llvm(), so that
+   /// programs don't need to go through clang, libclc and the LLVM back-end
+   /// again every time the application is started.
+   ///
+   disk_cache *
+   get_disk_cache() {
+      static disk_cache *const cache = []() -> disk_cache * {
+         char timestamp[256];
+
+         if (!disk_cache_get_function_timestamp(
+                (void *)&clover::compile_program_llvm,
+                timestamp, sizeof(timestamp)))
+            return NULL;
+
+         return disk_cache_create("clover", timestamp);
+      }();
+
+      return cache;
+   }
+
+   void
+   hash_string(mesa_sha1 *ctx, const std::string &str) {
+      const uint32_t size = str.size();
+
+      _mesa_sha1_update(ctx, &size, sizeof(size));
+      _mesa_sha1_update(ctx, str.data(), size);
+   }
+
+   void
+   compute_cache_key(cache_key key, const std::string &source,
+                     const header_map &headers, enum pipe_shader_ir ir,
+                     const std::string &target, const std::string &opts,
+                     const std::string &libclc_path) {
+      const uint32_t llvm_version = (HAVE_LLVM << 8) | MESA_LLVM_VERSION_PATCH;
+      mesa_sha1 *ctx = _mesa_sha1_init();
+      struct stat libclc_stat = {};
+
+      // libclc is linked into every program, its modification time tells
+      // whether it changed since the module was stored.
+      stat(libclc_path.c_str(), &libclc_stat);
+
+      _mesa_sha1_update(ctx, &llvm_version, sizeof(llvm_version));
+      _mesa_sha1_update(ctx, &ir, sizeof(ir));
+      _mesa_sha1_update(ctx, &libclc_stat.st_mtime,
+                        sizeof(libclc_stat.st_mtime));
+      hash_string(ctx, target);
+      hash_string(ctx, opts);
+      hash_string(ctx, source);
+
+      for (auto &header : headers) {
+         hash_string(ctx, header.first);
+         hash_string(ctx, header.second);
+      }
+
+      _mesa_sha1_final(ctx, key);
+   }
+
+   bool
+   load_cached_module(disk_cache *cache, const cache_key key,
+                      module &m, std::string &r_log) {
+      size_t size;
+      char *data = (char *)disk_cache_get(cache, key, &size);
+      uint32_t log_size;
+
+      if (!data)
+         return false;
+
+      try {
+         std::stringbuf bin({ data, size });
+         std::istream s(&bin);
+
+         s.exceptions(std::ios::failbit | std::ios::badbit);
+         s.read((char *)&log_size, sizeof(log_size));
+
+         std::string log(log_size, '\0');
+         s.read(&log[0], log_size);
+
+         m = module::deserialize(s);
+         r_log += log;
+
+      } catch (std::ios::failure &e) {
+         // Corrupted entry, build the program again.
+         disk_cache_remove(cache, key);
+         free(data);
+         return false;
+      }
+
+      free(data);
+      return true;
+   }
+
+   void
+   store_cached_module(disk_cache *cache, const cache_key key,
+                       const module &m, const std::string &log) {
+      const uint32_t log_size = log.size();
+      std::stringbuf bin;
+      std::ostream s(&bin);
+
+      s.write((const char *)&log_size, sizeof(log_size));
+      s.write(log.data(), log_size);
+      m.serialize(s);
+
+      const std::string data = bin.str();
+      disk_cache_put(cache, key, data.data(), data.size());
+   }
+#endif
+
 } // End anonymous namespace
 
 module
@@ -869,6 +981,23 @@ clover::compile_program_llvm(const std::string &source,
    llvm::LLVMContext llvm_ctx;
    unsigned optimization_level;
 
+#ifdef ENABLE_SHADER_CACHE
+   // Don't skip the compilation when its intermediate steps were asked to
+   // be dumped.
+   disk_cache *cache = get_debug_flags() ? NULL : get_disk_cache();
+   cache_key key;
+   const size_t log_start = r_log.size();
+
+   if (cache) {
+      module m;
+
+      compute_cache_key(key, source, headers, ir, target, opts,
+                        LIBCLC_LIBEXECDIR + processor + "-" + triple + ".bc");
+      if (load_cached_module(cache, key, m, r_log))
+         return m;
+   }
+#endif
+
    llvm_ctx.setDiagnosticHandler(diagnostic_handler, &r_log);
 
    if (get_debug_flags() & DBG_CLC)
@@ -914,5 +1043,10 @@ clover::compile_program_llvm(const std::string &source,
    delete mod;
 #endif
 
+#ifdef ENABLE_SHADER_CACHE
+   if (cache)
+      store_cached_module(cache, key, m, r_log.substr(log_start));
+#endif
+
    return m;
 }
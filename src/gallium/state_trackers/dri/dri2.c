@@ -1283,6 +1283,17 @@ dri2_load_opencl_interop(struct dri_screen *screen)
 #if defined(RTLD_DEFAULT)
    bool success;
 
+   /* Every pointer only ever goes from NULL to the one value dlsym returns
+    * for it, so once they are all set they can be used without taking the
+    * lock.  This keeps contexts on different threads from serializing on
+    * every CL event import.
+    */
+   if (p_atomic_read(&screen->opencl_dri_event_add_ref) &&
+       p_atomic_read(&screen->opencl_dri_event_release) &&
+       p_atomic_read(&screen->opencl_dri_event_wait) &&
+       p_atomic_read(&screen->opencl_dri_event_get_fence))
+      return true;
+
    pipe_mutex_lock(screen->opencl_func_mutex);
 
    if (dri2_is_opencl_interop_loaded_locked(screen)) {
@@ -151,6 +151,10 @@ dri_create_context(gl_api api, const struct gl_config * visual,
    ctx->st->st_manager_private = (void *) ctx;
    ctx->stapi = stapi;
 
+   if (ctx->st->start_thread &&
+       driQueryOptionb(&screen->optionCache, "mesa_glthread"))
+      ctx->st->start_thread(ctx->st);
+
    if (ctx->st->cso_context) {
       ctx->pp = pp_init(ctx->st->pipe, screen->pp_enabled, ctx->st->cso_context);
       ctx->hud = hud_create(ctx->st->pipe, ctx->st->cso_context);
@@ -184,6 +188,9 @@ dri_destroy_context(__DRIcontext * cPriv)
     * to avoid having to add code elsewhere to cope with flushing a
     * partially destroyed context.
     */
+   if (ctx->st->thread_finish)
+      ctx->st->thread_finish(ctx->st);
+
    ctx->st->flush(ctx->st, 0, NULL);
    ctx->st->destroy(ctx->st);
    free(ctx);
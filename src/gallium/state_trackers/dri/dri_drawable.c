@@ -451,6 +451,10 @@ dri_flush(__DRIcontext *cPriv,
       return;
    }
 
+   /* Wait for the marshalled GL calls, they may render to the drawable. */
+   if (ctx->st->thread_finish)
+      ctx->st->thread_finish(ctx->st);
+
    if (drawable) {
       /* prevent recursion */
       if (drawable->flushing)
@@ -75,6 +75,16 @@ NineBuffer9_ctor( struct NineBuffer9 *This,
     else if (Pool == D3DPOOL_SYSTEMMEM)
         info->usage = PIPE_USAGE_STAGING;
 
+    /* Games stream geometry into dynamic buffers with a DISCARD lock
+     * followed by many NOOVERWRITE locks. */
+    if ((Usage & D3DUSAGE_DYNAMIC) && Pool == D3DPOOL_DEFAULT &&
+        info->screen->get_param(info->screen,
+                                PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT)) {
+        info->flags = PIPE_RESOURCE_FLAG_MAP_PERSISTENT |
+                      PIPE_RESOURCE_FLAG_MAP_COHERENT;
+        This->dynamic.persistent = TRUE;
+    }
+
     /* if (pDesc->Usage & D3DUSAGE_DONOTCLIP) { } */
     /* if (pDesc->Usage & D3DUSAGE_NONSECURE) { } */
     /* if (pDesc->Usage & D3DUSAGE_NPATCHES) { } */
@@ -125,6 +135,9 @@ NineBuffer9_dtor( struct NineBuffer9 *This )
         FREE(This->maps);
     }
 
+    if (This->dynamic.transfer)
+        This->pipe->transfer_unmap(This->pipe, This->dynamic.transfer);
+
     if (This->base.pool == D3DPOOL_MANAGED) {
         if (This->managed.data)
             align_free(This->managed.data);
@@ -151,7 +164,7 @@ NineBuffer9_Lock( struct NineBuffer9 *This,
                         DWORD Flags )
 {
     struct pipe_box box;
-    void *data;
+    void *data = NULL;
     unsigned usage = d3dlock_buffer_to_pipe_transfer_usage(Flags);
 
     DBG("This=%p(pipe=%p) OffsetToLock=0x%x, SizeToLock=0x%x, Flags=0x%x\n",
@@ -193,6 +206,36 @@ NineBuffer9_Lock( struct NineBuffer9 *This,
         return D3D_OK;
     }
 
+    if (This->dynamic.persistent) {
+        if (Flags & D3DLOCK_DISCARD) {
+            /* The driver gives the buffer new storage, which the persistent
+             * mapping doesn't follow. Locks still holding a pointer into it
+             * keep it alive, the discard then has to synchronize instead. */
+            if (This->dynamic.transfer && !This->nmaps) {
+                This->pipe->transfer_unmap(This->pipe, This->dynamic.transfer);
+                This->dynamic.transfer = NULL;
+                This->dynamic.data = NULL;
+            }
+            if (This->dynamic.transfer)
+                usage = PIPE_TRANSFER_WRITE;
+        } else if (Flags & D3DLOCK_NOOVERWRITE) {
+            if (!This->dynamic.transfer) {
+                struct pipe_box whole;
+
+                u_box_1d(0, This->size, &whole);
+                This->dynamic.data =
+                    This->pipe->transfer_map(This->pipe, This->base.resource, 0,
+                                             PIPE_TRANSFER_WRITE |
+                                             PIPE_TRANSFER_UNSYNCHRONIZED |
+                                             PIPE_TRANSFER_PERSISTENT |
+                                             PIPE_TRANSFER_COHERENT,
+                                             &whole, &This->dynamic.transfer);
+            }
+            if (This->dynamic.data)
+                data = (char *)This->dynamic.data + OffsetToLock;
+        }
+    }
+
     if (This->nmaps == This->maxmaps) {
         struct pipe_transfer **newmaps =
             REALLOC(This->maps, sizeof(struct pipe_transfer *)*This->maxmaps,
@@ -204,8 +247,13 @@ NineBuffer9_Lock( struct NineBuffer9 *This,
         This->maps = newmaps;
     }
 
-    data = This->pipe->transfer_map(This->pipe, This->base.resource, 0,
-                                    usage, &box, &This->maps[This->nmaps]);
+    if (data) {
+        /* Persistently mapped, nothing to unmap */
+        This->maps[This->nmaps] = NULL;
+    } else {
+        data = This->pipe->transfer_map(This->pipe, This->base.resource, 0,
+                                        usage, &box, &This->maps[This->nmaps]);
+    }
 
     if (!data) {
         DBG("pipe::transfer_map failed\n"
@@ -232,9 +280,12 @@ NineBuffer9_Unlock( struct NineBuffer9 *This )
     DBG("This=%p\n", This);
 
     user_assert(This->nmaps > 0, D3DERR_INVALIDCALL);
-    if (This->base.pool != D3DPOOL_MANAGED)
-        This->pipe->transfer_unmap(This->pipe, This->maps[--(This->nmaps)]);
-    else {
+    if (This->base.pool != D3DPOOL_MANAGED) {
+        struct pipe_transfer *transfer = This->maps[--(This->nmaps)];
+
+        if (transfer)
+            This->pipe->transfer_unmap(This->pipe, transfer);
+    } else {
         This->nmaps--;
         /* TODO: Fix this to upload at the first draw call needing the data,
          * instead of at the next draw call */
@@ -43,6 +43,14 @@ struct NineBuffer9
     int nmaps, maxmaps;
     UINT size;
 
+    /* Specific to dynamic buffers: the whole buffer stays mapped between
+     * discards, so that NOOVERWRITE locks don't go through the driver. */
+    struct {
+        boolean persistent; /* resource can be mapped persistently */
+        struct pipe_transfer *transfer;
+        void *data;
+    } dynamic;
+
     /* Specific to managed buffers */
     struct {
         void *data;
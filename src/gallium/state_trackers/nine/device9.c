@@ -43,6 +43,7 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_context.h"
 #include "pipe/p_config.h"
+#include "util/disk_cache.h"
 #include "util/u_math.h"
 #include "util/u_inlines.h"
 #include "util/u_hash_table.h"
@@ -429,6 +430,19 @@ NineDevice9_ctor( struct NineDevice9 *This,
     This->driver_caps.vs_integer = pScreen->get_shader_param(pScreen, PIPE_SHADER_VERTEX, PIPE_SHADER_CAP_INTEGERS);
     This->driver_caps.ps_integer = pScreen->get_shader_param(pScreen, PIPE_SHADER_FRAGMENT, PIPE_SHADER_CAP_INTEGERS);
 
+#ifdef ENABLE_SHADER_CACHE
+    {
+        char timestamp[256];
+
+        /* Translations made by an older build of Nine or of the driver
+         * are not reused. */
+        if (disk_cache_get_function_timestamp((void *)nine_translate_shader,
+                                              timestamp, sizeof(timestamp)))
+            This->shader_cache = disk_cache_create(pScreen->get_name(pScreen),
+                                                   timestamp);
+    }
+#endif
+
     nine_ff_init(This); /* initialize fixed function code */
 
     NineDevice9_SetDefaultState(This, FALSE);
@@ -460,6 +474,9 @@ NineDevice9_dtor( struct NineDevice9 *This )
     nine_ff_fini(This);
     nine_state_clear(&This->state, TRUE);
 
+    if (This->shader_cache)
+        disk_cache_destroy(This->shader_cache);
+
     if (This->vertex_uploader)
         u_upload_destroy(This->vertex_uploader);
     if (This->index_uploader)
@@ -41,6 +41,7 @@ struct u_upload_mgr;
 
 struct NineSwapChain9;
 struct NineStateBlock9;
+struct disk_cache;
 
 #include "util/list.h"
 
@@ -91,6 +92,9 @@ struct NineDevice9
 
     struct gen_mipmap_state *gen_mipmap;
 
+    /* TGSI translations of the application's shaders, NULL if disabled */
+    struct disk_cache *shader_cache;
+
     struct {
         struct util_hash_table *ht_vs;
         struct util_hash_table *ht_ps;
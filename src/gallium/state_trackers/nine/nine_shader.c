@@ -27,7 +27,9 @@
 #include "nine_debug.h"
 #include "nine_state.h"
 
+#include "util/disk_cache.h"
 #include "util/macros.h"
+#include "util/mesa-sha1.h"
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
 #include "pipe/p_shader_tokens.h"
@@ -3305,6 +3307,243 @@ shader_add_ps_fog_stage(struct shader_translator *tx, struct ureg_src src_col)
     ureg_MOV(ureg, ureg_writemask(oCol0, TGSI_WRITEMASK_W), src_col);
 }
 
+#ifdef ENABLE_SHADER_CACHE
+/* Layout of the shader cache entries: the translation results, followed by
+ * the TGSI tokens, the local float constant ranges (bgn, end) and their
+ * values.
+ */
+struct nine_cached_shader
+{
+    uint32_t byte_size;
+    uint32_t const_used_size;
+    uint32_t const_float_slots;
+    uint32_t const_int_slots;
+    uint32_t const_bool_slots;
+    uint32_t num_tokens;
+    uint32_t num_lconstf_ranges;
+    uint32_t num_lconstf;
+    uint16_t input_map[PIPE_MAX_ATTRIBS];
+    uint16_t sampler_mask;
+    uint8_t num_inputs;
+    uint8_t position_t;
+    uint8_t point_size;
+    uint8_t rt_mask;
+    uint8_t bumpenvmat_needed;
+};
+
+/* Size of the byte code up to and including the end token. Instructions of
+ * shader model 1 have no length field, but their parameter tokens all have
+ * bit 31 set, except for the values of def.
+ */
+static DWORD
+sm1_get_byte_size(const DWORD *byte_code)
+{
+    const DWORD *tok = byte_code;
+    const unsigned major = D3DSHADER_VERSION_MAJOR(*tok++);
+
+    while (*tok != NINED3DSP_END) {
+        const DWORD opcode = *tok & D3DSI_OPCODE_MASK;
+
+        if (opcode == D3DSIO_COMMENT)
+            tok += 1 + ((*tok & D3DSI_COMMENTSIZE_MASK) >> D3DSI_COMMENTSIZE_SHIFT);
+        else if (major >= 2)
+            tok += 1 + ((*tok & D3DSI_INSTLENGTH_MASK) >> D3DSI_INSTLENGTH_SHIFT);
+        else if (opcode == D3DSIO_DEF)
+            tok += 6;
+        else
+            for (++tok; *tok & (1u << 31); ++tok);
+    }
+    return (tok + 1 - byte_code) * sizeof(DWORD);
+}
+
+static void
+nine_shader_cache_key(struct NineDevice9 *device,
+                      const struct shader_translator *tx, cache_key key)
+{
+    const struct nine_shader_info *info = tx->info;
+    struct mesa_sha1 *ctx = _mesa_sha1_init();
+    const uint32_t caps =
+        (tx->native_integers << 0) |
+        (tx->inline_subroutines << 1) |
+        (tx->lower_preds << 2) |
+        (tx->want_texcoord << 3) |
+        (tx->shift_wpos << 4) |
+        (tx->wpos_is_sysval << 5) |
+        (tx->face_is_sysval_integer << 6);
+    const uint32_t inputs[] = {
+        info->type,
+        caps,
+        device->max_vs_const_f,
+        device->max_ps_const_f,
+        info->const_i_base,
+        info->const_b_base,
+        info->sampler_mask_shadow,
+        info->fog_enable,
+    };
+
+    _mesa_sha1_update(ctx, inputs, sizeof(inputs));
+
+    /* The variant inputs that only pixel shaders use aren't set for vertex
+     * shaders. */
+    if (info->type == PIPE_SHADER_FRAGMENT) {
+        const uint32_t ps_inputs[] = {
+            info->sampler_ps1xtypes,
+            info->fog_mode,
+            info->force_color_in_centroid,
+            info->projected,
+        };
+
+        _mesa_sha1_update(ctx, ps_inputs, sizeof(ps_inputs));
+    }
+
+    _mesa_sha1_update(ctx, info->byte_code, sm1_get_byte_size(info->byte_code));
+    _mesa_sha1_final(ctx, key);
+}
+
+static void *
+nine_create_shader(struct pipe_context *pipe, unsigned type,
+                   const struct tgsi_token *tokens)
+{
+    struct pipe_shader_state state;
+
+    memset(&state, 0, sizeof(state));
+    state.tokens = tokens;
+
+    if (type == PIPE_SHADER_VERTEX)
+        return pipe->create_vs_state(pipe, &state);
+    return pipe->create_fs_state(pipe, &state);
+}
+
+/* Returns the shader cso and fills the translation results of info if the
+ * shader is in the cache, NULL otherwise. */
+static void *
+nine_shader_cache_load(struct NineDevice9 *device,
+                       struct nine_shader_info *info, const cache_key key)
+{
+    struct nine_cached_shader *entry;
+    const struct tgsi_token *tokens;
+    const uint32_t *ranges;
+    struct nine_range *lranges = NULL;
+    float *ldata = NULL;
+    void *cso;
+    size_t size;
+    unsigned i;
+
+    entry = disk_cache_get(device->shader_cache, key, &size);
+    if (!entry)
+        return NULL;
+
+    if (size < sizeof(*entry) ||
+        size != sizeof(*entry) +
+                entry->num_tokens * sizeof(struct tgsi_token) +
+                entry->num_lconstf_ranges * 2 * sizeof(uint32_t) +
+                entry->num_lconstf * 4 * sizeof(float)) {
+        disk_cache_remove(device->shader_cache, key);
+        free(entry);
+        return NULL;
+    }
+
+    tokens = (const struct tgsi_token *)(entry + 1);
+    ranges = (const uint32_t *)(tokens + entry->num_tokens);
+
+    if (entry->num_lconstf_ranges) {
+        lranges = MALLOC(entry->num_lconstf_ranges * sizeof(lranges[0]));
+        ldata = MALLOC(entry->num_lconstf * 4 * sizeof(float));
+        if (!lranges || !ldata)
+            goto fail;
+
+        for (i = 0; i < entry->num_lconstf_ranges; ++i) {
+            lranges[i].bgn = ranges[i * 2 + 0];
+            lranges[i].end = ranges[i * 2 + 1];
+            lranges[i].next = i + 1 < entry->num_lconstf_ranges ?
+                &lranges[i + 1] : NULL;
+        }
+        memcpy(ldata, &ranges[entry->num_lconstf_ranges * 2],
+               entry->num_lconstf * 4 * sizeof(float));
+    }
+
+    cso = nine_create_shader(device->pipe, info->type, tokens);
+    if (!cso)
+        goto fail;
+
+    info->byte_size = entry->byte_size;
+    info->const_used_size = entry->const_used_size;
+    info->const_float_slots = entry->const_float_slots;
+    info->const_int_slots = entry->const_int_slots;
+    info->const_bool_slots = entry->const_bool_slots;
+    memcpy(info->input_map, entry->input_map, sizeof(info->input_map));
+    info->num_inputs = entry->num_inputs;
+    info->sampler_mask = entry->sampler_mask;
+    info->position_t = entry->position_t;
+    info->point_size = entry->point_size;
+    info->rt_mask = entry->rt_mask;
+    info->bumpenvmat_needed = entry->bumpenvmat_needed;
+    info->lconstf.ranges = lranges;
+    info->lconstf.data = ldata;
+
+    free(entry);
+    return cso;
+
+fail:
+    FREE(lranges);
+    FREE(ldata);
+    free(entry);
+    return NULL;
+}
+
+static void
+nine_shader_cache_store(struct NineDevice9 *device,
+                        const struct nine_shader_info *info,
+                        const cache_key key,
+                        const struct tgsi_token *tokens, unsigned num_tokens)
+{
+    struct nine_cached_shader *entry;
+    const struct nine_range *r;
+    uint32_t *ranges;
+    unsigned num_ranges = 0, num_lconstf = 0;
+    size_t size;
+
+    for (r = info->lconstf.ranges; r; r = r->next) {
+        num_ranges++;
+        num_lconstf += r->end - r->bgn;
+    }
+
+    size = sizeof(*entry) + num_tokens * sizeof(struct tgsi_token) +
+           num_ranges * 2 * sizeof(uint32_t) + num_lconstf * 4 * sizeof(float);
+    entry = CALLOC(1, size);
+    if (!entry)
+        return;
+
+    entry->byte_size = info->byte_size;
+    entry->const_used_size = info->const_used_size;
+    entry->const_float_slots = info->const_float_slots;
+    entry->const_int_slots = info->const_int_slots;
+    entry->const_bool_slots = info->const_bool_slots;
+    entry->num_tokens = num_tokens;
+    entry->num_lconstf_ranges = num_ranges;
+    entry->num_lconstf = num_lconstf;
+    memcpy(entry->input_map, info->input_map, sizeof(entry->input_map));
+    entry->num_inputs = info->num_inputs;
+    entry->sampler_mask = info->sampler_mask;
+    entry->position_t = info->position_t;
+    entry->point_size = info->point_size;
+    entry->rt_mask = info->rt_mask;
+    entry->bumpenvmat_needed = info->bumpenvmat_needed;
+
+    memcpy(entry + 1, tokens, num_tokens * sizeof(struct tgsi_token));
+    ranges = (uint32_t *)((struct tgsi_token *)(entry + 1) + num_tokens);
+    for (r = info->lconstf.ranges; r; r = r->next) {
+        *ranges++ = r->bgn;
+        *ranges++ = r->end;
+    }
+    if (num_lconstf)
+        memcpy(ranges, info->lconstf.data, num_lconstf * 4 * sizeof(float));
+
+    disk_cache_put(device->shader_cache, key, entry, size);
+    FREE(entry);
+}
+#endif
+
 #define GET_CAP(n) device->screen->get_param( \
       device->screen, PIPE_CAP_##n)
 #define GET_SHADER_CAP(n) device->screen->get_shader_param( \
@@ -3318,6 +3557,12 @@ nine_translate_shader(struct NineDevice9 *device, struct nine_shader_info *info)
     const unsigned processor = info->type;
     unsigned s, slot_max;
     unsigned max_const_f;
+    const boolean dump = debug_get_bool_option("NINE_TGSI_DUMP", FALSE);
+#ifdef ENABLE_SHADER_CACHE
+    /* Don't skip the translation when its result was asked to be dumped. */
+    const boolean use_cache = device->shader_cache && !dump;
+    cache_key key;
+#endif
 
     user_assert(processor != ~0, D3DERR_INVALIDCALL);
 
@@ -3340,12 +3585,6 @@ nine_translate_shader(struct NineDevice9 *device, struct nine_shader_info *info)
     DUMP("%s%u.%u\n", processor == PIPE_SHADER_VERTEX ? "VS" : "PS",
          tx->version.major, tx->version.minor);
 
-    tx->ureg = ureg_create(processor);
-    if (!tx->ureg) {
-        hr = E_OUTOFMEMORY;
-        goto out;
-    }
-
     tx->native_integers = GET_SHADER_CAP(INTEGERS);
     tx->inline_subroutines = !GET_SHADER_CAP(SUBROUTINES);
     tx->lower_preds = !GET_SHADER_CAP(MAX_PREDS);
@@ -3356,6 +3595,21 @@ nine_translate_shader(struct NineDevice9 *device, struct nine_shader_info *info)
     tx->wpos_is_sysval = GET_CAP(TGSI_FS_POSITION_IS_SYSVAL);
     tx->face_is_sysval_integer = GET_CAP(TGSI_FS_FACE_IS_INTEGER_SYSVAL);
 
+#ifdef ENABLE_SHADER_CACHE
+    if (use_cache) {
+        nine_shader_cache_key(device, tx, key);
+        info->cso = nine_shader_cache_load(device, info, key);
+        if (info->cso)
+            goto out;
+    }
+#endif
+
+    tx->ureg = ureg_create(processor);
+    if (!tx->ureg) {
+        hr = E_OUTOFMEMORY;
+        goto out;
+    }
+
     if (IS_VS) {
         tx->num_constf_allowed = NINE_MAX_CONST_F;
     } else if (tx->version.major < 2) {/* IS_PS v1 */
@@ -3499,14 +3753,28 @@ nine_translate_shader(struct NineDevice9 *device, struct nine_shader_info *info)
     for (s = 0; s < slot_max; s++)
         ureg_DECL_constant(tx->ureg, s);
 
-    if (debug_get_bool_option("NINE_TGSI_DUMP", FALSE)) {
+    if (dump) {
         unsigned count;
         const struct tgsi_token *toks = ureg_get_tokens(tx->ureg, &count);
         tgsi_dump(toks, 0);
         ureg_free_tokens(toks);
     }
 
-    info->cso = ureg_create_shader_and_destroy(tx->ureg, device->pipe);
+    info->byte_size = (tx->parse - tx->byte_code) * sizeof(DWORD);
+
+#ifdef ENABLE_SHADER_CACHE
+    if (use_cache) {
+        unsigned count;
+        const struct tgsi_token *toks = ureg_get_tokens(tx->ureg, &count);
+
+        ureg_destroy(tx->ureg);
+        info->cso = nine_create_shader(device->pipe, processor, toks);
+        if (info->cso)
+            nine_shader_cache_store(device, info, key, toks, count);
+        ureg_free_tokens(toks);
+    } else
+#endif
+        info->cso = ureg_create_shader_and_destroy(tx->ureg, device->pipe);
     if (!info->cso) {
         hr = D3DERR_DRIVERINTERNALERROR;
         FREE(info->lconstf.data);
@@ -3514,7 +3782,6 @@ nine_translate_shader(struct NineDevice9 *device, struct nine_shader_info *info)
         goto out;
     }
 
-    info->byte_size = (tx->parse - tx->byte_code) * sizeof(DWORD);
 out:
     tx_dtor(tx);
     return hr;
@@ -58,6 +58,8 @@ NinePixelShader9_ctor( struct NinePixelShader9 *This,
     info.sampler_mask_shadow = 0x0;
     info.sampler_ps1xtypes = 0x0;
     info.fog_enable = 0;
+    info.fog_mode = 0;
+    info.force_color_in_centroid = 0;
     info.projected = 0;
 
     hr = nine_translate_shader(device, &info);
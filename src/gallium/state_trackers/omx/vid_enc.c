@@ -910,6 +910,9 @@ static OMX_ERRORTYPE enc_LoadImage(omx_base_PortType *port, OMX_BUFFERHEADERTYPE
       priv->s_pipe->transfer_inline_write(priv->s_pipe, views[1]->texture, 0,
                                           PIPE_TRANSFER_WRITE, &box,
                                           ptr, def->nStride, 0);
+
+      /* The upload may have gone through a copy on the GPU. */
+      priv->s_pipe->flush(priv->s_pipe, NULL, 0);
    } else {
       struct pipe_blit_info blit;
       struct vl_video_buffer *dst_buf = (struct vl_video_buffer *)vbuf;
@@ -961,7 +964,7 @@ static OMX_ERRORTYPE enc_LoadImage(omx_base_PortType *port, OMX_BUFFERHEADERTYPE
    return OMX_ErrorNone;
 }
 
-static void enc_ScaleInput(omx_base_PortType *port, struct pipe_video_buffer **vbuf, unsigned *size)
+static bool enc_ScaleInput(omx_base_PortType *port, struct pipe_video_buffer **vbuf, unsigned *size)
 {
    OMX_COMPONENTTYPE* comp = port->standCompContainer;
    vid_enc_PrivateType *priv = comp->pComponentPrivate;
@@ -974,7 +977,7 @@ static void enc_ScaleInput(omx_base_PortType *port, struct pipe_video_buffer **v
    unsigned i;
 
    if (!priv->scale_buffer[priv->current_scale_buffer])
-      return;
+      return false;
 
    views = src_buf->get_sampler_view_planes(src_buf);
    dst_surface = priv->scale_buffer[priv->current_scale_buffer]->get_surfaces
@@ -999,6 +1002,7 @@ static void enc_ScaleInput(omx_base_PortType *port, struct pipe_video_buffer **v
    *size  = priv->scale.xWidth * priv->scale.xHeight * 2;
    *vbuf = priv->scale_buffer[priv->current_scale_buffer++];
    priv->current_scale_buffer %= OMX_VID_ENC_NUM_SCALING_BUFFERS;
+   return true;
 }
 
 static void enc_ControlPicture(omx_base_PortType *port, struct pipe_h264_enc_picture_desc *picture)
@@ -1071,8 +1075,9 @@ static void enc_HandleTask(omx_base_PortType *port, struct encode_task *task,
    struct pipe_h264_enc_picture_desc picture = {};
 
    /* -------------- scale input image --------- */
-   enc_ScaleInput(port, &vbuf, &size);
-   priv->s_pipe->flush(priv->s_pipe, NULL, 0);
+   /* enc_LoadImage already flushed the upload of the input image. */
+   if (enc_ScaleInput(port, &vbuf, &size))
+      priv->s_pipe->flush(priv->s_pipe, NULL, 0);
 
    /* -------------- allocate output buffer --------- */
    task->bitstream = pipe_buffer_create(priv->s_pipe->screen, PIPE_BIND_VERTEX_BUFFER,
@@ -35,12 +35,15 @@
  * display target resource.  However, softpipe doesn't support "upside-down"
  * rendering which would be needed for the OSMESA_Y_UP=TRUE case.
  *
- * With llvmpipe we could only render directly into the user's buffer when its
+ * With llvmpipe we can only render directly into the user's buffer when its
  * width and height is a multiple of the tile size (64 pixels).
  *
- * Because of these constraints we always render into ordinary resources then
- * copy the results to the user's buffer in the flush_front() function which
- * is called when the app calls glFlush/Finish.
+ * So when the user's buffer is stored top to bottom (OSMESA_Y_UP=FALSE)
+ * without extra row padding, we ask the driver to wrap it with
+ * resource_from_user_memory().  Otherwise, or if the driver refuses, we
+ * render into ordinary resources then copy the results to the user's buffer
+ * in the flush_front() function which is called when the app calls
+ * glFlush/Finish.
  *
  * In general, the OSMesa interface is pretty ugly and not a good match
  * for Gallium.  But we're interested in doing the best we can to preserve
@@ -87,6 +90,11 @@ struct osmesa_buffer
 
    void *map;
 
+   /** Is the user's buffer laid out like the driver's color buffer? */
+   boolean user_layout;
+   /** Does the front color resource wrap the user's buffer? */
+   boolean direct;
+
    struct osmesa_buffer *next;  /**< next in linked list */
 };
 
@@ -346,6 +354,14 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
    map = pipe->transfer_map(pipe, res, 0, PIPE_TRANSFER_READ, &box,
                             &transfer);
 
+   if (statt == ST_ATTACHMENT_FRONT_LEFT && osbuffer->direct) {
+      /* The image is already in the user's buffer, mapping it was only
+       * needed to wait for rendering to finish.
+       */
+      pipe->transfer_unmap(pipe, transfer);
+      return TRUE;
+   }
+
    /*
     * Copy the color buffer from the resource to the user's buffer.
     */
@@ -432,8 +448,18 @@ osmesa_st_framebuffer_validate(struct st_context_iface *stctx,
 
       templat.format = format;
       templat.bind = bind;
-      out[i] = osbuffer->textures[statts[i]] =
-         screen->resource_create(screen, &templat);
+      out[i] = NULL;
+
+      if (statts[i] == ST_ATTACHMENT_FRONT_LEFT) {
+         if (osbuffer->user_layout && screen->resource_from_user_memory)
+            out[i] = screen->resource_from_user_memory(screen, &templat,
+                                                       osbuffer->map);
+         osbuffer->direct = out[i] != NULL;
+      }
+
+      if (!out[i])
+         out[i] = screen->resource_create(screen, &templat);
+      osbuffer->textures[statts[i]] = out[i];
    }
 
    return TRUE;
@@ -505,6 +531,30 @@ osmesa_find_buffer(enum pipe_format color_format,
 }
 
 
+/**
+ * Point the buffer at the user's memory.  If the color buffer could be
+ * rendered directly into it, or is and no longer can, bump the stamp so
+ * that the state tracker revalidates the attachments.
+ */
+static void
+osmesa_set_user_buffer(OSMesaContext osmesa, struct osmesa_buffer *osbuffer,
+                       void *map)
+{
+   const boolean user_layout = !osmesa->y_up &&
+      (!osmesa->user_row_length ||
+       osmesa->user_row_length == osbuffer->width);
+
+   if (map == osbuffer->map && user_layout == osbuffer->user_layout)
+      return;
+
+   if (user_layout || osbuffer->direct)
+      p_atomic_inc(&osbuffer->stfb->stamp);
+
+   osbuffer->map = map;
+   osbuffer->user_layout = user_layout;
+}
+
+
 static void
 osmesa_destroy_buffer(struct osmesa_buffer *osbuffer)
 {
@@ -776,7 +826,7 @@ OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
 
    osbuffer->width = width;
    osbuffer->height = height;
-   osbuffer->map = buffer;
+   osmesa_set_user_buffer(osmesa, osbuffer, buffer);
 
    /* XXX unused for now */
    (void) osmesa_destroy_buffer;
@@ -840,6 +890,10 @@ OSMesaPixelStore(GLint pname, GLint value)
       fprintf(stderr, "Invalid pname in OSMesaPixelStore()\n");
       return;
    }
+
+   if (osmesa->current_buffer)
+      osmesa_set_user_buffer(osmesa, osmesa->current_buffer,
+                             osmesa->current_buffer->map);
 }
 
 
@@ -27,6 +27,7 @@
  **************************************************************************/
 
 #include "pipe/p_screen.h"
+#include "state_tracker/drm_driver.h"
 
 #include "util/u_memory.h"
 #include "util/u_handle_table.h"
@@ -186,6 +187,9 @@ vlVaDeriveImage(VADriverContextP ctx, VASurfaceID surface, VAImage *image)
    vlVaBuffer *img_buf;
    VAImage *img;
    struct pipe_surface **surfaces;
+   struct pipe_screen *screen;
+   struct winsys_handle whandle;
+   unsigned cpp;
    int w;
    int h;
    int i;
@@ -230,20 +234,14 @@ vlVaDeriveImage(VADriverContextP ctx, VASurfaceID surface, VAImage *image)
    switch (img->format.fourcc) {
    case VA_FOURCC('U','Y','V','Y'):
    case VA_FOURCC('Y','U','Y','V'):
-      img->num_planes = 1;
-      img->pitches[0] = w * 2;
-      img->offsets[0] = 0;
-      img->data_size  = w * h * 2;
+      cpp = 2;
       break;
 
    case VA_FOURCC('B','G','R','A'):
    case VA_FOURCC('R','G','B','A'):
    case VA_FOURCC('B','G','R','X'):
    case VA_FOURCC('R','G','B','X'):
-      img->num_planes = 1;
-      img->pitches[0] = w * 4;
-      img->offsets[0] = 0;
-      img->data_size  = w * h * 4;
+      cpp = 4;
       break;
 
    default:
@@ -252,6 +250,27 @@ vlVaDeriveImage(VADriverContextP ctx, VASurfaceID surface, VAImage *image)
       return VA_STATUS_ERROR_INVALID_IMAGE_FORMAT;
    }
 
+   img->num_planes = 1;
+   img->pitches[0] = w * cpp;
+   img->offsets[0] = 0;
+
+   /* The image is mapped and exported as the surface's storage, so describe
+    * the real layout of it. Otherwise importers of the exported buffer need
+    * to copy it into a layout they know.
+    */
+   screen = VL_VA_PSCREEN(ctx);
+   memset(&whandle, 0, sizeof(whandle));
+   whandle.type = DRM_API_HANDLE_TYPE_KMS;
+   if (screen->resource_get_handle &&
+       screen->resource_get_handle(screen, surfaces[0]->texture, &whandle,
+                                   PIPE_HANDLE_USAGE_READ_WRITE) &&
+       whandle.stride >= img->pitches[0]) {
+      img->pitches[0] = whandle.stride;
+      img->offsets[0] = whandle.offset;
+   }
+
+   img->data_size = img->offsets[0] + img->pitches[0] * h;
+
    img_buf = CALLOC(1, sizeof(vlVaBuffer));
    if (!img_buf) {
       FREE(img);
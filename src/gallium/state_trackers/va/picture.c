@@ -29,6 +29,7 @@
 #include "pipe/p_video_codec.h"
 
 #include "util/u_handle_table.h"
+#include "util/u_memory.h"
 #include "util/u_video.h"
 
 #include "vl/vl_vlc.h"
@@ -222,8 +223,28 @@ bufHasStartcode(vlVaBuffer *buf, unsigned int code, unsigned int bits)
    return 0;
 }
 
+/* Slices collected during one vlVaRenderPicture call, to be passed to the
+ * decoder together. */
+struct slice_batch {
+   unsigned num_buffers;
+   const void **buffers;
+   unsigned *sizes;
+};
+
+static void
+flushSliceBatch(vlVaContext *context, struct slice_batch *batch)
+{
+   if (!batch->num_buffers)
+      return;
+
+   context->decoder->decode_bitstream(context->decoder, context->target, &context->desc.base,
+      batch->num_buffers, (const void * const*)batch->buffers, batch->sizes);
+   batch->num_buffers = 0;
+}
+
 static void
-handleVASliceDataBufferType(vlVaContext *context, vlVaBuffer *buf)
+handleVASliceDataBufferType(vlVaContext *context, vlVaBuffer *buf,
+                            struct slice_batch *batch)
 {
    enum pipe_video_format format;
    unsigned num_buffers = 0;
@@ -274,6 +295,23 @@ handleVASliceDataBufferType(vlVaContext *context, vlVaBuffer *buf)
    buffers[num_buffers] = buf->data;
    sizes[num_buffers] = buf->size;
    ++num_buffers;
+
+   /* The H.264 and HEVC start codes are constant and the slice parameters
+    * are only used once the picture is complete, so the slices can be
+    * submitted at once instead of one decode_bitstream call each. */
+   if (batch->buffers &&
+       (format == PIPE_VIDEO_FORMAT_MPEG4_AVC ||
+        format == PIPE_VIDEO_FORMAT_HEVC)) {
+      unsigned i;
+
+      for (i = 0; i < num_buffers; ++i) {
+         batch->buffers[batch->num_buffers] = buffers[i];
+         batch->sizes[batch->num_buffers++] = sizes[i];
+      }
+      return;
+   }
+
+   flushSliceBatch(context, batch);
    context->decoder->decode_bitstream(context->decoder, context->target, &context->desc.base,
       num_buffers, (const void * const*)buffers, sizes);
 }
@@ -284,6 +322,7 @@ vlVaRenderPicture(VADriverContextP ctx, VAContextID context_id, VABufferID *buff
    vlVaDriver *drv;
    vlVaContext *context;
    VAStatus vaStatus = VA_STATUS_SUCCESS;
+   struct slice_batch batch = {0};
 
    unsigned i;
 
@@ -301,13 +340,32 @@ vlVaRenderPicture(VADriverContextP ctx, VAContextID context_id, VABufferID *buff
       return VA_STATUS_ERROR_INVALID_CONTEXT;
    }
 
+   /* Each slice data buffer may need a start code in front of it. Without
+    * memory for the batch, slices are simply submitted one by one. */
+   if (num_buffers > 1) {
+      batch.buffers = MALLOC(2 * num_buffers * sizeof(*batch.buffers));
+      batch.sizes = MALLOC(2 * num_buffers * sizeof(*batch.sizes));
+      if (!batch.buffers || !batch.sizes) {
+         FREE(batch.buffers);
+         batch.buffers = NULL;
+      }
+   }
+
    for (i = 0; i < num_buffers; ++i) {
       vlVaBuffer *buf = handle_table_get(drv->htab, buffers[i]);
       if (!buf) {
+         flushSliceBatch(context, &batch);
+         FREE(batch.buffers);
+         FREE(batch.sizes);
          pipe_mutex_unlock(drv->mutex);
          return VA_STATUS_ERROR_INVALID_BUFFER;
       }
 
+      /* Anything but slices may change the picture description. */
+      if (buf->type != VASliceParameterBufferType &&
+          buf->type != VASliceDataBufferType)
+         flushSliceBatch(context, &batch);
+
       switch (buf->type) {
       case VAPictureParameterBufferType:
          vaStatus = handlePictureParameterBuffer(drv, context, buf);
@@ -322,7 +380,7 @@ vlVaRenderPicture(VADriverContextP ctx, VAContextID context_id, VABufferID *buff
          break;
 
       case VASliceDataBufferType:
-         handleVASliceDataBufferType(context, buf);
+         handleVASliceDataBufferType(context, buf, &batch);
          break;
       case VAProcPipelineParameterBufferType:
          vaStatus = vlVaHandleVAProcPipelineParameterBufferType(drv, context, buf);
@@ -332,6 +390,9 @@ vlVaRenderPicture(VADriverContextP ctx, VAContextID context_id, VABufferID *buff
          break;
       }
    }
+   flushSliceBatch(context, &batch);
+   FREE(batch.buffers);
+   FREE(batch.sizes);
    pipe_mutex_unlock(drv->mutex);
 
    return vaStatus;
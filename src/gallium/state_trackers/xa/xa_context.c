@@ -32,6 +32,7 @@
 #include "util/u_inlines.h"
 #include "util/u_rect.h"
 #include "util/u_surface.h"
+#include "util/u_upload_mgr.h"
 #include "pipe/p_context.h"
 
 XA_EXPORT void
@@ -42,6 +43,8 @@ xa_context_flush(struct xa_context *ctx)
         screen->fence_reference(screen, &ctx->last_fence, NULL);
     }
     ctx->pipe->flush(ctx->pipe, &ctx->last_fence, 0);
+    if (ctx->last_fence)
+        u_upload_fence(ctx->vb_upload, ctx->last_fence);
 }
 
 XA_EXPORT struct xa_context *
@@ -58,6 +61,9 @@ xa_context_create(struct xa_tracker *xa)
     ctx->xa = xa;
     ctx->pipe = xa->screen->context_create(xa->screen, NULL, 0);
     ctx->cso = cso_create_context(ctx->pipe);
+    ctx->vb_upload = u_upload_create(ctx->pipe, XA_VB_UPLOAD_SIZE,
+                                     PIPE_BIND_VERTEX_BUFFER,
+                                     PIPE_USAGE_STREAM);
     ctx->shaders = xa_shaders_create(ctx);
     renderer_init_state(ctx);
 
@@ -90,6 +96,9 @@ xa_context_destroy(struct xa_context *r)
 	r->cso = NULL;
     }
 
+    if (r->vb_upload)
+	u_upload_destroy(r->vb_upload);
+
     r->pipe->destroy(r->pipe);
 }
 
@@ -47,6 +47,7 @@
 #endif
 
 #define XA_VB_SIZE (100 * 4 * 3 * 4)
+#define XA_VB_UPLOAD_SIZE (64 * 1024)
 #define XA_LAST_SURFACE_TYPE (xa_type_yuv_component + 1)
 #define XA_MAX_SAMPLERS 3
 
@@ -88,6 +89,9 @@ struct xa_context {
     struct cso_context *cso;
     struct xa_shaders *shaders;
 
+    /* vertex data of each batch is streamed through this */
+    struct u_upload_mgr *vb_upload;
+
     struct pipe_resource *vs_const_buffer;
     struct pipe_resource *fs_const_buffer;
 
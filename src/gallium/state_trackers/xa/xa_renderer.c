@@ -33,6 +33,7 @@
 #include "util/u_inlines.h"
 #include "util/u_sampler.h"
 #include "util/u_draw_quad.h"
+#include "util/u_upload_mgr.h"
 
 #define floatsEqual(x, y) (fabs(x - y) <= 0.00001f * MIN2(fabs(x), fabs(y)))
 #define floatIsZero(x) (floatsEqual((x) + 1, 1))
@@ -89,9 +90,28 @@ renderer_draw(struct xa_context *r)
     r->pipe->set_scissor_states(r->pipe, 0, 1, &r->scissor);
 
     cso_set_vertex_elements(r->cso, r->attrs_per_vertex, r->velems);
-    util_draw_user_vertex_buffer(r->cso, r->buffer, PIPE_PRIM_QUADS,
-                                 num_verts,	/* verts */
-                                 r->attrs_per_vertex);	/* attribs/vert */
+
+    /* Stream the batch through the upload buffer, rather than handing
+     * the driver a user buffer it has to copy into a new one every time.
+     */
+    if (r->vb_upload) {
+	struct pipe_vertex_buffer vbuffer = {0};
+
+	vbuffer.stride = r->attrs_per_vertex * NUM_COMPONENTS * sizeof(float);
+	u_upload_data(r->vb_upload, 0, r->buffer_size * sizeof(float), 4,
+		      r->buffer, &vbuffer.buffer_offset, &vbuffer.buffer);
+	u_upload_unmap(r->vb_upload);
+
+	if (vbuffer.buffer) {
+	    cso_set_vertex_buffers(r->cso, 0, 1, &vbuffer);
+	    cso_draw_arrays(r->cso, PIPE_PRIM_QUADS, 0, num_verts);
+	    pipe_resource_reference(&vbuffer.buffer, NULL);
+	}
+    } else {
+	util_draw_user_vertex_buffer(r->cso, r->buffer, PIPE_PRIM_QUADS,
+				     num_verts,	/* verts */
+				     r->attrs_per_vertex);	/* attribs/vert */
+    }
     r->buffer_size = 0;
 
     xa_scissor_reset(r);
@@ -0,0 +1,388 @@
+/**************************************************************************
+ *
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Measures the CPU cost of common pipe_context operations: draws, state
+ * changes, buffer maps and shader compiles.  Each test is run for a fixed
+ * number of iterations and the average time per call is printed.
+ *
+ * Run with GALLIUM_NOOP=1 to get the baseline cost of the calls themselves,
+ * without the driver doing any work.
+ */
+
+#define WIDTH 64
+#define HEIGHT 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_state.h"
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_shader_tokens.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_sampler.h"
+#include "util/u_simple_shaders.h"
+#include "os/os_time.h"
+#include "pipe-loader/pipe_loader.h"
+
+struct program
+{
+	struct pipe_loader_device *dev;
+	struct pipe_screen *screen;
+	struct pipe_context *pipe;
+
+	void *blend[2];
+	void *dsa;
+	void *rasterizer;
+	void *sampler;
+	void *velem[2];
+	void *vs;
+	void *fs;
+
+	struct pipe_resource *vbuf;
+	struct pipe_resource *target;
+	struct pipe_resource *tex[2];
+	struct pipe_sampler_view *view[2];
+	struct pipe_framebuffer_state framebuffer;
+};
+
+typedef void (*test_func)(struct program *p, unsigned i);
+
+static void init_prog(struct program *p)
+{
+	struct pipe_blend_state blend;
+	struct pipe_depth_stencil_alpha_state dsa;
+	struct pipe_rasterizer_state rasterizer;
+	struct pipe_sampler_state sampler;
+	struct pipe_vertex_element velem[2];
+	struct pipe_viewport_state viewport;
+	struct pipe_resource tmplt;
+	struct pipe_surface surf_tmpl;
+	struct pipe_sampler_view view_tmpl;
+	struct pipe_vertex_buffer vbuf;
+	const uint semantic_names[] = { TGSI_SEMANTIC_POSITION,
+					TGSI_SEMANTIC_GENERIC };
+	const uint semantic_indexes[] = { 0, 0 };
+	float vertices[3][2][4] = {
+		{ { 0.0f, -0.9f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+		{ { -0.9f, 0.9f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
+		{ { 0.9f, 0.9f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } }
+	};
+	unsigned i;
+	int ret;
+
+	ret = pipe_loader_probe(&p->dev, 1);
+	if (!ret) {
+		fprintf(stderr, "no device found\n");
+		exit(1);
+	}
+
+	p->screen = pipe_loader_create_screen(p->dev);
+	if (!p->screen) {
+		fprintf(stderr, "failed to create the screen\n");
+		exit(1);
+	}
+
+	p->pipe = p->screen->context_create(p->screen, NULL, 0);
+
+	/* two blend states, so that binding one of them is a real change */
+	memset(&blend, 0, sizeof(blend));
+	blend.rt[0].colormask = PIPE_MASK_RGBA;
+	p->blend[0] = p->pipe->create_blend_state(p->pipe, &blend);
+	blend.rt[0].blend_enable = 1;
+	blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+	blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+	blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+	blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+	blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+	blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_ZERO;
+	p->blend[1] = p->pipe->create_blend_state(p->pipe, &blend);
+
+	memset(&dsa, 0, sizeof(dsa));
+	p->dsa = p->pipe->create_depth_stencil_alpha_state(p->pipe, &dsa);
+
+	memset(&rasterizer, 0, sizeof(rasterizer));
+	rasterizer.cull_face = PIPE_FACE_NONE;
+	rasterizer.half_pixel_center = 1;
+	rasterizer.bottom_edge_rule = 1;
+	rasterizer.depth_clip = 1;
+	p->rasterizer = p->pipe->create_rasterizer_state(p->pipe, &rasterizer);
+
+	memset(&sampler, 0, sizeof(sampler));
+	sampler.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+	sampler.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+	sampler.wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+	sampler.min_img_filter = PIPE_TEX_FILTER_NEAREST;
+	sampler.mag_img_filter = PIPE_TEX_FILTER_NEAREST;
+	sampler.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+	sampler.normalized_coords = 1;
+	p->sampler = p->pipe->create_sampler_state(p->pipe, &sampler);
+
+	/* two vertex element layouts, standing in for VAO switches */
+	memset(velem, 0, sizeof(velem));
+	velem[0].src_offset = 0;
+	velem[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+	velem[1].src_offset = 4 * sizeof(float);
+	velem[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+	p->velem[0] = p->pipe->create_vertex_elements_state(p->pipe, 2, velem);
+	velem[1].src_format = PIPE_FORMAT_R32G32B32_FLOAT;
+	p->velem[1] = p->pipe->create_vertex_elements_state(p->pipe, 2, velem);
+
+	p->vs = util_make_vertex_passthrough_shader(p->pipe, 2, semantic_names,
+						    semantic_indexes, FALSE);
+	p->fs = util_make_fragment_tex_shader(p->pipe, TGSI_TEXTURE_2D,
+					      TGSI_INTERPOLATE_LINEAR,
+					      TGSI_RETURN_TYPE_FLOAT);
+
+	p->vbuf = pipe_buffer_create(p->screen, PIPE_BIND_VERTEX_BUFFER,
+				     PIPE_USAGE_DEFAULT, sizeof(vertices));
+	pipe_buffer_write(p->pipe, p->vbuf, 0, sizeof(vertices), vertices);
+
+	memset(&tmplt, 0, sizeof(tmplt));
+	tmplt.target = PIPE_TEXTURE_2D;
+	tmplt.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+	tmplt.width0 = WIDTH;
+	tmplt.height0 = HEIGHT;
+	tmplt.depth0 = 1;
+	tmplt.array_size = 1;
+	tmplt.bind = PIPE_BIND_RENDER_TARGET;
+	p->target = p->screen->resource_create(p->screen, &tmplt);
+
+	tmplt.bind = PIPE_BIND_SAMPLER_VIEW;
+	for (i = 0; i < 2; i++) {
+		p->tex[i] = p->screen->resource_create(p->screen, &tmplt);
+		u_sampler_view_default_template(&view_tmpl, p->tex[i],
+						p->tex[i]->format);
+		p->view[i] = p->pipe->create_sampler_view(p->pipe, p->tex[i],
+							  &view_tmpl);
+	}
+
+	memset(&surf_tmpl, 0, sizeof(surf_tmpl));
+	surf_tmpl.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+	memset(&p->framebuffer, 0, sizeof(p->framebuffer));
+	p->framebuffer.width = WIDTH;
+	p->framebuffer.height = HEIGHT;
+	p->framebuffer.nr_cbufs = 1;
+	p->framebuffer.cbufs[0] = p->pipe->create_surface(p->pipe, p->target,
+							  &surf_tmpl);
+
+	memset(&viewport, 0, sizeof(viewport));
+	viewport.scale[0] = WIDTH / 2.0f;
+	viewport.scale[1] = HEIGHT / 2.0f;
+	viewport.scale[2] = 1.0f;
+	viewport.translate[0] = WIDTH / 2.0f;
+	viewport.translate[1] = HEIGHT / 2.0f;
+
+	memset(&vbuf, 0, sizeof(vbuf));
+	vbuf.stride = sizeof(vertices[0]);
+	vbuf.buffer = p->vbuf;
+
+	/* bind everything a draw needs once, the tests only change one thing */
+	p->pipe->set_framebuffer_state(p->pipe, &p->framebuffer);
+	p->pipe->set_viewport_states(p->pipe, 0, 1, &viewport);
+	p->pipe->bind_blend_state(p->pipe, p->blend[0]);
+	p->pipe->bind_depth_stencil_alpha_state(p->pipe, p->dsa);
+	p->pipe->bind_rasterizer_state(p->pipe, p->rasterizer);
+	p->pipe->bind_vertex_elements_state(p->pipe, p->velem[0]);
+	p->pipe->set_vertex_buffers(p->pipe, 0, 1, &vbuf);
+	p->pipe->bind_vs_state(p->pipe, p->vs);
+	p->pipe->bind_fs_state(p->pipe, p->fs);
+	p->pipe->bind_sampler_states(p->pipe, PIPE_SHADER_FRAGMENT, 0, 1,
+				     &p->sampler);
+	p->pipe->set_sampler_views(p->pipe, PIPE_SHADER_FRAGMENT, 0, 1,
+				   &p->view[0]);
+}
+
+static void close_prog(struct program *p)
+{
+	unsigned i;
+
+	p->pipe->bind_blend_state(p->pipe, NULL);
+	p->pipe->bind_depth_stencil_alpha_state(p->pipe, NULL);
+	p->pipe->bind_rasterizer_state(p->pipe, NULL);
+	p->pipe->bind_vertex_elements_state(p->pipe, NULL);
+	p->pipe->bind_vs_state(p->pipe, NULL);
+	p->pipe->bind_fs_state(p->pipe, NULL);
+	p->pipe->set_vertex_buffers(p->pipe, 0, 1, NULL);
+	p->pipe->set_sampler_views(p->pipe, PIPE_SHADER_FRAGMENT, 0, 1, NULL);
+	p->pipe->bind_sampler_states(p->pipe, PIPE_SHADER_FRAGMENT, 0, 1, NULL);
+
+	for (i = 0; i < 2; i++) {
+		p->pipe->delete_blend_state(p->pipe, p->blend[i]);
+		p->pipe->delete_vertex_elements_state(p->pipe, p->velem[i]);
+		pipe_sampler_view_reference(&p->view[i], NULL);
+		pipe_resource_reference(&p->tex[i], NULL);
+	}
+	p->pipe->delete_depth_stencil_alpha_state(p->pipe, p->dsa);
+	p->pipe->delete_rasterizer_state(p->pipe, p->rasterizer);
+	p->pipe->delete_sampler_state(p->pipe, p->sampler);
+	p->pipe->delete_vs_state(p->pipe, p->vs);
+	p->pipe->delete_fs_state(p->pipe, p->fs);
+
+	pipe_surface_reference(&p->framebuffer.cbufs[0], NULL);
+	pipe_resource_reference(&p->target, NULL);
+	pipe_resource_reference(&p->vbuf, NULL);
+
+	p->pipe->destroy(p->pipe);
+	p->screen->destroy(p->screen);
+	pipe_loader_release(&p->dev, 1);
+
+	FREE(p);
+}
+
+static void draw(struct program *p)
+{
+	struct pipe_draw_info info;
+
+	util_draw_init_info(&info);
+	info.mode = PIPE_PRIM_TRIANGLES;
+	info.count = 3;
+	p->pipe->draw_vbo(p->pipe, &info);
+}
+
+static void test_draw(struct program *p, unsigned i)
+{
+	draw(p);
+}
+
+static void test_blend(struct program *p, unsigned i)
+{
+	p->pipe->bind_blend_state(p->pipe, p->blend[i & 1]);
+	draw(p);
+}
+
+static void test_texture(struct program *p, unsigned i)
+{
+	p->pipe->set_sampler_views(p->pipe, PIPE_SHADER_FRAGMENT, 0, 1,
+				   &p->view[i & 1]);
+	draw(p);
+}
+
+static void test_constants(struct program *p, unsigned i)
+{
+	float constants[16];
+	struct pipe_constant_buffer cb;
+	unsigned k;
+
+	for (k = 0; k < ARRAY_SIZE(constants); k++)
+		constants[k] = (float)(i + k);
+
+	memset(&cb, 0, sizeof(cb));
+	cb.buffer_size = sizeof(constants);
+	cb.user_buffer = constants;
+	p->pipe->set_constant_buffer(p->pipe, PIPE_SHADER_FRAGMENT, 0, &cb);
+	draw(p);
+}
+
+static void test_velems(struct program *p, unsigned i)
+{
+	p->pipe->bind_vertex_elements_state(p->pipe, p->velem[i & 1]);
+	draw(p);
+}
+
+static void test_map(struct program *p, unsigned i)
+{
+	struct pipe_transfer *transfer;
+	float *map;
+
+	map = pipe_buffer_map(p->pipe, p->vbuf,
+			      PIPE_TRANSFER_WRITE | PIPE_TRANSFER_UNSYNCHRONIZED,
+			      &transfer);
+	if (map) {
+		map[0] = 0.0f;
+		pipe_buffer_unmap(p->pipe, transfer);
+	}
+}
+
+static void test_compile(struct program *p, unsigned i)
+{
+	void *fs = util_make_fragment_passthrough_shader(p->pipe,
+			TGSI_SEMANTIC_GENERIC, TGSI_INTERPOLATE_PERSPECTIVE,
+			i & 1);
+
+	/* bind it so that drivers compiling lazily do the work too */
+	p->pipe->bind_fs_state(p->pipe, fs);
+	draw(p);
+	p->pipe->bind_fs_state(p->pipe, p->fs);
+	p->pipe->delete_fs_state(p->pipe, fs);
+}
+
+static const struct {
+	const char *name;
+	test_func func;
+	unsigned iterations;
+} tests[] = {
+	{ "draw",			test_draw,	100000 },
+	{ "draw + blend change",	test_blend,	100000 },
+	{ "draw + texture change",	test_texture,	100000 },
+	{ "draw + constant update",	test_constants,	100000 },
+	{ "draw + vertex elements",	test_velems,	100000 },
+	{ "buffer map/unmap",		test_map,	100000 },
+	{ "shader compile",		test_compile,	1000 },
+};
+
+static void run_test(struct program *p, unsigned t)
+{
+	int64_t start, end;
+	unsigned i;
+
+	/* warm up, so that one-time setup doesn't count */
+	tests[t].func(p, 0);
+	tests[t].func(p, 1);
+	p->pipe->flush(p->pipe, NULL, 0);
+
+	start = os_time_get_nano();
+	for (i = 0; i < tests[t].iterations; i++)
+		tests[t].func(p, i);
+	p->pipe->flush(p->pipe, NULL, 0);
+	end = os_time_get_nano();
+
+	printf("%-28s %10.1f ns/call\n", tests[t].name,
+	       (double)(end - start) / tests[t].iterations);
+}
+
+int main(int argc, char** argv)
+{
+	struct program *p = CALLOC_STRUCT(program);
+	unsigned t;
+
+	init_prog(p);
+
+	printf("driver: %s\n", p->screen->get_name(p->screen));
+	for (t = 0; t < ARRAY_SIZE(tests); t++) {
+		if (argc > 1 && !strstr(tests[t].name, argv[1]))
+			continue;
+		run_test(p, t);
+	}
+
+	close_prog(p);
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+##########################################################################
+# 
+# Copyright 2016 Mesa contributors
+# 
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+# 
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+# 
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+# 
+##########################################################################
+
+'''Summarize where the CPU time of a trace goes.
+
+The trace driver records the time spent in every call.  This adds it up per
+method and per frame, to find which calls of an application are expensive
+without having to reproduce it.
+'''
+
+
+import sys
+
+import model
+import parse as parser
+
+
+class Profiler(parser.TraceParser):
+
+    def __init__(self, stream, options):
+        parser.TraceParser.__init__(self, stream)
+        self.options = options
+        self.methods = {}
+        self.frames = []
+        self.frame_time = 0
+        self.frame_calls = 0
+
+    def end_of_frame(self, call):
+        if call.method == 'flush_frontbuffer':
+            return True
+        if call.klass == 'pipe_context' and call.method == 'flush':
+            for name, value in call.args:
+                if name == 'flags' and isinstance(value, model.Literal):
+                    # PIPE_FLUSH_END_OF_FRAME
+                    return bool(value.value & 1)
+        return False
+
+    def handle_call(self, call):
+        if call.time is None:
+            return
+
+        time = call.time.value
+        name = call.klass + '::' + call.method
+        count, total, worst = self.methods.get(name, (0, 0, 0))
+        self.methods[name] = (count + 1, total + time, max(worst, time))
+
+        self.frame_time += time
+        self.frame_calls += 1
+        if self.end_of_frame(call):
+            self.frames.append((self.frame_calls, self.frame_time))
+            self.frame_time = 0
+            self.frame_calls = 0
+
+    def report(self):
+        total = sum([entry[1] for entry in self.methods.values()])
+        methods = sorted(self.methods.items(),
+                         key=lambda item: item[1][1], reverse=True)
+
+        sys.stdout.write('%-48s %10s %12s %10s %10s %6s\n' %
+                         ('method', 'calls', 'total (us)', 'avg (us)',
+                          'max (us)', '%'))
+        for name, (count, time, worst) in methods[:self.options.limit]:
+            sys.stdout.write('%-48s %10u %12u %10.1f %10u %6.2f\n' %
+                             (name, count, time, float(time) / count, worst,
+                              100.0 * time / max(total, 1)))
+
+        if self.frames:
+            times = [frame[1] for frame in self.frames]
+            sys.stdout.write('\n%u frames, CPU time per frame (us): '
+                             'avg %.1f, min %u, max %u\n' %
+                             (len(times), float(sum(times)) / len(times),
+                              min(times), max(times)))
+            if self.options.frames:
+                for i, (calls, time) in enumerate(self.frames):
+                    sys.stdout.write('frame %u: %u calls, %u us\n' %
+                                     (i, calls, time))
+
+
+class Main(parser.Main):
+
+    def get_optparser(self):
+        optparser = parser.Main.get_optparser(self)
+        optparser.add_option("-n", "--limit", action="store", type="int", dest="limit", default=40, help="number of methods to list")
+        optparser.add_option("-f", "--frames", action="store_true", dest="frames", default=False, help="list the CPU time of every frame")
+        return optparser
+
+    def process_arg(self, stream, options):
+        profiler = Profiler(stream, options)
+        profiler.parse()
+        profiler.report()
+
+
+if __name__ == '__main__':
+    Main().main()
@@ -30,6 +30,9 @@
  */
 
 #include "amdgpu_winsys.h"
+#include "util/u_hash.h"
+#include "util/u_hash_table.h"
+#include "util/u_memory.h"
 
 #ifndef NO_ENTRIES
 #define NO_ENTRIES 32
@@ -273,10 +276,9 @@ static int compute_level(struct amdgpu_winsys *ws,
    return 0;
 }
 
-static int amdgpu_surface_init(struct radeon_winsys *rws,
-                               struct radeon_surf *surf)
+static int amdgpu_surface_compute(struct amdgpu_winsys *ws,
+                                  struct radeon_surf *surf)
 {
-   struct amdgpu_winsys *ws = (struct amdgpu_winsys*)rws;
    unsigned level, mode, type;
    bool compressed;
    ADDR_COMPUTE_SURFACE_INFO_INPUT AddrSurfInfoIn = {0};
@@ -453,6 +455,124 @@ static int amdgpu_surface_init(struct radeon_winsys *rws,
    return 0;
 }
 
+/* Everything addrlib's output depends on: the calculator inputs and the
+ * macrotile hints.
+ */
+struct amdgpu_surface_key {
+   uint32_t npix_x, npix_y, npix_z;
+   uint32_t blk_w, blk_h, blk_d;
+   uint32_t array_size;
+   uint32_t last_level;
+   uint32_t bpe;
+   uint32_t nsamples;
+   uint32_t flags;
+   uint32_t bankw, bankh, mtilea, tile_split, stencil_tile_split;
+};
+
+struct amdgpu_surface_cache_entry {
+   struct amdgpu_surface_key key;
+   struct radeon_surf surf;
+};
+
+/* Drop everything once this is reached, so that applications streaming
+ * textures of ever-changing sizes don't grow the cache forever.
+ */
+#define AMDGPU_SURFACE_CACHE_MAX_ENTRIES 1024
+
+static unsigned amdgpu_surface_key_hash(void *key)
+{
+   return util_hash_crc32(key, sizeof(struct amdgpu_surface_key));
+}
+
+static int amdgpu_surface_key_compare(void *key1, void *key2)
+{
+   return memcmp(key1, key2, sizeof(struct amdgpu_surface_key));
+}
+
+static enum pipe_error amdgpu_surface_cache_free_entry(void *key, void *value,
+                                                       void *data)
+{
+   FREE(value);
+   return PIPE_OK;
+}
+
+static void amdgpu_surface_get_key(const struct radeon_surf *surf,
+                                   struct amdgpu_surface_key *key)
+{
+   memset(key, 0, sizeof(*key));
+   key->npix_x = surf->npix_x;
+   key->npix_y = surf->npix_y;
+   key->npix_z = surf->npix_z;
+   key->blk_w = surf->blk_w;
+   key->blk_h = surf->blk_h;
+   key->blk_d = surf->blk_d;
+   key->array_size = surf->array_size;
+   key->last_level = surf->last_level;
+   key->bpe = surf->bpe;
+   key->nsamples = surf->nsamples;
+   key->flags = surf->flags;
+   key->bankw = surf->bankw;
+   key->bankh = surf->bankh;
+   key->mtilea = surf->mtilea;
+   key->tile_split = surf->tile_split;
+   key->stencil_tile_split = surf->stencil_tile_split;
+}
+
+/* Textures are mostly created with a handful of different descriptions
+ * (render targets, mipmapped textures of the same size, ...), and asking
+ * addrlib for every level each time is expensive, so remember the layouts
+ * that have already been computed.
+ */
+static int amdgpu_surface_init(struct radeon_winsys *rws,
+                               struct radeon_surf *surf)
+{
+   struct amdgpu_winsys *ws = (struct amdgpu_winsys*)rws;
+   struct amdgpu_surface_cache_entry *entry;
+   struct amdgpu_surface_key key;
+   int r;
+
+   amdgpu_surface_get_key(surf, &key);
+
+   pipe_mutex_lock(ws->surface_cache_lock);
+   entry = util_hash_table_get(ws->surface_cache, &key);
+   if (entry) {
+      *surf = entry->surf;
+      pipe_mutex_unlock(ws->surface_cache_lock);
+      return 0;
+   }
+   pipe_mutex_unlock(ws->surface_cache_lock);
+
+   r = amdgpu_surface_compute(ws, surf);
+   if (r)
+      return r;
+
+   entry = MALLOC_STRUCT(amdgpu_surface_cache_entry);
+   if (!entry)
+      return 0;
+
+   entry->key = key;
+   entry->surf = *surf;
+
+   pipe_mutex_lock(ws->surface_cache_lock);
+   if (util_hash_table_get(ws->surface_cache, &key)) {
+      /* Another thread computed the same layout meanwhile. */
+      FREE(entry);
+   } else {
+      if (ws->num_cached_surfaces == AMDGPU_SURFACE_CACHE_MAX_ENTRIES) {
+         util_hash_table_foreach(ws->surface_cache,
+                                 amdgpu_surface_cache_free_entry, NULL);
+         util_hash_table_clear(ws->surface_cache);
+         ws->num_cached_surfaces = 0;
+      }
+      if (util_hash_table_set(ws->surface_cache, &entry->key, entry) == PIPE_OK)
+         ws->num_cached_surfaces++;
+      else
+         FREE(entry);
+   }
+   pipe_mutex_unlock(ws->surface_cache_lock);
+   return 0;
+}
+
 static int amdgpu_surface_best(struct radeon_winsys *rws,
                                struct radeon_surf *surf)
 {
@@ -463,4 +583,16 @@ void amdgpu_surface_init_functions(struct amdgpu_winsys *ws)
 {
    ws->base.surface_init = amdgpu_surface_init;
    ws->base.surface_best = amdgpu_surface_best;
+
+   pipe_mutex_init(ws->surface_cache_lock);
+   ws->surface_cache = util_hash_table_create(amdgpu_surface_key_hash,
+                                              amdgpu_surface_key_compare);
+}
+
+void amdgpu_surface_cache_destroy(struct amdgpu_winsys *ws)
+{
+   util_hash_table_foreach(ws->surface_cache,
+                           amdgpu_surface_cache_free_entry, NULL);
+   util_hash_table_destroy(ws->surface_cache);
+   pipe_mutex_destroy(ws->surface_cache_lock);
 }
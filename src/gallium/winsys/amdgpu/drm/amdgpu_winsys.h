@@ -33,22 +33,33 @@
 #define AMDGPU_WINSYS_H
 
 #include "pipebuffer/pb_cache.h"
+#include "pipebuffer/pb_slab.h"
 #include "gallium/drivers/radeon/radeon_winsys.h"
 #include "addrlib/addrinterface.h"
 #include "os/os_thread.h"
+#include "util/u_queue.h"
 #include <amdgpu.h>
 
 struct amdgpu_cs;
+struct util_hash_table;
+
+#define AMDGPU_SLAB_MIN_SIZE_LOG2 9
+#define AMDGPU_SLAB_MAX_SIZE_LOG2 14
+#define AMDGPU_SLAB_BO_SIZE_LOG2 17
 
 struct amdgpu_winsys {
    struct radeon_winsys base;
    struct pipe_reference reference;
    struct pb_cache bo_cache;
+   struct pb_slabs bo_slabs;  /* Slab allocator. */
 
    amdgpu_device_handle dev;
 
    pipe_mutex bo_fence_lock;
 
+   /* Command submission thread, only initialized on multi-core systems. */
+   struct util_queue cs_queue;
+
    int num_cs; /* The number of command streams created. */
    uint32_t next_bo_unique_id;
    uint64_t allocated_vram;
@@ -68,6 +79,11 @@ struct amdgpu_winsys {
    pipe_mutex global_bo_list_lock;
    struct list_head global_bo_list;
    unsigned num_buffers;
+
+   /* Surface layouts already computed by addrlib. */
+   pipe_mutex surface_cache_lock;
+   struct util_hash_table *surface_cache;
+   unsigned num_cached_surfaces;
 };
 
 static inline struct amdgpu_winsys *
@@ -77,6 +93,7 @@ amdgpu_winsys(struct radeon_winsys *base)
 }
 
 void amdgpu_surface_init_functions(struct amdgpu_winsys *ws);
+void amdgpu_surface_cache_destroy(struct amdgpu_winsys *ws);
 ADDR_HANDLE amdgpu_addr_create(struct amdgpu_winsys *ws);
 
 #endif
@@ -121,10 +121,14 @@ static boolean radeon_init_cs_context(struct radeon_cs_context *csc,
     csc->chunks[2].chunk_id = RADEON_CHUNK_ID_FLAGS;
     csc->chunks[2].length_dw = 2;
     csc->chunks[2].chunk_data = (uint64_t)(uintptr_t)&csc->flags;
+    csc->chunks[3].chunk_id = RADEON_CHUNK_ID_CONST_IB;
+    csc->chunks[3].length_dw = 0;
+    csc->chunks[3].chunk_data = (uint64_t)(uintptr_t)csc->const_buf;
 
     csc->chunk_array[0] = (uint64_t)(uintptr_t)&csc->chunks[0];
     csc->chunk_array[1] = (uint64_t)(uintptr_t)&csc->chunks[1];
     csc->chunk_array[2] = (uint64_t)(uintptr_t)&csc->chunks[2];
+    csc->chunk_array[3] = (uint64_t)(uintptr_t)&csc->chunks[3];
 
     csc->cs.chunks = (uint64_t)(uintptr_t)csc->chunk_array;
 
@@ -147,6 +151,7 @@ static void radeon_cs_context_cleanup(struct radeon_cs_context *csc)
     csc->validated_crelocs = 0;
     csc->chunks[0].length_dw = 0;
     csc->chunks[1].length_dw = 0;
+    csc->chunks[3].length_dw = 0;
     csc->used_gart = 0;
     csc->used_vram = 0;
 
@@ -204,6 +209,24 @@ radeon_drm_cs_create(struct radeon_winsys_ctx *ctx,
     return &cs->base;
 }
 
+static struct radeon_winsys_cs *
+radeon_drm_cs_add_const_ib(struct radeon_winsys_cs *rcs)
+{
+    struct radeon_drm_cs *cs = radeon_drm_cs(rcs);
+
+    /* The kernel only accepts a const IB for the GFX ring of SI and later,
+     * with virtual memory. Only one can be added. */
+    if (cs->ring_type != RING_GFX ||
+        cs->ws->info.chip_class < SI ||
+        !cs->ws->info.has_virtual_memory ||
+        cs->const_ib.buf)
+        return NULL;
+
+    cs->const_ib.buf = cs->csc->const_buf;
+    cs->const_ib.max_dw = ARRAY_SIZE(cs->csc->const_buf);
+    return &cs->const_ib;
+}
+
 #define OUT_CS(cs, value) (cs)->buf[(cs)->cdw++] = (value)
 
 static inline void update_reloc(struct drm_radeon_cs_reloc *reloc,
@@ -488,6 +511,10 @@ static void radeon_drm_cs_flush(struct radeon_winsys_cs *rcs,
             while (rcs->cdw & 7)
                 OUT_CS(&cs->base, 0xffff1000); /* type3 nop packet */
         }
+        if (cs->const_ib.buf) {
+            while (cs->const_ib.cdw & 7)
+                OUT_CS(&cs->const_ib, 0xffff1000); /* type3 nop packet */
+        }
         break;
     case RING_UVD:
         while (rcs->cdw & 15)
@@ -497,7 +524,8 @@ static void radeon_drm_cs_flush(struct radeon_winsys_cs *rcs,
         break;
     }
 
-    if (rcs->cdw > rcs->max_dw) {
+    if (rcs->cdw > rcs->max_dw ||
+        cs->const_ib.cdw > cs->const_ib.max_dw) {
        fprintf(stderr, "radeon: command stream overflowed\n");
     }
 
@@ -514,12 +542,14 @@ static void radeon_drm_cs_flush(struct radeon_winsys_cs *rcs,
     cs->cst = tmp;
 
     /* If the CS is not empty or overflowed, emit it in a separate thread. */
-    if (cs->base.cdw && cs->base.cdw <= cs->base.max_dw && !debug_get_option_noop()) {
+    if (cs->base.cdw && cs->base.cdw <= cs->base.max_dw &&
+        cs->const_ib.cdw <= cs->const_ib.max_dw && !debug_get_option_noop()) {
         unsigned i, crelocs;
 
         crelocs = cs->cst->crelocs;
 
         cs->cst->chunks[0].length_dw = cs->base.cdw;
+        cs->cst->chunks[3].length_dw = cs->const_ib.cdw;
 
         for (i = 0; i < crelocs; i++) {
             /* Update the number of active asynchronous CS ioctls for the buffer. */
@@ -570,6 +600,9 @@ static void radeon_drm_cs_flush(struct radeon_winsys_cs *rcs,
                 cs->cst->flags[1] = RADEON_CS_RING_COMPUTE;
                 cs->cst->cs.num_chunks = 3;
             }
+            /* The kernel rejects empty const IBs. */
+            if (cs->const_ib.cdw)
+                cs->cst->cs.num_chunks = 4;
             break;
         }
 
@@ -588,6 +621,10 @@ static void radeon_drm_cs_flush(struct radeon_winsys_cs *rcs,
     /* Prepare a new CS. */
     cs->base.buf = cs->csc->buf;
     cs->base.cdw = 0;
+    if (cs->const_ib.buf) {
+        cs->const_ib.buf = cs->csc->const_buf;
+        cs->const_ib.cdw = 0;
+    }
 
     cs->ws->num_cs_flushes++;
 }
@@ -666,6 +703,7 @@ void radeon_drm_cs_init_functions(struct radeon_drm_winsys *ws)
     ws->base.ctx_create = radeon_drm_ctx_create;
     ws->base.ctx_destroy = radeon_drm_ctx_destroy;
     ws->base.cs_create = radeon_drm_cs_create;
+    ws->base.cs_add_const_ib = radeon_drm_cs_add_const_ib;
     ws->base.cs_destroy = radeon_drm_cs_destroy;
     ws->base.cs_add_buffer = radeon_drm_cs_add_buffer;
     ws->base.cs_lookup_buffer = radeon_drm_cs_lookup_buffer;
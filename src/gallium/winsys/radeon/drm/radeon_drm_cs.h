@@ -36,11 +36,13 @@ struct radeon_bo_item {
 
 struct radeon_cs_context {
     uint32_t                    buf[16 * 1024];
+    /* Constant engine IB, see radeon_drm_cs_add_const_ib. */
+    uint32_t                    const_buf[16 * 1024];
 
     int                         fd;
     struct drm_radeon_cs        cs;
-    struct drm_radeon_cs_chunk  chunks[3];
-    uint64_t                    chunk_array[3];
+    struct drm_radeon_cs_chunk  chunks[4];
+    uint64_t                    chunk_array[4];
     uint32_t                    flags[2];
 
     /* Buffers. */
@@ -61,6 +63,10 @@ struct radeon_drm_cs {
     struct radeon_winsys_cs base;
     enum ring_type          ring_type;
 
+    /* The constant engine IB, submitted together with the main IB when
+     * buf is set. */
+    struct radeon_winsys_cs const_ib;
+
     /* We flip between these two CS. While one is being consumed
      * by the kernel in another thread, the other one is being filled
      * by the pipe driver. */
@@ -30,6 +30,11 @@
  * @file
  * GDI software rasterizer support.
  *
+ * Display targets are blitted to the window by a present thread, so that
+ * SwapBuffers returns as soon as the rendering is done and the application
+ * can start rendering the next frame into the other buffer while GDI is
+ * busy.  Only one present is in flight at a time.
+ *
  * @author Jose Fonseca <jfonseca@vmware.com>
  */
 
@@ -38,6 +43,7 @@
 
 #include "pipe/p_format.h"
 #include "pipe/p_context.h"
+#include "os/os_thread.h"
 #include "util/u_inlines.h"
 #include "util/u_format.h"
 #include "util/u_math.h"
@@ -61,6 +67,29 @@ struct gdi_sw_displaytarget
 };
 
 
+struct gdi_sw_winsys
+{
+   struct sw_winsys base;
+
+   pipe_thread present_thread;
+   pipe_mutex present_mutex;
+   pipe_condvar present_cond;
+
+   /* Display target being presented and its window, NULL when idle. */
+   struct gdi_sw_displaytarget *present_dt;
+   HWND present_hwnd;
+   boolean present_quit;
+};
+
+
+/** Cast wrapper */
+static inline struct gdi_sw_winsys *
+gdi_sw_winsys( struct sw_winsys *winsys )
+{
+   return (struct gdi_sw_winsys *)winsys;
+}
+
+
 /** Cast wrapper */
 static inline struct gdi_sw_displaytarget *
 gdi_sw_displaytarget( struct sw_displaytarget *buf )
@@ -107,12 +136,32 @@ gdi_sw_displaytarget_unmap(struct sw_winsys *ws,
 }
 
 
+/**
+ * Wait until the present thread is done with gdt, or idle if gdt is NULL.
+ * Must be called with the present mutex held.
+ */
+static void
+gdi_sw_wait_present_locked(struct gdi_sw_winsys *gws,
+                           struct gdi_sw_displaytarget *gdt)
+{
+   while (gws->present_dt && (!gdt || gws->present_dt == gdt))
+      pipe_condvar_wait(gws->present_cond, gws->present_mutex);
+}
+
+
 static void
 gdi_sw_displaytarget_destroy(struct sw_winsys *winsys,
                                    struct sw_displaytarget *dt)
 {
+   struct gdi_sw_winsys *gws = gdi_sw_winsys(winsys);
    struct gdi_sw_displaytarget *gdt = gdi_sw_displaytarget(dt);
 
+   if (gws->present_thread) {
+      pipe_mutex_lock(gws->present_mutex);
+      gdi_sw_wait_present_locked(gws, gdt);
+      pipe_mutex_unlock(gws->present_mutex);
+   }
+
    align_free(gdt->data);
    FREE(gdt);
 }
@@ -192,17 +241,84 @@ gdi_sw_displaytarget_get_handle(struct sw_winsys *winsys,
 }
 
 
+static void
+gdi_sw_blit( struct gdi_sw_displaytarget *gdt,
+             HDC hDC )
+{
+    StretchDIBits(hDC,
+                  0, 0, gdt->width, gdt->height,
+                  0, 0, gdt->width, gdt->height,
+                  gdt->data, &gdt->bmi, 0, SRCCOPY);
+}
+
+
+static PIPE_THREAD_ROUTINE(gdi_sw_present_thread, param)
+{
+   struct gdi_sw_winsys *gws = (struct gdi_sw_winsys *)param;
+
+   pipe_mutex_lock(gws->present_mutex);
+   for (;;) {
+      struct gdi_sw_displaytarget *gdt;
+      HWND hWnd;
+      HDC hDC;
+
+      while (!gws->present_dt && !gws->present_quit)
+         pipe_condvar_wait(gws->present_cond, gws->present_mutex);
+
+      if (!gws->present_dt)
+         break;
+
+      gdt = gws->present_dt;
+      hWnd = gws->present_hwnd;
+      pipe_mutex_unlock(gws->present_mutex);
+
+      /* The application's HDC can't be used here, it may be released as
+       * soon as SwapBuffers returns.
+       */
+      hDC = GetDC(hWnd);
+      if (hDC) {
+         gdi_sw_blit(gdt, hDC);
+         ReleaseDC(hWnd, hDC);
+      }
+
+      pipe_mutex_lock(gws->present_mutex);
+      gws->present_dt = NULL;
+      pipe_condvar_broadcast(gws->present_cond);
+   }
+   pipe_mutex_unlock(gws->present_mutex);
+
+   return 0;
+}
+
+
 void
 gdi_sw_display( struct sw_winsys *winsys,
                 struct sw_displaytarget *dt,
                 HDC hDC )
 {
+    struct gdi_sw_winsys *gws = gdi_sw_winsys(winsys);
     struct gdi_sw_displaytarget *gdt = gdi_sw_displaytarget(dt);
-
-    StretchDIBits(hDC,
-                  0, 0, gdt->width, gdt->height,
-                  0, 0, gdt->width, gdt->height,
-                  gdt->data, &gdt->bmi, 0, SRCCOPY);
+    HWND hWnd = WindowFromDC(hDC);
+
+    if (!gws->present_thread) {
+       gdi_sw_blit(gdt, hDC);
+       return;
+    }
+
+    pipe_mutex_lock(gws->present_mutex);
+    gdi_sw_wait_present_locked(gws, NULL);
+
+    if (!hWnd) {
+       /* Memory and printer DCs have no window, blit those right away. */
+       pipe_mutex_unlock(gws->present_mutex);
+       gdi_sw_blit(gdt, hDC);
+       return;
+    }
+
+    gws->present_dt = gdt;
+    gws->present_hwnd = hWnd;
+    pipe_condvar_broadcast(gws->present_cond);
+    pipe_mutex_unlock(gws->present_mutex);
 }
 
 static void
@@ -222,18 +338,36 @@ gdi_sw_displaytarget_display(struct sw_winsys *winsys,
 static void
 gdi_sw_destroy(struct sw_winsys *winsys)
 {
-   FREE(winsys);
+   struct gdi_sw_winsys *gws = gdi_sw_winsys(winsys);
+
+   if (gws->present_thread) {
+      pipe_mutex_lock(gws->present_mutex);
+      gdi_sw_wait_present_locked(gws, NULL);
+      gws->present_quit = TRUE;
+      pipe_condvar_broadcast(gws->present_cond);
+      pipe_mutex_unlock(gws->present_mutex);
+
+      pipe_thread_wait(gws->present_thread);
+   }
+
+   pipe_condvar_destroy(gws->present_cond);
+   pipe_mutex_destroy(gws->present_mutex);
+
+   FREE(gws);
 }
 
 struct sw_winsys *
 gdi_create_sw_winsys(void)
 {
-   static struct sw_winsys *winsys;
+   struct gdi_sw_winsys *gws;
+   struct sw_winsys *winsys;
 
-   winsys = CALLOC_STRUCT(sw_winsys);
-   if(!winsys)
+   gws = CALLOC_STRUCT(gdi_sw_winsys);
+   if(!gws)
       return NULL;
 
+   winsys = &gws->base;
+
    winsys->destroy = gdi_sw_destroy;
    winsys->is_displaytarget_format_supported = gdi_sw_is_displaytarget_format_supported;
    winsys->displaytarget_create = gdi_sw_displaytarget_create;
@@ -244,6 +378,12 @@ gdi_create_sw_winsys(void)
    winsys->displaytarget_display = gdi_sw_displaytarget_display;
    winsys->displaytarget_destroy = gdi_sw_displaytarget_destroy;
 
+   pipe_mutex_init(gws->present_mutex);
+   pipe_condvar_init(gws->present_cond);
+
+   /* Present synchronously if the thread can't be created. */
+   gws->present_thread = pipe_thread_create(gdi_sw_present_thread, gws);
+
    return winsys;
 }
 
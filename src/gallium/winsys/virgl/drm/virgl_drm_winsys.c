@@ -652,6 +652,8 @@ static boolean virgl_drm_res_is_ref(struct virgl_winsys *qws,
    return TRUE;
 }
 
+DEBUG_GET_ONCE_BOOL_OPTION(noop, "VIRGL_NOOP", FALSE)
+
 static int virgl_drm_winsys_submit_cmd(struct virgl_winsys *qws,
                                        struct virgl_cmd_buf *_cbuf)
 {
@@ -669,7 +671,11 @@ static int virgl_drm_winsys_submit_cmd(struct virgl_winsys *qws,
    eb.num_bo_handles = cbuf->cres;
    eb.bo_handles = (unsigned long)(void *)cbuf->res_hlist;
 
-   ret = drmIoctl(qdws->fd, DRM_IOCTL_VIRTGPU_EXECBUFFER, &eb);
+   /* VIRGL_NOOP drops the command stream, to measure the CPU side only */
+   if (debug_get_option_noop())
+      ret = 0;
+   else
+      ret = drmIoctl(qdws->fd, DRM_IOCTL_VIRTGPU_EXECBUFFER, &eb);
    if (ret == -1)
       fprintf(stderr,"got error from kernel - expect bad rendering %d\n", errno);
    cbuf->base.cdw = 0;
@@ -259,6 +259,12 @@ int virgl_vtest_recv_transfer_get_data(struct virgl_vtest_winsys *vws,
    void *ptr = data;
    int hblocks = util_format_get_nblocksy(format, box->height);
 
+   /* Rows without padding can be received in place in one go. */
+   if (util_format_get_stride(format, box->width) == stride) {
+      virgl_block_read(vws->sock_fd, data, hblocks * stride);
+      return 0;
+   }
+
    line = malloc(stride);
    while (hblocks) {
       virgl_block_read(vws->sock_fd, line, stride);
@@ -581,14 +581,15 @@ gbm_dri_bo_get_fd(struct gbm_bo *_bo)
 
    dri->image->queryImage(bo->image, __DRI_IMAGE_ATTRIB_FD, &fd);
 
+   /* Somebody else may now be using the buffer, so it can't be recycled. */
+   bo->cacheable = 0;
+
    return fd;
 }
 
 static void
-gbm_dri_bo_destroy(struct gbm_bo *_bo)
+gbm_dri_bo_free(struct gbm_dri_device *dri, struct gbm_dri_bo *bo)
 {
-   struct gbm_dri_device *dri = gbm_dri_device(_bo->gbm);
-   struct gbm_dri_bo *bo = gbm_dri_bo(_bo);
    struct drm_mode_destroy_dumb arg;
 
    if (bo->image != NULL) {
@@ -603,6 +604,66 @@ gbm_dri_bo_destroy(struct gbm_bo *_bo)
    free(bo);
 }
 
+static void
+gbm_dri_bo_destroy(struct gbm_bo *_bo)
+{
+   struct gbm_dri_device *dri = gbm_dri_device(_bo->gbm);
+   struct gbm_dri_bo *bo = gbm_dri_bo(_bo);
+   struct gbm_dri_bo *evict = NULL;
+
+   if (!bo->cacheable) {
+      gbm_dri_bo_free(dri, bo);
+      return;
+   }
+
+   bo->base.base.user_data = NULL;
+   bo->base.base.destroy_user_data = NULL;
+
+   mtx_lock(&dri->bo_cache_mutex);
+   if (dri->bo_cache_count == GBM_DRI_BO_CACHE_SIZE) {
+      evict = dri->bo_cache[0];
+      memmove(&dri->bo_cache[0], &dri->bo_cache[1],
+              (GBM_DRI_BO_CACHE_SIZE - 1) * sizeof(dri->bo_cache[0]));
+      dri->bo_cache_count--;
+   }
+   dri->bo_cache[dri->bo_cache_count++] = bo;
+   mtx_unlock(&dri->bo_cache_mutex);
+
+   if (evict)
+      gbm_dri_bo_free(dri, evict);
+}
+
+/**
+ * Take a BO matching the allocation parameters out of the BO cache.
+ */
+static struct gbm_dri_bo *
+gbm_dri_bo_cache_get(struct gbm_dri_device *dri,
+                     uint32_t width, uint32_t height,
+                     uint32_t format, uint32_t usage)
+{
+   struct gbm_dri_bo *bo = NULL;
+   unsigned i;
+
+   mtx_lock(&dri->bo_cache_mutex);
+   for (i = dri->bo_cache_count; i-- > 0; ) {
+      struct gbm_dri_bo *entry = dri->bo_cache[i];
+
+      if (entry->base.base.width == width &&
+          entry->base.base.height == height &&
+          entry->base.base.format == format &&
+          entry->usage == usage) {
+         bo = entry;
+         memmove(&dri->bo_cache[i], &dri->bo_cache[i + 1],
+                 (dri->bo_cache_count - i - 1) * sizeof(dri->bo_cache[0]));
+         dri->bo_cache_count--;
+         break;
+      }
+   }
+   mtx_unlock(&dri->bo_cache_mutex);
+
+   return bo;
+}
+
 static uint32_t
 gbm_dri_to_gbm_format(uint32_t dri_format)
 {
@@ -847,6 +908,10 @@ gbm_dri_bo_create(struct gbm_device *gbm,
    if (usage & GBM_BO_USE_WRITE || dri->image == NULL)
       return create_dumb(gbm, width, height, format, usage);
 
+   bo = gbm_dri_bo_cache_get(dri, width, height, format, usage);
+   if (bo)
+      return &bo->base.base;
+
    bo = calloc(1, sizeof *bo);
    if (bo == NULL)
       return NULL;
@@ -908,6 +973,9 @@ gbm_dri_bo_create(struct gbm_device *gbm,
    dri->image->queryImage(bo->image, __DRI_IMAGE_ATTRIB_STRIDE,
                           (int *) &bo->base.base.stride);
 
+   bo->usage = usage;
+   bo->cacheable = 1;
+
    return &bo->base.base;
 
 failed:
@@ -949,6 +1017,10 @@ dri_destroy(struct gbm_device *gbm)
    struct gbm_dri_device *dri = gbm_dri_device(gbm);
    unsigned i;
 
+   for (i = 0; i < dri->bo_cache_count; i++)
+      gbm_dri_bo_free(dri, dri->bo_cache[i]);
+   mtx_destroy(&dri->bo_cache_mutex);
+
    dri->core->destroyScreen(dri->screen);
    for (i = 0; dri->driver_configs[i]; i++)
       free((__DRIconfig *) dri->driver_configs[i]);
@@ -995,6 +1067,8 @@ dri_device_create(int fd)
    if (ret)
       goto err_dri;
 
+   mtx_init(&dri->bo_cache_mutex, mtx_plain);
+
    return &dri->base.base;
 
 err_dri:
@@ -30,6 +30,7 @@
 
 #include <sys/mman.h>
 #include "gbmint.h"
+#include "c11/threads.h"
 
 #include "common_drm.h"
 
@@ -39,6 +40,9 @@
 struct gbm_dri_surface;
 struct gbm_dri_bo;
 
+/* Number of destroyed BOs kept around for reuse by gbm_dri_bo_create() */
+#define GBM_DRI_BO_CACHE_SIZE 8
+
 struct gbm_dri_device {
    struct gbm_drm_device base;
 
@@ -93,6 +97,13 @@ struct gbm_dri_device {
                             void          *loaderPrivate);
 
    struct wl_drm *wl_drm;
+
+   /* Destroyed BOs that can be handed out again for the same size, format
+    * and usage, oldest first.
+    */
+   mtx_t bo_cache_mutex;
+   struct gbm_dri_bo *bo_cache[GBM_DRI_BO_CACHE_SIZE];
+   unsigned bo_cache_count;
 };
 
 struct gbm_dri_bo {
@@ -103,6 +114,12 @@ struct gbm_dri_bo {
    /* Used for cursors and the swrast front BO */
    uint32_t handle, size;
    void *map;
+
+   /* Usage the image was allocated with.  Only BOs that were allocated by
+    * us and never exported to another process go back to the BO cache.
+    */
+   uint32_t usage;
+   int cacheable;
 };
 
 struct gbm_dri_surface {
@@ -378,6 +378,13 @@ struct glx_context
      */
    GLint maxSmallRenderCommandSize;
 
+    /**
+     * Maximum size of a vertex array command sent with X_GLXRender.  The
+     * array data is copied into the buffer either way, so this is only
+     * bounded by the protocol and by the size of the buffer.
+     */
+   GLint maxArrayRenderCommandSize;
+
     /**
      * Major opcode for the extension.  Copied here so a lookup isn't
      * needed.
@@ -429,12 +429,13 @@ indirect_create_context(struct glx_screen *psc,
     ** constrain by a software limit, then constrain by the protocl
     ** limit.
     */
-   if (bufSize > __GLX_RENDER_CMD_SIZE_LIMIT) {
-      bufSize = __GLX_RENDER_CMD_SIZE_LIMIT;
-   }
    if (bufSize > __GLX_MAX_RENDER_CMD_SIZE) {
       bufSize = __GLX_MAX_RENDER_CMD_SIZE;
    }
+   gc->maxArrayRenderCommandSize = bufSize;
+   if (bufSize > __GLX_RENDER_CMD_SIZE_LIMIT) {
+      bufSize = __GLX_RENDER_CMD_SIZE_LIMIT;
+   }
    gc->maxSmallRenderCommandSize = bufSize;
    
 
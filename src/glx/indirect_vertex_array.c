@@ -595,9 +595,14 @@ emit_DrawArrays_header_old(struct glx_context * gc,
 
    /* Write the header for either a Render command or a RenderLarge
     * command.  After the header is written, write the ARRAY_INFO data.
+    *
+    * Every RenderLarge chunk is a separate X request, and the header chunk
+    * forces the pending render buffer out first.  Pack any draw that fits
+    * in the render buffer into a regular Render command instead, so that
+    * consecutive draws share a single request.
     */
 
-   if (command_size > gc->maxSmallRenderCommandSize) {
+   if (command_size > gc->maxArrayRenderCommandSize) {
       /* maxSize is the maximum amount of data can be stuffed into a single
        * packet.  sz_xGLXRenderReq is added because bufSize is the maximum
        * packet size minus sz_xGLXRenderReq.
@@ -23,7 +23,9 @@
 
 #include <assert.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "isl.h"
 #include "isl_gen4.h"
@@ -32,6 +34,7 @@
 #include "isl_gen8.h"
 #include "isl_gen9.h"
 #include "isl_priv.h"
+#include "util/hash_table.h"
 
 void PRINTFLIKE(3, 4) UNUSED
 __isl_finishme(const char *file, int line, const char *fmt, ...)
@@ -54,6 +57,7 @@ isl_device_init(struct isl_device *dev,
    dev->info = info;
    dev->use_separate_stencil = ISL_DEV_GEN(dev) >= 6;
    dev->has_bit6_swizzling = has_bit6_swizzling;
+   dev->surf_cache = NULL;
 
    /* The ISL_DEV macros may be defined in the CFLAGS, thus hardcoding some
     * device properties at buildtime. Verify that the macros with the device
@@ -1055,10 +1059,10 @@ isl_calc_total_height_el(const struct isl_device *dev,
    return total_h_el;
 }
 
-bool
-isl_surf_init_s(const struct isl_device *dev,
-                struct isl_surf *surf,
-                const struct isl_surf_init_info *restrict info)
+static bool
+isl_calc_surf(const struct isl_device *dev,
+              struct isl_surf *surf,
+              const struct isl_surf_init_info *restrict info)
 {
    const struct isl_format_layout *fmtl = isl_format_get_layout(info->format);
 
@@ -1155,6 +1159,67 @@ isl_surf_init_s(const struct isl_device *dev,
    return true;
 }
 
+void
+isl_surf_cache_init(struct isl_surf_cache *cache)
+{
+   memset(cache, 0, sizeof(*cache));
+   pthread_mutex_init(&cache->mutex, NULL);
+}
+
+void
+isl_surf_cache_finish(struct isl_surf_cache *cache)
+{
+   pthread_mutex_destroy(&cache->mutex);
+}
+
+/**
+ * The cache key is isl_surf_init_info without its tail padding, which the
+ * caller may leave uninitialized.
+ */
+#define ISL_SURF_CACHE_KEY_SIZE \
+   (offsetof(struct isl_surf_init_info, tiling_flags) + \
+    sizeof(isl_tiling_flags_t))
+
+bool
+isl_surf_init_s(const struct isl_device *dev,
+                struct isl_surf *surf,
+                const struct isl_surf_init_info *restrict info)
+{
+   struct isl_surf_cache *cache = dev->surf_cache;
+
+   if (cache == NULL)
+      return isl_calc_surf(dev, surf, info);
+
+   const uint32_t hash =
+      _mesa_fnv32_1a_accumulate_block(_mesa_fnv32_1a_offset_bias,
+                                      info, ISL_SURF_CACHE_KEY_SIZE);
+   struct isl_surf_cache_entry *entry =
+      &cache->entries[hash % ISL_SURF_CACHE_SIZE];
+
+   pthread_mutex_lock(&cache->mutex);
+   if (entry->valid &&
+       memcmp(&entry->info, info, ISL_SURF_CACHE_KEY_SIZE) == 0) {
+      *surf = entry->surf;
+      pthread_mutex_unlock(&cache->mutex);
+      return true;
+   }
+   pthread_mutex_unlock(&cache->mutex);
+
+   /* Compute the layout outside of the lock.  Two threads missing on the
+    * same entry just both store it.
+    */
+   if (!isl_calc_surf(dev, surf, info))
+      return false;
+
+   pthread_mutex_lock(&cache->mutex);
+   entry->valid = true;
+   memcpy(&entry->info, info, ISL_SURF_CACHE_KEY_SIZE);
+   entry->surf = *surf;
+   pthread_mutex_unlock(&cache->mutex);
+
+   return true;
+}
+
 void
 isl_surf_get_tile_info(const struct isl_device *dev,
                        const struct isl_surf *surf,
@@ -38,6 +38,7 @@
 #pragma once
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -374,6 +375,15 @@ enum isl_tiling {
    ISL_TILING_Ys, /**< Standard 64K tiling. The 's' means "sixty-four". */
 };
 
+/**
+ * @brief How to copy the pixels in isl_memcpy_linear_to_tiled() and
+ * isl_memcpy_tiled_to_linear()
+ */
+enum isl_memcpy_type {
+   ISL_MEMCPY = 0, /**< Plain copy */
+   ISL_MEMCPY_BGRA8, /**< Copy 4-byte pixels, swapping the R and B channels */
+};
+
 /**
  * @defgroup Tiling Flags
  * @{
@@ -565,6 +575,12 @@ struct isl_device {
    const struct brw_device_info *info;
    bool use_separate_stencil;
    bool has_bit6_swizzling;
+
+   /**
+    * Optional cache of surface layouts, owned by the driver.  NULL if
+    * isl_surf_init_s() should compute every layout.
+    */
+   struct isl_surf_cache *surf_cache;
 };
 
 struct isl_extent2d {
@@ -719,6 +735,24 @@ struct isl_surf {
    isl_surf_usage_flags_t usage;
 };
 
+#define ISL_SURF_CACHE_SIZE 64
+
+/**
+ * A small direct-mapped cache of the layouts computed by isl_surf_init_s(),
+ * keyed on the isl_surf_init_info.  Drivers that create and destroy many
+ * surfaces with the same parameters can point isl_device::surf_cache at
+ * one.  It may be used from several threads.
+ */
+struct isl_surf_cache {
+   pthread_mutex_t mutex;
+
+   struct isl_surf_cache_entry {
+      bool valid;
+      struct isl_surf_init_info info;
+      struct isl_surf surf;
+   } entries[ISL_SURF_CACHE_SIZE];
+};
+
 struct isl_view {
    /**
     * Indicates the usage of the particular view
@@ -1209,6 +1243,43 @@ uint32_t
 isl_surf_get_depth_format(const struct isl_device *dev,
                           const struct isl_surf *surf);
 
+void
+isl_surf_cache_init(struct isl_surf_cache *cache);
+
+void
+isl_surf_cache_finish(struct isl_surf_cache *cache);
+
+/**
+ * @brief Copy a linear region into an X or Y0 tiled surface
+ *
+ * The X range [xt1, xt2) is in bytes, the Y range [yt1, yt2) in rows.  @a
+ * dst is the start of the tiled surface and @a src the linear address
+ * corresponding to it, though copying begins at (xt1, yt1).
+ */
+void
+isl_memcpy_linear_to_tiled(uint32_t xt1, uint32_t xt2,
+                           uint32_t yt1, uint32_t yt2,
+                           char *dst, const char *src,
+                           uint32_t dst_pitch, int32_t src_pitch,
+                           bool has_swizzling,
+                           enum isl_tiling tiling,
+                           enum isl_memcpy_type copy_type);
+
+/**
+ * @brief Copy a region of an X or Y0 tiled surface to linear memory
+ *
+ * The inverse of isl_memcpy_linear_to_tiled(); @a src is the start of the
+ * tiled surface.
+ */
+void
+isl_memcpy_tiled_to_linear(uint32_t xt1, uint32_t xt2,
+                           uint32_t yt1, uint32_t yt2,
+                           char *dst, const char *src,
+                           int32_t dst_pitch, uint32_t src_pitch,
+                           bool has_swizzling,
+                           enum isl_tiling tiling,
+                           enum isl_memcpy_type copy_type);
+
 #ifdef __cplusplus
 }
 #endif
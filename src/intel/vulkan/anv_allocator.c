@@ -108,6 +108,7 @@ struct anv_mmap_cleanup {
    void *map;
    size_t size;
    uint32_t gem_handle;
+   uint64_t bo_offset;
 };
 
 #define ANV_MMAP_CLEANUP_INIT ((struct anv_mmap_cleanup){0})
@@ -260,6 +261,8 @@ anv_block_pool_init(struct anv_block_pool *pool,
    pool->bo.size = 0;
    pool->bo.is_winsys_bo = false;
    pool->block_size = block_size;
+   pthread_mutex_init(&pool->grow_mutex, NULL);
+   pool->grow_count = 0;
    pool->free_list = ANV_FREE_LIST_EMPTY;
    pool->back_free_list = ANV_FREE_LIST_EMPTY;
 
@@ -296,11 +299,15 @@ anv_block_pool_finish(struct anv_block_pool *pool)
          munmap(cleanup->map, cleanup->size);
       if (cleanup->gem_handle)
          anv_gem_close(pool->device, cleanup->gem_handle);
+      if (cleanup->bo_offset)
+         anv_vma_free(&pool->device->vma_heap, cleanup->bo_offset,
+                      cleanup->size);
    }
 
    anv_vector_finish(&pool->mmap_cleanups);
 
    close(pool->fd);
+   pthread_mutex_destroy(&pool->grow_mutex);
 }
 
 #define PAGE_SIZE 4096
@@ -337,7 +344,7 @@ anv_block_pool_grow(struct anv_block_pool *pool, struct anv_block_state *state)
    uint32_t gem_handle;
    struct anv_mmap_cleanup *cleanup;
 
-   pthread_mutex_lock(&pool->device->mutex);
+   pthread_mutex_lock(&pool->grow_mutex);
 
    assert(state == &pool->state || state == &pool->back_state);
 
@@ -447,6 +454,18 @@ anv_block_pool_grow(struct anv_block_pool *pool, struct anv_block_state *state)
       goto fail;
    cleanup->gem_handle = gem_handle;
 
+   /* Each size of the pool is a new BO, and gets a new address.  BOs of the
+    * old sizes stay where they are, so batches which were already set up
+    * for them keep working.
+    */
+   uint64_t bo_offset = pool->bo.offset;
+   if (pool->device->use_softpin) {
+      bo_offset = anv_vma_alloc(&pool->device->vma_heap, size);
+      if (bo_offset == 0)
+         goto fail;
+      cleanup->bo_offset = bo_offset;
+   }
+
 #if 0
    /* Regular objects are created I915_CACHING_CACHED on LLC platforms and
     * I915_CACHING_NONE on non-LLC platforms. However, userptr objects are
@@ -463,15 +482,20 @@ anv_block_pool_grow(struct anv_block_pool *pool, struct anv_block_state *state)
 
    /* Now that we successfull allocated everything, we can write the new
     * values back into pool. */
+   pthread_mutex_lock(&pool->device->mutex);
    pool->map = map + center_bo_offset;
    pool->center_bo_offset = center_bo_offset;
    pool->bo.gem_handle = gem_handle;
+   pool->bo.offset = bo_offset;
    pool->bo.size = size;
    pool->bo.map = map;
    pool->bo.index = 0;
+   pthread_mutex_unlock(&pool->device->mutex);
+
+   pool->grow_count++;
 
 done:
-   pthread_mutex_unlock(&pool->device->mutex);
+   pthread_mutex_unlock(&pool->grow_mutex);
 
    /* Return the appropreate new size.  This function never actually
     * updates state->next.  Instead, we let the caller do that because it
@@ -485,7 +509,7 @@ done:
    }
 
 fail:
-   pthread_mutex_unlock(&pool->device->mutex);
+   pthread_mutex_unlock(&pool->grow_mutex);
 
    return 0;
 }
@@ -812,6 +836,9 @@ anv_bo_pool_finish(struct anv_bo_pool *pool)
 
          anv_gem_munmap(link_copy.bo.map, link_copy.bo.size);
          anv_gem_close(pool->device, link_copy.bo.gem_handle);
+         if (pool->device->use_softpin)
+            anv_vma_free(&pool->device->vma_heap, link_copy.bo.offset,
+                         link_copy.bo.size);
          link = link_copy.next;
       }
    }
@@ -852,6 +879,8 @@ anv_bo_pool_alloc(struct anv_bo_pool *pool, struct anv_bo *bo, uint32_t size)
    new_bo.map = anv_gem_mmap(pool->device, new_bo.gem_handle, 0, pow2_size, 0);
    if (new_bo.map == NULL) {
       anv_gem_close(pool->device, new_bo.gem_handle);
+      if (pool->device->use_softpin)
+         anv_vma_free(&pool->device->vma_heap, new_bo.offset, new_bo.size);
       return vk_error(VK_ERROR_MEMORY_MAP_FAILED);
    }
 
@@ -878,3 +907,120 @@ anv_bo_pool_free(struct anv_bo_pool *pool, const struct anv_bo *bo_in)
    VG(VALGRIND_MEMPOOL_FREE(pool, bo.map));
    anv_ptr_free_list_push(&pool->free_list[bucket], link);
 }
+
+struct anv_vma_hole {
+   struct list_head link;
+   uint64_t offset;
+   uint64_t size;
+};
+
+void
+anv_vma_heap_init(struct anv_vma_heap *heap, uint64_t start, uint64_t size)
+{
+   pthread_mutex_init(&heap->mutex, NULL);
+   list_inithead(&heap->holes);
+   heap->next = start;
+   heap->end = start + size;
+}
+
+void
+anv_vma_heap_finish(struct anv_vma_heap *heap)
+{
+   list_for_each_entry_safe(struct anv_vma_hole, hole, &heap->holes, link)
+      free(hole);
+
+   pthread_mutex_destroy(&heap->mutex);
+}
+
+/**
+ * Returns the address of a free range of \p size bytes, or 0 if the heap
+ * is full.
+ */
+uint64_t
+anv_vma_alloc(struct anv_vma_heap *heap, uint64_t size)
+{
+   uint64_t offset = 0;
+
+   size = align_u64(size, PAGE_SIZE);
+
+   pthread_mutex_lock(&heap->mutex);
+
+   list_for_each_entry(struct anv_vma_hole, hole, &heap->holes, link) {
+      if (hole->size < size)
+         continue;
+
+      offset = hole->offset;
+      hole->offset += size;
+      hole->size -= size;
+      if (hole->size == 0) {
+         list_del(&hole->link);
+         free(hole);
+      }
+      goto done;
+   }
+
+   if (heap->end - heap->next >= size) {
+      offset = heap->next;
+      heap->next += size;
+   }
+
+done:
+   pthread_mutex_unlock(&heap->mutex);
+
+   return offset;
+}
+
+void
+anv_vma_free(struct anv_vma_heap *heap, uint64_t offset, uint64_t size)
+{
+   struct anv_vma_hole *prev = NULL, *next = NULL, *hole;
+
+   if (offset == 0)
+      return;
+
+   size = align_u64(size, PAGE_SIZE);
+
+   pthread_mutex_lock(&heap->mutex);
+
+   list_for_each_entry(struct anv_vma_hole, h, &heap->holes, link) {
+      if (h->offset > offset) {
+         next = h;
+         break;
+      }
+      prev = h;
+   }
+
+   /* Merge the range with its neighbours when they touch. */
+   if (prev && prev->offset + prev->size == offset) {
+      prev->size += size;
+      if (next && prev->offset + prev->size == next->offset) {
+         prev->size += next->size;
+         list_del(&next->link);
+         free(next);
+      }
+      hole = prev;
+   } else if (next && offset + size == next->offset) {
+      next->offset = offset;
+      next->size += size;
+      hole = next;
+   } else {
+      hole = malloc(sizeof(*hole));
+      if (hole == NULL) {
+         /* We just lose the range. */
+         pthread_mutex_unlock(&heap->mutex);
+         return;
+      }
+      hole->offset = offset;
+      hole->size = size;
+      list_addtail(&hole->link, next ? &next->link : &heap->holes);
+   }
+
+   /* A hole at the top of the used range goes back to the bump allocator. */
+   if (hole->offset + hole->size == heap->next) {
+      heap->next = hole->offset;
+      list_del(&hole->link);
+      free(hole);
+   }
+
+   pthread_mutex_unlock(&heap->mutex);
+}
@@ -738,6 +738,22 @@ anv_cmd_buffer_end_batch_buffer(struct anv_cmd_buffer *cmd_buffer)
           * probably better of simply copying it into our batch.
           */
          cmd_buffer->exec_mode = ANV_CMD_BUFFER_EXEC_MODE_EMIT;
+      } else if (cmd_buffer->device->use_softpin) {
+         /* With softpin all batch addresses are known up-front, so the
+          * primary can jump into the secondary and have it jump back
+          * without touching it on the CPU.  That also works for
+          * simultaneous use.  The return MI_BATCH_BUFFER_START goes into
+          * the padding kept at the end of the batch.
+          */
+         cmd_buffer->exec_mode = ANV_CMD_BUFFER_EXEC_MODE_CALL_AND_RETURN;
+
+         cmd_buffer->batch.end += GEN8_MI_BATCH_BUFFER_START_length * 4;
+         cmd_buffer->return_addr = (struct anv_address) {
+            .bo = &batch_bo->bo,
+            .offset = cmd_buffer->batch.next - cmd_buffer->batch.start + 4,
+         };
+         emit_batch_buffer_start(cmd_buffer, NULL, 0);
+         anv_batch_bo_finish(batch_bo, &cmd_buffer->batch);
       } else if (!(cmd_buffer->usage_flags &
                    VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT)) {
          cmd_buffer->exec_mode = ANV_CMD_BUFFER_EXEC_MODE_CHAIN;
@@ -855,6 +871,32 @@ anv_cmd_buffer_add_secondary(struct anv_cmd_buffer *primary,
       anv_cmd_buffer_emit_state_base_address(primary);
       break;
    }
+   case ANV_CMD_BUFFER_EXEC_MODE_CALL_AND_RETURN: {
+      struct anv_batch_bo *first_bbo =
+         list_first_entry(&secondary->batch_bos, struct anv_batch_bo, link);
+
+      /* Patch the return address of the secondary from the GPU, then jump
+       * into it.  The BOs are softpinned below 4GB, so the low dword of the
+       * address is all that needs writing.
+       */
+      uint32_t *write_return_addr =
+         anv_batch_emitn(&primary->batch, GEN8_MI_STORE_DATA_IMM_length,
+                         GEN8_MI_STORE_DATA_IMM,
+                         .Address = secondary->return_addr);
+
+      emit_batch_buffer_start(primary, &first_bbo->bo, 0);
+
+      struct anv_batch_bo *this_bbo = anv_cmd_buffer_current_batch_bo(primary);
+      const uint64_t return_addr = this_bbo->bo.offset +
+         (primary->batch.next - primary->batch.start);
+      assert(return_addr < ANV_VMA_END);
+      write_return_addr[3] = return_addr; /* Data DWord 0 */
+
+      anv_cmd_buffer_add_seen_bbos(primary, &secondary->batch_bos);
+
+      anv_cmd_buffer_emit_state_base_address(primary);
+      break;
+   }
    default:
       assert(!"Invalid execution mode");
    }
@@ -920,6 +962,8 @@ anv_cmd_buffer_add_bo(struct anv_cmd_buffer *cmd_buffer,
       obj->alignment = 0;
       obj->offset = bo->offset;
       obj->flags = bo->is_winsys_bo ? EXEC_OBJECT_WRITE : 0;
+      if (cmd_buffer->device->use_softpin)
+         obj->flags |= EXEC_OBJECT_PINNED;
       obj->rsvd1 = 0;
       obj->rsvd2 = 0;
    }
@@ -927,10 +971,13 @@ anv_cmd_buffer_add_bo(struct anv_cmd_buffer *cmd_buffer,
    if (relocs != NULL && obj->relocation_count == 0) {
       /* This is the first time we've ever seen a list of relocations for
        * this BO.  Go ahead and set the relocations and then walk the list
-       * of relocations and add them all.
+       * of relocations and add them all.  With softpin the list is only
+       * used to find the BOs, the kernel doesn't get to see it.
        */
-      obj->relocation_count = relocs->num_relocs;
-      obj->relocs_ptr = (uintptr_t) relocs->relocs;
+      if (!cmd_buffer->device->use_softpin) {
+         obj->relocation_count = relocs->num_relocs;
+         obj->relocs_ptr = (uintptr_t) relocs->relocs;
+      }
 
       for (size_t i = 0; i < relocs->num_relocs; i++) {
          /* A quick sanity check on relocations */
@@ -1053,6 +1100,29 @@ adjust_relocations_to_block_pool(struct anv_block_pool *pool,
    *last_pool_center_bo_offset = pool->center_bo_offset;
 }
 
+/**
+ * With softpin nothing is relocated by the kernel, so we patch up the
+ * relocations to BOs which got a new address since they were emitted.
+ * Only block pools move, when they grow.
+ */
+static void
+apply_softpin_relocations(const struct anv_device *device,
+                          struct anv_bo *from_bo,
+                          struct anv_reloc_list *relocs)
+{
+   for (size_t i = 0; i < relocs->num_relocs; i++) {
+      const struct anv_bo *bo = relocs->reloc_bos[i];
+
+      if (relocs->relocs[i].presumed_offset == bo->offset)
+         continue;
+
+      assert(relocs->relocs[i].offset < from_bo->size);
+      write_reloc(device, from_bo->map + relocs->relocs[i].offset,
+                  bo->offset + relocs->relocs[i].delta);
+      relocs->relocs[i].presumed_offset = bo->offset;
+   }
+}
+
 void
 anv_cmd_buffer_prepare_execbuf(struct anv_cmd_buffer *cmd_buffer)
 {
@@ -1060,10 +1130,14 @@ anv_cmd_buffer_prepare_execbuf(struct anv_cmd_buffer *cmd_buffer)
    struct anv_block_pool *ss_pool =
       &cmd_buffer->device->surface_state_block_pool;
 
+   const bool use_softpin = cmd_buffer->device->use_softpin;
+
    cmd_buffer->execbuf2.bo_count = 0;
    cmd_buffer->execbuf2.need_reloc = false;
 
-   adjust_relocations_from_block_pool(ss_pool, &cmd_buffer->surface_relocs);
+   /* The surface states point to BOs which never move with softpin. */
+   if (!use_softpin)
+      adjust_relocations_from_block_pool(ss_pool, &cmd_buffer->surface_relocs);
    anv_cmd_buffer_add_bo(cmd_buffer, &ss_pool->bo, &cmd_buffer->surface_relocs);
 
    /* First, we walk over all of the bos we've seen and add them and their
@@ -1073,6 +1147,9 @@ anv_cmd_buffer_prepare_execbuf(struct anv_cmd_buffer *cmd_buffer)
    anv_vector_foreach(bbo, &cmd_buffer->seen_bbos) {
       adjust_relocations_to_block_pool(ss_pool, &(*bbo)->bo, &(*bbo)->relocs,
                                        &(*bbo)->last_ss_pool_bo_offset);
+      if (use_softpin)
+         apply_softpin_relocations(cmd_buffer->device, &(*bbo)->bo,
+                                   &(*bbo)->relocs);
 
       anv_cmd_buffer_add_bo(cmd_buffer, &(*bbo)->bo, &(*bbo)->relocs);
    }
@@ -1106,10 +1183,12 @@ anv_cmd_buffer_prepare_execbuf(struct anv_cmd_buffer *cmd_buffer)
     * the correct indices in the object array.  We have to do this after we
     * reorder the list above as some of the indices may have changed.
     */
-   anv_vector_foreach(bbo, &cmd_buffer->seen_bbos)
-      anv_cmd_buffer_process_relocs(cmd_buffer, &(*bbo)->relocs);
+   if (!use_softpin) {
+      anv_vector_foreach(bbo, &cmd_buffer->seen_bbos)
+         anv_cmd_buffer_process_relocs(cmd_buffer, &(*bbo)->relocs);
 
-   anv_cmd_buffer_process_relocs(cmd_buffer, &cmd_buffer->surface_relocs);
+      anv_cmd_buffer_process_relocs(cmd_buffer, &cmd_buffer->surface_relocs);
+   }
 
    if (!cmd_buffer->device->info.has_llc) {
       __builtin_ia32_mfence();
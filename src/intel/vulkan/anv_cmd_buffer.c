@@ -152,6 +152,8 @@ anv_cmd_state_setup_attachments(struct anv_cmd_buffer *cmd_buffer,
 
    anv_free(&cmd_buffer->pool->alloc, state->attachments);
 
+   state->render_area = info->renderArea;
+
    if (pass->attachment_count == 0) {
       state->attachments = NULL;
       return;
@@ -255,10 +255,25 @@ void anv_DestroyPipelineLayout(
  * until the pool size with no freeing must succeed and 2) allocating and
  * freeing only descriptor sets with the same layout. Case 1) is easy enogh,
  * and the free lists lets us recycle blocks for case 2).
+ *
+ * Freed sets go on a free list for their size, of which we keep a few, so
+ * that allocating a set of a layout which was freed before takes constant
+ * time.  Sets of other sizes go on the general free list.
  */
 
 #define EMPTY 1
 
+static void
+anv_descriptor_pool_reset_free_lists(struct anv_descriptor_pool *pool)
+{
+   pool->next = 0;
+   pool->free_list = EMPTY;
+   for (uint32_t i = 0; i < ANV_DESCRIPTOR_POOL_SIZE_LISTS; i++) {
+      pool->size_lists[i].size = 0;
+      pool->size_lists[i].head = EMPTY;
+   }
+}
+
 VkResult anv_CreateDescriptorPool(
     VkDevice                                    _device,
     const VkDescriptorPoolCreateInfo*           pCreateInfo,
@@ -295,8 +310,7 @@ VkResult anv_CreateDescriptorPool(
       return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
 
    pool->size = size;
-   pool->next = 0;
-   pool->free_list = EMPTY;
+   anv_descriptor_pool_reset_free_lists(pool);
 
    anv_state_stream_init(&pool->surface_state_stream,
                          &device->surface_state_block_pool);
@@ -327,8 +341,7 @@ VkResult anv_ResetDescriptorPool(
    ANV_FROM_HANDLE(anv_device, device, _device);
    ANV_FROM_HANDLE(anv_descriptor_pool, pool, descriptorPool);
 
-   pool->next = 0;
-   pool->free_list = EMPTY;
+   anv_descriptor_pool_reset_free_lists(pool);
    anv_state_stream_finish(&pool->surface_state_stream);
    anv_state_stream_init(&pool->surface_state_stream,
                          &device->surface_state_block_pool);
@@ -351,6 +364,73 @@ layout_size(const struct anv_descriptor_set_layout *layout)
       layout->buffer_count * sizeof(struct anv_buffer_view);
 }
 
+/**
+ * Takes a set from the free list for \p size or, failing that, from the
+ * list of the smallest size which is big enough.
+ */
+static struct anv_descriptor_set *
+pool_size_lists_pop(struct anv_descriptor_pool *pool, uint32_t size)
+{
+   int best = -1;
+
+   for (int i = 0; i < ANV_DESCRIPTOR_POOL_SIZE_LISTS; i++) {
+      if (pool->size_lists[i].head == EMPTY ||
+          pool->size_lists[i].size < size)
+         continue;
+
+      if (best < 0 || pool->size_lists[i].size < pool->size_lists[best].size)
+         best = i;
+
+      if (pool->size_lists[i].size == size)
+         break;
+   }
+
+   if (best < 0)
+      return NULL;
+
+   const uint32_t f = pool->size_lists[best].head;
+   struct pool_free_list_entry *entry =
+      (struct pool_free_list_entry *) (pool->data + f);
+   pool->size_lists[best].head = entry->next;
+
+   return (struct anv_descriptor_set *) entry;
+}
+
+/**
+ * Puts a freed set on the free list for its size, taking over a list which
+ * is empty if there's none for the size yet.  Returns false if all the
+ * lists are in use by other sizes.
+ */
+static bool
+pool_size_lists_push(struct anv_descriptor_pool *pool,
+                     struct pool_free_list_entry *entry)
+{
+   int slot = -1;
+
+   for (int i = 0; i < ANV_DESCRIPTOR_POOL_SIZE_LISTS; i++) {
+      if (pool->size_lists[i].size == entry->size) {
+         slot = i;
+         break;
+      }
+
+      if (slot < 0 && pool->size_lists[i].head == EMPTY)
+         slot = i;
+   }
+
+   if (slot < 0)
+      return false;
+
+   if (pool->size_lists[slot].size != entry->size) {
+      pool->size_lists[slot].size = entry->size;
+      pool->size_lists[slot].head = EMPTY;
+   }
+
+   entry->next = pool->size_lists[slot].head;
+   pool->size_lists[slot].head = (char *) entry - pool->data;
+
+   return true;
+}
+
 struct surface_state_free_list_entry {
    void *next;
    uint32_t offset;
@@ -370,6 +450,10 @@ anv_descriptor_set_create(struct anv_device *device,
       set = (struct anv_descriptor_set *) (pool->data + pool->next);
       pool->next += size;
    } else {
+      set = pool_size_lists_pop(pool, size);
+   }
+
+   if (set == NULL) {
       struct pool_free_list_entry *entry;
       uint32_t *link = &pool->free_list;
       for (uint32_t f = pool->free_list; f != EMPTY; f = entry->next) {
@@ -453,9 +537,11 @@ anv_descriptor_set_destroy(struct anv_device *device,
       pool->next = index;
    } else {
       struct pool_free_list_entry *entry = (struct pool_free_list_entry *) set;
-      entry->next = pool->free_list;
       entry->size = set->size;
-      pool->free_list = (char *) entry - pool->data;
+      if (!pool_size_lists_push(pool, entry)) {
+         entry->next = pool->free_list;
+         pool->free_list = (char *) entry - pool->data;
+      }
    }
 }
 
@@ -26,11 +26,13 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <inttypes.h>
 
 #include "anv_private.h"
 #include "mesa/main/git_sha1.h"
 #include "util/strtod.h"
 #include "util/debug.h"
+#include "util/disk_cache.h"
 
 #include "genxml/gen7_pack.h"
 
@@ -52,6 +54,32 @@ compiler_perf_log(void *data, const char *fmt, ...)
    va_end(args);
 }
 
+static void
+anv_physical_device_init_disk_cache(struct anv_physical_device *device)
+{
+   char gpu_name[16];
+   char timestamp[32];
+
+   device->disk_cache = NULL;
+
+   /* Most debug flags change the generated code or expect to see the
+    * compile happen.
+    */
+   if (INTEL_DEBUG)
+      return;
+
+   if (!disk_cache_get_function_timestamp(
+          (void *) anv_physical_device_init_disk_cache,
+          timestamp, sizeof(timestamp)))
+      return;
+
+   /* Kernels only depend on the device, so devices of the same kind can
+    * share the on-disk cache.
+    */
+   snprintf(gpu_name, sizeof(gpu_name), "anv_%04x", device->chipset_id);
+   device->disk_cache = disk_cache_create(gpu_name, timestamp);
+}
+
 static VkResult
 anv_physical_device_init(struct anv_physical_device *device,
                          struct anv_instance *instance,
@@ -137,6 +165,11 @@ anv_physical_device_init(struct anv_physical_device *device,
 
    bool swizzled = anv_gem_get_bit6_swizzle(fd, I915_TILING_X);
 
+   /* Softpin needs a full PPGTT, as the addresses are per context. */
+   device->has_exec_softpin = device->info->gen >= 8 &&
+      anv_gem_get_param(fd, I915_PARAM_HAS_EXEC_SOFTPIN) &&
+      anv_gem_get_param(fd, I915_PARAM_HAS_ALIASING_PPGTT) >= 2;
+
    close(fd);
 
    brw_process_intel_debug_variable();
@@ -152,6 +185,8 @@ anv_physical_device_init(struct anv_physical_device *device,
    /* XXX: Actually detect bit6 swizzling */
    isl_device_init(&device->isl_dev, device->info, swizzled);
 
+   anv_physical_device_init_disk_cache(device);
+
    return VK_SUCCESS;
 
 fail:
@@ -162,6 +197,7 @@ fail:
 static void
 anv_physical_device_finish(struct anv_physical_device *device)
 {
+   disk_cache_destroy(device->disk_cache);
    ralloc_free(device->compiler);
 }
 
@@ -747,7 +783,7 @@ anv_device_submit_simple_batch(struct anv_device *device,
    exec2_objects[0].relocs_ptr = 0;
    exec2_objects[0].alignment = 0;
    exec2_objects[0].offset = bo.offset;
-   exec2_objects[0].flags = 0;
+   exec2_objects[0].flags = device->use_softpin ? EXEC_OBJECT_PINNED : 0;
    exec2_objects[0].rsvd1 = 0;
    exec2_objects[0].rsvd2 = 0;
 
@@ -853,6 +889,22 @@ VkResult anv_CreateDevice(
 
    pthread_mutex_init(&device->mutex, NULL);
 
+   /* Applications streaming textures create many images with the same
+    * parameters, so remember the layouts isl computes for them.
+    */
+   isl_surf_cache_init(&device->surf_cache);
+   device->isl_dev.surf_cache = &device->surf_cache;
+
+   device->use_softpin = physical_device->has_exec_softpin &&
+      env_var_as_boolean("ANV_ENABLE_SOFTPIN", true);
+   if (device->use_softpin)
+      anv_vma_heap_init(&device->vma_heap, ANV_VMA_START,
+                        ANV_VMA_END - ANV_VMA_START);
+
+   /* HiZ ops are only implemented with 3DSTATE_WM_HZ_OP. */
+   device->use_hiz = device->info.gen >= 8 &&
+      env_var_as_boolean("ANV_ENABLE_HIZ", true);
+
    anv_bo_pool_init(&device->batch_bo_pool, device);
 
    anv_block_pool_init(&device->dynamic_state_block_pool, device, 16384);
@@ -901,6 +953,17 @@ VkResult anv_CreateDevice(
 
    anv_device_init_border_colors(device);
 
+   /* The compiler has its own queue for SIMD16 compiles, which pipeline
+    * threads wait on, so they can't share it.
+    */
+   memset(&device->pipeline_queue, 0, sizeof(device->pipeline_queue));
+   long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+   if (num_cpus > 1 &&
+       env_var_as_boolean("ANV_PARALLEL_PIPELINE_COMPILE", true)) {
+      util_queue_init(&device->pipeline_queue, "anv_pipeline", 32,
+                      MIN2(num_cpus, ANV_MAX_PIPELINE_THREADS));
+   }
+
    *pDevice = anv_device_to_handle(device);
 
    return VK_SUCCESS;
@@ -913,6 +976,26 @@ VkResult anv_CreateDevice(
    return result;
 }
 
+static void
+anv_device_report_block_pools(struct anv_device *device)
+{
+   const struct {
+      const char *name;
+      const struct anv_block_pool *pool;
+   } pools[] = {
+      { "dynamic state", &device->dynamic_state_block_pool },
+      { "instruction", &device->instruction_block_pool },
+      { "surface state", &device->surface_state_block_pool },
+      { "scratch", &device->scratch_block_pool },
+   };
+
+   for (unsigned i = 0; i < ARRAY_SIZE(pools); i++) {
+      fprintf(stderr, "anv: %s block pool: %u grows, %"PRIu64" bytes\n",
+              pools[i].name, pools[i].pool->grow_count,
+              pools[i].pool->bo.size);
+   }
+}
+
 void anv_DestroyDevice(
     VkDevice                                    _device,
     const VkAllocationCallbacks*                pAllocator)
@@ -921,6 +1004,9 @@ void anv_DestroyDevice(
 
    anv_queue_finish(&device->queue);
 
+   if (util_queue_is_initialized(&device->pipeline_queue))
+      util_queue_destroy(&device->pipeline_queue);
+
    anv_device_finish_meta(device);
 
 #ifdef HAVE_VALGRIND
@@ -933,6 +1019,9 @@ void anv_DestroyDevice(
    anv_gem_munmap(device->workaround_bo.map, device->workaround_bo.size);
    anv_gem_close(device, device->workaround_bo.gem_handle);
 
+   if (unlikely(INTEL_DEBUG & DEBUG_PERF))
+      anv_device_report_block_pools(device);
+
    anv_bo_pool_finish(&device->batch_bo_pool);
    anv_state_pool_finish(&device->dynamic_state_pool);
    anv_block_pool_finish(&device->dynamic_state_block_pool);
@@ -941,8 +1030,12 @@ void anv_DestroyDevice(
    anv_block_pool_finish(&device->surface_state_block_pool);
    anv_block_pool_finish(&device->scratch_block_pool);
 
+   if (device->use_softpin)
+      anv_vma_heap_finish(&device->vma_heap);
+
    close(device->fd);
 
+   isl_surf_cache_finish(&device->surf_cache);
    pthread_mutex_destroy(&device->mutex);
 
    anv_free(&device->alloc, device);
@@ -1103,6 +1196,14 @@ anv_bo_init_new(struct anv_bo *bo, struct anv_device *device, uint64_t size)
    bo->size = size;
    bo->is_winsys_bo = false;
 
+   if (device->use_softpin) {
+      bo->offset = anv_vma_alloc(&device->vma_heap, size);
+      if (bo->offset == 0) {
+         anv_gem_close(device, bo->gem_handle);
+         return vk_error(VK_ERROR_OUT_OF_DEVICE_MEMORY);
+      }
+   }
+
    return VK_SUCCESS;
 }
 
@@ -1171,6 +1272,9 @@ void anv_FreeMemory(
    if (mem->bo.gem_handle != 0)
       anv_gem_close(device, mem->bo.gem_handle);
 
+   if (device->use_softpin)
+      anv_vma_free(&device->vma_heap, mem->bo.offset, mem->bo.size);
+
    anv_free2(&device->alloc, pAllocator, mem);
 }
 
@@ -1441,7 +1545,8 @@ VkResult anv_CreateFence(
    fence->exec2_objects[0].relocs_ptr = 0;
    fence->exec2_objects[0].alignment = 0;
    fence->exec2_objects[0].offset = fence->bo.offset;
-   fence->exec2_objects[0].flags = 0;
+   fence->exec2_objects[0].flags =
+      device->use_softpin ? EXEC_OBJECT_PINNED : 0;
    fence->exec2_objects[0].rsvd1 = 0;
    fence->exec2_objects[0].rsvd2 = 0;
 
@@ -154,6 +154,62 @@ make_surface(const struct anv_device *dev,
    return VK_SUCCESS;
 }
 
+/**
+ * Whether the depth surface of the image gets a HiZ buffer.  The depth buffer
+ * emission in genX_cmd_buffer.c only handles LOD 0 and layer 0 and the HiZ
+ * ops don't handle multisampling, so only simple 2D images get one.
+ */
+static bool
+image_wants_hiz(const struct anv_device *dev, const struct anv_image *image)
+{
+   return dev->use_hiz &&
+          image->format->has_depth &&
+          (image->usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) &&
+          image->tiling == VK_IMAGE_TILING_OPTIMAL &&
+          image->type == VK_IMAGE_TYPE_2D &&
+          image->levels == 1 &&
+          image->array_size == 1 &&
+          image->samples == 1;
+}
+
+/**
+ * Initialize anv_image::hiz_surface and update the image's memory
+ * requirements.
+ *
+ * ISL doesn't know about HiZ, so the buffer is described as a Y-tiled R8
+ * surface with the dimensions the Broadwell PRM gives for it, in
+ * "Hierarchical Depth Buffer".
+ */
+static void
+make_hiz_surface(const struct anv_device *dev, struct anv_image *image)
+{
+   bool ok UNUSED;
+
+   /* HZ_QPitch = h0 + max(h1, sum(i=2 to m; h_i)), with a single level. */
+   const uint32_t qpitch = align_u32(image->extent.height, 8) +
+                           align_u32(anv_minify(image->extent.height, 1), 8);
+
+   ok = isl_surf_init(&dev->isl_dev, &image->hiz_surface.isl,
+      .dim = ISL_SURF_DIM_2D,
+      .format = ISL_FORMAT_R8_UINT,
+      /* HZ_Width (bytes) = ceiling(Z_Width / 16) * 16 */
+      .width = align_u32(image->extent.width, 16),
+      /* HZ_Height (rows) = ceiling((HZ_QPitch / 2) / 8) * 8 * Z_Depth */
+      .height = DIV_ROUND_UP(qpitch, 2 * 8) * 8,
+      .depth = 1,
+      .levels = 1,
+      .array_len = 1,
+      .samples = 1,
+      .usage = ISL_SURF_USAGE_DISABLE_AUX_BIT,
+      .tiling_flags = ISL_TILING_Y0_BIT);
+   assert(ok);
+
+   struct anv_surface *hiz = &image->hiz_surface;
+   hiz->offset = align_u32(image->size, hiz->isl.alignment);
+   image->size = hiz->offset + hiz->isl.size;
+   image->alignment = MAX(image->alignment, hiz->isl.alignment);
+}
+
 /**
  * Parameter @a format is required and overrides VkImageCreateInfo::format.
  */
@@ -251,6 +307,9 @@ anv_image_create(VkDevice _device,
          if (r != VK_SUCCESS)
             goto fail;
       }
+
+      if (image_wants_hiz(device, image))
+         make_hiz_surface(device, image);
    }
 
    *pImage = anv_image_to_handle(image);
@@ -60,6 +60,15 @@ VkResult anv_CreateDmaBufImageINTEL(
    mem->bo.offset = 0;
    mem->bo.size = pCreateInfo->strideInBytes * pCreateInfo->extent.height;
 
+   if (device->use_softpin) {
+      mem->bo.offset = anv_vma_alloc(&device->vma_heap, mem->bo.size);
+      if (mem->bo.offset == 0) {
+         anv_gem_close(device, mem->bo.gem_handle);
+         result = vk_error(VK_ERROR_OUT_OF_DEVICE_MEMORY);
+         goto fail;
+      }
+   }
+
    anv_image_create(_device,
       &(struct anv_image_create_info) {
          .isl_tiling_flags = ISL_TILING_X_BIT,
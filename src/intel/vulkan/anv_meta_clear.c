@@ -1020,6 +1020,18 @@ void anv_CmdFillBuffer(
    ANV_FROM_HANDLE(anv_buffer, dst_buffer, dstBuffer);
    struct anv_meta_saved_state saved_state;
 
+   if (cmd_buffer->device->info.gen >= 8 &&
+       fillSize <= ANV_MI_COPY_MAX_SIZE) {
+      uint32_t fill_data[ANV_MI_COPY_MAX_SIZE / 4];
+      for (uint32_t i = 0; i < fillSize / 4; i++)
+         fill_data[i] = data;
+
+      gen8_cmd_buffer_mi_store_data(cmd_buffer, dst_buffer->bo,
+                                    dst_buffer->offset + dstOffset,
+                                    fill_data, fillSize);
+      return;
+   }
+
    meta_clear_begin(&saved_state, cmd_buffer);
 
    VkFormat format;
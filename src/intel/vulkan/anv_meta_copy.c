@@ -332,6 +332,33 @@ void anv_CmdCopyImage(
    anv_meta_end_blit2d(cmd_buffer, &saved_state);
 }
 
+/**
+ * Whether the copies in \p regions are small enough to be done by the
+ * command streamer, without going through meta at all.
+ */
+static bool
+can_copy_buffer_with_mi(struct anv_cmd_buffer *cmd_buffer,
+                        struct anv_buffer *src_buffer,
+                        struct anv_buffer *dest_buffer,
+                        uint32_t regionCount,
+                        const VkBufferCopy *pRegions)
+{
+   if (cmd_buffer->device->info.gen < 8)
+      return false;
+
+   VkDeviceSize total_size = 0;
+   for (unsigned r = 0; r < regionCount; r++) {
+      if ((src_buffer->offset + pRegions[r].srcOffset) % 4 != 0 ||
+          (dest_buffer->offset + pRegions[r].dstOffset) % 4 != 0 ||
+          pRegions[r].size % 4 != 0)
+         return false;
+
+      total_size += pRegions[r].size;
+   }
+
+   return total_size <= ANV_MI_COPY_MAX_SIZE;
+}
+
 void anv_CmdCopyBuffer(
     VkCommandBuffer                             commandBuffer,
     VkBuffer                                    srcBuffer,
@@ -345,6 +372,18 @@ void anv_CmdCopyBuffer(
 
    struct anv_meta_saved_state saved_state;
 
+   if (can_copy_buffer_with_mi(cmd_buffer, src_buffer, dest_buffer,
+                               regionCount, pRegions)) {
+      for (unsigned r = 0; r < regionCount; r++) {
+         gen8_cmd_buffer_mi_memcpy(cmd_buffer, dest_buffer->bo,
+                                   dest_buffer->offset + pRegions[r].dstOffset,
+                                   src_buffer->bo,
+                                   src_buffer->offset + pRegions[r].srcOffset,
+                                   pRegions[r].size);
+      }
+      return;
+   }
+
    anv_meta_begin_blit2d(cmd_buffer, &saved_state);
 
    for (unsigned r = 0; r < regionCount; r++) {
@@ -419,6 +458,14 @@ void anv_CmdUpdateBuffer(
    ANV_FROM_HANDLE(anv_buffer, dst_buffer, dstBuffer);
    struct anv_meta_saved_state saved_state;
 
+   if (cmd_buffer->device->info.gen >= 8 &&
+       dataSize <= ANV_MI_COPY_MAX_SIZE) {
+      gen8_cmd_buffer_mi_store_data(cmd_buffer, dst_buffer->bo,
+                                    dst_buffer->offset + dstOffset,
+                                    pData, dataSize);
+      return;
+   }
+
    anv_meta_begin_blit2d(cmd_buffer, &saved_state);
 
    /* We can't quite grab a full block because the state stream needs a
@@ -1280,6 +1280,109 @@ anv_graphics_pipeline_create(
    }
 }
 
+struct anv_pipeline_job {
+   struct util_queue_fence fence;
+
+   VkDevice device;
+   VkPipelineCache cache;
+   const VkGraphicsPipelineCreateInfo *graphics_info;
+   const VkComputePipelineCreateInfo *compute_info;
+   const VkAllocationCallbacks *alloc;
+   VkPipeline *pipeline;
+
+   /* Number of parents in the same call, for derivative pipelines. */
+   uint32_t depth;
+
+   VkResult result;
+};
+
+static VkResult anv_compute_pipeline_create(
+    VkDevice                                    _device,
+    VkPipelineCache                             _cache,
+    const VkComputePipelineCreateInfo*          pCreateInfo,
+    const VkAllocationCallbacks*                pAllocator,
+    VkPipeline*                                 pPipeline);
+
+static void
+anv_pipeline_job_execute(void *data, int thread_index)
+{
+   struct anv_pipeline_job *job = data;
+
+   if (job->graphics_info) {
+      job->result = anv_graphics_pipeline_create(job->device, job->cache,
+                                                 job->graphics_info, NULL,
+                                                 job->alloc, job->pipeline);
+   } else {
+      job->result = anv_compute_pipeline_create(job->device, job->cache,
+                                                job->compute_info,
+                                                job->alloc, job->pipeline);
+   }
+}
+
+/**
+ * Returns how many parents of pipeline \p i are created in the same call.
+ * Derivatives are compiled after their parent is done, so the stages they
+ * share are found in the pipeline cache instead of compiled twice.
+ */
+static uint32_t
+pipeline_depth(const struct anv_pipeline_job *jobs, uint32_t i,
+               VkPipelineCreateFlags flags, VkPipeline base_handle,
+               int32_t base_index)
+{
+   if (!(flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT) ||
+       base_handle != VK_NULL_HANDLE ||
+       base_index < 0 || (uint32_t) base_index >= i)
+      return 0;
+
+   return jobs[base_index].depth + 1;
+}
+
+/**
+ * Creates the pipelines of \p jobs on the pipeline queue, a level of the
+ * derivative tree at a time.  If any of them fails, the others are
+ * destroyed and the first error is returned.
+ */
+static VkResult
+anv_create_pipelines_parallel(struct anv_device *device,
+                              struct anv_pipeline_job *jobs, uint32_t count,
+                              uint32_t max_depth)
+{
+   VkResult result = VK_SUCCESS;
+
+   for (uint32_t i = 0; i < count; i++)
+      util_queue_fence_init(&jobs[i].fence);
+
+   for (uint32_t depth = 0; depth <= max_depth; depth++) {
+      for (uint32_t i = 0; i < count; i++) {
+         if (jobs[i].depth == depth) {
+            util_queue_add_job(&device->pipeline_queue, &jobs[i],
+                               &jobs[i].fence, anv_pipeline_job_execute);
+         }
+      }
+
+      for (uint32_t i = 0; i < count; i++) {
+         if (jobs[i].depth == depth)
+            util_queue_job_wait(&jobs[i].fence);
+      }
+   }
+
+   for (uint32_t i = 0; i < count; i++) {
+      util_queue_fence_destroy(&jobs[i].fence);
+      if (result == VK_SUCCESS)
+         result = jobs[i].result;
+   }
+
+   if (result != VK_SUCCESS) {
+      for (uint32_t i = 0; i < count; i++) {
+         if (jobs[i].result == VK_SUCCESS)
+            anv_DestroyPipeline(jobs[i].device, *jobs[i].pipeline,
+                                jobs[i].alloc);
+      }
+   }
+
+   return result;
+}
+
 VkResult anv_CreateGraphicsPipelines(
     VkDevice                                    _device,
     VkPipelineCache                             pipelineCache,
@@ -1288,8 +1391,38 @@ VkResult anv_CreateGraphicsPipelines(
     const VkAllocationCallbacks*                pAllocator,
     VkPipeline*                                 pPipelines)
 {
+   ANV_FROM_HANDLE(anv_device, device, _device);
    VkResult result = VK_SUCCESS;
 
+   if (count > 1 && util_queue_is_initialized(&device->pipeline_queue)) {
+      struct anv_pipeline_job *jobs =
+         anv_alloc2(&device->alloc, pAllocator, count * sizeof(*jobs), 8,
+                    VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+      if (jobs == NULL)
+         return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+
+      uint32_t max_depth = 0;
+      for (uint32_t i = 0; i < count; i++) {
+         jobs[i] = (struct anv_pipeline_job) {
+            .device = _device,
+            .cache = pipelineCache,
+            .graphics_info = &pCreateInfos[i],
+            .alloc = pAllocator,
+            .pipeline = &pPipelines[i],
+            .depth = pipeline_depth(jobs, i, pCreateInfos[i].flags,
+                                    pCreateInfos[i].basePipelineHandle,
+                                    pCreateInfos[i].basePipelineIndex),
+         };
+         max_depth = MAX2(max_depth, jobs[i].depth);
+      }
+
+      result = anv_create_pipelines_parallel(device, jobs, count, max_depth);
+
+      anv_free2(&device->alloc, pAllocator, jobs);
+
+      return result;
+   }
+
    unsigned i = 0;
    for (; i < count; i++) {
       result = anv_graphics_pipeline_create(_device,
@@ -1344,8 +1477,38 @@ VkResult anv_CreateComputePipelines(
     const VkAllocationCallbacks*                pAllocator,
     VkPipeline*                                 pPipelines)
 {
+   ANV_FROM_HANDLE(anv_device, device, _device);
    VkResult result = VK_SUCCESS;
 
+   if (count > 1 && util_queue_is_initialized(&device->pipeline_queue)) {
+      struct anv_pipeline_job *jobs =
+         anv_alloc2(&device->alloc, pAllocator, count * sizeof(*jobs), 8,
+                    VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+      if (jobs == NULL)
+         return vk_error(VK_ERROR_OUT_OF_HOST_MEMORY);
+
+      uint32_t max_depth = 0;
+      for (uint32_t i = 0; i < count; i++) {
+         jobs[i] = (struct anv_pipeline_job) {
+            .device = _device,
+            .cache = pipelineCache,
+            .compute_info = &pCreateInfos[i],
+            .alloc = pAllocator,
+            .pipeline = &pPipelines[i],
+            .depth = pipeline_depth(jobs, i, pCreateInfos[i].flags,
+                                    pCreateInfos[i].basePipelineHandle,
+                                    pCreateInfos[i].basePipelineIndex),
+         };
+         max_depth = MAX2(max_depth, jobs[i].depth);
+      }
+
+      result = anv_create_pipelines_parallel(device, jobs, count, max_depth);
+
+      anv_free2(&device->alloc, pAllocator, jobs);
+
+      return result;
+   }
+
    unsigned i = 0;
    for (; i < count; i++) {
       result = anv_compute_pipeline_create(_device, pipelineCache,
@@ -23,6 +23,7 @@
 
 #include "util/mesa-sha1.h"
 #include "util/debug.h"
+#include "util/disk_cache.h"
 #include "anv_private.h"
 
 /* Remaining work:
@@ -79,9 +80,19 @@ struct cache_entry {
 
    char prog_data[0];
 
-   /* kernel follows prog_data at next 64 byte aligned address */
+   /* prog_data is followed by the param array and the surface and sampler
+    * maps.  The kernel follows at the next 64 byte aligned address.
+    */
 };
 
+static uint32_t
+entry_param_count(const struct cache_entry *entry)
+{
+   const struct brw_stage_prog_data *prog_data = (void *) entry->prog_data;
+
+   return prog_data->nr_params;
+}
+
 static uint32_t
 entry_size(struct cache_entry *entry)
 {
@@ -92,8 +103,40 @@ entry_size(struct cache_entry *entry)
    const uint32_t map_size =
       entry->surface_count * sizeof(struct anv_pipeline_binding) +
       entry->sampler_count * sizeof(struct anv_pipeline_binding);
+   const uint32_t params_size =
+      entry_param_count(entry) * sizeof(union gl_constant_value *);
 
-   return sizeof(*entry) + entry->prog_data_size + map_size;
+   return sizeof(*entry) + entry->prog_data_size + params_size + map_size;
+}
+
+/**
+ * Returns the size of the serialized entry at \p p, kernel included, or 0 if
+ * it doesn't fit in the bytes up to \p end.
+ */
+static size_t
+serialized_entry_size(const void *p, const void *end)
+{
+   const struct cache_entry *entry = p;
+   const size_t left = end - p;
+
+   if (left < sizeof(*entry) ||
+       entry->prog_data_size < sizeof(struct brw_stage_prog_data) ||
+       entry->prog_data_size > left - sizeof(*entry))
+      return 0;
+
+   /* Check the counts separately so the size computation can't wrap. */
+   if (entry_param_count(entry) > left ||
+       entry->surface_count > left ||
+       entry->sampler_count > left ||
+       entry->kernel_size > left)
+      return 0;
+
+   const size_t size =
+      entry_size((struct cache_entry *) entry) + entry->kernel_size;
+   if (size > left)
+      return 0;
+
+   return size;
 }
 
 void
@@ -141,6 +184,7 @@ anv_pipeline_cache_search_unlocked(struct anv_pipeline_cache *cache,
             void *p = entry->prog_data;
             *prog_data = p;
             p += entry->prog_data_size;
+            p += entry_param_count(entry) * sizeof(union gl_constant_value *);
             map->surface_count = entry->surface_count;
             map->sampler_count = entry->sampler_count;
             map->image_count = entry->image_count;
@@ -156,6 +200,12 @@ anv_pipeline_cache_search_unlocked(struct anv_pipeline_cache *cache,
    unreachable("hash table should never be full");
 }
 
+static uint32_t
+anv_pipeline_cache_search_disk(struct anv_pipeline_cache *cache,
+                               const unsigned char *sha1,
+                               const struct brw_stage_prog_data **prog_data,
+                               struct anv_pipeline_bind_map *map);
+
 uint32_t
 anv_pipeline_cache_search(struct anv_pipeline_cache *cache,
                           const unsigned char *sha1,
@@ -170,6 +220,9 @@ anv_pipeline_cache_search(struct anv_pipeline_cache *cache,
 
    pthread_mutex_unlock(&cache->mutex);
 
+   if (kernel == NO_KERNEL)
+      kernel = anv_pipeline_cache_search_disk(cache, sha1, prog_data, map);
+
    return kernel;
 }
 
@@ -243,13 +296,51 @@ anv_pipeline_cache_add_entry(struct anv_pipeline_cache *cache,
       anv_pipeline_cache_set_entry(cache, entry, entry_offset);
 }
 
-uint32_t
-anv_pipeline_cache_upload_kernel(struct anv_pipeline_cache *cache,
-                                 const unsigned char *sha1,
-                                 const void *kernel, size_t kernel_size,
-                                 const struct brw_stage_prog_data **prog_data,
-                                 size_t prog_data_size,
-                                 struct anv_pipeline_bind_map *map)
+static struct disk_cache *
+anv_pipeline_cache_get_disk_cache(struct anv_pipeline_cache *cache)
+{
+   /* A disabled pipeline cache doesn't use the disk cache either. */
+   if (cache->table_size == 0)
+      return NULL;
+
+   return cache->device->instance->physicalDevice.disk_cache;
+}
+
+/**
+ * Stores the entry, which must be complete, in the on-disk cache.  The
+ * serialized form is the same as in the vkGetPipelineCacheData() blob.
+ */
+static void
+anv_pipeline_cache_write_to_disk(struct anv_pipeline_cache *cache,
+                                 const struct cache_entry *entry)
+{
+   struct disk_cache *disk_cache = anv_pipeline_cache_get_disk_cache(cache);
+   if (disk_cache == NULL)
+      return;
+
+   const uint32_t size = entry_size((struct cache_entry *) entry);
+   void *data = malloc(size + entry->kernel_size);
+   if (data == NULL)
+      return;
+
+   memcpy(data, entry, size);
+   memcpy(data + size, (const void *) entry + align_u32(size, 64),
+          entry->kernel_size);
+
+   disk_cache_put(disk_cache, entry->sha1, data, size + entry->kernel_size);
+
+   free(data);
+}
+
+static uint32_t
+anv_pipeline_cache_add_kernel(struct anv_pipeline_cache *cache,
+                              const unsigned char *sha1,
+                              const void *kernel, size_t kernel_size,
+                              const struct brw_stage_prog_data **prog_data,
+                              size_t prog_data_size,
+                              const union gl_constant_value **params,
+                              struct anv_pipeline_bind_map *map,
+                              bool write_to_disk)
 {
    pthread_mutex_lock(&cache->mutex);
 
@@ -267,12 +358,15 @@ anv_pipeline_cache_upload_kernel(struct anv_pipeline_cache *cache,
 
    struct cache_entry *entry;
 
+   const uint32_t param_count = (*prog_data)->nr_params;
+   const uint32_t params_size = param_count * sizeof(params[0]);
+
    const uint32_t map_size =
       map->surface_count * sizeof(struct anv_pipeline_binding) +
       map->sampler_count * sizeof(struct anv_pipeline_binding);
 
    const uint32_t preamble_size =
-      align_u32(sizeof(*entry) + prog_data_size + map_size, 64);
+      align_u32(sizeof(*entry) + prog_data_size + params_size + map_size, 64);
 
    const uint32_t size = preamble_size + kernel_size;
 
@@ -291,6 +385,16 @@ anv_pipeline_cache_upload_kernel(struct anv_pipeline_cache *cache,
    memcpy(p, *prog_data, prog_data_size);
    p += prog_data_size;
 
+   /* The param values are offsets into anv_push_constants.  Keep a copy of
+    * the array with the entry so the cached prog_data doesn't point to
+    * memory owned by whoever compiled it.
+    */
+   struct brw_stage_prog_data *entry_prog_data = (void *) entry->prog_data;
+   if (param_count > 0)
+      memcpy(p, params, params_size);
+   entry_prog_data->param = param_count > 0 ? p : NULL;
+   p += params_size;
+
    memcpy(p, map->surface_to_descriptor,
           map->surface_count * sizeof(struct anv_pipeline_binding));
    map->surface_to_descriptor = p;
@@ -315,11 +419,109 @@ anv_pipeline_cache_upload_kernel(struct anv_pipeline_cache *cache,
    if (!cache->device->info.has_llc)
       anv_state_clflush(state);
 
+   if (sha1 && write_to_disk)
+      anv_pipeline_cache_write_to_disk(cache, entry);
+
    *prog_data = (const struct brw_stage_prog_data *) entry->prog_data;
 
    return state.offset + preamble_size;
 }
 
+uint32_t
+anv_pipeline_cache_upload_kernel(struct anv_pipeline_cache *cache,
+                                 const unsigned char *sha1,
+                                 const void *kernel, size_t kernel_size,
+                                 const struct brw_stage_prog_data **prog_data,
+                                 size_t prog_data_size,
+                                 struct anv_pipeline_bind_map *map)
+{
+   return anv_pipeline_cache_add_kernel(cache, sha1, kernel, kernel_size,
+                                        prog_data, prog_data_size,
+                                        (*prog_data)->param, map, true);
+}
+
+/**
+ * Adds the serialized entry at \p data, which must have been checked with
+ * serialized_entry_size(), to the cache.
+ */
+static uint32_t
+anv_pipeline_cache_add_serialized(struct anv_pipeline_cache *cache,
+                                  const void *data,
+                                  const struct brw_stage_prog_data **prog_data,
+                                  struct anv_pipeline_bind_map *map)
+{
+   const struct cache_entry *entry = data;
+
+   const void *p = entry->prog_data;
+   const struct brw_stage_prog_data *entry_prog_data = p;
+   p += entry->prog_data_size;
+
+   const union gl_constant_value **params = (void *) p;
+   p += entry_param_count(entry) * sizeof(params[0]);
+
+   struct anv_pipeline_binding *surface_to_descriptor = (void *) p;
+   p += entry->surface_count * sizeof(struct anv_pipeline_binding);
+   struct anv_pipeline_binding *sampler_to_descriptor = (void *) p;
+   p += entry->sampler_count * sizeof(struct anv_pipeline_binding);
+   const void *kernel = p;
+
+   struct anv_pipeline_bind_map entry_map = {
+      .surface_count = entry->surface_count,
+      .sampler_count = entry->sampler_count,
+      .image_count = entry->image_count,
+      .surface_to_descriptor = surface_to_descriptor,
+      .sampler_to_descriptor = sampler_to_descriptor
+   };
+
+   uint32_t offset =
+      anv_pipeline_cache_add_kernel(cache, entry->sha1,
+                                    kernel, entry->kernel_size,
+                                    &entry_prog_data, entry->prog_data_size,
+                                    params, &entry_map, false);
+
+   if (prog_data) {
+      *prog_data = entry_prog_data;
+      *map = entry_map;
+   }
+
+   return offset;
+}
+
+/**
+ * Looks the kernel up in the on-disk cache shared by all devices of the
+ * same kind, and adds it to \p cache if it's found.  The size of the
+ * on-disk cache is limited and old entries are evicted by util/disk_cache.
+ */
+static uint32_t
+anv_pipeline_cache_search_disk(struct anv_pipeline_cache *cache,
+                               const unsigned char *sha1,
+                               const struct brw_stage_prog_data **prog_data,
+                               struct anv_pipeline_bind_map *map)
+{
+   struct disk_cache *disk_cache = anv_pipeline_cache_get_disk_cache(cache);
+   uint32_t kernel = NO_KERNEL;
+   size_t size;
+
+   if (disk_cache == NULL)
+      return NO_KERNEL;
+
+   void *data = disk_cache_get(disk_cache, sha1, &size);
+   if (data == NULL)
+      return NO_KERNEL;
+
+   const struct cache_entry *entry = data;
+   if (serialized_entry_size(data, data + size) == size &&
+       memcmp(entry->sha1, sha1, sizeof(entry->sha1)) == 0) {
+      kernel = anv_pipeline_cache_add_serialized(cache, data, prog_data, map);
+   } else {
+      disk_cache_remove(disk_cache, sha1);
+   }
+
+   free(data);
+
+   return kernel;
+}
+
 struct cache_header {
    uint32_t header_size;
    uint32_t header_version;
@@ -355,31 +557,12 @@ anv_pipeline_cache_load(struct anv_pipeline_cache *cache,
    void *p = (void *) data + header.header_size;
 
    while (p < end) {
-      struct cache_entry *entry = p;
-
-      void *data = entry->prog_data;
-      const struct brw_stage_prog_data *prog_data = data;
-      data += entry->prog_data_size;
-
-      struct anv_pipeline_binding *surface_to_descriptor = data;
-      data += entry->surface_count * sizeof(struct anv_pipeline_binding);
-      struct anv_pipeline_binding *sampler_to_descriptor = data;
-      data += entry->sampler_count * sizeof(struct anv_pipeline_binding);
-      void *kernel = data;
-
-      struct anv_pipeline_bind_map map = {
-         .surface_count = entry->surface_count,
-         .sampler_count = entry->sampler_count,
-         .image_count = entry->image_count,
-         .surface_to_descriptor = surface_to_descriptor,
-         .sampler_to_descriptor = sampler_to_descriptor
-      };
-
-      anv_pipeline_cache_upload_kernel(cache, entry->sha1,
-                                       kernel, entry->kernel_size,
-                                       &prog_data,
-                                       entry->prog_data_size, &map);
-      p = kernel + entry->kernel_size;
+      const size_t entry_size = serialized_entry_size(p, end);
+      if (entry_size == 0)
+         break;
+
+      anv_pipeline_cache_add_serialized(cache, p, NULL, NULL);
+      p += entry_size;
    }
 }
 
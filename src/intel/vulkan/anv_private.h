@@ -31,6 +31,14 @@
 #include <stdint.h>
 #include <i915_drm.h>
 
+#ifndef I915_PARAM_HAS_EXEC_SOFTPIN
+#define I915_PARAM_HAS_EXEC_SOFTPIN 37
+#endif
+
+#ifndef EXEC_OBJECT_PINNED
+#define EXEC_OBJECT_PINNED (1 << 4)
+#endif
+
 #ifdef HAVE_VALGRIND
 #include <valgrind.h>
 #include <memcheck.h>
@@ -44,6 +52,7 @@
 #include "brw_compiler.h"
 #include "util/macros.h"
 #include "util/list.h"
+#include "util/u_queue.h"
 
 /* Pre-declarations needed for WSI entrypoints */
 struct wl_surface;
@@ -359,6 +368,17 @@ struct anv_block_pool {
 
    uint32_t block_size;
 
+   /* Serializes growing the front and the back of the pool.  The device
+    * mutex is only taken to switch to the new bo, as building the exec
+    * list reads the pool bo under it.
+    */
+   pthread_mutex_t grow_mutex;
+
+   /* Number of times the pool got a new, bigger, bo.  Reported with
+    * INTEL_DEBUG=perf.
+    */
+   uint32_t grow_count;
+
    union anv_free_list free_list;
    struct anv_block_state state;
 
@@ -474,6 +494,30 @@ VkResult anv_bo_pool_alloc(struct anv_bo_pool *pool, struct anv_bo *bo,
                            uint32_t size);
 void anv_bo_pool_free(struct anv_bo_pool *pool, const struct anv_bo *bo);
 
+/* GPU virtual addresses handed out to softpinned BOs.  We stay in the low
+ * 4GB and never use address 0, so that 0 can mean "no address".
+ */
+#define ANV_VMA_START 4096ull
+#define ANV_VMA_END   (1ull << 32)
+
+/**
+ * Allocator for the GPU virtual addresses of softpinned BOs.  Addresses are
+ * handed out from the top of the used range, freed ranges are kept in a
+ * list of holes sorted by address and reused first.
+ */
+struct anv_vma_heap {
+   pthread_mutex_t mutex;
+   struct list_head holes;
+   uint64_t next;
+   uint64_t end;
+};
+
+void anv_vma_heap_init(struct anv_vma_heap *heap,
+                       uint64_t start, uint64_t size);
+void anv_vma_heap_finish(struct anv_vma_heap *heap);
+uint64_t anv_vma_alloc(struct anv_vma_heap *heap, uint64_t size);
+void anv_vma_free(struct anv_vma_heap *heap, uint64_t offset, uint64_t size);
+
 
 void *anv_resolve_entrypoint(uint32_t index);
 
@@ -544,6 +588,10 @@ struct anv_physical_device {
     struct brw_compiler *                       compiler;
     struct isl_device                           isl_dev;
     int                                         cmd_parser_version;
+    bool                                        has_exec_softpin;
+
+    /** On-disk backing of the pipeline caches, shared by all devices. */
+    struct disk_cache *                         disk_cache;
 };
 
 struct anv_wsi_interaface;
@@ -673,10 +721,22 @@ struct anv_device {
     uint32_t                                    chipset_id;
     struct brw_device_info                      info;
     struct isl_device                           isl_dev;
+    struct isl_surf_cache                       surf_cache;
     int                                         context_id;
     int                                         fd;
     bool                                        can_chain_batches;
 
+    /**
+     * With softpin every BO gets a fixed address from vma_heap when it's
+     * created.  The batches are written with the final addresses, so
+     * execbuf doesn't pass any relocations to the kernel.
+     */
+    bool                                        use_softpin;
+    struct anv_vma_heap                         vma_heap;
+
+    /** Whether depth images get a HiZ buffer, see anv_image::hiz_surface. */
+    bool                                        use_hiz;
+
     struct anv_bo_pool                          batch_bo_pool;
 
     struct anv_block_pool                       dynamic_state_block_pool;
@@ -696,6 +756,12 @@ struct anv_device {
 
     struct anv_queue                            queue;
 
+    /**
+     * Threads compiling the pipelines of a vkCreate*Pipelines() call in
+     * parallel.  Not initialized on single CPU systems.
+     */
+    struct util_queue                           pipeline_queue;
+
     struct anv_block_pool                       scratch_block_pool;
 
     uint32_t                                    default_mocs;
@@ -703,6 +769,9 @@ struct anv_device {
     pthread_mutex_t                             mutex;
 };
 
+/** Largest number of threads in anv_device::pipeline_queue. */
+#define ANV_MAX_PIPELINE_THREADS 8
+
 void anv_device_get_cache_uuid(void *uuid);
 
 
@@ -988,11 +1057,21 @@ struct anv_descriptor_set {
    struct anv_descriptor descriptors[0];
 };
 
+#define ANV_DESCRIPTOR_POOL_SIZE_LISTS 8
+
 struct anv_descriptor_pool {
    uint32_t size;
    uint32_t next;
    uint32_t free_list;
 
+   /* Free lists of sets of a single size, so that recycling the sets of a
+    * layout doesn't have to walk free_list.
+    */
+   struct {
+      uint32_t size;
+      uint32_t head;
+   } size_lists[ANV_DESCRIPTOR_POOL_SIZE_LISTS];
+
    struct anv_state_stream surface_state_stream;
    void *surface_state_free_list;
 
@@ -1154,6 +1233,14 @@ struct anv_attachment_state {
    VkClearValue                                 clear_value;
 };
 
+/**
+ * The only depth value HiZ fast clears to.  3DSTATE_CLEAR_PARAMS has to hold
+ * the value of the last fast clear whenever a HiZ buffer is in use, and
+ * secondary command buffers don't know the clear values of the render pass,
+ * so it is fixed.
+ */
+#define ANV_HZ_FC_VAL 1.0f
+
 /** State required while building cmd buffer */
 struct anv_cmd_state {
    /* PIPELINE_SELECT.PipelineSelection */
@@ -1172,6 +1259,7 @@ struct anv_cmd_state {
    struct anv_framebuffer *                     framebuffer;
    struct anv_render_pass *                     pass;
    struct anv_subpass *                         subpass;
+   VkRect2D                                     render_area;
    uint32_t                                     restart_index;
    struct anv_vertex_binding                    vertex_bindings[MAX_VBS];
    struct anv_descriptor_set *                  descriptors[MAX_SETS];
@@ -1207,6 +1295,7 @@ enum anv_cmd_buffer_exec_mode {
    ANV_CMD_BUFFER_EXEC_MODE_GROW_AND_EMIT,
    ANV_CMD_BUFFER_EXEC_MODE_CHAIN,
    ANV_CMD_BUFFER_EXEC_MODE_COPY_AND_CHAIN,
+   ANV_CMD_BUFFER_EXEC_MODE_CALL_AND_RETURN,
 };
 
 struct anv_cmd_buffer {
@@ -1226,6 +1315,12 @@ struct anv_cmd_buffer {
    struct list_head                             batch_bos;
    enum anv_cmd_buffer_exec_mode                exec_mode;
 
+   /* For ANV_CMD_BUFFER_EXEC_MODE_CALL_AND_RETURN, the address of the
+    * address field of the MI_BATCH_BUFFER_START which ends the secondary.
+    * The primary writes its return address there before jumping in.
+    */
+   struct anv_address                           return_addr;
+
    /* A vector of anv_batch_bo pointers for every batch or surface buffer
     * referenced by this command buffer
     *
@@ -1308,6 +1403,21 @@ VkResult
 anv_cmd_buffer_new_binding_table_block(struct anv_cmd_buffer *cmd_buffer);
 
 void gen8_cmd_buffer_emit_viewport(struct anv_cmd_buffer *cmd_buffer);
+
+/**
+ * Largest buffer copy, update or fill done by the command streamer rather
+ * than through meta.  Below this, the MI commands are cheaper than the
+ * state meta emits and re-emits afterwards.
+ */
+#define ANV_MI_COPY_MAX_SIZE 256
+
+void gen8_cmd_buffer_mi_memcpy(struct anv_cmd_buffer *cmd_buffer,
+                               struct anv_bo *dst, uint32_t dst_offset,
+                               struct anv_bo *src, uint32_t src_offset,
+                               uint32_t size);
+void gen8_cmd_buffer_mi_store_data(struct anv_cmd_buffer *cmd_buffer,
+                                   struct anv_bo *dst, uint32_t dst_offset,
+                                   const uint32_t *data, uint32_t size);
 void gen7_cmd_buffer_emit_scissor(struct anv_cmd_buffer *cmd_buffer);
 
 void anv_cmd_buffer_emit_state_base_address(struct anv_cmd_buffer *cmd_buffer);
@@ -1600,8 +1710,26 @@ struct anv_image {
          struct anv_surface stencil_surface;
       };
    };
+
+   /**
+    * Hierarchical depth buffer of the depth surface, allocated after the
+    * other surfaces in the same bo.  Its isl.size is 0 if the image has no
+    * HiZ buffer.
+    *
+    * The HiZ buffer is only used inside render pass instances.  It is
+    * rebuilt from the depth surface when the render pass begins, unless the
+    * depth is cleared then, and the depth surface is resolved at the end of
+    * each subpass.  Everything else accesses the depth surface only.
+    */
+   struct anv_surface hiz_surface;
 };
 
+static inline bool
+anv_image_has_hiz(const struct anv_image *image)
+{
+   return image->hiz_surface.isl.size > 0;
+}
+
 static inline uint32_t
 anv_get_layerCount(const struct anv_image *image,
                    const VkImageSubresourceRange *range)
@@ -89,6 +89,49 @@ gen8_cmd_buffer_emit_viewport(struct anv_cmd_buffer *cmd_buffer)
       clip.SFClipViewportPointer = sf_clip_state.offset;
    }
 }
+
+/**
+ * Copies \p size bytes, a multiple of 4, with the command streamer.  The MI
+ * commands are the same on gen9, so this is also used there.
+ */
+void
+gen8_cmd_buffer_mi_memcpy(struct anv_cmd_buffer *cmd_buffer,
+                          struct anv_bo *dst, uint32_t dst_offset,
+                          struct anv_bo *src, uint32_t src_offset,
+                          uint32_t size)
+{
+   assert(size % 4 == 0 && dst_offset % 4 == 0 && src_offset % 4 == 0);
+
+   for (uint32_t i = 0; i < size; i += 4) {
+      anv_batch_emit(&cmd_buffer->batch, GENX(MI_COPY_MEM_MEM), cp) {
+         cp.DestinationMemoryAddress = (struct anv_address) {
+            dst, dst_offset + i
+         };
+         cp.SourceMemoryAddress = (struct anv_address) {
+            src, src_offset + i
+         };
+      }
+   }
+}
+
+/**
+ * Writes \p size bytes of \p data, a multiple of 4, with the command
+ * streamer.
+ */
+void
+gen8_cmd_buffer_mi_store_data(struct anv_cmd_buffer *cmd_buffer,
+                              struct anv_bo *dst, uint32_t dst_offset,
+                              const uint32_t *data, uint32_t size)
+{
+   assert(size % 4 == 0 && dst_offset % 4 == 0);
+
+   for (uint32_t i = 0; i < size / 4; i++) {
+      anv_batch_emit(&cmd_buffer->batch, GENX(MI_STORE_DATA_IMM), sdi) {
+         sdi.Address = (struct anv_address) { dst, dst_offset + i * 4 };
+         sdi.DataDWord0 = data[i];
+      }
+   }
+}
 #endif
 
 void
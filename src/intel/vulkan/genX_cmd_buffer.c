@@ -919,18 +919,41 @@ genX(cmd_buffer_alloc_null_surface_state)(struct anv_cmd_buffer *cmd_buffer,
    return state;
 }
 
+/**
+ * Whether rendering to \p iview in the current framebuffer uses the HiZ
+ * buffer of its image.  HiZ ops work on the whole image, so the framebuffer
+ * has to cover all of it.
+ */
+static bool
+cmd_buffer_view_uses_hiz(const struct anv_cmd_buffer *cmd_buffer,
+                         const struct anv_image_view *iview)
+{
+#if GEN_GEN >= 8
+   const struct anv_framebuffer *fb = cmd_buffer->state.framebuffer;
+
+   return iview != NULL &&
+          anv_format_for_vk_format(iview->vk_format)->has_depth &&
+          anv_image_has_hiz(iview->image) &&
+          fb->width == iview->image->extent.width &&
+          fb->height == iview->image->extent.height;
+#else
+   return false;
+#endif
+}
+
 static void
-cmd_buffer_emit_depth_stencil(struct anv_cmd_buffer *cmd_buffer)
+cmd_buffer_emit_depth_stencil(struct anv_cmd_buffer *cmd_buffer,
+                              const struct anv_image_view *iview)
 {
    struct anv_device *device = cmd_buffer->device;
    const struct anv_framebuffer *fb = cmd_buffer->state.framebuffer;
-   const struct anv_image_view *iview =
-      anv_cmd_buffer_get_depth_stencil_view(cmd_buffer);
    const struct anv_image *image = iview ? iview->image : NULL;
    const struct anv_format *anv_format =
       iview ? anv_format_for_vk_format(iview->vk_format) : NULL;
    const bool has_depth = iview && anv_format->has_depth;
    const bool has_stencil = iview && anv_format->has_stencil;
+   const bool has_hiz = has_depth &&
+                        cmd_buffer_view_uses_hiz(cmd_buffer, iview);
 
    /* FIXME: Implement the PMA stall W/A */
    /* FIXME: Width and Height are wrong */
@@ -941,7 +964,7 @@ cmd_buffer_emit_depth_stencil(struct anv_cmd_buffer *cmd_buffer)
          db.SurfaceType                   = SURFTYPE_2D;
          db.DepthWriteEnable              = true;
          db.StencilWriteEnable            = has_stencil;
-         db.HierarchicalDepthBufferEnable = false;
+         db.HierarchicalDepthBufferEnable = has_hiz;
 
          db.SurfaceFormat = isl_surf_get_depth_format(&device->isl_dev,
                                                       &image->depth_surface.isl);
@@ -1020,6 +1043,26 @@ cmd_buffer_emit_depth_stencil(struct anv_cmd_buffer *cmd_buffer)
       anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_STENCIL_BUFFER), sb);
    }
 
+#if GEN_GEN >= 8
+   if (has_hiz) {
+      anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_HIER_DEPTH_BUFFER), hz) {
+         hz.HierarchicalDepthBufferObjectControlState = GENX(MOCS);
+         hz.SurfacePitch = image->hiz_surface.isl.row_pitch - 1;
+         hz.SurfaceBaseAddress = (struct anv_address) {
+            .bo = image->bo,
+            .offset = image->offset + image->hiz_surface.offset,
+         };
+         /* Images with HiZ have a single layer, the QPitch is unused. */
+      }
+
+      anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_CLEAR_PARAMS), cp) {
+         cp.DepthClearValue = ANV_HZ_FC_VAL;
+         cp.DepthClearValueValid = true;
+      }
+      return;
+   }
+#endif
+
    /* Disable hierarchial depth buffers. */
    anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_HIER_DEPTH_BUFFER), hz);
 
@@ -1027,6 +1070,169 @@ cmd_buffer_emit_depth_stencil(struct anv_cmd_buffer *cmd_buffer)
    anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_CLEAR_PARAMS), cp);
 }
 
+static void
+cmd_buffer_emit_drawing_rectangle(struct anv_cmd_buffer *cmd_buffer)
+{
+   const VkRect2D *render_area = &cmd_buffer->state.render_area;
+
+   anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_DRAWING_RECTANGLE), r) {
+      r.ClippedDrawingRectangleYMin = MAX2(render_area->offset.y, 0);
+      r.ClippedDrawingRectangleXMin = MAX2(render_area->offset.x, 0);
+      r.ClippedDrawingRectangleYMax =
+         render_area->offset.y + render_area->extent.height - 1;
+      r.ClippedDrawingRectangleXMax =
+         render_area->offset.x + render_area->extent.width - 1;
+      r.DrawingRectangleOriginY     = 0;
+      r.DrawingRectangleOriginX     = 0;
+   }
+}
+
+#if GEN_GEN >= 8
+enum anv_hz_op {
+   /** Fast clear the depth to ANV_HZ_FC_VAL. */
+   ANV_HZ_OP_DEPTH_CLEAR,
+   /** Write the depth values HiZ stands for to the depth surface. */
+   ANV_HZ_OP_DEPTH_RESOLVE,
+   /** Rebuild the HiZ buffer from the depth surface. */
+   ANV_HZ_OP_HIZ_RESOLVE,
+};
+
+/**
+ * Run a HiZ op on the whole depth buffer bound with
+ * cmd_buffer_emit_depth_stencil(), following gen8_hiz_exec() in i965.
+ * The op clobbers the multisample state and the drawing rectangle, which
+ * are restored afterwards.
+ */
+static void
+cmd_buffer_emit_hz_op(struct anv_cmd_buffer *cmd_buffer,
+                      const struct anv_image *image, enum anv_hz_op op)
+{
+   /* Depth buffer clears and HiZ resolves must use an 8x4 aligned
+    * rectangle.  The HiZ buffer is allocated with that alignment, so
+    * expanding the size just touches padding.
+    */
+   const uint32_t rect_width = align_u32(image->extent.width, 8);
+   const uint32_t rect_height = align_u32(image->extent.height, 4);
+
+   /* From the documentation for 3DSTATE_WM_HZ_OP: "3DSTATE_MULTISAMPLE
+    * packet must be used prior to this packet to change the Number of
+    * Multisamples."  Images with HiZ are single-sampled.
+    */
+   anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_MULTISAMPLE), ms) {
+      ms.PixelLocation = CENTER;
+      ms.NumberofMultisamples = 0;
+   }
+
+   anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_DRAWING_RECTANGLE), r) {
+      r.ClippedDrawingRectangleXMax = rect_width - 1;
+      r.ClippedDrawingRectangleYMax = rect_height - 1;
+   }
+
+   anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_WM_HZ_OP), hzp) {
+      switch (op) {
+      case ANV_HZ_OP_DEPTH_CLEAR:
+         hzp.DepthBufferClearEnable = true;
+         break;
+      case ANV_HZ_OP_DEPTH_RESOLVE:
+         hzp.DepthBufferResolveEnable = true;
+         break;
+      case ANV_HZ_OP_HIZ_RESOLVE:
+         hzp.HierarchicalDepthBufferResolveEnable = true;
+         break;
+      }
+      hzp.ClearRectangleXMax = rect_width;
+      hzp.ClearRectangleYMax = rect_height;
+      hzp.SampleMask = 0xffff;
+   }
+
+   /* A PIPE_CONTROL with a post-sync write and no other bits set makes the
+    * 3DSTATE_WM_HZ_OP state take effect and spawns the rectangle.
+    */
+   anv_batch_emit(&cmd_buffer->batch, GENX(PIPE_CONTROL), pc) {
+      pc.DestinationAddressType  = DAT_PPGTT;
+      pc.PostSyncOperation       = WriteImmediateData;
+      pc.Address = (struct anv_address) {
+         &cmd_buffer->device->workaround_bo, 0
+      };
+   }
+
+   /* Return to normal rendering. */
+   anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_WM_HZ_OP), hzp);
+
+   cmd_buffer_emit_drawing_rectangle(cmd_buffer);
+   cmd_buffer->state.dirty |= ANV_CMD_DIRTY_PIPELINE;
+}
+#endif
+
+/**
+ * Get the HiZ buffers of the render pass attachments ready for rendering.
+ * An attachment whose depth is cleared by the render pass is fast cleared
+ * if the clear value allows it, the others get their HiZ buffer rebuilt
+ * since the depth surface may have been written without HiZ.
+ */
+static void
+cmd_buffer_prepare_hiz_attachments(struct anv_cmd_buffer *cmd_buffer)
+{
+#if GEN_GEN >= 8
+   const struct anv_framebuffer *fb = cmd_buffer->state.framebuffer;
+
+   for (uint32_t i = 0; i < cmd_buffer->state.pass->attachment_count; i++) {
+      const struct anv_image_view *iview = fb->attachments[i];
+      struct anv_attachment_state *att_state =
+         &cmd_buffer->state.attachments[i];
+
+      if (!cmd_buffer_view_uses_hiz(cmd_buffer, iview))
+         continue;
+
+      /* Meta clears the whole framebuffer, which is the whole image here,
+       * so the render area doesn't matter.
+       */
+      const bool fast_clear =
+         (att_state->pending_clear_aspects & VK_IMAGE_ASPECT_DEPTH_BIT) &&
+         att_state->clear_value.depthStencil.depth == ANV_HZ_FC_VAL;
+
+      anv_batch_emit(&cmd_buffer->batch, GENX(PIPE_CONTROL), pc) {
+         pc.DepthStallEnable = true;
+         pc.DepthCacheFlushEnable = true;
+      }
+
+      cmd_buffer_emit_depth_stencil(cmd_buffer, iview);
+
+      if (fast_clear) {
+         cmd_buffer_emit_hz_op(cmd_buffer, iview->image,
+                               ANV_HZ_OP_DEPTH_CLEAR);
+         att_state->pending_clear_aspects &= ~VK_IMAGE_ASPECT_DEPTH_BIT;
+      } else {
+         cmd_buffer_emit_hz_op(cmd_buffer, iview->image,
+                               ANV_HZ_OP_HIZ_RESOLVE);
+      }
+   }
+#endif
+}
+
+/**
+ * Write the depth of the current subpass back to the depth surface, so
+ * that anything but HiZ-enabled rendering sees it.
+ */
+static void
+cmd_buffer_resolve_hiz_subpass(struct anv_cmd_buffer *cmd_buffer)
+{
+#if GEN_GEN >= 8
+   const struct anv_image_view *iview =
+      anv_cmd_buffer_get_depth_stencil_view(cmd_buffer);
+
+   if (!cmd_buffer_view_uses_hiz(cmd_buffer, iview))
+      return;
+
+   anv_batch_emit(&cmd_buffer->batch, GENX(PIPE_CONTROL), pc) {
+      pc.DepthStallEnable = true;
+      pc.DepthCacheFlushEnable = true;
+   }
+
+   cmd_buffer_emit_hz_op(cmd_buffer, iview->image, ANV_HZ_OP_DEPTH_RESOLVE);
+#endif
+}
+
 /**
  * @see anv_cmd_buffer_set_subpass()
  */
@@ -1038,7 +1244,8 @@ genX(cmd_buffer_set_subpass)(struct anv_cmd_buffer *cmd_buffer,
 
    cmd_buffer->state.descriptors_dirty |= VK_SHADER_STAGE_FRAGMENT_BIT;
 
-   cmd_buffer_emit_depth_stencil(cmd_buffer);
+   cmd_buffer_emit_depth_stencil(cmd_buffer,
+      anv_cmd_buffer_get_depth_stencil_view(cmd_buffer));
 }
 
 void genX(CmdBeginRenderPass)(
@@ -1056,18 +1263,8 @@ void genX(CmdBeginRenderPass)(
 
    genX(flush_pipeline_select_3d)(cmd_buffer);
 
-   const VkRect2D *render_area = &pRenderPassBegin->renderArea;
-
-   anv_batch_emit(&cmd_buffer->batch, GENX(3DSTATE_DRAWING_RECTANGLE), r) {
-      r.ClippedDrawingRectangleYMin = MAX2(render_area->offset.y, 0);
-      r.ClippedDrawingRectangleXMin = MAX2(render_area->offset.x, 0);
-      r.ClippedDrawingRectangleYMax =
-         render_area->offset.y + render_area->extent.height - 1;
-      r.ClippedDrawingRectangleXMax =
-         render_area->offset.x + render_area->extent.width - 1;
-      r.DrawingRectangleOriginY     = 0;
-      r.DrawingRectangleOriginX     = 0;
-   }
+   cmd_buffer_prepare_hiz_attachments(cmd_buffer);
+   cmd_buffer_emit_drawing_rectangle(cmd_buffer);
 
    genX(cmd_buffer_set_subpass)(cmd_buffer, pass->subpasses);
    anv_cmd_buffer_clear_subpass(cmd_buffer);
@@ -1081,6 +1278,7 @@ void genX(CmdNextSubpass)(
 
    assert(cmd_buffer->level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
+   cmd_buffer_resolve_hiz_subpass(cmd_buffer);
    anv_cmd_buffer_resolve_subpass(cmd_buffer);
    genX(cmd_buffer_set_subpass)(cmd_buffer, cmd_buffer->state.subpass + 1);
    anv_cmd_buffer_clear_subpass(cmd_buffer);
@@ -1091,6 +1289,7 @@ void genX(CmdEndRenderPass)(
 {
    ANV_FROM_HANDLE(anv_cmd_buffer, cmd_buffer, commandBuffer);
 
+   cmd_buffer_resolve_hiz_subpass(cmd_buffer);
    anv_cmd_buffer_resolve_subpass(cmd_buffer);
 }
 
@@ -84,6 +84,7 @@
 #include <sys/types.h>
 #endif
 #include "loader.h"
+#include "c11/threads.h"
 
 #ifdef HAVE_LIBDRM
 #include <xf86drm.h>
@@ -579,8 +580,54 @@ drm_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
 #endif
 
 
-int
-loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
+/* PCI IDs of the devices seen by this process, keyed by device number.
+ * Probing a device and picking its driver each query the ID, and every
+ * query goes through udev, sysfs or an ioctl.
+ */
+#define PCI_ID_CACHE_SIZE 16
+
+static struct {
+   dev_t rdev;
+   int vendor_id;
+   int chip_id;
+} pci_id_cache[PCI_ID_CACHE_SIZE];
+static unsigned pci_id_cache_count;
+static mtx_t pci_id_cache_mutex = _MTX_INITIALIZER_NP;
+
+static int
+pci_id_cache_lookup(dev_t rdev, int *vendor_id, int *chip_id)
+{
+   unsigned i;
+   int found = 0;
+
+   mtx_lock(&pci_id_cache_mutex);
+   for (i = 0; i < pci_id_cache_count; i++) {
+      if (pci_id_cache[i].rdev == rdev) {
+         *vendor_id = pci_id_cache[i].vendor_id;
+         *chip_id = pci_id_cache[i].chip_id;
+         found = 1;
+         break;
+      }
+   }
+   mtx_unlock(&pci_id_cache_mutex);
+   return found;
+}
+
+static void
+pci_id_cache_add(dev_t rdev, int vendor_id, int chip_id)
+{
+   mtx_lock(&pci_id_cache_mutex);
+   if (pci_id_cache_count < PCI_ID_CACHE_SIZE) {
+      pci_id_cache[pci_id_cache_count].rdev = rdev;
+      pci_id_cache[pci_id_cache_count].vendor_id = vendor_id;
+      pci_id_cache[pci_id_cache_count].chip_id = chip_id;
+      pci_id_cache_count++;
+   }
+   mtx_unlock(&pci_id_cache_mutex);
+}
+
+static int
+get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
 {
 #if HAVE_LIBUDEV
    if (libudev_get_pci_id_for_fd(fd, vendor_id, chip_id))
@@ -597,6 +644,25 @@ loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
    return 0;
 }
 
+int
+loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
+{
+   struct stat buf;
+
+   /* Only character devices have a stable identity to cache. */
+   if (fstat(fd, &buf) < 0 || !S_ISCHR(buf.st_mode))
+      return get_pci_id_for_fd(fd, vendor_id, chip_id);
+
+   if (pci_id_cache_lookup(buf.st_rdev, vendor_id, chip_id))
+      return 1;
+
+   if (!get_pci_id_for_fd(fd, vendor_id, chip_id))
+      return 0;
+
+   pci_id_cache_add(buf.st_rdev, *vendor_id, *chip_id);
+   return 1;
+}
+
 
 #ifdef HAVE_LIBUDEV
 static char *
@@ -77,6 +77,8 @@ dri3_update_num_back(struct loader_dri3_drawable *draw)
    }
    if (draw->vtable->get_swap_interval(draw) == 0)
       draw->num_back++;
+   if (draw->num_back < draw->min_back)
+      draw->num_back = draw->min_back;
 }
 
 void
@@ -149,6 +151,14 @@ loader_dri3_drawable_init(xcb_connection_t *conn,
    draw->have_fake_front = 0;
    draw->first_init = true;
 
+   draw->min_back = 0;
+   if (getenv("LIBGL_DRI3_BACK_BUFFERS")) {
+      draw->min_back = atoi(getenv("LIBGL_DRI3_BACK_BUFFERS"));
+      if (draw->min_back > LOADER_DRI3_MAX_BACK)
+         draw->min_back = LOADER_DRI3_MAX_BACK;
+   }
+   draw->mailbox = getenv("LIBGL_DRI3_MAILBOX") != NULL;
+
    if (draw->ext->config)
       draw->ext->config->configQueryi(draw->dri_screen,
                                       "vblank_mode", &vblank_mode);
@@ -354,6 +364,27 @@ loader_dri3_wait_for_sbc(struct loader_dri3_drawable *draw,
    return 1;
 }
 
+/** dri3_flush_present_events
+ *
+ * Process any present events that have been received from the X server
+ */
+static void
+dri3_flush_present_events(struct loader_dri3_drawable *draw)
+{
+   /* Check to see if any configuration changes have occurred
+    * since we were last invoked
+    */
+   if (draw->special_event) {
+      xcb_generic_event_t    *ev;
+
+      while ((ev = xcb_poll_for_special_event(draw->conn,
+                                              draw->special_event)) != NULL) {
+         xcb_present_generic_event_t *ge = (void *) ev;
+         dri3_handle_present_event(draw, ge);
+      }
+   }
+}
+
 /** loader_dri3_find_back
  *
  * Find an idle back buffer. If there isn't one, then
@@ -366,6 +397,11 @@ dri3_find_back(struct loader_dri3_drawable *draw)
    xcb_generic_event_t *ev;
    xcb_present_generic_event_t *ge;
 
+   /* Pick up idle notifies that have already arrived, so a buffer the server
+    * released is found without blocking.
+    */
+   dri3_flush_present_events(draw);
+
    for (;;) {
       for (b = 0; b < draw->num_back; b++) {
          int id = LOADER_DRI3_BACK_ID((b + draw->cur_back) % draw->num_back);
@@ -597,27 +633,6 @@ loader_dri3_wait_gl(struct loader_dri3_drawable *draw)
    loader_dri3_copy_drawable(draw, draw->drawable, front->pixmap);
 }
 
-/** dri3_flush_present_events
- *
- * Process any present events that have been received from the X server
- */
-static void
-dri3_flush_present_events(struct loader_dri3_drawable *draw)
-{
-   /* Check to see if any configuration changes have occurred
-    * since we were last invoked
-    */
-   if (draw->special_event) {
-      xcb_generic_event_t    *ev;
-
-      while ((ev = xcb_poll_for_special_event(draw->conn,
-                                              draw->special_event)) != NULL) {
-         xcb_present_generic_event_t *ge = (void *) ev;
-         dri3_handle_present_event(draw, ge);
-      }
-   }
-}
-
 /** loader_dri3_swap_buffers_msc
  *
  * Make the current back buffer visible using the present extension
@@ -693,9 +708,11 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
        *
        * Implementation note: It is possible to enable triple buffering
        * behaviour by not using XCB_PRESENT_OPTION_ASYNC, but this should not be
-       * the default.
+       * the default.  LIBGL_DRI3_MAILBOX selects it: every swap then targets
+       * the last known MSC, so the server shows the newest one at the next
+       * vblank and skips (and idles) any older one still queued.
        */
-      if (swap_interval == 0)
+      if (swap_interval == 0 && !draw->mailbox)
           options |= XCB_PRESENT_OPTION_ASYNC;
       if (force_copy)
           options |= XCB_PRESENT_OPTION_COPY;
@@ -149,6 +149,14 @@ struct loader_dri3_drawable {
    int cur_back;
    int num_back;
 
+   /* Lower bound on num_back requested by the user (LIBGL_DRI3_BACK_BUFFERS) */
+   int min_back;
+
+   /* With a swap interval of 0, queue swaps for the next vblank, replacing
+    * any not yet shown, rather than presenting them asynchronously.
+    */
+   bool mailbox;
+
    uint32_t *stamp;
 
    xcb_present_event_t eid;
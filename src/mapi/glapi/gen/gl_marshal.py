@@ -0,0 +1,398 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2012 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# This script generates the file marshal_generated.c, which contains the
+# entry points of the glthread marshalling dispatch table
+# (_mesa_create_marshal_table()) and the functions executing the marshalled
+# commands on the server thread (_mesa_unmarshal_dispatch_cmd()).
+#
+# Each entry point is either marshalled asynchronously, copying its
+# parameters and any client memory they point to into the current batch,
+# or executed synchronously on the client thread once the server thread is
+# idle.  Entry points returning a value, writing to client memory, or
+# taking pointers whose size can't be computed from the XML are
+# synchronous.
+
+import argparse
+import re
+import license
+import gl_XML
+
+
+header = """
+#include <string.h>
+#include "main/context.h"
+#include "main/dispatch.h"
+#include "main/glthread.h"
+#include "main/macros.h"
+"""
+
+
+# Entry points that must not return before their effect is complete.
+sync_functions = frozenset([
+    'Finish',
+    ])
+
+# Entry points whose pointer is an offset into the bound pixel unpack buffer
+# when there is one, so their data can't be copied blindly.
+pbo_functions = frozenset([
+    'Bitmap',
+    'PixelMapfv',
+    'PixelMapuiv',
+    'PixelMapusv',
+    'PolygonStipple',
+    ])
+
+# Entry points after which the current batch is handed to the server
+# thread right away.
+flush_functions = frozenset([
+    'Flush',
+    ])
+
+# Client-side state tracking, run on the client thread before the command
+# is marshalled.
+client_hooks = {
+    'BindBuffer': '_mesa_glthread_BindBuffer(ctx, target, buffer);',
+    'DeleteBuffers': '_mesa_glthread_DeleteBuffers(ctx, n, buffer);',
+    'BindVertexArray': '_mesa_glthread_BindVertexArray(ctx, array);',
+    'PopClientAttrib': '_mesa_glthread_PopClientAttrib(ctx);',
+    }
+
+# Local variable names used by the generated code.
+reserved_names = frozenset(['ctx', 'cmd', 'cmd_data', 'cmd_size',
+                            'variable_data', 'result'])
+
+
+def is_draw(func):
+    """Whether func sources vertices from the current vertex arrays."""
+    return (re.search(r'Draw(Range)?(Arrays|Elements)', func.name) or
+            func.name.startswith('DrawTransformFeedback') or
+            func.name == 'ArrayElement')
+
+
+def is_vertex_pointer(func):
+    """Whether func points a vertex array at buffer or client memory."""
+    return (func.name.endswith('Pointer') or
+            func.name.endswith('PointerEXT') or
+            func.name.endswith('PointerOES') or
+            func.name == 'InterleavedArrays')
+
+
+def is_offset_param(func, p):
+    """Whether p is an offset into a bound buffer rather than client memory
+    when the matching buffer binding is non-zero (or in a core context).
+    Those are marshalled by value."""
+    if p.type_string().count('*') != 1:
+        return False
+    if is_draw(func):
+        return p.name in ('indices', 'indirect')
+    if is_vertex_pointer(func):
+        return p.name == 'pointer'
+    return False
+
+
+def is_copied_param(p):
+    """Whether the memory p points to is copied into the command."""
+    return p.is_pointer() and p.type_string().count('*') == 1 and \
+        not p.is_output and not p.is_image() and \
+        not p.count_parameter_list and (p.count or p.counter)
+
+
+def marshal_async(func):
+    if func.name in sync_functions or func.return_type != 'void':
+        return False
+
+    if func.name in pbo_functions or func.name.startswith('CompressedTex'):
+        return False
+
+    for p in func.parameterIterator():
+        if p.is_padding or not p.is_pointer():
+            continue
+        if p.is_output:
+            return False
+        if is_offset_param(func, p):
+            continue
+        if not is_copied_param(p):
+            return False
+
+    return True
+
+
+class PrintCode(gl_XML.gl_print_base):
+
+    def __init__(self):
+        gl_XML.gl_print_base.__init__(self)
+
+        self.name = 'gl_marshal.py'
+        self.license = license.bsd_license_template % (
+            'Copyright (C) 2012 Intel Corporation',
+            'Intel Corporation')
+
+    def printRealHeader(self):
+        print header
+
+    def printRealFooter(self):
+        pass
+
+    def params(self, func):
+        return [p for p in func.parameterIterator() if not p.is_padding]
+
+    def fixed_params(self, func):
+        return [p for p in self.params(func) if not is_copied_param(p)]
+
+    def variable_params(self, func):
+        return [p for p in self.params(func) if is_copied_param(p)]
+
+    def size_expr(self, p):
+        if p.counter:
+            return '(int64_t) {0} * {1}'.format(p.counter, p.size())
+        return str(p.size())
+
+    def print_sync_call(self, func, indent):
+        call = 'CALL_{0}(ctx->CurrentDispatch, ({1}))'.format(
+            func.name, func.get_called_parameter_string())
+        print indent + '_mesa_glthread_finish(ctx);'
+        if func.return_type != 'void':
+            print indent + 'result = {0};'.format(call)
+            print indent + '_mesa_glthread_restore_dispatch(ctx);'
+            print indent + 'return result;'
+        else:
+            print indent + call + ';'
+            print indent + '_mesa_glthread_restore_dispatch(ctx);'
+
+    def print_sync_body(self, func):
+        print '/* {0}: marshalled synchronously */'.format(func.name)
+        print 'static {0} GLAPIENTRY'.format(func.return_type)
+        print '_mesa_marshal_{0}({1})'.format(
+            func.name, func.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        if func.return_type != 'void':
+            print '   {0} result;'.format(func.return_type)
+        if func.name in client_hooks:
+            print '   ' + client_hooks[func.name]
+        self.print_sync_call(func, '   ')
+        print '}'
+        print ''
+        print ''
+
+    def print_async_struct(self, func):
+        print 'struct marshal_cmd_{0}'.format(func.name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in self.fixed_params(func):
+            print '   {0};'.format(p.string())
+        for p in self.variable_params(func):
+            print '   GLboolean {0}_null;'.format(p.name)
+        for p in self.variable_params(func):
+            print ('   /* Next ALIGN({0}, 8) bytes are {1} */'.format(
+                self.size_expr(p), p.string()))
+        print '};'
+
+    def print_async_unmarshal(self, func):
+        print 'static void'
+        print '_mesa_unmarshal_{0}(struct gl_context *ctx, const void *cmd_data)' \
+            .format(func.name)
+        print '{'
+        if self.params(func):
+            print '   const struct marshal_cmd_{0} *cmd = cmd_data;'.format(func.name)
+        for p in self.fixed_params(func):
+            print '   {0} = cmd->{1};'.format(p.string(), p.name)
+        if self.variable_params(func):
+            print '   const char *variable_data = (const char *) cmd +'
+            print '      ALIGN(sizeof(*cmd), 8);'
+            for p in self.variable_params(func):
+                print '   {0} = NULL;'.format(p.string())
+            for p in self.variable_params(func):
+                print '   if (!cmd->{0}_null) {{'.format(p.name)
+                print '      {0} = ({1}) variable_data;'.format(
+                    p.name, p.type_string())
+                print '      variable_data += ALIGN({0}, 8);'.format(
+                    self.size_expr(p))
+                print '   }'
+        print '   CALL_{0}(ctx->CurrentDispatch, ({1}));'.format(
+            func.name, func.get_called_parameter_string())
+        print '}'
+
+    def print_async_marshal(self, func):
+        variable_params = self.variable_params(func)
+
+        print 'static void GLAPIENTRY'
+        print '_mesa_marshal_{0}({1})'.format(
+            func.name, func.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        for p in variable_params:
+            print '   const int64_t {0}_size = {1} ? {2} : 0;'.format(
+                p.name, p.name, self.size_expr(p))
+        print '   int64_t cmd_size = ALIGN(sizeof(struct marshal_cmd_{0}), 8);' \
+            .format(func.name)
+        if self.params(func):
+            print '   struct marshal_cmd_{0} *cmd;'.format(func.name)
+        if variable_params:
+            print '   char *variable_data;'
+        for p in variable_params:
+            print '   cmd_size += ALIGN({0}_size, 8);'.format(p.name)
+
+        if func.name in client_hooks:
+            print '   ' + client_hooks[func.name]
+
+        conditions = []
+        for p in variable_params:
+            conditions.append('{0}_size < 0'.format(p.name))
+        if variable_params:
+            conditions.append('cmd_size > MARSHAL_MAX_CMD_SIZE')
+        if is_draw(func):
+            params = [p.name for p in self.params(func)]
+            if 'indices' in params:
+                conditions.append('_mesa_glthread_is_non_vbo_draw_elements(ctx)')
+            else:
+                conditions.append('_mesa_glthread_is_non_vbo_draw(ctx)')
+        elif any(is_offset_param(func, p) for p in self.params(func)):
+            conditions.append('_mesa_glthread_is_non_vbo_vertex_pointer(ctx)')
+
+        if conditions:
+            print ''
+            print '   if (unlikely({0})) {{'.format(
+                ' ||\n                '.join(conditions))
+            if is_vertex_pointer(func) and not is_draw(func):
+                print '      ctx->GLThread->has_client_arrays = true;'
+            self.print_sync_call(func, '      ')
+            print '      return;'
+            print '   }'
+
+        print ''
+        print '   {0}_mesa_glthread_allocate_command(ctx, DISPATCH_CMD_{1}, cmd_size);' \
+            .format('cmd = ' if self.params(func) else '', func.name)
+        for p in self.fixed_params(func):
+            print '   cmd->{0} = {0};'.format(p.name)
+        if variable_params:
+            print '   variable_data = (char *) cmd + ALIGN(sizeof(*cmd), 8);'
+            for p in variable_params:
+                print '   cmd->{0}_null = !{0};'.format(p.name)
+                print '   if (!cmd->{0}_null) {{'.format(p.name)
+                print '      memcpy(variable_data, {0}, {0}_size);'.format(p.name)
+                print '      variable_data += ALIGN({0}_size, 8);'.format(p.name)
+                print '   }'
+        if func.name in flush_functions:
+            print '   _mesa_glthread_flush_batch(ctx);'
+        print '}'
+        print ''
+        print ''
+
+    def printBody(self, api):
+        async_funcs = []
+        all_funcs = []
+
+        for func in api.functionIterateByOffset():
+            for p in self.params(func):
+                if p.name in reserved_names:
+                    raise Exception('{0} has reserved parameter name {1!r}'
+                                    .format(func.name, p.name))
+            all_funcs.append(func)
+            if marshal_async(func):
+                async_funcs.append(func)
+
+        print 'enum marshal_dispatch_cmd_id'
+        print '{'
+        for func in async_funcs:
+            print '   DISPATCH_CMD_{0},'.format(func.name)
+        print '   NUM_DISPATCH_CMD'
+        print '};'
+        print ''
+        print ''
+
+        for func in all_funcs:
+            if func in async_funcs:
+                print '/* {0}: marshalled asynchronously */'.format(func.name)
+                self.print_async_struct(func)
+                self.print_async_unmarshal(func)
+                self.print_async_marshal(func)
+            else:
+                self.print_sync_body(func)
+
+        print 'typedef void (*unmarshal_func)(struct gl_context *ctx,'
+        print '                               const void *cmd);'
+        print ''
+        print 'static const unmarshal_func unmarshal_dispatch[NUM_DISPATCH_CMD] = {'
+        for func in async_funcs:
+            print '   _mesa_unmarshal_{0},'.format(func.name)
+        print '};'
+        print ''
+        print ''
+        print '/**'
+        print ' * Execute the command at \\p cmd on the server thread.'
+        print ' *'
+        print ' * \\return the size of the command in bytes.'
+        print ' */'
+        print 'size_t'
+        print '_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd)'
+        print '{'
+        print '   const struct marshal_cmd_base *cmd_base = cmd;'
+        print ''
+        print '   assert(cmd_base->cmd_id < NUM_DISPATCH_CMD);'
+        print '   unmarshal_dispatch[cmd_base->cmd_id](ctx, cmd);'
+        print '   return cmd_base->cmd_size;'
+        print '}'
+        print ''
+        print ''
+        print '/**'
+        print ' * Create the dispatch table used by the client thread when glthread'
+        print ' * is enabled.'
+        print ' */'
+        print 'struct _glapi_table *'
+        print '_mesa_create_marshal_table(const struct gl_context *ctx)'
+        print '{'
+        print '   struct _glapi_table *table;'
+        print ''
+        print '   table = _mesa_alloc_dispatch_table();'
+        print '   if (table == NULL)'
+        print '      return NULL;'
+        print ''
+        for func in all_funcs:
+            print '   SET_{0}(table, _mesa_marshal_{0});'.format(func.name)
+        print ''
+        print '   return table;'
+        print '}'
+
+
+def _parser():
+    """Parse arguments and return namespace."""
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-f',
+                        dest='filename',
+                        default='gl_and_es_API.xml',
+                        help='an xml file describing an API')
+    return parser.parse_args()
+
+
+def main():
+    """Main function."""
+    args = _parser()
+    printer = PrintCode()
+    api = gl_XML.parse_GL_API(args.filename)
+    printer.Print(api)
+
+
+if __name__ == '__main__':
+    main()
@@ -26,6 +26,9 @@
 #include "compiler/nir/nir.h"
 #include "main/errors.h"
 #include "util/debug.h"
+#include "util/u_queue.h"
+
+#include <unistd.h>
 
 static void
 shader_debug_log_mesa(void *data, const char *fmt, ...)
@@ -136,6 +139,43 @@ static const struct nir_shader_compiler_options vector_nir_options_gen6 = {
    .lower_extract_word = true,
 };
 
+/** Largest number of threads in brw_compiler::compile_queue. */
+#define BRW_MAX_COMPILE_THREADS 4
+
+static void
+brw_compiler_destroy(void *ptr)
+{
+   struct brw_compiler *compiler = ptr;
+
+   util_queue_destroy(compiler->compile_queue);
+   free(compiler->compile_queue);
+}
+
+static void
+brw_compiler_init_queue(struct brw_compiler *compiler)
+{
+   long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+   if (num_cpus < 2 || !env_var_as_boolean("INTEL_PARALLEL_COMPILE", true))
+      return;
+
+   compiler->compile_queue = calloc(1, sizeof(*compiler->compile_queue));
+   if (!compiler->compile_queue)
+      return;
+
+   if (!util_queue_init(compiler->compile_queue, "i965_compile", 32,
+                        MIN2(num_cpus - 1, BRW_MAX_COMPILE_THREADS))) {
+      free(compiler->compile_queue);
+      compiler->compile_queue = NULL;
+      return;
+   }
+
+   /* The queue isn't allocated with ralloc, the children of the compiler
+    * are already gone when the destructor runs.
+    */
+   ralloc_set_destructor(compiler, brw_compiler_destroy);
+}
+
 struct brw_compiler *
 brw_compiler_create(void *mem_ctx, const struct brw_device_info *devinfo)
 {
@@ -150,6 +190,8 @@ brw_compiler_create(void *mem_ctx, const struct brw_device_info *devinfo)
 
    compiler->precise_trig = env_var_as_boolean("INTEL_PRECISE_TRIG", false);
 
+   brw_compiler_init_queue(compiler);
+
    compiler->scalar_stage[MESA_SHADER_VERTEX] =
       devinfo->gen >= 8 && !(INTEL_DEBUG & DEBUG_VEC4VS);
    compiler->scalar_stage[MESA_SHADER_TESS_CTRL] = false;
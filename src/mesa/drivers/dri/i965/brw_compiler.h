@@ -98,6 +98,12 @@ struct brw_compiler {
     * This can negatively impact performance.
     */
    bool precise_trig;
+
+   /**
+    * Threads compiling the SIMD16 variant of fragment shaders while the
+    * SIMD8 one is compiled by the calling thread, or NULL.
+    */
+   struct util_queue *compile_queue;
 };
 
 
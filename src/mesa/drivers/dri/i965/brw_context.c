@@ -767,6 +767,8 @@ brw_process_driconf_options(struct brw_context *brw)
    }
 
    brw->precompile = driQueryOptionb(&brw->optionCache, "shader_precompile");
+   brw->precompile_observed_keys =
+      driQueryOptionb(&brw->optionCache, "shader_precompile_observed_keys");
 
    ctx->Const.ForceGLSLExtensionsWarn =
       driQueryOptionb(options, "force_glsl_extensions_warn");
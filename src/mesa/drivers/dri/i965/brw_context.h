@@ -593,6 +593,13 @@ struct brw_query_object {
 
    /** True if we know the batch has been flushed since we ended the query. */
    bool flushed;
+
+   /**
+    * True if the GPU sets an availability flag in the BO once the final
+    * snapshot has landed, so the result can be read before the whole batch
+    * retires.
+    */
+   bool has_availability;
 };
 
 enum brw_gpu_ring {
@@ -607,6 +614,13 @@ struct intel_batchbuffer {
    /** Last BO submitted to the hardware.  Used for glFinish(). */
    drm_intel_bo *last_bo;
 
+   /**
+    * Recently submitted batch BOs, reused by later batches once the GPU is
+    * done with them.  On LLC platforms they stay mapped.
+    */
+   drm_intel_bo *bo_ring[4];
+   unsigned bo_ring_next;
+
 #ifdef DEBUG
    uint16_t emit, total;
 #endif
@@ -839,6 +853,7 @@ struct brw_context
    bool always_flush_cache;
    bool disable_throttling;
    bool precompile;
+   bool precompile_observed_keys;
    bool dual_color_blend_by_location;
 
    driOptionCache optionCache;
@@ -1270,6 +1285,16 @@ struct brw_context
    const struct brw_tracked_state render_atoms[76];
    const struct brw_tracked_state compute_atoms[11];
 
+   /**
+    * For each dirty bit, the atoms of each pipeline which check it, as a
+    * bitmask of positions in render_atoms/compute_atoms.  Built along with
+    * the atom lists so that state upload only visits atoms with work to do.
+    */
+   struct {
+      uint64_t mesa[32][2];
+      uint64_t brw[BRW_NUM_STATE_BITS][2];
+   } atom_masks[BRW_NUM_PIPELINES];
+
    /* If (INTEL_DEBUG & DEBUG_BATCH) */
    struct {
       uint32_t offset;
@@ -32,6 +32,7 @@
 #include "intel_batchbuffer.h"
 #include "brw_nir.h"
 #include "brw_program.h"
+#include "brw_disk_cache.h"
 #include "compiler/glsl/ir_uniform.h"
 
 static void
@@ -121,9 +122,20 @@ brw_codegen_cs_prog(struct brw_context *brw,
       st_index = brw_get_shader_time_index(brw, prog, &cp->program.Base, ST_CS);
 
    char *error_str;
-   program = brw_compile_cs(brw->intelScreen->compiler, brw, mem_ctx,
-                            key, &prog_data, cp->program.Base.nir,
-                            st_index, &program_size, &error_str);
+   struct brw_disk_cache_item cache_item;
+   program = brw_disk_cache_search(brw, &cache_item, prog, BRW_CACHE_CS_PROG,
+                                   key, sizeof(*key), &key->program_string_id,
+                                   &prog_data, sizeof(prog_data), mem_ctx,
+                                   &program_size);
+   if (program == NULL) {
+      program = brw_compile_cs(brw->intelScreen->compiler, brw, mem_ctx,
+                               key, &prog_data, cp->program.Base.nir,
+                               st_index, &program_size, &error_str);
+      if (program) {
+         brw_disk_cache_store(brw, &cache_item, program, program_size,
+                              &prog_data, sizeof(prog_data));
+      }
+   }
    if (program == NULL) {
       prog->LinkStatus = false;
       ralloc_strcat(&prog->InfoLog, error_str);
@@ -0,0 +1,142 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file brw_dataflow.cpp
+ *
+ * Worklist solver for the backward liveness problem shared by the fs and
+ * vec4 backends.
+ */
+
+#include "brw_dataflow.h"
+
+using namespace brw;
+
+/**
+ * Allocates the per-block sets for a problem over \p bitset_words words.
+ *
+ * The four sets of all blocks come out of a single zeroed allocation, so a
+ * block's sets are adjacent in memory and the solver walks them linearly.
+ */
+struct block_data *
+brw::alloc_block_data(void *mem_ctx, const cfg_t *cfg, int bitset_words)
+{
+   struct block_data *block_data =
+      rzalloc_array(mem_ctx, struct block_data, cfg->num_blocks);
+   BITSET_WORD *sets =
+      rzalloc_array(mem_ctx, BITSET_WORD, 4 * bitset_words * cfg->num_blocks);
+
+   for (int i = 0; i < cfg->num_blocks; i++) {
+      block_data[i].def = sets;
+      block_data[i].use = sets + bitset_words;
+      block_data[i].livein = sets + 2 * bitset_words;
+      block_data[i].liveout = sets + 3 * bitset_words;
+      sets += 4 * bitset_words;
+   }
+
+   return block_data;
+}
+
+/**
+ * Sets liveout of \p block to the union of its successors' livein and
+ * recomputes livein from it, returning whether livein changed.
+ *
+ * The loops are kept free of branches so the compiler can vectorize them.
+ */
+static bool
+update_block(const bblock_t *block, struct block_data *block_data,
+             int bitset_words)
+{
+   struct block_data *bd = &block_data[block->num];
+   BITSET_WORD changed = 0;
+
+   foreach_list_typed(bblock_link, child_link, link, &block->children) {
+      const struct block_data *child_bd = &block_data[child_link->block->num];
+
+      for (int i = 0; i < bitset_words; i++)
+         bd->liveout[i] |= child_bd->livein[i];
+      bd->flag_liveout[0] |= child_bd->flag_livein[0];
+   }
+
+   for (int i = 0; i < bitset_words; i++) {
+      BITSET_WORD new_livein = bd->use[i] | (bd->liveout[i] & ~bd->def[i]);
+      changed |= new_livein & ~bd->livein[i];
+      bd->livein[i] |= new_livein;
+   }
+
+   BITSET_WORD new_livein = (bd->flag_use[0] |
+                             (bd->flag_liveout[0] & ~bd->flag_def[0]));
+   changed |= new_livein & ~bd->flag_livein[0];
+   bd->flag_livein[0] |= new_livein;
+
+   return changed != 0;
+}
+
+/**
+ * Solves livein/liveout of every block from its def and use sets.
+ *
+ * Rather than sweeping the whole program until nothing changes, this keeps
+ * a worklist of the blocks whose successors' livein may have grown.  It is
+ * seeded in reverse program order, which for the structured control flow we
+ * generate is close to postorder, so most blocks only see changes once and
+ * only the loop bodies get revisited.
+ */
+void
+brw::compute_backward_liveness(const cfg_t *cfg, struct block_data *block_data,
+                               int bitset_words)
+{
+   const int num_blocks = cfg->num_blocks;
+   bblock_t **worklist = new bblock_t *[num_blocks];
+   BITSET_WORD *in_worklist = new BITSET_WORD[BITSET_WORDS(num_blocks)];
+   int head = 0, count = 0;
+
+   /* A block is never queued twice, so a ring of num_blocks entries is
+    * enough.
+    */
+   for (int i = num_blocks - 1; i >= 0; i--)
+      worklist[count++] = cfg->blocks[i];
+   memset(in_worklist, 0xff, BITSET_WORDS(num_blocks) * sizeof(BITSET_WORD));
+
+   while (count > 0) {
+      bblock_t *block = worklist[head];
+      head = (head + 1) % num_blocks;
+      count--;
+      BITSET_CLEAR(in_worklist, block->num);
+
+      if (!update_block(block, block_data, bitset_words))
+         continue;
+
+      foreach_list_typed(bblock_link, parent_link, link, &block->parents) {
+         bblock_t *parent = parent_link->block;
+
+         if (BITSET_TEST(in_worklist, parent->num))
+            continue;
+
+         BITSET_SET(in_worklist, parent->num);
+         worklist[(head + count) % num_blocks] = parent;
+         count++;
+      }
+   }
+
+   delete[] worklist;
+   delete[] in_worklist;
+}
@@ -0,0 +1,458 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file brw_disk_cache.c
+ *
+ * Disk-backed tier below the in-memory program cache (brw_state_cache.c).
+ *
+ * Compiled kernels of GLSL programs are stored in the shared on-disk cache
+ * (util/disk_cache.c) under the SHA-1 of the program source, the stage and
+ * the program key, so that a warm start can skip the backend compile.  The
+ * GLSL front end still runs; only brw_compile_* is skipped.
+ *
+ * The program key includes program_string_id, which is a per-process
+ * counter, so it is left out of the hash.
+ *
+ * The keys of the programs compiled at draw time are recorded as well, so
+ * that the next link of the same program can precompile them instead of
+ * only the guessed key (see brw_disk_cache_record_key()).
+ */
+
+#include "main/imports.h"
+#include "compiler/glsl/shader_cache.h"
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+#include "brw_disk_cache.h"
+#include "intel_screen.h"
+
+/**
+ * Header of an entry.
+ *
+ * The layout follows the entries of the anv pipeline cache: the header is
+ * followed by the prog_data and then by the kernel.  In between come the
+ * indices of the param and pull_param references, which anv doesn't need.
+ */
+struct brw_disk_cache_entry {
+   uint32_t prog_data_size;
+   uint32_t kernel_size;
+   uint32_t nr_params;
+   uint32_t nr_pull_params;
+};
+
+/** Index stored for a NULL uniform reference. */
+#define NO_PARAM 0xffffffffu
+
+void
+brw_disk_cache_init(struct intel_screen *screen)
+{
+   char gpu_name[16];
+   char timestamp[32];
+
+   /* Most debug flags change the generated code or expect to see the
+    * compile happen.
+    */
+   if (INTEL_DEBUG)
+      return;
+
+   if (!disk_cache_get_function_timestamp((void *) brw_disk_cache_init,
+                                          timestamp, sizeof(timestamp)))
+      return;
+
+   snprintf(gpu_name, sizeof(gpu_name), "i965_%04x", screen->deviceID);
+   screen->disk_cache = disk_cache_create(gpu_name, timestamp);
+}
+
+void
+brw_disk_cache_destroy(struct intel_screen *screen)
+{
+   disk_cache_destroy(screen->disk_cache);
+   screen->disk_cache = NULL;
+}
+
+/**
+ * Compute \c prog->sha1 at link time, unless the GLSL shader cache has done
+ * so already.
+ */
+void
+brw_disk_cache_compute_program_sha1(struct gl_context *ctx,
+                                    struct gl_shader_program *prog)
+{
+   if (ctx->Cache)
+      return;
+
+   for (unsigned i = 0; i < prog->NumShaders; i++)
+      shader_cache_compute_shader_sha1(ctx, prog->Shaders[i]);
+
+   shader_cache_compute_program_sha1(ctx, prog);
+}
+
+static bool
+compute_key(struct brw_disk_cache_item *item,
+            const struct gl_shader_program *prog,
+            enum brw_cache_id cache_id,
+            const void *key, size_t key_size,
+            const unsigned *program_string_id)
+{
+   const uint8_t *bytes = key;
+   const size_t id_start = (const uint8_t *) program_string_id - bytes;
+   const size_t id_end = id_start + sizeof(*program_string_id);
+   const uint32_t id = cache_id;
+   struct mesa_sha1 *sha1_ctx = _mesa_sha1_init();
+
+   if (sha1_ctx == NULL)
+      return false;
+
+   assert(id_end <= key_size);
+
+   _mesa_sha1_update(sha1_ctx, prog->sha1, sizeof(prog->sha1));
+   _mesa_sha1_update(sha1_ctx, &id, sizeof(id));
+   _mesa_sha1_update(sha1_ctx, bytes, id_start);
+   _mesa_sha1_update(sha1_ctx, bytes + id_end, key_size - id_end);
+   _mesa_sha1_final(sha1_ctx, item->key);
+
+   return true;
+}
+
+/**
+ * Compute the name of the list of keys observed for \p prog and
+ * \p cache_id.
+ */
+static bool
+compute_observed_keys_name(cache_key name,
+                           const struct gl_shader_program *prog,
+                           enum brw_cache_id cache_id)
+{
+   static const char marker[] = "observed keys";
+   const uint32_t id = cache_id;
+   struct mesa_sha1 *sha1_ctx = _mesa_sha1_init();
+
+   if (sha1_ctx == NULL)
+      return false;
+
+   _mesa_sha1_update(sha1_ctx, prog->sha1, sizeof(prog->sha1));
+   _mesa_sha1_update(sha1_ctx, &id, sizeof(id));
+   _mesa_sha1_update(sha1_ctx, marker, sizeof(marker));
+   _mesa_sha1_final(sha1_ctx, name);
+
+   return true;
+}
+
+static bool
+entry_is_valid(const struct brw_disk_cache_item *item,
+               const struct brw_disk_cache_entry *entry, size_t size,
+               size_t prog_data_size)
+{
+   const uint32_t *indices;
+
+   if (size < sizeof(*entry) || entry->prog_data_size != prog_data_size)
+      return false;
+
+   if (size != sizeof(*entry) + prog_data_size +
+               (size_t) (entry->nr_params + entry->nr_pull_params) *
+               sizeof(uint32_t) + entry->kernel_size)
+      return false;
+
+   indices = (const uint32_t *) ((const uint8_t *) (entry + 1) +
+                                 prog_data_size);
+   for (unsigned i = 0; i < entry->nr_params + entry->nr_pull_params; i++) {
+      if (indices[i] != NO_PARAM && indices[i] >= item->nr_params)
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * Look up the kernel for a program in the disk cache.
+ *
+ * \p prog_data must have its uniform references set up as for a compile.
+ * On a hit it is filled in as brw_compile_* would, and the kernel is
+ * returned, allocated out of \p mem_ctx.  Otherwise NULL is returned, and
+ * \p item is ready for storing the result of the real compile with
+ * brw_disk_cache_store().
+ */
+const unsigned *
+brw_disk_cache_search(struct brw_context *brw,
+                      struct brw_disk_cache_item *item,
+                      struct gl_shader_program *prog,
+                      enum brw_cache_id cache_id,
+                      const void *key, size_t key_size,
+                      const unsigned *program_string_id,
+                      void *prog_data, size_t prog_data_size,
+                      void *mem_ctx, unsigned *program_size)
+{
+   struct disk_cache *cache = brw->intelScreen->disk_cache;
+   struct brw_stage_prog_data *stage_prog_data = prog_data;
+   const struct brw_disk_cache_entry *entry;
+   const uint32_t *indices;
+   size_t size;
+
+   item->enabled = false;
+
+   /* ARB and fixed function programs have no source hash. */
+   if (!cache || !prog)
+      return NULL;
+
+   if (!compute_key(item, prog, cache_id, key, key_size, program_string_id))
+      return NULL;
+
+   item->nr_params = stage_prog_data->nr_params;
+   item->params = ralloc_array(mem_ctx, const union gl_constant_value *,
+                               item->nr_params);
+   memcpy(item->params, stage_prog_data->param,
+          item->nr_params * sizeof(*item->params));
+   item->enabled = true;
+
+   entry = disk_cache_get(cache, item->key, &size);
+   if (!entry)
+      return NULL;
+
+   if (!entry_is_valid(item, entry, size, prog_data_size)) {
+      disk_cache_remove(cache, item->key);
+      free((void *) entry);
+      return NULL;
+   }
+
+   /* The uniform references are the ones set up by the caller, resolved
+    * through the stored indices.
+    */
+   const struct brw_stage_prog_data saved = *stage_prog_data;
+   memcpy(prog_data, entry + 1, prog_data_size);
+   stage_prog_data->param = saved.param;
+   stage_prog_data->pull_param = saved.pull_param;
+   stage_prog_data->image_param = saved.image_param;
+
+   if (entry->nr_params > saved.nr_params) {
+      stage_prog_data->param =
+         reralloc(NULL, stage_prog_data->param,
+                  const union gl_constant_value *, entry->nr_params);
+   }
+   if (entry->nr_pull_params > saved.nr_params) {
+      stage_prog_data->pull_param =
+         reralloc(NULL, stage_prog_data->pull_param,
+                  const union gl_constant_value *, entry->nr_pull_params);
+   }
+
+   indices = (const uint32_t *) ((const uint8_t *) (entry + 1) +
+                                 prog_data_size);
+   for (unsigned i = 0; i < entry->nr_params; i++) {
+      stage_prog_data->param[i] =
+         indices[i] == NO_PARAM ? NULL : item->params[indices[i]];
+   }
+   indices += entry->nr_params;
+   for (unsigned i = 0; i < entry->nr_pull_params; i++) {
+      stage_prog_data->pull_param[i] =
+         indices[i] == NO_PARAM ? NULL : item->params[indices[i]];
+   }
+   indices += entry->nr_pull_params;
+
+   void *program = ralloc_size(mem_ctx, entry->kernel_size);
+   memcpy(program, indices, entry->kernel_size);
+   *program_size = entry->kernel_size;
+
+   free((void *) entry);
+
+   return program;
+}
+
+static bool
+encode_params(struct hash_table *index, uint32_t *out,
+              const union gl_constant_value **params, unsigned count)
+{
+   for (unsigned i = 0; i < count; i++) {
+      struct hash_entry *entry;
+
+      if (!params[i]) {
+         out[i] = NO_PARAM;
+         continue;
+      }
+
+      entry = _mesa_hash_table_search(index, params[i]);
+      if (!entry)
+         return false;
+
+      out[i] = (uintptr_t) entry->data;
+   }
+
+   return true;
+}
+
+/**
+ * Store the result of a compile that missed in brw_disk_cache_search().
+ *
+ * Programs referencing uniform storage that wasn't set up before the
+ * compile (e.g. the padding the Gen4-5 VS adds) are not stored.
+ */
+void
+brw_disk_cache_store(struct brw_context *brw,
+                     const struct brw_disk_cache_item *item,
+                     const void *program, unsigned program_size,
+                     const void *prog_data, size_t prog_data_size)
+{
+   const struct brw_stage_prog_data *stage_prog_data = prog_data;
+   struct brw_disk_cache_entry *entry;
+   struct hash_table *index;
+   uint32_t *indices;
+   size_t size;
+
+   if (!item->enabled)
+      return;
+
+   index = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                   _mesa_key_pointer_equal);
+   if (!index)
+      return;
+
+   for (unsigned i = 0; i < item->nr_params; i++) {
+      if (item->params[i])
+         _mesa_hash_table_insert(index, item->params[i], (void *)(uintptr_t) i);
+   }
+
+   size = sizeof(*entry) + prog_data_size +
+          (size_t) (stage_prog_data->nr_params +
+                    stage_prog_data->nr_pull_params) * sizeof(uint32_t) +
+          program_size;
+   entry = malloc(size);
+   if (!entry)
+      goto out;
+
+   entry->prog_data_size = prog_data_size;
+   entry->kernel_size = program_size;
+   entry->nr_params = stage_prog_data->nr_params;
+   entry->nr_pull_params = stage_prog_data->nr_pull_params;
+   memcpy(entry + 1, prog_data, prog_data_size);
+
+   indices = (uint32_t *) ((uint8_t *) (entry + 1) + prog_data_size);
+   if (!encode_params(index, indices, stage_prog_data->param,
+                      entry->nr_params) ||
+       !encode_params(index, indices + entry->nr_params,
+                      stage_prog_data->pull_param, entry->nr_pull_params))
+      goto out;
+
+   memcpy(indices + entry->nr_params + entry->nr_pull_params, program,
+          program_size);
+
+   disk_cache_put(brw->intelScreen->disk_cache, item->key, entry, size);
+
+out:
+   free(entry);
+   _mesa_hash_table_destroy(index, NULL);
+}
+
+static bool
+observed_keys_enabled(struct brw_context *brw,
+                      const struct gl_shader_program *prog)
+{
+   return brw->precompile_observed_keys && brw->intelScreen->disk_cache &&
+          prog;
+}
+
+/**
+ * Remember a program key that was needed at draw time, so that the next
+ * link of the same program can precompile it.
+ *
+ * This is called when a program is compiled at draw time, which means the
+ * key guessed at link time didn't match.  The list of keys of a program is
+ * stored in the disk cache next to the kernels, with program_string_id
+ * cleared.  The oldest key is dropped once it is full.
+ */
+void
+brw_disk_cache_record_key(struct brw_context *brw,
+                          struct gl_shader_program *prog,
+                          enum brw_cache_id cache_id,
+                          const void *key, size_t key_size,
+                          const unsigned *program_string_id)
+{
+   struct disk_cache *cache = brw->intelScreen->disk_cache;
+   const size_t id_offset =
+      (const uint8_t *) program_string_id - (const uint8_t *) key;
+   uint8_t keys[(BRW_MAX_OBSERVED_KEYS + 1) * key_size];
+   uint8_t *new_key = keys;
+   unsigned num_keys = 0;
+   cache_key name;
+   size_t size;
+
+   if (!observed_keys_enabled(brw, prog) ||
+       !compute_observed_keys_name(name, prog, cache_id))
+      return;
+
+   memcpy(new_key, key, key_size);
+   memset(new_key + id_offset, 0, sizeof(*program_string_id));
+
+   /* The new key goes first, followed by the ones already known. */
+   uint8_t *old_keys = disk_cache_get(cache, name, &size);
+   if (old_keys) {
+      if (size % key_size == 0 && size / key_size <= BRW_MAX_OBSERVED_KEYS) {
+         for (unsigned i = 0; i < size / key_size; i++) {
+            if (memcmp(old_keys + i * key_size, new_key, key_size) == 0) {
+               free(old_keys);
+               return;
+            }
+         }
+
+         num_keys = MIN2(size / key_size, BRW_MAX_OBSERVED_KEYS - 1);
+         memcpy(keys + key_size, old_keys, num_keys * key_size);
+      }
+      free(old_keys);
+   }
+   num_keys++;
+
+   disk_cache_put(cache, name, keys, num_keys * key_size);
+}
+
+/**
+ * Get the keys recorded by brw_disk_cache_record_key() for \p prog.
+ *
+ * \p keys must have room for BRW_MAX_OBSERVED_KEYS keys.  The caller has to
+ * fill in program_string_id.
+ *
+ * \return The number of keys written to \p keys.
+ */
+unsigned
+brw_disk_cache_get_observed_keys(struct brw_context *brw,
+                                 struct gl_shader_program *prog,
+                                 enum brw_cache_id cache_id,
+                                 void *keys, size_t key_size)
+{
+   cache_key name;
+   unsigned num_keys = 0;
+   size_t size;
+   void *data;
+
+   if (!observed_keys_enabled(brw, prog) ||
+       !compute_observed_keys_name(name, prog, cache_id))
+      return 0;
+
+   data = disk_cache_get(brw->intelScreen->disk_cache, name, &size);
+   if (!data)
+      return 0;
+
+   if (size % key_size == 0 && size / key_size <= BRW_MAX_OBSERVED_KEYS) {
+      num_keys = size / key_size;
+      memcpy(keys, data, size);
+   }
+
+   free(data);
+   return num_keys;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BRW_DISK_CACHE_H
+#define BRW_DISK_CACHE_H
+
+#include "brw_context.h"
+#include "util/disk_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * State carried from brw_disk_cache_search() to brw_disk_cache_store() for
+ * one compile.
+ */
+struct brw_disk_cache_item {
+   /** Whether the program can be stored at all. */
+   bool enabled;
+
+   /** Name of the entry: program source, program key and stage. */
+   cache_key key;
+
+   /**
+    * The uniform references set up before compiling.  The compiler only
+    * reorders these into param and pull_param, so the entry stores indices
+    * into this array rather than the pointers themselves.
+    */
+   const union gl_constant_value **params;
+   unsigned nr_params;
+};
+
+/**
+ * Maximum number of program keys remembered per program and stage by
+ * brw_disk_cache_record_key().
+ */
+#define BRW_MAX_OBSERVED_KEYS 4
+
+void
+brw_disk_cache_init(struct intel_screen *screen);
+
+void
+brw_disk_cache_destroy(struct intel_screen *screen);
+
+void
+brw_disk_cache_compute_program_sha1(struct gl_context *ctx,
+                                    struct gl_shader_program *prog);
+
+const unsigned *
+brw_disk_cache_search(struct brw_context *brw,
+                      struct brw_disk_cache_item *item,
+                      struct gl_shader_program *prog,
+                      enum brw_cache_id cache_id,
+                      const void *key, size_t key_size,
+                      const unsigned *program_string_id,
+                      void *prog_data, size_t prog_data_size,
+                      void *mem_ctx, unsigned *program_size);
+
+void
+brw_disk_cache_store(struct brw_context *brw,
+                     const struct brw_disk_cache_item *item,
+                     const void *program, unsigned program_size,
+                     const void *prog_data, size_t prog_data_size);
+
+void
+brw_disk_cache_record_key(struct brw_context *brw,
+                          struct gl_shader_program *prog,
+                          enum brw_cache_id cache_id,
+                          const void *key, size_t key_size,
+                          const unsigned *program_string_id);
+
+unsigned
+brw_disk_cache_get_observed_keys(struct brw_context *brw,
+                                 struct gl_shader_program *prog,
+                                 enum brw_cache_id cache_id,
+                                 void *keys, size_t key_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BRW_DISK_CACHE_H */
@@ -39,6 +39,7 @@
 #include "brw_program.h"
 #include "brw_dead_control_flow.h"
 #include "compiler/glsl_types.h"
+#include "util/u_queue.h"
 
 using namespace brw;
 
@@ -2130,6 +2131,9 @@ fs_visitor::assign_constant_locations()
          stage_prog_data->param[push_constant_loc[i]] = value;
       }
    }
+
+   if (constants_assigned)
+      constants_assigned(constants_assigned_data);
 }
 
 /**
@@ -5786,6 +5790,78 @@ computed_depth_mode(const nir_shader *shader)
    return BRW_PSCDEPTH_OFF;
 }
 
+namespace {
+
+/**
+ * A SIMD16 fragment shader compile running on brw_compiler::compile_queue
+ * while the calling thread does the SIMD8 one.  The SIMD16 visitor has its
+ * own ralloc context and copy of the prog_data, so that the two threads
+ * don't allocate from or write to the same objects.
+ */
+struct simd16_compile_job {
+   struct util_queue_fence fence;
+   struct util_queue *queue;
+
+   fs_visitor *v8;
+   fs_visitor *v16;
+
+   const struct brw_wm_prog_data *prog_data;
+   struct brw_wm_prog_data *simd16_prog_data;
+
+   bool queued;
+   bool success;
+};
+
+void
+run_simd16_compile(void *data, int thread_index)
+{
+   simd16_compile_job *job = (simd16_compile_job *) data;
+
+   job->success = job->v16->run_fs(false /* do_rep_send */);
+}
+
+/**
+ * Starts the SIMD16 compile as soon as the SIMD8 one has laid out the
+ * uniforms.  Called from the SIMD8 optimize().
+ */
+void
+queue_simd16_compile(void *data)
+{
+   simd16_compile_job *job = (simd16_compile_job *) data;
+
+   if (job->v8->simd16_unsupported)
+      return;
+
+   job->v16->import_uniforms(job->v8);
+   *job->simd16_prog_data = *job->prog_data;
+
+   util_queue_add_job(job->queue, job, &job->fence, run_simd16_compile);
+   job->queued = true;
+}
+
+/**
+ * Copies what the SIMD16 compile wrote to its prog_data back.  Everything
+ * else is set up identically by both compiles.
+ */
+void
+merge_simd16_prog_data(struct brw_wm_prog_data *prog_data,
+                       const struct brw_wm_prog_data *simd16_prog_data)
+{
+   prog_data->dispatch_grf_start_reg_16 =
+      simd16_prog_data->dispatch_grf_start_reg_16;
+   prog_data->reg_blocks_16 = simd16_prog_data->reg_blocks_16;
+   prog_data->pulls_bary |= simd16_prog_data->pulls_bary;
+   prog_data->dual_src_blend |= simd16_prog_data->dual_src_blend;
+
+   prog_data->base.total_scratch = MAX2(prog_data->base.total_scratch,
+                                        simd16_prog_data->base.total_scratch);
+   prog_data->base.binding_table.size_bytes =
+      MAX2(prog_data->base.binding_table.size_bytes,
+           simd16_prog_data->base.binding_table.size_bytes);
+}
+
+} /* anonymous namespace */
+
 const unsigned *
 brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
                void *mem_ctx,
@@ -5823,10 +5899,50 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
                                            key->persample_shading,
                                            shader);
 
+   /* The SIMD16 compile only depends on the uniform layout chosen by the
+    * SIMD8 one, so with a compile queue it runs on another thread as soon as
+    * that is known.  The replicated clear shader changes the uniform setup
+    * itself and is tiny anyway, so it always runs afterwards.
+    */
+   const bool try_simd16 = likely(!(INTEL_DEBUG & DEBUG_NO16) || use_rep_send);
+   const bool parallel =
+      try_simd16 && !use_rep_send && compiler->compile_queue != NULL;
+   void *simd16_mem_ctx = parallel ? ralloc_context(NULL) : mem_ctx;
+   struct brw_wm_prog_data simd16_prog_data;
+
    fs_visitor v(compiler, log_data, mem_ctx, key,
                 &prog_data->base, prog, shader, 8,
                 shader_time_index8);
-   if (!v.run_fs(false /* do_rep_send */)) {
+   fs_visitor v2(compiler, log_data, simd16_mem_ctx, key,
+                 parallel ? &simd16_prog_data.base : &prog_data->base,
+                 prog, shader, 16, shader_time_index16);
+
+   simd16_compile_job job;
+   job.queued = false;
+   job.success = false;
+
+   if (parallel) {
+      util_queue_fence_init(&job.fence);
+      job.queue = compiler->compile_queue;
+      job.v8 = &v;
+      job.v16 = &v2;
+      job.prog_data = prog_data;
+      job.simd16_prog_data = &simd16_prog_data;
+
+      v.constants_assigned = queue_simd16_compile;
+      v.constants_assigned_data = &job;
+   }
+
+   bool simd8_success = v.run_fs(false /* do_rep_send */);
+
+   if (parallel) {
+      if (job.queued)
+         util_queue_job_wait(&job.fence);
+      util_queue_fence_destroy(&job.fence);
+      ralloc_steal(mem_ctx, simd16_mem_ctx);
+   }
+
+   if (!simd8_success) {
       if (error_str)
          *error_str = ralloc_strdup(mem_ctx, v.fail_msg);
 
@@ -5834,11 +5950,21 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
    }
 
    cfg_t *simd16_cfg = NULL;
-   fs_visitor v2(compiler, log_data, mem_ctx, key,
-                 &prog_data->base, prog, shader, 16,
-                 shader_time_index16);
-   if (likely(!(INTEL_DEBUG & DEBUG_NO16) || use_rep_send)) {
-      if (!v.simd16_unsupported) {
+   if (parallel) {
+      if (job.queued && !v.simd16_unsupported) {
+         if (!job.success) {
+            compiler->shader_perf_log(log_data,
+                                      "SIMD16 shader failed to compile: %s",
+                                      v2.fail_msg);
+         } else {
+            merge_simd16_prog_data(prog_data, &simd16_prog_data);
+            simd16_cfg = v2.cfg;
+         }
+      }
+   } else if (try_simd16) {
+      /* SIMD16 can't spill, so don't bother if SIMD8 had to. */
+      if (!v.simd16_unsupported &&
+          (!v.spilled_any_registers || use_rep_send)) {
          /* Try a SIMD16 compile */
          v2.import_uniforms(&v);
          if (!v2.run_fs(use_rep_send)) {
@@ -129,6 +129,7 @@ public:
    void assign_tes_urb_setup();
    void assign_gs_urb_setup();
    bool assign_regs(bool allow_spilling);
+   void setup_vgrf_interference(struct ra_graph *g);
    void assign_regs_trivial();
    void calculate_payload_ranges(int payload_node_count,
                                  int *payload_last_use_ip);
@@ -375,6 +376,14 @@ public:
    bool simd16_unsupported;
    char *no16_msg;
 
+   /**
+    * Called by assign_constant_locations() once the uniform layout has been
+    * decided, which is all a compile of another width needs from this one
+    * to get started, see import_uniforms().
+    */
+   void (*constants_assigned)(void *data);
+   void *constants_assigned_data;
+
    /* Result of last visit() method. Still used by emit_texture() */
    fs_reg result;
 
@@ -408,6 +417,7 @@ public:
 
    unsigned grf_used;
    bool spilled_any_registers;
+   unsigned spilled_reg_count;
 
    const unsigned dispatch_width; /**< 8 or 16 */
    unsigned min_dispatch_width;
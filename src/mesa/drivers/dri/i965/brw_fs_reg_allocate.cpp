@@ -32,6 +32,15 @@
 
 using namespace brw;
 
+/**
+ * Number of registers spilled for each failed allocation, once
+ * spilled_reg_count registers have been spilled already.  Every retry
+ * recomputes liveness and the interference graph, so shaders spilling a
+ * lot spill in batches growing with the spill count, at the price of
+ * spilling up to 1/SPILL_BATCH_DIVISOR more than needed.
+ */
+#define SPILL_BATCH_DIVISOR 8
+
 static void
 assign_reg(unsigned *reg_hw_locations, fs_reg *reg)
 {
@@ -541,6 +550,72 @@ setup_mrf_hack_interference(fs_visitor *v, struct ra_graph *g,
    }
 }
 
+struct vgrf_interval {
+   int start;
+   unsigned vgrf;
+};
+
+static int
+compare_vgrf_intervals(const void *a, const void *b)
+{
+   const vgrf_interval *ia = (const vgrf_interval *) a;
+   const vgrf_interval *ib = (const vgrf_interval *) b;
+
+   if (ia->start != ib->start)
+      return ia->start < ib->start ? -1 : 1;
+
+   return ia->vgrf < ib->vgrf ? -1 : ia->vgrf > ib->vgrf;
+}
+
+/**
+ * Adds the interference between the VGRFs, from the live intervals.
+ *
+ * Rather than testing all the pairs, walk the VGRFs by start of their
+ * interval, keeping the ones still live at that point.  This is linear in
+ * the number of interferences, which matters on big shaders as the graph
+ * is rebuilt after every spill.
+ */
+void
+fs_visitor::setup_vgrf_interference(struct ra_graph *g)
+{
+   const unsigned count = this->alloc.count;
+   vgrf_interval *intervals = ralloc_array(NULL, vgrf_interval, count);
+   unsigned *active = ralloc_array(intervals, unsigned, count);
+   unsigned active_count = 0;
+
+   for (unsigned i = 0; i < count; i++) {
+      intervals[i].start = virtual_grf_start[i];
+      intervals[i].vgrf = i;
+   }
+
+   qsort(intervals, count, sizeof(*intervals), compare_vgrf_intervals);
+
+   for (unsigned i = 0; i < count; i++) {
+      const unsigned n = intervals[i].vgrf;
+      unsigned kept = 0;
+
+      /* Drop the VGRFs which are dead by the start of n.  Whatever is left
+       * started no later than n and is still live when n starts.
+       */
+      for (unsigned j = 0; j < active_count; j++) {
+         const unsigned n2 = active[j];
+
+         if (virtual_grf_end[n2] <= virtual_grf_start[n])
+            continue;
+
+         active[kept++] = n2;
+
+         if (virtual_grf_interferes(n, n2))
+            ra_add_node_interference(g, n, n2);
+      }
+
+      active_count = kept;
+      active[active_count++] = n;
+   }
+
+   ralloc_free(intervals);
+}
+
 bool
 fs_visitor::assign_regs(bool allow_spilling)
 {
@@ -589,14 +664,10 @@ fs_visitor::assign_regs(bool allow_spilling)
       }
 
       ra_set_node_class(g, i, c);
-
-      for (unsigned j = 0; j < i; j++) {
-	 if (virtual_grf_interferes(i, j)) {
-	    ra_add_node_interference(g, i, j);
-	 }
-      }
    }
 
+   setup_vgrf_interference(g);
+
    /* Certain instructions can't safely use the same register for their
     * sources and destination.  Add interference.
     */
@@ -667,6 +738,25 @@ fs_visitor::assign_regs(bool allow_spilling)
       }
    }
 
+   /* Ask the allocator to give the copies register_coalesce() couldn't get
+    * rid of the same register on both sides, they're removed below.
+    */
+   foreach_block_and_inst(block, fs_inst, inst, cfg) {
+      if (inst->opcode == BRW_OPCODE_MOV &&
+          !inst->is_partial_write() &&
+          !inst->saturate &&
+          inst->conditional_mod == BRW_CONDITIONAL_NONE &&
+          inst->dst.file == VGRF &&
+          inst->src[0].file == VGRF &&
+          !inst->src[0].negate &&
+          !inst->src[0].abs &&
+          inst->dst.type == inst->src[0].type &&
+          inst->dst.reg_offset == inst->src[0].reg_offset &&
+          alloc.sizes[inst->dst.nr] == alloc.sizes[inst->src[0].nr]) {
+         ra_add_node_move(g, inst->dst.nr, inst->src[0].nr);
+      }
+   }
+
    /* Debug of register spilling: Go spill everything. */
    if (unlikely(INTEL_DEBUG & DEBUG_SPILL_FS)) {
       int reg = choose_spill_reg(g);
@@ -679,8 +769,8 @@ fs_visitor::assign_regs(bool allow_spilling)
    }
 
    if (!ra_allocate(g)) {
-      /* Failed to allocate registers.  Spill a reg, and the caller will
-       * loop back into here to try again.
+      /* Failed to allocate registers.  Spill some regs, and the caller
+       * will loop back into here to try again.
        */
       int reg = choose_spill_reg(g);
 
@@ -688,7 +778,19 @@ fs_visitor::assign_regs(bool allow_spilling)
          fail("no register to spill:\n");
          dump_instructions(NULL);
       } else if (allow_spilling) {
-         spill_reg(reg);
+         const unsigned batch_size =
+            1 + spilled_reg_count / SPILL_BATCH_DIVISOR;
+
+         /* The spill costs set up by choose_spill_reg() are still valid
+          * for the nodes of this graph, spill_reg() only adds new VGRFs.
+          */
+         for (unsigned i = 0; i < batch_size && reg != -1 && !failed; i++) {
+            spill_reg(reg);
+            spilled_reg_count++;
+
+            ra_set_node_spill_cost(g, reg, 0.0f);
+            reg = ra_get_best_spill_node(g);
+         }
       }
 
       ralloc_free(g);
@@ -709,13 +811,28 @@ fs_visitor::assign_regs(bool allow_spilling)
 			    hw_reg_mapping[i] + this->alloc.sizes[i]);
    }
 
-   foreach_block_and_inst(block, fs_inst, inst, cfg) {
+   bool removed_moves = false;
+
+   foreach_block_and_inst_safe(block, fs_inst, inst, cfg) {
       assign_reg(hw_reg_mapping, &inst->dst);
       for (int i = 0; i < inst->sources; i++) {
          assign_reg(hw_reg_mapping, &inst->src[i]);
       }
+
+      /* Drop the copies which ended up coalesced. */
+      if (inst->opcode == BRW_OPCODE_MOV &&
+          !inst->saturate &&
+          inst->conditional_mod == BRW_CONDITIONAL_NONE &&
+          inst->dst.file == VGRF &&
+          inst->dst.equals(inst->src[0])) {
+         inst->remove(block);
+         removed_moves = true;
+      }
    }
 
+   if (removed_moves)
+      invalidate_live_intervals();
+
    this->alloc.count = this->grf_used;
 
    ralloc_free(g);
@@ -1045,6 +1045,8 @@ fs_visitor::init()
    this->failed = false;
    this->simd16_unsupported = false;
    this->no16_msg = NULL;
+   this->constants_assigned = NULL;
+   this->constants_assigned_data = NULL;
 
    this->nir_locals = NULL;
    this->nir_ssa_values = NULL;
@@ -1069,6 +1071,7 @@ fs_visitor::init()
    this->promoted_constants = 0,
 
    this->spilled_any_registers = false;
+   this->spilled_reg_count = 0;
    this->do_dual_src = false;
 }
 
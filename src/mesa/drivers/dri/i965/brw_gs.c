@@ -34,6 +34,7 @@
 #include "brw_ff_gs.h"
 #include "brw_nir.h"
 #include "brw_program.h"
+#include "brw_disk_cache.h"
 #include "compiler/glsl/ir_uniform.h"
 
 static void
@@ -157,10 +158,21 @@ brw_codegen_gs_prog(struct brw_context *brw,
    void *mem_ctx = ralloc_context(NULL);
    unsigned program_size;
    char *error_str;
+   struct brw_disk_cache_item cache_item;
    const unsigned *program =
-      brw_compile_gs(brw->intelScreen->compiler, brw, mem_ctx, key,
-                     &prog_data, shader->Program->nir, prog,
-                     st_index, &program_size, &error_str);
+      brw_disk_cache_search(brw, &cache_item, prog, BRW_CACHE_GS_PROG,
+                            key, sizeof(*key), &key->program_string_id,
+                            &prog_data, sizeof(prog_data), mem_ctx,
+                            &program_size);
+   if (program == NULL) {
+      program = brw_compile_gs(brw->intelScreen->compiler, brw, mem_ctx, key,
+                               &prog_data, shader->Program->nir, prog,
+                               st_index, &program_size, &error_str);
+      if (program) {
+         brw_disk_cache_store(brw, &cache_item, program, program_size,
+                              &prog_data, sizeof(prog_data));
+      }
+   }
    if (program == NULL) {
       ralloc_free(mem_ctx);
       return false;
@@ -258,6 +270,9 @@ brw_upload_gs_prog(struct brw_context *brw)
    if (!brw_search_cache(&brw->cache, BRW_CACHE_GS_PROG,
                          &key, sizeof(key),
                          &stage_state->prog_offset, &brw->gs.prog_data)) {
+      brw_disk_cache_record_key(brw, current[MESA_SHADER_GEOMETRY],
+                                BRW_CACHE_GS_PROG, &key, sizeof(key),
+                                &key.program_string_id);
       bool success = brw_codegen_gs_prog(brw, current[MESA_SHADER_GEOMETRY],
                                          gp, &key);
       assert(success);
@@ -287,6 +302,16 @@ brw_gs_precompile(struct gl_context *ctx,
 
    success = brw_codegen_gs_prog(brw, shader_prog, bgp, &key);
 
+   struct brw_gs_prog_key observed[BRW_MAX_OBSERVED_KEYS];
+   unsigned num_observed =
+      brw_disk_cache_get_observed_keys(brw, shader_prog, BRW_CACHE_GS_PROG,
+                                       observed, sizeof(key));
+   for (unsigned i = 0; success && i < num_observed; i++) {
+      observed[i].program_string_id = bgp->id;
+      if (memcmp(&observed[i], &key, sizeof(key)) != 0)
+         success = brw_codegen_gs_prog(brw, shader_prog, bgp, &observed[i]);
+   }
+
    brw->gs.base.prog_offset = old_prog_offset;
    brw->gs.prog_data = old_prog_data;
 
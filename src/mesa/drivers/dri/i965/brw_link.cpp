@@ -22,6 +22,7 @@
  */
 
 #include "brw_context.h"
+#include "brw_disk_cache.h"
 #include "brw_shader.h"
 #include "brw_fs.h"
 #include "brw_nir.h"
@@ -188,6 +189,9 @@ brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
    const struct brw_compiler *compiler = brw->intelScreen->compiler;
    unsigned int stage;
 
+   if (brw->intelScreen->disk_cache)
+      brw_disk_cache_compute_program_sha1(ctx, shProg);
+
    for (stage = 0; stage < ARRAY_SIZE(shProg->_LinkedShaders); stage++) {
       struct gl_shader *shader = shProg->_LinkedShaders[stage];
       if (!shader)
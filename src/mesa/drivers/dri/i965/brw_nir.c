@@ -383,10 +383,16 @@ brw_nir_lower_cs_shared(nir_shader *nir)
 
 #define OPT_V(pass, ...) NIR_PASS_V(nir, pass, ##__VA_ARGS__)
 
+#define OPT_LOOP(pass, ...) \
+   NIR_LOOP_PASS(progress, &tracker, nir, pass, ##__VA_ARGS__)
+
 static nir_shader *
 nir_optimize(nir_shader *nir, bool is_scalar)
 {
+   nir_pass_tracker tracker;
    bool progress;
+
+   nir_pass_tracker_init(&tracker);
    do {
       progress = false;
       OPT_V(nir_lower_vars_to_ssa);
@@ -395,21 +401,21 @@ nir_optimize(nir_shader *nir, bool is_scalar)
          OPT_V(nir_lower_alu_to_scalar);
       }
 
-      OPT(nir_copy_prop);
+      OPT_LOOP(nir_copy_prop);
 
       if (is_scalar) {
          OPT_V(nir_lower_phis_to_scalar);
       }
 
-      OPT(nir_copy_prop);
-      OPT(nir_opt_dce);
-      OPT(nir_opt_cse);
-      OPT(nir_opt_peephole_select);
-      OPT(nir_opt_algebraic);
-      OPT(nir_opt_constant_folding);
-      OPT(nir_opt_dead_cf);
-      OPT(nir_opt_remove_phis);
-      OPT(nir_opt_undef);
+      OPT_LOOP(nir_copy_prop);
+      OPT_LOOP(nir_opt_dce);
+      OPT_LOOP(nir_opt_cse);
+      OPT_LOOP(nir_opt_peephole_select);
+      OPT_LOOP(nir_opt_algebraic);
+      OPT_LOOP(nir_opt_constant_folding);
+      OPT_LOOP(nir_opt_dead_cf);
+      OPT_LOOP(nir_opt_remove_phis);
+      OPT_LOOP(nir_opt_undef);
    } while (progress);
 
    return nir;
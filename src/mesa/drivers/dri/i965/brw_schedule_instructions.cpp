@@ -75,6 +75,12 @@ public:
    int unblocked_time;
    int latency;
 
+   /**
+    * Whether the node is ordered against all the other nodes of the block,
+    * see add_barrier_deps().
+    */
+   bool is_barrier;
+
    /**
     * Which iteration of pushing groups of children onto the candidates list
     * this node was a part of.
@@ -539,6 +545,7 @@ public:
                             int block_count,
                             instruction_scheduler_mode mode);
    void calculate_deps();
+   void clear_last_grf_write();
    bool is_compressed(fs_inst *inst);
    schedule_node *choose_instruction_to_schedule();
    int issue_time(backend_instruction *inst);
@@ -548,6 +555,13 @@ public:
    void setup_liveness(cfg_t *cfg);
    void update_register_pressure(backend_instruction *inst);
    int get_register_pressure_benefit(backend_instruction *inst);
+
+   /**
+    * The last write per VGRF offset before register allocation, or per GRF
+    * after it.  Sized for the whole program, but only the entries written by
+    * the block being scheduled are ever set.
+    */
+   schedule_node **last_grf_write;
 };
 
 fs_instruction_scheduler::fs_instruction_scheduler(fs_visitor *v,
@@ -557,6 +571,7 @@ fs_instruction_scheduler::fs_instruction_scheduler(fs_visitor *v,
    : instruction_scheduler(v, grf_count, hw_reg_count, block_count, mode),
      v(v)
 {
+   last_grf_write = rzalloc_array(mem_ctx, schedule_node *, grf_count * 16);
 }
 
 static bool
@@ -768,6 +783,7 @@ schedule_node::schedule_node(backend_instruction *inst,
    this->unblocked_time = 0;
    this->cand_generation = 0;
    this->delay = 0;
+   this->is_barrier = false;
 
    /* We can't measure Gen6 timings directly but expect them to be much
     * closer to Gen7 than Gen4.
@@ -822,7 +838,11 @@ instruction_scheduler::add_dep(schedule_node *before, schedule_node *after,
 
    assert(before != after);
 
-   for (int i = 0; i < before->child_count; i++) {
+   /* Repeated deps between the same pair of nodes (e.g. for each register
+    * of a multi-register read) are usually on the child added last, so look
+    * from the end.
+    */
+   for (int i = before->child_count - 1; i >= 0; i--) {
       if (before->children[i] == after) {
          before->child_latency[i] = MAX2(before->child_latency[i], latency);
          return;
@@ -861,6 +881,12 @@ instruction_scheduler::add_dep(schedule_node *before, schedule_node *after)
  * Sometimes we really want this node to execute after everything that
  * was before it and before everything that followed it.  This adds
  * the deps to do so.
+ *
+ * The deps only need to reach as far as the closest barrier on either
+ * side, which is itself ordered against everything beyond it.  That keeps
+ * blocks with many barriers from growing a quadratic number of edges.
+ * Barriers are marked up front by calculate_deps(), so that the ones
+ * further down the block are known as well.
  */
 void
 instruction_scheduler::add_barrier_deps(schedule_node *n)
@@ -868,9 +894,13 @@ instruction_scheduler::add_barrier_deps(schedule_node *n)
    schedule_node *prev = (schedule_node *)n->prev;
    schedule_node *next = (schedule_node *)n->next;
 
+   n->is_barrier = true;
+
    if (prev) {
       while (!prev->is_head_sentinel()) {
          add_dep(prev, n, 0);
+         if (prev->is_barrier)
+            break;
          prev = (schedule_node *)prev->prev;
       }
    }
@@ -878,6 +908,8 @@ instruction_scheduler::add_barrier_deps(schedule_node *n)
    if (next) {
       while (!next->is_tail_sentinel()) {
          add_dep(n, next, 0);
+         if (next->is_barrier)
+            break;
          next = (schedule_node *)next->next;
       }
    }
@@ -901,14 +933,36 @@ is_scheduling_barrier(const fs_inst *inst)
           (inst->has_side_effects() && inst->opcode != FS_OPCODE_FB_WRITE);
 }
 
+/**
+ * Resets the last_grf_write entries set for the current block.
+ *
+ * With thousands of VGRFs, clearing the whole array for each pass over each
+ * block costs more than building the dependencies of a small block.
+ */
+void
+fs_instruction_scheduler::clear_last_grf_write()
+{
+   foreach_in_list(schedule_node, n, &instructions) {
+      fs_inst *inst = (fs_inst *)n->inst;
+
+      if (inst->dst.file == VGRF) {
+         if (post_reg_alloc) {
+            for (int r = 0; r < inst->regs_written; r++)
+               last_grf_write[inst->dst.nr + r] = NULL;
+         } else {
+            for (int r = 0; r < inst->regs_written; r++)
+               last_grf_write[inst->dst.nr * 16 + inst->dst.reg_offset + r] = NULL;
+         }
+      } else if (inst->dst.file == FIXED_GRF && post_reg_alloc) {
+         for (int r = 0; r < inst->regs_written; r++)
+            last_grf_write[inst->dst.nr + r] = NULL;
+      }
+   }
+}
+
 void
 fs_instruction_scheduler::calculate_deps()
 {
-   /* Pre-register-allocation, this tracks the last write per VGRF offset.
-    * After register allocation, reg_offsets are gone and we track individual
-    * GRF registers.
-    */
-   schedule_node *last_grf_write[grf_count * 16];
    schedule_node *last_mrf_write[BRW_MAX_MRF(v->devinfo->gen)];
    schedule_node *last_conditional_mod[2] = { NULL, NULL };
    schedule_node *last_accumulator_write = NULL;
@@ -919,14 +973,16 @@ fs_instruction_scheduler::calculate_deps()
     */
    schedule_node *last_fixed_grf_write = NULL;
 
-   memset(last_grf_write, 0, sizeof(last_grf_write));
    memset(last_mrf_write, 0, sizeof(last_mrf_write));
 
+   foreach_in_list(schedule_node, n, &instructions)
+      n->is_barrier = is_scheduling_barrier((fs_inst *)n->inst);
+
    /* top-to-bottom dependencies: RAW and WAW. */
    foreach_in_list(schedule_node, n, &instructions) {
       fs_inst *inst = (fs_inst *)n->inst;
 
-      if (is_scheduling_barrier(inst))
+      if (n->is_barrier)
          add_barrier_deps(n);
 
       /* read-after-write deps. */
@@ -1032,7 +1088,7 @@ fs_instruction_scheduler::calculate_deps()
    }
 
    /* bottom-to-top dependencies: WAR */
-   memset(last_grf_write, 0, sizeof(last_grf_write));
+   clear_last_grf_write();
    memset(last_mrf_write, 0, sizeof(last_mrf_write));
    memset(last_conditional_mod, 0, sizeof(last_conditional_mod));
    last_accumulator_write = NULL;
@@ -1136,6 +1192,8 @@ fs_instruction_scheduler::calculate_deps()
          last_accumulator_write = n;
       }
    }
+
+   clear_last_grf_write();
 }
 
 static bool
@@ -1162,11 +1220,14 @@ vec4_instruction_scheduler::calculate_deps()
    memset(last_grf_write, 0, sizeof(last_grf_write));
    memset(last_mrf_write, 0, sizeof(last_mrf_write));
 
+   foreach_in_list(schedule_node, n, &instructions)
+      n->is_barrier = is_scheduling_barrier((vec4_instruction *)n->inst);
+
    /* top-to-bottom dependencies: RAW and WAW. */
    foreach_in_list(schedule_node, n, &instructions) {
       vec4_instruction *inst = (vec4_instruction *)n->inst;
 
-      if (is_scheduling_barrier(inst))
+      if (n->is_barrier)
          add_barrier_deps(n);
 
       /* read-after-write deps. */
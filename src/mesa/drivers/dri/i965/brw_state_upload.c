@@ -459,10 +459,27 @@ brw_copy_pipeline_atoms(struct brw_context *brw,
    struct brw_tracked_state *context_atoms =
       (struct brw_tracked_state *) brw_get_pipeline_atoms(brw, pipeline);
 
+   memset(&brw->atom_masks[pipeline], 0, sizeof(brw->atom_masks[pipeline]));
+
    for (int i = 0; i < num_atoms; i++) {
       context_atoms[i] = *atoms[i];
       assert(context_atoms[i].dirty.mesa | context_atoms[i].dirty.brw);
       assert(context_atoms[i].emit);
+
+      GLuint mesa = context_atoms[i].dirty.mesa;
+      while (mesa) {
+         const int bit = ffs(mesa) - 1;
+         brw->atom_masks[pipeline].mesa[bit][i / 64] |= 1ull << (i % 64);
+         mesa &= ~(1u << bit);
+      }
+
+      uint64_t brw_bits = context_atoms[i].dirty.brw;
+      while (brw_bits) {
+         const int bit = ffsll(brw_bits) - 1;
+         assert(bit < BRW_NUM_STATE_BITS);
+         brw->atom_masks[pipeline].brw[bit][i / 64] |= 1ull << (i % 64);
+         brw_bits &= ~(1ull << bit);
+      }
    }
 
    brw->num_atoms[pipeline] = num_atoms;
@@ -485,6 +502,10 @@ void brw_init_state( struct brw_context *brw )
                  ARRAY_SIZE(brw->compute_atoms));
    STATIC_ASSERT(ARRAY_SIZE(gen8_compute_atoms) <=
                  ARRAY_SIZE(brw->compute_atoms));
+   STATIC_ASSERT(ARRAY_SIZE(brw->render_atoms) <=
+                 8 * sizeof(brw->atom_masks[0].mesa[0]));
+   STATIC_ASSERT(ARRAY_SIZE(brw->compute_atoms) <=
+                 8 * sizeof(brw->atom_masks[0].mesa[0]));
 
    brw_init_caches(brw);
 
@@ -774,6 +795,30 @@ check_and_emit_atom(struct brw_context *brw,
    }
 }
 
+/**
+ * Add the atoms which check any of the given dirty bits to \p pending.
+ */
+static inline void
+add_pending_atoms(struct brw_context *brw,
+                  enum brw_pipeline pipeline,
+                  GLuint mesa, uint64_t brw_bits,
+                  uint64_t pending[2])
+{
+   while (mesa) {
+      const int bit = ffs(mesa) - 1;
+      pending[0] |= brw->atom_masks[pipeline].mesa[bit][0];
+      pending[1] |= brw->atom_masks[pipeline].mesa[bit][1];
+      mesa &= ~(1u << bit);
+   }
+
+   while (brw_bits) {
+      const int bit = ffsll(brw_bits) - 1;
+      pending[0] |= brw->atom_masks[pipeline].brw[bit][0];
+      pending[1] |= brw->atom_masks[pipeline].brw[bit][1];
+      brw_bits &= ~(1ull << bit);
+   }
+}
+
 static inline void
 brw_upload_pipeline_state(struct brw_context *brw,
                           enum brw_pipeline pipeline)
@@ -877,10 +922,31 @@ brw_upload_pipeline_state(struct brw_context *brw,
       }
    }
    else {
-      for (i = 0; i < num_atoms; i++) {
-	 const struct brw_tracked_state *atom = &atoms[i];
+      /* Only visit the atoms which check a dirty bit, in list order.  Bits
+       * flagged by an atom's emit function only ever affect later atoms (the
+       * debug path above asserts this), so atoms before the current one are
+       * dropped from the pending set.
+       */
+      uint64_t pending[2] = { 0, 0 };
 
-         check_and_emit_atom(brw, &state, atom);
+      add_pending_atoms(brw, pipeline, state.mesa, state.brw, pending);
+
+      for (int w = 0; w < 2; w++) {
+         while (pending[w]) {
+            const int bit = ffsll(pending[w]) - 1;
+            const struct brw_tracked_state *atom = &atoms[w * 64 + bit];
+            const struct brw_state_flags prev = state;
+
+            assert(w * 64 + bit < num_atoms);
+
+            atom->emit(brw);
+            merge_ctx_state(brw, &state);
+
+            add_pending_atoms(brw, pipeline,
+                              state.mesa & ~prev.mesa,
+                              state.brw & ~prev.brw, pending);
+            pending[w] &= bit == 63 ? 0 : ~0ull << (bit + 1);
+         }
       }
    }
 
@@ -40,6 +40,7 @@
 #include "program/prog_parameter.h"
 #include "brw_nir.h"
 #include "brw_program.h"
+#include "brw_disk_cache.h"
 
 #include "util/ralloc.h"
 
@@ -177,11 +178,22 @@ brw_codegen_vs_prog(struct brw_context *brw,
    /* Emit GEN4 code.
     */
    char *error_str;
-   program = brw_compile_vs(compiler, brw, mem_ctx, key,
-                            &prog_data, vp->program.Base.nir,
-                            brw_select_clip_planes(&brw->ctx),
-                            !_mesa_is_gles3(&brw->ctx),
-                            st_index, &program_size, &error_str);
+   struct brw_disk_cache_item cache_item;
+   program = brw_disk_cache_search(brw, &cache_item, prog, BRW_CACHE_VS_PROG,
+                                   key, sizeof(*key), &key->program_string_id,
+                                   &prog_data, sizeof(prog_data), mem_ctx,
+                                   &program_size);
+   if (program == NULL) {
+      program = brw_compile_vs(compiler, brw, mem_ctx, key,
+                               &prog_data, vp->program.Base.nir,
+                               brw_select_clip_planes(&brw->ctx),
+                               !_mesa_is_gles3(&brw->ctx),
+                               st_index, &program_size, &error_str);
+      if (program) {
+         brw_disk_cache_store(brw, &cache_item, program, program_size,
+                              &prog_data, sizeof(prog_data));
+      }
+   }
    if (program == NULL) {
       if (prog) {
          prog->LinkStatus = false;
@@ -363,6 +375,9 @@ brw_upload_vs_prog(struct brw_context *brw)
    if (!brw_search_cache(&brw->cache, BRW_CACHE_VS_PROG,
 			 &key, sizeof(key),
 			 &brw->vs.base.prog_offset, &brw->vs.prog_data)) {
+      brw_disk_cache_record_key(brw, current[MESA_SHADER_VERTEX],
+                                BRW_CACHE_VS_PROG, &key, sizeof(key),
+                                &key.program_string_id);
       bool success = brw_codegen_vs_prog(brw, current[MESA_SHADER_VERTEX],
                                          vp, &key);
       (void) success;
@@ -395,6 +410,16 @@ brw_vs_precompile(struct gl_context *ctx,
 
    success = brw_codegen_vs_prog(brw, shader_prog, bvp, &key);
 
+   struct brw_vs_prog_key observed[BRW_MAX_OBSERVED_KEYS];
+   unsigned num_observed =
+      brw_disk_cache_get_observed_keys(brw, shader_prog, BRW_CACHE_VS_PROG,
+                                       observed, sizeof(key));
+   for (unsigned i = 0; success && i < num_observed; i++) {
+      observed[i].program_string_id = bvp->id;
+      if (memcmp(&observed[i], &key, sizeof(key)) != 0)
+         success = brw_codegen_vs_prog(brw, shader_prog, bvp, &observed[i]);
+   }
+
    brw->vs.base.prog_offset = old_prog_offset;
    brw->vs.prog_data = old_prog_data;
 
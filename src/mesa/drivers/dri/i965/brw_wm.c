@@ -37,6 +37,7 @@
 #include "intel_mipmap_tree.h"
 #include "brw_nir.h"
 #include "brw_program.h"
+#include "brw_disk_cache.h"
 
 #include "util/ralloc.h"
 
@@ -134,10 +135,21 @@ brw_codegen_wm_prog(struct brw_context *brw,
    }
 
    char *error_str = NULL;
-   program = brw_compile_fs(brw->intelScreen->compiler, brw, mem_ctx,
-                            key, &prog_data, fp->program.Base.nir,
-                            &fp->program.Base, st_index8, st_index16,
-                            brw->use_rep_send, &program_size, &error_str);
+   struct brw_disk_cache_item cache_item;
+   program = brw_disk_cache_search(brw, &cache_item, prog, BRW_CACHE_FS_PROG,
+                                   key, sizeof(*key), &key->program_string_id,
+                                   &prog_data, sizeof(prog_data), mem_ctx,
+                                   &program_size);
+   if (program == NULL) {
+      program = brw_compile_fs(brw->intelScreen->compiler, brw, mem_ctx,
+                               key, &prog_data, fp->program.Base.nir,
+                               &fp->program.Base, st_index8, st_index16,
+                               brw->use_rep_send, &program_size, &error_str);
+      if (program) {
+         brw_disk_cache_store(brw, &cache_item, program, program_size,
+                              &prog_data, sizeof(prog_data));
+      }
+   }
    if (program == NULL) {
       if (prog) {
          prog->LinkStatus = false;
@@ -573,6 +585,8 @@ brw_upload_wm_prog(struct brw_context *brw)
    if (!brw_search_cache(&brw->cache, BRW_CACHE_FS_PROG,
 			 &key, sizeof(key),
 			 &brw->wm.base.prog_offset, &brw->wm.prog_data)) {
+      brw_disk_cache_record_key(brw, current, BRW_CACHE_FS_PROG,
+                                &key, sizeof(key), &key.program_string_id);
       bool success = brw_codegen_wm_prog(brw, current, fp, &key);
       (void) success;
       assert(success);
@@ -632,6 +646,16 @@ brw_fs_precompile(struct gl_context *ctx,
 
    bool success = brw_codegen_wm_prog(brw, shader_prog, bfp, &key);
 
+   struct brw_wm_prog_key observed[BRW_MAX_OBSERVED_KEYS];
+   unsigned num_observed =
+      brw_disk_cache_get_observed_keys(brw, shader_prog, BRW_CACHE_FS_PROG,
+                                       observed, sizeof(key));
+   for (unsigned i = 0; success && i < num_observed; i++) {
+      observed[i].program_string_id = bfp->id;
+      if (memcmp(&observed[i], &key, sizeof(key)) != 0)
+         success = brw_codegen_wm_prog(brw, shader_prog, bfp, &observed[i]);
+   }
+
    brw->wm.base.prog_offset = old_prog_offset;
    brw->wm.prog_data = old_prog_data;
 
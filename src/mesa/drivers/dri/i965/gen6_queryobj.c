@@ -163,6 +163,56 @@ emit_pipeline_stat(struct brw_context *brw, drm_intel_bo *bo,
 }
 
 
+/**
+ * Offset of the availability flag in the query BO, following the two 64-bit
+ * snapshots.
+ */
+#define GEN6_QUERY_AVAILABLE_OFFSET (2 * sizeof(uint64_t))
+
+/**
+ * Emit a write of the availability flag after the query's final snapshot.
+ *
+ * The CS stall makes the write wait for the preceding post-sync operations
+ * and register stores, so a set flag means the results are in memory.
+ */
+static void
+write_availability(struct brw_context *brw, drm_intel_bo *bo)
+{
+   if (brw->gen == 6) {
+      /* Emit Sandybridge workaround flush: */
+      brw_emit_pipe_control_flush(brw,
+                                  PIPE_CONTROL_CS_STALL |
+                                  PIPE_CONTROL_STALL_AT_SCOREBOARD);
+   }
+
+   brw_emit_pipe_control_write(brw,
+                               PIPE_CONTROL_WRITE_IMMEDIATE |
+                               PIPE_CONTROL_CS_STALL,
+                               bo, GEN6_QUERY_AVAILABLE_OFFSET, 1, 0);
+}
+
+/**
+ * Check the GPU-written availability flag without waiting on the BO.
+ *
+ * With an LLC, the unsynchronized map is coherent with GPU writes, so this
+ * sees the flag as soon as the end of the query has executed, even if the
+ * rest of the batch is still running.
+ */
+static bool
+query_available(struct brw_query_object *query)
+{
+   if (!query->has_availability)
+      return false;
+
+   drm_intel_gem_bo_map_unsynchronized(query->bo);
+   const volatile uint32_t *available =
+      query->bo->virtual + GEN6_QUERY_AVAILABLE_OFFSET;
+   bool ready = *available != 0;
+   drm_intel_bo_unmap(query->bo);
+
+   return ready;
+}
+
 /**
  * Wait on the query object's BO and calculate the final result.
  */
@@ -175,7 +225,13 @@ gen6_queryobj_get_results(struct gl_context *ctx,
    if (query->bo == NULL)
       return;
 
-   brw_bo_map(brw, query->bo, false, "query object");
+   /* If the GPU already flagged the results as written, there's no need to
+    * wait for the rest of the batch.
+    */
+   if (query_available(query))
+      drm_intel_gem_bo_map_unsynchronized(query->bo);
+   else
+      brw_bo_map(brw, query->bo, false, "query object");
    uint64_t *results = query->bo->virtual;
    switch (query->Base.Target) {
    case GL_TIME_ELAPSED:
@@ -282,6 +338,17 @@ gen6_begin_query(struct gl_context *ctx, struct gl_query_object *q)
    drm_intel_bo_unreference(query->bo);
    query->bo = drm_intel_bo_alloc(brw->bufmgr, "query results", 4096, 4096);
 
+   /* The availability flag is only useful if the CPU can read it while the
+    * GPU is still busy, which requires a coherent mapping.  BOs come back
+    * from the cache with stale contents, so clear it first.
+    */
+   query->has_availability = brw->has_llc;
+   if (query->has_availability) {
+      const uint32_t zero = 0;
+      drm_intel_bo_subdata(query->bo, GEN6_QUERY_AVAILABLE_OFFSET,
+                           sizeof(zero), &zero);
+   }
+
    switch (query->Base.Target) {
    case GL_TIME_ELAPSED:
       /* For timestamp queries, we record the starting time right away so that
@@ -391,6 +458,9 @@ gen6_end_query(struct gl_context *ctx, struct gl_query_object *q)
       unreachable("Unrecognized query target in brw_end_query()");
    }
 
+   if (query->has_availability)
+      write_availability(brw, query->bo);
+
    /* The current batch contains the commands to handle EndQuery(),
     * but they won't actually execute until it is flushed.
     */
@@ -459,7 +529,7 @@ static void gen6_check_query(struct gl_context *ctx, struct gl_query_object *q)
     */
    flush_batch_if_needed(brw, query);
 
-   if (!drm_intel_bo_busy(query->bo)) {
+   if (query_available(query) || !drm_intel_bo_busy(query->bo)) {
       gen6_queryobj_get_results(ctx, query);
    }
 }
@@ -51,6 +51,34 @@ intel_batchbuffer_init(struct brw_context *brw)
    }
 }
 
+/**
+ * Return the BO for a new batch.  The batch BOs are recycled in a small ring:
+ * a BO the GPU is done with is reused directly, skipping the allocation from
+ * the BO cache and, on LLC platforms, the map and its domain change.
+ */
+static drm_intel_bo *
+intel_batchbuffer_get_bo(struct brw_context *brw)
+{
+   struct intel_batchbuffer *batch = &brw->batch;
+   drm_intel_bo **bo = &batch->bo_ring[batch->bo_ring_next];
+
+   batch->bo_ring_next = (batch->bo_ring_next + 1) % ARRAY_SIZE(batch->bo_ring);
+
+   if (*bo && drm_intel_bo_busy(*bo)) {
+      drm_intel_bo_unreference(*bo);
+      *bo = NULL;
+   }
+
+   if (!*bo) {
+      *bo = drm_intel_bo_alloc(brw->bufmgr, "batchbuffer", BATCH_SZ, 4096);
+      if (brw->has_llc)
+         drm_intel_bo_map(*bo, true);
+   }
+
+   drm_intel_bo_reference(*bo);
+   return *bo;
+}
+
 static void
 intel_batchbuffer_reset(struct brw_context *brw)
 {
@@ -62,12 +90,9 @@ intel_batchbuffer_reset(struct brw_context *brw)
 
    brw_render_cache_set_clear(brw);
 
-   brw->batch.bo = drm_intel_bo_alloc(brw->bufmgr, "batchbuffer",
-					BATCH_SZ, 4096);
-   if (brw->has_llc) {
-      drm_intel_bo_map(brw->batch.bo, true);
+   brw->batch.bo = intel_batchbuffer_get_bo(brw);
+   if (brw->has_llc)
       brw->batch.map = brw->batch.bo->virtual;
-   }
    brw->batch.map_next = brw->batch.map;
 
    brw->batch.reserved_space = BATCH_RESERVED;
@@ -101,9 +126,14 @@ intel_batchbuffer_reset_to_saved(struct brw_context *brw)
 void
 intel_batchbuffer_free(struct brw_context *brw)
 {
+   unsigned i;
+
    free(brw->batch.cpu_map);
    drm_intel_bo_unreference(brw->batch.last_bo);
    drm_intel_bo_unreference(brw->batch.bo);
+
+   for (i = 0; i < ARRAY_SIZE(brw->batch.bo_ring); i++)
+      drm_intel_bo_unreference(brw->batch.bo_ring[i]);
 }
 
 void
@@ -324,9 +354,10 @@ do_flush_locked(struct brw_context *brw)
    struct intel_batchbuffer *batch = &brw->batch;
    int ret = 0;
 
-   if (brw->has_llc) {
-      drm_intel_bo_unmap(batch->bo);
-   } else {
+   /* On LLC platforms the batch stays mapped for its next use, the CPU and
+    * GPU views are coherent.
+    */
+   if (!brw->has_llc) {
       ret = drm_intel_bo_subdata(batch->bo, 0, 4 * USED_BATCH(*batch), batch->map);
       if (ret == 0 && batch->state_batch_offset != batch->bo->size) {
 	 ret = drm_intel_bo_subdata(batch->bo,
@@ -372,7 +372,6 @@ intel_miptree_create_layout(struct brw_context *brw,
    mt->logical_depth0 = depth0;
    mt->fast_clear_state = INTEL_FAST_CLEAR_STATE_NO_MCS;
    mt->disable_aux_buffers = (layout_flags & MIPTREE_LAYOUT_DISABLE_AUX) != 0;
-   exec_list_make_empty(&mt->hiz_map);
    mt->cpp = _mesa_get_format_bytes(format);
    mt->num_samples = num_samples;
    mt->compressed = _mesa_is_format_compressed(format);
@@ -994,7 +993,6 @@ intel_miptree_release(struct intel_mipmap_tree **mt)
          free((*mt)->hiz_buf);
       }
       intel_miptree_release(&(*mt)->mcs_mt);
-      intel_resolve_map_clear(&(*mt)->hiz_map);
 
       for (i = 0; i < MAX_TEXTURE_LEVELS; i++) {
 	 free((*mt)->level[i].slice);
@@ -1911,17 +1909,18 @@ intel_miptree_alloc_hiz(struct brw_context *brw,
 
    /* Mark that all slices need a HiZ resolve. */
    for (unsigned level = mt->first_level; level <= mt->last_level; ++level) {
-      if (!intel_miptree_level_enable_hiz(brw, mt, level))
-         continue;
+      const bool has_hiz = intel_miptree_level_enable_hiz(brw, mt, level);
 
       for (unsigned layer = 0; layer < mt->level[level].depth; ++layer) {
-         struct intel_resolve_map *m = malloc(sizeof(struct intel_resolve_map));
-         exec_node_init(&m->link);
-         m->level = level;
-         m->layer = layer;
-         m->need = GEN6_HIZ_OP_HIZ_RESOLVE;
+         mt->level[level].slice[layer].hiz_need =
+            has_hiz ? GEN6_HIZ_OP_HIZ_RESOLVE : GEN6_HIZ_OP_NONE;
+      }
 
-         exec_list_push_tail(&mt->hiz_map, &m->link);
+      memset(mt->level[level].hiz_need_count, 0,
+             sizeof(mt->level[level].hiz_need_count));
+      if (has_hiz) {
+         mt->level[level].hiz_need_count[GEN6_HIZ_OP_HIZ_RESOLVE] =
+            mt->level[level].depth;
       }
    }
 
@@ -1938,6 +1937,32 @@ intel_miptree_level_has_hiz(struct intel_mipmap_tree *mt, uint32_t level)
    return mt->level[level].has_hiz;
 }
 
+/**
+ * Record the HiZ operation a slice needs, keeping the level's counts in sync.
+ */
+static void
+intel_miptree_slice_set_hiz_need(struct intel_mipmap_tree *mt,
+                                 uint32_t level,
+                                 uint32_t layer,
+                                 enum gen6_hiz_op need)
+{
+   struct intel_mipmap_level *lvl = &mt->level[level];
+   struct intel_mipmap_slice *slice = &lvl->slice[layer];
+
+   if (slice->hiz_need == need)
+      return;
+
+   if (slice->hiz_need != GEN6_HIZ_OP_NONE) {
+      assert(lvl->hiz_need_count[slice->hiz_need] > 0);
+      lvl->hiz_need_count[slice->hiz_need]--;
+   }
+
+   if (need != GEN6_HIZ_OP_NONE)
+      lvl->hiz_need_count[need]++;
+
+   slice->hiz_need = need;
+}
+
 void
 intel_miptree_slice_set_needs_hiz_resolve(struct intel_mipmap_tree *mt,
 					  uint32_t level,
@@ -1946,8 +1971,8 @@ intel_miptree_slice_set_needs_hiz_resolve(struct intel_mipmap_tree *mt,
    if (!intel_miptree_level_has_hiz(mt, level))
       return;
 
-   intel_resolve_map_set(&mt->hiz_map,
-			 level, layer, GEN6_HIZ_OP_HIZ_RESOLVE);
+   intel_miptree_slice_set_hiz_need(mt, level, layer,
+                                    GEN6_HIZ_OP_HIZ_RESOLVE);
 }
 
 
@@ -1959,8 +1984,8 @@ intel_miptree_slice_set_needs_depth_resolve(struct intel_mipmap_tree *mt,
    if (!intel_miptree_level_has_hiz(mt, level))
       return;
 
-   intel_resolve_map_set(&mt->hiz_map,
-			 level, layer, GEN6_HIZ_OP_DEPTH_RESOLVE);
+   intel_miptree_slice_set_hiz_need(mt, level, layer,
+                                    GEN6_HIZ_OP_DEPTH_RESOLVE);
 }
 
 void
@@ -1984,14 +2009,12 @@ intel_miptree_slice_resolve(struct brw_context *brw,
 {
    intel_miptree_check_level_layer(mt, level, layer);
 
-   struct intel_resolve_map *item =
-	 intel_resolve_map_get(&mt->hiz_map, level, layer);
-
-   if (!item || item->need != need)
+   if (!mt->level[level].has_hiz ||
+       mt->level[level].slice[layer].hiz_need != need)
       return false;
 
    intel_hiz_exec(brw, mt, level, layer, need);
-   intel_resolve_map_remove(item);
+   intel_miptree_slice_set_hiz_need(mt, level, layer, GEN6_HIZ_OP_NONE);
    return true;
 }
 
@@ -2022,13 +2045,26 @@ intel_miptree_all_slices_resolve(struct brw_context *brw,
 {
    bool did_resolve = false;
 
-   foreach_list_typed_safe(struct intel_resolve_map, map, link, &mt->hiz_map) {
-      if (map->need != need)
-	 continue;
+   if (!mt->hiz_buf)
+      return false;
+
+   for (unsigned level = mt->first_level; level <= mt->last_level; ++level) {
+      if (!mt->level[level].has_hiz ||
+          mt->level[level].hiz_need_count[need] == 0)
+         continue;
+
+      for (unsigned layer = 0; layer < mt->level[level].depth; ++layer) {
+         if (mt->level[level].slice[layer].hiz_need != need)
+            continue;
+
+         intel_hiz_exec(brw, mt, level, layer, need);
+         intel_miptree_slice_set_hiz_need(mt, level, layer,
+                                          GEN6_HIZ_OP_NONE);
+         did_resolve = true;
 
-      intel_hiz_exec(brw, mt, map->level, map->layer, need);
-      intel_resolve_map_remove(map);
-      did_resolve = true;
+         if (mt->level[level].hiz_need_count[need] == 0)
+            break;
+      }
    }
 
    return did_resolve;
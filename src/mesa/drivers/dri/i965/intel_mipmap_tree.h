@@ -58,7 +58,6 @@ extern "C" {
 struct brw_context;
 struct intel_renderbuffer;
 
-struct intel_resolve_map;
 struct intel_texture_image;
 
 /**
@@ -155,7 +154,21 @@ struct intel_mipmap_level
        * intel_miptree_map/unmap on this slice.
        */
       struct intel_miptree_map *map;
+
+      /**
+       * The HiZ operation this slice needs before its depth or HiZ data can
+       * be used, or GEN6_HIZ_OP_NONE.  Only meaningful when the level has
+       * HiZ enabled.
+       */
+      enum gen6_hiz_op hiz_need;
    } *slice;
+
+   /**
+    * Number of slices in this level needing each HiZ operation, so that
+    * resolving all slices of a miptree only visits the levels with work to
+    * do and the common case of nothing pending costs a few compares.
+    */
+   unsigned hiz_need_count[GEN6_HIZ_OP_NONE];
 };
 
 /**
@@ -589,17 +602,6 @@ struct intel_mipmap_tree
     */
    struct intel_miptree_aux_buffer *hiz_buf;
 
-   /**
-    * \brief Map of miptree slices to needed resolves.
-    *
-    * This is used only when the miptree has a child HiZ miptree.
-    *
-    * Let \c mt be a depth miptree with HiZ enabled. Then the resolve map is
-    * \c mt->hiz_map. The resolve map of the child HiZ miptree, \c
-    * mt->hiz_mt->hiz_map, is unused.
-    */
-   struct exec_list hiz_map; /* List of intel_resolve_map. */
-
    /**
     * \brief Stencil miptree for depthstencil textures.
     *
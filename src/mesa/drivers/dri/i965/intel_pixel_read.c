@@ -50,8 +50,9 @@
 /**
  * \brief A fast path for glReadPixels
  *
- * This fast path is taken when the source format is BGRA, RGBA,
- * A or L and when the texture memory is X- or Y-tiled.  It downloads
+ * This fast path is taken when the client data has the layout of the
+ * source format (or swaps R and B of an 8-bit RGBA format) and when the
+ * texture memory is X- or Y-tiled.  It downloads
  * the source data by directly mapping the memory without a GTT fence.
  * This then needs to be de-tiled on the CPU before presenting the data to
  * the user in the linear fasion.
@@ -87,14 +88,12 @@ intel_readpixels_tiled_memcpy(struct gl_context * ctx,
    int error = 0;
 
    uint32_t cpp;
-   mem_copy_fn mem_copy = NULL;
+   enum isl_memcpy_type copy_type;
 
-   /* This fastpath is restricted to specific renderbuffer types:
-    * a 2D BGRA, RGBA, L8 or A8 texture. It could be generalized to support
-    * more types.
+   /* This fastpath is restricted to 2D renderbuffers whose format
+    * intel_get_memcpy() knows how to copy.
     */
    if (!brw->has_llc ||
-       !(type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_INT_8_8_8_8_REV) ||
        pixels == NULL ||
        _mesa_is_bufferobj(pack->BufferObj) ||
        pack->Alignment > 4 ||
@@ -141,7 +140,7 @@ intel_readpixels_tiled_memcpy(struct gl_context * ctx,
    if (rb->_BaseFormat == GL_RGB)
       return false;
 
-   if (!intel_get_memcpy(rb->Format, format, type, &mem_copy, &cpp))
+   if (!intel_get_memcpy(rb->Format, format, type, &copy_type, &cpp))
       return false;
 
    if (!irb->mt ||
@@ -177,8 +176,9 @@ intel_readpixels_tiled_memcpy(struct gl_context * ctx,
     * little creative.  First, we compute the Y-offset of the first row of
     * the renderbuffer (in renderbuffer coordinates).  We then match that
     * with the last row of the client's data.  Finally, we give
-    * tiled_to_linear a negative pitch so that it walks through the
-    * client's data backwards as it walks through the renderbufer forwards.
+    * isl_memcpy_tiled_to_linear a negative pitch so that it walks through
+    * the client's data backwards as it walks through the renderbufer
+    * forwards.
     */
    if (rb->Name == 0) {
       yoffset = rb->Height - yoffset - height;
@@ -197,15 +197,15 @@ intel_readpixels_tiled_memcpy(struct gl_context * ctx,
        pack->Alignment, pack->RowLength, pack->SkipPixels,
        pack->SkipRows);
 
-   tiled_to_linear(
+   isl_memcpy_tiled_to_linear(
       xoffset * cpp, (xoffset + width) * cpp,
       yoffset, yoffset + height,
       pixels - (ptrdiff_t) yoffset * dst_pitch - (ptrdiff_t) xoffset * cpp,
       bo->virtual,
       dst_pitch, irb->mt->pitch,
       brw->has_swizzling,
-      irb->mt->tiling,
-      mem_copy
+      irb->mt->tiling == I915_TILING_X ? ISL_TILING_X : ISL_TILING_Y0,
+      copy_type
    );
 
    drm_intel_bo_unmap(bo);
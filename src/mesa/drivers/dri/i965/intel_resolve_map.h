@@ -24,7 +24,6 @@
 #pragma once
 
 #include <stdint.h>
-#include "compiler/glsl/list.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,8 +36,8 @@ extern "C" {
  *   - 7.5.3.2 Depth Buffer Resolve
  *   - 7.5.3.3 Hierarchical Depth Buffer Resolve
  *
- * Of these, two get entered in the resolve map as needing to be done to the
- * buffer: depth resolve and hiz resolve.
+ * Of these, two get recorded per miptree slice as needing to be done to the
+ * buffer: depth resolve and hiz resolve.  See intel_mipmap_slice::hiz_need.
  */
 enum gen6_hiz_op {
    GEN6_HIZ_OP_DEPTH_CLEAR,
@@ -47,57 +46,6 @@ enum gen6_hiz_op {
    GEN6_HIZ_OP_NONE,
 };
 
-/**
- * \brief Map of miptree slices to needed resolves.
- *
- * The map is implemented as a linear doubly-linked list.
- *
- * In the intel_resolve_map*() functions, the \c head argument is not
- * inspected for its data. It only serves as an anchor for the list.
- *
- * \par Design Discussion
- *
- *     There are two possible ways to record which miptree slices need
- *     resolves. 1) Maintain a flag for every miptree slice in the texture,
- *     likely in intel_mipmap_level::slice, or 2) maintain a list of only
- *     those slices that need a resolve.
- *
- *     Immediately before drawing, a full depth resolve performed on each
- *     enabled depth texture. If design 1 were chosen, then at each draw call
- *     it would be necessary to iterate over each miptree slice of each
- *     enabled depth texture in order to query if each slice needed a resolve.
- *     In the worst case, this would require 2^16 iterations: 16 texture
- *     units, 16 miplevels, and 256 depth layers (assuming maximums for OpenGL
- *     2.1).
- *
- *     By choosing design 2, the number of iterations is exactly the minimum
- *     necessary.
- */
-struct intel_resolve_map {
-   struct exec_node link;
-
-   uint32_t level;
-   uint32_t layer;
-   enum gen6_hiz_op need;
-};
-
-void
-intel_resolve_map_set(struct exec_list *resolve_map,
-		      uint32_t level,
-		      uint32_t layer,
-		      enum gen6_hiz_op need);
-
-struct intel_resolve_map *
-intel_resolve_map_get(struct exec_list *resolve_map,
-		      uint32_t level,
-		      uint32_t layer);
-
-void
-intel_resolve_map_remove(struct intel_resolve_map *resolve_map);
-
-void
-intel_resolve_map_clear(struct exec_list *resolve_map);
-
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
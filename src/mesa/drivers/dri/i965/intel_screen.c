@@ -85,6 +85,12 @@ DRI_CONF_BEGIN
       DRI_CONF_OPT_BEGIN_B(shader_precompile, "true")
 	 DRI_CONF_DESC(en, "Perform code generation at shader link time.")
       DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_B(shader_precompile_observed_keys, "true")
+	 DRI_CONF_DESC(en, "Remember the state shaders were compiled for at "
+                       "draw time in the shader cache, and generate code "
+                       "for it at link time as well.")
+      DRI_CONF_OPT_END
    DRI_CONF_SECTION_END
 DRI_CONF_END
 };
@@ -99,6 +105,7 @@ DRI_CONF_END
 #include "intel_image.h"
 
 #include "brw_context.h"
+#include "brw_disk_cache.h"
 
 #include "i915_drm.h"
 
@@ -965,6 +972,7 @@ intelDestroyScreen(__DRIscreen * sPriv)
 {
    struct intel_screen *intelScreen = sPriv->driverPrivate;
 
+   brw_disk_cache_destroy(intelScreen);
    dri_bufmgr_destroy(intelScreen->bufmgr);
    driDestroyOptionInfo(&intelScreen->optionCache);
 
@@ -1547,6 +1555,7 @@ __DRIconfig **intelInitScreen2(__DRIscreen *psp)
    intelScreen->compiler = brw_compiler_create(intelScreen,
                                                intelScreen->devinfo);
    intelScreen->program_id = 1;
+   brw_disk_cache_init(intelScreen);
 
    if (intelScreen->devinfo->has_resource_streamer) {
       int val = -1;
@@ -71,6 +71,11 @@ struct intel_screen
 
    struct brw_compiler *compiler;
 
+   /**
+    * On-disk cache of compiled programs, or NULL if disabled.
+    */
+   struct disk_cache *disk_cache;
+
    /**
    * Configuration cache with default values for all contexts
    */
@@ -371,11 +371,10 @@ intel_gettexsubimage_tiled_memcpy(struct gl_context *ctx,
    int error = 0;
 
    uint32_t cpp;
-   mem_copy_fn mem_copy = NULL;
+   enum isl_memcpy_type copy_type;
 
-   /* This fastpath is restricted to specific texture types:
-    * a 2D BGRA, RGBA, L8 or A8 texture. It could be generalized to support
-    * more types.
+   /* This fastpath is restricted to 2D textures whose format
+    * intel_get_memcpy() knows how to copy.
     *
     * FINISHME: The restrictions below on packing alignment and packing row
     * length are likely unneeded now because we calculate the destination stride
@@ -383,7 +382,6 @@ intel_gettexsubimage_tiled_memcpy(struct gl_context *ctx,
     * we need tests.
     */
    if (!brw->has_llc ||
-       !(type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_INT_8_8_8_8_REV) ||
        !(texImage->TexObject->Target == GL_TEXTURE_2D ||
          texImage->TexObject->Target == GL_TEXTURE_RECTANGLE) ||
        pixels == NULL ||
@@ -405,7 +403,7 @@ intel_gettexsubimage_tiled_memcpy(struct gl_context *ctx,
    if (texImage->_BaseFormat == GL_RGB)
       return false;
 
-   if (!intel_get_memcpy(texImage->TexFormat, format, type, &mem_copy, &cpp))
+   if (!intel_get_memcpy(texImage->TexFormat, format, type, &copy_type, &cpp))
       return false;
 
    /* If this is a nontrivial texture view, let another path handle it instead. */
@@ -453,15 +451,15 @@ intel_gettexsubimage_tiled_memcpy(struct gl_context *ctx,
    xoffset += image->mt->level[level].level_x;
    yoffset += image->mt->level[level].level_y;
 
-   tiled_to_linear(
+   isl_memcpy_tiled_to_linear(
       xoffset * cpp, (xoffset + width) * cpp,
       yoffset, yoffset + height,
       pixels - (ptrdiff_t) yoffset * dst_pitch - (ptrdiff_t) xoffset * cpp,
       bo->virtual,
       dst_pitch, image->mt->pitch,
       brw->has_swizzling,
-      image->mt->tiling,
-      mem_copy
+      image->mt->tiling == I915_TILING_X ? ISL_TILING_X : ISL_TILING_Y0,
+      copy_type
    );
 
    drm_intel_bo_unmap(bo);
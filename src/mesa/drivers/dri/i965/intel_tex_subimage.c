@@ -32,6 +32,7 @@
 #include "main/texstore.h"
 #include "main/texcompress.h"
 #include "main/enums.h"
+#include "main/glformats.h"
 #include "drivers/common/meta.h"
 
 #include "brw_context.h"
@@ -40,6 +41,8 @@
 #include "intel_mipmap_tree.h"
 #include "intel_blit.h"
 #include "intel_tiled_memcpy.h"
+#include "intel_buffer_objects.h"
+#include "brw_blorp.h"
 
 #define FILE_DEBUG_FLAG DEBUG_TEXTURE
 
@@ -48,8 +51,9 @@
  *
  * \param for_glTexImage Was this called from glTexImage or glTexSubImage?
  *
- * This fast path is taken when the texture format is BGRA, RGBA,
- * A or L and when the texture memory is X- or Y-tiled.  It uploads
+ * This fast path is taken when the client data has the layout of the
+ * texture format (or swaps R and B of an 8-bit RGBA format) and when the
+ * texture memory is X- or Y-tiled.  It uploads
  * the texture data by mapping the texture memory without a GTT fence, thus
  * acquiring a tiled view of the memory, and then copying sucessive
  * spans within each tile.
@@ -89,11 +93,10 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
    int error = 0;
 
    uint32_t cpp;
-   mem_copy_fn mem_copy = NULL;
+   enum isl_memcpy_type copy_type;
 
-   /* This fastpath is restricted to specific texture types:
-    * a 2D BGRA, RGBA, L8 or A8 texture. It could be generalized to support
-    * more types.
+   /* This fastpath is restricted to 2D textures whose format
+    * intel_get_memcpy() knows how to copy.
     *
     * FINISHME: The restrictions below on packing alignment and packing row
     * length are likely unneeded now because we calculate the source stride
@@ -101,7 +104,6 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
     * we need tests.
     */
    if (!brw->has_llc ||
-       !(type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_INT_8_8_8_8_REV) ||
        !(texImage->TexObject->Target == GL_TEXTURE_2D ||
          texImage->TexObject->Target == GL_TEXTURE_RECTANGLE) ||
        pixels == NULL ||
@@ -119,7 +121,7 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
    if (ctx->_ImageTransferState)
       return false;
 
-   if (!intel_get_memcpy(texImage->TexFormat, format, type, &mem_copy, &cpp))
+   if (!intel_get_memcpy(texImage->TexFormat, format, type, &copy_type, &cpp))
       return false;
 
    /* If this is a nontrivial texture view, let another path handle it instead. */
@@ -174,21 +176,151 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
    xoffset += image->mt->level[level].level_x;
    yoffset += image->mt->level[level].level_y;
 
-   linear_to_tiled(
+   isl_memcpy_linear_to_tiled(
       xoffset * cpp, (xoffset + width) * cpp,
       yoffset, yoffset + height,
       bo->virtual,
       pixels - (ptrdiff_t) yoffset * src_pitch - (ptrdiff_t) xoffset * cpp,
       image->mt->pitch, src_pitch,
       brw->has_swizzling,
-      image->mt->tiling,
-      mem_copy
+      image->mt->tiling == I915_TILING_X ? ISL_TILING_X : ISL_TILING_Y0,
+      copy_type
    );
 
    drm_intel_bo_unmap(bo);
    return true;
 }
 
+/**
+ * \brief Upload through a linear staging buffer and a BLORP blit.
+ *
+ * When the miptree is still in use by the GPU, mapping it would stall until
+ * rendering finishes.  Instead, the client data is copied into a freshly
+ * allocated (and therefore idle) buffer, which is then blitted into the
+ * miptree by the GPU in order with the rest of the batch.
+ *
+ * This only handles client data which already has the layout of the texture
+ * format; anything needing conversion is left to the other paths.
+ */
+static bool
+intel_texsubimage_blorp(struct gl_context *ctx,
+                        GLuint dims,
+                        struct gl_texture_image *texImage,
+                        GLint xoffset, GLint yoffset, GLint zoffset,
+                        GLsizei width, GLsizei height, GLsizei depth,
+                        GLenum format, GLenum type,
+                        const GLvoid *pixels,
+                        const struct gl_pixelstore_attrib *packing)
+{
+   struct brw_context *brw = brw_context(ctx);
+   struct intel_texture_image *image = intel_texture_image(texImage);
+   struct intel_mipmap_tree *dst_mt = image->mt;
+   const mesa_format tex_format = texImage->TexFormat;
+   GLenum target = texImage->TexObject->Target;
+
+   /* BLORP is only supported from Gen6 onwards. */
+   if (brw->gen < 6 || dst_mt == NULL || dst_mt->num_samples > 1)
+      return false;
+
+   if (pixels == NULL || _mesa_is_bufferobj(packing->BufferObj))
+      return false;
+
+   /* Only a simple blit, no scale, bias or other mapping. */
+   if (ctx->_ImageTransferState)
+      return false;
+
+   if (!(target == GL_TEXTURE_2D ||
+         target == GL_TEXTURE_RECTANGLE ||
+         target == GL_TEXTURE_CUBE_MAP ||
+         target == GL_TEXTURE_2D_ARRAY ||
+         target == GL_TEXTURE_CUBE_MAP_ARRAY ||
+         target == GL_TEXTURE_3D))
+      return false;
+
+   const GLenum base_format = _mesa_get_format_base_format(tex_format);
+   if (_mesa_is_format_compressed(tex_format) ||
+       _mesa_is_depth_or_stencil_format(base_format) ||
+       !brw->format_supported_as_render_target[tex_format])
+      return false;
+
+   if (!_mesa_format_matches_format_and_type(tex_format, format, type,
+                                             packing->SwapBytes, NULL))
+      return false;
+
+   const int cpp = _mesa_get_format_bytes(tex_format);
+   const int pitch = ALIGN(width * cpp, 64);
+   const uint32_t size = pitch * height * depth;
+
+   /* Leave huge uploads to the paths which don't need a second copy of the
+    * data in the aperture.
+    */
+   if (size >= brw->max_gtt_map_object_size)
+      return false;
+
+   drm_intel_bo *bo = drm_intel_bo_alloc(brw->bufmgr, "texsubimage staging",
+                                         size, 64);
+   if (bo == NULL)
+      return false;
+
+   if (brw_bo_map(brw, bo, true /* write enable */, "texsubimage staging") ||
+       bo->virtual == NULL) {
+      drm_intel_bo_unreference(bo);
+      return false;
+   }
+
+   DBG("%s: level=%d offset=(%d,%d,%d) (w,h,d)=(%d,%d,%d) format=0x%x "
+       "type=0x%x mesa_format=0x%x\n",
+       __func__, texImage->Level, xoffset, yoffset, zoffset,
+       width, height, depth, format, type, tex_format);
+
+   const int src_stride = _mesa_image_row_stride(packing, width, format, type);
+   const int src_image_stride =
+      _mesa_image_image_stride(packing, width, height, format, type);
+   const GLubyte *src = _mesa_image_address(dims, packing, pixels,
+                                            width, height, format, type,
+                                            0, 0, 0);
+   GLubyte *dst = bo->virtual;
+
+   for (int z = 0; z < depth; z++) {
+      for (int y = 0; y < height; y++) {
+         memcpy(dst + (z * height + y) * pitch,
+                src + z * src_image_stride + y * src_stride,
+                width * cpp);
+      }
+   }
+
+   drm_intel_bo_unmap(bo);
+
+   struct intel_mipmap_tree *src_mt =
+      intel_miptree_create_for_bo(brw, bo, tex_format, 0,
+                                  width, height * depth, 1, pitch, 0);
+   if (src_mt == NULL) {
+      drm_intel_bo_unreference(bo);
+      return false;
+   }
+
+   const int level = texImage->Level + texImage->TexObject->MinLevel;
+   const int first_layer = texImage->Face + texImage->TexObject->MinLayer;
+
+   for (int z = 0; z < depth; z++) {
+      brw_blorp_blit_miptrees(brw,
+                              src_mt, 0 /* level */, 0 /* layer */,
+                              tex_format, SWIZZLE_XYZW,
+                              dst_mt, level, first_layer + zoffset + z,
+                              tex_format,
+                              0, z * height, width, (z + 1) * height,
+                              xoffset, yoffset,
+                              xoffset + width, yoffset + height,
+                              GL_NEAREST, false, false,
+                              false, false /* decode/encode srgb */);
+   }
+
+   intel_miptree_release(&src_mt);
+   drm_intel_bo_unreference(bo);
+
+   return true;
+}
+
 static void
 intelTexSubImage(struct gl_context * ctx,
                  GLuint dims,
@@ -199,10 +331,13 @@ intelTexSubImage(struct gl_context * ctx,
                  const GLvoid * pixels,
                  const struct gl_pixelstore_attrib *packing)
 {
+   struct brw_context *brw = brw_context(ctx);
    struct intel_texture_image *intelImage = intel_texture_image(texImage);
    bool ok;
 
-   bool tex_busy = intelImage->mt && drm_intel_bo_busy(intelImage->mt->bo);
+   bool tex_busy = intelImage->mt &&
+      (drm_intel_bo_references(brw->batch.bo, intelImage->mt->bo) ||
+       drm_intel_bo_busy(intelImage->mt->bo));
 
    DBG("%s mesa_format %s target %s format %s type %s level %d %dx%dx%d\n",
        __func__, _mesa_get_format_name(texImage->TexFormat),
@@ -210,6 +345,15 @@ intelTexSubImage(struct gl_context * ctx,
        _mesa_enum_to_string(format), _mesa_enum_to_string(type),
        texImage->Level, texImage->Width, texImage->Height, texImage->Depth);
 
+   if (tex_busy) {
+      ok = intel_texsubimage_blorp(ctx, dims, texImage,
+                                   xoffset, yoffset, zoffset,
+                                   width, height, depth, format, type,
+                                   pixels, packing);
+      if (ok)
+         return;
+   }
+
    ok = _mesa_meta_pbo_TexSubImage(ctx, dims, texImage,
                                    xoffset, yoffset, zoffset,
                                    width, height, depth, format, type,
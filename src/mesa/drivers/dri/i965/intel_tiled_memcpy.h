@@ -34,28 +34,10 @@
 
 #include <stdint.h>
 #include "main/mtypes.h"
-
-typedef void *(*mem_copy_fn)(void *dest, const void *src, size_t n);
-
-void
-linear_to_tiled(uint32_t xt1, uint32_t xt2,
-                uint32_t yt1, uint32_t yt2,
-                char *dst, const char *src,
-                uint32_t dst_pitch, int32_t src_pitch,
-                bool has_swizzling,
-                uint32_t tiling,
-                mem_copy_fn mem_copy);
-
-void
-tiled_to_linear(uint32_t xt1, uint32_t xt2,
-                uint32_t yt1, uint32_t yt2,
-                char *dst, const char *src,
-                int32_t dst_pitch, uint32_t src_pitch,
-                bool has_swizzling,
-                uint32_t tiling,
-                mem_copy_fn mem_copy);
+#include "isl/isl.h"
 
 bool intel_get_memcpy(mesa_format tiledFormat, GLenum format,
-                      GLenum type, mem_copy_fn *mem_copy, uint32_t *cpp);
+                      GLenum type, enum isl_memcpy_type *copy_type,
+                      uint32_t *cpp);
 
 #endif /* INTEL_TILED_MEMCPY */
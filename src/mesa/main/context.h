@@ -158,6 +158,9 @@ _mesa_notifySwapBuffers(struct gl_context *gc);
 extern struct _glapi_table *
 _mesa_get_dispatch(struct gl_context *ctx);
 
+extern struct _glapi_table *
+_mesa_alloc_dispatch_table(void);
+
 
 extern GLboolean
 _mesa_valid_to_render(struct gl_context *ctx, const char *where);
@@ -35,6 +35,8 @@
 
 #include "glheader.h"
 
+struct blob;
+struct blob_reader;
 struct gl_bitmap_atlas;
 struct gl_buffer_object;
 struct gl_context;
@@ -514,6 +516,30 @@ struct dd_function_table {
     */
    GLboolean (*LinkShader)(struct gl_context *ctx,
                            struct gl_shader_program *shader);
+
+   /**
+    * Serialize the driver-specific part of a linked program into \p blob
+    * for storage in the on-disk shader cache (optional).
+    *
+    * \return false if the program cannot be cached, in which case nothing
+    * is stored for the whole shader program.
+    */
+   bool (*ShaderCacheSerializeDriverBlob)(struct gl_context *ctx,
+                                          struct gl_program *prog,
+                                          struct blob *blob);
+
+   /**
+    * Restore a program previously written by
+    * \c ShaderCacheSerializeDriverBlob.  This replaces both the GLSL
+    * compiler back end and \c ProgramStringNotify for \p prog.
+    *
+    * \return false if the blob could not be used, in which case the
+    * program is linked from source instead.
+    */
+   bool (*ShaderCacheDeserializeDriverBlob)(struct gl_context *ctx,
+                                            struct gl_shader_program *shProg,
+                                            struct gl_program *prog,
+                                            struct blob_reader *blob);
    /*@}*/
 
    /**
@@ -26,6 +26,13 @@
 #include "glformats.h"
 #include "format_pack.h"
 #include "format_unpack.h"
+#include "c11/threads.h"
+#include "util/u_queue.h"
+#include "x86/common_x86_asm.h"
+
+#ifdef HAVE_PTHREAD
+#include <unistd.h>
+#endif
 
 const mesa_array_format RGBA32_FLOAT =
    MESA_ARRAY_FORMAT(4, 1, 1, 1, 4, 0, 1, 2, 3);
@@ -236,6 +243,87 @@ convert_ubyte_rgba_to_bgra(size_t width, size_t height,
 }
 
 
+/**
+ * Images with fewer pixels are converted on the calling thread only.
+ */
+#define FORMAT_CONVERT_MIN_THREADED_PIXELS (1024 * 1024)
+
+/** Largest number of threads converting a single image. */
+#define FORMAT_CONVERT_MAX_THREADS 8
+
+struct format_convert_job {
+   uint8_t *dst;
+   uint32_t dst_format;
+   size_t dst_stride;
+   uint8_t *src;
+   uint32_t src_format;
+   size_t src_stride;
+   size_t width;
+   size_t height;
+   uint8_t *rebase_swizzle;
+   struct util_queue_fence fence;
+};
+
+/* Shared by all contexts.  Conversions are stateless, any thread can work
+ * on any band of rows.
+ */
+static struct util_queue format_convert_queue;
+static once_flag format_convert_queue_once = ONCE_FLAG_INIT;
+
+static void
+format_convert_queue_destroy(void)
+{
+   util_queue_destroy(&format_convert_queue);
+}
+
+static void
+format_convert_queue_init(void)
+{
+#if defined(HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+   long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+   if (num_cpus < 2)
+      return;
+
+   /* The calling thread converts a band of rows as well. */
+   if (util_queue_init(&format_convert_queue, "format_convert",
+                       FORMAT_CONVERT_MAX_THREADS,
+                       MIN2(num_cpus, FORMAT_CONVERT_MAX_THREADS) - 1))
+      atexit(format_convert_queue_destroy);
+#endif
+}
+
+/**
+ * Return the queue large images are converted on, or NULL if there's only
+ * one CPU.  Other work on independent bands of an image's rows, like
+ * decompressing textures, can use it too.
+ */
+struct util_queue *
+_mesa_get_format_convert_queue(void)
+{
+   call_once(&format_convert_queue_once, format_convert_queue_init);
+
+   if (!util_queue_is_initialized(&format_convert_queue))
+      return NULL;
+
+   return &format_convert_queue;
+}
+
+static void
+format_convert_rows(void *void_dst, uint32_t dst_format, size_t dst_stride,
+                    void *void_src, uint32_t src_format, size_t src_stride,
+                    size_t width, size_t height, uint8_t *rebase_swizzle);
+
+static void
+format_convert_execute(void *data, int thread_index)
+{
+   struct format_convert_job *job = data;
+
+   format_convert_rows(job->dst, job->dst_format, job->dst_stride,
+                       job->src, job->src_format, job->src_stride,
+                       job->width, job->height, job->rebase_swizzle);
+}
+
 /**
  * This can be used to convert between most color formats.
  *
@@ -267,6 +355,62 @@ void
 _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
                      void *void_src, uint32_t src_format, size_t src_stride,
                      size_t width, size_t height, uint8_t *rebase_swizzle)
+{
+   struct format_convert_job jobs[FORMAT_CONVERT_MAX_THREADS];
+   unsigned num_jobs, i;
+   size_t rows_per_job;
+
+   if (width * height >= FORMAT_CONVERT_MIN_THREADED_PIXELS)
+      call_once(&format_convert_queue_once, format_convert_queue_init);
+
+   if (width * height < FORMAT_CONVERT_MIN_THREADED_PIXELS ||
+       !util_queue_is_initialized(&format_convert_queue)) {
+      format_convert_rows(void_dst, dst_format, dst_stride,
+                          void_src, src_format, src_stride,
+                          width, height, rebase_swizzle);
+      return;
+   }
+
+   /* Split the image in bands of rows, the first one is converted by the
+    * calling thread while the queue works on the others.
+    */
+   num_jobs = MIN2(format_convert_queue.num_threads + 1, height);
+   rows_per_job = DIV_ROUND_UP(height, num_jobs);
+   num_jobs = DIV_ROUND_UP(height, rows_per_job);
+
+   for (i = 0; i < num_jobs; i++) {
+      struct format_convert_job *job = &jobs[i];
+      size_t row = i * rows_per_job;
+
+      job->dst = (uint8_t *) void_dst + row * dst_stride;
+      job->dst_format = dst_format;
+      job->dst_stride = dst_stride;
+      job->src = (uint8_t *) void_src + row * src_stride;
+      job->src_format = src_format;
+      job->src_stride = src_stride;
+      job->width = width;
+      job->height = MIN2(rows_per_job, height - row);
+      job->rebase_swizzle = rebase_swizzle;
+
+      if (i > 0) {
+         util_queue_fence_init(&job->fence);
+         util_queue_add_job(&format_convert_queue, job, &job->fence,
+                            format_convert_execute);
+      }
+   }
+
+   format_convert_execute(&jobs[0], 0);
+
+   for (i = 1; i < num_jobs; i++) {
+      util_queue_job_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
+
+static void
+format_convert_rows(void *void_dst, uint32_t dst_format, size_t dst_stride,
+                    void *void_src, uint32_t src_format, size_t src_stride,
+                    size_t width, size_t height, uint8_t *rebase_swizzle)
 {
    uint8_t *dst = (uint8_t *)void_dst;
    uint8_t *src = (uint8_t *)void_src;
@@ -1066,6 +1210,12 @@ convert_ubyte(void *void_dst, int num_dst_channels,
       }
       break;
    case MESA_ARRAY_FORMAT_TYPE_UBYTE:
+#if defined(USE_SSE41)
+      if (cpu_has_sse4_1 && num_dst_channels == 4 && num_src_channels == 4) {
+         _mesa_swizzle_ubyte4_sse41(void_dst, void_src, swizzle, one, count);
+         break;
+      }
+#endif
       SWIZZLE_CONVERT(uint8_t, uint8_t, src);
       break;
    case MESA_ARRAY_FORMAT_TYPE_BYTE:
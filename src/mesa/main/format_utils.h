@@ -36,6 +36,8 @@
 #include "util/rounding.h"
 #include "util/half_float.h"
 
+struct util_queue;
+
 extern const mesa_array_format RGBA32_FLOAT;
 extern const mesa_array_format RGBA8_UBYTE;
 extern const mesa_array_format RGBA32_UINT;
@@ -229,6 +231,12 @@ _mesa_swizzle_and_convert(void *dst,
                           int num_src_channels,
                           const uint8_t swizzle[4], bool normalized, int count);
 
+#if defined(USE_SSE41)
+void
+_mesa_swizzle_ubyte4_sse41(uint8_t *dst, const uint8_t *src,
+                           const uint8_t swizzle[4], uint8_t one, int count);
+#endif
+
 bool
 _mesa_compute_rgba2base2rgba_component_mapping(GLenum baseFormat, uint8_t *map);
 
@@ -237,4 +245,7 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
                      void *void_src, uint32_t src_format, size_t src_stride,
                      size_t width, size_t height, uint8_t *rebase_swizzle);
 
+struct util_queue *
+_mesa_get_format_convert_queue(void);
+
 #endif
@@ -1607,15 +1607,73 @@ _mesa_GetFloatv(GLenum pname, GLfloat *params)
    }
 }
 
+/**
+ * Answer the binding and limit queries which applications issue most often
+ * directly, without the hash lookup and the value_desc decoding of
+ * find_value().  Except for GL_CURRENT_PROGRAM, these are in the table of
+ * every API and have no extra checks, so they can't raise errors.
+ *
+ * \return true if the query was handled
+ */
+static inline bool
+get_integer_fast(struct gl_context *ctx, GLenum pname, GLint *params)
+{
+   switch (pname) {
+   case GL_ARRAY_BUFFER_BINDING:
+      params[0] = ctx->Array.ArrayBufferObj->Name;
+      return true;
+   case GL_ELEMENT_ARRAY_BUFFER_BINDING:
+      params[0] = ctx->Array.VAO->IndexBufferObj->Name;
+      return true;
+   case GL_VERTEX_ARRAY_BINDING:
+      params[0] = ctx->Array.VAO->Name;
+      return true;
+   case GL_TEXTURE_BINDING_2D:
+      params[0] = ctx->Texture.Unit[ctx->Texture.CurrentUnit]
+                     .CurrentTex[TEXTURE_2D_INDEX]->Name;
+      return true;
+   case GL_ACTIVE_TEXTURE:
+      params[0] = GL_TEXTURE0 + ctx->Texture.CurrentUnit;
+      return true;
+   case GL_FRAMEBUFFER_BINDING:
+      params[0] = ctx->DrawBuffer->Name;
+      return true;
+   case GL_RENDERBUFFER_BINDING:
+      params[0] = ctx->CurrentRenderbuffer ? ctx->CurrentRenderbuffer->Name : 0;
+      return true;
+   case GL_CURRENT_PROGRAM:
+      if (ctx->API == API_OPENGLES)
+         return false;
+      params[0] =
+         ctx->Shader.ActiveProgram ? ctx->Shader.ActiveProgram->Name : 0;
+      return true;
+   case GL_MAX_TEXTURE_SIZE:
+      params[0] = 1 << (ctx->Const.MaxTextureLevels - 1);
+      return true;
+   case GL_PACK_ALIGNMENT:
+      params[0] = ctx->Pack.Alignment;
+      return true;
+   case GL_UNPACK_ALIGNMENT:
+      params[0] = ctx->Unpack.Alignment;
+      return true;
+   default:
+      return false;
+   }
+}
+
 void GLAPIENTRY
 _mesa_GetIntegerv(GLenum pname, GLint *params)
 {
+   GET_CURRENT_CONTEXT(ctx);
    const struct value_desc *d;
    union value v;
    GLmatrix *m;
    int shift, i;
    void *p;
 
+   if (get_integer_fast(ctx, pname, params))
+      return;
+
    d = find_value("glGetIntegerv", pname, &p, &v);
    switch (d->type) {
    case TYPE_INVALID:
@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.c
+ *
+ * Support functions for the GL API marshalling thread: the batch ring
+ * executed by a single-threaded util_queue, and the client-side state
+ * tracking used by the generated marshalling code.
+ */
+
+#include "main/mtypes.h"
+#include "main/context.h"
+#include "main/glthread.h"
+#include "main/dispatch.h"
+
+
+static void
+glthread_unmarshal_batch(void *job, int thread_index)
+{
+   struct glthread_batch *batch = (struct glthread_batch *) job;
+   struct gl_context *ctx = batch->ctx;
+   const uint8_t *cmd = (const uint8_t *) batch->buffer;
+   const uint8_t *end = cmd + batch->used;
+
+   /* The server thread executes everything with the context's real
+    * dispatch.  Entry points that switch it (glBegin, glNewList) do so for
+    * this thread only.
+    */
+   _glapi_set_context(ctx);
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   while (cmd < end)
+      cmd += _mesa_unmarshal_dispatch_cmd(ctx, cmd);
+
+   assert(cmd == end);
+   batch->used = 0;
+}
+
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = calloc(1, sizeof(*glthread));
+   unsigned i;
+
+   if (!glthread)
+      return;
+
+   if (!util_queue_init(&glthread->queue, "glthread", MARSHAL_MAX_BATCHES,
+                        1)) {
+      free(glthread);
+      return;
+   }
+
+   ctx->MarshalExec = _mesa_create_marshal_table(ctx);
+   if (!ctx->MarshalExec) {
+      util_queue_destroy(&glthread->queue);
+      free(glthread);
+      return;
+   }
+
+   for (i = 0; i < MARSHAL_MAX_BATCHES; i++) {
+      glthread->batches[i].ctx = ctx;
+      util_queue_fence_init(&glthread->batches[i].fence);
+   }
+
+   ctx->GLThread = glthread;
+
+   /* Start marshalling right away if the context is already current. */
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->MarshalExec);
+}
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   unsigned i;
+
+   if (!glthread)
+      return;
+
+   _mesa_glthread_finish(ctx);
+   util_queue_destroy(&glthread->queue);
+
+   for (i = 0; i < MARSHAL_MAX_BATCHES; i++)
+      util_queue_fence_destroy(&glthread->batches[i].fence);
+
+   free(glthread);
+   ctx->GLThread = NULL;
+
+   /* Go back to the real dispatch if the context is still current. */
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   free(ctx->MarshalExec);
+   ctx->MarshalExec = NULL;
+}
+
+/**
+ * Queue the batch being filled for execution and move on to the next one,
+ * waiting for the server thread to release it if needed.
+ */
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *batch;
+
+   if (!glthread)
+      return;
+
+   batch = &glthread->batches[glthread->next];
+   if (!batch->used)
+      return;
+
+   util_queue_add_job(&glthread->queue, batch, &batch->fence,
+                      glthread_unmarshal_batch);
+
+   glthread->next = (glthread->next + 1) % MARSHAL_MAX_BATCHES;
+   util_queue_job_wait(&glthread->batches[glthread->next].fence);
+}
+
+/**
+ * Wait for all marshalled commands to be executed.  Called before any call
+ * that has to run on the client thread, and whenever something outside the
+ * GL API (MakeCurrent, SwapBuffers) needs the context to be idle.
+ */
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   unsigned i;
+
+   if (!glthread)
+      return;
+
+   /* The server thread can end up here through a flush callback of the
+    * window system.  Its own commands are executed already.
+    */
+   if (thrd_equal(glthread->queue.threads[0], thrd_current()))
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   for (i = 0; i < MARSHAL_MAX_BATCHES; i++)
+      util_queue_job_wait(&glthread->batches[i].fence);
+}
+
+void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   switch (target) {
+   case GL_ARRAY_BUFFER:
+      glthread->vertex_array_buffer = buffer;
+      break;
+   case GL_ELEMENT_ARRAY_BUFFER:
+      glthread->element_array_buffer = buffer;
+      break;
+   }
+}
+
+void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   GLsizei i;
+
+   if (!buffers)
+      return;
+
+   /* Deleting a bound buffer unbinds it. */
+   for (i = 0; i < n; i++) {
+      if (buffers[i] == glthread->vertex_array_buffer)
+         glthread->vertex_array_buffer = 0;
+      if (buffers[i] == glthread->element_array_buffer)
+         glthread->element_array_buffer = 0;
+   }
+}
+
+void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint array)
+{
+   /* The element array binding of the new VAO isn't known on the client
+    * thread; treat it as a user pointer until it is rebound.
+    */
+   ctx->GLThread->element_array_buffer = 0;
+}
+
+void
+_mesa_glthread_PopClientAttrib(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   /* The restored vertex array state is unknown to the client thread. */
+   glthread->has_client_arrays = true;
+   glthread->vertex_array_buffer = 0;
+   glthread->element_array_buffer = 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.h
+ * GL API marshalling thread.
+ *
+ * When enabled, the client thread's dispatch table is replaced by
+ * ctx->MarshalExec, whose entry points (generated by gl_marshal.py) pack
+ * their arguments into batches.  The batches are executed in order by a
+ * server thread which calls the real entry points in ctx->CurrentDispatch.
+ * Entry points that return data, write to client memory or keep client
+ * pointers around wait for the server thread to go idle and run directly
+ * on the client thread instead.
+ */
+
+#ifndef GLTHREAD_H
+#define GLTHREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "main/glheader.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "glapi/glapi.h"
+#include "util/u_queue.h"
+
+/** Size of each batch of marshalled commands, in bytes. */
+#define MARSHAL_BATCH_SIZE (64 * 1024)
+
+/**
+ * Largest command that is marshalled, in bytes.  Calls with more data than
+ * this (e.g. big glBufferData uploads) are executed synchronously rather
+ * than copied.
+ */
+#define MARSHAL_MAX_CMD_SIZE (8 * 1024)
+
+/** Number of batches in the ring shared by the client and server threads. */
+#define MARSHAL_MAX_BATCHES 4
+
+/**
+ * Header of every marshalled command.
+ */
+struct marshal_cmd_base
+{
+   /** Type of the command, indexes the generated unmarshal table. */
+   uint16_t cmd_id;
+
+   /** Size of the command in bytes, including this header. */
+   uint16_t cmd_size;
+};
+
+struct glthread_batch
+{
+   /** Signalled when the server thread is done with the batch. */
+   struct util_queue_fence fence;
+
+   /** The context the commands are executed in. */
+   struct gl_context *ctx;
+
+   /** Number of bytes of \c buffer used by commands. */
+   size_t used;
+
+   /** Command storage, kept 8-byte aligned for the command structures. */
+   uint64_t buffer[MARSHAL_BATCH_SIZE / 8];
+};
+
+struct glthread_state
+{
+   /** Single-threaded queue executing the batches in order. */
+   struct util_queue queue;
+
+   /** Ring of batches; the client fills \c next while the server executes. */
+   struct glthread_batch batches[MARSHAL_MAX_BATCHES];
+   unsigned next;
+
+   /**
+    * Client-side tracking of the state that decides whether commands
+    * referencing client memory may be marshalled.  Only updated by the
+    * client thread.
+    */
+   /*@{*/
+   /** Whether any vertex array may have been set to a user pointer. */
+   bool has_client_arrays;
+
+   /** GL_ARRAY_BUFFER binding, as seen by the client thread. */
+   GLuint vertex_array_buffer;
+
+   /**
+    * GL_ELEMENT_ARRAY_BUFFER binding, as seen by the client thread.  This is
+    * per-VAO state, so binding a VAO resets it to 0 (unknown).
+    */
+   GLuint element_array_buffer;
+   /*@}*/
+};
+
+void
+_mesa_glthread_init(struct gl_context *ctx);
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx);
+
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx);
+
+void
+_mesa_glthread_finish(struct gl_context *ctx);
+
+void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer);
+
+void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers);
+
+void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint array);
+
+void
+_mesa_glthread_PopClientAttrib(struct gl_context *ctx);
+
+/* Defined in the generated marshal_generated.c. */
+struct _glapi_table *
+_mesa_create_marshal_table(const struct gl_context *ctx);
+
+size_t
+_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd);
+
+/**
+ * Reserve \p size bytes for a command in the batch being filled.  The
+ * command header is filled in, the caller fills in the rest.
+ */
+static inline void *
+_mesa_glthread_allocate_command(struct gl_context *ctx,
+                                uint16_t cmd_id,
+                                size_t size)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *next = &glthread->batches[glthread->next];
+   struct marshal_cmd_base *cmd_base;
+   const size_t aligned_size = ALIGN(size, 8);
+
+   assert(aligned_size <= MARSHAL_MAX_CMD_SIZE);
+
+   if (unlikely(next->used + aligned_size > MARSHAL_BATCH_SIZE)) {
+      _mesa_glthread_flush_batch(ctx);
+      next = &glthread->batches[glthread->next];
+   }
+
+   cmd_base = (struct marshal_cmd_base *)
+              ((uint8_t *) next->buffer + next->used);
+   next->used += aligned_size;
+   cmd_base->cmd_id = cmd_id;
+   cmd_base->cmd_size = aligned_size;
+   return cmd_base;
+}
+
+/**
+ * Point the calling thread back at the marshalling table after a call that
+ * was executed synchronously on the client thread.  A few entry points
+ * (e.g. glCallLists) rebind the dispatch table of the calling thread.
+ */
+static inline void
+_mesa_glthread_restore_dispatch(struct gl_context *ctx)
+{
+   if (_glapi_get_dispatch() != ctx->MarshalExec)
+      _glapi_set_dispatch(ctx->MarshalExec);
+}
+
+/**
+ * Whether a draw call may source vertices from client memory, in which
+ * case it has to be executed synchronously.  Core contexts can only source
+ * vertices from buffer objects.
+ */
+static inline bool
+_mesa_glthread_is_non_vbo_draw(const struct gl_context *ctx)
+{
+   return ctx->API != API_OPENGL_CORE && ctx->GLThread->has_client_arrays;
+}
+
+/**
+ * Like _mesa_glthread_is_non_vbo_draw(), but also checks whether the index
+ * pointer may point to client memory.
+ */
+static inline bool
+_mesa_glthread_is_non_vbo_draw_elements(const struct gl_context *ctx)
+{
+   return ctx->API != API_OPENGL_CORE &&
+          (ctx->GLThread->has_client_arrays ||
+           ctx->GLThread->element_array_buffer == 0);
+}
+
+/**
+ * Whether a gl*Pointer call may set up a vertex array with a user pointer.
+ */
+static inline bool
+_mesa_glthread_is_non_vbo_vertex_pointer(const struct gl_context *ctx)
+{
+   return ctx->API != API_OPENGL_CORE &&
+          ctx->GLThread->vertex_array_buffer == 0;
+}
+
+#endif /* GLTHREAD_H */
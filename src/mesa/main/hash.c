@@ -38,6 +38,7 @@
 #include "imports.h"
 #include "hash.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 /**
  * Magic GLuint object name that gets stored outside of the struct hash_table.
@@ -52,6 +53,27 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Keys below this are mirrored in a directly indexed array, so that looking
+ * them up doesn't need the mutex.  glGen*() hands out small keys, so this
+ * covers nearly all lookups.
+ */
+#define DIRECT_MAX_KEYS (1 << 16)
+#define DIRECT_MIN_KEYS 64
+
+/**
+ * Directly indexed copy of the entries with keys below \c Size.
+ *
+ * Only modified with the table mutex held.  When the array grows, the old
+ * one is linked from the new one and kept up to date until the table is
+ * deleted, since lock-free readers may still be looking at it.
+ */
+struct direct_array {
+   GLuint Size;
+   struct direct_array *Prev;
+   void **Data;
+};
+
 /**
  * The hash table data structure.  
  */
@@ -63,6 +85,8 @@ struct _mesa_HashTable {
    GLboolean InDeleteAll;                /**< Debug check */
    /** Value that would be in the table for DELETED_KEY_VALUE. */
    void *deleted_key_data;
+   /** Lock-free lookups of small keys, NULL until the first insertion. */
+   struct direct_array *direct;
 };
 
 /** @{
@@ -109,6 +133,63 @@ uint_key(GLuint id)
 }
 /** @} */
 
+
+/**
+ * Set the entry of \p key in the direct arrays, if they cover it.
+ * Must be called with the table mutex held.
+ */
+static void
+direct_set(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   struct direct_array *direct;
+
+   for (direct = table->direct; direct && key < direct->Size;
+        direct = direct->Prev)
+      p_atomic_set(&direct->Data[key], data);
+}
+
+
+/**
+ * Grow the direct array so that it covers \p key.  Must be called with the
+ * table mutex held.
+ */
+static void
+direct_grow(struct _mesa_HashTable *table, GLuint key)
+{
+   struct direct_array *old = table->direct;
+   struct direct_array *direct;
+   struct hash_entry *entry;
+   GLuint size = old ? old->Size : DIRECT_MIN_KEYS;
+
+   if (key >= DIRECT_MAX_KEYS)
+      return;
+
+   while (size <= key)
+      size *= 2;
+
+   direct = malloc(sizeof(*direct) + size * sizeof(void *));
+   if (!direct)
+      return;
+
+   direct->Size = size;
+   direct->Prev = old;
+   direct->Data = (void **) (direct + 1);
+   memset(direct->Data, 0, size * sizeof(void *));
+
+   hash_table_foreach(table->ht, entry) {
+      const GLuint k = (uintptr_t) entry->key;
+      if (k < size)
+         direct->Data[k] = entry->data;
+   }
+   direct->Data[DELETED_KEY_VALUE] = table->deleted_key_data;
+
+   /* Readers must see the contents of the array before the array. */
+#if defined(__GNUC__)
+   __sync_synchronize();
+#endif
+   p_atomic_set(&table->direct, direct);
+}
+
 /**
  * Create a new hash table.
  * 
@@ -160,6 +241,12 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   while (table->direct) {
+      struct direct_array *prev = table->direct->Prev;
+      free(table->direct);
+      table->direct = prev;
+   }
+
    mtx_destroy(&table->Mutex);
    mtx_destroy(&table->WalkMutex);
    free(table);
@@ -192,6 +279,10 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 
 /**
  * Lookup an entry in the hash table.
+ *
+ * Small keys are looked up in the direct array without locking.  The
+ * result is the same as if the lookup had been done under the mutex just
+ * before or after a concurrent insertion or removal of the key.
  * 
  * \param table the hash table.
  * \param key the key.
@@ -201,8 +292,14 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
+   const struct direct_array *direct;
    void *res;
    assert(table);
+
+   direct = p_atomic_read(&table->direct);
+   if (direct && key < direct->Size)
+      return p_atomic_read(&direct->Data[key]);
+
    mtx_lock(&table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    mtx_unlock(&table->Mutex);
@@ -270,6 +367,10 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
+   if (!table->direct || key >= table->direct->Size)
+      direct_grow(table, key);
+   direct_set(table, key, data);
+
    if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = data;
    } else {
@@ -344,6 +445,7 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
    }
 
    mtx_lock(&table->Mutex);
+   direct_set(table, key, NULL);
    if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = NULL;
    } else {
@@ -377,10 +479,12 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
    table->InDeleteAll = GL_TRUE;
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
+      direct_set(table, (uintptr_t)entry->key, NULL);
       _mesa_hash_table_remove(table->ht, entry);
    }
    if (table->deleted_key_data) {
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
+      direct_set(table, DELETED_KEY_VALUE, NULL);
       table->deleted_key_data = NULL;
    }
    table->InDeleteAll = GL_FALSE;
@@ -45,6 +45,7 @@
 #include "compiler/shader_enums.h"
 #include "main/formats.h"       /* MESA_FORMAT_COUNT */
 #include "compiler/glsl/list.h"
+#include "util/u_queue.h"
 
 
 #ifdef __cplusplus
@@ -80,13 +81,16 @@ struct gl_program_cache;
 struct gl_texture_object;
 struct gl_debug_state;
 struct gl_context;
+struct glthread_state;
 struct st_context;
 struct gl_uniform_storage;
 struct prog_instruction;
 struct gl_program_parameter_list;
 struct set;
 struct set_entry;
+struct hash_table;
 struct vbo_context;
+struct disk_cache;
 /*@}*/
 
 
@@ -2253,6 +2257,28 @@ struct gl_shader
    GLuint SourceChecksum;       /**< for debug/logging purposes */
    const GLchar *Source;  /**< Source code string */
 
+   /** SHA1 of the source and compile-affecting state, see ctx->Cache */
+   unsigned char sha1[20];
+
+   /**
+    * True if compilation was skipped because the shader was found in the
+    * on-disk shader cache.  Such a shader has no IR, and must be compiled
+    * for real if the linked program turns out not to be cached.
+    */
+   bool CompileSkipped;
+
+   /**
+    * \name GL_ARB_parallel_shader_compile
+    *
+    * A glCompileShader queued on the shader compiler threads signals
+    * \c CompileFence when done.  \c PendingLinks counts the queued
+    * glLinkProgram calls still reading this shader's IR.
+    */
+   /*@{*/
+   struct util_queue_fence CompileFence;
+   int PendingLinks;
+   /*@}*/
+
    struct gl_program *Program;  /**< Post-compile assembly code */
    GLchar *InfoLog;
 
@@ -2607,6 +2633,7 @@ struct gl_program_resource
    GLenum Type; /** Program interface type. */
    const void *Data; /** Pointer to resource associated data structure. */
    uint8_t StageReferences; /** Bitmask of shader stage references. */
+   GLuint Index; /** Index among the resources of the same type. */
 };
 
 /**
@@ -2803,6 +2830,19 @@ struct gl_shader_program
    GLboolean LinkStatus;   /**< GL_LINK_STATUS */
    GLboolean Validated;
    GLboolean _Used;        /**< Ever used for drawing? */
+
+   /**
+    * \name GL_ARB_parallel_shader_compile
+    *
+    * A glLinkProgram queued on the shader compiler threads signals
+    * \c LinkFence once the GLSL linker is done.  \c LinkPending stays set
+    * until the driver's LinkShader has run on the application thread.
+    */
+   /*@{*/
+   struct util_queue_fence LinkFence;
+   bool LinkPending;
+   /*@}*/
+
    GLboolean SamplersValidated; /**< Samplers validated against texture units? */
    GLchar *InfoLog;
 
@@ -2822,10 +2862,19 @@ struct gl_shader_program
    struct gl_program_resource *ProgramResourceList;
    unsigned NumProgramResourceList;
 
+   /**
+    * ProgramResourceList entries keyed by type and name, built by
+    * _mesa_create_program_resource_hash().
+    */
+   struct hash_table *ProgramResourceHash;
+
    /* True if any of the fragment shaders attached to this program use:
     * #extension ARB_fragment_coord_conventions: enable
     */
    GLboolean ARB_fragment_coord_conventions_enable;
+
+   /** SHA1 of the attached shaders and link-affecting state, see ctx->Cache */
+   unsigned char sha1[20];
 };   
 
 
@@ -4155,6 +4204,12 @@ struct gl_driver_flags
     * gl_context::TessCtrlProgram::patch_default_*
     */
    uint64_t NewDefaultTessLevels;
+
+   /**
+    * Uniform values of the programs used by each shader stage.  If 0,
+    * _NEW_PROGRAM_CONSTANTS is flagged instead.
+    */
+   uint64_t NewShaderConstants[MESA_SHADER_STAGES];
 };
 
 struct gl_uniform_buffer_binding
@@ -4287,8 +4342,17 @@ struct gl_context
     * re-set on glXMakeCurrent().
     */
    struct _glapi_table *CurrentDispatch;
+   /**
+    * Dispatch table used to marshal API calls from the client program to
+    * the glthread server thread.  NULL if API calls are not being marshalled
+    * to another thread.
+    */
+   struct _glapi_table *MarshalExec;
    /*@}*/
 
+   /** State of the GL API marshalling thread, NULL when it is disabled. */
+   struct glthread_state *GLThread;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
@@ -4415,6 +4479,23 @@ struct gl_context
     */
    struct gl_pipeline_object *_Shader;
 
+   /**
+    * On-disk cache of compiled shaders and linked programs, or NULL if the
+    * driver does not support it or it is disabled.
+    */
+   struct disk_cache *Cache;
+
+   /**
+    * \name GL_ARB_parallel_shader_compile
+    *
+    * Threads running glCompileShader and the GLSL linker part of
+    * glLinkProgram.  The queue is created on first use.
+    */
+   /*@{*/
+   GLuint MaxShaderCompilerThreads; /**< GL_MAX_SHADER_COMPILER_THREADS_ARB */
+   struct util_queue ShaderCompilerQueue;
+   /*@}*/
+
    struct gl_query_state Query;  /**< occlusion, timer queries */
 
    struct gl_transform_feedback_state TransformFeedback;
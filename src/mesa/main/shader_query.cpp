@@ -459,109 +459,246 @@ valid_array_index(const GLchar *name, unsigned *array_index)
    return true;
 }
 
+/**
+ * Key of gl_shader_program::ProgramResourceHash.  \c Name doesn't need to be
+ * NUL-terminated, so prefixes of a name can be looked up in place.
+ */
+struct program_resource_key {
+   GLenum Type;
+   const char *Name;
+   size_t Length;
+};
+
+static unsigned
+program_resource_key_hash(const void *key)
+{
+   const struct program_resource_key *k =
+      (const struct program_resource_key *) key;
+   unsigned hash = 5381 + k->Type;
+
+   for (size_t i = 0; i < k->Length; i++)
+      hash = (hash * 33) + k->Name[i];
+
+   return hash;
+}
+
+static int
+program_resource_key_compare(const void *a, const void *b)
+{
+   const struct program_resource_key *ka =
+      (const struct program_resource_key *) a;
+   const struct program_resource_key *kb =
+      (const struct program_resource_key *) b;
+
+   if (ka->Type != kb->Type || ka->Length != kb->Length)
+      return 1;
+
+   return memcmp(ka->Name, kb->Name, ka->Length);
+}
+
+/**
+ * Look up the first resource of \c programInterface whose name is exactly
+ * the first \c len characters of \c name.
+ */
+static struct gl_program_resource *
+search_program_resource_hash(struct gl_shader_program *shProg,
+                             GLenum programInterface, const char *name,
+                             size_t len)
+{
+   const struct program_resource_key key = { programInterface, name, len };
+
+   return (struct gl_program_resource *)
+      hash_table_find(shProg->ProgramResourceHash, &key);
+}
+
+/**
+ * Build the name lookup table used by _mesa_program_resource_find_name()
+ * and the per-interface indices returned by _mesa_program_resource_index().
+ *
+ * Must be called whenever the resource list has been (re)built.
+ */
+void
+_mesa_create_program_resource_hash(struct gl_shader_program *shProg)
+{
+   const unsigned num_resources = shProg->NumProgramResourceList;
+   struct {
+      GLenum Type;
+      GLuint Count;
+   } counts[32];
+   unsigned num_types = 0;
+
+   if (shProg->ProgramResourceHash) {
+      hash_table_dtor(shProg->ProgramResourceHash);
+      shProg->ProgramResourceHash = NULL;
+   }
+
+   /* The keys are freed along with the resource list. */
+   struct program_resource_key *keys = NULL;
+   if (num_resources > 0) {
+      keys = ralloc_array(shProg->ProgramResourceList,
+                          struct program_resource_key, num_resources);
+      if (!keys)
+         return;
+   }
+
+   shProg->ProgramResourceHash =
+      hash_table_ctor(num_resources, program_resource_key_hash,
+                      program_resource_key_compare);
+   if (!shProg->ProgramResourceHash)
+      return;
+
+   struct gl_program_resource *res = shProg->ProgramResourceList;
+   for (unsigned i = 0; i < num_resources; i++, res++) {
+      unsigned t;
+      for (t = 0; t < num_types; t++) {
+         if (counts[t].Type == res->Type)
+            break;
+      }
+
+      if (t == num_types) {
+         assert(num_types < ARRAY_SIZE(counts));
+         counts[num_types].Type = res->Type;
+         counts[num_types].Count = 0;
+         num_types++;
+      }
+
+      res->Index = counts[t].Count++;
+   }
+
+   /* The most recently inserted entry of a key is found first, insert in
+    * reverse so the first resource of a given name wins, like it would in a
+    * linear search of the list.
+    */
+   for (unsigned i = num_resources; i-- > 0; ) {
+      res = &shProg->ProgramResourceList[i];
+
+      /* Buffers are only looked up by index. */
+      if (res->Type == GL_ATOMIC_COUNTER_BUFFER ||
+          res->Type == GL_TRANSFORM_FEEDBACK_BUFFER)
+         continue;
+
+      keys[i].Type = res->Type;
+      keys[i].Name = _mesa_program_resource_name(res);
+      keys[i].Length = strlen(keys[i].Name);
+      hash_table_insert(shProg->ProgramResourceHash, res, &keys[i]);
+   }
+}
+
 /* Find a program resource with specific name in given interface.
+ *
+ * From ARB_program_interface_query spec:
+ *
+ * "uint GetProgramResourceIndex(uint program, enum programInterface,
+ *                               const char *name);
+ *  [...]
+ *  If <name> exactly matches the name string of one of the active
+ *  resources for <programInterface>, the index of the matched resource is
+ *  returned. Additionally, if <name> would exactly match the name string
+ *  of an active resource if "[0]" were appended to <name>, the index of
+ *  the matched resource is returned. [...]"
+ *
+ * "A string provided to GetProgramResourceLocation or
+ * GetProgramResourceLocationIndex is considered to match an active variable
+ * if:
+ *
+ *  * the string exactly matches the name of the active variable;
+ *
+ *  * if the string identifies the base name of an active array, where the
+ *    string would exactly match the name of the variable if the suffix
+ *    "[0]" were appended to the string; [...]"
+ *
+ * A resource therefore matches when its name is \c name itself, or a prefix
+ * of \c name that is followed by an array subscript or (for blocks and
+ * uniforms) a structure member.  Every such prefix is looked up in
+ * gl_shader_program::ProgramResourceHash, and the match coming first in the
+ * resource list is returned.
  */
 struct gl_program_resource *
 _mesa_program_resource_find_name(struct gl_shader_program *shProg,
                                  GLenum programInterface, const char *name,
                                  unsigned *array_index)
 {
-   struct gl_program_resource *res = shProg->ProgramResourceList;
-   for (unsigned i = 0; i < shProg->NumProgramResourceList; i++, res++) {
-      if (res->Type != programInterface)
-         continue;
+   if (!shProg->ProgramResourceHash)
+      return NULL;
 
-      /* Resource basename. */
-      const char *rname = _mesa_program_resource_name(res);
-      unsigned baselen = strlen(rname);
-      unsigned baselen_without_array_index = baselen;
-      const char *rname_last_square_bracket = strrchr(rname, '[');
-      bool found = false;
-      bool rname_has_array_index_zero = false;
-      /* From ARB_program_interface_query spec:
-       *
-       * "uint GetProgramResourceIndex(uint program, enum programInterface,
-       *                               const char *name);
-       *  [...]
-       *  If <name> exactly matches the name string of one of the active
-       *  resources for <programInterface>, the index of the matched resource is
-       *  returned. Additionally, if <name> would exactly match the name string
-       *  of an active resource if "[0]" were appended to <name>, the index of
-       *  the matched resource is returned. [...]"
-       *
-       * "A string provided to GetProgramResourceLocation or
-       * GetProgramResourceLocationIndex is considered to match an active variable
-       * if:
-       *
-       *  * the string exactly matches the name of the active variable;
-       *
-       *  * if the string identifies the base name of an active array, where the
-       *    string would exactly match the name of the variable if the suffix
-       *    "[0]" were appended to the string; [...]"
-       */
-      /* Remove array's index from interface block name comparison only if
-       * array's index is zero and the resulting string length is the same
-       * than the provided name's length.
-       */
-      if (rname_last_square_bracket) {
-         baselen_without_array_index -= strlen(rname_last_square_bracket);
-         rname_has_array_index_zero =
-            (strncmp(rname_last_square_bracket, "[0]\0", 4) == 0) &&
-            (baselen_without_array_index == strlen(name));
+   bool is_block = false, allow_member = false;
+   switch (programInterface) {
+   case GL_UNIFORM_BLOCK:
+   case GL_SHADER_STORAGE_BLOCK:
+      is_block = true;
+      allow_member = true;
+      break;
+   case GL_TRANSFORM_FEEDBACK_VARYING:
+   case GL_BUFFER_VARIABLE:
+   case GL_UNIFORM:
+   case GL_VERTEX_SUBROUTINE_UNIFORM:
+   case GL_GEOMETRY_SUBROUTINE_UNIFORM:
+   case GL_FRAGMENT_SUBROUTINE_UNIFORM:
+   case GL_COMPUTE_SUBROUTINE_UNIFORM:
+   case GL_TESS_CONTROL_SUBROUTINE_UNIFORM:
+   case GL_TESS_EVALUATION_SUBROUTINE_UNIFORM:
+   case GL_VERTEX_SUBROUTINE:
+   case GL_GEOMETRY_SUBROUTINE:
+   case GL_FRAGMENT_SUBROUTINE:
+   case GL_COMPUTE_SUBROUTINE:
+   case GL_TESS_CONTROL_SUBROUTINE:
+   case GL_TESS_EVALUATION_SUBROUTINE:
+      allow_member = true;
+      break;
+   case GL_PROGRAM_INPUT:
+   case GL_PROGRAM_OUTPUT:
+      break;
+   default:
+      assert(!"not implemented for given interface");
+      return NULL;
+   }
+
+   const size_t len = strlen(name);
+   struct gl_program_resource *found =
+      search_program_resource_hash(shProg, programInterface, name, len);
+   bool found_array_element = false;
+
+   /* A block array is named after its first element. */
+   if (is_block) {
+      char *element_name = (char *) malloc(len + 4);
+      if (element_name) {
+         memcpy(element_name, name, len);
+         memcpy(element_name + len, "[0]", 4);
+
+         struct gl_program_resource *res =
+            search_program_resource_hash(shProg, programInterface,
+                                         element_name, len + 3);
+         if (res && (!found || res < found))
+            found = res;
+         free(element_name);
       }
+   }
 
-      if (strncmp(rname, name, baselen) == 0)
-         found = true;
-      else if (rname_has_array_index_zero &&
-               strncmp(rname, name, baselen_without_array_index) == 0)
-         found = true;
-
-      if (found) {
-         switch (programInterface) {
-         case GL_UNIFORM_BLOCK:
-         case GL_SHADER_STORAGE_BLOCK:
-            /* Basename match, check if array or struct. */
-            if (rname_has_array_index_zero ||
-                name[baselen] == '\0' ||
-                name[baselen] == '[' ||
-                name[baselen] == '.') {
-               return res;
-            }
-            break;
-         case GL_TRANSFORM_FEEDBACK_VARYING:
-         case GL_BUFFER_VARIABLE:
-         case GL_UNIFORM:
-         case GL_VERTEX_SUBROUTINE_UNIFORM:
-         case GL_GEOMETRY_SUBROUTINE_UNIFORM:
-         case GL_FRAGMENT_SUBROUTINE_UNIFORM:
-         case GL_COMPUTE_SUBROUTINE_UNIFORM:
-         case GL_TESS_CONTROL_SUBROUTINE_UNIFORM:
-         case GL_TESS_EVALUATION_SUBROUTINE_UNIFORM:
-         case GL_VERTEX_SUBROUTINE:
-         case GL_GEOMETRY_SUBROUTINE:
-         case GL_FRAGMENT_SUBROUTINE:
-         case GL_COMPUTE_SUBROUTINE:
-         case GL_TESS_CONTROL_SUBROUTINE:
-         case GL_TESS_EVALUATION_SUBROUTINE:
-            if (name[baselen] == '.') {
-               return res;
-            }
-            /* fall-through */
-         case GL_PROGRAM_INPUT:
-         case GL_PROGRAM_OUTPUT:
-            if (name[baselen] == '\0') {
-               return res;
-            } else if (name[baselen] == '[' &&
-                valid_array_index(name, array_index)) {
-               return res;
-            }
-            break;
-         default:
-            assert(!"not implemented for given interface");
-         }
+   /* Only an array subscript at the very end of the name is checked. */
+   bool valid_index = false;
+   if (!is_block)
+      valid_index = valid_array_index(name, NULL);
+
+   for (size_t i = 0; i < len; i++) {
+      if (name[i] == '[') {
+         if (!is_block && !valid_index)
+            continue;
+      } else if (name[i] != '.' || !allow_member) {
+         continue;
+      }
+
+      struct gl_program_resource *res =
+         search_program_resource_hash(shProg, programInterface, name, i);
+      if (res && (!found || res < found)) {
+         found = res;
+         found_array_element = !is_block && name[i] == '[';
       }
    }
-   return NULL;
+
+   if (found_array_element)
+      valid_array_index(name, array_index);
+
+   return found;
 }
 
 static GLuint
@@ -604,6 +741,8 @@ _mesa_program_resource_index(struct gl_shader_program *shProg,
    case GL_TRANSFORM_FEEDBACK_BUFFER:
    case GL_TRANSFORM_FEEDBACK_VARYING:
    default:
+      if (shProg->ProgramResourceHash)
+         return res->Index;
       return calc_resource_index(shProg, res);
    }
 }
@@ -40,9 +40,11 @@
 #include <stdbool.h>
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/debug_output.h"
 #include "main/dispatch.h"
 #include "main/enums.h"
 #include "main/hash.h"
+#include "main/macros.h"
 #include "main/mtypes.h"
 #include "main/pipelineobj.h"
 #include "main/shaderapi.h"
@@ -59,6 +61,17 @@
 #include "util/ralloc.h"
 #include "util/hash_table.h"
 #include "util/mesa-sha1.h"
+#include "util/u_atomic.h"
+#include "util/u_queue.h"
+
+#ifdef HAVE_PTHREAD
+#include <unistd.h>
+#endif
+
+/**
+ * Most threads GL_ARB_parallel_shader_compile will start per context.
+ */
+#define MAX_SHADER_COMPILER_THREADS 16
 
 
 /**
@@ -126,6 +139,9 @@ _mesa_init_shader_state(struct gl_context *ctx)
    ctx->Shader.RefCount = 1;
    mtx_init(&ctx->Shader.Mutex, mtx_plain);
 
+   /* GL_ARB_parallel_shader_compile: use as many threads as there are CPUs. */
+   ctx->MaxShaderCompilerThreads = 0xffffffff;
+
    ctx->TessCtrlProgram.patch_vertices = 3;
    for (i = 0; i < 4; ++i)
       ctx->TessCtrlProgram.patch_default_outer_level[i] = 1.0;
@@ -141,6 +157,9 @@ void
 _mesa_free_shader_state(struct gl_context *ctx)
 {
    int i;
+
+   _mesa_destroy_shader_compiler_queue(ctx);
+
    for (i = 0; i < MESA_SHADER_STAGES; i++) {
       _mesa_reference_shader_program(ctx, &ctx->Shader.CurrentProgram[i],
                                      NULL);
@@ -581,8 +600,20 @@ static void
 get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
               GLint *params)
 {
-   struct gl_shader_program *shProg
-      = _mesa_lookup_shader_program_err(ctx, program, "glGetProgramiv(program)");
+   struct gl_shader_program *shProg;
+
+   /* Unlike every other query, this one mustn't wait for the link. */
+   if (pname == GL_COMPLETION_STATUS_ARB &&
+       _mesa_has_ARB_parallel_shader_compile(ctx)) {
+      shProg = _mesa_lookup_shader_program_err_nowait(ctx, program,
+                                                      "glGetProgramiv(program)");
+      if (shProg)
+         *params = util_queue_fence_is_signalled(&shProg->LinkFence);
+      return;
+   }
+
+   shProg = _mesa_lookup_shader_program_err(ctx, program,
+                                            "glGetProgramiv(program)");
 
    /* Is transform feedback available in this context?
     */
@@ -832,9 +863,18 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
 static void
 get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
 {
-   struct gl_shader *shader =
-      _mesa_lookup_shader_err(ctx, name, "glGetShaderiv");
+   struct gl_shader *shader;
+
+   /* Unlike every other query, this one mustn't wait for the compile. */
+   if (pname == GL_COMPLETION_STATUS_ARB &&
+       _mesa_has_ARB_parallel_shader_compile(ctx)) {
+      shader = _mesa_lookup_shader_err_nowait(ctx, name, "glGetShaderiv");
+      if (shader)
+         *params = util_queue_fence_is_signalled(&shader->CompileFence);
+      return;
+   }
 
+   shader = _mesa_lookup_shader_err(ctx, name, "glGetShaderiv");
    if (!shader) {
       return;
    }
@@ -957,6 +997,10 @@ shader_source(struct gl_shader *sh, const GLchar *source)
 
 /**
  * Compile a shader.
+ *
+ * This may run on a shader compiler thread, so it looks at the flags of
+ * ctx->Shader rather than ctx->_Shader, which the application thread can
+ * rebind.  All pipeline objects get the same flags.
  */
 void
 _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
@@ -970,7 +1014,7 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
        */
       sh->CompileStatus = GL_FALSE;
    } else {
-      if (ctx->_Shader->Flags & GLSL_DUMP) {
+      if (ctx->Shader.Flags & GLSL_DUMP) {
          _mesa_log("GLSL source for %s shader %d:\n",
                  _mesa_shader_stage_to_string(sh->Stage), sh->Name);
          _mesa_log("%s\n", sh->Source);
@@ -979,13 +1023,13 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
       /* this call will set the shader->CompileStatus field to indicate if
        * compilation was successful.
        */
-      _mesa_glsl_compile_shader(ctx, sh, false, false);
+      _mesa_glsl_compile_shader(ctx, sh, false, false, false);
 
-      if (ctx->_Shader->Flags & GLSL_LOG) {
+      if (ctx->Shader.Flags & GLSL_LOG) {
          _mesa_write_shader_to_file(sh);
       }
 
-      if (ctx->_Shader->Flags & GLSL_DUMP) {
+      if (ctx->Shader.Flags & GLSL_DUMP) {
          if (sh->CompileStatus) {
             _mesa_log("GLSL IR for shader %d:\n", sh->Name);
             _mesa_print_ir(_mesa_get_log_file(), sh->ir, NULL);
@@ -1001,14 +1045,14 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
    }
 
    if (!sh->CompileStatus) {
-      if (ctx->_Shader->Flags & GLSL_DUMP_ON_ERROR) {
+      if (ctx->Shader.Flags & GLSL_DUMP_ON_ERROR) {
          _mesa_log("GLSL source for %s shader %d:\n",
                  _mesa_shader_stage_to_string(sh->Stage), sh->Name);
          _mesa_log("%s\n", sh->Source);
          _mesa_log("Info Log:\n%s\n", sh->InfoLog);
       }
 
-      if (ctx->_Shader->Flags & GLSL_REPORT_ERRORS) {
+      if (ctx->Shader.Flags & GLSL_REPORT_ERRORS) {
          _mesa_debug(ctx, "Error compiling shader %u:\n%s\n",
                      sh->Name, sh->InfoLog);
       }
@@ -1017,29 +1061,190 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
 
 
 /**
- * Link a program's shaders.
+ * \name GL_ARB_parallel_shader_compile
+ *
+ * glCompileShader and the GLSL linker part of glLinkProgram can run on a
+ * queue of shader compiler threads.  Looking up a shader or program by name
+ * waits for its job to finish, and for a program runs the rest of the link
+ * on the application thread, since the driver's LinkShader is not thread
+ * safe.  So apart from GL_COMPLETION_STATUS_ARB, nothing can see a shader or
+ * program while its job is running.
+ *
+ * Linking only reads the IR of the attached shaders, except when a stage
+ * has several shaders.  Such programs are linked synchronously, and
+ * recompiling a shader waits for the queued links still reading it.
+ */
+/*@{*/
+
+struct shader_compiler_job
+{
+   struct gl_context *ctx;
+   struct gl_shader *shader;          /**< for glCompileShader */
+   struct gl_shader_program *prog;    /**< for glLinkProgram */
+};
+
+
+/**
+ * Return the shader compiler queue, or NULL if shaders have to be compiled
+ * and linked synchronously.
+ */
+static struct util_queue *
+get_shader_compiler_queue(struct gl_context *ctx)
+{
+   struct util_queue *queue = &ctx->ShaderCompilerQueue;
+
+   if (ctx->MaxShaderCompilerThreads == 0)
+      return NULL;
+
+   /* Keep the output of MESA_GLSL=dump and log in order. */
+   if (ctx->Shader.Flags & (GLSL_DUMP | GLSL_LOG))
+      return NULL;
+
+   /* Synchronous debug output has to reach the application on the thread
+    * that called glCompileShader.
+    */
+   if (ctx->Debug &&
+       _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB))
+      return NULL;
+
+   if (!util_queue_is_initialized(queue)) {
+#if defined(HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+      unsigned num_threads = MIN2(ctx->MaxShaderCompilerThreads,
+                                  MAX_SHADER_COMPILER_THREADS);
+
+      if (ctx->MaxShaderCompilerThreads == 0xffffffff) {
+         long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+         if (num_cpus < 2)
+            return NULL;
+
+         num_threads = MIN2(num_cpus, num_threads);
+      }
+
+      if (!util_queue_init(queue, "glsl", 256, num_threads))
+         return NULL;
+#else
+      return NULL;
+#endif
+   }
+
+   return queue;
+}
+
+
+static void
+wait_shader_object_cb(GLuint id, void *data, void *userData)
+{
+   struct gl_shader *sh = (struct gl_shader *) data;
+
+   if (sh->Type == GL_SHADER_PROGRAM_MESA) {
+      struct gl_shader_program *shProg = (struct gl_shader_program *) data;
+      util_queue_job_wait(&shProg->LinkFence);
+   } else {
+      util_queue_job_wait(&sh->CompileFence);
+   }
+}
+
+
+/**
+ * Wait for all the jobs queued on the shader compiler threads.
+ */
+static void
+wait_shader_compiler_jobs(struct gl_context *ctx)
+{
+   _mesa_HashWalk(ctx->Shared->ShaderObjects, wait_shader_object_cb, ctx);
+}
+
+
+/**
+ * Wait until no queued glLinkProgram is reading the IR of \p sh anymore.
+ */
+static void
+wait_shader_links(struct gl_context *ctx, struct gl_shader *sh)
+{
+   if (p_atomic_read(&sh->PendingLinks) != 0)
+      wait_shader_compiler_jobs(ctx);
+}
+
+
+/**
+ * Wait for the queued jobs, and stop the shader compiler threads.
  */
 void
-_mesa_link_program(struct gl_context *ctx, struct gl_shader_program *shProg)
+_mesa_destroy_shader_compiler_queue(struct gl_context *ctx)
 {
-   if (!shProg)
+   if (!util_queue_is_initialized(&ctx->ShaderCompilerQueue))
       return;
 
-   /* From the ARB_transform_feedback2 specification:
-    * "The error INVALID_OPERATION is generated by LinkProgram if <program> is
-    *  the name of a program being used by one or more transform feedback
-    *  objects, even if the objects are not currently bound or are paused."
+   wait_shader_compiler_jobs(ctx);
+   util_queue_destroy(&ctx->ShaderCompilerQueue);
+   memset(&ctx->ShaderCompilerQueue, 0, sizeof(ctx->ShaderCompilerQueue));
+}
+
+
+static void
+compile_shader_job(void *data, int thread_index)
+{
+   struct shader_compiler_job *job = (struct shader_compiler_job *) data;
+
+   _mesa_compile_shader(job->ctx, job->shader);
+   free(job);
+}
+
+
+static void
+link_program_job(void *data, int thread_index)
+{
+   struct shader_compiler_job *job = (struct shader_compiler_job *) data;
+   struct gl_shader_program *shProg = job->prog;
+   unsigned i;
+
+   _mesa_glsl_link_shader_ir(job->ctx, shProg);
+
+   for (i = 0; i < shProg->NumShaders; i++)
+      p_atomic_dec(&shProg->Shaders[i]->PendingLinks);
+
+   free(job);
+}
+
+
+/**
+ * Can the GLSL linker part of linking \p shProg run on a shader compiler
+ * thread?
+ */
+static bool
+can_queue_link(const struct gl_shader_program *shProg)
+{
+   unsigned stages = 0;
+   unsigned i;
+
+   /* The application thread may be drawing with an earlier executable. */
+   for (i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (shProg->_LinkedShaders[i])
+         return false;
+   }
+
+   /* Cross validation of the globals of several shaders of the same stage
+    * writes to their IR.
     */
-   if (_mesa_transform_feedback_is_using_program(ctx, shProg)) {
-      _mesa_error(ctx, GL_INVALID_OPERATION,
-                  "glLinkProgram(transform feedback is using the program)");
-      return;
+   for (i = 0; i < shProg->NumShaders; i++) {
+      const unsigned bit = 1 << shProg->Shaders[i]->Stage;
+
+      if (stages & bit)
+         return false;
+      stages |= bit;
    }
 
-   FLUSH_VERTICES(ctx, _NEW_PROGRAM);
+   return true;
+}
+
+
+/*@}*/
 
-   _mesa_glsl_link_shader(ctx, shProg);
 
+static void
+link_program_done(struct gl_context *ctx, struct gl_shader_program *shProg)
+{
    if (shProg->LinkStatus == GL_FALSE &&
        (ctx->_Shader->Flags & GLSL_REPORT_ERRORS)) {
       _mesa_debug(ctx, "Error linking program %u:\n%s\n",
@@ -1063,6 +1268,88 @@ _mesa_link_program(struct gl_context *ctx, struct gl_shader_program *shProg)
 }
 
 
+static void
+link_program(struct gl_context *ctx, struct gl_shader_program *shProg,
+             struct util_queue *queue)
+{
+   struct shader_compiler_job *job = NULL;
+   unsigned i;
+
+   if (!shProg)
+      return;
+
+   /* From the ARB_transform_feedback2 specification:
+    * "The error INVALID_OPERATION is generated by LinkProgram if <program> is
+    *  the name of a program being used by one or more transform feedback
+    *  objects, even if the objects are not currently bound or are paused."
+    */
+   if (_mesa_transform_feedback_is_using_program(ctx, shProg)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glLinkProgram(transform feedback is using the program)");
+      return;
+   }
+
+   FLUSH_VERTICES(ctx, _NEW_PROGRAM);
+
+   for (i = 0; i < shProg->NumShaders; i++)
+      util_queue_job_wait(&shProg->Shaders[i]->CompileFence);
+
+   if (queue && can_queue_link(shProg))
+      job = MALLOC_STRUCT(shader_compiler_job);
+
+   if (job) {
+      if (_mesa_glsl_link_shader_begin(ctx, shProg)) {
+         job->ctx = ctx;
+         job->shader = NULL;
+         job->prog = shProg;
+
+         for (i = 0; i < shProg->NumShaders; i++)
+            p_atomic_inc(&shProg->Shaders[i]->PendingLinks);
+
+         shProg->LinkPending = true;
+         util_queue_add_job(queue, job, &shProg->LinkFence, link_program_job);
+         return;
+      }
+      free(job);
+   } else {
+      for (i = 0; i < shProg->NumShaders; i++)
+         wait_shader_links(ctx, shProg->Shaders[i]);
+
+      _mesa_glsl_link_shader(ctx, shProg);
+   }
+
+   link_program_done(ctx, shProg);
+}
+
+
+/**
+ * Link a program's shaders.
+ */
+void
+_mesa_link_program(struct gl_context *ctx, struct gl_shader_program *shProg)
+{
+   link_program(ctx, shProg, NULL);
+}
+
+
+/**
+ * Finish a glLinkProgram which was queued on the shader compiler threads.
+ */
+void
+_mesa_finish_link_program(struct gl_context *ctx,
+                          struct gl_shader_program *shProg)
+{
+   util_queue_job_wait(&shProg->LinkFence);
+
+   if (!shProg->LinkPending)
+      return;
+
+   shProg->LinkPending = false;
+   _mesa_glsl_link_shader_end(ctx, shProg);
+   link_program_done(ctx, shProg);
+}
+
+
 /**
  * Print basic shader info (for debug).
  */
@@ -1260,11 +1547,32 @@ _mesa_AttachShader(GLuint program, GLuint shader)
 void GLAPIENTRY
 _mesa_CompileShader(GLuint shaderObj)
 {
+   struct gl_shader *sh;
+   struct util_queue *queue;
+   struct shader_compiler_job *job = NULL;
+
    GET_CURRENT_CONTEXT(ctx);
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glCompileShader %u\n", shaderObj);
-   _mesa_compile_shader(ctx, _mesa_lookup_shader_err(ctx, shaderObj,
-                                                     "glCompileShader"));
+
+   sh = _mesa_lookup_shader_err(ctx, shaderObj, "glCompileShader");
+   if (!sh)
+      return;
+
+   wait_shader_links(ctx, sh);
+
+   queue = get_shader_compiler_queue(ctx);
+   if (queue)
+      job = MALLOC_STRUCT(shader_compiler_job);
+
+   if (job) {
+      job->ctx = ctx;
+      job->shader = sh;
+      job->prog = NULL;
+      util_queue_add_job(queue, job, &sh->CompileFence, compile_shader_job);
+   } else {
+      _mesa_compile_shader(ctx, sh);
+   }
 }
 
 
@@ -1511,8 +1819,28 @@ _mesa_LinkProgram(GLuint programObj)
    GET_CURRENT_CONTEXT(ctx);
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glLinkProgram %u\n", programObj);
-   _mesa_link_program(ctx, _mesa_lookup_shader_program_err(ctx, programObj,
-                                                           "glLinkProgram"));
+   link_program(ctx, _mesa_lookup_shader_program_err(ctx, programObj,
+                                                     "glLinkProgram"),
+                get_shader_compiler_queue(ctx));
+}
+
+
+/**
+ * Called via glMaxShaderCompilerThreadsARB().
+ */
+void GLAPIENTRY
+_mesa_MaxShaderCompilerThreadsARB(GLuint count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   if (MESA_VERBOSE & VERBOSE_API)
+      _mesa_debug(ctx, "glMaxShaderCompilerThreadsARB %u\n", count);
+
+   if (count == ctx->MaxShaderCompilerThreads)
+      return;
+
+   /* A util_queue can't be resized: start a new one on the next compile. */
+   _mesa_destroy_shader_compiler_queue(ctx);
+   ctx->MaxShaderCompilerThreads = count;
 }
 
 #if defined(HAVE_SHA1)
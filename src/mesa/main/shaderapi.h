@@ -60,6 +60,13 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh);
 extern void
 _mesa_link_program(struct gl_context *ctx, struct gl_shader_program *sh_prog);
 
+extern void
+_mesa_finish_link_program(struct gl_context *ctx,
+                          struct gl_shader_program *shProg);
+
+extern void
+_mesa_destroy_shader_compiler_queue(struct gl_context *ctx);
+
 extern unsigned
 _mesa_count_active_attribs(struct gl_shader_program *shProg);
 
@@ -236,6 +243,9 @@ extern GLuint
 _mesa_program_resource_index(struct gl_shader_program *shProg,
                              struct gl_program_resource *res);
 
+extern void
+_mesa_create_program_resource_hash(struct gl_shader_program *shProg);
+
 extern struct gl_program_resource *
 _mesa_program_resource_find_name(struct gl_shader_program *shProg,
                                  GLenum programInterface, const char *name,
@@ -319,6 +329,10 @@ extern GLvoid GLAPIENTRY
 _mesa_GetProgramStageiv(GLuint program, GLenum shadertype,
                         GLenum pname, GLint *values);
 
+/* GL_ARB_parallel_shader_compile */
+extern void GLAPIENTRY
+_mesa_MaxShaderCompilerThreadsARB(GLuint count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -92,6 +92,7 @@ void
 _mesa_init_shader(struct gl_context *ctx, struct gl_shader *shader)
 {
    shader->RefCount = 1;
+   util_queue_fence_init(&shader->CompileFence);
 }
 
 /**
@@ -120,6 +121,9 @@ _mesa_new_shader(struct gl_context *ctx, GLuint name, GLenum type)
 void
 _mesa_delete_shader(struct gl_context *ctx, struct gl_shader *sh)
 {
+   util_queue_job_wait(&sh->CompileFence);
+   util_queue_fence_destroy(&sh->CompileFence);
+
    free((void *)sh->Source);
    free(sh->Label);
    _mesa_reference_program(ctx, &sh->Program, NULL);
@@ -143,6 +147,9 @@ _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
       if (sh && sh->Type == GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (sh) {
+         util_queue_job_wait(&sh->CompileFence);
+      }
       return sh;
    }
    return NULL;
@@ -154,6 +161,22 @@ _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
  */
 struct gl_shader *
 _mesa_lookup_shader_err(struct gl_context *ctx, GLuint name, const char *caller)
+{
+   struct gl_shader *sh = _mesa_lookup_shader_err_nowait(ctx, name, caller);
+   if (sh) {
+      util_queue_job_wait(&sh->CompileFence);
+   }
+   return sh;
+}
+
+
+/**
+ * As above, but don't wait for a glCompileShader still running on the
+ * shader compiler threads.
+ */
+struct gl_shader *
+_mesa_lookup_shader_err_nowait(struct gl_context *ctx, GLuint name,
+                               const char *caller)
 {
    if (!name) {
       _mesa_error(ctx, GL_INVALID_VALUE, "%s", caller);
@@ -227,6 +250,7 @@ init_shader_program(struct gl_shader_program *prog)
 {
    prog->Type = GL_SHADER_PROGRAM_MESA;
    prog->RefCount = 1;
+   util_queue_fence_init(&prog->LinkFence);
 
    prog->AttributeBindings = string_to_uint_map_ctor();
    prog->FragDataBindings = string_to_uint_map_ctor();
@@ -309,6 +333,11 @@ _mesa_clear_shader_program_data(struct gl_shader_program *shProg)
       shProg->ProgramResourceList = NULL;
       shProg->NumProgramResourceList = 0;
    }
+
+   if (shProg->ProgramResourceHash) {
+      hash_table_dtor(shProg->ProgramResourceHash);
+      shProg->ProgramResourceHash = NULL;
+   }
 }
 
 
@@ -325,6 +354,9 @@ _mesa_free_shader_program_data(struct gl_context *ctx,
 
    assert(shProg->Type == GL_SHADER_PROGRAM_MESA);
 
+   util_queue_job_wait(&shProg->LinkFence);
+   shProg->LinkPending = false;
+
    _mesa_clear_shader_program_data(shProg);
 
    if (shProg->AttributeBindings) {
@@ -380,6 +412,7 @@ _mesa_delete_shader_program(struct gl_context *ctx,
                             struct gl_shader_program *shProg)
 {
    _mesa_free_shader_program_data(ctx, shProg);
+   util_queue_fence_destroy(&shProg->LinkFence);
 
    ralloc_free(shProg);
 }
@@ -402,6 +435,9 @@ _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
       if (shProg && shProg->Type != GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (shProg) {
+         _mesa_finish_link_program(ctx, shProg);
+      }
       return shProg;
    }
    return NULL;
@@ -414,6 +450,23 @@ _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
 struct gl_shader_program *
 _mesa_lookup_shader_program_err(struct gl_context *ctx, GLuint name,
                                 const char *caller)
+{
+   struct gl_shader_program *shProg =
+      _mesa_lookup_shader_program_err_nowait(ctx, name, caller);
+   if (shProg) {
+      _mesa_finish_link_program(ctx, shProg);
+   }
+   return shProg;
+}
+
+
+/**
+ * As above, but don't wait for a glLinkProgram still running on the shader
+ * compiler threads.
+ */
+struct gl_shader_program *
+_mesa_lookup_shader_program_err_nowait(struct gl_context *ctx, GLuint name,
+                                       const char *caller)
 {
    if (!name) {
       _mesa_error(ctx, GL_INVALID_VALUE, "%s", caller);
@@ -59,6 +59,10 @@ _mesa_lookup_shader(struct gl_context *ctx, GLuint name);
 extern struct gl_shader *
 _mesa_lookup_shader_err(struct gl_context *ctx, GLuint name, const char *caller);
 
+extern struct gl_shader *
+_mesa_lookup_shader_err_nowait(struct gl_context *ctx, GLuint name,
+                               const char *caller);
+
 
 
 extern void
@@ -92,6 +96,10 @@ extern struct gl_shader_program *
 _mesa_lookup_shader_program_err(struct gl_context *ctx, GLuint name,
                                 const char *caller);
 
+extern struct gl_shader_program *
+_mesa_lookup_shader_program_err_nowait(struct gl_context *ctx, GLuint name,
+                                       const char *caller);
+
 extern struct gl_shader_program *
 _mesa_new_shader_program(GLuint name);
 
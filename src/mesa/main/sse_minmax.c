@@ -28,67 +28,240 @@
 #include "main/sse_minmax.h"
 #include <smmintrin.h>
 #include <stdint.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
-void
-_mesa_uint_array_min_max(const unsigned *ui_indices, unsigned *min_index,
-                         unsigned *max_index, const unsigned count)
+/* The vector loop works on 256-bit registers when built for AVX2 and on
+ * 128-bit ones otherwise.
+ */
+#ifdef __AVX2__
+#define VEC_SIZE 32
+typedef __m256i vec;
+#define vec_load(p)             _mm256_load_si256((const __m256i *)(p))
+#define vec_store(p, v)         _mm256_store_si256((__m256i *)(p), v)
+#define vec_zero()              _mm256_setzero_si256()
+#define vec_ones()              _mm256_set1_epi32(~0)
+#define vec_or(a, b)            _mm256_or_si256(a, b)
+#define vec_andnot(a, b)        _mm256_andnot_si256(a, b)
+#define vec_set1_8(x)           _mm256_set1_epi8(x)
+#define vec_set1_16(x)          _mm256_set1_epi16(x)
+#define vec_set1_32(x)          _mm256_set1_epi32(x)
+#define vec_cmpeq_8(a, b)       _mm256_cmpeq_epi8(a, b)
+#define vec_cmpeq_16(a, b)      _mm256_cmpeq_epi16(a, b)
+#define vec_cmpeq_32(a, b)      _mm256_cmpeq_epi32(a, b)
+#define vec_min_8(a, b)         _mm256_min_epu8(a, b)
+#define vec_min_16(a, b)        _mm256_min_epu16(a, b)
+#define vec_min_32(a, b)        _mm256_min_epu32(a, b)
+#define vec_max_8(a, b)         _mm256_max_epu8(a, b)
+#define vec_max_16(a, b)        _mm256_max_epu16(a, b)
+#define vec_max_32(a, b)        _mm256_max_epu32(a, b)
+#else
+#define VEC_SIZE 16
+typedef __m128i vec;
+#define vec_load(p)             _mm_load_si128((const __m128i *)(p))
+#define vec_store(p, v)         _mm_store_si128((__m128i *)(p), v)
+#define vec_zero()              _mm_setzero_si128()
+#define vec_ones()              _mm_set1_epi32(~0)
+#define vec_or(a, b)            _mm_or_si128(a, b)
+#define vec_andnot(a, b)        _mm_andnot_si128(a, b)
+#define vec_set1_8(x)           _mm_set1_epi8(x)
+#define vec_set1_16(x)          _mm_set1_epi16(x)
+#define vec_set1_32(x)          _mm_set1_epi32(x)
+#define vec_cmpeq_8(a, b)       _mm_cmpeq_epi8(a, b)
+#define vec_cmpeq_16(a, b)      _mm_cmpeq_epi16(a, b)
+#define vec_cmpeq_32(a, b)      _mm_cmpeq_epi32(a, b)
+#define vec_min_8(a, b)         _mm_min_epu8(a, b)
+#define vec_min_16(a, b)        _mm_min_epu16(a, b)
+#define vec_min_32(a, b)        _mm_min_epu32(a, b)
+#define vec_max_8(a, b)         _mm_max_epu8(a, b)
+#define vec_max_16(a, b)        _mm_max_epu16(a, b)
+#define vec_max_32(a, b)        _mm_max_epu32(a, b)
+#endif
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+static ALWAYS_INLINE unsigned
+read_index(const uint8_t *p, unsigned index_size)
 {
-   unsigned max_ui = 0;
-   unsigned min_ui = ~0U;
-   unsigned i = 0;
-   unsigned aligned_count = count;
-
-   /* handle the first few values without SSE until the pointer is aligned */
-   while (((uintptr_t)ui_indices & 15) && aligned_count) {
-      if (*ui_indices > max_ui)
-         max_ui = *ui_indices;
-      if (*ui_indices < min_ui)
-         min_ui = *ui_indices;
-
-      aligned_count--;
-      ui_indices++;
+   switch (index_size) {
+   case 1:
+      return *p;
+   case 2:
+      return *(const uint16_t *)p;
+   default:
+      return *(const uint32_t *)p;
    }
+}
 
-   /* TODO: The actual threshold for SSE begin useful may be higher than 8.
-    * Some careful microbenchmarks and measurement are required to
-    * find the actual tipping point.
-    */
-   if (aligned_count >= 8) {
-      unsigned max_arr[4] __attribute__ ((aligned (16)));
-      unsigned min_arr[4] __attribute__ ((aligned (16)));
-      unsigned vec_count;
-      __m128i max_ui4 = _mm_setzero_si128();
-      __m128i min_ui4 = _mm_set1_epi32(~0U);
-      __m128i ui_indices4;
-      __m128i *ui_indices_ptr;
-
-      vec_count = aligned_count & ~0x3;
-      ui_indices_ptr = (__m128i *)ui_indices;
-      for (i = 0; i < vec_count / 4; i++) {
-         ui_indices4 = _mm_load_si128(&ui_indices_ptr[i]);
-         max_ui4 = _mm_max_epu32(ui_indices4, max_ui4);
-         min_ui4 = _mm_min_epu32(ui_indices4, min_ui4);
+static ALWAYS_INLINE vec
+vec_set1(unsigned x, unsigned index_size)
+{
+   switch (index_size) {
+   case 1:
+      return vec_set1_8(x);
+   case 2:
+      return vec_set1_16(x);
+   default:
+      return vec_set1_32(x);
+   }
+}
+
+static ALWAYS_INLINE vec
+vec_cmpeq(vec a, vec b, unsigned index_size)
+{
+   switch (index_size) {
+   case 1:
+      return vec_cmpeq_8(a, b);
+   case 2:
+      return vec_cmpeq_16(a, b);
+   default:
+      return vec_cmpeq_32(a, b);
+   }
+}
+
+static ALWAYS_INLINE vec
+vec_min(vec a, vec b, unsigned index_size)
+{
+   switch (index_size) {
+   case 1:
+      return vec_min_8(a, b);
+   case 2:
+      return vec_min_16(a, b);
+   default:
+      return vec_min_32(a, b);
+   }
+}
+
+static ALWAYS_INLINE vec
+vec_max(vec a, vec b, unsigned index_size)
+{
+   switch (index_size) {
+   case 1:
+      return vec_max_8(a, b);
+   case 2:
+      return vec_max_16(a, b);
+   default:
+      return vec_max_32(a, b);
+   }
+}
+
+/**
+ * Computes the min and max of an index array, skipping the restart index
+ * if \p restart is set.  If there's no index to look at, min is ~0 and max
+ * is 0, like the scalar loops in vbo_minmax_index.c.
+ */
+static ALWAYS_INLINE void
+array_min_max(const void *indices, unsigned index_size, unsigned count,
+              bool restart, unsigned restart_index,
+              unsigned *min_index, unsigned *max_index)
+{
+   const uint8_t *p = indices;
+   const unsigned type_max = ~0U >> (32 - 8 * index_size);
+   const unsigned per_vec = VEC_SIZE / index_size;
+   unsigned max = 0;
+   unsigned min = ~0U;
+   unsigned i;
+
+   /* A restart index outside of the type's range never matches. */
+   if (restart_index > type_max)
+      restart = false;
+
+   /* handle the first few values without SIMD until the pointer is aligned */
+   while (((uintptr_t)p & (VEC_SIZE - 1)) && count) {
+      const unsigned index = read_index(p, index_size);
+
+      if (!restart || index != restart_index) {
+         if (index > max)
+            max = index;
+         if (index < min)
+            min = index;
       }
 
-      _mm_store_si128((__m128i *)max_arr, max_ui4);
-      _mm_store_si128((__m128i *)min_arr, min_ui4);
+      p += index_size;
+      count--;
+   }
+
+   if (count >= 2 * per_vec) {
+      uint8_t max_arr[VEC_SIZE] __attribute__ ((aligned (VEC_SIZE)));
+      uint8_t min_arr[VEC_SIZE] __attribute__ ((aligned (VEC_SIZE)));
+      const vec restart_vec = vec_set1(restart_index, index_size);
+      vec max_vec = vec_zero();
+      vec min_vec = vec_ones();
+
+      for (; count >= per_vec; count -= per_vec, p += VEC_SIZE) {
+         const vec v = vec_load(p);
 
-      for (i = 0; i < 4; i++) {
-         if (max_arr[i] > max_ui)
-            max_ui = max_arr[i];
-         if (min_arr[i] < min_ui)
-            min_ui = min_arr[i];
+         if (restart) {
+            /* Restart lanes become 0 for max and all ones for min. */
+            const vec is_restart = vec_cmpeq(v, restart_vec, index_size);
+
+            max_vec = vec_max(max_vec, vec_andnot(is_restart, v), index_size);
+            min_vec = vec_min(min_vec, vec_or(v, is_restart), index_size);
+         } else {
+            max_vec = vec_max(max_vec, v, index_size);
+            min_vec = vec_min(min_vec, v, index_size);
+         }
+      }
+
+      vec_store(max_arr, max_vec);
+      vec_store(min_arr, min_vec);
+
+      for (i = 0; i < VEC_SIZE; i += index_size) {
+         const unsigned lane_max = read_index(&max_arr[i], index_size);
+         const unsigned lane_min = read_index(&min_arr[i], index_size);
+
+         if (lane_max > max)
+            max = lane_max;
+         if (lane_min < min)
+            min = lane_min;
       }
-      i = vec_count;
    }
 
-   for (; i < aligned_count; i++) {
-      if (ui_indices[i] > max_ui)
-         max_ui = ui_indices[i];
-      if (ui_indices[i] < min_ui)
-         min_ui = ui_indices[i];
+   for (; count; count--, p += index_size) {
+      const unsigned index = read_index(p, index_size);
+
+      if (!restart || index != restart_index) {
+         if (index > max)
+            max = index;
+         if (index < min)
+            min = index;
+      }
    }
 
-   *min_index = min_ui;
-   *max_index = max_ui;
+   /* Unused vector lanes leave type_max in min.  If every index was a
+    * restart index, report the same as the scalar path.
+    */
+   if (min > max)
+      min = ~0U;
+
+   *min_index = min;
+   *max_index = max;
+}
+
+void
+_mesa_uint_array_min_max(const unsigned *ui_indices, unsigned *min_index,
+                         unsigned *max_index, const unsigned count,
+                         bool restart, unsigned restart_index)
+{
+   array_min_max(ui_indices, 4, count, restart, restart_index,
+                 min_index, max_index);
+}
+
+void
+_mesa_ushort_array_min_max(const uint16_t *us_indices, unsigned *min_index,
+                           unsigned *max_index, const unsigned count,
+                           bool restart, unsigned restart_index)
+{
+   array_min_max(us_indices, 2, count, restart, restart_index,
+                 min_index, max_index);
+}
+
+void
+_mesa_ubyte_array_min_max(const uint8_t *ub_indices, unsigned *min_index,
+                          unsigned *max_index, const unsigned count,
+                          bool restart, unsigned restart_index)
+{
+   array_min_max(ub_indices, 1, count, restart, restart_index,
+                 min_index, max_index);
 }
@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "main/format_utils.h"
+#include <smmintrin.h>
+#include <stdint.h>
+
+/**
+ * Swizzles \p count pixels of 4 ubyte channels, four pixels at a time with
+ * PSHUFB.  The \p swizzle values are the ones of _mesa_swizzle_and_convert():
+ * 0-3 select a source channel, MESA_FORMAT_SWIZZLE_ONE writes \p one and
+ * anything else writes 0.
+ */
+void
+_mesa_swizzle_ubyte4_sse41(uint8_t *dst, const uint8_t *src,
+                           const uint8_t swizzle[4], uint8_t one, int count)
+{
+   uint8_t shuffle[16], ones[16];
+   __m128i shuffle_mask, ones_mask;
+   int i, c;
+
+   for (i = 0; i < 4; i++) {
+      for (c = 0; c < 4; c++) {
+         /* PSHUFB writes 0 for indices with the top bit set. */
+         shuffle[i * 4 + c] = swizzle[c] < 4 ? i * 4 + swizzle[c] : 0x80;
+         ones[i * 4 + c] = swizzle[c] == MESA_FORMAT_SWIZZLE_ONE ? one : 0;
+      }
+   }
+
+   shuffle_mask = _mm_loadu_si128((const __m128i *) shuffle);
+   ones_mask = _mm_loadu_si128((const __m128i *) ones);
+
+   for (; count >= 4; count -= 4) {
+      __m128i pixels = _mm_loadu_si128((const __m128i *) src);
+
+      pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle_mask),
+                            ones_mask);
+      _mm_storeu_si128((__m128i *) dst, pixels);
+
+      src += 16;
+      dst += 16;
+   }
+
+   for (; count > 0; count--) {
+      uint8_t pixel[4];
+
+      for (c = 0; c < 4; c++)
+         pixel[c] = swizzle[c] < 4 ? src[swizzle[c]] : ones[c];
+
+      memcpy(dst, pixel, 4);
+      src += 4;
+      dst += 4;
+   }
+}
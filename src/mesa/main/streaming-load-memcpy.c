@@ -29,9 +29,13 @@
 #include "main/macros.h"
 #include "main/streaming-load-memcpy.h"
 #include <smmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 /* Copies memory from src to dst, using SSE 4.1's MOVNTDQA to get streaming
- * read performance from uncached memory.
+ * read performance from uncached memory.  When built for AVX2, the aligned
+ * part is read 32 bytes at a time with the wider VMOVNTDQA.
  */
 void
 _mesa_streaming_load_memcpy(void *restrict dst, void *restrict src, size_t len)
@@ -62,6 +66,37 @@ _mesa_streaming_load_memcpy(void *restrict dst, void *restrict src, size_t len)
    if (len >= 64)
       _mm_mfence();
 
+#ifdef __AVX2__
+   /* Align to a 32-byte boundary, if the two are co-aligned that far. */
+   if (((uintptr_t)d & 31) == ((uintptr_t)s & 31)) {
+      if (((uintptr_t)d & 31) && len >= 16) {
+         _mm_store_si128((__m128i *)d, _mm_stream_load_si128((__m128i *)s));
+         d += 16;
+         s += 16;
+         len -= 16;
+      }
+
+      while (len >= 128) {
+         __m256i *dst_cacheline = (__m256i *)d;
+         __m256i *src_cacheline = (__m256i *)s;
+
+         __m256i temp1 = _mm256_stream_load_si256(src_cacheline + 0);
+         __m256i temp2 = _mm256_stream_load_si256(src_cacheline + 1);
+         __m256i temp3 = _mm256_stream_load_si256(src_cacheline + 2);
+         __m256i temp4 = _mm256_stream_load_si256(src_cacheline + 3);
+
+         _mm256_store_si256(dst_cacheline + 0, temp1);
+         _mm256_store_si256(dst_cacheline + 1, temp2);
+         _mm256_store_si256(dst_cacheline + 2, temp3);
+         _mm256_store_si256(dst_cacheline + 3, temp4);
+
+         d += 128;
+         s += 128;
+         len -= 128;
+      }
+   }
+#endif
+
    while (len >= 64) {
       __m128i *dst_cacheline = (__m128i *)d;
       __m128i *src_cacheline = (__m128i *)s;
@@ -26,8 +26,36 @@
  *
  */
 
+#ifndef STREAMING_LOAD_MEMCPY_H
+#define STREAMING_LOAD_MEMCPY_H
+
+#include <stddef.h>
+#include <string.h>
+
+#include "c99_compat.h"
+#include "x86/common_x86_asm.h"
+
 /* Copies memory from src to dst, using SSE 4.1's MOVNTDQA to get streaming
  * read performance from uncached memory.
  */
 void
 _mesa_streaming_load_memcpy(void *restrict dst, void *restrict src, size_t len);
+
+/**
+ * Copies memory that was mapped for reading from a write-combined or
+ * uncached buffer.  Uses _mesa_streaming_load_memcpy() when the CPU
+ * supports it, and is a plain memcpy() otherwise.
+ */
+static inline void
+_mesa_memcpy_from_uncached(void *restrict dst, void *restrict src, size_t len)
+{
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1) {
+      _mesa_streaming_load_memcpy(dst, src, len);
+      return;
+   }
+#endif
+   memcpy(dst, src, len);
+}
+
+#endif /* STREAMING_LOAD_MEMCPY_H */
@@ -946,6 +946,9 @@ const struct function common_desktop_functions_possible[] = {
    /* GL_GREMEDY_string_marker */
    { "glStringMarkerGREMEDY", 15, -1 },
 
+   /* GL_ARB_parallel_shader_compile */
+   { "glMaxShaderCompilerThreadsARB", 11, -1 },
+
    { NULL, 0, -1 }
 };
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \name get_integerv.cpp
+ *
+ * Check the values returned by the glGetIntegerv() fast paths, and report
+ * the cost of a call with and without them.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "GL/gl.h"
+#include "GL/glext.h"
+#include "main/compiler.h"
+#include "main/context.h"
+#include "main/mtypes.h"
+#include "glapi/glapi.h"
+#include "drivers/common/driverfuncs.h"
+#include "vbo/vbo.h"
+
+extern "C" {
+#include "main/get.h"
+}
+
+class GetIntegerv_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   double ns_per_call(GLenum pname);
+
+   struct gl_config visual;
+   struct dd_function_table driver_functions;
+   struct gl_context ctx;
+};
+
+void
+GetIntegerv_test::SetUp()
+{
+   memset(&visual, 0, sizeof(visual));
+   memset(&driver_functions, 0, sizeof(driver_functions));
+   memset(&ctx, 0, sizeof(ctx));
+
+   _mesa_init_driver_functions(&driver_functions);
+   _mesa_initialize_context(&ctx, API_OPENGL_COMPAT, &visual, NULL,
+                            &driver_functions);
+   _vbo_CreateContext(&ctx);
+   ctx.Version = 30;
+
+   _glapi_set_context(&ctx);
+}
+
+void
+GetIntegerv_test::TearDown()
+{
+   _glapi_set_context(NULL);
+}
+
+double
+GetIntegerv_test::ns_per_call(GLenum pname)
+{
+   const unsigned iterations = 1000000;
+   GLint value;
+   clock_t start = clock();
+
+   for (unsigned i = 0; i < iterations; i++)
+      _mesa_GetIntegerv(pname, &value);
+
+   return (double) (clock() - start) * 1e9 / CLOCKS_PER_SEC / iterations;
+}
+
+TEST_F(GetIntegerv_test, FastPathValues)
+{
+   GLint value;
+
+   ctx.Pack.Alignment = 2;
+   ctx.Unpack.Alignment = 8;
+   ctx.Texture.CurrentUnit = 3;
+
+   _mesa_GetIntegerv(GL_PACK_ALIGNMENT, &value);
+   EXPECT_EQ(2, value);
+   _mesa_GetIntegerv(GL_UNPACK_ALIGNMENT, &value);
+   EXPECT_EQ(8, value);
+   _mesa_GetIntegerv(GL_ACTIVE_TEXTURE, &value);
+   EXPECT_EQ(GL_TEXTURE3, value);
+   _mesa_GetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+   EXPECT_EQ(0, value);
+   _mesa_GetIntegerv(GL_ARRAY_BUFFER_BINDING, &value);
+   EXPECT_EQ(0, value);
+   _mesa_GetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &value);
+   EXPECT_EQ(0, value);
+   _mesa_GetIntegerv(GL_CURRENT_PROGRAM, &value);
+   EXPECT_EQ(0, value);
+   _mesa_GetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
+   EXPECT_EQ(1 << (ctx.Const.MaxTextureLevels - 1), value);
+}
+
+/**
+ * Not a real test: prints the cost of a query answered by the fast path
+ * next to one going through the generic hash lookup, to keep track of it.
+ */
+TEST_F(GetIntegerv_test, CallCost)
+{
+   printf("glGetIntegerv(GL_ARRAY_BUFFER_BINDING): %.1f ns/call\n",
+          ns_per_call(GL_ARRAY_BUFFER_BINDING));
+   printf("glGetIntegerv(GL_TEXTURE_BINDING_2D): %.1f ns/call\n",
+          ns_per_call(GL_TEXTURE_BINDING_2D));
+   printf("glGetIntegerv(GL_STENCIL_CLEAR_VALUE): %.1f ns/call\n",
+          ns_per_call(GL_STENCIL_CLEAR_VALUE));
+}
@@ -43,7 +43,9 @@
 #include "texstore.h"
 #include "macros.h"
 #include "format_unpack.h"
+#include "format_utils.h"
 #include "util/format_srgb.h"
+#include "util/u_queue.h"
 
 
 struct etc2_block {
@@ -114,6 +116,11 @@ _mesa_texstore_etc1_rgb8(TEXSTORE_PARAMS)
 }
 
 
+static void
+etc_unpack(uint8_t *dst_row, unsigned dst_stride,
+           const uint8_t *src_row, unsigned src_stride,
+           unsigned width, unsigned height, mesa_format format);
+
 /**
  * Decode texture data in format `MESA_FORMAT_ETC1_RGB8` to
  * `MESA_FORMAT_ABGR8888`.
@@ -141,9 +148,8 @@ _mesa_etc1_unpack_rgba8888(uint8_t *dst_row,
                            unsigned src_width,
                            unsigned src_height)
 {
-   etc1_unpack_rgba8888(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
+   etc_unpack(dst_row, dst_stride, src_row, src_stride,
+              src_width, src_height, MESA_FORMAT_ETC1_RGB8);
 }
 
 static uint8_t
@@ -1207,7 +1213,28 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
                          unsigned src_height,
                          mesa_format format)
 {
-   if (format == MESA_FORMAT_ETC2_RGB8)
+   etc_unpack(dst_row, dst_stride, src_row, src_stride,
+              src_width, src_height, format);
+}
+
+
+/**
+ * Decode the rows of an ETC1 or ETC2 image, on the calling thread.
+ */
+static void
+etc_unpack_rows(uint8_t *dst_row,
+                unsigned dst_stride,
+                const uint8_t *src_row,
+                unsigned src_stride,
+                unsigned src_width,
+                unsigned src_height,
+                mesa_format format)
+{
+   if (format == MESA_FORMAT_ETC1_RGB8)
+      etc1_unpack_rgba8888(dst_row, dst_stride,
+                           src_row, src_stride,
+                           src_width, src_height);
+   else if (format == MESA_FORMAT_ETC2_RGB8)
       etc2_unpack_rgb8(dst_row, dst_stride,
                        src_row, src_stride,
                        src_width, src_height);
@@ -1250,6 +1277,94 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
 }
 
 
+/**
+ * Images with fewer pixels are decoded on the calling thread only.
+ */
+#define ETC_UNPACK_MIN_THREADED_PIXELS (1024 * 1024)
+
+/** Largest number of bands a single image is split into. */
+#define ETC_UNPACK_MAX_JOBS 8
+
+struct etc_unpack_job {
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned width;
+   unsigned height;
+   mesa_format format;
+   struct util_queue_fence fence;
+};
+
+static void
+etc_unpack_execute(void *data, int thread_index)
+{
+   struct etc_unpack_job *job = data;
+
+   etc_unpack_rows(job->dst_row, job->dst_stride,
+                   job->src_row, job->src_stride,
+                   job->width, job->height, job->format);
+}
+
+/**
+ * Decode an ETC1 or ETC2 image.  Blocks don't depend on each other, so large
+ * images are split into bands of block rows decoded in parallel, which keeps
+ * the ETC emulation of drivers without native support from stalling uploads.
+ */
+static void
+etc_unpack(uint8_t *dst_row, unsigned dst_stride,
+           const uint8_t *src_row, unsigned src_stride,
+           unsigned width, unsigned height, mesa_format format)
+{
+   const unsigned bh = 4;
+   const unsigned block_rows = DIV_ROUND_UP(height, bh);
+   struct etc_unpack_job jobs[ETC_UNPACK_MAX_JOBS];
+   struct util_queue *queue = NULL;
+   unsigned num_jobs, block_rows_per_job, i;
+
+   if ((size_t) width * height >= ETC_UNPACK_MIN_THREADED_PIXELS)
+      queue = _mesa_get_format_convert_queue();
+
+   if (!queue) {
+      etc_unpack_rows(dst_row, dst_stride, src_row, src_stride,
+                      width, height, format);
+      return;
+   }
+
+   /* The first band is decoded by the calling thread while the queue works
+    * on the others.
+    */
+   num_jobs = MIN3(queue->num_threads + 1, ETC_UNPACK_MAX_JOBS, block_rows);
+   block_rows_per_job = DIV_ROUND_UP(block_rows, num_jobs);
+   num_jobs = DIV_ROUND_UP(block_rows, block_rows_per_job);
+
+   for (i = 0; i < num_jobs; i++) {
+      struct etc_unpack_job *job = &jobs[i];
+      unsigned y = i * block_rows_per_job * bh;
+
+      job->dst_row = dst_row + (size_t) y * dst_stride;
+      job->dst_stride = dst_stride;
+      job->src_row = src_row + (size_t) (y / bh) * src_stride;
+      job->src_stride = src_stride;
+      job->width = width;
+      job->height = MIN2(block_rows_per_job * bh, height - y);
+      job->format = format;
+
+      if (i > 0) {
+         util_queue_fence_init(&job->fence);
+         util_queue_add_job(queue, job, &job->fence, etc_unpack_execute);
+      }
+   }
+
+   etc_unpack_execute(&jobs[0], 0);
+
+   for (i = 1; i < num_jobs; i++) {
+      util_queue_job_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+}
+
+
 
 static void
 fetch_etc1_rgb8(const GLubyte *map,
@@ -537,6 +537,44 @@ log_program_parameters(const struct gl_shader_program *shProg)
  *                     the array to be propagated.
  * \param count        Number of array elements to propagate.
  */
+/**
+ * Flush the vertices and flag the state of the constant buffers which have
+ * to be reuploaded after a change of \c uni.
+ *
+ * Drivers setting gl_driver_flags::NewShaderConstants are only notified
+ * about the stages using the uniform, everything else gets
+ * _NEW_PROGRAM_CONSTANTS.
+ */
+static void
+flush_vertices_for_uniforms(struct gl_context *ctx,
+                            const struct gl_uniform_storage *uni)
+{
+   uint64_t new_driver_state = 0;
+
+   /* Opaque uniforms change bindings rather than constant buffers. */
+   if (!uni->type->contains_opaque()) {
+      for (int i = 0; i < MESA_SHADER_STAGES; i++) {
+         if (!(uni->active_shader_mask & (1 << i)))
+            continue;
+
+         if (!ctx->DriverFlags.NewShaderConstants[i]) {
+            new_driver_state = 0;
+            break;
+         }
+
+         new_driver_state |= ctx->DriverFlags.NewShaderConstants[i];
+      }
+   }
+
+   if (!new_driver_state) {
+      FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
+      return;
+   }
+
+   FLUSH_VERTICES(ctx, 0);
+   ctx->NewDriverState |= new_driver_state;
+}
+
 extern "C" void
 _mesa_propagate_uniforms_to_driver_storage(struct gl_uniform_storage *uni,
 					   unsigned array_index,
@@ -577,6 +615,13 @@ _mesa_propagate_uniforms_to_driver_storage(struct gl_uniform_storage *uni,
 	 unsigned j;
 	 unsigned v;
 
+	 /* Tightly packed driver storage is updated with a single copy. */
+	 if (store->vector_stride == src_vector_byte_stride &&
+	     extra_stride == 0) {
+	    memcpy(dst, src, src_vector_byte_stride * vectors * count);
+	    break;
+	 }
+
 	 for (j = 0; j < count; j++) {
 	    for (v = 0; v < vectors; v++) {
 	       memcpy(dst, src, src_vector_byte_stride);
@@ -793,13 +838,22 @@ _mesa_uniform(struct gl_context *ctx, struct gl_shader_program *shProg,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
-   FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
+   /* Setting a uniform to its current value is common, skip the flush and
+    * the reupload of the constant buffers then.
+    */
+   const unsigned size = sizeof(uni->storage[0]) * components * count *
+                         size_mul;
+   if (!uni->type->is_boolean() && !uni->type->contains_opaque() &&
+       memcmp(&uni->storage[size_mul * components * offset], values,
+              size) == 0)
+      return;
+
+   flush_vertices_for_uniforms(ctx, uni);
 
    /* Store the data in the "actual type" backing storage for the uniform.
     */
    if (!uni->type->is_boolean()) {
-      memcpy(&uni->storage[size_mul * components * offset], values,
-	     sizeof(uni->storage[0]) * components * count * size_mul);
+      memcpy(&uni->storage[size_mul * components * offset], values, size);
    } else {
       const union gl_constant_value *src =
 	 (const union gl_constant_value *) values;
@@ -986,21 +1040,28 @@ _mesa_uniform_matrix(struct gl_context *ctx, struct gl_shader_program *shProg,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
-   FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
-
    /* Store the data in the "actual type" backing storage for the uniform.
     */
    elements = components * vectors;
 
    if (!transpose) {
-      memcpy(&uni->storage[elements * offset], values,
-	     sizeof(uni->storage[0]) * elements * count * size_mul);
+      const unsigned size = sizeof(uni->storage[0]) * elements * count *
+                            size_mul;
+
+      /* Skip the flush and the reupload for unchanged values. */
+      if (memcmp(&uni->storage[elements * offset], values, size) == 0)
+         return;
+
+      flush_vertices_for_uniforms(ctx, uni);
+      memcpy(&uni->storage[elements * offset], values, size);
    } else if (basicType == GLSL_TYPE_FLOAT) {
       /* Copy and transpose the matrix.
        */
       const float *src = (const float *)values;
       float *dst = &uni->storage[elements * offset].f;
 
+      flush_vertices_for_uniforms(ctx, uni);
+
       for (int i = 0; i < count; i++) {
 	 for (unsigned r = 0; r < rows; r++) {
 	    for (unsigned c = 0; c < cols; c++) {
@@ -1016,6 +1077,8 @@ _mesa_uniform_matrix(struct gl_context *ctx, struct gl_shader_program *shProg,
       const double *src = (const double *)values;
       double *dst = (double *)&uni->storage[elements * offset].f;
 
+      flush_vertices_for_uniforms(ctx, uni);
+
       for (int i = 0; i < count; i++) {
 	 for (unsigned r = 0; r < rows; r++) {
 	    for (unsigned c = 0; c < cols; c++) {
@@ -46,6 +46,7 @@
 #include "compiler/glsl_types.h"
 #include "compiler/glsl/linker.h"
 #include "compiler/glsl/program.h"
+#include "compiler/glsl/shader_cache.h"
 #include "program/hash_table.h"
 #include "program/prog_instruction.h"
 #include "program/prog_optimize.h"
@@ -2980,11 +2981,31 @@ _mesa_ir_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
    return prog->LinkStatus;
 }
 
+static void
+dump_link_result(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   if (ctx->_Shader->Flags & GLSL_DUMP) {
+      if (!prog->LinkStatus) {
+	 fprintf(stderr, "GLSL shader program %d failed to link\n", prog->Name);
+      }
+
+      if (prog->InfoLog && prog->InfoLog[0] != 0) {
+	 fprintf(stderr, "GLSL shader program %d info log:\n", prog->Name);
+	 fprintf(stderr, "%s\n", prog->InfoLog);
+      }
+   }
+}
+
 /**
- * Link a GLSL shader program.  Called via glLinkProgram().
+ * First step of linking a GLSL shader program: reset the program, and
+ * restore it from the shader cache if possible.
+ *
+ * Returns true if the program still has to go through
+ * _mesa_glsl_link_shader_ir() and _mesa_glsl_link_shader_end().
  */
-void
-_mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
+bool
+_mesa_glsl_link_shader_begin(struct gl_context *ctx,
+                             struct gl_shader_program *prog)
 {
    unsigned int i;
 
@@ -2998,25 +3019,75 @@ _mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
       }
    }
 
-   if (prog->LinkStatus) {
-      link_shaders(ctx, prog);
+   if (prog->LinkStatus && ctx->Cache) {
+      shader_cache_compute_program_sha1(ctx, prog);
+      if (shader_cache_read_program_metadata(ctx, prog)) {
+         dump_link_result(ctx, prog);
+         return false;
+      }
+
+      /* Not in the cache: any shader whose compile was skipped has to be
+       * compiled for real before it can be linked.
+       */
+      for (i = 0; i < prog->NumShaders; i++) {
+         if (prog->Shaders[i]->CompileSkipped) {
+            _mesa_glsl_compile_shader(ctx, prog->Shaders[i], false, false,
+                                      true);
+            if (!prog->Shaders[i]->CompileStatus)
+               linker_error(prog, "linking with uncompiled shader");
+         }
+      }
    }
 
+   if (!prog->LinkStatus) {
+      dump_link_result(ctx, prog);
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * Run the GLSL linker.  This doesn't call into the driver, so it may run on
+ * a shader compiler thread, see GL_ARB_parallel_shader_compile.
+ */
+void
+_mesa_glsl_link_shader_ir(struct gl_context *ctx,
+                          struct gl_shader_program *prog)
+{
+   link_shaders(ctx, prog);
+}
+
+/**
+ * Last step of linking a GLSL shader program: let the driver compile the
+ * linked shaders, and store the result in the shader cache.
+ */
+void
+_mesa_glsl_link_shader_end(struct gl_context *ctx,
+                           struct gl_shader_program *prog)
+{
    if (prog->LinkStatus) {
       if (!ctx->Driver.LinkShader(ctx, prog)) {
 	 prog->LinkStatus = GL_FALSE;
       }
    }
 
-   if (ctx->_Shader->Flags & GLSL_DUMP) {
-      if (!prog->LinkStatus) {
-	 fprintf(stderr, "GLSL shader program %d failed to link\n", prog->Name);
-      }
+   if (prog->LinkStatus && ctx->Cache) {
+      shader_cache_write_program_metadata(ctx, prog);
+   }
 
-      if (prog->InfoLog && prog->InfoLog[0] != 0) {
-	 fprintf(stderr, "GLSL shader program %d info log:\n", prog->Name);
-	 fprintf(stderr, "%s\n", prog->InfoLog);
-      }
+   dump_link_result(ctx, prog);
+}
+
+/**
+ * Link a GLSL shader program.  Called via glLinkProgram().
+ */
+void
+_mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   if (_mesa_glsl_link_shader_begin(ctx, prog)) {
+      _mesa_glsl_link_shader_ir(ctx, prog);
+      _mesa_glsl_link_shader_end(ctx, prog);
    }
 }
 
@@ -32,76 +32,47 @@
 #include "main/shaderobj.h"
 #include "program/prog_cache.h"
 #include "program/program.h"
+#include "util/hash_table.h"
+
+
+/**
+ * The cache is cleared instead of growing past this many programs.
+ */
+#define PROG_CACHE_MAX_ITEMS 1500
 
 
 struct cache_item
 {
-   GLuint hash;
-   unsigned keysize;
-   void *key;
+   GLuint keysize;
+   const void *key;
    struct gl_program *program;
-   struct cache_item *next;
 };
 
 struct gl_program_cache
 {
-   struct cache_item **items;
+   struct hash_table *ht;
    struct cache_item *last;
-   GLuint size, n_items;
 };
 
 
 
-/**
- * Compute hash index from state key.
- */
-static GLuint
-hash_key(const void *key, GLuint key_size)
+static uint32_t
+cache_item_hash(const void *item)
 {
-   const GLuint *ikey = (const GLuint *) key;
-   GLuint hash = 0, i;
-
-   assert(key_size >= 4);
-
-   /* Make a slightly better attempt at a hash function:
-    */
-   for (i = 0; i < key_size / sizeof(*ikey); i++)
-   {
-      hash += ikey[i];
-      hash += (hash << 10);
-      hash ^= (hash >> 6);
-   }
+   const struct cache_item *c = (const struct cache_item *) item;
 
-   return hash;
+   return _mesa_hash_data(c->key, c->keysize);
 }
 
 
-/**
- * Rebuild/expand the hash table to accommodate more entries
- */
-static void
-rehash(struct gl_program_cache *cache)
+static bool
+cache_item_equal(const void *a, const void *b)
 {
-   struct cache_item **items;
-   struct cache_item *c, *next;
-   GLuint size, i;
-
-   cache->last = NULL;
+   const struct cache_item *ca = (const struct cache_item *) a;
+   const struct cache_item *cb = (const struct cache_item *) b;
 
-   size = cache->size * 3;
-   items = malloc(size * sizeof(*items));
-   memset(items, 0, size * sizeof(*items));
-
-   for (i = 0; i < cache->size; i++)
-      for (c = cache->items[i]; c; c = next) {
-	 next = c->next;
-	 c->next = items[c->hash % size];
-	 items[c->hash % size] = c;
-      }
-
-   free(cache->items);
-   cache->items = items;
-   cache->size = size;
+   return ca->keysize == cb->keysize &&
+          memcmp(ca->key, cb->key, ca->keysize) == 0;
 }
 
 
@@ -109,29 +80,24 @@ static void
 clear_cache(struct gl_context *ctx, struct gl_program_cache *cache,
 	    GLboolean shader)
 {
-   struct cache_item *c, *next;
-   GLuint i;
-   
+   struct hash_entry *entry;
+
    cache->last = NULL;
 
-   for (i = 0; i < cache->size; i++) {
-      for (c = cache->items[i]; c; c = next) {
-	 next = c->next;
-	 free(c->key);
-	 if (shader) {
-	    _mesa_reference_shader_program(ctx,
-					   (struct gl_shader_program **)&c->program,
-					   NULL);
-	 } else {
-	    _mesa_reference_program(ctx, &c->program, NULL);
-	 }
-	 free(c);
+   hash_table_foreach(cache->ht, entry) {
+      struct cache_item *c = (struct cache_item *) entry->key;
+
+      if (shader) {
+         _mesa_reference_shader_program(ctx,
+                                        (struct gl_shader_program **)&c->program,
+                                        NULL);
+      } else {
+         _mesa_reference_program(ctx, &c->program, NULL);
       }
-      cache->items[i] = NULL;
+      free(c);
    }
 
-
-   cache->n_items = 0;
+   _mesa_hash_table_clear(cache->ht, NULL);
 }
 
 
@@ -141,10 +107,9 @@ _mesa_new_program_cache(void)
 {
    struct gl_program_cache *cache = CALLOC_STRUCT(gl_program_cache);
    if (cache) {
-      cache->size = 17;
-      cache->items =
-         calloc(cache->size, sizeof(struct cache_item *));
-      if (!cache->items) {
+      cache->ht = _mesa_hash_table_create(NULL, cache_item_hash,
+                                          cache_item_equal);
+      if (!cache->ht) {
          free(cache);
          return NULL;
       }
@@ -157,7 +122,7 @@ void
 _mesa_delete_program_cache(struct gl_context *ctx, struct gl_program_cache *cache)
 {
    clear_cache(ctx, cache, GL_FALSE);
-   free(cache->items);
+   _mesa_hash_table_destroy(cache->ht, NULL);
    free(cache);
 }
 
@@ -166,7 +131,7 @@ _mesa_delete_shader_cache(struct gl_context *ctx,
 			  struct gl_program_cache *cache)
 {
    clear_cache(ctx, cache, GL_TRUE);
-   free(cache->items);
+   _mesa_hash_table_destroy(cache->ht, NULL);
    free(cache);
 }
 
@@ -181,51 +146,47 @@ _mesa_search_program_cache(struct gl_program_cache *cache,
       return cache->last->program;
    }
    else {
-      const GLuint hash = hash_key(key, keysize);
-      struct cache_item *c;
+      struct cache_item search = { keysize, key, NULL };
+      struct hash_entry *entry = _mesa_hash_table_search(cache->ht, &search);
 
-      for (c = cache->items[hash % cache->size]; c; c = c->next) {
-         if (c->hash == hash &&
-             c->keysize == keysize &&
-             memcmp(c->key, key, keysize) == 0) {
-
-            cache->last = c;
-            return c->program;
-         }
-      }
+      if (!entry)
+         return NULL;
 
-      return NULL;
+      cache->last = (struct cache_item *) entry->key;
+      return cache->last->program;
    }
 }
 
 
-void
-_mesa_program_cache_insert(struct gl_context *ctx,
-                           struct gl_program_cache *cache,
-                           const void *key, GLuint keysize,
-                           struct gl_program *program)
+static void
+cache_insert(struct gl_context *ctx, struct gl_program_cache *cache,
+             const void *key, GLuint keysize, struct gl_program *program,
+             GLboolean shader)
 {
-   const GLuint hash = hash_key(key, keysize);
-   struct cache_item *c = CALLOC_STRUCT(cache_item);
+   /* The key is stored right after the item. */
+   struct cache_item *c = malloc(sizeof(*c) + keysize);
 
-   c->hash = hash;
+   if (!c)
+      return;
 
-   c->key = malloc(keysize);
-   memcpy(c->key, key, keysize);
+   memcpy(c + 1, key, keysize);
+   c->key = c + 1;
    c->keysize = keysize;
-
    c->program = program;  /* no refcount change */
 
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else 
-	 clear_cache(ctx, cache, GL_FALSE);
-   }
+   if (cache->ht->entries >= PROG_CACHE_MAX_ITEMS)
+      clear_cache(ctx, cache, shader);
+
+   _mesa_hash_table_insert(cache->ht, c, c);
+}
 
-   cache->n_items++;
-   c->next = cache->items[hash % cache->size];
-   cache->items[hash % cache->size] = c;
+void
+_mesa_program_cache_insert(struct gl_context *ctx,
+                           struct gl_program_cache *cache,
+                           const void *key, GLuint keysize,
+                           struct gl_program *program)
+{
+   cache_insert(ctx, cache, key, keysize, program, GL_FALSE);
 }
 
 void
@@ -234,25 +195,6 @@ _mesa_shader_cache_insert(struct gl_context *ctx,
 			  const void *key, GLuint keysize,
 			  struct gl_shader_program *program)
 {
-   const GLuint hash = hash_key(key, keysize);
-   struct cache_item *c = CALLOC_STRUCT(cache_item);
-
-   c->hash = hash;
-
-   c->key = malloc(keysize);
-   memcpy(c->key, key, keysize);
-   c->keysize = keysize;
-
-   c->program = (struct gl_program *)program;  /* no refcount change */
-
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else
-	 clear_cache(ctx, cache, GL_TRUE);
-   }
-
-   cache->n_items++;
-   c->next = cache->items[hash % cache->size];
-   cache->items[hash % cache->size] = c;
+   cache_insert(ctx, cache, key, keysize,
+                (struct gl_program *)program, GL_TRUE);
 }
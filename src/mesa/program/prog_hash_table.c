@@ -42,7 +42,8 @@ struct hash_table {
     hash_compare_func_t  compare;
 
     unsigned num_buckets;
-    struct node buckets[1];
+    unsigned num_entries;
+    struct node *buckets;
 };
 
 
@@ -65,12 +66,18 @@ hash_table_ctor(unsigned num_buckets, hash_func_t hash,
         num_buckets = 16;
     }
 
-    ht = malloc(sizeof(*ht) + ((num_buckets - 1) 
-				     * sizeof(ht->buckets[0])));
+    ht = malloc(sizeof(*ht));
     if (ht != NULL) {
+        ht->buckets = malloc(num_buckets * sizeof(ht->buckets[0]));
+        if (ht->buckets == NULL) {
+            free(ht);
+            return NULL;
+        }
+
         ht->hash = hash;
         ht->compare = compare;
         ht->num_buckets = num_buckets;
+        ht->num_entries = 0;
 
         for (i = 0; i < num_buckets; i++) {
             make_empty_list(& ht->buckets[i]);
@@ -85,6 +92,7 @@ void
 hash_table_dtor(struct hash_table *ht)
 {
    hash_table_clear(ht);
+   free(ht->buckets);
    free(ht);
 }
 
@@ -105,6 +113,50 @@ hash_table_clear(struct hash_table *ht)
 
       assert(is_empty_list(& ht->buckets[i]));
    }
+
+   ht->num_entries = 0;
+}
+
+
+/**
+ * Double the number of buckets once there are more than two entries per
+ * bucket on average, so that lookups don't degrade to walking long chains
+ * when a table was created with too few buckets for its contents.
+ */
+static void
+grow_if_needed(struct hash_table *ht)
+{
+   const unsigned num_buckets = ht->num_buckets * 2;
+   struct node *buckets;
+   unsigned i;
+
+   if (ht->num_entries <= ht->num_buckets * 2)
+      return;
+
+   buckets = malloc(num_buckets * sizeof(buckets[0]));
+   if (buckets == NULL)
+      return;
+
+   for (i = 0; i < num_buckets; i++) {
+      make_empty_list(& buckets[i]);
+   }
+
+   /* Move the nodes from the tail of each chain, so that entries sharing a
+    * key stay ordered from the most recently inserted one.
+    */
+   for (i = 0; i < ht->num_buckets; i++) {
+      while (!is_empty_list(& ht->buckets[i])) {
+         struct hash_node *hn = (struct hash_node *) last_elem(& ht->buckets[i]);
+         const unsigned bucket = (*ht->hash)(hn->key) % num_buckets;
+
+         remove_from_list(& hn->link);
+         insert_at_head(& buckets[bucket], & hn->link);
+      }
+   }
+
+   free(ht->buckets);
+   ht->buckets = buckets;
+   ht->num_buckets = num_buckets;
 }
 
 
@@ -151,6 +203,8 @@ hash_table_insert(struct hash_table *ht, void *data, const void *key)
     node->key = key;
 
     insert_at_head(& ht->buckets[bucket], & node->link);
+    ht->num_entries++;
+    grow_if_needed(ht);
 }
 
 bool
@@ -180,6 +234,8 @@ hash_table_replace(struct hash_table *ht, void *data, const void *key)
     hn->key = key;
 
     insert_at_head(& ht->buckets[bucket], & hn->link);
+    ht->num_entries++;
+    grow_if_needed(ht);
     return false;
 }
 
@@ -190,6 +246,7 @@ hash_table_remove(struct hash_table *ht, const void *key)
    if (node != NULL) {
       remove_from_list(node);
       free(node);
+      ht->num_entries--;
       return;
    }
 }
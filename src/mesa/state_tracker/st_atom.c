@@ -31,6 +31,7 @@
 #include "main/context.h"
 
 #include "pipe/p_defines.h"
+#include "util/u_math.h"
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_program.h"
@@ -114,9 +115,38 @@ static const struct st_tracked_state *compute_atoms[] =
 };
 
 
+static void
+init_atom_masks(struct st_context *st, enum st_pipeline pipeline,
+                const struct st_tracked_state **atoms, unsigned num_atoms)
+{
+   unsigned i;
+
+   assert(num_atoms <= ST_MAX_ATOMS);
+
+   for (i = 0; i < num_atoms; i++) {
+      GLbitfield mesa = atoms[i]->dirty.mesa;
+      unsigned st_flags = atoms[i]->dirty.st;
+
+      /* Only the low 32 ST_NEW_x bits are looked up. */
+      assert(atoms[i]->dirty.st == st_flags);
+
+      while (mesa)
+         st->atoms_for_mesa_state[pipeline][u_bit_scan(&mesa)] |= 1ull << i;
+      while (st_flags)
+         st->atoms_for_st_state[pipeline][u_bit_scan(&st_flags)] |= 1ull << i;
+   }
+}
+
+
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   STATIC_ASSERT(ARRAY_SIZE(render_atoms) <= ST_MAX_ATOMS);
+   STATIC_ASSERT(ARRAY_SIZE(compute_atoms) <= ST_MAX_ATOMS);
+
+   init_atom_masks(st, ST_PIPELINE_RENDER,
+                   render_atoms, ARRAY_SIZE(render_atoms));
+   init_atom_masks(st, ST_PIPELINE_COMPUTE,
+                   compute_atoms, ARRAY_SIZE(compute_atoms));
 }
 
 
@@ -284,10 +314,26 @@ void st_validate_state( struct st_context *st, enum st_pipeline pipeline )
 
    }
    else {
-      for (i = 0; i < num_atoms; i++) {
-	 if (check_state(state, &atoms[i]->dirty))
-	    atoms[i]->update( st );
-      }
+      /* Only visit the atoms which depend on one of the dirty flags.  The
+       * bits are visited in ascending order, which is the order of the list.
+       * The atoms don't flag new state, so the mask can be computed once.
+       */
+      GLbitfield mesa = state->mesa;
+      unsigned st_flags = state->st;
+      uint64_t mask = 0;
+      unsigned half;
+
+      while (mesa)
+         mask |= st->atoms_for_mesa_state[pipeline][u_bit_scan(&mesa)];
+      while (st_flags)
+         mask |= st->atoms_for_st_state[pipeline][u_bit_scan(&st_flags)];
+
+      half = mask;
+      while (half)
+         atoms[u_bit_scan(&half)]->update( st );
+      half = mask >> 32;
+      while (half)
+         atoms[32 + u_bit_scan(&half)]->update( st );
    }
 
    memset(state, 0, sizeof(*state));
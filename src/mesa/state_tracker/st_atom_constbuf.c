@@ -148,7 +148,7 @@ const struct st_tracked_state st_update_vs_constants = {
    "st_update_vs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_VERTEX_PROGRAM,				/* st */
+      ST_NEW_VERTEX_PROGRAM | ST_NEW_VS_CONSTANTS,	/* st */
    },
    update_vs_constants					/* update */
 };
@@ -171,7 +171,7 @@ const struct st_tracked_state st_update_fs_constants = {
    "st_update_fs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_FRAGMENT_PROGRAM,				/* st */
+      ST_NEW_FRAGMENT_PROGRAM | ST_NEW_FS_CONSTANTS,	/* st */
    },
    update_fs_constants					/* update */
 };
@@ -193,7 +193,7 @@ const struct st_tracked_state st_update_gs_constants = {
    "st_update_gs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_GEOMETRY_PROGRAM,				/* st */
+      ST_NEW_GEOMETRY_PROGRAM | ST_NEW_GS_CONSTANTS,	/* st */
    },
    update_gs_constants					/* update */
 };
@@ -215,7 +215,7 @@ const struct st_tracked_state st_update_tcs_constants = {
    "st_update_tcs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_TESSCTRL_PROGRAM,				/* st */
+      ST_NEW_TESSCTRL_PROGRAM | ST_NEW_TCS_CONSTANTS,	/* st */
    },
    update_tcs_constants					/* update */
 };
@@ -237,7 +237,7 @@ const struct st_tracked_state st_update_tes_constants = {
    "st_update_tes_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_TESSEVAL_PROGRAM,				/* st */
+      ST_NEW_TESSEVAL_PROGRAM | ST_NEW_TES_CONSTANTS,	/* st */
    },
    update_tes_constants					/* update */
 };
@@ -259,7 +259,7 @@ const struct st_tracked_state st_update_cs_constants = {
    "st_update_cs_constants",				/* name */
    {							/* dirty */
       _NEW_PROGRAM_CONSTANTS,                           /* mesa */
-      ST_NEW_COMPUTE_PROGRAM,				/* st */
+      ST_NEW_COMPUTE_PROGRAM | ST_NEW_CS_CONSTANTS,	/* st */
    },
    update_cs_constants					/* update */
 };
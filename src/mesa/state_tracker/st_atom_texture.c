@@ -315,13 +315,47 @@ st_create_texture_sampler_view_from_stobj(struct st_context *st,
 }
 
 
+/**
+ * Gather the GL state the texture's sampler view depends on.
+ */
+static void
+get_sampler_view_key(const struct st_texture_object *stObj,
+                     enum pipe_format format, unsigned glsl_version,
+                     struct st_sampler_view_key *key)
+{
+   const struct gl_texture_image *firstImage =
+      _mesa_base_tex_image(&stObj->base);
+
+   memset(key, 0, sizeof(*key));
+   key->format = format;
+   key->target = stObj->base.Target;
+   if (firstImage) {
+      key->base_format = firstImage->_BaseFormat;
+      key->internal_format = firstImage->InternalFormat;
+   }
+   key->depth_mode = stObj->base.DepthMode;
+   key->swizzle = stObj->base._Swizzle;
+   key->min_level = stObj->base.MinLevel;
+   key->base_level = stObj->base.BaseLevel;
+   key->max_level = stObj->base._MaxLevel;
+   key->num_levels = stObj->base.NumLevels;
+   key->min_layer = stObj->base.MinLayer;
+   key->num_layers = stObj->base.NumLayers;
+   key->buffer_offset = stObj->base.BufferOffset;
+   key->buffer_size = stObj->base.BufferSize;
+   key->immutable = stObj->base.Immutable;
+   key->glsl130 = glsl_version >= 130;
+}
+
+
 static struct pipe_sampler_view *
 st_get_texture_sampler_view_from_stobj(struct st_context *st,
                                        struct st_texture_object *stObj,
 				       enum pipe_format format,
                                        unsigned glsl_version)
 {
-   struct pipe_sampler_view **sv;
+   struct st_sampler_view *sv;
+   struct st_sampler_view_key key;
    const struct st_texture_image *firstImage;
    if (!stObj || !stObj->pt) {
       return NULL;
@@ -339,32 +373,45 @@ st_get_texture_sampler_view_from_stobj(struct st_context *st,
       }
    }
 
+   get_sampler_view_key(stObj, format, glsl_version, &key);
+
+   /* Views are released whenever stObj->pt changes, so if the GL state
+    * matches what the view was made from, it's still good.
+    */
+   if (sv->view && sv->view->context == st->pipe &&
+       memcmp(&key, &sv->key, sizeof(key)) == 0)
+      return sv->view;
+
    /* if sampler view has changed dereference it */
-   if (*sv) {
-      if (check_sampler_swizzle(st, stObj, *sv, glsl_version) ||
-	  (format != (*sv)->format) ||
-          gl_target_to_pipe(stObj->base.Target) != (*sv)->target ||
-          stObj->base.MinLevel + stObj->base.BaseLevel != (*sv)->u.tex.first_level ||
-          last_level(stObj) != (*sv)->u.tex.last_level ||
-          stObj->base.MinLayer != (*sv)->u.tex.first_layer ||
-          last_layer(stObj) != (*sv)->u.tex.last_layer) {
-	 pipe_sampler_view_reference(sv, NULL);
+   if (sv->view) {
+      struct pipe_sampler_view *view = sv->view;
+
+      if (check_sampler_swizzle(st, stObj, view, glsl_version) ||
+	  (format != view->format) ||
+          gl_target_to_pipe(stObj->base.Target) != view->target ||
+          stObj->base.MinLevel + stObj->base.BaseLevel != view->u.tex.first_level ||
+          last_level(stObj) != view->u.tex.last_level ||
+          stObj->base.MinLayer != view->u.tex.first_layer ||
+          last_layer(stObj) != view->u.tex.last_layer) {
+	 pipe_sampler_view_reference(&sv->view, NULL);
       }
    }
 
-   if (!*sv) {
-      *sv = st_create_texture_sampler_view_from_stobj(st, stObj,
-                                                      format, glsl_version);
+   if (!sv->view) {
+      sv->view = st_create_texture_sampler_view_from_stobj(st, stObj,
+                                                           format, glsl_version);
 
-   } else if ((*sv)->context != st->pipe) {
+   } else if (sv->view->context != st->pipe) {
       /* Recreate view in correct context, use existing view as template */
       struct pipe_sampler_view *new_sv =
-         st->pipe->create_sampler_view(st->pipe, stObj->pt, *sv);
-      pipe_sampler_view_reference(sv, NULL);
-      *sv = new_sv;
+         st->pipe->create_sampler_view(st->pipe, stObj->pt, sv->view);
+      pipe_sampler_view_reference(&sv->view, NULL);
+      sv->view = new_sv;
    }
 
-   return *sv;
+   sv->key = key;
+
+   return sv->view;
 }
 
 static GLboolean
@@ -44,6 +44,7 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "util/u_gen_mipmap.h"
+#include "util/u_upload_mgr.h"
 
 
 /** Check if we have a front color buffer and if it's been drawn to. */
@@ -79,12 +80,32 @@ void st_flush(struct st_context *st,
               struct pipe_fence_handle **fence,
               unsigned flags)
 {
+   struct pipe_screen *screen = st->pipe->screen;
+   struct pipe_fence_handle *upload_fence = NULL;
+
    FLUSH_VERTICES(st->ctx, 0);
    FLUSH_CURRENT(st->ctx, 0);
 
    st_flush_bitmap_cache(st);
 
+   /* Always ask for a fence, the uploaders need it to know when their
+    * retired buffers can be reused.
+    */
+   if (!fence)
+      fence = &upload_fence;
+
    st->pipe->flush(st->pipe, fence, flags);
+
+   if (*fence) {
+      u_upload_fence(st->uploader, *fence);
+      if (st->indexbuf_uploader)
+         u_upload_fence(st->indexbuf_uploader, *fence);
+      if (st->constbuf_uploader)
+         u_upload_fence(st->constbuf_uploader, *fence);
+   }
+
+   if (upload_fence)
+      screen->fence_reference(screen, &upload_fence, NULL);
 }
 
 
@@ -47,6 +47,7 @@
 #include "st_cb_program.h"
 #include "st_glsl_to_tgsi.h"
 #include "st_atifs_to_tgsi.h"
+#include "st_shader_cache.h"
 
 
 
@@ -355,4 +356,6 @@ st_init_program_functions(struct dd_function_table *functions)
    functions->NewATIfs = st_new_ati_fs;
    
    functions->LinkShader = st_link_shader;
+   functions->ShaderCacheSerializeDriverBlob = st_shader_cache_serialize;
+   functions->ShaderCacheDeserializeDriverBlob = st_shader_cache_deserialize;
 }
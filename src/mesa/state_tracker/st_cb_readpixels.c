@@ -31,6 +31,7 @@
 #include "main/readpix.h"
 #include "main/enums.h"
 #include "main/framebuffer.h"
+#include "main/streaming-load-memcpy.h"
 #include "util/u_inlines.h"
 #include "util/u_format.h"
 
@@ -241,7 +242,7 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
          void *dest = _mesa_image_address2d(pack, pixels,
                                               width, height, format,
                                               type, row, 0);
-         memcpy(dest, map, bytesPerRow);
+         _mesa_memcpy_from_uncached(dest, map, bytesPerRow);
          map += tex_xfer->stride;
       }
    }
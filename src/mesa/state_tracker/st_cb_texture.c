@@ -39,6 +39,7 @@
 #include "main/pack.h"
 #include "main/pbo.h"
 #include "main/pixeltransfer.h"
+#include "main/streaming-load-memcpy.h"
 #include "main/texcompress.h"
 #include "main/texcompress_etc.h"
 #include "main/texgetimage.h"
@@ -727,6 +728,8 @@ st_init_pbo_upload(struct st_context *st)
 void
 st_destroy_pbo_upload(struct st_context *st)
 {
+   unsigned i;
+
    if (st->pbo_upload.fs) {
       cso_delete_fragment_shader(st->cso_context, st->pbo_upload.fs);
       st->pbo_upload.fs = NULL;
@@ -741,6 +744,9 @@ st_destroy_pbo_upload(struct st_context *st)
       cso_delete_vertex_shader(st->cso_context, st->pbo_upload.vs);
       st->pbo_upload.vs = NULL;
    }
+
+   for (i = 0; i < ST_NUM_UPLOAD_STAGING_TEXTURES; i++)
+      pipe_resource_reference(&st->upload_staging.textures[i], NULL);
 }
 
 /**
@@ -1675,6 +1681,63 @@ try_pbo_upload(struct gl_context *ctx, GLuint dims,
    return success;
 }
 
+/**
+ * Return a staging texture at least as large as \p templ for an upload,
+ * reusing one of the textures of the previous uploads if possible.
+ *
+ * The texture is mapped with PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE, so the
+ * driver doesn't stall if a previous blit from it is still in flight.
+ */
+static struct pipe_resource *
+get_upload_staging_texture(struct st_context *st,
+                           const struct pipe_resource *templ)
+{
+   struct pipe_screen *screen = st->pipe->screen;
+   struct pipe_resource *res = NULL;
+   struct pipe_resource **slot;
+   struct pipe_resource tmpl = *templ;
+   unsigned i;
+
+   /* Big uploads are rare, don't keep their memory around. */
+   if (util_format_get_stride(templ->format, templ->width0) *
+       templ->height0 * templ->depth0 * templ->array_size > 16 * 1024 * 1024)
+      return screen->resource_create(screen, templ);
+
+   for (i = 0; i < ST_NUM_UPLOAD_STAGING_TEXTURES; i++) {
+      struct pipe_resource *tex = st->upload_staging.textures[i];
+
+      if (tex && tex->target == templ->target &&
+          tex->format == templ->format &&
+          tex->width0 >= templ->width0 &&
+          tex->height0 >= templ->height0 &&
+          tex->depth0 >= templ->depth0 &&
+          tex->array_size >= templ->array_size) {
+         pipe_resource_reference(&res, tex);
+         return res;
+      }
+   }
+
+   slot = &st->upload_staging.textures[st->upload_staging.next];
+   st->upload_staging.next =
+      (st->upload_staging.next + 1) % ST_NUM_UPLOAD_STAGING_TEXTURES;
+
+   /* Grow a texture of the same kind, so that streaming uploads of varying
+    * sizes settle on a single texture.
+    */
+   if (*slot && (*slot)->target == templ->target &&
+       (*slot)->format == templ->format) {
+      tmpl.width0 = MAX2(tmpl.width0, (*slot)->width0);
+      tmpl.height0 = MAX2(tmpl.height0, (*slot)->height0);
+      tmpl.depth0 = MAX2(tmpl.depth0, (*slot)->depth0);
+      tmpl.array_size = MAX2(tmpl.array_size, (*slot)->array_size);
+   }
+
+   pipe_resource_reference(slot, NULL);
+   *slot = screen->resource_create(screen, &tmpl);
+   pipe_resource_reference(&res, *slot);
+   return res;
+}
+
 static void
 st_TexSubImage(struct gl_context *ctx, GLuint dims,
                struct gl_texture_image *texImage,
@@ -1804,8 +1867,8 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
       goto fallback;
    }
 
-   /* Create the source texture. */
-   src = screen->resource_create(screen, &src_templ);
+   /* Get the source texture. */
+   src = get_upload_staging_texture(st, &src_templ);
    if (!src) {
       goto fallback;
    }
@@ -1828,8 +1891,10 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
       height = 1;
    }
 
-   map = pipe_transfer_map_3d(pipe, src, 0, PIPE_TRANSFER_WRITE, 0, 0, 0,
-                              width, height, depth, &transfer);
+   map = pipe_transfer_map_3d(pipe, src, 0,
+                              PIPE_TRANSFER_WRITE |
+                              PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE,
+                              0, 0, 0, width, height, depth, &transfer);
    if (!map) {
       _mesa_unmap_teximage_pbo(ctx, unpack);
       pipe_resource_reference(&src, NULL);
@@ -2323,7 +2388,7 @@ st_GetTexSubImage(struct gl_context * ctx,
             void *dest = _mesa_image_address3d(&ctx->Pack, pixels,
                                                  width, depth, format,
                                                  type, 0, slice, 0);
-            memcpy(dest, map, bytesPerRow);
+            _mesa_memcpy_from_uncached(dest, map, bytesPerRow);
          }
          else {
             ubyte *slice_map = map;
@@ -2332,7 +2397,7 @@ st_GetTexSubImage(struct gl_context * ctx,
                void *dest = _mesa_image_address3d(&ctx->Pack, pixels,
                                                     width, height, format,
                                                     type, slice, row, 0);
-               memcpy(dest, slice_map, bytesPerRow);
+               _mesa_memcpy_from_uncached(dest, slice_map, bytesPerRow);
                slice_map += tex_xfer->stride;
             }
          }
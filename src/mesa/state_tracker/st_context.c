@@ -30,6 +30,7 @@
 #include "main/api_exec.h"
 #include "main/context.h"
 #include "main/samplerobj.h"
+#include "main/shaderapi.h"
 #include "main/shaderobj.h"
 #include "main/version.h"
 #include "main/vtxfmt.h"
@@ -37,6 +38,7 @@
 #include "program/prog_cache.h"
 #include "vbo/vbo.h"
 #include "glapi/glapi.h"
+#include "util/disk_cache.h"
 #include "st_context.h"
 #include "st_debug.h"
 #include "st_cb_bitmap.h"
@@ -239,6 +241,17 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
 
    st->cso_context = cso_create_context(pipe);
 
+   /* The cached TGSI comes from this state tracker build and depends on the
+    * device's capabilities, so key the cache directory on both.
+    */
+   {
+      char timestamp[32];
+
+      if (disk_cache_get_function_timestamp((void *) st_create_context_priv,
+                                            timestamp, sizeof(timestamp)))
+         ctx->Cache = disk_cache_create(screen->get_name(screen), timestamp);
+   }
+
    st_init_atoms( st );
    st_init_clear(st);
    st_init_draw( st );
@@ -315,6 +328,8 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
       screen->get_param(screen, PIPE_CAP_QUERY_TIME_ELAPSED);
    st->has_half_float_packing =
       screen->get_param(screen, PIPE_CAP_TGSI_PACK_HALF_FLOAT);
+   st->needs_index_bounds =
+      !screen->get_param(screen, PIPE_CAP_INDEX_BOUNDS_NOT_NEEDED);
    st->has_multi_draw_indirect =
       screen->get_param(screen, PIPE_CAP_MULTI_DRAW_INDIRECT);
 
@@ -401,6 +416,13 @@ static void st_init_driver_flags(struct gl_driver_flags *f)
    f->NewAtomicBuffer = ST_NEW_ATOMIC_BUFFER;
    f->NewShaderStorageBuffer = ST_NEW_STORAGE_BUFFER;
    f->NewImageUnits = ST_NEW_IMAGE_UNITS;
+
+   f->NewShaderConstants[MESA_SHADER_VERTEX] = ST_NEW_VS_CONSTANTS;
+   f->NewShaderConstants[MESA_SHADER_TESS_CTRL] = ST_NEW_TCS_CONSTANTS;
+   f->NewShaderConstants[MESA_SHADER_TESS_EVAL] = ST_NEW_TES_CONSTANTS;
+   f->NewShaderConstants[MESA_SHADER_GEOMETRY] = ST_NEW_GS_CONSTANTS;
+   f->NewShaderConstants[MESA_SHADER_FRAGMENT] = ST_NEW_FS_CONSTANTS;
+   f->NewShaderConstants[MESA_SHADER_COMPUTE] = ST_NEW_CS_CONSTANTS;
 }
 
 struct st_context *st_create_context(gl_api api, struct pipe_context *pipe,
@@ -457,6 +479,9 @@ void st_destroy_context( struct st_context *st )
    struct gl_context *ctx = st->ctx;
    GLuint i;
 
+   /* Queued shader compiles use ctx->Cache, which goes away below. */
+   _mesa_destroy_shader_compiler_queue(ctx);
+
    _mesa_HashWalk(ctx->Shared->TexObjects, destroy_tex_sampler_cb, st);
 
    st_reference_fragprog(st, &st->fp, NULL);
@@ -478,6 +503,9 @@ void st_destroy_context( struct st_context *st )
 
    st_destroy_program_variants(st);
 
+   disk_cache_destroy(ctx->Cache);
+   ctx->Cache = NULL;
+
    _mesa_free_context_data(ctx);
 
    /* This will free the st_context too, so 'st' must not be accessed
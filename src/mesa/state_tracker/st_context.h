@@ -66,6 +66,12 @@ struct u_upload_mgr;
 #define ST_NEW_STORAGE_BUFFER          (1 << 13)
 #define ST_NEW_COMPUTE_PROGRAM         (1 << 14)
 #define ST_NEW_IMAGE_UNITS             (1 << 15)
+#define ST_NEW_VS_CONSTANTS            (1 << 16)
+#define ST_NEW_FS_CONSTANTS            (1 << 17)
+#define ST_NEW_GS_CONSTANTS            (1 << 18)
+#define ST_NEW_TCS_CONSTANTS           (1 << 19)
+#define ST_NEW_TES_CONSTANTS           (1 << 20)
+#define ST_NEW_CS_CONSTANTS            (1 << 21)
 
 
 struct st_state_flags {
@@ -86,8 +92,15 @@ struct st_tracked_state {
 enum st_pipeline {
    ST_PIPELINE_RENDER,
    ST_PIPELINE_COMPUTE,
+   ST_NUM_PIPELINES,
 };
 
+/** Maximum number of atoms of a pipeline, one bit each in a uint64_t. */
+#define ST_MAX_ATOMS 64
+
+/** Number of staging textures kept around for glTexSubImage uploads. */
+#define ST_NUM_UPLOAD_STAGING_TEXTURES 4
+
 
 /** For drawing quads for glClear, glDraw/CopyPixels, glBitmap, etc. */
 struct st_util_vertex
@@ -124,6 +137,7 @@ struct st_context
    boolean has_shareable_shaders;
    boolean has_half_float_packing;
    boolean has_multi_draw_indirect;
+   boolean needs_index_bounds; /**< min/max_index needed for user arrays? */
 
    /**
     * If a shader can be created when we get its source.
@@ -174,6 +188,14 @@ struct st_context
    struct st_state_flags dirty;
    struct st_state_flags dirty_cp;
 
+   /**
+    * For each bit of st_state_flags::mesa and the low 32 bits of
+    * st_state_flags::st, the mask of the atoms of each pipeline which
+    * depend on it.  Bit i of a mask is atom i of the pipeline's list.
+    */
+   uint64_t atoms_for_mesa_state[ST_NUM_PIPELINES][32];
+   uint64_t atoms_for_st_state[ST_NUM_PIPELINES][32];
+
    GLboolean vertdata_edgeflags;
    GLboolean edgeflag_culls_prims;
 
@@ -248,6 +270,12 @@ struct st_context
       bool use_gs;
    } pbo_upload;
 
+   /** Staging textures reused by the blit-based glTexSubImage path */
+   struct {
+      struct pipe_resource *textures[ST_NUM_UPLOAD_STAGING_TEXTURES];
+      unsigned next;
+   } upload_staging;
+
    /** for drawing with st_util_vertex */
    struct pipe_vertex_element util_velems[3];
 
@@ -183,8 +183,10 @@ st_draw_vbo(struct gl_context *ctx,
    util_draw_init_info(&info);
 
    if (ib) {
-      /* Get index bounds for user buffers. */
-      if (!index_bounds_valid)
+      /* Get index bounds for user buffers, unless the driver can fetch
+       * from them without knowing the range.
+       */
+      if (!index_bounds_valid && st->needs_index_bounds)
          if (!all_varyings_in_vbos(arrays))
             vbo_get_minmax_indices(ctx, prims, ib, &min_index, &max_index,
                                    nr_prims);
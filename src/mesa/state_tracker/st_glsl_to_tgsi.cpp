@@ -4503,34 +4503,48 @@ glsl_to_tgsi_visitor::simplify_cmp(void)
    free(tempWrites);
 }
 
-/* Replaces all references to a temporary register index with another index. */
+/* Replaces all references to a temporary register index with another index.
+ * The renames are applied in order, so a register renamed by one entry may
+ * be renamed again by a later one. */
 void
 glsl_to_tgsi_visitor::rename_temp_registers(int num_renames, struct rename_reg_pair *renames)
 {
+   int *map;
+   int k;
+
+   if (!num_renames)
+      return;
+
+   /* Compose the renames into a single lookup table, so that each operand
+    * is looked up once instead of being compared with every rename. */
+   map = ralloc_array(mem_ctx, int, this->next_temp);
+   for (k = 0; k < this->next_temp; k++)
+      map[k] = k;
+   for (k = num_renames - 1; k >= 0; k--)
+      map[renames[k].old_reg] = map[renames[k].new_reg];
+
    foreach_in_list(glsl_to_tgsi_instruction, inst, &this->instructions) {
       unsigned j;
-      int k;
       for (j = 0; j < num_inst_src_regs(inst); j++) {
-         if (inst->src[j].file == PROGRAM_TEMPORARY)
-            for (k = 0; k < num_renames; k++)
-               if (inst->src[j].index == renames[k].old_reg)
-                  inst->src[j].index = renames[k].new_reg;
+         if (inst->src[j].file == PROGRAM_TEMPORARY &&
+             inst->src[j].index < this->next_temp)
+            inst->src[j].index = map[inst->src[j].index];
       }
 
       for (j = 0; j < inst->tex_offset_num_offset; j++) {
-         if (inst->tex_offsets[j].file == PROGRAM_TEMPORARY)
-            for (k = 0; k < num_renames; k++)
-               if (inst->tex_offsets[j].index == renames[k].old_reg)
-                  inst->tex_offsets[j].index = renames[k].new_reg;
+         if (inst->tex_offsets[j].file == PROGRAM_TEMPORARY &&
+             inst->tex_offsets[j].index < this->next_temp)
+            inst->tex_offsets[j].index = map[inst->tex_offsets[j].index];
       }
 
       for (j = 0; j < num_inst_dst_regs(inst); j++) {
-         if (inst->dst[j].file == PROGRAM_TEMPORARY)
-             for (k = 0; k < num_renames; k++)
-                if (inst->dst[j].index == renames[k].old_reg)
-                   inst->dst[j].index = renames[k].new_reg;
+         if (inst->dst[j].file == PROGRAM_TEMPORARY &&
+             inst->dst[j].index < this->next_temp)
+            inst->dst[j].index = map[inst->dst[j].index];
       }
    }
+
+   ralloc_free(map);
 }
 
 void
@@ -5054,18 +5068,58 @@ glsl_to_tgsi_visitor::merge_two_dsts(void)
    }
 }
 
+/* Live range of a temporary register, used by merge_registers(). */
+struct temp_live_range {
+   int index;
+   int first_write;
+   int last_read;
+};
+
+static int
+compare_live_range_start(const void *a, const void *b)
+{
+   const struct temp_live_range *ra = (const struct temp_live_range *) a;
+   const struct temp_live_range *rb = (const struct temp_live_range *) b;
+
+   if (ra->first_write != rb->first_write)
+      return ra->first_write - rb->first_write;
+   if (ra->last_read != rb->last_read)
+      return ra->last_read - rb->last_read;
+   return ra->index - rb->index;
+}
+
+static int
+compare_live_range_end(const void *a, const void *b)
+{
+   const struct temp_live_range *ra = (const struct temp_live_range *) a;
+   const struct temp_live_range *rb = (const struct temp_live_range *) b;
+
+   if (ra->last_read != rb->last_read)
+      return ra->last_read - rb->last_read;
+   if (ra->first_write != rb->first_write)
+      return ra->first_write - rb->first_write;
+   return ra->index - rb->index;
+}
+
 /* Merges temporary registers together where possible to reduce the number of
  * registers needed to run a program.
  *
+ * This is a linear scan over the live ranges sorted by their first write: a
+ * register whose last read is at or before the first write of the current
+ * range is free and can be reused for it.
+ *
  * Produces optimal code only after copy propagation and dead code elimination
  * have been run. */
 void
 glsl_to_tgsi_visitor::merge_registers(void)
 {
-   int *last_reads = rzalloc_array(mem_ctx, int, this->next_temp);
-   int *first_writes = rzalloc_array(mem_ctx, int, this->next_temp);
+   int *last_reads = ralloc_array(mem_ctx, int, this->next_temp);
+   int *first_writes = ralloc_array(mem_ctx, int, this->next_temp);
    struct rename_reg_pair *renames = rzalloc_array(mem_ctx, struct rename_reg_pair, this->next_temp);
-   int i, j;
+   struct temp_live_range *by_start, *by_end;
+   int *assigned = ralloc_array(mem_ctx, int, this->next_temp);
+   int *free_regs = ralloc_array(mem_ctx, int, this->next_temp);
+   int i, num_ranges = 0, num_free = 0, next_end = 0;
    int num_renames = 0;
 
    /* Read the indices of the last read and first write to each temp register
@@ -5074,37 +5128,49 @@ glsl_to_tgsi_visitor::merge_registers(void)
    for (i = 0; i < this->next_temp; i++) {
       last_reads[i] = -1;
       first_writes[i] = -1;
+      assigned[i] = -1;
    }
    get_last_temp_read_first_temp_write(last_reads, first_writes);
 
-   /* Start looking for registers with non-overlapping usages that can be
-    * merged together. */
+   by_start = ralloc_array(mem_ctx, struct temp_live_range, this->next_temp);
    for (i = 0; i < this->next_temp; i++) {
       /* Don't touch unused registers. */
-      if (last_reads[i] < 0 || first_writes[i] < 0) continue;
-
-      for (j = 0; j < this->next_temp; j++) {
-         /* Don't touch unused registers. */
-         if (last_reads[j] < 0 || first_writes[j] < 0) continue;
-
-         /* We can merge the two registers if the first write to j is after or
-          * in the same instruction as the last read from i.  Note that the
-          * register at index i will always be used earlier or at the same time
-          * as the register at index j. */
-         if (first_writes[i] <= first_writes[j] &&
-             last_reads[i] <= first_writes[j]) {
-            renames[num_renames].old_reg = j;
-            renames[num_renames].new_reg = i;
-            num_renames++;
-
-            /* Update the first_writes and last_reads arrays with the new
-             * values for the merged register index, and mark the newly unused
-             * register index as such. */
-            assert(last_reads[j] >= last_reads[i]);
-            last_reads[i] = last_reads[j];
-            first_writes[j] = -1;
-            last_reads[j] = -1;
-         }
+      if (last_reads[i] < 0 || first_writes[i] < 0)
+         continue;
+
+      by_start[num_ranges].index = i;
+      by_start[num_ranges].first_write = first_writes[i];
+      by_start[num_ranges].last_read = last_reads[i];
+      num_ranges++;
+   }
+
+   by_end = ralloc_array(mem_ctx, struct temp_live_range, MAX2(num_ranges, 1));
+   memcpy(by_end, by_start, num_ranges * sizeof(*by_end));
+   qsort(by_start, num_ranges, sizeof(*by_start), compare_live_range_start);
+   qsort(by_end, num_ranges, sizeof(*by_end), compare_live_range_end);
+
+   for (i = 0; i < num_ranges; i++) {
+      const struct temp_live_range *range = &by_start[i];
+
+      /* Release the registers of all ranges that end before this one is
+       * first written.  A range that isn't assigned yet starts at the same
+       * instruction and is released on a later iteration. */
+      while (next_end < num_ranges &&
+             by_end[next_end].last_read <= range->first_write &&
+             assigned[by_end[next_end].index] >= 0) {
+         free_regs[num_free++] = assigned[by_end[next_end].index];
+         next_end++;
+      }
+
+      if (num_free) {
+         int reg = free_regs[--num_free];
+
+         assigned[range->index] = reg;
+         renames[num_renames].old_reg = range->index;
+         renames[num_renames].new_reg = reg;
+         num_renames++;
+      } else {
+         assigned[range->index] = range->index;
       }
    }
 
@@ -5112,6 +5178,10 @@ glsl_to_tgsi_visitor::merge_registers(void)
    ralloc_free(renames);
    ralloc_free(last_reads);
    ralloc_free(first_writes);
+   ralloc_free(assigned);
+   ralloc_free(free_regs);
+   ralloc_free(by_start);
+   ralloc_free(by_end);
 }
 
 /* Reassign indices to temporary registers by reusing unused indices created
@@ -0,0 +1,321 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file st_shader_cache.c
+ *
+ * Driver blobs for the GLSL on-disk shader cache (see
+ * compiler/glsl/shader_cache.cpp).
+ *
+ * A cached program holds the gl_program state produced by glsl_to_tgsi and
+ * the final TGSI tokens, so that restoring it skips both the GLSL back end
+ * and st_translate_*_program().  Only vertex and fragment programs without
+ * stream output are supported.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "main/mtypes.h"
+#include "compiler/glsl/blob.h"
+#include "program/ir_to_mesa.h"
+#include "program/prog_parameter.h"
+#include "program/program.h"
+#include "tgsi/tgsi_parse.h"
+
+#include "st_context.h"
+#include "st_debug.h"
+#include "st_program.h"
+#include "st_shader_cache.h"
+
+
+static void
+write_tgsi_tokens(struct blob *blob, const struct tgsi_token *tokens)
+{
+   const unsigned num_tokens = tgsi_num_tokens(tokens);
+
+   blob_write_uint32(blob, num_tokens);
+   blob_write_bytes(blob, tokens, num_tokens * sizeof(struct tgsi_token));
+}
+
+static const struct tgsi_token *
+read_tgsi_tokens(struct blob_reader *blob)
+{
+   const unsigned num_tokens = blob_read_uint32(blob);
+   struct tgsi_token *tokens;
+
+   if (blob->overrun || num_tokens == 0)
+      return NULL;
+
+   tokens = tgsi_alloc_tokens(num_tokens);
+   if (!tokens)
+      return NULL;
+
+   blob_copy_bytes(blob, (uint8_t *) tokens,
+                   num_tokens * sizeof(struct tgsi_token));
+   if (blob->overrun) {
+      tgsi_free_tokens(tokens);
+      return NULL;
+   }
+
+   return tokens;
+}
+
+static void
+write_program_parameters(struct blob *blob,
+                         const struct gl_program_parameter_list *params)
+{
+   GLuint i;
+
+   blob_write_uint32(blob, params->NumParameters);
+   blob_write_uint32(blob, params->StateFlags);
+
+   for (i = 0; i < params->NumParameters; i++) {
+      const struct gl_program_parameter *p = &params->Parameters[i];
+
+      blob_write_uint32(blob, p->Name != NULL);
+      if (p->Name)
+         blob_write_string(blob, p->Name);
+      blob_write_uint32(blob, p->Type);
+      blob_write_uint32(blob, p->DataType);
+      blob_write_uint32(blob, p->Size);
+      blob_write_uint32(blob, p->Initialized);
+      blob_write_bytes(blob, p->StateIndexes, sizeof(p->StateIndexes));
+   }
+
+   blob_write_bytes(blob, params->ParameterValues,
+                    params->NumParameters * sizeof(params->ParameterValues[0]));
+}
+
+static bool
+read_program_parameters(struct blob_reader *blob,
+                        struct gl_program_parameter_list *params)
+{
+   const GLuint num_parameters = blob_read_uint32(blob);
+   GLuint i;
+
+   params->StateFlags = blob_read_uint32(blob);
+   if (blob->overrun)
+      return false;
+
+   _mesa_reserve_parameter_storage(params, num_parameters);
+   if (num_parameters && (!params->Parameters || !params->ParameterValues))
+      return false;
+
+   for (i = 0; i < num_parameters; i++) {
+      struct gl_program_parameter *p = &params->Parameters[i];
+
+      /* Keep NumParameters consistent with the initialized entries, so the
+       * list can be freed at any point.
+       */
+      memset(p, 0, sizeof(*p));
+      params->NumParameters = i + 1;
+
+      if (blob_read_uint32(blob)) {
+         const char *name = blob_read_string(blob);
+         if (!name)
+            return false;
+         p->Name = strdup(name);
+      }
+      p->Type = blob_read_uint32(blob);
+      p->DataType = blob_read_uint32(blob);
+      p->Size = blob_read_uint32(blob);
+      p->Initialized = blob_read_uint32(blob);
+      blob_copy_bytes(blob, (uint8_t *) p->StateIndexes,
+                      sizeof(p->StateIndexes));
+   }
+
+   blob_copy_bytes(blob, (uint8_t *) params->ParameterValues,
+                   num_parameters * sizeof(params->ParameterValues[0]));
+
+   return !blob->overrun;
+}
+
+static void
+write_program_common(struct blob *blob, const struct gl_program *prog)
+{
+   blob_write_uint64(blob, prog->InputsRead);
+   blob_write_uint64(blob, prog->DoubleInputsRead);
+   blob_write_uint64(blob, prog->OutputsWritten);
+   blob_write_uint32(blob, prog->PatchInputsRead);
+   blob_write_uint32(blob, prog->PatchOutputsWritten);
+   blob_write_uint32(blob, prog->SystemValuesRead);
+   blob_write_bytes(blob, prog->TexturesUsed, sizeof(prog->TexturesUsed));
+   blob_write_uint32(blob, prog->SamplersUsed);
+   blob_write_uint32(blob, prog->ShadowSamplers);
+   blob_write_uint32(blob, prog->UsesGather);
+   blob_write_uint32(blob, prog->ClipDistanceArraySize);
+   blob_write_bytes(blob, prog->SamplerUnits, sizeof(prog->SamplerUnits));
+   blob_write_uint32(blob, prog->IndirectRegisterFiles);
+   blob_write_uint32(blob, prog->NumTemporaries);
+   blob_write_uint32(blob, prog->NumParameters);
+   blob_write_uint32(blob, prog->NumAddressRegs);
+
+   write_program_parameters(blob, prog->Parameters);
+}
+
+static bool
+read_program_common(struct blob_reader *blob, struct gl_program *prog)
+{
+   prog->InputsRead = blob_read_uint64(blob);
+   prog->DoubleInputsRead = blob_read_uint64(blob);
+   prog->OutputsWritten = blob_read_uint64(blob);
+   prog->PatchInputsRead = blob_read_uint32(blob);
+   prog->PatchOutputsWritten = blob_read_uint32(blob);
+   prog->SystemValuesRead = blob_read_uint32(blob);
+   blob_copy_bytes(blob, (uint8_t *) prog->TexturesUsed,
+                   sizeof(prog->TexturesUsed));
+   prog->SamplersUsed = blob_read_uint32(blob);
+   prog->ShadowSamplers = blob_read_uint32(blob);
+   prog->UsesGather = blob_read_uint32(blob);
+   prog->ClipDistanceArraySize = blob_read_uint32(blob);
+   blob_copy_bytes(blob, (uint8_t *) prog->SamplerUnits,
+                   sizeof(prog->SamplerUnits));
+   prog->IndirectRegisterFiles = blob_read_uint32(blob);
+   prog->NumTemporaries = blob_read_uint32(blob);
+   prog->NumParameters = blob_read_uint32(blob);
+   prog->NumAddressRegs = blob_read_uint32(blob);
+
+   prog->Parameters = _mesa_new_parameter_list();
+   if (!prog->Parameters)
+      return false;
+
+   return read_program_parameters(blob, prog->Parameters);
+}
+
+/**
+ * Called via ctx->Driver.ShaderCacheSerializeDriverBlob()
+ */
+bool
+st_shader_cache_serialize(struct gl_context *ctx, struct gl_program *prog,
+                          struct blob *blob)
+{
+   switch (prog->Target) {
+   case GL_VERTEX_PROGRAM_ARB: {
+      struct st_vertex_program *stvp = (struct st_vertex_program *) prog;
+
+      if (!stvp->tgsi.tokens || stvp->tgsi.stream_output.num_outputs)
+         return false;
+
+      write_program_common(blob, prog);
+      blob_write_uint32(blob, stvp->num_inputs);
+      blob_write_bytes(blob, stvp->index_to_input,
+                       sizeof(stvp->index_to_input));
+      blob_write_bytes(blob, stvp->result_to_output,
+                       sizeof(stvp->result_to_output));
+      write_tgsi_tokens(blob, stvp->tgsi.tokens);
+      return true;
+   }
+   case GL_FRAGMENT_PROGRAM_ARB: {
+      struct st_fragment_program *stfp = (struct st_fragment_program *) prog;
+
+      if (!stfp->tgsi.tokens)
+         return false;
+
+      write_program_common(blob, prog);
+      blob_write_uint32(blob, stfp->Base.UsesKill);
+      blob_write_uint32(blob, stfp->Base.UsesDFdy);
+      blob_write_uint32(blob, stfp->Base.OriginUpperLeft);
+      blob_write_uint32(blob, stfp->Base.PixelCenterInteger);
+      blob_write_uint32(blob, stfp->Base.FragDepthLayout);
+      blob_write_bytes(blob, stfp->Base.InterpQualifier,
+                       sizeof(stfp->Base.InterpQualifier));
+      blob_write_uint64(blob, stfp->Base.IsCentroid);
+      blob_write_uint64(blob, stfp->Base.IsSample);
+      write_tgsi_tokens(blob, stfp->tgsi.tokens);
+      return true;
+   }
+   default:
+      return false;
+   }
+}
+
+/**
+ * Called via ctx->Driver.ShaderCacheDeserializeDriverBlob()
+ *
+ * This replaces get_mesa_program() and st_program_string_notify() for a
+ * freshly created \p prog.
+ */
+bool
+st_shader_cache_deserialize(struct gl_context *ctx,
+                            struct gl_shader_program *shProg,
+                            struct gl_program *prog,
+                            struct blob_reader *blob)
+{
+   struct st_context *st = st_context(ctx);
+
+   if (!read_program_common(blob, prog))
+      return false;
+
+   switch (prog->Target) {
+   case GL_VERTEX_PROGRAM_ARB: {
+      struct st_vertex_program *stvp = (struct st_vertex_program *) prog;
+
+      stvp->num_inputs = blob_read_uint32(blob);
+      blob_copy_bytes(blob, (uint8_t *) stvp->index_to_input,
+                      sizeof(stvp->index_to_input));
+      blob_copy_bytes(blob, (uint8_t *) stvp->result_to_output,
+                      sizeof(stvp->result_to_output));
+      stvp->tgsi.tokens = read_tgsi_tokens(blob);
+      if (!stvp->tgsi.tokens)
+         return false;
+      break;
+   }
+   case GL_FRAGMENT_PROGRAM_ARB: {
+      struct st_fragment_program *stfp = (struct st_fragment_program *) prog;
+
+      stfp->Base.UsesKill = blob_read_uint32(blob);
+      stfp->Base.UsesDFdy = blob_read_uint32(blob);
+      stfp->Base.OriginUpperLeft = blob_read_uint32(blob);
+      stfp->Base.PixelCenterInteger = blob_read_uint32(blob);
+      stfp->Base.FragDepthLayout = blob_read_uint32(blob);
+      blob_copy_bytes(blob, (uint8_t *) stfp->Base.InterpQualifier,
+                      sizeof(stfp->Base.InterpQualifier));
+      stfp->Base.IsCentroid = blob_read_uint64(blob);
+      stfp->Base.IsSample = blob_read_uint64(blob);
+      stfp->tgsi.tokens = read_tgsi_tokens(blob);
+      if (!stfp->tgsi.tokens)
+         return false;
+      break;
+   }
+   default:
+      return false;
+   }
+
+   /* Same as at the end of get_mesa_program(): leave room for the Bitmap
+    * and DrawPixels constants before the uniform storage is associated with
+    * the parameter list.
+    */
+   _mesa_reserve_parameter_storage(prog->Parameters, 8);
+   _mesa_associate_uniform_storage(ctx, shProg, prog->Parameters);
+   if (!shProg->LinkStatus)
+      return false;
+
+   /* As in st_program_string_notify(). */
+   if (ST_DEBUG & DEBUG_PRECOMPILE ||
+       st->shader_has_one_variant[_mesa_program_enum_to_shader_stage(prog->Target)])
+      st_precompile_shader_variant(st, prog);
+
+   return true;
+}
@@ -421,23 +421,23 @@ st_create_color_map_texture(struct gl_context *ctx)
  * If none is found an empty slot is initialized with a
  * template and returned instead.
  */
-struct pipe_sampler_view **
+struct st_sampler_view *
 st_texture_get_sampler_view(struct st_context *st,
                             struct st_texture_object *stObj)
 {
-   struct pipe_sampler_view *used = NULL, **free = NULL;
+   struct st_sampler_view *used = NULL, *free = NULL;
    GLuint i;
 
    for (i = 0; i < stObj->num_sampler_views; ++i) {
-      struct pipe_sampler_view **sv = &stObj->sampler_views[i];
+      struct st_sampler_view *sv = &stObj->sampler_views[i];
       /* Is the array entry used ? */
-      if (*sv) {
+      if (sv->view) {
          /* Yes, check if it's the right one */
-         if ((*sv)->context == st->pipe)
+         if (sv->view->context == st->pipe)
             return sv;
 
          /* Wasn't the right one, but remember it as template */
-         used = *sv;
+         used = sv;
       } else {
          /* Found a free slot, remember that */
          free = sv;
@@ -448,16 +448,21 @@ st_texture_get_sampler_view(struct st_context *st,
 
    if (!free) {
       /* Haven't even found a free one, resize the array */
-      GLuint old_size = stObj->num_sampler_views * sizeof(void *);
-      GLuint new_size = old_size + sizeof(void *);
+      GLuint old_size = stObj->num_sampler_views * sizeof(*free);
+      GLuint new_size = old_size + sizeof(*free);
       stObj->sampler_views = REALLOC(stObj->sampler_views, old_size, new_size);
       free = &stObj->sampler_views[stObj->num_sampler_views++];
-      *free = NULL;
+      free->view = NULL;
    }
 
    /* Add just any sampler view to be used as a template */
-   if (used)
-      pipe_sampler_view_reference(free, used);
+   if (used) {
+      pipe_sampler_view_reference(&free->view, used->view);
+      free->key = used->key;
+   }
+   else {
+      memset(&free->key, 0, sizeof(free->key));
+   }
 
    return free;
 }
@@ -474,7 +479,7 @@ st_texture_release_sampler_view(struct st_context *st,
    GLuint i;
 
    for (i = 0; i < stObj->num_sampler_views; ++i) {
-      struct pipe_sampler_view **sv = &stObj->sampler_views[i];
+      struct pipe_sampler_view **sv = &stObj->sampler_views[i].view;
 
       if (*sv && (*sv)->context == st->pipe) {
          pipe_sampler_view_reference(sv, NULL);
@@ -496,7 +501,7 @@ st_texture_release_all_sampler_views(struct st_context *st,
 
    /* XXX This should use sampler_views[i]->pipe, not st->pipe */
    for (i = 0; i < stObj->num_sampler_views; ++i)
-      pipe_sampler_view_release(st->pipe, &stObj->sampler_views[i]);
+      pipe_sampler_view_release(st->pipe, &stObj->sampler_views[i].view);
 }
 
 
@@ -68,6 +68,42 @@ struct st_texture_image
 };
 
 
+/**
+ * The GL state a sampler view was created from.
+ *
+ * These are the raw inputs of the view's format, swizzle and level/layer
+ * range, so that revalidating a view in the steady state is a single
+ * memcmp() instead of recomputing the view template.  Some of them can
+ * change without the driver being notified (e.g. glTexParameterIiv), so
+ * they are compared on every validation rather than invalidated.
+ */
+struct st_sampler_view_key
+{
+   enum pipe_format format;
+   GLenum target;
+   GLenum base_format;       /**< of the base image */
+   GLenum internal_format;   /**< of the base image */
+   GLenum depth_mode;
+   GLuint swizzle;           /**< gl_texture_object::_Swizzle */
+   GLuint min_level, base_level, max_level, num_levels;
+   GLuint min_layer, num_layers;
+   GLintptr buffer_offset;
+   GLsizeiptr buffer_size;
+   GLboolean immutable;
+   GLboolean glsl130;        /**< shader uses GLSL 1.30 or later */
+};
+
+
+/**
+ * A sampler view of a texture object, for one context.
+ */
+struct st_sampler_view
+{
+   struct pipe_sampler_view *view;
+   struct st_sampler_view_key key;
+};
+
+
 /**
  * Subclass of gl_texure_object.
  */
@@ -96,7 +132,7 @@ struct st_texture_object
    /* Array of sampler views (one per context) attached to this texture
     * object. Created lazily on first binding in context.
     */
-   struct pipe_sampler_view **sampler_views;
+   struct st_sampler_view *sampler_views;
 
    /* True if this texture comes from the window system. Such a texture
     * cannot be reallocated and the format can only be changed with a sampler
@@ -236,7 +272,7 @@ st_texture_image_copy(struct pipe_context *pipe,
 extern struct pipe_resource *
 st_create_color_map_texture(struct gl_context *ctx);
 
-extern struct pipe_sampler_view **
+extern struct st_sampler_view *
 st_texture_get_sampler_view(struct st_context *st,
                             struct st_texture_object *stObj);
 
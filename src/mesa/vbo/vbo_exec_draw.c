@@ -237,7 +237,7 @@ vbo_exec_bind_arrays( struct gl_context *ctx )
             assert(exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Pointer);
             assert(offset >= 0);
             arrays[attr].Ptr = (GLubyte *)
-               exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset + offset;
+               (GLintptr) exec->vtx.buffer_used + offset;
          }
          else {
             /* Ptr into ordinary app memory */
@@ -265,6 +265,17 @@ vbo_exec_bind_arrays( struct gl_context *ctx )
 }
 
 
+/**
+ * Whether the VBO is kept mapped across draws.  This needs persistent and
+ * coherent mappings, which are available along with ARB_buffer_storage.
+ */
+static inline bool
+vbo_exec_persistent_vtx_map(const struct gl_context *ctx)
+{
+   return ctx->Extensions.ARB_buffer_storage;
+}
+
+
 /**
  * Unmap the VBO.  This is called before drawing.
  */
@@ -274,7 +285,8 @@ vbo_exec_vtx_unmap( struct vbo_exec_context *exec )
    if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
       struct gl_context *ctx = exec->ctx;
 
-      if (ctx->Driver.FlushMappedBufferRange) {
+      if (ctx->Driver.FlushMappedBufferRange &&
+          !vbo_exec_persistent_vtx_map(ctx)) {
          GLintptr offset = exec->vtx.buffer_used -
                            exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
          GLsizeiptr length = (exec->vtx.buffer_ptr - exec->vtx.buffer_map) *
@@ -300,6 +312,28 @@ vbo_exec_vtx_unmap( struct vbo_exec_context *exec )
 }
 
 
+/**
+ * With a persistent mapping, move the start of the mapped range past the
+ * vertices which were just drawn.  Those are never written again: once the
+ * VBO is full, its storage is replaced by vbo_exec_vtx_map(), so no fence
+ * is needed to wait for the GPU.
+ */
+static void
+vbo_exec_vtx_advance(struct vbo_exec_context *exec)
+{
+   exec->vtx.buffer_used += (exec->vtx.buffer_ptr -
+                             exec->vtx.buffer_map) * sizeof(float);
+   assert(exec->vtx.buffer_used <= VBO_VERT_BUFFER_SIZE);
+
+   exec->vtx.buffer_map = exec->vtx.buffer_ptr;
+
+   if (VBO_VERT_BUFFER_SIZE <= exec->vtx.buffer_used + 1024) {
+      vbo_exec_vtx_unmap(exec);
+      vbo_exec_vtx_map(exec);
+   }
+}
+
+
 /**
  * Map the vertex buffer to begin storing glVertex, glColor, etc data.
  */
@@ -307,20 +341,45 @@ void
 vbo_exec_vtx_map( struct vbo_exec_context *exec )
 {
    struct gl_context *ctx = exec->ctx;
-   const GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
-                              GL_MAP_INVALIDATE_RANGE_BIT |
-                              GL_MAP_UNSYNCHRONIZED_BIT |
-                              GL_MAP_FLUSH_EXPLICIT_BIT |
-                              MESA_MAP_NOWAIT_BIT;
+   const bool persistent = vbo_exec_persistent_vtx_map(ctx);
+   GLbitfield accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
+                            GL_MAP_UNSYNCHRONIZED_BIT;
+   GLbitfield storageFlags = GL_MAP_WRITE_BIT |
+                             GL_DYNAMIC_STORAGE_BIT |
+                             GL_CLIENT_STORAGE_BIT;
    const GLenum usage = GL_STREAM_DRAW_ARB;
 
    if (!_mesa_is_bufferobj(exec->vtx.bufferobj))
       return;
 
+   if (persistent) {
+      /* The whole buffer is mapped once and stays mapped until it's full.
+       * vbo_copy_vertices() reads back from it, so map it for reading too.
+       */
+      accessRange |= GL_MAP_PERSISTENT_BIT |
+                     GL_MAP_COHERENT_BIT |
+                     GL_MAP_READ_BIT;
+      storageFlags |= GL_MAP_PERSISTENT_BIT |
+                      GL_MAP_COHERENT_BIT |
+                      GL_MAP_READ_BIT;
+
+      /* Still mapped from the previous vertices. */
+      if (exec->vtx.buffer_map)
+         return;
+   }
+   else {
+      accessRange |= GL_MAP_INVALIDATE_RANGE_BIT |
+                     GL_MAP_FLUSH_EXPLICIT_BIT |
+                     MESA_MAP_NOWAIT_BIT;
+   }
+
    assert(!exec->vtx.buffer_map);
    assert(!exec->vtx.buffer_ptr);
 
-   if (VBO_VERT_BUFFER_SIZE > exec->vtx.buffer_used + 1024) {
+   /* The storage made by vbo_use_buffer_objects() can't be mapped
+    * persistently, so a persistent mapping always starts with new storage.
+    */
+   if (!persistent && VBO_VERT_BUFFER_SIZE > exec->vtx.buffer_used + 1024) {
       /* The VBO exists and there's room for more */
       if (exec->vtx.bufferobj->Size > 0) {
          exec->vtx.buffer_map =
@@ -344,10 +403,7 @@ vbo_exec_vtx_map( struct vbo_exec_context *exec )
 
       if (ctx->Driver.BufferData(ctx, GL_ARRAY_BUFFER_ARB,
                                  VBO_VERT_BUFFER_SIZE,
-                                 NULL, usage,
-                                 GL_MAP_WRITE_BIT |
-                                 GL_DYNAMIC_STORAGE_BIT |
-                                 GL_CLIENT_STORAGE_BIT,
+                                 NULL, usage, storageFlags,
                                  exec->vtx.bufferobj)) {
          /* buffer allocation worked, now map the buffer */
          exec->vtx.buffer_map =
@@ -411,7 +467,8 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
          if (ctx->NewState)
             _mesa_update_state( ctx );
 
-         if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
+         if (_mesa_is_bufferobj(exec->vtx.bufferobj) &&
+             !vbo_exec_persistent_vtx_map(ctx)) {
             vbo_exec_vtx_unmap( exec );
          }
 
@@ -429,9 +486,13 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
 				       NULL, 0, NULL);
 
 	 /* If using a real VBO, get new storage -- unless asked not to.
+          * A persistent mapping is kept, as nothing else maps this VBO.
           */
-         if (_mesa_is_bufferobj(exec->vtx.bufferobj) && !keepUnmapped) {
-            vbo_exec_vtx_map( exec );
+         if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
+            if (vbo_exec_persistent_vtx_map(ctx))
+               vbo_exec_vtx_advance( exec );
+            else if (!keepUnmapped)
+               vbo_exec_vtx_map( exec );
          }
       }
    }
@@ -440,6 +501,7 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
     */
    if (keepUnmapped &&
        _mesa_is_bufferobj(exec->vtx.bufferobj) &&
+       !vbo_exec_persistent_vtx_map(exec->ctx) &&
        exec->vtx.buffer_map) {
       vbo_exec_vtx_unmap( exec );
    }
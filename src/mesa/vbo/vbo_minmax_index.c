@@ -243,21 +243,45 @@ vbo_get_minmax_index(struct gl_context *ctx,
    const GLuint restartIndex = _mesa_primitive_restart_index(ctx, ib->type);
    const int index_size = vbo_sizeof_ib_type(ib->type);
    const char *indices;
+   GLintptr offset = 0;
    GLuint i;
 
    indices = (char *) ib->ptr + prim->start * index_size;
    if (_mesa_is_bufferobj(ib->obj)) {
       GLsizeiptr size = MIN2(count * index_size, ib->obj->Size);
 
-      if (vbo_get_minmax_cached(ib->obj, ib->type, (GLintptr) indices, count,
+      /* The cache is keyed on the offset of the indices in the buffer. */
+      offset = (GLintptr) indices;
+      if (vbo_get_minmax_cached(ib->obj, ib->type, offset, count,
                                 min_index, max_index))
          return;
 
-      indices = ctx->Driver.MapBufferRange(ctx, (GLintptr) indices, size,
+      indices = ctx->Driver.MapBufferRange(ctx, offset, size,
                                            GL_MAP_READ_BIT, ib->obj,
                                            MAP_INTERNAL);
    }
 
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1) {
+      switch (ib->type) {
+      case GL_UNSIGNED_INT:
+         _mesa_uint_array_min_max((const GLuint *)indices, min_index,
+                                  max_index, count, restart, restartIndex);
+         break;
+      case GL_UNSIGNED_SHORT:
+         _mesa_ushort_array_min_max((const GLushort *)indices, min_index,
+                                    max_index, count, restart, restartIndex);
+         break;
+      case GL_UNSIGNED_BYTE:
+         _mesa_ubyte_array_min_max((const GLubyte *)indices, min_index,
+                                   max_index, count, restart, restartIndex);
+         break;
+      default:
+         unreachable("not reached");
+      }
+   }
+   else
+#endif
    switch (ib->type) {
    case GL_UNSIGNED_INT: {
       const GLuint *ui_indices = (const GLuint *)indices;
@@ -272,16 +296,10 @@ vbo_get_minmax_index(struct gl_context *ctx,
          }
       }
       else {
-#if defined(USE_SSE41)
-         if (cpu_has_sse4_1) {
-            _mesa_uint_array_min_max(ui_indices, &min_ui, &max_ui, count);
+         for (i = 0; i < count; i++) {
+            if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
+            if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
          }
-         else
-#endif
-            for (i = 0; i < count; i++) {
-               if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-               if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
-            }
       }
       *min_index = min_ui;
       *max_index = max_ui;
@@ -336,7 +354,7 @@ vbo_get_minmax_index(struct gl_context *ctx,
    }
 
    if (_mesa_is_bufferobj(ib->obj)) {
-      vbo_minmax_cache_store(ctx, ib->obj, ib->type, prim->start, count,
+      vbo_minmax_cache_store(ctx, ib->obj, ib->type, offset, count,
                              *min_index, *max_index);
       ctx->Driver.UnmapBuffer(ctx, ib->obj, MAP_INTERNAL);
    }
@@ -81,6 +81,16 @@ struct vbo_save_vertex_list {
    struct _mesa_prim *prim;
    GLuint prim_count;
 
+   /**
+    * The primitives above merged into a single indexed draw of points,
+    * lines or triangles, with identical vertices collapsed onto one index.
+    * merged_bufferobj holds the GL_UNSIGNED_SHORT indices, it is NULL if
+    * the primitives couldn't be merged.
+    */
+   struct _mesa_prim merged_prim;
+   struct gl_buffer_object *merged_bufferobj;
+   GLboolean merged_last_vertex_only; /**< strips/fans became triangles */
+
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
 };
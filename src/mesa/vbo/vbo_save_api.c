@@ -78,6 +78,7 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "main/api_arrayelt.h"
 #include "main/vtxfmt.h"
 #include "main/dispatch.h"
+#include "util/hash_table.h"
 
 #include "vbo_context.h"
 #include "vbo_noop.h"
@@ -405,6 +406,195 @@ convert_line_loop_to_strip(struct vbo_save_context *save,
 }
 
 
+/**
+ * Return the mode of the indexed draw a primitive can be merged into, or
+ * GL_POLYGON if it can't be merged.  Strips and fans can only be turned
+ * into triangles as long as their edges and last vertices are kept, so
+ * line strips, quads and polygons are left alone.
+ */
+static GLenum
+get_merged_mode(GLenum mode)
+{
+   switch (mode) {
+   case GL_POINTS:
+   case GL_LINES:
+      return mode;
+   case GL_TRIANGLES:
+   case GL_TRIANGLE_STRIP:
+   case GL_TRIANGLE_FAN:
+      return GL_TRIANGLES;
+   default:
+      return GL_POLYGON;
+   }
+}
+
+
+static GLuint
+get_merged_index_count(const struct _mesa_prim *prim)
+{
+   switch (prim->mode) {
+   case GL_POINTS:
+      return prim->count;
+   case GL_LINES:
+      return prim->count & ~1;
+   case GL_TRIANGLES:
+      return prim->count - prim->count % 3;
+   default:
+      return prim->count >= 3 ? (prim->count - 2) * 3 : 0;
+   }
+}
+
+
+/**
+ * Map each vertex of the list to the first one with the same contents.
+ * Returns false if we ran out of memory.
+ */
+static bool
+dedup_vertices(const fi_type *vertices, GLuint count, GLuint vertex_size,
+               GLushort *remap)
+{
+   const size_t stride = vertex_size * sizeof(fi_type);
+   GLuint table_size = 1;
+   GLushort *table;
+   GLuint i;
+
+   while (table_size < count * 2)
+      table_size <<= 1;
+
+   table = malloc(table_size * sizeof(GLushort));
+   if (!table)
+      return false;
+
+   memset(table, 0xff, table_size * sizeof(GLushort));
+
+   for (i = 0; i < count; i++) {
+      const fi_type *v = vertices + i * vertex_size;
+      GLuint slot = _mesa_hash_data(v, stride) & (table_size - 1);
+
+      while (table[slot] != 0xffff &&
+             memcmp(vertices + table[slot] * vertex_size, v, stride) != 0)
+         slot = (slot + 1) & (table_size - 1);
+
+      if (table[slot] == 0xffff)
+         table[slot] = i;
+      remap[i] = table[slot];
+   }
+
+   free(table);
+   return true;
+}
+
+
+/**
+ * Try to turn the primitives of a vertex list into a single indexed draw,
+ * so that replaying lists made of many small glBegin/glEnd pairs doesn't
+ * cost a draw call per primitive.  The indices are stored in a buffer
+ * object of their own which is never modified after this.
+ */
+static void
+compile_merged_draw(struct gl_context *ctx,
+                    struct vbo_save_vertex_list *node,
+                    const fi_type *vertices)
+{
+   GLenum mode = GL_POLYGON;
+   GLuint index_count = 0;
+   GLushort *remap, *indices, *out;
+   struct gl_buffer_object *bufferobj;
+   GLuint i, j;
+
+   node->merged_bufferobj = NULL;
+   node->merged_last_vertex_only = GL_FALSE;
+
+   /* Edge flags only apply to separate triangles, keep strips and fans
+    * as they are then.
+    */
+   if (node->prim_count < 2 || node->attrsz[VBO_ATTRIB_EDGEFLAG] ||
+       node->count > 0xffff)
+      return;
+
+   for (i = 0; i < node->prim_count; i++) {
+      const struct _mesa_prim *prim = &node->prim[i];
+      GLenum prim_mode = get_merged_mode(prim->mode);
+
+      if (prim_mode == GL_POLYGON || (i > 0 && prim_mode != mode) ||
+          prim->num_instances != 1 || prim->base_instance != 0)
+         return;
+
+      if (prim->mode == GL_TRIANGLE_STRIP || prim->mode == GL_TRIANGLE_FAN)
+         node->merged_last_vertex_only = GL_TRUE;
+
+      mode = prim_mode;
+      index_count += get_merged_index_count(prim);
+   }
+
+   if (index_count == 0)
+      return;
+
+   remap = malloc(node->count * sizeof(GLushort));
+   indices = malloc(index_count * sizeof(GLushort));
+   if (!remap || !indices ||
+       !dedup_vertices(vertices, node->count, node->vertex_size, remap))
+      goto done;
+
+   out = indices;
+   for (i = 0; i < node->prim_count; i++) {
+      const struct _mesa_prim *prim = &node->prim[i];
+      const GLushort *v = remap + prim->start;
+      const GLuint count = get_merged_index_count(prim);
+
+      switch (prim->mode) {
+      case GL_TRIANGLE_STRIP:
+         /* Every other triangle has its first two vertices swapped to keep
+          * the winding, the last vertex stays the same.
+          */
+         for (j = 0; j < count / 3; j++) {
+            *out++ = v[j + (j & 1)];
+            *out++ = v[j + 1 - (j & 1)];
+            *out++ = v[j + 2];
+         }
+         break;
+      case GL_TRIANGLE_FAN:
+         for (j = 0; j < count / 3; j++) {
+            *out++ = v[0];
+            *out++ = v[j + 1];
+            *out++ = v[j + 2];
+         }
+         break;
+      default:
+         memcpy(out, v, count * sizeof(GLushort));
+         out += count;
+         break;
+      }
+   }
+   assert(out == indices + index_count);
+
+   bufferobj = ctx->Driver.NewBufferObject(ctx, VBO_BUF_ID);
+   if (!bufferobj)
+      goto done;
+
+   if (!ctx->Driver.BufferData(ctx, GL_ELEMENT_ARRAY_BUFFER_ARB,
+                               index_count * sizeof(GLushort), indices,
+                               GL_STATIC_DRAW_ARB, GL_MAP_READ_BIT,
+                               bufferobj)) {
+      _mesa_reference_buffer_object(ctx, &bufferobj, NULL);
+      goto done;
+   }
+
+   memset(&node->merged_prim, 0, sizeof(node->merged_prim));
+   node->merged_prim.mode = mode;
+   node->merged_prim.indexed = 1;
+   node->merged_prim.begin = 1;
+   node->merged_prim.end = 1;
+   node->merged_prim.count = index_count;
+   node->merged_prim.num_instances = 1;
+   node->merged_bufferobj = bufferobj;
+
+done:
+   free(remap);
+   free(indices);
+}
+
+
 /**
  * Insert the active immediate struct onto the display list currently
  * being built.
@@ -492,6 +682,8 @@ _save_compile_vertex_list(struct gl_context *ctx)
 
    merge_prims(node->prim, &node->prim_count);
 
+   compile_merged_draw(ctx, node, save->buffer);
+
    /* Deal with GL_COMPILE_AND_EXECUTE:
     */
    if (ctx->ExecuteFlag) {
@@ -1581,6 +1773,8 @@ vbo_destroy_vertex_list(struct gl_context *ctx, void *data)
    if (--node->prim_store->refcount == 0)
       free(node->prim_store);
 
+   _mesa_reference_buffer_object(ctx, &node->merged_bufferobj, NULL);
+
    free(node->current_data);
    node->current_data = NULL;
 }
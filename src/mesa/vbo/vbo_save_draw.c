@@ -240,6 +240,36 @@ vbo_save_loopback_vertex_list(struct gl_context *ctx,
 }
 
 
+/**
+ * Whether the merged indexed draw of a vertex list gives the same results
+ * as its original primitives with the current state.
+ */
+static bool
+can_draw_merged(struct gl_context *ctx,
+                const struct vbo_save_vertex_list *node)
+{
+   const struct gl_vertex_program *vp = ctx->VertexProgram._Current;
+
+   if (!node->merged_bufferobj)
+      return false;
+
+   /* Strips and fans turned into triangles only keep the last vertex of
+    * each triangle in place.
+    */
+   if (node->merged_last_vertex_only &&
+       ctx->Light.ProvokingVertex != GL_LAST_VERTEX_CONVENTION_EXT)
+      return false;
+
+   /* Identical vertices share an index, which changes gl_VertexID. */
+   if (vp && (vp->Base.SystemValuesRead &
+              ((1 << SYSTEM_VALUE_VERTEX_ID) |
+               (1 << SYSTEM_VALUE_VERTEX_ID_ZERO_BASE))))
+      return false;
+
+   return true;
+}
+
+
 /**
  * Execute the buffer and save copied verts.
  * This is called from the display list code when executing
@@ -306,7 +336,24 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
       if (ctx->NewState)
 	 _mesa_update_state( ctx );
 
-      if (node->count > 0) {
+      if (node->count > 0 && can_draw_merged(ctx, node)) {
+         struct _mesa_index_buffer ib;
+
+         ib.count = node->merged_prim.count;
+         ib.type = GL_UNSIGNED_SHORT;
+         ib.obj = node->merged_bufferobj;
+         ib.ptr = NULL;
+
+         vbo_context(ctx)->draw_prims(ctx,
+                                      &node->merged_prim,
+                                      1,
+                                      &ib,
+                                      GL_TRUE,
+                                      0,
+                                      node->count - 1,
+                                      NULL, 0, NULL);
+      }
+      else if (node->count > 0) {
          vbo_context(ctx)->draw_prims(ctx, 
                                       node->prim,
                                       node->prim_count,
@@ -0,0 +1,800 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef ENABLE_SHADER_CACHE
+
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/file.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <errno.h>
+#include <dirent.h>
+
+#include "util/u_atomic.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+#include "util/debug.h"
+
+#include "disk_cache.h"
+
+/* Number of bits to mask off from a cache key to get an index. */
+#define CACHE_INDEX_KEY_BITS 16
+
+/* Mask for computing an index from a key. */
+#define CACHE_INDEX_KEY_MASK ((1 << CACHE_INDEX_KEY_BITS) - 1)
+
+/* The number of keys that can be stored in the index. */
+#define CACHE_INDEX_MAX_KEYS (1 << CACHE_INDEX_KEY_BITS)
+
+/* Temporary files older than this (in seconds) are assumed to have been
+ * left behind by a process that died while writing them.
+ */
+#define CACHE_STALE_TMP_FILE_AGE 60
+
+struct disk_cache {
+   /* The path to the cache directory. */
+   char *path;
+
+   /* A pointer to the mmapped index file within the cache directory. */
+   uint8_t *index_mmap;
+   size_t index_mmap_size;
+
+   /* Pointer to total size of all objects in cache (within index_mmap) */
+   uint64_t *size;
+
+   /* Pointer to stored keys, (within index_mmap). */
+   uint8_t *stored_keys;
+
+   /* Maximum size of all cached objects (in bytes). */
+   uint64_t max_size;
+};
+
+/* Create a directory named 'path' if it does not already exist.
+ *
+ * Returns: 0 if path already exists as a directory or if created.
+ *         -1 in all other cases.
+ */
+static int
+mkdir_if_needed(const char *path)
+{
+   struct stat sb;
+   int ret;
+
+   /* If the path exists already, then our work is done if it's a
+    * directory, but it's an error if it is not.
+    */
+   if (stat(path, &sb) == 0) {
+      if (S_ISDIR(sb.st_mode)) {
+         return 0;
+      } else {
+         fprintf(stderr, "Cannot use %s for shader cache (not a directory)"
+                         "---disabling.\n", path);
+         return -1;
+      }
+   }
+
+   ret = mkdir(path, 0755);
+   if (ret == 0 || (ret == -1 && errno == EEXIST))
+     return 0;
+
+   fprintf(stderr, "Failed to create %s for shader cache (%s)---disabling.\n",
+           path, strerror(errno));
+
+   return -1;
+}
+
+/* Concatenate an existing path and a new name to form a new path.  If the new
+ * path does not exist as a directory, create it then return the resulting
+ * name of the new path (ralloc'ed off of 'ctx').
+ *
+ * Returns NULL on any error, such as:
+ *
+ *      <path> does not exist or is not a directory
+ *      <path>/<name> exists but is not a directory
+ *      <path>/<name> cannot be created as a directory
+ */
+static char *
+concatenate_and_mkdir(void *ctx, const char *path, const char *name)
+{
+   char *new_path;
+   struct stat sb;
+
+   if (stat(path, &sb) != 0 || ! S_ISDIR(sb.st_mode))
+      return NULL;
+
+   new_path = ralloc_asprintf(ctx, "%s/%s", path, name);
+
+   if (mkdir_if_needed(new_path) == 0)
+      return new_path;
+   else
+      return NULL;
+}
+
+/* Parse a size with an optional K/M/G suffix, returning 0 if the string
+ * cannot be parsed.
+ */
+static uint64_t
+parse_cache_size(const char *str)
+{
+   char *end;
+   uint64_t size = strtoul(str, &end, 10);
+
+   if (end == str)
+      return 0;
+
+   switch (*end) {
+   case 'K':
+   case 'k':
+      size *= 1024;
+      break;
+   case 'M':
+   case 'm':
+      size *= 1024*1024;
+      break;
+   case '\0':
+   case 'G':
+   case 'g':
+   default:
+      size *= 1024*1024*1024;
+      break;
+   }
+
+   return size;
+}
+
+struct disk_cache *
+disk_cache_create(const char *gpu_name, const char *timestamp)
+{
+   void *local;
+   struct disk_cache *cache = NULL;
+   char *path, *max_size_str;
+   uint64_t max_size;
+   int fd = -1;
+   struct stat sb;
+   size_t size;
+
+   /* If running as a users other than the real user disable cache */
+   if (geteuid() != getuid())
+      return NULL;
+
+   /* A ralloc context for transient data during this invocation. */
+   local = ralloc_context(NULL);
+   if (local == NULL)
+      goto fail;
+
+   /* At user request, disable shader cache entirely. */
+   if (env_var_as_boolean("MESA_GLSL_CACHE_DISABLE", false))
+      goto fail;
+
+   /* Determine path for cache based on the first defined name as follows:
+    *
+    *   $MESA_GLSL_CACHE_DIR
+    *   $XDG_CACHE_HOME/mesa
+    *   <pwd.pw_dir>/.cache/mesa
+    */
+   path = getenv("MESA_GLSL_CACHE_DIR");
+   if (path) {
+      if (mkdir_if_needed(path) == -1)
+         goto fail;
+   }
+
+   if (path == NULL) {
+      char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+
+      if (xdg_cache_home) {
+         if (mkdir_if_needed(xdg_cache_home) == -1)
+            goto fail;
+
+         path = concatenate_and_mkdir(local, xdg_cache_home, "mesa");
+         if (path == NULL)
+            goto fail;
+      }
+   }
+
+   if (path == NULL) {
+      char *buf;
+      size_t buf_size;
+      struct passwd pwd, *result;
+
+      buf_size = sysconf(_SC_GETPW_R_SIZE_MAX);
+      if (buf_size == -1)
+         buf_size = 512;
+
+      /* Loop until buf_size is large enough to query the directory */
+      while (1) {
+         buf = ralloc_size(local, buf_size);
+
+         getpwuid_r(getuid(), &pwd, buf, buf_size, &result);
+         if (result)
+            break;
+
+         if (errno == ERANGE) {
+            ralloc_free(buf);
+            buf = NULL;
+            buf_size *= 2;
+         } else {
+            goto fail;
+         }
+      }
+
+      path = concatenate_and_mkdir(local, pwd.pw_dir, ".cache");
+      if (path == NULL)
+         goto fail;
+
+      path = concatenate_and_mkdir(local, path, "mesa");
+      if (path == NULL)
+         goto fail;
+   }
+
+   /* Keep entries of different driver builds and different devices apart,
+    * so that a driver update never sees binaries produced by another build.
+    */
+   if (timestamp) {
+      path = concatenate_and_mkdir(local, path, timestamp);
+      if (path == NULL)
+         goto fail;
+   }
+
+   if (gpu_name) {
+      /* Device names such as "AMD TONGA (DRM 3.1.0 / 4.5)" may contain
+       * path separators.
+       */
+      char *name = ralloc_strdup(local, gpu_name), *c;
+
+      for (c = name; *c; c++) {
+         if (*c == '/')
+            *c = '_';
+      }
+
+      path = concatenate_and_mkdir(local, path, name);
+      if (path == NULL)
+         goto fail;
+   }
+
+   cache = ralloc(NULL, struct disk_cache);
+   if (cache == NULL)
+      goto fail;
+
+   cache->path = ralloc_strdup(cache, path);
+   if (cache->path == NULL)
+      goto fail;
+
+   path = ralloc_asprintf(local, "%s/index", cache->path);
+   if (path == NULL)
+      goto fail;
+
+   fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   if (fd == -1)
+      goto fail;
+
+   if (fstat(fd, &sb) == -1)
+      goto fail;
+
+   /* Force the index file to be the expected size. */
+   size = sizeof(*cache->size) + CACHE_INDEX_MAX_KEYS * CACHE_KEY_SIZE;
+   if (sb.st_size != size) {
+      if (ftruncate(fd, size) == -1)
+         goto fail;
+   }
+
+   /* We map this shared so that other processes see updates that we
+    * make.
+    *
+    * Note: We do use atomic addition to ensure that multiple
+    * processes don't scramble the cache size recorded in the
+    * index. But we don't use any locking to prevent multiple
+    * processes from updating the same entry simultaneously. The idea
+    * is that if either result lands entirely in the index, then
+    * that's equivalent to a well-ordered write followed by an
+    * eviction and a write. On the other hand, if the simultaneous
+    * writes result in a corrupt entry, that's not really any
+    * different than both entries being evicted, (since within the
+    * guarantees of the cryptographic hash, a corrupt entry is
+    * unlikely to ever match a real cache key).
+    */
+   cache->index_mmap = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+   if (cache->index_mmap == MAP_FAILED)
+      goto fail;
+   cache->index_mmap_size = size;
+
+   close(fd);
+   fd = -1;
+
+   cache->size = (uint64_t *) cache->index_mmap;
+   cache->stored_keys = cache->index_mmap + sizeof(uint64_t);
+
+   max_size = 0;
+
+   max_size_str = getenv("MESA_GLSL_CACHE_MAX_SIZE");
+   if (max_size_str)
+      max_size = parse_cache_size(max_size_str);
+
+   /* Default to 1GB for maximum cache size. */
+   if (max_size == 0)
+      max_size = 1024*1024*1024;
+
+   cache->max_size = max_size;
+
+   ralloc_free(local);
+
+   return cache;
+
+ fail:
+   if (fd != -1)
+      close(fd);
+   if (cache)
+      ralloc_free(cache);
+   ralloc_free(local);
+
+   return NULL;
+}
+
+void
+disk_cache_destroy(struct disk_cache *cache)
+{
+   if (cache == NULL)
+      return;
+
+   munmap(cache->index_mmap, cache->index_mmap_size);
+
+   ralloc_free(cache);
+}
+
+/* Return a filename within the cache's directory corresponding to 'key'. The
+ * returned filename is ralloced with 'cache' as the parent context.
+ *
+ * Returns NULL if out of memory.
+ */
+static char *
+get_cache_file(struct disk_cache *cache, const cache_key key)
+{
+   char buf[41];
+
+   _mesa_sha1_format(buf, key);
+
+   return ralloc_asprintf(cache, "%s/%c%c/%s",
+                          cache->path, buf[0], buf[1], buf + 2);
+}
+
+/* Create the directory that will be needed for the cache file for \key.
+ *
+ * Obviously, the implementation here must closely match
+ * _get_cache_file above.
+*/
+static void
+make_cache_file_directory(struct disk_cache *cache, const cache_key key)
+{
+   char *dir;
+   char buf[41];
+
+   _mesa_sha1_format(buf, key);
+
+   dir = ralloc_asprintf(cache, "%s/%c%c", cache->path, buf[0], buf[1]);
+
+   mkdir_if_needed(dir);
+
+   ralloc_free(dir);
+}
+
+/* Does the given string end in ".tmp"? */
+static bool
+is_tmp_file(const char *name)
+{
+   size_t len = strlen(name);
+
+   return len > 4 && strcmp(name + len - 4, ".tmp") == 0;
+}
+
+/* Is entry a two-character sub-directory of the cache? */
+static bool
+is_two_character_sub_directory(const struct dirent *entry, const char *path)
+{
+   struct stat sb;
+   char *subdir;
+   bool result;
+
+   if (strlen(entry->d_name) != 2 ||
+       !isxdigit(entry->d_name[0]) || !isxdigit(entry->d_name[1]))
+      return false;
+
+   subdir = ralloc_asprintf(NULL, "%s/%s", path, entry->d_name);
+   result = stat(subdir, &sb) == 0 && S_ISDIR(sb.st_mode);
+   ralloc_free(subdir);
+
+   return result;
+}
+
+/* Return the name of a random entry of the directory \path that matches
+ * \predicate, (ralloc'ed off of \ctx), or NULL if there is none.
+ */
+static char *
+choose_random_entry_matching(void *ctx, const char *path,
+                             bool (*predicate)(const struct dirent *,
+                                               const char *))
+{
+   DIR *dir;
+   struct dirent *entry;
+   unsigned count, victim;
+   char *result = NULL;
+
+   dir = opendir(path);
+   if (dir == NULL)
+      return NULL;
+
+   /* First count the number of matching entries. */
+   count = 0;
+   while ((entry = readdir(dir)) != NULL) {
+      if (predicate(entry, path))
+         count++;
+   }
+
+   if (count == 0)
+      goto out;
+
+   /* Then pick one at random and walk the directory again to find it. */
+   victim = rand() % count;
+
+   rewinddir(dir);
+   count = 0;
+   while ((entry = readdir(dir)) != NULL) {
+      if (!predicate(entry, path))
+         continue;
+      if (count++ == victim) {
+         result = ralloc_asprintf(ctx, "%s/%s", path, entry->d_name);
+         break;
+      }
+   }
+
+ out:
+   closedir(dir);
+
+   return result;
+}
+
+/* Return the least-recently-used regular cache file within the directory
+ * \path, (ralloc'ed off of \ctx), or NULL if the directory has none.
+ */
+static char *
+choose_lru_file(void *ctx, const char *path)
+{
+   DIR *dir;
+   struct dirent *entry;
+   char *lru_name = NULL;
+   time_t lru_atime = 0;
+
+   dir = opendir(path);
+   if (dir == NULL)
+      return NULL;
+
+   while ((entry = readdir(dir)) != NULL) {
+      struct stat sb;
+      char *filename;
+
+      if (is_tmp_file(entry->d_name))
+         continue;
+
+      filename = ralloc_asprintf(ctx, "%s/%s", path, entry->d_name);
+      if (stat(filename, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+         ralloc_free(filename);
+         continue;
+      }
+
+      if (lru_name == NULL || sb.st_atime < lru_atime) {
+         ralloc_free(lru_name);
+         lru_name = filename;
+         lru_atime = sb.st_atime;
+      } else {
+         ralloc_free(filename);
+      }
+   }
+
+   closedir(dir);
+
+   return lru_name;
+}
+
+/* Remove \filename from the cache, updating the recorded cache size. */
+static void
+unlink_and_account(struct disk_cache *cache, const char *filename)
+{
+   struct stat sb;
+
+   if (stat(filename, &sb) == -1)
+      return;
+
+   if (unlink(filename) == 0 && sb.st_blocks)
+      p_atomic_add(cache->size, - (uint64_t) sb.st_blocks * 512);
+}
+
+/* Evict the least-recently-used file of a randomly chosen sub-directory.
+ *
+ * Picking the directory at random keeps eviction O(directory size) instead
+ * of requiring a global LRU list shared (and locked) between processes,
+ * while still approximately evicting the oldest entries.
+ */
+static void
+evict_random_lru_file(struct disk_cache *cache)
+{
+   char *dir_path, *filename;
+
+   dir_path = choose_random_entry_matching(cache, cache->path,
+                                           is_two_character_sub_directory);
+   if (dir_path == NULL)
+      return;
+
+   filename = choose_lru_file(cache, dir_path);
+   if (filename == NULL) {
+      /* Remove empty directories so they don't keep getting picked. */
+      rmdir(dir_path);
+      ralloc_free(dir_path);
+      return;
+   }
+
+   unlink_and_account(cache, filename);
+
+   ralloc_free(filename);
+   ralloc_free(dir_path);
+}
+
+void
+disk_cache_remove(struct disk_cache *cache, const cache_key key)
+{
+   char *filename;
+
+   filename = get_cache_file(cache, key);
+   if (filename == NULL)
+      return;
+
+   unlink_and_account(cache, filename);
+
+   ralloc_free(filename);
+}
+
+/* Open \filename_tmp for exclusive creation.
+ *
+ * If the file already exists it is either being written by another
+ * process right now, (in which case we let that process finish), or it was
+ * left behind by a writer that died, (in which case it is removed so that a
+ * later put may succeed).
+ */
+static int
+open_tmp_file(const char *filename_tmp)
+{
+   struct stat sb;
+   int fd;
+
+   fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT | O_EXCL, 0644);
+   if (fd != -1 || errno != EEXIST)
+      return fd;
+
+   if (stat(filename_tmp, &sb) == 0 &&
+       time(NULL) - sb.st_mtime > CACHE_STALE_TMP_FILE_AGE)
+      unlink(filename_tmp);
+
+   return -1;
+}
+
+void
+disk_cache_put(struct disk_cache *cache,
+               const cache_key key,
+               const void *data,
+               size_t size)
+{
+   int fd = -1, fd_final, err, ret;
+   size_t len;
+   char *filename = NULL, *filename_tmp = NULL;
+   const char *p = data;
+   struct stat sb;
+
+   filename = get_cache_file(cache, key);
+   if (filename == NULL)
+      goto done;
+
+   /* Write to a temporary file to allow for an atomic rename to the
+    * final destination filename, (to prevent any readers from seeing
+    * a partially written file).
+    */
+   filename_tmp = ralloc_asprintf(cache, "%s.tmp", filename);
+   if (filename_tmp == NULL)
+      goto done;
+
+   fd = open_tmp_file(filename_tmp);
+
+   /* Make the two-character subdirectory within the cache as needed. */
+   if (fd == -1) {
+      if (errno != ENOENT)
+         goto done;
+
+      make_cache_file_directory(cache, key);
+
+      fd = open_tmp_file(filename_tmp);
+      if (fd == -1)
+         goto done;
+   }
+
+   /* With the temporary file open, we take an exclusive flock on
+    * it. If the flock fails, then another process still has the file
+    * open with the flock held. So just let that file be responsible
+    * for writing the file.
+    */
+   err = flock(fd, LOCK_EX | LOCK_NB);
+   if (err == -1)
+      goto done;
+
+   /* Now that we have the lock on the open temporary file, we can
+    * check to see if the destination file already exists. If so,
+    * another process won the race between when we saw that the file
+    * didn't exist and now. In this case, we don't do anything more,
+    * (to ensure the size accounting of the cache doesn't get off).
+    */
+   fd_final = open(filename, O_RDONLY | O_CLOEXEC);
+   if (fd_final != -1) {
+      close(fd_final);
+      unlink(filename_tmp);
+      goto done;
+   }
+
+   /* OK, we're now on the hook to write out a file that we know is
+    * not in the cache, and is also not being written out to the cache
+    * by some other process.
+    *
+    * Before we do that, if the cache is too large, evict something
+    * else first.
+    */
+   if (*cache->size + size > cache->max_size)
+      evict_random_lru_file(cache);
+
+   /* Now, finally, write out the contents to the temporary file, then
+    * rename them atomically to the destination filename, and also
+    * perform an atomic increment of the total cache size.
+    */
+   for (len = 0; len < size; len += ret) {
+      ret = write(fd, p + len, size - len);
+      if (ret == -1) {
+         if (errno == EINTR) {
+            ret = 0;
+            continue;
+         }
+         unlink(filename_tmp);
+         goto done;
+      }
+   }
+
+   if (rename(filename_tmp, filename) == -1) {
+      unlink(filename_tmp);
+      goto done;
+   }
+
+   if (fstat(fd, &sb) == 0)
+      p_atomic_add(cache->size, (uint64_t) sb.st_blocks * 512);
+
+ done:
+   /* This close finally releases the flock, (now that the final file
+    * has been renamed into place and the size has been added).
+    */
+   if (fd != -1)
+      close(fd);
+   if (filename_tmp)
+      ralloc_free(filename_tmp);
+   if (filename)
+      ralloc_free(filename);
+}
+
+void *
+disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
+{
+   int fd = -1, ret, len;
+   struct stat sb;
+   char *filename = NULL;
+   uint8_t *data = NULL;
+
+   if (size)
+      *size = 0;
+
+   filename = get_cache_file(cache, key);
+   if (filename == NULL)
+      goto fail;
+
+   fd = open(filename, O_RDONLY | O_CLOEXEC);
+   if (fd == -1)
+      goto fail;
+
+   if (fstat(fd, &sb) == -1)
+      goto fail;
+
+   data = malloc(sb.st_size);
+   if (data == NULL)
+      goto fail;
+
+   for (len = 0; len < sb.st_size; len += ret) {
+      ret = read(fd, data + len, sb.st_size - len);
+      if (ret == -1) {
+         if (errno == EINTR) {
+            ret = 0;
+            continue;
+         }
+         goto fail;
+      }
+      /* The file shrank underneath us; treat it as a miss. */
+      if (ret == 0)
+         goto fail;
+   }
+
+   ralloc_free(filename);
+   close(fd);
+
+   if (size)
+      *size = sb.st_size;
+
+   return data;
+
+ fail:
+   if (data)
+      free(data);
+   if (filename)
+      ralloc_free(filename);
+   if (fd != -1)
+      close(fd);
+
+   return NULL;
+}
+
+void
+disk_cache_put_key(struct disk_cache *cache, const cache_key key)
+{
+   uint32_t i = (key[0] | (key[1] << 8)) & CACHE_INDEX_KEY_MASK;
+   unsigned char *entry;
+
+   entry = &cache->stored_keys[i * CACHE_KEY_SIZE];
+
+   memcpy(entry, key, CACHE_KEY_SIZE);
+}
+
+/* This function lets us test whether a given key was previously
+ * stored in the cache with disk_cache_put_key(). The implementation is
+ * efficient by not using syscalls or hitting the disk. It's not
+ * race-free, but the races are benign. If we race with someone else
+ * calling disk_cache_put_key, then that's just an extra cache miss and an
+ * extra recompile.
+ */
+bool
+disk_cache_has_key(struct disk_cache *cache, const cache_key key)
+{
+   uint32_t i = (key[0] | (key[1] << 8)) & CACHE_INDEX_KEY_MASK;
+   unsigned char *entry;
+
+   entry = &cache->stored_keys[i * CACHE_KEY_SIZE];
+
+   return memcmp(entry, key, CACHE_KEY_SIZE) == 0;
+}
+
+#endif /* ENABLE_SHADER_CACHE */
@@ -109,6 +109,26 @@ entry_is_present(const struct hash_table *ht, struct hash_entry *entry)
    return entry->key != NULL && entry->key != ht->deleted_key;
 }
 
+static inline bool
+key_equals(const struct hash_table *ht, const void *a, const void *b)
+{
+   /* Avoid the indirect call for the common pointer-keyed tables */
+   if (ht->key_equals_function == _mesa_key_pointer_equal)
+      return a == b;
+
+   return ht->key_equals_function(a, b);
+}
+
+/**
+ * Step to the next probe address.  Same as (address + step) % size without
+ * a division, since both address and step are smaller than size.
+ */
+static inline uint32_t
+probe_next(uint32_t address, uint32_t step, uint32_t size)
+{
+   return address >= size - step ? address - (size - step) : address + step;
+}
+
 struct hash_table *
 _mesa_hash_table_create(void *mem_ctx,
                         uint32_t (*key_hash_function)(const void *key),
@@ -210,23 +230,20 @@ hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
 {
    uint32_t start_hash_address = hash % ht->size;
    uint32_t hash_address = start_hash_address;
+   uint32_t double_hash = 1 + hash % ht->rehash;
 
    do {
-      uint32_t double_hash;
-
       struct hash_entry *entry = ht->table + hash_address;
 
       if (entry_is_free(entry)) {
          return NULL;
       } else if (entry_is_present(ht, entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+         if (key_equals(ht, key, entry->key)) {
             return entry;
          }
       }
 
-      double_hash = 1 + hash % ht->rehash;
-
-      hash_address = (hash_address + double_hash) % ht->size;
+      hash_address = probe_next(hash_address, double_hash, ht->size);
    } while (hash_address != start_hash_address);
 
    return NULL;
@@ -292,7 +309,7 @@ static struct hash_entry *
 hash_table_insert(struct hash_table *ht, uint32_t hash,
                   const void *key, void *data)
 {
-   uint32_t start_hash_address, hash_address;
+   uint32_t start_hash_address, hash_address, double_hash;
    struct hash_entry *available_entry = NULL;
 
    if (ht->entries >= ht->max_entries) {
@@ -303,9 +320,9 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
 
    start_hash_address = hash % ht->size;
    hash_address = start_hash_address;
+   double_hash = 1 + hash % ht->rehash;
    do {
       struct hash_entry *entry = ht->table + hash_address;
-      uint32_t double_hash;
 
       if (!entry_is_present(ht, entry)) {
          /* Stash the first available entry we find */
@@ -328,16 +345,13 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
        */
       if (!entry_is_deleted(ht, entry) &&
           entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
+          key_equals(ht, key, entry->key)) {
          entry->key = key;
          entry->data = data;
          return entry;
       }
 
-
-      double_hash = 1 + hash % ht->rehash;
-
-      hash_address = (hash_address + double_hash) % ht->size;
+      hash_address = probe_next(hash_address, double_hash, ht->size);
    } while (hash_address != start_hash_address);
 
    if (available_entry) {
@@ -515,3 +515,80 @@ ralloc_vasprintf_rewrite_tail(char **str, size_t *start, const char *fmt,
    *start += new_length;
    return true;
 }
+
+#define LINEAR_BLOCK_SIZE (32 * 1024)
+/* Allocations bigger than this get a block of their own. */
+#define LINEAR_MAX_SHARED_SIZE (LINEAR_BLOCK_SIZE / 4)
+#define LINEAR_ALIGNMENT 8
+
+struct linear_ctx
+{
+   /* The free space of the current block.  The blocks are ralloc children
+    * of the linear context.
+    */
+   char *cur;
+   char *end;
+};
+
+void *
+linear_context(const void *ralloc_ctx)
+{
+   struct linear_ctx *lin = ralloc(ralloc_ctx, struct linear_ctx);
+
+   if (unlikely(lin == NULL))
+      return NULL;
+
+   lin->cur = NULL;
+   lin->end = NULL;
+   return lin;
+}
+
+void *
+linear_alloc_size(void *lin_ctx, size_t size)
+{
+   struct linear_ctx *lin = lin_ctx;
+   char *ptr;
+
+   size = (size + LINEAR_ALIGNMENT - 1) & ~(size_t) (LINEAR_ALIGNMENT - 1);
+
+   if (unlikely(size > (size_t) (lin->end - lin->cur))) {
+      if (size > LINEAR_MAX_SHARED_SIZE)
+         return ralloc_size(lin, size);
+
+      ptr = ralloc_size(lin, LINEAR_BLOCK_SIZE);
+      if (unlikely(ptr == NULL))
+         return NULL;
+
+      lin->cur = ptr;
+      lin->end = ptr + LINEAR_BLOCK_SIZE;
+   }
+
+   ptr = lin->cur;
+   lin->cur += size;
+   return ptr;
+}
+
+void *
+linear_zalloc_size(void *lin_ctx, size_t size)
+{
+   void *ptr = linear_alloc_size(lin_ctx, size);
+   if (likely(ptr != NULL))
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+char *
+linear_strdup(void *lin_ctx, const char *str)
+{
+   size_t n;
+   char *ptr;
+
+   if (unlikely(str == NULL))
+      return NULL;
+
+   n = strlen(str);
+   ptr = linear_alloc_size(lin_ctx, n + 1);
+   if (likely(ptr != NULL))
+      memcpy(ptr, str, n + 1);
+   return ptr;
+}
@@ -407,6 +407,51 @@ bool ralloc_asprintf_append (char **str, const char *fmt, ...)
 bool ralloc_vasprintf_append(char **str, const char *fmt, va_list args);
 /// @}
 
+/// \defgroup linear Linear Allocators @{
+
+/**
+ * Allocate a new linear context chained off of the given ralloc context.
+ *
+ * A linear context hands out memory from large blocks by bumping a pointer,
+ * which is a lot cheaper than ralloc for many small allocations and keeps
+ * them close to each other.  The allocations can't be freed, resized,
+ * stolen or used as ralloc contexts: they all go away at once when the
+ * linear context, or its ralloc parent, is freed with \c ralloc_free.
+ */
+void *linear_context(const void *ralloc_ctx);
+
+/**
+ * Allocate memory out of the given linear context.
+ *
+ * The memory is aligned like the memory returned by \c ralloc_size.
+ */
+void *linear_alloc_size(void *lin_ctx, size_t size) MALLOCLIKE;
+
+/**
+ * Allocate zero-initialized memory out of the given linear context.
+ */
+void *linear_zalloc_size(void *lin_ctx, size_t size) MALLOCLIKE;
+
+/**
+ * \def linear_alloc(lin_ctx, type)
+ * Allocate a new object out of the given linear context.
+ */
+#define linear_alloc(lin_ctx, type) \
+   ((type *) linear_alloc_size(lin_ctx, sizeof(type)))
+
+/**
+ * \def linear_zalloc(lin_ctx, type)
+ * Allocate a new zero-initialized object out of the given linear context.
+ */
+#define linear_zalloc(lin_ctx, type) \
+   ((type *) linear_zalloc_size(lin_ctx, sizeof(type)))
+
+/**
+ * Duplicate a string, allocating the memory out of the given linear context.
+ */
+char *linear_strdup(void *lin_ctx, const char *str) MALLOCLIKE;
+/// @}
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -448,5 +493,30 @@ public:                                                                  \
       ralloc_free(p);                                                    \
    }
 
+/**
+ * Declare C++ new and delete operators which use a linear context.
+ *
+ * Placing this macro in the body of a class makes it possible to do:
+ *
+ * TYPE *var = new(lin_ctx) TYPE(...);
+ *
+ * The memory is zeroed like ralloc's, to keep the classes moved over from
+ * DECLARE_RALLOC_CXX_OPERATORS working unchanged.  Objects are never freed
+ * or destroyed individually, so TYPE should have a trivial destructor.
+ */
+#define DECLARE_LINEAR_ALLOC_CXX_OPERATORS(TYPE)                         \
+public:                                                                  \
+   static void* operator new(size_t size, void *lin_ctx)                 \
+   {                                                                     \
+      void *p = linear_zalloc_size(lin_ctx, size);                       \
+      assert(p != NULL);                                                 \
+      return p;                                                          \
+   }                                                                     \
+                                                                         \
+   static void operator delete(void *p)                                  \
+   {                                                                     \
+      /* The memory is released along with the linear context. */        \
+   }
+
 
 #endif
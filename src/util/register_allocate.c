@@ -68,6 +68,13 @@
  * up front and stored in a 2-dimensional array, so that the cost of
  * coloring a node is constant with the number of registers.  We do
  * this during ra_set_finalize().
+ *
+ * Simplification keeps a worklist of the nodes passing the pq test, so
+ * each node is visited once instead of rescanning the whole graph until
+ * nothing changes.  Nodes related by a copy (see ra_add_node_move()) are
+ * coalesced at select time: a node picks the register of an already
+ * colored copy partner if that is legal, which lets the caller drop the
+ * copy.
  */
 
 #include <stdbool.h>
@@ -81,6 +88,13 @@
 
 #define NO_REG ~0U
 
+/**
+ * Largest graph which keeps an adjacency bitset per node.  Those take
+ * count^2 bits, so bigger graphs keep a hash set of the interfering node
+ * pairs instead.
+ */
+#define RA_DENSE_ADJACENCY_MAX_NODES 4096
+
 struct ra_reg {
    BITSET_WORD *conflicts;
    unsigned int *conflict_list;
@@ -125,7 +139,8 @@ struct ra_node {
    /** @{
     *
     * List of which nodes this node interferes with.  This should be
-    * symmetric with the other node.
+    * symmetric with the other node.  The bitset is NULL for graphs using
+    * ra_graph::edge_set.
     */
    BITSET_WORD *adjacency;
    unsigned int *adjacency_list;
@@ -156,6 +171,16 @@ struct ra_node {
     * approximate cost of spilling this node.
     */
    float spill_cost;
+
+   /** @{
+    *
+    * List of the nodes this node is copied from or to, which would
+    * preferably get the same register.
+    */
+   unsigned int *move_list;
+   unsigned int move_list_size;
+   unsigned int move_count;
+   /** @} */
 };
 
 struct ra_graph {
@@ -169,6 +194,20 @@ struct ra_graph {
    unsigned int *stack;
    unsigned int stack_count;
 
+   /** Nodes passing the pq test which haven't been pushed on the stack. */
+   unsigned int *worklist;
+   unsigned int worklist_count;
+
+   /**
+    * Open-addressed hash set of the interfering node pairs, used instead of
+    * the per-node adjacency bitsets for graphs with more than
+    * RA_DENSE_ADJACENCY_MAX_NODES nodes.  Each pair is stored once, with
+    * the lower node number in the upper 32 bits.  0 marks an empty slot.
+    */
+   uint64_t *edge_set;
+   unsigned int edge_set_size;
+   unsigned int edge_set_count;
+
    /**
     * Tracks the start of the set of optimistically-colored registers in the
     * stack.
@@ -387,10 +426,85 @@ ra_set_finalize(struct ra_regs *regs, unsigned int **q_values)
    }
 }
 
+static uint64_t
+ra_edge_key(unsigned int n1, unsigned int n2)
+{
+   if (n1 > n2)
+      return ((uint64_t)n2 << 32) | n1;
+   else
+      return ((uint64_t)n1 << 32) | n2;
+}
+
+static unsigned int
+ra_edge_slot(const struct ra_graph *g, uint64_t key)
+{
+   return (unsigned int)((key * 0x9e3779b97f4a7c15ull) >> 32) &
+          (g->edge_set_size - 1);
+}
+
+static bool
+ra_edge_set_contains(const struct ra_graph *g, uint64_t key)
+{
+   unsigned int i;
+
+   for (i = ra_edge_slot(g, key); g->edge_set[i] != 0;
+        i = (i + 1) & (g->edge_set_size - 1)) {
+      if (g->edge_set[i] == key)
+         return true;
+   }
+
+   return false;
+}
+
+static void
+ra_edge_set_insert(struct ra_graph *g, uint64_t key)
+{
+   unsigned int i;
+
+   /* Keep the set at most half full. */
+   if (2 * (g->edge_set_count + 1) > g->edge_set_size) {
+      uint64_t *old_set = g->edge_set;
+      unsigned int old_size = g->edge_set_size;
+
+      g->edge_set_size *= 2;
+      g->edge_set = rzalloc_array(g, uint64_t, g->edge_set_size);
+
+      for (i = 0; i < old_size; i++) {
+         if (old_set[i] != 0) {
+            unsigned int j = ra_edge_slot(g, old_set[i]);
+
+            while (g->edge_set[j] != 0)
+               j = (j + 1) & (g->edge_set_size - 1);
+            g->edge_set[j] = old_set[i];
+         }
+      }
+
+      ralloc_free(old_set);
+   }
+
+   i = ra_edge_slot(g, key);
+   while (g->edge_set[i] != 0)
+      i = (i + 1) & (g->edge_set_size - 1);
+
+   g->edge_set[i] = key;
+   g->edge_set_count++;
+}
+
+static bool
+ra_nodes_interfere(const struct ra_graph *g, unsigned int n1, unsigned int n2)
+{
+   if (g->edge_set == NULL)
+      return BITSET_TEST(g->nodes[n1].adjacency, n2);
+
+   /* Nodes always interfere with themselves, as in the bitsets. */
+   return n1 == n2 || ra_edge_set_contains(g, ra_edge_key(n1, n2));
+}
+
 static void
 ra_add_node_adjacency(struct ra_graph *g, unsigned int n1, unsigned int n2)
 {
-   BITSET_SET(g->nodes[n1].adjacency, n2);
+   if (g->edge_set == NULL)
+      BITSET_SET(g->nodes[n1].adjacency, n2);
 
    if (n1 != n2) {
       int n1_class = g->nodes[n1].class;
@@ -422,10 +536,20 @@ ra_alloc_interference_graph(struct ra_regs *regs, unsigned int count)
    g->count = count;
 
    g->stack = rzalloc_array(g, unsigned int, count);
+   g->worklist = ralloc_array(g, unsigned int, count);
+
+   if (count > RA_DENSE_ADJACENCY_MAX_NODES) {
+      g->edge_set_size = 1;
+      while (g->edge_set_size < 8 * count)
+         g->edge_set_size *= 2;
+      g->edge_set = rzalloc_array(g, uint64_t, g->edge_set_size);
+   }
 
    for (i = 0; i < count; i++) {
-      int bitset_count = BITSET_WORDS(count);
-      g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
+      if (g->edge_set == NULL) {
+         int bitset_count = BITSET_WORDS(count);
+         g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
+      }
 
       g->nodes[i].adjacency_list_size = 4;
       g->nodes[i].adjacency_list =
@@ -451,12 +575,45 @@ void
 ra_add_node_interference(struct ra_graph *g,
                          unsigned int n1, unsigned int n2)
 {
-   if (!BITSET_TEST(g->nodes[n1].adjacency, n2)) {
+   if (!ra_nodes_interfere(g, n1, n2)) {
+      if (g->edge_set != NULL)
+         ra_edge_set_insert(g, ra_edge_key(n1, n2));
+
       ra_add_node_adjacency(g, n1, n2);
       ra_add_node_adjacency(g, n2, n1);
    }
 }
 
+static void
+ra_add_node_move_to_list(struct ra_graph *g, unsigned int n1, unsigned int n2)
+{
+   struct ra_node *node = &g->nodes[n1];
+
+   if (node->move_count >= node->move_list_size) {
+      node->move_list_size = MAX2(node->move_list_size * 2, 2);
+      node->move_list = reralloc(g, node->move_list, unsigned int,
+                                 node->move_list_size);
+   }
+
+   node->move_list[node->move_count++] = n2;
+}
+
+/**
+ * Records that n1 and n2 are copies of each other, so the copy between
+ * them can be removed if they're allocated the same register.  Nodes
+ * which interfere with each other are ignored, so this is best called
+ * once the interference has been added.
+ */
+void
+ra_add_node_move(struct ra_graph *g, unsigned int n1, unsigned int n2)
+{
+   if (ra_nodes_interfere(g, n1, n2))
+      return;
+
+   ra_add_node_move_to_list(g, n1, n2);
+   ra_add_node_move_to_list(g, n2, n1);
+}
+
 static bool
 pq_test(struct ra_graph *g, unsigned int n)
 {
@@ -465,6 +622,10 @@ pq_test(struct ra_graph *g, unsigned int n)
    return g->nodes[n].q_total < g->regs->classes[n_class]->p;
 }
 
+/**
+ * Removes the edges of n from the q totals of its neighbors, adding the
+ * neighbors which become trivially colorable to the worklist.
+ */
 static void
 decrement_q(struct ra_graph *g, unsigned int n)
 {
@@ -476,17 +637,36 @@ decrement_q(struct ra_graph *g, unsigned int n)
       unsigned int n2_class = g->nodes[n2].class;
 
       if (n != n2 && !g->nodes[n2].in_stack) {
+         bool was_colorable = pq_test(g, n2);
+
          assert(g->nodes[n2].q_total >= g->regs->classes[n2_class]->q[n_class]);
          g->nodes[n2].q_total -= g->regs->classes[n2_class]->q[n_class];
+
+         if (!was_colorable && pq_test(g, n2) &&
+             g->nodes[n2].reg == NO_REG)
+            g->worklist[g->worklist_count++] = n2;
       }
    }
 }
 
+static void
+ra_push_node(struct ra_graph *g, unsigned int n)
+{
+   decrement_q(g, n);
+   g->stack[g->stack_count] = n;
+   g->stack_count++;
+   g->nodes[n].in_stack = true;
+}
+
 /**
  * Simplifies the interference graph by pushing all
  * trivially-colorable nodes into a stack of nodes to be colored,
  * removing them from the graph, and rinsing and repeating.
  *
+ * The q totals only go down during simplification, so a node becomes
+ * trivially colorable at most once.  It is put on the worklist at that
+ * point, which avoids rescanning the graph for new candidates.
+ *
  * If we encounter a case where we can't push any nodes on the stack, then
  * we optimistically choose a node and push it on the stack. We heuristically
  * push the node with the lowest total q value, since it has the fewest
@@ -495,50 +675,101 @@ decrement_q(struct ra_graph *g, unsigned int n)
 static void
 ra_simplify(struct ra_graph *g)
 {
-   bool progress = true;
    unsigned int stack_optimistic_start = UINT_MAX;
-   int i;
+   unsigned int remaining = 0;
+   unsigned int i;
+
+   /* Fill the worklist in ascending order, so the nodes are popped from the
+    * highest numbered one down.
+    */
+   g->worklist_count = 0;
+   for (i = 0; i < g->count; i++) {
+      if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
+         continue;
 
-   while (progress) {
+      remaining++;
+      if (pq_test(g, i))
+         g->worklist[g->worklist_count++] = i;
+   }
+
+   while (remaining > 0) {
       unsigned int best_optimistic_node = ~0;
       unsigned int lowest_q_total = ~0;
 
-      progress = false;
-
-      for (i = g->count - 1; i >= 0; i--) {
-	 if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
-	    continue;
-
-	 if (pq_test(g, i)) {
-	    decrement_q(g, i);
-	    g->stack[g->stack_count] = i;
-	    g->stack_count++;
-	    g->nodes[i].in_stack = true;
-	    progress = true;
-	 } else {
-	    unsigned int new_q_total = g->nodes[i].q_total;
-	    if (new_q_total < lowest_q_total) {
-	       best_optimistic_node = i;
-	       lowest_q_total = new_q_total;
-	    }
-	 }
+      while (g->worklist_count > 0) {
+         ra_push_node(g, g->worklist[--g->worklist_count]);
+         remaining--;
       }
 
-      if (!progress && best_optimistic_node != ~0U) {
-         if (stack_optimistic_start == UINT_MAX)
-            stack_optimistic_start = g->stack_count;
+      if (remaining == 0)
+         break;
 
-	 decrement_q(g, best_optimistic_node);
-	 g->stack[g->stack_count] = best_optimistic_node;
-	 g->stack_count++;
-	 g->nodes[best_optimistic_node].in_stack = true;
-	 progress = true;
+      for (i = g->count; i-- > 0;) {
+         if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
+            continue;
+
+         if (g->nodes[i].q_total < lowest_q_total) {
+            best_optimistic_node = i;
+            lowest_q_total = g->nodes[i].q_total;
+         }
       }
+
+      assert(best_optimistic_node != ~0U);
+
+      if (stack_optimistic_start == UINT_MAX)
+         stack_optimistic_start = g->stack_count;
+
+      ra_push_node(g, best_optimistic_node);
+      remaining--;
    }
 
    g->stack_optimistic_start = stack_optimistic_start;
 }
 
+/**
+ * Whether any neighbor of n which has a register already conflicts with
+ * register r.
+ */
+static bool
+ra_any_neighbors_conflict(struct ra_graph *g, unsigned int n, unsigned int r)
+{
+   unsigned int i;
+
+   for (i = 0; i < g->nodes[n].adjacency_count; i++) {
+      unsigned int n2 = g->nodes[n].adjacency_list[i];
+
+      if (!g->nodes[n2].in_stack &&
+          BITSET_TEST(g->regs->regs[r].conflicts, g->nodes[n2].reg)) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/**
+ * Returns the register of a copy partner of n which n can use as well, or
+ * NO_REG if there's none.
+ */
+static unsigned int
+ra_find_move_reg(struct ra_graph *g, unsigned int n, struct ra_class *c)
+{
+   unsigned int i;
+
+   for (i = 0; i < g->nodes[n].move_count; i++) {
+      unsigned int n2 = g->nodes[n].move_list[i];
+      unsigned int r = g->nodes[n2].reg;
+
+      if (g->nodes[n2].in_stack || r == NO_REG)
+         continue;
+
+      if (reg_belongs_to_class(r, c) && !ra_any_neighbors_conflict(g, n, r))
+         return r;
+   }
+
+   return NO_REG;
+}
+
 /**
  * Pops nodes from the stack back into the graph, coloring them with
  * registers as they go.
@@ -552,31 +783,26 @@ ra_select(struct ra_graph *g)
    int start_search_reg = 0;
 
    while (g->stack_count != 0) {
-      unsigned int i;
       unsigned int ri;
-      unsigned int r = -1;
+      unsigned int r;
       int n = g->stack[g->stack_count - 1];
       struct ra_class *c = g->regs->classes[g->nodes[n].class];
 
-      /* Find the lowest-numbered reg which is not used by a member
-       * of the graph adjacent to us.
+      /* Prefer the register of a copy partner, that coalesces the copy.
+       * Otherwise find the lowest-numbered reg which is not used by a
+       * member of the graph adjacent to us.
        */
-      for (ri = 0; ri < g->regs->count; ri++) {
-         r = (start_search_reg + ri) % g->regs->count;
-         if (!reg_belongs_to_class(r, c))
-	    continue;
-
-	 /* Check if any of our neighbors conflict with this register choice. */
-	 for (i = 0; i < g->nodes[n].adjacency_count; i++) {
-	    unsigned int n2 = g->nodes[n].adjacency_list[i];
-
-	    if (!g->nodes[n2].in_stack &&
-		BITSET_TEST(g->regs->regs[r].conflicts, g->nodes[n2].reg)) {
-	       break;
-	    }
-	 }
-	 if (i == g->nodes[n].adjacency_count)
-	    break;
+      r = ra_find_move_reg(g, n, c);
+      if (r == NO_REG) {
+         for (ri = 0; ri < g->regs->count; ri++) {
+            unsigned int reg = (start_search_reg + ri) % g->regs->count;
+
+            if (reg_belongs_to_class(reg, c) &&
+                !ra_any_neighbors_conflict(g, n, reg)) {
+               r = reg;
+               break;
+            }
+         }
       }
 
       /* set this to false even if we return here so that
@@ -584,7 +810,7 @@ ra_select(struct ra_graph *g)
        */
       g->nodes[n].in_stack = false;
 
-      if (ri == g->regs->count)
+      if (r == NO_REG)
 	 return false;
 
       g->nodes[n].reg = r;
@@ -74,6 +74,7 @@ struct ra_graph *ra_alloc_interference_graph(struct ra_regs *regs,
 void ra_set_node_class(struct ra_graph *g, unsigned int n, unsigned int c);
 void ra_add_node_interference(struct ra_graph *g,
 			      unsigned int n1, unsigned int n2);
+void ra_add_node_move(struct ra_graph *g, unsigned int n1, unsigned int n2);
 /** @} */
 
 /** @{ Graph-coloring register allocation */
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#include "hash_table.h"
 #include "macros.h"
 #include "ralloc.h"
 #include "set.h"
@@ -102,6 +103,26 @@ entry_is_present(struct set_entry *entry)
    return entry->key != NULL && entry->key != deleted_key;
 }
 
+static inline bool
+key_equals(const struct set *ht, const void *a, const void *b)
+{
+   /* Avoid the indirect call for the common pointer-keyed sets */
+   if (ht->key_equals_function == _mesa_key_pointer_equal)
+      return a == b;
+
+   return ht->key_equals_function(a, b);
+}
+
+/**
+ * Step to the next probe address.  Same as (address + step) % size without
+ * a division, since both address and step are smaller than size.
+ */
+static inline uint32_t
+probe_next(uint32_t address, uint32_t step, uint32_t size)
+{
+   return address >= size - step ? address - (size - step) : address + step;
+}
+
 struct set *
 _mesa_set_create(void *mem_ctx,
                  uint32_t (*key_hash_function)(const void *key),
@@ -163,26 +184,23 @@ _mesa_set_destroy(struct set *ht, void (*delete_function)(struct set_entry *entr
 static struct set_entry *
 set_search(const struct set *ht, uint32_t hash, const void *key)
 {
-   uint32_t hash_address;
+   uint32_t start_hash_address = hash % ht->size;
+   uint32_t hash_address = start_hash_address;
+   uint32_t double_hash = 1 + hash % ht->rehash;
 
-   hash_address = hash % ht->size;
    do {
-      uint32_t double_hash;
-
       struct set_entry *entry = ht->table + hash_address;
 
       if (entry_is_free(entry)) {
          return NULL;
       } else if (entry_is_present(entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+         if (key_equals(ht, key, entry->key)) {
             return entry;
          }
       }
 
-      double_hash = 1 + hash % ht->rehash;
-
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != hash % ht->size);
+      hash_address = probe_next(hash_address, double_hash, ht->size);
+   } while (hash_address != start_hash_address);
 
    return NULL;
 }
@@ -250,7 +268,7 @@ set_rehash(struct set *ht, unsigned new_size_index)
 static struct set_entry *
 set_add(struct set *ht, uint32_t hash, const void *key)
 {
-   uint32_t hash_address;
+   uint32_t start_hash_address, hash_address, double_hash;
    struct set_entry *available_entry = NULL;
 
    if (ht->entries >= ht->max_entries) {
@@ -259,10 +277,11 @@ set_add(struct set *ht, uint32_t hash, const void *key)
       set_rehash(ht, ht->size_index);
    }
 
-   hash_address = hash % ht->size;
+   start_hash_address = hash % ht->size;
+   hash_address = start_hash_address;
+   double_hash = 1 + hash % ht->rehash;
    do {
       struct set_entry *entry = ht->table + hash_address;
-      uint32_t double_hash;
 
       if (!entry_is_present(entry)) {
          /* Stash the first available entry we find */
@@ -284,15 +303,13 @@ set_add(struct set *ht, uint32_t hash, const void *key)
        */
       if (!entry_is_deleted(entry) &&
           entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
+          key_equals(ht, key, entry->key)) {
          entry->key = key;
          return entry;
       }
 
-      double_hash = 1 + hash % ht->rehash;
-
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != hash % ht->size);
+      hash_address = probe_next(hash_address, double_hash, ht->size);
+   } while (hash_address != start_hash_address);
 
    if (available_entry) {
       if (entry_is_deleted(available_entry))
@@ -0,0 +1,259 @@
+/*
+ * Copyright © 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NON-INFRINGEMENT. IN NO EVENT SHALL THE COPYRIGHT HOLDERS, AUTHORS
+ * AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ */
+
+#include "u_queue.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+static void
+util_queue_set_thread_name(const char *name)
+{
+#if defined(HAVE_PTHREAD)
+#  if defined(__GNU_LIBRARY__) && defined(__GLIBC__) && defined(__GLIBC_MINOR__) && \
+      (__GLIBC__ >= 3 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 12))
+   pthread_setname_np(pthread_self(), name);
+#  endif
+#endif
+   (void)name;
+}
+
+static void
+util_queue_fence_signal(struct util_queue_fence *fence)
+{
+   mtx_lock(&fence->mutex);
+   fence->signalled = true;
+   cnd_broadcast(&fence->cond);
+   mtx_unlock(&fence->mutex);
+}
+
+void
+util_queue_job_wait(struct util_queue_fence *fence)
+{
+   mtx_lock(&fence->mutex);
+   while (!fence->signalled)
+      cnd_wait(&fence->cond, &fence->mutex);
+   mtx_unlock(&fence->mutex);
+}
+
+struct thread_input {
+   struct util_queue *queue;
+   int thread_index;
+};
+
+static int
+util_queue_thread_func(void *input)
+{
+   struct util_queue *queue = ((struct thread_input*)input)->queue;
+   int thread_index = ((struct thread_input*)input)->thread_index;
+
+   free(input);
+
+   if (queue->name) {
+      char name[16];
+      snprintf(name, sizeof(name), "%s:%i", queue->name, thread_index);
+      util_queue_set_thread_name(name);
+   }
+
+   while (1) {
+      struct util_queue_job job;
+
+      mtx_lock(&queue->lock);
+      assert(queue->num_queued >= 0 && queue->num_queued <= queue->max_jobs);
+
+      /* wait if the queue is empty */
+      while (!queue->kill_threads && queue->num_queued == 0)
+         cnd_wait(&queue->has_queued_cond, &queue->lock);
+
+      if (queue->kill_threads) {
+         mtx_unlock(&queue->lock);
+         break;
+      }
+
+      job = queue->jobs[queue->read_idx];
+      memset(&queue->jobs[queue->read_idx], 0, sizeof(struct util_queue_job));
+      queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
+
+      queue->num_queued--;
+      cnd_signal(&queue->has_space_cond);
+      mtx_unlock(&queue->lock);
+
+      if (job.job) {
+         job.execute(job.job, thread_index);
+         util_queue_fence_signal(job.fence);
+      }
+   }
+
+   /* signal remaining jobs before terminating */
+   mtx_lock(&queue->lock);
+   while (queue->jobs[queue->read_idx].job) {
+      util_queue_fence_signal(queue->jobs[queue->read_idx].fence);
+
+      queue->jobs[queue->read_idx].job = NULL;
+      queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
+   }
+   mtx_unlock(&queue->lock);
+   return 0;
+}
+
+bool
+util_queue_init(struct util_queue *queue,
+                const char *name,
+                unsigned max_jobs,
+                unsigned num_threads)
+{
+   unsigned i;
+
+   memset(queue, 0, sizeof(*queue));
+   queue->name = name;
+   queue->num_threads = num_threads;
+   queue->max_jobs = max_jobs;
+
+   queue->jobs = (struct util_queue_job*)
+                 calloc(max_jobs, sizeof(struct util_queue_job));
+   if (!queue->jobs)
+      goto fail;
+
+   mtx_init(&queue->lock, mtx_plain);
+
+   queue->num_queued = 0;
+   cnd_init(&queue->has_queued_cond);
+   cnd_init(&queue->has_space_cond);
+
+   queue->threads = (thrd_t*)calloc(num_threads, sizeof(thrd_t));
+   if (!queue->threads)
+      goto fail;
+
+   /* start threads */
+   for (i = 0; i < num_threads; i++) {
+      struct thread_input *input =
+         (struct thread_input *)malloc(sizeof(struct thread_input));
+      input->queue = queue;
+      input->thread_index = i;
+
+      if (thrd_create(&queue->threads[i], util_queue_thread_func,
+                      input) != thrd_success) {
+         free(input);
+
+         if (i == 0) {
+            /* no threads created, fail */
+            goto fail;
+         } else {
+            /* at least one thread created, so use it */
+            queue->num_threads = i;
+            break;
+         }
+      }
+   }
+   return true;
+
+fail:
+   free(queue->threads);
+
+   if (queue->jobs) {
+      cnd_destroy(&queue->has_space_cond);
+      cnd_destroy(&queue->has_queued_cond);
+      mtx_destroy(&queue->lock);
+      free(queue->jobs);
+   }
+   /* also util_queue_is_initialized can be used to check for success */
+   memset(queue, 0, sizeof(*queue));
+   return false;
+}
+
+void
+util_queue_destroy(struct util_queue *queue)
+{
+   unsigned i;
+
+   /* Signal all threads to terminate. */
+   mtx_lock(&queue->lock);
+   queue->kill_threads = 1;
+   cnd_broadcast(&queue->has_queued_cond);
+   mtx_unlock(&queue->lock);
+
+   for (i = 0; i < queue->num_threads; i++)
+      thrd_join(queue->threads[i], NULL);
+
+   cnd_destroy(&queue->has_space_cond);
+   cnd_destroy(&queue->has_queued_cond);
+   mtx_destroy(&queue->lock);
+   free(queue->jobs);
+   free(queue->threads);
+}
+
+void
+util_queue_fence_init(struct util_queue_fence *fence)
+{
+   memset(fence, 0, sizeof(*fence));
+   mtx_init(&fence->mutex, mtx_plain);
+   cnd_init(&fence->cond);
+   fence->signalled = true;
+}
+
+void
+util_queue_fence_destroy(struct util_queue_fence *fence)
+{
+   assert(fence->signalled);
+   cnd_destroy(&fence->cond);
+   mtx_destroy(&fence->mutex);
+}
+
+void
+util_queue_add_job(struct util_queue *queue,
+                   void *job,
+                   struct util_queue_fence *fence,
+                   util_queue_execute_func execute)
+{
+   struct util_queue_job *ptr;
+
+   assert(fence->signalled);
+   fence->signalled = false;
+
+   mtx_lock(&queue->lock);
+   assert(queue->num_queued >= 0 && queue->num_queued <= queue->max_jobs);
+
+   /* if the queue is full, wait until there is space */
+   while (queue->num_queued == queue->max_jobs)
+      cnd_wait(&queue->has_space_cond, &queue->lock);
+
+   ptr = &queue->jobs[queue->write_idx];
+   assert(ptr->job == NULL);
+   ptr->job = job;
+   ptr->fence = fence;
+   ptr->execute = execute;
+   queue->write_idx = (queue->write_idx + 1) % queue->max_jobs;
+
+   queue->num_queued++;
+   cnd_signal(&queue->has_queued_cond);
+   mtx_unlock(&queue->lock);
+}
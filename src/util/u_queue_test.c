@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2016 Advanced Micro Devices, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NON-INFRINGEMENT. IN NO EVENT SHALL THE COPYRIGHT HOLDERS, AUTHORS
+ * AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "u_queue.h"
+
+#define NUM_THREADS 4
+#define NUM_JOBS 256
+
+struct test_job {
+   struct util_queue_fence fence;
+   unsigned value;
+   unsigned result;
+   int thread_index;
+};
+
+static void
+execute_job(void *data, int thread_index)
+{
+   struct test_job *job = (struct test_job *)data;
+
+   job->result = job->value * 2;
+   job->thread_index = thread_index;
+}
+
+int
+main(void)
+{
+   struct util_queue queue;
+   struct test_job *jobs;
+   unsigned i;
+
+   jobs = (struct test_job *)calloc(NUM_JOBS, sizeof(*jobs));
+   assert(jobs);
+
+   /* The ring is smaller than the number of jobs, so adding them has to
+    * block until the threads free up space.
+    */
+   if (!util_queue_init(&queue, "test", 8, NUM_THREADS)) {
+      fprintf(stderr, "failed to create the queue threads\n");
+      return 1;
+   }
+   assert(util_queue_is_initialized(&queue));
+
+   for (i = 0; i < NUM_JOBS; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      assert(util_queue_fence_is_signalled(&jobs[i].fence));
+
+      jobs[i].value = i;
+      util_queue_add_job(&queue, &jobs[i], &jobs[i].fence, execute_job);
+   }
+
+   for (i = 0; i < NUM_JOBS; i++) {
+      util_queue_job_wait(&jobs[i].fence);
+      assert(util_queue_fence_is_signalled(&jobs[i].fence));
+      assert(jobs[i].result == i * 2);
+      assert(jobs[i].thread_index >= 0 &&
+             jobs[i].thread_index < (int)queue.num_threads);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+
+   util_queue_destroy(&queue);
+   free(jobs);
+   return 0;
+}